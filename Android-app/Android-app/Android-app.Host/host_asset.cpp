@@ -0,0 +1,157 @@
+/*
+ * Ressources htes : les fichiers d'un rpertoire.
+ *
+ * Comme dans un APK, une ressource est stocke sans compression si son
+ * extension est dans la liste par dfaut d'aapt (images, sons, vidos dj
+ * compresss) : AAsset_openFileDescriptor() rend alors le descripteur du
+ * fichier. Les autres sont considres comme compresses et ne se lisent que
+ * par AAsset_read() ; leur contenu n'est pas rellement dcompress.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <android/asset_manager.h>
+
+#include "host_internal.h"
+
+struct AAsset {
+    int fd;
+    off_t length;
+    off_t position;
+    int stored;
+};
+
+static pthread_mutex_t asset_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char asset_root[PATH_MAX] = ".";
+
+static const char* const asset_stored_extensions[] = {
+    ".jpg", ".jpeg", ".png", ".gif", ".wav", ".mp2", ".mp3", ".ogg", ".aac", ".mpg", ".mpeg",
+    ".mid", ".midi", ".smf", ".jet", ".rtttl", ".imy", ".xmf", ".mp4", ".m4a", ".m4v", ".3gp",
+    ".3gpp", ".3g2", ".3gpp2", ".amr", ".awb", ".wma", ".wmv", ".webm", ".mkv",
+};
+
+static int asset_is_stored(const char* filename) {
+    const char* extension = strrchr(filename, '.');
+    if (extension == NULL) {
+        return 0;
+    }
+    for (size_t i = 0; i < sizeof(asset_stored_extensions) / sizeof(asset_stored_extensions[0]); i++) {
+        if (strcasecmp(extension, asset_stored_extensions[i]) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void host_asset_set_root(const char* directory) {
+    pthread_mutex_lock(&asset_mutex);
+    snprintf(asset_root, sizeof(asset_root), "%s", directory);
+    pthread_mutex_unlock(&asset_mutex);
+}
+
+AAsset* AAssetManager_open(AAssetManager* mgr, const char* filename, int mode) {
+    char path[PATH_MAX];
+    pthread_mutex_lock(&asset_mutex);
+    int length = snprintf(path, sizeof(path), "%s/%s", asset_root, filename);
+    pthread_mutex_unlock(&asset_mutex);
+    if (length < 0 || (size_t)length >= sizeof(path)) {
+        return NULL;
+    }
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        close(fd);
+        return NULL;
+    }
+    AAsset* asset = (AAsset*)calloc(1, sizeof(AAsset));
+    if (asset == NULL) {
+        close(fd);
+        return NULL;
+    }
+    asset->fd = fd;
+    asset->length = info.st_size;
+    asset->stored = asset_is_stored(filename);
+    return asset;
+}
+
+int AAsset_read(AAsset* asset, void* buf, size_t count) {
+    if (asset->position >= asset->length) {
+        return 0;
+    }
+    if ((off_t)count > asset->length - asset->position) {
+        count = (size_t)(asset->length - asset->position);
+    }
+    if (count > INT_MAX) {
+        count = INT_MAX;
+    }
+    ssize_t done = pread(asset->fd, buf, count, asset->position);
+    if (done < 0) {
+        return -1;
+    }
+    asset->position += done;
+    return (int)done;
+}
+
+off_t AAsset_seek(AAsset* asset, off_t offset, int whence) {
+    off_t position;
+    switch (whence) {
+        case SEEK_SET:
+            position = offset;
+            break;
+        case SEEK_CUR:
+            position = asset->position + offset;
+            break;
+        case SEEK_END:
+            position = asset->length + offset;
+            break;
+        default:
+            return -1;
+    }
+    if (position < 0 || position > asset->length) {
+        return -1;
+    }
+    asset->position = position;
+    return position;
+}
+
+void AAsset_close(AAsset* asset) {
+    close(asset->fd);
+    free(asset);
+}
+
+off_t AAsset_getLength(AAsset* asset) {
+    return asset->length;
+}
+
+off_t AAsset_getRemainingLength(AAsset* asset) {
+    return asset->length - asset->position;
+}
+
+int AAsset_openFileDescriptor(AAsset* asset, off_t* outStart, off_t* outLength) {
+    if (!asset->stored) {
+        return -1;
+    }
+    int fd = fcntl(asset->fd, F_DUPFD_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    *outStart = 0;
+    *outLength = asset->length;
+    return fd;
+}
+
+int AAsset_isAllocated(AAsset* asset) {
+    return 0;
+}
@@ -0,0 +1,4170 @@
+/*
+ * Benchmarks du code de collage sur le runtime hte.
+ *
+ * Ce programme fournit son propre android_main() minimal afin de mesurer le
+ * cot du code de collage seul, sans le moteur de main.cpp. Le moteur est
+ * aussi li, son point d'entre renomm en engine_android_main() : les
+ * benchmarks save, lifecycle et frame l'excutent dans une activit  part.
+ *
+ *      cmd     rafales de commandes non bloquantes (focus, configuration) :
+ *              appels systme et rveils du looper par commande, latence
+ *              entre l'appel du rappel et l'excution d'onAppCmd.
+ *
+ *      dispatch  dbit de process_input() : rafales de 32 mouvements (deux
+ *              pointeurs, huit chantillons historiques) injectes au plus
+ *              vite, distribues  onInputEvent puis  l'tage d'entre lu
+ *              aprs chaque vnement.
+ *
+ *      sensor  rejeu d'une trace d'acclromtre  200 Hz (synthtique, ou
+ *              lue avec -f : une ligne  t_us x y z  par chantillon), en
+ *              temps rel acclr par -x. Compare la lecture vnement par
+ *              vnement avec journal de l'ancien moteur  sensor_pipeline,
+ *              cran anim puis statique : vnements livrs, rveils du
+ *              looper et temps CPU du thread de l'application.
+ *
+ *      input   toucher soutenu  1 kHz, deux pointeurs et huit chantillons
+ *              historiques par vnement : distribution vnement par
+ *              vnement  onInputEvent (premier pointeur seulement), compare
+ *               l'tage d'entre diffr, lu une fois par image. Temps CPU du
+ *              thread de l'application, rveils du looper et chantillons livrs.
+ *
+ *      timing  cot d'un enregistrement de frame_timing (lecture d'horloge et
+ *              histogramme), seul puis avec le thread de l'application qui
+ *              enregistre dans le mme histogramme.
+ *
+ *      log     cot par appel, pour le thread appelant, de __android_log_print()
+ *              et d'ASYNC_LOG() (sans limite puis limit  100 messages par
+ *              seconde), par rafales de 32 messages spares d'une
+ *              milliseconde, comme les journaux d'une image.
+ *
+ *      snapshot  enregistrement puis restauration d'tats de 4 Kio, 1 Mio et
+ *              16 Mio par le code de collage : bloc allou et copi  chaque
+ *              enregistrement puis recopi dans l'tat de l'application  la
+ *              restauration, compar au format de state_snapshot.h (tampon de
+ *              la rserve, lecture sur place). Retourne 1 si un tat restaur
+ *              diffre de l'tat enregistr.
+ *
+ *      journal  journal d'tat de state_journal.h : cot d'un ajout, dure d'un
+ *              point de contrle en arrire-plan, ouverture  froid avec un
+ *              champ de 64 Kio, puis rouverture aprs une criture interrompue
+ *              (dernier enregistrement corrompu : la valeur prcdente est rendue).
+ *              Retourne 1 si une ouverture ne rend pas les champs enregistrs ou
+ *              si l'enregistrement interrompu n'est pas cart.
+ *
+ *      asset   chargement de ressources d'asset_stream.h, servies par un
+ *              rpertoire temporaire (fichiers dans le cache de pages) : dbit
+ *              et temps CPU du thread du looper pour 64 fichiers de 256 Kio
+ *              projets (stocks) ou copis (compresss), avec 1 et 2 threads
+ *              de chargement, compars  la lecture synchrone par le looper ;
+ *              latence de demandes prioritaires derrire une file de priorit
+ *              basse ; respect du budget du cache et prsence des ressources
+ *              rcentes ; annulation. Retourne 1 si un contenu diffre, si le
+ *              budget est dpass ou si une annulation n'a pas de rappel.
+ *
+ *      save    moteur : dure d'onSaveInstanceState() (APP_CMD_SAVE_STATE aller
+ *              et retour), puis d'ANativeActivity_onCreate() avec l'tat
+ *              enregistr.
+ *
+ *      lifecycle  moteur : cycles complets cration, dmarrage, reprise,
+ *              fentre, focus, pause, enregistrement, arrt et destruction,
+ *              l'tat de chaque cycle restaur au suivant. Dure de chaque
+ *              rappel et du cycle.
+ *
+ *      frame   moteur : boucle d'android_main() en rgime tabli, fentre
+ *              affiche et focus acquis, l'appareil en mouvement pour que
+ *              l'animation continue. Images par seconde et temps CPU par
+ *              image, du processus et du thread de l'application.
+ *
+ *      alloc   moteur : allocations sur le tas en rgime tabli, avec un toucher
+ *              et un chantillon d'acclromtre par image. Toutes les
+ *              allocations du processus sont comptes (runtime hte), moins
+ *              celles du thread qui injecte les vnements ; le programme
+ *              retourne 1 si une image en fait une seule.
+ *
+ *      raster  rendu logiciel de soft_raster.h : scnes alatoires de 200
+ *              commandes compares au pixel prs  la rfrence scalaire pour
+ *              chaque jeu d'instructions, sur 1 et 4 threads ; dbit en
+ *              mgapixels par seconde de chaque opration en 1280x720 ; puis
+ *              moteur sans EGL, qui doit prsenter ses images par
+ *              ANativeWindow_unlockAndPost(). Retourne 1 en cas d'cart.
+ *
+ *      resume  moteur : fentre dtruite puis recre, comme  chaque retour
+ *              dans l'application. Latence entre onNativeWindowCreated et la
+ *              premire prsentation, pour la premire fentre (initialisation
+ *              d'EGL) puis pour les suivantes, qui ne doivent crer qu'une
+ *              surface ; puis un redimensionnement, qui n'en cre aucune, et
+ *              une perte de contexte, qui en recre un seul. Retourne 1 si le
+ *              contexte n'est pas conserv.
+ *
+ *      config  moteur : rotation de l'cran, d'abord comme avant la dclaration
+ *              de screenSize dans le manifeste (activit dtruite puis recre
+ *              avec son tat enregistr), puis sur place (changement de
+ *              configuration et fentre redimensionne) : dlai jusqu'au retour
+ *              de la demande de redessin qui suit, prsente  la nouvelle
+ *              taille, contextes et surfaces EGL crs. Puis, au repos, mode
+ *              nuit et densit, livrs  l'abonn du repre, et orientation
+ *              seule, sans abonn. Retourne 1 si la rotation sur place recre
+ *              une surface ou un contexte, si le mode nuit ou la densit ne
+ *              redessinent pas une image, ou si l'orientation seule en dessine une.
+ *
+ *      redraw  moteur en rendu  la demande : images par seconde, rveils du
+ *              looper et temps CPU pendant que l'appareil bouge, puis au repos
+ *              une fois l'animation termine ; dure d'une demande de redessin
+ *              du systme et dlai entre un toucher et l'image prsente.
+ *              Retourne 1 si une image est prsente au repos, si le capteur
+ *              est enregistr  nouveau au repos, si le redessin n'est pas
+ *              prsent avant le retour de la demande ou si l'animation ne
+ *              reprend pas avec le focus.
+ *
+ *      resolution  moteur  cot de remplissage simul (dure de prsentation
+ *              proportionnelle aux pixels des tampons), fentre 1080x1920 :
+ *              chelle atteinte sous un cot lev, puis stabilit en rgime
+ *              tabli ; retour  la pleine rsolution quand le cot baisse ;
+ *              plafond impos par une marge thermique de 0,95. Retourne 1 si
+ *              l'chelle ne se stabilise pas sous le budget, oscille, ne remonte
+ *              pas ou ignore la marge thermique.
+ *
+ *      jobs    ordonnanceur de job_system.h : cot d'une tche de
+ *              parallel_for() et dbit d'un arbre de tches parentes et
+ *              filles, sur 1, 2 et 4 threads ; acclration d'un calcul
+ *              dcoup et utilisation de chaque thread ; latence d'un calcul
+ *              de premier plan pendant des tches de fond, avec puis sans
+ *              thread de fond. Retourne 1 si un rsultat est faux.
+ *
+ *      memory  budget de memory_budget.h sur des caches synthtiques : cot de
+ *              la vrification de chaque image, libration au-del du budget
+ *              (caches seulement, par priorit, jusqu'au seuil bas), pas de
+ *              nouvel essai sans croissance, puis arrt et mmoire faible :
+ *              octets librs et dure. Puis moteur : fentre recre aprs
+ *              l'arrt, qui garde le contexte EGL, et aprs une alerte de
+ *              mmoire faible, qui le recre. Retourne 1 si un palier est
+ *              libr  tort ou dans le dsordre.
+ *
+ *      trace   enregistrement d'event_trace.h : cot par mouvement (deux
+ *              pointeurs, huit chantillons historiques) et par chantillon
+ *              d'acclromtre  200 Hz, octets par vnement avant et aprs
+ *              compression, puis relecture compare au bit prs. Puis moteur :
+ *              session enregistre (cycle de vie, touchers, capteur), rejoue
+ *              par host_replay_run()  la vitesse d'origine puis au plus vite.
+ *              Retourne 1 si la relecture diffre ou si le rejeu ne redonne pas
+ *              les mmes commandes, les mmes entres, toutes termines, et les
+ *              mmes lectures de l'acclromtre.
+ *
+ *      systrace  marqueurs de sys_trace.h : cot d'une tranche (dbut et fin),
+ *              d'une tranche asynchrone et d'un compteur, ATrace de l'hte
+ *              compris ; anneau d'un thread rempli trois fois, export : les
+ *              fins dont le dbut a t cras doivent disparatre. Puis
+ *              moteur : session avec touchers, export demand par SIGUSR2 ;
+ *              l'export doit tre tri, chaque tranche ferme sur son thread,
+ *              chaque commande avoir sa tranche asynchrone complte, et les
+ *              rappels, les commandes et les phases d'image tre prsents.
+ *              Retourne 1 sinon, ou si une fin ATrace n'a pas de dbut.
+ *
+ *      bus     distribution d'event_bus.h  48 abonns, sur des cls tires au
+ *              hasard : abonns pars (quatre cls chacun, six par cl en
+ *              moyenne) puis abonns de toutes les cls, non dvelopps en
+ *              ligne ; cot par vnement,
+ *              compar au parcours d'une liste d'abonns enregistrs 
+ *              l'excution (masque et pointeur de fonction). Retourne 1 si un
+ *              abonn est appel  tort, manqu ou dans le dsordre.
+ *
+ * Plusieurs benchmarks peuvent tre donns ;  all  les excute tous. Avec -j,
+ * les rsultats sont aussi crits en JSON dans le fichier indiqu, une entre
+ * par mesure, pour suivre les rgressions d'une version  l'autre :
+ *
+ *      { "suite": "host_bench", "version": 1, "timestamp": ..., "iterations": ...,
+ *        "results": [ { "benchmark": "cmd", "metric": "latency_p50",
+ *                       "unit": "us", "value": 4.99 }, ... ] }
+ *
+ * Les bilans de phases que le moteur crit  chaque pause sont carts.
+ *
+ * Utilisation : host_bench [-n itrations] [-b taille de rafale] [-f trace]
+ *                          [-x acclration] [-j fichier JSON] [benchmark...]
+ */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <malloc.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <android/log.h>
+
+#include "android_native_app_glue.h"
+#include "asset_stream.h"
+#include "async_log.h"
+#include "event_bus.h"
+#include "event_trace.h"
+#include "frame_timing.h"
+#include "input_stage.h"
+#include "job_system.h"
+#include "memory_budget.h"
+#include "sensor_pipeline.h"
+#include "soft_raster.h"
+#include "state_snapshot.h"
+#include "state_journal.h"
+#include "sys_trace.h"
+#include "host_runtime.h"
+
+#define BENCH_MAX_SAMPLES (1 << 20)
+
+#define BENCH_FRAME_NS 16666667LL
+#define BENCH_INPUT_POINTERS 2
+#define BENCH_INPUT_HISTORY 8
+#define BENCH_INPUT_MAX_EVENTS 4000
+
+#define BENCH_LOG_BURST 32
+#define BENCH_LOG_MAX_MESSAGES 20000
+
+#define BENCH_DISPATCH_BURST 32
+#define BENCH_DISPATCH_MAX_EVENTS 20000
+
+#define BENCH_SAVE_MAX 10000
+#define BENCH_RESTORE_MAX 1000
+#define BENCH_LIFECYCLE_MAX 1000
+#define BENCH_FRAME_MAX 300
+#define BENCH_RESUME_MAX 1000
+
+#define BENCH_SNAPSHOT_MAX 200
+#define BENCH_SNAPSHOT_BYTES (256 << 20)
+#define BENCH_SNAPSHOT_SCHEMA 0x48434e42u
+#define BENCH_SNAPSHOT_FIELD 1
+
+#define BENCH_JOURNAL_SCHEMA 0x4e524a42u
+#define BENCH_JOURNAL_ANGLE 1
+#define BENCH_JOURNAL_BLOB 2
+#define BENCH_JOURNAL_BLOB_BYTES (64 << 10)
+#define BENCH_JOURNAL_OPENS 200
+
+#define BENCH_RASTER_WIDTH 1280
+#define BENCH_RASTER_HEIGHT 720
+#define BENCH_RASTER_COMMANDS 200
+#define BENCH_RASTER_SCENES 16
+#define BENCH_RASTER_MAX_FRAMES 200
+
+#define BENCH_ASSET_FILES 64
+#define BENCH_ASSET_BYTES (256 << 10)
+#define BENCH_ASSET_SMALL 32
+#define BENCH_ASSET_SMALL_BYTES (4 << 10)
+#define BENCH_ASSET_MAX (BENCH_ASSET_FILES + BENCH_ASSET_SMALL)
+#define BENCH_ASSET_BUDGET (4 << 20)
+#define BENCH_ASSET_ROUNDS 5
+
+#define BENCH_CONFIG_MAX 200
+
+#define BENCH_REDRAW_FRAMES 60
+#define BENCH_REDRAW_SETTLE_NS 500000000LL
+#define BENCH_REDRAW_REFOCUS_FRAMES 10
+
+#define BENCH_RESOLUTION_WIDTH 1080
+#define BENCH_RESOLUTION_HEIGHT 1920
+#define BENCH_RESOLUTION_HIGH_COST 12000000LL
+#define BENCH_RESOLUTION_LOW_COST 3000000LL
+#define BENCH_RESOLUTION_CONVERGE_NS 3000000000LL
+#define BENCH_RESOLUTION_STEADY_NS 2000000000LL
+#define BENCH_RESOLUTION_RECOVER_NS 15000000000LL
+#define BENCH_RESOLUTION_THERMAL_NS 1500000000LL
+
+#define BENCH_JOBS_MAX 100000
+#define BENCH_JOBS_TREE_DEPTH 12
+#define BENCH_JOBS_CHUNKS 1024
+#define BENCH_JOBS_WORK 2000
+#define BENCH_JOBS_BACKGROUND_JOBS 200
+#define BENCH_JOBS_BACKGROUND_ITEMS 256
+#define BENCH_JOBS_LATENCY_ROUNDS 50
+
+#define BENCH_MEMORY_BUDGET (8 << 20)
+#define BENCH_MEMORY_BLOCK (64 << 10)
+#define BENCH_MEMORY_MAX_BLOCKS 128
+#define BENCH_MEMORY_MAX_CALLS 64
+
+#define BENCH_TRACE_MAX_EVENTS 4096
+#define BENCH_TRACE_POINTERS 2
+#define BENCH_TRACE_HISTORY 8
+#define BENCH_TRACE_SENSOR_BATCH 4
+#define BENCH_TRACE_TOUCHES 100
+
+#define BENCH_SYSTRACE_MAX_MARKERS 200000
+#define BENCH_SYSTRACE_TOUCHES 20
+#define BENCH_SYSTRACE_MAX_ASYNC 256
+#define BENCH_SYSTRACE_MAX_LINE 512
+
+#define BENCH_BUS_SUBSCRIBERS 48
+#define BENCH_BUS_KEY_SEQUENCE 1024
+#define BENCH_BUS_MAX_EVENTS 10000000
+
+#define BENCH_MAX_RESULTS 256
+
+#define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, "host_bench", __VA_ARGS__))
+
+enum {
+    BENCH_INPUT_LEGACY,
+    BENCH_INPUT_STAGE,
+    // tage d'entre sans report : le lot est lu aprs chaque passage du looper.
+    BENCH_INPUT_IMMEDIATE,
+};
+
+enum {
+    BENCH_SNAPSHOT_OFF,
+    // Bloc allou avec malloc()  chaque enregistrement, tat recopi  la restauration.
+    BENCH_SNAPSHOT_LEGACY,
+    BENCH_SNAPSHOT_POOLED,
+};
+
+enum {
+    BENCH_SENSOR_OFF,
+    BENCH_SENSOR_LEGACY,
+    BENCH_SENSOR_ANIMATING,
+    BENCH_SENSOR_STATIC,
+};
+
+struct bench_sample {
+    int64_t timestamp;
+    float x;
+    float y;
+    float z;
+};
+
+struct bench_app {
+    // Instant d'envoi de chaque commande, crit par le thread principal avant l'envoi.
+    int64_t* sendTimes;
+
+    // Latence de chaque commande, crite par le thread de l'application.
+    int64_t* latencies;
+
+    uint64_t processed;
+
+    // Benchmark sensor : mode courant, horloge CPU du thread de l'application,
+    // file et chane d'acquisition cres par android_main().
+    int sensorMode;
+    clockid_t appCpuClock;
+    ASensorEventQueue* sensorQueue;
+    const ASensor* accelerometer;
+    struct sensor_pipeline pipeline;
+    struct sensor_pipeline_stats pipelineStats;
+
+    // Benchmark input : mode courant, tage d'entre et chantillons lus par
+    // le thread de l'application.
+    int inputMode;
+    struct input_stage inputStage;
+    uint64_t inputSamples;
+    uint64_t inputBatches;
+    float inputSink;
+
+    // Activit confie au moteur, et horloge CPU de son thread.
+    ANativeActivity* engineActivity;
+    clockid_t engineCpuClock;
+
+    // Benchmark snapshot : mode courant, tat de l'application, activit de
+    // restauration, instant o son tat est disponible et restaurations dont
+    // l'tat diffre de celui enregistr.
+    int snapshotMode;
+    uint8_t* snapshotData;
+    size_t snapshotSize;
+    ANativeActivity* restoreActivity;
+    int64_t restoredAt;
+    uint8_t* restoreCopy;
+    uint32_t restoreSink;
+    int restoreMismatches;
+};
+
+static struct bench_app bench_app;
+
+/**
+ * Mesure retenue pour le rapport JSON.
+ */
+struct bench_result {
+    char benchmark[32];
+    char metric[32];
+    const char* unit;
+    double value;
+};
+
+static struct bench_result bench_results[BENCH_MAX_RESULTS];
+static int bench_result_count;
+
+// Point d'entre de main.cpp, renomm  la compilation pour host_bench.
+extern "C" void engine_android_main(struct android_app* state);
+
+static void bench_result(const char* benchmark, const char* metric, const char* unit,
+        double value) {
+    if (bench_result_count == BENCH_MAX_RESULTS) {
+        return;
+    }
+    struct bench_result* result = &bench_results[bench_result_count++];
+    snprintf(result->benchmark, sizeof(result->benchmark), "%s", benchmark);
+    snprintf(result->metric, sizeof(result->metric), "%s", metric);
+    result->unit = unit;
+    result->value = value;
+}
+
+static int bench_cmd_is_measured(int32_t cmd) {
+    return cmd == APP_CMD_GAINED_FOCUS || cmd == APP_CMD_LOST_FOCUS
+            || cmd == APP_CMD_CONFIG_CHANGED;
+}
+
+static void bench_sensor_cmd(int32_t cmd) {
+    int mode = __atomic_load_n(&bench_app.sensorMode, __ATOMIC_ACQUIRE);
+    if (cmd == APP_CMD_GAINED_FOCUS) {
+        if (mode == BENCH_SENSOR_LEGACY) {
+            // Rglage de l'ancien moteur : 60 vnements par seconde, sans regroupement.
+            ASensorEventQueue_enableSensor(bench_app.sensorQueue, bench_app.accelerometer);
+            ASensorEventQueue_setEventRate(bench_app.sensorQueue, bench_app.accelerometer,
+                    (1000L / 60) * 1000);
+        } else {
+            sensor_pipeline_init(&bench_app.pipeline, bench_app.sensorQueue,
+                    bench_app.accelerometer, 1000000000LL / 60);
+            sensor_pipeline_enable(&bench_app.pipeline, mode == BENCH_SENSOR_STATIC);
+        }
+    } else if (cmd == APP_CMD_LOST_FOCUS) {
+        if (mode == BENCH_SENSOR_LEGACY) {
+            ASensorEventQueue_disableSensor(bench_app.sensorQueue, bench_app.accelerometer);
+        } else {
+            sensor_pipeline_drain(&bench_app.pipeline);
+            sensor_pipeline_disable(&bench_app.pipeline);
+            sensor_pipeline_report(&bench_app.pipeline, &bench_app.pipelineStats);
+        }
+    }
+    __atomic_store_n(&bench_app.processed, bench_app.processed + 1, __ATOMIC_RELEASE);
+}
+
+static void bench_sensor_drain(void) {
+    if (__atomic_load_n(&bench_app.sensorMode, __ATOMIC_ACQUIRE) == BENCH_SENSOR_LEGACY) {
+        ASensorEvent event;
+        while (ASensorEventQueue_getEvents(bench_app.sensorQueue, &event, 1) > 0) {
+            LOGI("accelerometer: x=%f y=%f z=%f",
+                    event.acceleration.x, event.acceleration.y, event.acceleration.z);
+        }
+    } else {
+        sensor_pipeline_drain(&bench_app.pipeline);
+        struct sensor_sample samples[8];
+        while (sensor_pipeline_read(&bench_app.pipeline, samples, 8) > 0) {
+        }
+    }
+}
+
+// Benchmark snapshot : enregistrement de l'tat de snapshotSize octets.
+static void bench_snapshot_save(struct android_app* app) {
+    int mode = __atomic_load_n(&bench_app.snapshotMode, __ATOMIC_ACQUIRE);
+    size_t size = bench_app.snapshotSize;
+    if (mode == BENCH_SNAPSHOT_LEGACY) {
+        app->savedState = malloc(size);
+        memcpy(app->savedState, bench_app.snapshotData, size);
+        app->savedStateSize = size;
+    } else {
+        struct state_snapshot_writer writer;
+        if (state_snapshot_begin(&writer, BENCH_SNAPSHOT_SCHEMA, 1, STATE_SNAPSHOT_SPACE(size)) == 0) {
+            state_snapshot_put(&writer, BENCH_SNAPSHOT_FIELD, STATE_FIELD_BYTES,
+                    bench_app.snapshotData, size);
+            app->savedState = state_snapshot_finish(&writer, &app->savedStateSize);
+        }
+    }
+}
+
+// Benchmark snapshot : thread de l'activit de restauration. L'tat est rendu
+// disponible comme le ferait l'application, puis l'activit attend sa destruction.
+static void bench_restore_main(struct android_app* state) {
+    int mode = __atomic_load_n(&bench_app.snapshotMode, __ATOMIC_ACQUIRE);
+    const uint8_t* data = NULL;
+    size_t size = 0;
+    if (mode == BENCH_SNAPSHOT_LEGACY) {
+        free(bench_app.restoreCopy);
+        bench_app.restoreCopy = (uint8_t*)malloc(state->savedStateSize);
+        memcpy(bench_app.restoreCopy, state->savedState, state->savedStateSize);
+        data = bench_app.restoreCopy;
+        size = state->savedStateSize;
+    } else {
+        struct state_snapshot_view view;
+        if (state_snapshot_open(&view, state->savedState, state->savedStateSize,
+                BENCH_SNAPSHOT_SCHEMA) == 0) {
+            data = (const uint8_t*)state_snapshot_get(&view, BENCH_SNAPSHOT_FIELD,
+                    STATE_FIELD_BYTES, &size);
+        }
+    }
+    if (data != NULL && size > 0) {
+        bench_app.restoreSink += data[0] + data[size - 1];
+    }
+    __atomic_store_n(&bench_app.restoredAt, host_now_ns(), __ATOMIC_RELEASE);
+
+    // Vrification hors mesure ; onDestroy() attend la fin de ce thread.
+    if (data == NULL || size != bench_app.snapshotSize || memcmp(data, bench_app.snapshotData, size) != 0) {
+        __atomic_add_fetch(&bench_app.restoreMismatches, 1, __ATOMIC_RELAXED);
+    }
+
+    while (!state->destroyRequested) {
+        int events;
+        struct android_poll_source* source;
+        if (ALooper_pollAll(-1, NULL, &events, (void**)&source) >= 0 && source != NULL) {
+            source->process(state, source);
+        }
+    }
+}
+
+static void bench_handle_cmd(struct android_app* app, int32_t cmd) {
+    if (cmd == APP_CMD_SAVE_STATE
+            && __atomic_load_n(&bench_app.snapshotMode, __ATOMIC_ACQUIRE) != BENCH_SNAPSHOT_OFF) {
+        bench_snapshot_save(app);
+        return;
+    }
+    if (__atomic_load_n(&bench_app.sensorMode, __ATOMIC_ACQUIRE) != BENCH_SENSOR_OFF) {
+        bench_sensor_cmd(cmd);
+        return;
+    }
+    if (!bench_cmd_is_measured(cmd)) {
+        return;
+    }
+    uint64_t index = bench_app.processed;
+    if (index < BENCH_MAX_SAMPLES) {
+        bench_app.latencies[index] = host_now_ns() - bench_app.sendTimes[index];
+    }
+    __atomic_store_n(&bench_app.processed, index + 1, __ATOMIC_RELEASE);
+}
+
+static int32_t bench_handle_input(struct android_app* app, AInputEvent* event) {
+    // Ancien moteur : seule la position courante du premier pointeur est lue.
+    if (AInputEvent_getType(event) == AINPUT_EVENT_TYPE_MOTION) {
+        bench_app.inputSink += AMotionEvent_getX(event, 0) + AMotionEvent_getY(event, 0);
+        bench_app.inputSamples++;
+        return 1;
+    }
+    return 0;
+}
+
+// Benchmark dispatch : lot lu aussitt aprs le passage du looper.
+static void bench_input_consume(void) {
+    const struct input_batch* batch = input_stage_swap(&bench_app.inputStage);
+    for (size_t i = 0; i < batch->count; i++) {
+        bench_app.inputSink += batch->x[i] + batch->y[i];
+    }
+    bench_app.inputSamples += batch->count;
+    if (batch->events > 0) {
+        bench_app.inputBatches++;
+    }
+}
+
+// Benchmark input : lecture de la file puis du lot de l'tage d'entre, une fois par image.
+static void bench_input_frame(struct android_app* state) {
+    android_app_latch_input(state);
+    bench_input_consume();
+}
+
+void android_main(struct android_app* state) {
+    if (state->activity == __atomic_load_n(&bench_app.engineActivity, __ATOMIC_ACQUIRE)) {
+        pthread_getcpuclockid(pthread_self(), &bench_app.engineCpuClock);
+        engine_android_main(state);
+        return;
+    }
+    if (state->activity == __atomic_load_n(&bench_app.restoreActivity, __ATOMIC_ACQUIRE)) {
+        bench_restore_main(state);
+        return;
+    }
+
+    state->onAppCmd = bench_handle_cmd;
+    state->onInputEvent = bench_handle_input;
+    input_stage_init(&bench_app.inputStage);
+    pthread_getcpuclockid(pthread_self(), &bench_app.appCpuClock);
+    ASensorManager* manager = ASensorManager_getInstance();
+    bench_app.accelerometer = ASensorManager_getDefaultSensor(manager, ASENSOR_TYPE_ACCELEROMETER);
+    bench_app.sensorQueue = ASensorManager_createEventQueue(manager, state->looper,
+            LOOPER_ID_USER, NULL, NULL);
+
+    int64_t nextFrame = 0;
+    while (1) {
+        // En mode tage d'entre, la boucle dessine une image toutes les 16,7 ms.
+        int inputMode = __atomic_load_n(&bench_app.inputMode, __ATOMIC_ACQUIRE);
+        int staged = inputMode == BENCH_INPUT_STAGE;
+        int timeout = -1;
+        if (bench_app.inputStage.deferred != staged) {
+            bench_app.inputStage.deferred = staged;
+            android_app_latch_input(state);
+        }
+        if (staged) {
+            int64_t now = host_now_ns();
+            if (nextFrame == 0) nextFrame = now + BENCH_FRAME_NS;
+            timeout = nextFrame > now ? (int)((nextFrame - now + 999999) / 1000000) : 0;
+        }
+
+        int events;
+        struct android_poll_source* source;
+        int ident = ALooper_pollAll(timeout, NULL, &events, (void**)&source);
+        if (ident >= 0) {
+            state->inputStage = inputMode != BENCH_INPUT_LEGACY ? &bench_app.inputStage : NULL;
+            if (source != NULL) {
+                source->process(state, source);
+            }
+            if (ident == LOOPER_ID_INPUT && inputMode == BENCH_INPUT_IMMEDIATE) {
+                bench_input_consume();
+            }
+            if (ident == LOOPER_ID_USER) {
+                bench_sensor_drain();
+            }
+            if (state->destroyRequested != 0) {
+                ASensorManager_destroyEventQueue(manager, bench_app.sensorQueue);
+                return;
+            }
+        }
+
+        if (staged && host_now_ns() >= nextFrame) {
+            bench_input_frame(state);
+            nextFrame += BENCH_FRAME_NS;
+            if (nextFrame < host_now_ns()) nextFrame = host_now_ns() + BENCH_FRAME_NS;
+        } else if (!staged) {
+            nextFrame = 0;
+        }
+    }
+}
+
+static int bench_compare(const void* a, const void* b) {
+    int64_t x = *(const int64_t*)a;
+    int64_t y = *(const int64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static void bench_wait_processed(uint64_t count) {
+    while (__atomic_load_n(&bench_app.processed, __ATOMIC_ACQUIRE) < count) {
+        sched_yield();
+    }
+}
+
+static void bench_cmd(ANativeActivity* activity, int iterations, int burst) {
+    static const int32_t sequence[] = {
+        APP_CMD_GAINED_FOCUS, APP_CMD_CONFIG_CHANGED, APP_CMD_LOST_FOCUS,
+    };
+
+    // Les commandes d'un benchmark prcdent ne comptent pas.
+    __atomic_store_n(&bench_app.processed, 0, __ATOMIC_RELEASE);
+    uint64_t total = (uint64_t)iterations * burst;
+    if (total > BENCH_MAX_SAMPLES) {
+        total = BENCH_MAX_SAMPLES;
+        iterations = (int)(total / burst);
+        total = (uint64_t)iterations * burst;
+    }
+
+    struct host_counters before;
+    struct host_counters after;
+    host_counters_get(&before);
+    int64_t start = host_now_ns();
+
+    uint64_t sent = 0;
+    for (int i = 0; i < iterations; i++) {
+        for (int j = 0; j < burst; j++) {
+            int32_t cmd = sequence[j % 3];
+            bench_app.sendTimes[sent++] = host_now_ns();
+            if (cmd == APP_CMD_CONFIG_CHANGED) {
+                activity->callbacks->onConfigurationChanged(activity);
+            } else {
+                activity->callbacks->onWindowFocusChanged(activity, cmd == APP_CMD_GAINED_FOCUS);
+            }
+        }
+        bench_wait_processed(sent);
+    }
+
+    int64_t elapsed = host_now_ns() - start;
+    host_counters_get(&after);
+
+    qsort(bench_app.latencies, total, sizeof(int64_t), bench_compare);
+    int64_t sum = 0;
+    for (uint64_t i = 0; i < total; i++) {
+        sum += bench_app.latencies[i];
+    }
+
+    double commands = (double)total;
+    printf("cmd: commands=%llu burst=%d elapsed=%.3f s\n",
+            (unsigned long long)total, burst, elapsed / 1e9);
+    printf("cmd: syscalls/cmd=%.3f (read=%.3f write=%.3f) looper_wakeups/cmd=%.3f\n",
+            (after.reads - before.reads + after.writes - before.writes) / commands,
+            (after.reads - before.reads) / commands,
+            (after.writes - before.writes) / commands,
+            (after.looperWakeups - before.looperWakeups) / commands);
+    printf("cmd: latency_us mean=%.2f p50=%.2f p99=%.2f max=%.2f\n",
+            sum / commands / 1000.0,
+            bench_app.latencies[total / 2] / 1000.0,
+            bench_app.latencies[total * 99 / 100] / 1000.0,
+            bench_app.latencies[total - 1] / 1000.0);
+
+    bench_result("cmd", "syscalls_per_cmd", "count",
+            (after.reads - before.reads + after.writes - before.writes) / commands);
+    bench_result("cmd", "wakeups_per_cmd", "count",
+            (after.looperWakeups - before.looperWakeups) / commands);
+    bench_result("cmd", "latency_mean", "us", sum / commands / 1000.0);
+    bench_result("cmd", "latency_p50", "us", bench_app.latencies[total / 2] / 1000.0);
+    bench_result("cmd", "latency_p99", "us", bench_app.latencies[total * 99 / 100] / 1000.0);
+    bench_result("cmd", "latency_max", "us", bench_app.latencies[total - 1] / 1000.0);
+}
+
+// --------------------------------------------------------------------
+// Rejeu de capteur
+// --------------------------------------------------------------------
+
+// Trace synthtique de 30 s  200 Hz : immobile, marche (2 Hz), tremblement
+// de la main, puis de nouveau immobile ; bruit pseudo-alatoire dterministe.
+static size_t bench_sensor_synthesize(struct bench_sample* samples, size_t capacity) {
+    const int64_t period = 5000000;
+    uint32_t seed = 12345;
+    size_t count = 0;
+    for (int64_t t = 0; t < 30000000000LL && count < capacity; t += period) {
+        double seconds = t * 1e-9;
+        double amplitude = 0;
+        double frequency = 0;
+        if (seconds >= 8 && seconds < 16) {
+            amplitude = 2.0;
+            frequency = 2.0;
+        } else if (seconds >= 16 && seconds < 22) {
+            amplitude = 0.3;
+            frequency = 9.0;
+        }
+        seed = seed * 1664525u + 1013904223u;
+        float noise = ((seed >> 8) / (float)(1 << 24) - 0.5f) * 0.02f;
+        float wave = (float)(amplitude * sin(2 * M_PI * frequency * seconds));
+        struct bench_sample* sample = &samples[count++];
+        sample->timestamp = t;
+        sample->x = wave * 0.5f + noise;
+        sample->y = ASENSOR_STANDARD_GRAVITY + wave + noise;
+        sample->z = noise;
+    }
+    return count;
+}
+
+static size_t bench_sensor_load(const char* path, struct bench_sample* samples, size_t capacity) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "cannot open trace '%s'\n", path);
+        return 0;
+    }
+    size_t count = 0;
+    long long timestampUs;
+    float x, y, z;
+    while (count < capacity && fscanf(file, "%lld %f %f %f", &timestampUs, &x, &y, &z) == 4) {
+        struct bench_sample* sample = &samples[count++];
+        sample->timestamp = timestampUs * 1000;
+        sample->x = x;
+        sample->y = y;
+        sample->z = z;
+    }
+    fclose(file);
+    return count;
+}
+
+static int64_t bench_clock_ns(clockid_t clock) {
+    struct timespec now;
+    clock_gettime(clock, &now);
+    return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static void bench_sensor_focus(ANativeActivity* activity, int focused) {
+    uint64_t target = __atomic_load_n(&bench_app.processed, __ATOMIC_ACQUIRE) + 1;
+    activity->callbacks->onWindowFocusChanged(activity, focused);
+    bench_wait_processed(target);
+}
+
+static void bench_sensor_run(ANativeActivity* activity, const char* name, int mode,
+        const struct bench_sample* samples, size_t count, int speedup) {
+    __atomic_store_n(&bench_app.sensorMode, mode, __ATOMIC_RELEASE);
+    memset(&bench_app.pipelineStats, 0, sizeof(bench_app.pipelineStats));
+    bench_sensor_focus(activity, 1);
+
+    struct host_counters before;
+    struct host_counters after;
+    host_counters_get(&before);
+    int64_t cpuStart = bench_clock_ns(bench_app.appCpuClock);
+    int64_t start = host_now_ns();
+    int64_t base = host_now_ns() - samples[0].timestamp;
+
+    // Les chantillons sont dats sur l'horloge monotone, la trace est rejoue
+    //  sa cadence divise par speedup.
+    for (size_t i = 0; i < count; i++) {
+        int64_t due = start + (samples[i].timestamp - samples[0].timestamp) / speedup;
+        struct timespec deadline;
+        deadline.tv_sec = due / 1000000000LL;
+        deadline.tv_nsec = due % 1000000000LL;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+        host_sensor_push_at(ASENSOR_TYPE_ACCELEROMETER, base + samples[i].timestamp,
+                samples[i].x, samples[i].y, samples[i].z);
+    }
+
+    bench_sensor_focus(activity, 0);
+    int64_t cpu = bench_clock_ns(bench_app.appCpuClock) - cpuStart;
+    host_counters_get(&after);
+
+    double traceSeconds = (samples[count - 1].timestamp - samples[0].timestamp) * 1e-9;
+    uint64_t delivered = after.sensorRead - before.sensorRead;
+    uint64_t wakeups = after.looperWakeups - before.looperWakeups;
+    printf("sensor/%s: pushed=%llu delivered=%llu wakeups=%llu (%.1f/s) log_lines=%llu\n",
+            name, (unsigned long long)count, (unsigned long long)delivered,
+            (unsigned long long)wakeups, wakeups / traceSeconds,
+            (unsigned long long)(after.logLines - before.logLines));
+    printf("sensor/%s: app_cpu_ms=%.3f us/delivered=%.3f us/trace_s=%.1f\n",
+            name, cpu / 1e6, delivered > 0 ? cpu / 1e3 / (double)delivered : 0.0,
+            cpu / 1e3 / traceSeconds);
+    char benchmark[32];
+    snprintf(benchmark, sizeof(benchmark), "sensor/%s", name);
+    bench_result(benchmark, "delivered", "count", (double)delivered);
+    bench_result(benchmark, "wakeups_per_s", "count", wakeups / traceSeconds);
+    bench_result(benchmark, "app_cpu_per_trace_s", "us", cpu / 1e3 / traceSeconds);
+    if (mode != BENCH_SENSOR_LEGACY) {
+        const struct sensor_pipeline_stats* stats = &bench_app.pipelineStats;
+        printf("sensor/%s: drains=%llu events/drain=%.1f samples=%llu rate_changes=%llu\n",
+                name, (unsigned long long)stats->drains,
+                stats->drains > 0 ? stats->events / (double)stats->drains : 0.0,
+                (unsigned long long)stats->samples, (unsigned long long)stats->rateChanges);
+    }
+}
+
+static void bench_sensor(ANativeActivity* activity, const char* tracePath, int speedup) {
+    const size_t capacity = 1 << 20;
+    struct bench_sample* samples = (struct bench_sample*)malloc(capacity * sizeof(struct bench_sample));
+    size_t count = tracePath != NULL ? bench_sensor_load(tracePath, samples, capacity)
+            : bench_sensor_synthesize(samples, capacity);
+    if (count < 2) {
+        fprintf(stderr, "sensor: trace too short\n");
+        free(samples);
+        return;
+    }
+    if (speedup < 1) speedup = 1;
+
+    bench_sensor_run(activity, "legacy", BENCH_SENSOR_LEGACY, samples, count, speedup);
+    bench_sensor_run(activity, "pipeline", BENCH_SENSOR_ANIMATING, samples, count, speedup);
+    bench_sensor_run(activity, "pipeline_static", BENCH_SENSOR_STATIC, samples, count, speedup);
+    __atomic_store_n(&bench_app.sensorMode, BENCH_SENSOR_OFF, __ATOMIC_RELEASE);
+    free(samples);
+}
+
+// --------------------------------------------------------------------
+// Entres
+// --------------------------------------------------------------------
+
+static void bench_input_run(AInputQueue* queue, const char* name, int mode, int count) {
+    __atomic_store_n(&bench_app.inputMode, mode, __ATOMIC_RELEASE);
+    // Rveil du thread de l'application pour qu'il prenne le mode en compte.
+    host_input_push_key(queue, AKEY_EVENT_ACTION_DOWN, AKEYCODE_BACK);
+    usleep(50000);
+
+    struct host_counters before;
+    struct host_counters after;
+    host_counters_get(&before);
+    uint64_t samplesBefore = bench_app.inputSamples;
+    uint64_t batchesBefore = bench_app.inputBatches;
+    int64_t cpuStart = bench_clock_ns(bench_app.appCpuClock);
+    int64_t start = host_now_ns();
+
+    float xy[BENCH_INPUT_POINTERS * 2];
+    for (int i = 0; i < count; i++) {
+        int64_t due = start + (int64_t)i * 1000000;
+        struct timespec deadline;
+        deadline.tv_sec = due / 1000000000LL;
+        deadline.tv_nsec = due % 1000000000LL;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+        for (int p = 0; p < BENCH_INPUT_POINTERS; p++) {
+            xy[p * 2] = 100.0f + p * 200.0f + (i % 500);
+            xy[p * 2 + 1] = 300.0f + (i % 700);
+        }
+        host_input_push_motion(queue, AMOTION_EVENT_ACTION_MOVE, BENCH_INPUT_POINTERS, xy,
+                BENCH_INPUT_HISTORY);
+    }
+
+    // Attente de la fin de tous les vnements, puis d'une image pour le dernier lot.
+    host_counters_get(&after);
+    while (after.inputFinished - before.inputFinished < (uint64_t)count) {
+        usleep(1000);
+        host_counters_get(&after);
+    }
+    usleep(2 * BENCH_FRAME_NS / 1000);
+    int64_t cpu = bench_clock_ns(bench_app.appCpuClock) - cpuStart;
+    host_counters_get(&after);
+
+    uint64_t samples = bench_app.inputSamples - samplesBefore;
+    uint64_t wakeups = after.looperWakeups - before.looperWakeups;
+    printf("input/%s: events=%d samples=%llu (%.1f/event) wakeups=%llu batches=%llu\n",
+            name, count, (unsigned long long)samples, samples / (double)count,
+            (unsigned long long)wakeups,
+            (unsigned long long)(bench_app.inputBatches - batchesBefore));
+    printf("input/%s: app_cpu_ms=%.3f us/event=%.3f ns/sample=%.1f\n",
+            name, cpu / 1e6, cpu / 1e3 / count, samples > 0 ? cpu / (double)samples : 0.0);
+
+    char benchmark[32];
+    snprintf(benchmark, sizeof(benchmark), "input/%s", name);
+    bench_result(benchmark, "samples_per_event", "count", samples / (double)count);
+    bench_result(benchmark, "wakeups", "count", (double)wakeups);
+    bench_result(benchmark, "app_cpu_per_event", "us", cpu / 1e3 / count);
+}
+
+static void bench_input(ANativeActivity* activity, int iterations) {
+    int count = iterations < BENCH_INPUT_MAX_EVENTS ? iterations : BENCH_INPUT_MAX_EVENTS;
+    if (count < 1) count = 1;
+
+    AInputQueue* queue = host_input_queue_create();
+    activity->callbacks->onInputQueueCreated(activity, queue);
+    bench_input_run(queue, "legacy", BENCH_INPUT_LEGACY, count);
+    bench_input_run(queue, "stage", BENCH_INPUT_STAGE, count);
+    __atomic_store_n(&bench_app.inputMode, BENCH_INPUT_LEGACY, __ATOMIC_RELEASE);
+    activity->callbacks->onInputQueueDestroyed(activity, queue);
+    host_input_queue_destroy(queue);
+}
+
+static void bench_dispatch_run(AInputQueue* queue, const char* name, int mode, int count) {
+    __atomic_store_n(&bench_app.inputMode, mode, __ATOMIC_RELEASE);
+    host_input_push_key(queue, AKEY_EVENT_ACTION_DOWN, AKEYCODE_BACK);
+    usleep(50000);
+
+    struct host_counters before;
+    struct host_counters after;
+    host_counters_get(&before);
+    uint64_t samplesBefore = bench_app.inputSamples;
+    int64_t cpuStart = bench_clock_ns(bench_app.appCpuClock);
+    int64_t start = host_now_ns();
+
+    // Chaque rafale est entirement termine avant la suivante : la file reste
+    // courte et le dbit mesur est celui de la distribution.
+    float xy[BENCH_INPUT_POINTERS * 2];
+    for (int i = 0; i < count; i += BENCH_DISPATCH_BURST) {
+        int burst = count - i < BENCH_DISPATCH_BURST ? count - i : BENCH_DISPATCH_BURST;
+        for (int j = 0; j < burst; j++) {
+            for (int p = 0; p < BENCH_INPUT_POINTERS; p++) {
+                xy[p * 2] = 100.0f + p * 200.0f + ((i + j) % 500);
+                xy[p * 2 + 1] = 300.0f + ((i + j) % 700);
+            }
+            host_input_push_motion(queue, AMOTION_EVENT_ACTION_MOVE, BENCH_INPUT_POINTERS, xy,
+                    BENCH_INPUT_HISTORY);
+        }
+        do {
+            sched_yield();
+            host_counters_get(&after);
+        } while (after.inputFinished - before.inputFinished < (uint64_t)(i + burst));
+    }
+
+    int64_t elapsed = host_now_ns() - start;
+    int64_t cpu = bench_clock_ns(bench_app.appCpuClock) - cpuStart;
+    host_counters_get(&after);
+
+    uint64_t samples = bench_app.inputSamples - samplesBefore;
+    uint64_t wakeups = after.looperWakeups - before.looperWakeups;
+    printf("dispatch/%s: events=%d elapsed=%.3f s events/s=%.0f samples/event=%.1f "
+            "wakeups/event=%.3f\n", name, count, elapsed / 1e9, count / (elapsed / 1e9),
+            samples / (double)count, wakeups / (double)count);
+    printf("dispatch/%s: app_cpu_us/event=%.3f wall_us/event=%.3f\n",
+            name, cpu / 1e3 / count, elapsed / 1e3 / count);
+
+    char benchmark[32];
+    snprintf(benchmark, sizeof(benchmark), "dispatch/%s", name);
+    bench_result(benchmark, "events_per_s", "count", count / (elapsed / 1e9));
+    bench_result(benchmark, "app_cpu_per_event", "us", cpu / 1e3 / count);
+    bench_result(benchmark, "wakeups_per_event", "count", wakeups / (double)count);
+}
+
+static void bench_dispatch(ANativeActivity* activity, int iterations) {
+    int count = iterations < BENCH_DISPATCH_MAX_EVENTS ? iterations : BENCH_DISPATCH_MAX_EVENTS;
+    if (count < 1) count = 1;
+
+    AInputQueue* queue = host_input_queue_create();
+    activity->callbacks->onInputQueueCreated(activity, queue);
+    bench_dispatch_run(queue, "legacy", BENCH_INPUT_LEGACY, count);
+    bench_dispatch_run(queue, "stage", BENCH_INPUT_IMMEDIATE, count);
+    __atomic_store_n(&bench_app.inputMode, BENCH_INPUT_LEGACY, __ATOMIC_RELEASE);
+    activity->callbacks->onInputQueueDestroyed(activity, queue);
+    host_input_queue_destroy(queue);
+}
+
+// --------------------------------------------------------------------
+// Mesure des phases
+// --------------------------------------------------------------------
+
+static struct frame_timing bench_timing;
+static int bench_timing_stop;
+
+static void* bench_timing_contender(void* param) {
+    while (!__atomic_load_n(&bench_timing_stop, __ATOMIC_ACQUIRE)) {
+        frame_timing_end(&bench_timing, FRAME_PHASE_DRAW, frame_timing_now());
+    }
+    return NULL;
+}
+
+static void bench_timing_run(const char* name, int iterations) {
+    frame_timing_reset(&bench_timing);
+    int64_t start = host_now_ns();
+    int64_t t = frame_timing_now();
+    for (int i = 0; i < iterations; i++) {
+        t = frame_timing_end(&bench_timing, FRAME_PHASE_FRAME, t);
+    }
+    int64_t elapsed = host_now_ns() - start;
+
+    struct frame_timing_summary summary;
+    frame_timing_summarize(&bench_timing, FRAME_PHASE_FRAME, &summary);
+    printf("timing/%s: records=%d ns/record=%.1f p50=%lld p99=%lld p99.9=%lld max=%lld\n",
+            name, iterations, elapsed / (double)iterations, (long long)summary.p50Ns,
+            (long long)summary.p99Ns, (long long)summary.p999Ns, (long long)summary.maxNs);
+
+    char benchmark[32];
+    snprintf(benchmark, sizeof(benchmark), "timing/%s", name);
+    bench_result(benchmark, "record_mean", "ns", elapsed / (double)iterations);
+    bench_result(benchmark, "record_p99", "ns", (double)summary.p99Ns);
+}
+
+static void bench_timing_all(int iterations) {
+    frame_timing_init(&bench_timing);
+    bench_timing_run("single", iterations);
+
+    pthread_t thread;
+    __atomic_store_n(&bench_timing_stop, 0, __ATOMIC_RELEASE);
+    if (pthread_create(&thread, NULL, bench_timing_contender, NULL) == 0) {
+        bench_timing_run("contended", iterations);
+        __atomic_store_n(&bench_timing_stop, 1, __ATOMIC_RELEASE);
+        pthread_join(thread, NULL);
+    }
+    frame_timing_write(&bench_timing, stdout);
+}
+
+// --------------------------------------------------------------------
+// Journal
+// --------------------------------------------------------------------
+
+ASYNC_LOG_TAG(bench_log_tag, "host_bench", 0);
+ASYNC_LOG_TAG(bench_log_limited_tag, "host_bench_limited", 100);
+
+enum {
+    BENCH_LOG_SYNC,
+    BENCH_LOG_ASYNC,
+    BENCH_LOG_ASYNC_LIMITED,
+};
+
+static void bench_log_run(const char* name, int mode, int messages) {
+    struct async_log_stats before;
+    struct async_log_stats after;
+    async_log_flush();
+    async_log_get_stats(&before);
+
+    for (int i = 0; i < messages; i++) {
+        if (i % BENCH_LOG_BURST == 0 && i > 0) {
+            usleep(1000);
+        }
+        int64_t start = host_now_ns();
+        switch (mode) {
+            case BENCH_LOG_SYNC:
+                __android_log_print(ANDROID_LOG_VERBOSE, "host_bench",
+                        "New input event: type=%d x=%.1f y=%.1f source=%s\n", 2, i * 0.5f, i * 0.25f,
+                        "touchscreen");
+                break;
+            case BENCH_LOG_ASYNC:
+                ASYNC_LOG(ANDROID_LOG_VERBOSE, &bench_log_tag,
+                        "New input event: type=%d x=%.1f y=%.1f source=%s\n", 2, i * 0.5f, i * 0.25f,
+                        "touchscreen");
+                break;
+            case BENCH_LOG_ASYNC_LIMITED:
+                ASYNC_LOG(ANDROID_LOG_VERBOSE, &bench_log_limited_tag,
+                        "New input event: type=%d x=%.1f y=%.1f source=%s\n", 2, i * 0.5f, i * 0.25f,
+                        "touchscreen");
+                break;
+        }
+        bench_app.latencies[i] = host_now_ns() - start;
+    }
+
+    async_log_flush();
+    async_log_get_stats(&after);
+
+    qsort(bench_app.latencies, messages, sizeof(int64_t), bench_compare);
+    int64_t sum = 0;
+    for (int i = 0; i < messages; i++) {
+        sum += bench_app.latencies[i];
+    }
+    printf("log/%s: messages=%d ns/call mean=%.0f p50=%lld p99=%lld max=%lld\n",
+            name, messages, sum / (double)messages,
+            (long long)bench_app.latencies[messages / 2],
+            (long long)bench_app.latencies[messages * 99 / 100],
+            (long long)bench_app.latencies[messages - 1]);
+    char benchmark[32];
+    snprintf(benchmark, sizeof(benchmark), "log/%s", name);
+    bench_result(benchmark, "call_mean", "ns", sum / (double)messages);
+    bench_result(benchmark, "call_p50", "ns", (double)bench_app.latencies[messages / 2]);
+    bench_result(benchmark, "call_p99", "ns", (double)bench_app.latencies[messages * 99 / 100]);
+    if (mode != BENCH_LOG_SYNC) {
+        bench_result(benchmark, "dropped", "count", (double)(after.dropped - before.dropped));
+        printf("log/%s: written=%llu dropped=%llu suppressed=%llu\n", name,
+                (unsigned long long)(after.written - before.written),
+                (unsigned long long)(after.dropped - before.dropped),
+                (unsigned long long)(after.suppressed - before.suppressed));
+    }
+}
+
+static void bench_log(int iterations) {
+    int messages = iterations < BENCH_LOG_MAX_MESSAGES ? iterations : BENCH_LOG_MAX_MESSAGES;
+    if (messages < 1) messages = 1;
+    bench_log_run("sync", BENCH_LOG_SYNC, messages);
+    bench_log_run("async", BENCH_LOG_ASYNC, messages);
+    bench_log_run("async_limited", BENCH_LOG_ASYNC_LIMITED, messages);
+}
+
+// --------------------------------------------------------------------
+// tat enregistr
+// --------------------------------------------------------------------
+
+static void bench_latency_report(const char* benchmark, int64_t* latencies, int count) {
+    qsort(latencies, count, sizeof(int64_t), bench_compare);
+    int64_t sum = 0;
+    for (int i = 0; i < count; i++) {
+        sum += latencies[i];
+    }
+    printf("%s: count=%d latency_us mean=%.2f p50=%.2f p99=%.2f max=%.2f\n", benchmark, count,
+            sum / (double)count / 1000.0, latencies[count / 2] / 1000.0,
+            latencies[count * 99 / 100] / 1000.0, latencies[count - 1] / 1000.0);
+    bench_result(benchmark, "latency_mean", "us", sum / (double)count / 1000.0);
+    bench_result(benchmark, "latency_p50", "us", latencies[count / 2] / 1000.0);
+    bench_result(benchmark, "latency_p99", "us", latencies[count * 99 / 100] / 1000.0);
+    bench_result(benchmark, "latency_max", "us", latencies[count - 1] / 1000.0);
+}
+
+// Retourne le nombre de restaurations dont l'tat diffre de celui enregistr.
+static int bench_snapshot_run(ANativeActivity* activity, const char* name, int mode,
+        size_t size, int iterations) {
+    int count = (int)(BENCH_SNAPSHOT_BYTES / size);
+    if (count > iterations) count = iterations;
+    if (count > BENCH_SNAPSHOT_MAX) count = BENCH_SNAPSHOT_MAX;
+    if (count < 4) count = 4;
+
+    __atomic_store_n(&bench_app.snapshotMode, mode, __ATOMIC_RELEASE);
+    bench_app.snapshotSize = size;
+    __atomic_store_n(&bench_app.restoreMismatches, 0, __ATOMIC_RELAXED);
+    struct state_pool_stats poolBefore;
+    struct state_pool_stats poolAfter;
+    state_pool_get_stats(&poolBefore);
+
+    // Enregistrement : dure pendant laquelle le thread principal de l'activit
+    // est bloqu. Le systme copie puis libre le bloc, hors mesure.
+    void* savedState = NULL;
+    size_t savedStateSize = 0;
+    for (int i = 0; i < count; i++) {
+        free(savedState);
+        int64_t start = host_now_ns();
+        savedState = activity->callbacks->onSaveInstanceState(activity, &savedStateSize);
+        bench_app.latencies[i] = host_now_ns() - start;
+        // Le remplaant du bloc est prpar par le thread de l'application.
+        usleep(size >> 10 > 1000 ? 20000 : 1000);
+    }
+    state_pool_get_stats(&poolAfter);
+
+    // Restauration : de la cration de l'activit jusqu' l'tat disponible
+    // dans le thread de l'application. La destruction n'est pas mesure.
+    for (int i = 0; i < count; i++) {
+        ANativeActivity* restored = host_activity_create("/tmp");
+        __atomic_store_n(&bench_app.restoreActivity, restored, __ATOMIC_RELEASE);
+        __atomic_store_n(&bench_app.restoredAt, (int64_t)0, __ATOMIC_RELEASE);
+        int64_t start = host_now_ns();
+        ANativeActivity_onCreate(restored, savedState, savedStateSize);
+        while (__atomic_load_n(&bench_app.restoredAt, __ATOMIC_ACQUIRE) == 0) {
+            sched_yield();
+        }
+        bench_app.sendTimes[i] = bench_app.restoredAt - start;
+        restored->callbacks->onDestroy(restored);
+        __atomic_store_n(&bench_app.restoreActivity, (ANativeActivity*)NULL, __ATOMIC_RELEASE);
+        host_activity_destroy(restored);
+    }
+    free(savedState);
+    __atomic_store_n(&bench_app.snapshotMode, BENCH_SNAPSHOT_OFF, __ATOMIC_RELEASE);
+
+    char benchmark[32];
+    snprintf(benchmark, sizeof(benchmark), "snapshot/%s_%zuk", name, size >> 10);
+    int mismatches = __atomic_load_n(&bench_app.restoreMismatches, __ATOMIC_RELAXED);
+    printf("%s: state_bytes=%zu saved_bytes=%zu pool_hits=%llu pool_reserved=%llu mismatches=%d/%d\n",
+            benchmark, size, savedStateSize,
+            (unsigned long long)(poolAfter.hits - poolBefore.hits),
+            (unsigned long long)(poolAfter.reserved - poolBefore.reserved), mismatches, count);
+    char restore[40];
+    snprintf(restore, sizeof(restore), "%s/restore", benchmark);
+    snprintf(benchmark + strlen(benchmark), sizeof(benchmark) - strlen(benchmark), "/save");
+    bench_latency_report(benchmark, bench_app.latencies, count);
+    bench_latency_report(restore, bench_app.sendTimes, count);
+    return mismatches;
+}
+
+static int bench_snapshot(ANativeActivity* activity, int iterations) {
+    static const size_t sizes[] = { 4 << 10, 1 << 20, 16 << 20 };
+    // Seuil fixe, comme l'allocateur de l'appareil : les grands blocs sont rendus
+    // au systme  chaque free(), au lieu de rester dans le tas de la glibc.
+    mallopt(M_MMAP_THRESHOLD, 128 << 10);
+    bench_app.snapshotData = (uint8_t*)malloc(16 << 20);
+    for (size_t i = 0; i < (16 << 20); i++) {
+        bench_app.snapshotData[i] = (uint8_t)(i * 131);
+    }
+    int mismatches = 0;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        mismatches += bench_snapshot_run(activity, "legacy", BENCH_SNAPSHOT_LEGACY, sizes[i], iterations);
+        mismatches += bench_snapshot_run(activity, "pooled", BENCH_SNAPSHOT_POOLED, sizes[i], iterations);
+    }
+    free(bench_app.restoreCopy);
+    bench_app.restoreCopy = NULL;
+    free(bench_app.snapshotData);
+    bench_app.snapshotData = NULL;
+    if (mismatches != 0) {
+        fprintf(stderr, "snapshot: %d restored states differ from the saved ones\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
+
+// --------------------------------------------------------------------
+// Journal d'tat
+// --------------------------------------------------------------------
+
+static void bench_journal_remove(const char* directory) {
+    static const char* const names[] = { "state.ckpt", "state.ckpt.tmp", "state.jrnl0", "state.jrnl1" };
+    char path[PATH_MAX];
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        snprintf(path, sizeof(path), "%s/%s", directory, names[i]);
+        unlink(path);
+    }
+    rmdir(directory);
+}
+
+// Remplace dans les journaux de directory la valeur from par to, comme une
+// criture interrompue au milieu d'un enregistrement. Retourne le nombre de remplacements.
+static int bench_journal_tear(const char* directory, float from, float to) {
+    int torn = 0;
+    char path[PATH_MAX];
+    for (int index = 0; index < 2; index++) {
+        snprintf(path, sizeof(path), "%s/state.jrnl%d", directory, index);
+        int fd = open(path, O_RDWR | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        float value;
+        for (off_t offset = 0; pread(fd, &value, sizeof(value), offset) == sizeof(value);
+                offset += sizeof(value)) {
+            if (memcmp(&value, &from, sizeof(value)) == 0) {
+                pwrite(fd, &to, sizeof(to), offset);
+                torn++;
+            }
+        }
+        close(fd);
+    }
+    return torn;
+}
+
+static int bench_journal(int iterations) {
+    char root[] = "/tmp/host_bench.XXXXXX";
+    if (mkdtemp(root) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+    char directory[64];
+    snprintf(directory, sizeof(directory), "%s/state", root);
+
+    // Ajouts : rafales de 32 champs par milliseconde, bien plus qu'une image n'en
+    // modifie, compactages en arrire-plan compris.
+    struct state_journal* journal = state_journal_open(directory, BENCH_JOURNAL_SCHEMA);
+    if (journal == NULL) {
+        fprintf(stderr, "journal: unable to open %s\n", directory);
+        rmdir(root);
+        return 1;
+    }
+    state_journal_release_view(journal);
+    int appends = iterations < BENCH_MAX_SAMPLES ? iterations : BENCH_MAX_SAMPLES;
+    float angle = 0;
+    int64_t total = 0;
+    for (int i = 0; i < appends; i++) {
+        angle += 1;
+        int64_t start = host_now_ns();
+        state_journal_append(journal, BENCH_JOURNAL_ANGLE, STATE_FIELD_F32, &angle, 1);
+        int64_t elapsed = host_now_ns() - start;
+        bench_app.latencies[i] = elapsed;
+        total += elapsed;
+        if (i % 32 == 31) {
+            usleep(1000);
+        }
+    }
+    struct state_journal_stats stats;
+    state_journal_wait(journal);
+    state_journal_get_stats(journal, &stats);
+    printf("journal/append: appends=%llu dropped=%llu compactions=%llu mean=%.0f ns\n",
+            (unsigned long long)stats.appends, (unsigned long long)stats.dropped,
+            (unsigned long long)stats.compactions, total / (double)appends);
+    bench_result("journal/append", "mean", "ns", total / (double)appends);
+    bench_result("journal/append", "dropped", "count", (double)stats.dropped);
+    bench_latency_report("journal/append", bench_app.latencies, appends);
+
+    // Point de contrle avec un grand champ, crit par le thread de fond.
+    uint8_t* blob = (uint8_t*)malloc(BENCH_JOURNAL_BLOB_BYTES);
+    for (int i = 0; i < BENCH_JOURNAL_BLOB_BYTES; i++) {
+        blob[i] = (uint8_t)(i * 131);
+    }
+    state_journal_append(journal, BENCH_JOURNAL_BLOB, STATE_FIELD_BYTES, blob,
+            BENCH_JOURNAL_BLOB_BYTES);
+    int64_t start = host_now_ns();
+    state_journal_compact(journal);
+    int64_t requested = host_now_ns() - start;
+    state_journal_wait(journal);
+    state_journal_get_stats(journal, &stats);
+    state_journal_close(journal);
+    printf("journal/compact: checkpoint_bytes=%llu request=%.1f us background=%.1f us\n",
+            (unsigned long long)stats.checkpointBytes, requested / 1000.0,
+            stats.lastCompactionNs / 1000.0);
+    bench_result("journal/compact", "request", "us", requested / 1000.0);
+    bench_result("journal/compact", "background", "us", stats.lastCompactionNs / 1000.0);
+
+    // Ouverture  froid : du fichier jusqu'aux champs disponibles, sans lecture des donnes.
+    int opens = iterations < BENCH_JOURNAL_OPENS ? iterations : BENCH_JOURNAL_OPENS;
+    int valid = 0;
+    for (int i = 0; i < opens; i++) {
+        start = host_now_ns();
+        journal = state_journal_open(directory, BENCH_JOURNAL_SCHEMA);
+        size_t count = 0;
+        const float* restored = (const float*)state_journal_get(journal, BENCH_JOURNAL_ANGLE,
+                STATE_FIELD_F32, NULL);
+        const uint8_t* restoredBlob = (const uint8_t*)state_journal_get(journal,
+                BENCH_JOURNAL_BLOB, STATE_FIELD_BYTES, &count);
+        bench_app.latencies[i] = host_now_ns() - start;
+        valid += restored != NULL && restored[0] == angle && count == BENCH_JOURNAL_BLOB_BYTES
+                && memcmp(restoredBlob, blob, count) == 0;
+        state_journal_close(journal);
+    }
+    printf("journal/open: valid=%d/%d\n", valid, opens);
+    bench_result("journal/open", "valid", "count", valid);
+    bench_latency_report("journal/open", bench_app.latencies, opens);
+    free(blob);
+
+    // criture interrompue : le dernier enregistrement est cart  l'ouverture.
+    journal = state_journal_open(directory, BENCH_JOURNAL_SCHEMA);
+    state_journal_release_view(journal);
+    const float before = 0.25f;
+    const float last = 0.75f;
+    state_journal_append(journal, BENCH_JOURNAL_ANGLE, STATE_FIELD_F32, &before, 1);
+    state_journal_append(journal, BENCH_JOURNAL_ANGLE, STATE_FIELD_F32, &last, 1);
+    state_journal_close(journal);
+    int replaced = bench_journal_tear(directory, last, 0.5f);
+    journal = state_journal_open(directory, BENCH_JOURNAL_SCHEMA);
+    const float* restored = (const float*)state_journal_get(journal, BENCH_JOURNAL_ANGLE,
+            STATE_FIELD_F32, NULL);
+    float value = restored != NULL ? restored[0] : -1;
+    state_journal_release_view(journal);
+    state_journal_wait(journal);
+    state_journal_get_stats(journal, &stats);
+    state_journal_close(journal);
+    printf("journal/torn: replaced=%d torn=%llu corrupt=%llu restored=%g (expected %g)\n",
+            replaced, (unsigned long long)stats.torn, (unsigned long long)stats.corrupt,
+            value, before);
+    bench_result("journal/torn", "torn", "count", (double)stats.torn);
+    bench_result("journal/torn", "recovered", "count", value == before);
+
+    bench_journal_remove(directory);
+    rmdir(root);
+
+    int failed = 0;
+    if (valid != opens) {
+        fprintf(stderr, "journal: %d of %d cold opens did not restore the saved fields\n", opens - valid, opens);
+        failed = 1;
+    }
+    if (replaced == 0 || stats.torn == 0 || value != before) {
+        fprintf(stderr, "journal: the torn record was not discarded (restored %g, expected %g)\n", value, before);
+        failed = 1;
+    }
+    return failed;
+}
+
+// --------------------------------------------------------------------
+// Ressources
+// --------------------------------------------------------------------
+
+struct bench_asset_run {
+    struct asset_stream* stream;
+    int completed;
+    int ok;
+    int cancelled;
+    int corrupt;
+
+    // Ressources rendues, libres  la fin de la mesure ; instants de demande
+    // et latences, par indice de fichier.
+    const struct asset_stream_asset* assets[BENCH_ASSET_MAX];
+    int64_t sendTimes[BENCH_ASSET_MAX];
+    int64_t latencies[BENCH_ASSET_MAX];
+};
+
+static struct bench_asset_run bench_asset_run;
+
+static uint8_t bench_asset_byte(int file, size_t offset) {
+    return (uint8_t)(file * 31 + offset * 7 + (offset >> 12));
+}
+
+// Le contenu est vrifi sur chaque page : les pages projetes sont toutes lues.
+static int bench_asset_valid(int file, const struct asset_stream_asset* asset, size_t size) {
+    if (asset->size != size) {
+        return 0;
+    }
+    const uint8_t* data = (const uint8_t*)asset->data;
+    for (size_t offset = 0; offset < size; offset += 4096) {
+        if (data[offset] != bench_asset_byte(file, offset)) {
+            return 0;
+        }
+    }
+    return size == 0 || data[size - 1] == bench_asset_byte(file, size - 1);
+}
+
+static void bench_asset_path(char* path, size_t capacity, int file, size_t size, int stored) {
+    snprintf(path, capacity, "%s%02d.%s", size == BENCH_ASSET_BYTES ? "large" : "small", file,
+            stored ? "ogg" : "dat");
+}
+
+static int bench_asset_write(const char* root, int file, size_t size, int stored) {
+    char name[32];
+    char path[96];
+    bench_asset_path(name, sizeof(name), file, size, stored);
+    snprintf(path, sizeof(path), "%s/%s", root, name);
+    uint8_t* data = (uint8_t*)malloc(size);
+    for (size_t offset = 0; offset < size; offset++) {
+        data[offset] = bench_asset_byte(file, offset);
+    }
+    FILE* out = fopen(path, "wb");
+    int written = out != NULL && fwrite(data, 1, size, out) == size;
+    if (out != NULL && fclose(out) != 0) {
+        written = 0;
+    }
+    free(data);
+    return written ? 0 : -1;
+}
+
+static void bench_asset_done(void* userData, int32_t id, int status,
+        const struct asset_stream_asset* asset) {
+    struct bench_asset_run* run = &bench_asset_run;
+    int file = (int)(intptr_t)userData;
+    run->latencies[file] = host_now_ns() - run->sendTimes[file];
+    run->completed++;
+    if (status == ASSET_STREAM_OK) {
+        run->ok++;
+        run->assets[file] = asset;
+    } else if (status == ASSET_STREAM_CANCELLED) {
+        run->cancelled++;
+    }
+}
+
+static void bench_asset_reset(struct asset_stream* stream) {
+    struct bench_asset_run* run = &bench_asset_run;
+    memset(run, 0, sizeof(*run));
+    run->stream = stream;
+}
+
+static void bench_asset_wait(int count) {
+    while (bench_asset_run.completed < count) {
+        ALooper_pollOnce(100, NULL, NULL, NULL);
+    }
+}
+
+static int32_t bench_asset_request(int file, size_t size, int stored, int priority) {
+    char path[32];
+    bench_asset_path(path, sizeof(path), file, size, stored);
+    bench_asset_run.sendTimes[file] = host_now_ns();
+    return asset_stream_request(bench_asset_run.stream, path, priority, bench_asset_done,
+            (void*)(intptr_t)file);
+}
+
+// Vrifie puis rend les ressources des fichiers first  first + count - 1.
+static void bench_asset_release(int first, int count, size_t size) {
+    struct bench_asset_run* run = &bench_asset_run;
+    for (int file = first; file < first + count; file++) {
+        if (run->assets[file] != NULL) {
+            run->corrupt += !bench_asset_valid(file, run->assets[file], size);
+            asset_stream_release(run->stream, run->assets[file]);
+            run->assets[file] = NULL;
+        }
+    }
+}
+
+/**
+ * Dbit : tous les grands fichiers demands d'un coup, jusqu'au dernier rappel,
+ * et temps CPU du thread du looper (demandes, rappels et vrification).
+ */
+static int bench_asset_load(AAssetManager* manager, ALooper* looper, int stored, int workers,
+        int rounds) {
+    char name[32];
+    snprintf(name, sizeof(name), "asset/%s_w%d", stored ? "mapped" : "copied", workers);
+    int64_t elapsed = 0;
+    int64_t cpu = 0;
+    int corrupt = 0;
+    for (int round = 0; round < rounds; round++) {
+        struct asset_stream* stream = asset_stream_create(manager, looper, workers, 64 << 20);
+        bench_asset_reset(stream);
+        int64_t start = host_now_ns();
+        int64_t cpuStart = bench_clock_ns(CLOCK_THREAD_CPUTIME_ID);
+        for (int file = 0; file < BENCH_ASSET_FILES; file++) {
+            bench_asset_request(file, BENCH_ASSET_BYTES, stored, ASSET_STREAM_PRIORITY_NORMAL);
+        }
+        bench_asset_wait(BENCH_ASSET_FILES);
+        bench_asset_release(0, BENCH_ASSET_FILES, BENCH_ASSET_BYTES);
+        elapsed += host_now_ns() - start;
+        cpu += bench_clock_ns(CLOCK_THREAD_CPUTIME_ID) - cpuStart;
+        corrupt += bench_asset_run.corrupt + BENCH_ASSET_FILES - bench_asset_run.ok;
+        asset_stream_destroy(stream);
+    }
+    double bytes = (double)BENCH_ASSET_FILES * BENCH_ASSET_BYTES * rounds;
+    printf("%s: files=%d size=%d KiB throughput=%.0f MiB/s looper_cpu=%.1f us/file corrupt=%d\n",
+            name, BENCH_ASSET_FILES, BENCH_ASSET_BYTES >> 10, bytes / (1 << 20) / (elapsed / 1e9),
+            cpu / 1e3 / (BENCH_ASSET_FILES * rounds), corrupt);
+    bench_result(name, "throughput", "MiB/s", bytes / (1 << 20) / (elapsed / 1e9));
+    bench_result(name, "looper_cpu_per_file", "us", cpu / 1e3 / (BENCH_ASSET_FILES * rounds));
+    return corrupt;
+}
+
+// Lecture synchrone des mmes fichiers par le thread du looper, comme sans chargeur.
+static void bench_asset_sync(AAssetManager* manager, int rounds) {
+    int64_t elapsed = 0;
+    uint8_t* buffer = (uint8_t*)malloc(BENCH_ASSET_BYTES);
+    for (int round = 0; round < rounds; round++) {
+        int64_t start = host_now_ns();
+        for (int file = 0; file < BENCH_ASSET_FILES; file++) {
+            char path[32];
+            bench_asset_path(path, sizeof(path), file, BENCH_ASSET_BYTES, 0);
+            AAsset* asset = AAssetManager_open(manager, path, AASSET_MODE_STREAMING);
+            if (asset != NULL) {
+                while (AAsset_read(asset, buffer, BENCH_ASSET_BYTES) > 0) {
+                }
+                AAsset_close(asset);
+            }
+        }
+        elapsed += host_now_ns() - start;
+    }
+    printf("asset/sync: files=%d blocked=%.1f us/file\n", BENCH_ASSET_FILES,
+            elapsed / 1e3 / (BENCH_ASSET_FILES * rounds));
+    bench_result("asset/sync", "blocked_per_file", "us", elapsed / 1e3 / (BENCH_ASSET_FILES * rounds));
+    free(buffer);
+}
+
+/**
+ * Priorits : un seul thread de chargement, tous les grands fichiers compresss
+ * en priorit basse, puis les petits en priorit haute, qui doivent passer devant.
+ */
+static void bench_asset_priority(AAssetManager* manager, ALooper* looper) {
+    struct asset_stream* stream = asset_stream_create(manager, looper, 1, 64 << 20);
+    bench_asset_reset(stream);
+    for (int file = 0; file < BENCH_ASSET_FILES; file++) {
+        bench_asset_request(file, BENCH_ASSET_BYTES, 0, ASSET_STREAM_PRIORITY_LOW);
+    }
+    for (int i = 0; i < BENCH_ASSET_SMALL; i++) {
+        bench_asset_request(BENCH_ASSET_FILES + i, BENCH_ASSET_SMALL_BYTES, 1,
+                ASSET_STREAM_PRIORITY_HIGH);
+    }
+    bench_asset_wait(BENCH_ASSET_FILES + BENCH_ASSET_SMALL);
+    int64_t lowSum = 0;
+    for (int file = 0; file < BENCH_ASSET_FILES; file++) {
+        lowSum += bench_asset_run.latencies[file];
+    }
+    printf("asset/priority: low latency_us mean=%.2f\n", lowSum / 1e3 / BENCH_ASSET_FILES);
+    bench_result("asset/priority", "low_latency_mean", "us", lowSum / 1e3 / BENCH_ASSET_FILES);
+    bench_latency_report("asset/priority", bench_asset_run.latencies + BENCH_ASSET_FILES,
+            BENCH_ASSET_SMALL);
+    bench_asset_release(0, BENCH_ASSET_FILES, BENCH_ASSET_BYTES);
+    asset_stream_destroy(stream);
+}
+
+/**
+ * Cache : budget de BENCH_ASSET_BUDGET octets, grands fichiers projets demands
+ * un par un puis rendus. Les derniers sont encore prsents, les premiers ont t
+ * librs. Retourne -1 si le budget est dpass.
+ */
+static int bench_asset_cache(AAssetManager* manager, ALooper* looper) {
+    struct asset_stream* stream = asset_stream_create(manager, looper, 1, BENCH_ASSET_BUDGET);
+    bench_asset_reset(stream);
+    for (int file = 0; file < BENCH_ASSET_FILES; file++) {
+        bench_asset_request(file, BENCH_ASSET_BYTES, 1, ASSET_STREAM_PRIORITY_NORMAL);
+        bench_asset_wait(file + 1);
+        bench_asset_release(file, 1, BENCH_ASSET_BYTES);
+    }
+    struct asset_stream_stats stats;
+    asset_stream_get_stats(stream, &stats);
+    int overBudget = stats.residentBytes > BENCH_ASSET_BUDGET;
+
+    // Demandes des fichiers rests dans le cache : rendues au passage suivant du looper.
+    const int resident = BENCH_ASSET_BUDGET / BENCH_ASSET_BYTES;
+    int first = BENCH_ASSET_FILES - resident;
+    bench_asset_reset(stream);
+    for (int file = first; file < BENCH_ASSET_FILES; file++) {
+        bench_asset_request(file, BENCH_ASSET_BYTES, 1, ASSET_STREAM_PRIORITY_NORMAL);
+        bench_asset_wait(file - first + 1);
+    }
+    int64_t hitSum = 0;
+    for (int file = first; file < BENCH_ASSET_FILES; file++) {
+        hitSum += bench_asset_run.latencies[file];
+    }
+    bench_asset_release(first, resident, BENCH_ASSET_BYTES);
+    struct asset_stream_stats after;
+    asset_stream_get_stats(stream, &after);
+    printf("asset/cache: budget=%d KiB resident=%llu KiB peak=%llu KiB evictions=%llu "
+            "hits=%llu/%d hit_latency=%.2f us\n", BENCH_ASSET_BUDGET >> 10,
+            (unsigned long long)stats.residentBytes >> 10,
+            (unsigned long long)stats.peakResidentBytes >> 10,
+            (unsigned long long)stats.evictions, (unsigned long long)(after.hits - stats.hits),
+            resident, hitSum / 1e3 / resident);
+    bench_result("asset/cache", "evictions", "count", (double)stats.evictions);
+    bench_result("asset/cache", "hits", "count", (double)(after.hits - stats.hits));
+    bench_result("asset/cache", "hit_latency", "us", hitSum / 1e3 / resident);
+    asset_stream_destroy(stream);
+    return overBudget || after.hits - stats.hits != (uint64_t)resident ? -1 : 0;
+}
+
+/**
+ * Annulation : grands fichiers compresss demands puis aussitt annuls. Chaque
+ * annulation accepte doit donner un rappel ASSET_STREAM_CANCELLED. Retourne -1
+ * sinon.
+ */
+static int bench_asset_cancel(AAssetManager* manager, ALooper* looper) {
+    struct asset_stream* stream = asset_stream_create(manager, looper, 1, 64 << 20);
+    bench_asset_reset(stream);
+    int32_t ids[BENCH_ASSET_FILES];
+    for (int file = 0; file < BENCH_ASSET_FILES; file++) {
+        ids[file] = bench_asset_request(file, BENCH_ASSET_BYTES, 0, ASSET_STREAM_PRIORITY_LOW);
+    }
+    int accepted = 0;
+    for (int file = 0; file < BENCH_ASSET_FILES; file++) {
+        accepted += asset_stream_cancel(stream, ids[file]) == 0;
+    }
+    bench_asset_wait(BENCH_ASSET_FILES);
+    bench_asset_release(0, BENCH_ASSET_FILES, BENCH_ASSET_BYTES);
+    struct asset_stream_stats stats;
+    asset_stream_get_stats(stream, &stats);
+    printf("asset/cancel: requests=%d accepted=%d cancelled=%d loaded=%llu\n", BENCH_ASSET_FILES,
+            accepted, bench_asset_run.cancelled,
+            (unsigned long long)(stats.mapped + stats.copied));
+    bench_result("asset/cancel", "cancelled", "count", bench_asset_run.cancelled);
+    bench_result("asset/cancel", "loaded", "count", (double)(stats.mapped + stats.copied));
+    asset_stream_destroy(stream);
+    return accepted == bench_asset_run.cancelled ? 0 : -1;
+}
+
+static int bench_asset(ANativeActivity* activity, int iterations) {
+    char root[] = "/tmp/host_bench.XXXXXX";
+    if (mkdtemp(root) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+    int failed = 0;
+    for (int file = 0; file < BENCH_ASSET_FILES; file++) {
+        failed |= bench_asset_write(root, file, BENCH_ASSET_BYTES, 1);
+        failed |= bench_asset_write(root, file, BENCH_ASSET_BYTES, 0);
+    }
+    for (int i = 0; i < BENCH_ASSET_SMALL; i++) {
+        failed |= bench_asset_write(root, BENCH_ASSET_FILES + i, BENCH_ASSET_SMALL_BYTES, 1);
+    }
+    int result = 0;
+    if (failed) {
+        fprintf(stderr, "asset: unable to write the files in %s\n", root);
+        result = 1;
+    } else {
+        host_asset_set_root(root);
+        AAssetManager* manager = activity->assetManager;
+        ALooper* looper = ALooper_prepare(ALOOPER_PREPARE_ALLOW_NON_CALLBACKS);
+        int rounds = iterations < BENCH_ASSET_ROUNDS ? iterations : BENCH_ASSET_ROUNDS;
+        if (rounds < 1) rounds = 1;
+        int corrupt = 0;
+        for (int workers = 1; workers <= 2; workers++) {
+            corrupt += bench_asset_load(manager, looper, 1, workers, rounds);
+            corrupt += bench_asset_load(manager, looper, 0, workers, rounds);
+        }
+        bench_asset_sync(manager, rounds);
+        bench_asset_priority(manager, looper);
+        if (corrupt != 0 || bench_asset_run.corrupt != 0) {
+            fprintf(stderr, "asset: corrupt or missing assets\n");
+            result = 1;
+        }
+        if (bench_asset_cache(manager, looper) != 0) {
+            fprintf(stderr, "asset: cache budget or hits not respected\n");
+            result = 1;
+        }
+        if (bench_asset_cancel(manager, looper) != 0) {
+            fprintf(stderr, "asset: cancelled requests without their callback\n");
+            result = 1;
+        }
+        host_asset_set_root(".");
+    }
+
+    char command[64];
+    snprintf(command, sizeof(command), "rm -rf %s", root);
+    if (system(command) != 0) {
+        fprintf(stderr, "asset: unable to remove %s\n", root);
+    }
+    return result;
+}
+
+// --------------------------------------------------------------------
+// Moteur
+// --------------------------------------------------------------------
+
+static int bench_saved_stdout = -1;
+
+// Les bilans de phases crits par le moteur  chaque pause sont carts.
+static void bench_engine_quiet(int quiet) {
+    fflush(stdout);
+    if (quiet && bench_saved_stdout < 0) {
+        bench_saved_stdout = dup(STDOUT_FILENO);
+        int fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            close(fd);
+        }
+    } else if (!quiet && bench_saved_stdout >= 0) {
+        dup2(bench_saved_stdout, STDOUT_FILENO);
+        close(bench_saved_stdout);
+        bench_saved_stdout = -1;
+    }
+}
+
+static ANativeActivity* bench_engine_create(void* savedState, size_t savedStateSize) {
+    ANativeActivity* activity = host_activity_create("/tmp");
+    __atomic_store_n(&bench_app.engineActivity, activity, __ATOMIC_RELEASE);
+    ANativeActivity_onCreate(activity, savedState, savedStateSize);
+    return activity;
+}
+
+static void bench_engine_destroy(ANativeActivity* activity) {
+    activity->callbacks->onDestroy(activity);
+    __atomic_store_n(&bench_app.engineActivity, (ANativeActivity*)NULL, __ATOMIC_RELEASE);
+    host_activity_destroy(activity);
+}
+
+
+static void bench_save(int iterations) {
+    int saves = iterations < BENCH_SAVE_MAX ? iterations : BENCH_SAVE_MAX;
+    int restores = iterations < BENCH_RESTORE_MAX ? iterations : BENCH_RESTORE_MAX;
+    if (saves < 1) saves = 1;
+    if (restores < 1) restores = 1;
+
+    bench_engine_quiet(1);
+    ANativeActivity* activity = bench_engine_create(NULL, 0);
+    activity->callbacks->onStart(activity);
+    activity->callbacks->onResume(activity);
+    activity->callbacks->onPause(activity);
+
+    // Enregistrement : APP_CMD_SAVE_STATE jusqu' la remise de l'tat au systme.
+    void* savedState = NULL;
+    size_t savedStateSize = 0;
+    for (int i = 0; i < saves; i++) {
+        free(savedState);
+        savedState = NULL;
+        int64_t start = host_now_ns();
+        savedState = activity->callbacks->onSaveInstanceState(activity, &savedStateSize);
+        bench_app.latencies[i] = host_now_ns() - start;
+    }
+    activity->callbacks->onStop(activity);
+    bench_engine_destroy(activity);
+
+    // Restauration : cration de l'activit avec l'tat, jusqu'au dmarrage
+    // du thread de l'application. La destruction n'est pas mesure.
+    for (int i = 0; i < restores; i++) {
+        int64_t start = host_now_ns();
+        activity = bench_engine_create(savedState, savedStateSize);
+        bench_app.sendTimes[i] = host_now_ns() - start;
+        bench_engine_destroy(activity);
+    }
+    bench_engine_quiet(0);
+
+    printf("save: state_bytes=%zu\n", savedStateSize);
+    bench_result("save", "state_bytes", "bytes", (double)savedStateSize);
+    bench_latency_report("save", bench_app.latencies, saves);
+    bench_latency_report("restore", bench_app.sendTimes, restores);
+    free(savedState);
+}
+
+enum {
+    BENCH_STEP_CREATE,
+    BENCH_STEP_START,
+    BENCH_STEP_RESUME,
+    BENCH_STEP_WINDOW,
+    BENCH_STEP_FOCUS,
+    BENCH_STEP_UNFOCUS,
+    BENCH_STEP_PAUSE,
+    BENCH_STEP_WINDOW_DESTROY,
+    BENCH_STEP_SAVE,
+    BENCH_STEP_STOP,
+    BENCH_STEP_DESTROY,
+
+    BENCH_STEP_COUNT
+};
+
+static const char* const bench_step_names[BENCH_STEP_COUNT] = {
+    "create", "start", "resume", "window", "focus", "unfocus", "pause", "window_destroy",
+    "save", "stop", "destroy",
+};
+
+static void bench_lifecycle(int iterations) {
+    int cycles = iterations < BENCH_LIFECYCLE_MAX ? iterations : BENCH_LIFECYCLE_MAX;
+    if (cycles < 1) cycles = 1;
+
+    int64_t stepNs[BENCH_STEP_COUNT];
+    memset(stepNs, 0, sizeof(stepNs));
+    void* savedState = NULL;
+    size_t savedStateSize = 0;
+
+    bench_engine_quiet(1);
+    struct host_counters before;
+    struct host_counters after;
+    host_counters_get(&before);
+    for (int i = 0; i < cycles; i++) {
+        ANativeActivity* activity = NULL;
+        ANativeWindow* window = NULL;
+        int64_t cycleStart = host_now_ns();
+        int64_t t = cycleStart;
+        for (int step = 0; step < BENCH_STEP_COUNT; step++) {
+            switch (step) {
+                case BENCH_STEP_CREATE:
+                    activity = bench_engine_create(savedState, savedStateSize);
+                    free(savedState);
+                    savedState = NULL;
+                    break;
+                case BENCH_STEP_START:
+                    activity->callbacks->onStart(activity);
+                    break;
+                case BENCH_STEP_RESUME:
+                    activity->callbacks->onResume(activity);
+                    break;
+                case BENCH_STEP_WINDOW:
+                    window = host_window_create(720, 1280, WINDOW_FORMAT_RGBA_8888);
+                    activity->callbacks->onNativeWindowCreated(activity, window);
+                    break;
+                case BENCH_STEP_FOCUS:
+                case BENCH_STEP_UNFOCUS:
+                    activity->callbacks->onWindowFocusChanged(activity, step == BENCH_STEP_FOCUS);
+                    break;
+                case BENCH_STEP_PAUSE:
+                    activity->callbacks->onPause(activity);
+                    break;
+                case BENCH_STEP_WINDOW_DESTROY:
+                    activity->callbacks->onNativeWindowDestroyed(activity, window);
+                    ANativeWindow_release(window);
+                    break;
+                case BENCH_STEP_SAVE:
+                    savedState = activity->callbacks->onSaveInstanceState(activity, &savedStateSize);
+                    break;
+                case BENCH_STEP_STOP:
+                    activity->callbacks->onStop(activity);
+                    break;
+                case BENCH_STEP_DESTROY:
+                    bench_engine_destroy(activity);
+                    break;
+            }
+            int64_t now = host_now_ns();
+            stepNs[step] += now - t;
+            t = now;
+        }
+        bench_app.latencies[i] = t - cycleStart;
+    }
+    host_counters_get(&after);
+    bench_engine_quiet(0);
+    free(savedState);
+
+    printf("lifecycle: cycles=%d swaps/cycle=%.2f syscalls/cycle=%.1f\n", cycles,
+            (after.swaps - before.swaps) / (double)cycles,
+            (after.reads - before.reads + after.writes - before.writes) / (double)cycles);
+    printf("lifecycle: step_us");
+    for (int step = 0; step < BENCH_STEP_COUNT; step++) {
+        printf(" %s=%.2f", bench_step_names[step], stepNs[step] / 1e3 / cycles);
+        char metric[32];
+        snprintf(metric, sizeof(metric), "%s_mean", bench_step_names[step]);
+        bench_result("lifecycle", metric, "us", stepNs[step] / 1e3 / cycles);
+    }
+    printf("\n");
+    bench_latency_report("lifecycle", bench_app.latencies, cycles);
+}
+
+static void bench_frame(int iterations) {
+    int frames = iterations < BENCH_FRAME_MAX ? iterations : BENCH_FRAME_MAX;
+    if (frames < 1) frames = 1;
+
+    bench_engine_quiet(1);
+    ANativeActivity* activity = bench_engine_create(NULL, 0);
+    activity->callbacks->onStart(activity);
+    activity->callbacks->onResume(activity);
+    ANativeWindow* window = host_window_create(720, 1280, WINDOW_FORMAT_RGBA_8888);
+    activity->callbacks->onNativeWindowCreated(activity, window);
+    activity->callbacks->onWindowFocusChanged(activity, 1);
+
+    // Mise en rgime, puis mesure sur un nombre d'images fix.
+    usleep(200000);
+    struct host_counters before;
+    struct host_counters after;
+    host_counters_get(&before);
+    int64_t processStart = bench_clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+    int64_t appStart = bench_clock_ns(bench_app.engineCpuClock);
+    int64_t start = host_now_ns();
+    int frame = 0;
+    do {
+        host_sensor_push(ASENSOR_TYPE_ACCELEROMETER, (float)(frame++ % 60) * 0.1f, 9.81f, 0.0f);
+        usleep(BENCH_FRAME_NS / 1000);
+        host_counters_get(&after);
+    } while (after.swaps - before.swaps < (uint64_t)frames);
+    int64_t elapsed = host_now_ns() - start;
+    int64_t processCpu = bench_clock_ns(CLOCK_PROCESS_CPUTIME_ID) - processStart;
+    int64_t appCpu = bench_clock_ns(bench_app.engineCpuClock) - appStart;
+    uint64_t swaps = after.swaps - before.swaps;
+    uint64_t wakeups = after.looperWakeups - before.looperWakeups;
+
+    activity->callbacks->onWindowFocusChanged(activity, 0);
+    activity->callbacks->onPause(activity);
+    activity->callbacks->onNativeWindowDestroyed(activity, window);
+    ANativeWindow_release(window);
+    activity->callbacks->onStop(activity);
+    bench_engine_destroy(activity);
+    bench_engine_quiet(0);
+
+    printf("frame: frames=%llu elapsed=%.3f s fps=%.1f wakeups/frame=%.2f\n",
+            (unsigned long long)swaps, elapsed / 1e9, swaps / (elapsed / 1e9),
+            wakeups / (double)swaps);
+    printf("frame: process_cpu_us/frame=%.2f app_cpu_us/frame=%.2f\n",
+            processCpu / 1e3 / swaps, appCpu / 1e3 / swaps);
+    bench_result("frame", "fps", "count", swaps / (elapsed / 1e9));
+    bench_result("frame", "wakeups_per_frame", "count", wakeups / (double)swaps);
+    bench_result("frame", "process_cpu_per_frame", "us", processCpu / 1e3 / swaps);
+    bench_result("frame", "app_cpu_per_frame", "us", appCpu / 1e3 / swaps);
+}
+
+// Toucher lu juste aprs une image : l'tage diffr dtache la file du looper
+// jusqu' l'image suivante. Retourne 1 si l'vnement est termin, la file
+// encore dtache.
+static int bench_alloc_defer_input(AInputQueue* queue) {
+    struct host_counters counters;
+    host_counters_get(&counters);
+    uint64_t swaps = counters.swaps;
+    uint64_t finished = counters.inputFinished;
+    int64_t deadline = host_now_ns() + 2000000000LL;
+    while (counters.swaps == swaps && host_now_ns() < deadline) {
+        sched_yield();
+        host_counters_get(&counters);
+    }
+    float xy[2] = { 50.0f, 60.0f };
+    host_input_push_motion(queue, AMOTION_EVENT_ACTION_MOVE, 1, xy, 0);
+    while (counters.inputFinished == finished && host_now_ns() < deadline) {
+        sched_yield();
+        host_counters_get(&counters);
+    }
+    return counters.inputFinished > finished && counters.swaps == swaps + 1;
+}
+
+static int bench_alloc(int iterations) {
+    int frames = iterations < BENCH_FRAME_MAX ? iterations : BENCH_FRAME_MAX;
+    if (frames < 1) frames = 1;
+
+    bench_engine_quiet(1);
+    ANativeActivity* activity = bench_engine_create(NULL, 0);
+    AInputQueue* queue = host_input_queue_create();
+    activity->callbacks->onInputQueueCreated(activity, queue);
+    activity->callbacks->onStart(activity);
+    activity->callbacks->onResume(activity);
+    ANativeWindow* window = host_window_create(720, 1280, WINDOW_FORMAT_RGBA_8888);
+    activity->callbacks->onNativeWindowCreated(activity, window);
+    activity->callbacks->onWindowFocusChanged(activity, 1);
+
+    // Mise en rgime avec les mmes entres que pendant la mesure : les arnes
+    // ont pris leur taille et les tampons de chaque thread existent.
+    int warmup = 30;
+    struct host_counters before;
+    struct host_counters after;
+    uint64_t injectorBefore = 0;
+    host_counters_get(&before);
+    for (int frame = 0; frame < warmup + frames; frame++) {
+        if (frame == warmup) {
+            usleep(BENCH_FRAME_NS / 1000);
+            host_counters_get(&before);
+            injectorBefore = host_thread_allocations();
+        }
+        float xy[2] = { 100.0f + frame % 500, 200.0f + frame % 700 };
+        host_input_push_motion(queue, frame == 0 ? AMOTION_EVENT_ACTION_DOWN : AMOTION_EVENT_ACTION_MOVE,
+                1, xy, BENCH_INPUT_HISTORY);
+        host_sensor_push(ASENSOR_TYPE_ACCELEROMETER, 0.1f * (frame % 10), 9.81f, 0.0f);
+        usleep(BENCH_FRAME_NS / 1000);
+    }
+    // Dernire image, puis relev avant tout changement d'tat.
+    usleep(BENCH_FRAME_NS / 1000);
+    host_counters_get(&after);
+    uint64_t injector = host_thread_allocations() - injectorBefore;
+    uint64_t swaps = after.swaps - before.swaps;
+
+    // File remplace pendant que l'tage diffr la tient dtache : le runtime
+    // hte s'arrte si le code de collage la dtache une seconde fois.
+    int deferred = bench_alloc_defer_input(queue);
+    activity->callbacks->onInputQueueDestroyed(activity, queue);
+    host_input_queue_destroy(queue);
+    queue = host_input_queue_create();
+    activity->callbacks->onInputQueueCreated(activity, queue);
+
+    activity->callbacks->onWindowFocusChanged(activity, 0);
+    activity->callbacks->onPause(activity);
+    activity->callbacks->onNativeWindowDestroyed(activity, window);
+    ANativeWindow_release(window);
+    activity->callbacks->onStop(activity);
+    activity->callbacks->onInputQueueDestroyed(activity, queue);
+    host_input_queue_destroy(queue);
+    bench_engine_destroy(activity);
+    bench_engine_quiet(0);
+
+    uint64_t total = after.allocations - before.allocations;
+    uint64_t engine = total - injector;
+    printf("alloc: frames=%llu events=%llu allocations=%llu injector=%llu engine=%llu "
+            "engine/frame=%.3f queue_replaced_detached=%d\n",
+            (unsigned long long)swaps, (unsigned long long)(after.inputFinished - before.inputFinished),
+            (unsigned long long)total, (unsigned long long)injector, (unsigned long long)engine,
+            swaps > 0 ? engine / (double)swaps : 0.0, deferred);
+    bench_result("alloc", "engine_allocations", "count", (double)engine);
+    bench_result("alloc", "engine_allocations_per_frame", "count",
+            swaps > 0 ? engine / (double)swaps : 0.0);
+    if (engine != 0) {
+        fprintf(stderr, "alloc: %llu heap allocations in steady-state frames\n",
+                (unsigned long long)engine);
+        return 1;
+    }
+    return 0;
+}
+
+// --------------------------------------------------------------------
+// Rendu logiciel
+// --------------------------------------------------------------------
+
+static uint32_t bench_raster_random(uint32_t* seed) {
+    uint32_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+static void bench_raster_fill_random(uint32_t* pixels, size_t count, uint32_t seed) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t value = bench_raster_random(&seed);
+        // Alphas extrmes frquents : les cas 0 et 255 sont traits  part par les noyaux.
+        switch (value & 7) {
+            case 0: value &= 0x00ffffffu; break;
+            case 1: value |= 0xff000000u; break;
+        }
+        pixels[i] = value;
+    }
+}
+
+// Scne alatoire : effacement ventuel, rectangles opaques et transparents et
+// copies d'images, dbordant souvent de la destination.
+static void bench_raster_scene(struct soft_raster* raster, const struct soft_raster_target* target,
+        const struct soft_raster_image* images, int imageCount, uint32_t seed) {
+    soft_raster_begin(raster, target);
+    if (seed & 1) {
+        soft_raster_clear(raster, bench_raster_random(&seed));
+    }
+    for (int i = 0; i < BENCH_RASTER_COMMANDS; i++) {
+        uint32_t kind = bench_raster_random(&seed) % 4;
+        int32_t x = (int32_t)(bench_raster_random(&seed) % (target->width + 80)) - 40;
+        int32_t y = (int32_t)(bench_raster_random(&seed) % (target->height + 80)) - 40;
+        int32_t w = (int32_t)(bench_raster_random(&seed) % 120);
+        int32_t h = (int32_t)(bench_raster_random(&seed) % 120);
+        uint32_t color = bench_raster_random(&seed);
+        switch (kind) {
+            case 0:
+                soft_raster_fill(raster, x, y, w, h, color);
+                break;
+            case 1:
+                soft_raster_blend(raster, x, y, w, h, color);
+                break;
+            default:
+                soft_raster_blit(raster, x, y, &images[i % imageCount], kind == 3);
+                break;
+        }
+    }
+    soft_raster_end(raster);
+}
+
+/**
+ * Comparaison au pixel prs de chaque jeu d'instructions et nombre de threads
+ * avec la rfrence scalaire sur un thread, remplissage des lignes compris.
+ * Retourne le nombre de scnes diffrentes.
+ */
+static int bench_raster_exact(void) {
+    // Taille impaire, lignes plus longues que la destination.
+    const int32_t width = 333;
+    const int32_t height = 211;
+    const int32_t stride = 352;
+    const int32_t imageWidth = 97;
+    const int32_t imageHeight = 61;
+    const int32_t imageStride = 101;
+    size_t size = (size_t)stride * height;
+    uint32_t* initial = (uint32_t*)malloc(size * sizeof(uint32_t));
+    uint32_t* expected = (uint32_t*)malloc(size * sizeof(uint32_t));
+    uint32_t* actual = (uint32_t*)malloc(size * sizeof(uint32_t));
+    uint32_t* imagePixels = (uint32_t*)malloc(2 * (size_t)imageStride * imageHeight * sizeof(uint32_t));
+    bench_raster_fill_random(initial, size, 0x9e3779b9u);
+    bench_raster_fill_random(imagePixels, 2 * (size_t)imageStride * imageHeight, 0x85ebca6bu);
+    struct soft_raster_image images[2] = {
+        { imagePixels, imageWidth, imageHeight, imageStride },
+        { imagePixels + (size_t)imageStride * imageHeight, imageWidth, imageHeight, imageStride },
+    };
+
+    struct soft_raster* reference = soft_raster_create(1);
+    soft_raster_set_isa(reference, SOFT_RASTER_ISA_SCALAR);
+    static const int threadCounts[] = { 1, SOFT_RASTER_MAX_THREADS };
+    int failures = 0;
+    for (int isa = 0; isa < SOFT_RASTER_ISA_COUNT; isa++) {
+        for (size_t t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); t++) {
+            struct soft_raster* raster = soft_raster_create(threadCounts[t]);
+            if (soft_raster_set_isa(raster, isa) != isa) {
+                soft_raster_destroy(raster);
+                break;
+            }
+            int mismatches = 0;
+            for (uint32_t scene = 1; scene <= BENCH_RASTER_SCENES; scene++) {
+                memcpy(expected, initial, size * sizeof(uint32_t));
+                memcpy(actual, initial, size * sizeof(uint32_t));
+                struct soft_raster_target target = { expected, width, height, stride };
+                bench_raster_scene(reference, &target, images, 2, scene * 0x27d4eb2du);
+                target.pixels = actual;
+                bench_raster_scene(raster, &target, images, 2, scene * 0x27d4eb2du);
+                if (memcmp(expected, actual, size * sizeof(uint32_t)) != 0) {
+                    mismatches++;
+                }
+            }
+            printf("raster: exact isa=%s threads=%d scenes=%d mismatches=%d\n",
+                    soft_raster_isa_name(isa), soft_raster_get_threads(raster),
+                    BENCH_RASTER_SCENES, mismatches);
+            failures += mismatches;
+            soft_raster_destroy(raster);
+        }
+    }
+    soft_raster_destroy(reference);
+    free(imagePixels);
+    free(actual);
+    free(expected);
+    free(initial);
+    return failures;
+}
+
+enum {
+    BENCH_RASTER_CLEAR,
+    BENCH_RASTER_FILL,
+    BENCH_RASTER_BLEND,
+    BENCH_RASTER_BLIT,
+    BENCH_RASTER_BLIT_BLEND,
+
+    BENCH_RASTER_OP_COUNT
+};
+
+static const char* const bench_raster_op_names[BENCH_RASTER_OP_COUNT] = {
+    "clear", "fill", "blend", "blit", "blit_blend",
+};
+
+/**
+ * Dbit en mgapixels par seconde d'images 1280x720 couvertes par une seule
+ * opration, pour chaque jeu d'instructions et nombre de threads.
+ */
+static void bench_raster_rate(int iterations) {
+    int frames = iterations < BENCH_RASTER_MAX_FRAMES ? iterations : BENCH_RASTER_MAX_FRAMES;
+    if (frames < 1) frames = 1;
+    size_t size = (size_t)BENCH_RASTER_WIDTH * BENCH_RASTER_HEIGHT;
+    uint32_t* pixels = (uint32_t*)calloc(size, sizeof(uint32_t));
+    // Image dcale d'une ligne de cache par rapport  la destination : deux
+    // tampons allous par mmap() auraient le mme dcalage dans leurs pages, et
+    // chaque lecture de l'image attendrait l'criture prcdente de la destination.
+    uint32_t* imageStorage = (uint32_t*)malloc((size + 16) * sizeof(uint32_t));
+    uint32_t* imagePixels = imageStorage + 16;
+    bench_raster_fill_random(imagePixels, size, 0xc2b2ae35u);
+    struct soft_raster_target target = { pixels, BENCH_RASTER_WIDTH, BENCH_RASTER_HEIGHT,
+        BENCH_RASTER_WIDTH };
+    struct soft_raster_image image = { imagePixels, BENCH_RASTER_WIDTH, BENCH_RASTER_HEIGHT,
+        BENCH_RASTER_WIDTH };
+
+    static const int threadCounts[] = { 1, SOFT_RASTER_MAX_THREADS };
+    for (int isa = 0; isa < SOFT_RASTER_ISA_COUNT; isa++) {
+        for (size_t t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); t++) {
+            struct soft_raster* raster = soft_raster_create(threadCounts[t]);
+            if (soft_raster_set_isa(raster, isa) != isa) {
+                soft_raster_destroy(raster);
+                break;
+            }
+            char benchmark[32];
+            snprintf(benchmark, sizeof(benchmark), "raster/%s_t%d", soft_raster_isa_name(isa),
+                    soft_raster_get_threads(raster));
+            printf("%s:", benchmark);
+            for (int op = 0; op < BENCH_RASTER_OP_COUNT; op++) {
+                int64_t start = host_now_ns();
+                for (int frame = 0; frame < frames; frame++) {
+                    uint32_t color = SOFT_RASTER_RGBA(frame, 255 - frame, 64, 255);
+                    soft_raster_begin(raster, &target);
+                    switch (op) {
+                        case BENCH_RASTER_CLEAR:
+                            soft_raster_clear(raster, color);
+                            break;
+                        case BENCH_RASTER_FILL:
+                            soft_raster_fill(raster, 0, 0, BENCH_RASTER_WIDTH, BENCH_RASTER_HEIGHT, color);
+                            break;
+                        case BENCH_RASTER_BLEND:
+                            soft_raster_blend(raster, 0, 0, BENCH_RASTER_WIDTH, BENCH_RASTER_HEIGHT,
+                                    (color & 0x00ffffffu) | 0x80000000u);
+                            break;
+                        case BENCH_RASTER_BLIT:
+                            soft_raster_blit(raster, 0, 0, &image, 0);
+                            break;
+                        case BENCH_RASTER_BLIT_BLEND:
+                            soft_raster_blit(raster, 0, 0, &image, 1);
+                            break;
+                    }
+                    soft_raster_end(raster);
+                }
+                double rate = (double)size * frames / ((host_now_ns() - start) / 1e3);
+                printf(" %s=%.0f", bench_raster_op_names[op], rate);
+                char metric[32];
+                snprintf(metric, sizeof(metric), "%s_rate", bench_raster_op_names[op]);
+                bench_result(benchmark, metric, "Mpix/s", rate);
+            }
+            printf(" Mpix/s\n");
+            soft_raster_destroy(raster);
+        }
+    }
+    free(imageStorage);
+    free(pixels);
+}
+
+/**
+ * Moteur sans EGL : il doit passer au rendu logiciel et prsenter des images
+ * d'une seule couleur opaque. Retourne 0 en cas de succs.
+ */
+static int bench_raster_fallback(void) {
+    const int32_t width = 720;
+    const int32_t height = 1280;
+    host_egl_set_available(0);
+    bench_engine_quiet(1);
+    ANativeActivity* activity = bench_engine_create(NULL, 0);
+    activity->callbacks->onStart(activity);
+    activity->callbacks->onResume(activity);
+    ANativeWindow* window = host_window_create(width, height, WINDOW_FORMAT_RGBA_8888);
+    activity->callbacks->onNativeWindowCreated(activity, window);
+    activity->callbacks->onWindowFocusChanged(activity, 1);
+
+    struct host_counters before;
+    struct host_counters after;
+    host_counters_get(&before);
+    int64_t deadline = host_now_ns() + 2000000000LL;
+    do {
+        usleep(BENCH_FRAME_NS / 1000);
+        host_counters_get(&after);
+    } while (after.posts - before.posts < 30 && host_now_ns() < deadline);
+
+    uint32_t* pixels = (uint32_t*)malloc((size_t)width * height * sizeof(uint32_t));
+    int32_t readWidth = 0;
+    int32_t readHeight = 0;
+    int64_t posts = host_window_read(window, pixels, (size_t)width * height, &readWidth, &readHeight);
+
+    activity->callbacks->onWindowFocusChanged(activity, 0);
+    activity->callbacks->onPause(activity);
+    activity->callbacks->onNativeWindowDestroyed(activity, window);
+    ANativeWindow_release(window);
+    activity->callbacks->onStop(activity);
+    bench_engine_destroy(activity);
+    bench_engine_quiet(0);
+    host_egl_set_available(1);
+
+    size_t uniform = 0;
+    if (posts > 0) {
+        while (uniform < (size_t)readWidth * readHeight && pixels[uniform] == pixels[0]) {
+            uniform++;
+        }
+    }
+    int ok = posts > 0 && readWidth == width && readHeight == height
+            && uniform == (size_t)width * height && (pixels[0] >> 24) == 255
+            && after.swaps == before.swaps;
+    printf("raster: fallback posts=%lld swaps=%llu size=%dx%d color=0x%08x uniform=%s\n",
+            (long long)posts, (unsigned long long)(after.swaps - before.swaps), readWidth,
+            readHeight, posts > 0 ? pixels[0] : 0, ok ? "yes" : "no");
+    free(pixels);
+    return ok ? 0 : 1;
+}
+
+/**
+ * Attente de la prsentation numro swaps (compteur global). Retourne 0, ou -1
+ * aprs deux secondes.
+ */
+static int bench_wait_swaps(uint64_t swaps) {
+    int64_t deadline = host_now_ns() + 2000000000LL;
+    struct host_counters counters;
+    do {
+        host_counters_get(&counters);
+        if (counters.swaps >= swaps) {
+            return 0;
+        }
+        sched_yield();
+    } while (host_now_ns() < deadline);
+    return -1;
+}
+
+static int bench_resume(int iterations) {
+    int cycles = iterations < BENCH_RESUME_MAX ? iterations : BENCH_RESUME_MAX;
+    if (cycles < 1) cycles = 1;
+
+    bench_engine_quiet(1);
+    ANativeActivity* activity = bench_engine_create(NULL, 0);
+    activity->callbacks->onStart(activity);
+    activity->callbacks->onResume(activity);
+
+    // Premire fentre : affichage, configuration, contexte et surface.
+    struct host_counters before;
+    host_counters_get(&before);
+    ANativeWindow* window = host_window_create(720, 1280, WINDOW_FORMAT_RGBA_8888);
+    int64_t start = host_now_ns();
+    activity->callbacks->onNativeWindowCreated(activity, window);
+    int failed = bench_wait_swaps(before.swaps + 1);
+    int64_t coldNs = host_now_ns() - start;
+
+    // Fentres suivantes : la surface seule.
+    struct host_counters cold;
+    host_counters_get(&cold);
+    for (int i = 0; i < cycles && failed == 0; i++) {
+        activity->callbacks->onNativeWindowDestroyed(activity, window);
+        ANativeWindow_release(window);
+        window = host_window_create(720, 1280, WINDOW_FORMAT_RGBA_8888);
+        struct host_counters counters;
+        host_counters_get(&counters);
+        start = host_now_ns();
+        activity->callbacks->onNativeWindowCreated(activity, window);
+        failed = bench_wait_swaps(counters.swaps + 1);
+        bench_app.latencies[i] = host_now_ns() - start;
+    }
+    struct host_counters resumed;
+    host_counters_get(&resumed);
+
+    // Redimensionnement : mme surface.
+    host_window_resize(window, 1280, 720);
+    activity->callbacks->onNativeWindowResized(activity, window);
+    failed |= bench_wait_swaps(resumed.swaps + 1);
+    struct host_counters resized;
+    host_counters_get(&resized);
+
+    // Perte de contexte : la prsentation du premier redimensionnement choue et
+    // recre le contexte, celle du second doit russir.
+    host_egl_lose_context();
+    host_window_resize(window, 720, 1280);
+    activity->callbacks->onNativeWindowResized(activity, window);
+    host_window_resize(window, 1280, 720);
+    activity->callbacks->onNativeWindowResized(activity, window);
+    failed |= bench_wait_swaps(resized.swaps + 1);
+    struct host_counters after;
+    host_counters_get(&after);
+
+    activity->callbacks->onPause(activity);
+    activity->callbacks->onNativeWindowDestroyed(activity, window);
+    ANativeWindow_release(window);
+    activity->callbacks->onStop(activity);
+    bench_engine_destroy(activity);
+    bench_engine_quiet(0);
+
+    uint64_t resumeInits = resumed.eglInits - cold.eglInits;
+    uint64_t resumeContexts = resumed.eglContexts - cold.eglContexts;
+    uint64_t resumeSurfaces = resumed.eglSurfaces - cold.eglSurfaces;
+    uint64_t resizeSurfaces = resized.eglSurfaces - resumed.eglSurfaces;
+    uint64_t lossContexts = after.eglContexts - resized.eglContexts;
+    printf("resume: cold_us=%.2f cycles=%d inits/resume=%.2f contexts/resume=%.2f "
+            "surfaces/resume=%.2f\n", coldNs / 1e3, cycles, resumeInits / (double)cycles,
+            resumeContexts / (double)cycles, resumeSurfaces / (double)cycles);
+    printf("resume: resize_surfaces=%llu loss_contexts=%llu\n",
+            (unsigned long long)resizeSurfaces, (unsigned long long)lossContexts);
+    bench_result("resume", "cold", "us", coldNs / 1e3);
+    bench_result("resume", "contexts_per_resume", "count", resumeContexts / (double)cycles);
+    bench_result("resume", "surfaces_per_resume", "count", resumeSurfaces / (double)cycles);
+    bench_latency_report("resume", bench_app.latencies, cycles);
+
+    if (failed != 0 || resumeInits != 0 || resumeContexts != 0 || resumeSurfaces != (uint64_t)cycles
+            || resizeSurfaces != 0 || lossContexts != 1) {
+        fprintf(stderr, "resume: EGL context not preserved across windows%s\n",
+                failed != 0 ? " (no frame presented)" : "");
+        return 1;
+    }
+    return 0;
+}
+
+// --------------------------------------------------------------------
+// Rendu  la demande
+// --------------------------------------------------------------------
+
+/**
+ * Mesure d'une phase du moteur, l'acclromtre chantillonn  chaque image :
+ * au repos (valeur constante) ou en mouvement.
+ */
+struct bench_redraw_phase {
+    uint64_t swaps;
+    uint64_t wakeups;
+    uint64_t sensorRegistrations;
+    int64_t appCpu;
+    int64_t processCpu;
+    int64_t elapsed;
+};
+
+static void bench_redraw_measure(struct bench_redraw_phase* phase, int moving) {
+    struct host_counters before;
+    struct host_counters after;
+    host_counters_get(&before);
+    int64_t processStart = bench_clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+    int64_t appStart = bench_clock_ns(bench_app.engineCpuClock);
+    int64_t start = host_now_ns();
+    for (int frame = 0; frame < BENCH_REDRAW_FRAMES; frame++) {
+        float x = moving ? (float)(frame % 60) * 0.1f : 0.0f;
+        host_sensor_push(ASENSOR_TYPE_ACCELEROMETER, x, 9.81f, 0.0f);
+        usleep(BENCH_FRAME_NS / 1000);
+    }
+    phase->elapsed = host_now_ns() - start;
+    phase->processCpu = bench_clock_ns(CLOCK_PROCESS_CPUTIME_ID) - processStart;
+    phase->appCpu = bench_clock_ns(bench_app.engineCpuClock) - appStart;
+    host_counters_get(&after);
+    phase->swaps = after.swaps - before.swaps;
+    phase->wakeups = after.looperWakeups - before.looperWakeups;
+    phase->sensorRegistrations = after.sensorRegistrations - before.sensorRegistrations;
+}
+
+static void bench_redraw_report(const char* name, const struct bench_redraw_phase* phase) {
+    double seconds = phase->elapsed / 1e9;
+    printf("%s: fps=%.1f wakeups/s=%.1f sensor_registrations=%llu app_cpu_ms/s=%.2f process_cpu_ms/s=%.2f\n",
+            name, phase->swaps / seconds, phase->wakeups / seconds,
+            (unsigned long long)phase->sensorRegistrations, phase->appCpu / 1e6 / seconds,
+            phase->processCpu / 1e6 / seconds);
+    bench_result(name, "fps", "count", phase->swaps / seconds);
+    bench_result(name, "wakeups_per_s", "count", phase->wakeups / seconds);
+    bench_result(name, "app_cpu_per_s", "ms", phase->appCpu / 1e6 / seconds);
+    bench_result(name, "process_cpu_per_s", "ms", phase->processCpu / 1e6 / seconds);
+}
+
+// Fin de l'animation, l'appareil au repos : aucune prsentation pendant BENCH_REDRAW_SETTLE_NS.
+static int bench_redraw_settle(void) {
+    int64_t deadline = host_now_ns() + 4 * BENCH_REDRAW_SETTLE_NS + 2000000000LL;
+    struct host_counters counters;
+    host_counters_get(&counters);
+    uint64_t swaps = counters.swaps;
+    int64_t quietSince = host_now_ns();
+    while (host_now_ns() < deadline) {
+        host_sensor_push(ASENSOR_TYPE_ACCELEROMETER, 0.0f, 9.81f, 0.0f);
+        usleep(BENCH_FRAME_NS / 1000);
+        host_counters_get(&counters);
+        if (counters.swaps != swaps) {
+            swaps = counters.swaps;
+            quietSince = host_now_ns();
+        } else if (host_now_ns() - quietSince >= BENCH_REDRAW_SETTLE_NS) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int bench_redraw(void) {
+    bench_engine_quiet(1);
+    ANativeActivity* activity = bench_engine_create(NULL, 0);
+    AInputQueue* queue = host_input_queue_create();
+    activity->callbacks->onInputQueueCreated(activity, queue);
+    activity->callbacks->onStart(activity);
+    activity->callbacks->onResume(activity);
+    ANativeWindow* window = host_window_create(720, 1280, WINDOW_FORMAT_RGBA_8888);
+    activity->callbacks->onNativeWindowCreated(activity, window);
+    activity->callbacks->onWindowFocusChanged(activity, 1);
+
+    // Appareil en mouvement, puis au repos une fois l'animation termine.
+    struct bench_redraw_phase moving;
+    struct bench_redraw_phase resting;
+    bench_redraw_measure(&moving, 1);
+    int failed = bench_redraw_settle();
+    bench_redraw_measure(&resting, 0);
+
+    // Redessin demand par le systme : prsent avant le retour du rappel.
+    struct host_counters before;
+    struct host_counters after;
+    host_counters_get(&before);
+    int64_t start = host_now_ns();
+    activity->callbacks->onNativeWindowRedrawNeeded(activity, window);
+    int64_t redrawNs = host_now_ns() - start;
+    host_counters_get(&after);
+    int redrawn = after.swaps > before.swaps;
+
+    // Toucher pendant l'attente : premire image prsente.
+    float xy[2] = { 100.0f + (float)(host_now_ns() / 1000 % 500), 200.0f };
+    host_counters_get(&before);
+    start = host_now_ns();
+    host_input_push_motion(queue, AMOTION_EVENT_ACTION_DOWN, 1, xy, 0);
+    failed |= bench_wait_swaps(before.swaps + 1);
+    int64_t touchNs = host_now_ns() - start;
+
+    // Focus perdu puis retrouv : l'animation reprend.
+    activity->callbacks->onWindowFocusChanged(activity, 0);
+    host_counters_get(&before);
+    activity->callbacks->onWindowFocusChanged(activity, 1);
+    int refocused = bench_wait_swaps(before.swaps + BENCH_REDRAW_REFOCUS_FRAMES) == 0;
+
+    activity->callbacks->onWindowFocusChanged(activity, 0);
+    activity->callbacks->onPause(activity);
+    activity->callbacks->onNativeWindowDestroyed(activity, window);
+    ANativeWindow_release(window);
+    activity->callbacks->onStop(activity);
+    activity->callbacks->onInputQueueDestroyed(activity, queue);
+    host_input_queue_destroy(queue);
+    bench_engine_destroy(activity);
+    bench_engine_quiet(0);
+
+    bench_redraw_report("redraw/moving", &moving);
+    bench_redraw_report("redraw/resting", &resting);
+    printf("redraw: resting_swaps=%llu redraw_needed_us=%.2f presented=%d touch_to_present_us=%.2f "
+            "refocused=%d\n", (unsigned long long)resting.swaps, redrawNs / 1e3, redrawn, touchNs / 1e3,
+            refocused);
+    bench_result("redraw", "redraw_needed", "us", redrawNs / 1e3);
+    bench_result("redraw", "touch_to_present", "us", touchNs / 1e3);
+    if (failed != 0 || resting.swaps != 0 || resting.sensorRegistrations != 0 || !redrawn || !refocused) {
+        fprintf(stderr, "redraw: %s\n", resting.swaps != 0 ? "frames presented at rest"
+                : resting.sensorRegistrations != 0 ? "sensor registered again at rest"
+                : !redrawn ? "redraw request returned before presenting"
+                : !refocused ? "animation not resumed with the focus" : "no frame presented");
+        return 1;
+    }
+    return 0;
+}
+
+// --------------------------------------------------------------------
+// Configuration
+// --------------------------------------------------------------------
+
+static int64_t bench_config_recreate_ns[BENCH_CONFIG_MAX];
+
+// Configuration de l'appareil tourn : orientation et taille de l'cran en dp.
+static void bench_config_rotate(int landscape) {
+    AConfiguration* config;
+    host_config_lock(&config);
+    AConfiguration_setOrientation(config, landscape ? ACONFIGURATION_ORIENTATION_LAND
+            : ACONFIGURATION_ORIENTATION_PORT);
+    AConfiguration_setScreenWidthDp(config, landscape ? 640 : 360);
+    AConfiguration_setScreenHeightDp(config, landscape ? 360 : 640);
+    host_config_unlock();
+}
+
+static void bench_config_set(int32_t density, int32_t night) {
+    AConfiguration* config;
+    host_config_lock(&config);
+    AConfiguration_setDensity(config, density);
+    AConfiguration_setUiModeNight(config, night);
+    host_config_unlock();
+}
+
+static ANativeWindow* bench_config_window(int landscape) {
+    return host_window_create(landscape ? 1280 : 720, landscape ? 720 : 1280, WINDOW_FORMAT_RGBA_8888);
+}
+
+/**
+ * Rotation par recration de l'activit, dans l'ordre des rappels du systme,
+ * jusqu'au redessin de la nouvelle fentre. Retourne la nouvelle activit, sa
+ * fentre dans inOutWindow.
+ */
+static ANativeActivity* bench_config_recreate(ANativeActivity* activity, ANativeWindow** inOutWindow,
+        int landscape) {
+    activity->callbacks->onWindowFocusChanged(activity, 0);
+    activity->callbacks->onPause(activity);
+    size_t savedStateSize = 0;
+    void* savedState = activity->callbacks->onSaveInstanceState(activity, &savedStateSize);
+    activity->callbacks->onStop(activity);
+    activity->callbacks->onNativeWindowDestroyed(activity, *inOutWindow);
+    ANativeWindow_release(*inOutWindow);
+    bench_engine_destroy(activity);
+    bench_config_rotate(landscape);
+
+    activity = bench_engine_create(savedState, savedStateSize);
+    free(savedState);
+    activity->callbacks->onStart(activity);
+    activity->callbacks->onResume(activity);
+    *inOutWindow = bench_config_window(landscape);
+    activity->callbacks->onNativeWindowCreated(activity, *inOutWindow);
+    activity->callbacks->onNativeWindowRedrawNeeded(activity, *inOutWindow);
+    activity->callbacks->onWindowFocusChanged(activity, 1);
+    return activity;
+}
+
+/**
+ * Changement de configuration, le moteur au repos : images prsentes dans les
+ * BENCH_REDRAW_SETTLE_NS qui suivent.
+ */
+static uint64_t bench_config_change(ANativeActivity* activity, int32_t density, int32_t night,
+        int landscape) {
+    struct host_counters before;
+    struct host_counters after;
+    host_counters_get(&before);
+    bench_config_set(density, night);
+    bench_config_rotate(landscape);
+    activity->callbacks->onConfigurationChanged(activity);
+    usleep(BENCH_REDRAW_SETTLE_NS / 1000);
+    host_counters_get(&after);
+    return after.swaps - before.swaps;
+}
+
+static int bench_config(int iterations) {
+    int rotations = iterations < BENCH_CONFIG_MAX ? iterations : BENCH_CONFIG_MAX;
+    if (rotations < 1) rotations = 1;
+
+    bench_engine_quiet(1);
+    bench_config_rotate(0);
+    ANativeActivity* activity = bench_engine_create(NULL, 0);
+    activity->callbacks->onStart(activity);
+    activity->callbacks->onResume(activity);
+    ANativeWindow* window = bench_config_window(0);
+    activity->callbacks->onNativeWindowCreated(activity, window);
+    activity->callbacks->onNativeWindowRedrawNeeded(activity, window);
+    activity->callbacks->onWindowFocusChanged(activity, 1);
+    int failed = 0;
+
+    // Avant : chaque rotation recre l'activit, son affichage et son tat.
+    struct host_counters before;
+    struct host_counters counters;
+    struct host_counters presented;
+    host_counters_get(&before);
+    for (int i = 0; i < rotations && failed == 0; i++) {
+        host_counters_get(&counters);
+        int64_t start = host_now_ns();
+        activity = bench_config_recreate(activity, &window, (i & 1) == 0);
+        bench_config_recreate_ns[i] = host_now_ns() - start;
+        host_counters_get(&presented);
+        failed = presented.swaps > counters.swaps ? 0 : -1;
+    }
+    struct host_counters recreated;
+    host_counters_get(&recreated);
+
+    // Aprs : la configuration change, la mme fentre est redimensionne.
+    int landscape = rotations & 1;
+    for (int i = 0; i < rotations && failed == 0; i++) {
+        landscape = !landscape;
+        host_counters_get(&counters);
+        int64_t start = host_now_ns();
+        bench_config_rotate(landscape);
+        activity->callbacks->onConfigurationChanged(activity);
+        host_window_resize(window, landscape ? 1280 : 720, landscape ? 720 : 1280);
+        activity->callbacks->onNativeWindowResized(activity, window);
+        activity->callbacks->onNativeWindowRedrawNeeded(activity, window);
+        bench_app.latencies[i] = host_now_ns() - start;
+        host_counters_get(&presented);
+        failed = presented.swaps > counters.swaps ? 0 : -1;
+    }
+    struct host_counters rotated;
+    host_counters_get(&rotated);
+
+    // Au repos : le mode nuit puis la densit redessinent le repre ; l'orientation
+    // seule, sans nouvelle taille de fentre, n'a pas d'abonn.
+    failed |= bench_redraw_settle();
+    uint64_t nightSwaps = bench_config_change(activity, ACONFIGURATION_DENSITY_XHIGH,
+            ACONFIGURATION_UI_MODE_NIGHT_YES, landscape);
+    uint64_t densitySwaps = bench_config_change(activity, ACONFIGURATION_DENSITY_XXHIGH,
+            ACONFIGURATION_UI_MODE_NIGHT_YES, landscape);
+    uint64_t orientationSwaps = bench_config_change(activity, ACONFIGURATION_DENSITY_XXHIGH,
+            ACONFIGURATION_UI_MODE_NIGHT_YES, !landscape);
+    struct host_counters after;
+    host_counters_get(&after);
+
+    activity->callbacks->onWindowFocusChanged(activity, 0);
+    activity->callbacks->onPause(activity);
+    activity->callbacks->onNativeWindowDestroyed(activity, window);
+    ANativeWindow_release(window);
+    activity->callbacks->onStop(activity);
+    bench_engine_destroy(activity);
+    bench_config_rotate(0);
+    bench_config_set(ACONFIGURATION_DENSITY_XHIGH, ACONFIGURATION_UI_MODE_NIGHT_NO);
+    bench_engine_quiet(0);
+
+    uint64_t recreateContexts = recreated.eglContexts - before.eglContexts;
+    uint64_t recreateSurfaces = recreated.eglSurfaces - before.eglSurfaces;
+    uint64_t rotateContexts = rotated.eglContexts - recreated.eglContexts;
+    uint64_t rotateSurfaces = rotated.eglSurfaces - recreated.eglSurfaces;
+    uint64_t changeSurfaces = after.eglSurfaces - rotated.eglSurfaces;
+    printf("config: rotations=%d recreate contexts/rotation=%.2f surfaces/rotation=%.2f "
+            "in_place contexts/rotation=%.2f surfaces/rotation=%.2f\n", rotations,
+            recreateContexts / (double)rotations, recreateSurfaces / (double)rotations,
+            rotateContexts / (double)rotations, rotateSurfaces / (double)rotations);
+    bench_result("config/recreate", "contexts_per_rotation", "count", recreateContexts / (double)rotations);
+    bench_result("config/recreate", "surfaces_per_rotation", "count", recreateSurfaces / (double)rotations);
+    bench_result("config/in_place", "contexts_per_rotation", "count", rotateContexts / (double)rotations);
+    bench_result("config/in_place", "surfaces_per_rotation", "count", rotateSurfaces / (double)rotations);
+    bench_latency_report("config/recreate", bench_config_recreate_ns, rotations);
+    bench_latency_report("config/in_place", bench_app.latencies, rotations);
+    printf("config: swaps night=%llu density=%llu orientation_only=%llu\n",
+            (unsigned long long)nightSwaps, (unsigned long long)densitySwaps,
+            (unsigned long long)orientationSwaps);
+
+    const char* failure = NULL;
+    if (failed != 0) {
+        failure = "no frame presented after a rotation";
+    } else if (rotateContexts != 0 || rotateSurfaces != 0) {
+        failure = "in-place rotation recreated the display";
+    } else if (nightSwaps != 1 || densitySwaps != 1 || changeSurfaces != 0) {
+        failure = "night mode or density change not redrawn once in place";
+    } else if (orientationSwaps != 0) {
+        failure = "configuration change redrawn without a subscriber";
+    }
+    if (failure != NULL) {
+        fprintf(stderr, "config: %s\n", failure);
+        return 1;
+    }
+    return 0;
+}
+
+// --------------------------------------------------------------------
+// Rsolution dynamique
+// --------------------------------------------------------------------
+
+/**
+ * Largeur des tampons de la fentre pendant une phase, l'appareil en mouvement.
+ */
+struct bench_resolution_phase {
+    int32_t firstWidth;
+    int32_t lastWidth;
+    int changes;
+    uint64_t swaps;
+    int64_t elapsed;
+};
+
+/**
+ * Images pendant duration au plus ; la phase s'arrte plus tt quand la largeur
+ * atteint untilWidth (0 : jamais).
+ */
+static void bench_resolution_run(ANativeWindow* window, struct bench_resolution_phase* phase,
+        int64_t duration, int32_t untilWidth) {
+    struct host_counters before;
+    struct host_counters after;
+    host_counters_get(&before);
+    int64_t start = host_now_ns();
+    phase->firstWidth = ANativeWindow_getWidth(window);
+    phase->lastWidth = phase->firstWidth;
+    phase->changes = 0;
+    for (int frame = 0; host_now_ns() - start < duration; frame++) {
+        host_sensor_push(ASENSOR_TYPE_ACCELEROMETER, (float)(frame % 60) * 0.1f, 9.81f, 0.0f);
+        usleep(BENCH_FRAME_NS / 1000);
+        int32_t width = ANativeWindow_getWidth(window);
+        if (width != phase->lastWidth) {
+            phase->changes++;
+            phase->lastWidth = width;
+        }
+        if (width == untilWidth) {
+            break;
+        }
+    }
+    phase->elapsed = host_now_ns() - start;
+    host_counters_get(&after);
+    phase->swaps = after.swaps - before.swaps;
+}
+
+static void bench_resolution_report(const char* name, const struct bench_resolution_phase* phase) {
+    double scale = (double)phase->lastWidth / BENCH_RESOLUTION_WIDTH;
+    printf("%s: scale=%.2f changes=%d fps=%.1f elapsed_ms=%.0f\n", name, scale, phase->changes,
+            phase->swaps / (phase->elapsed / 1e9), phase->elapsed / 1e6);
+    bench_result(name, "scale", "ratio", scale);
+    bench_result(name, "changes", "count", phase->changes);
+    bench_result(name, "fps", "count", phase->swaps / (phase->elapsed / 1e9));
+    bench_result(name, "elapsed", "ms", phase->elapsed / 1e6);
+}
+
+static int bench_resolution(void) {
+    bench_engine_quiet(1);
+    ANativeActivity* activity = bench_engine_create(NULL, 0);
+    activity->callbacks->onStart(activity);
+    activity->callbacks->onResume(activity);
+    ANativeWindow* window = host_window_create(BENCH_RESOLUTION_WIDTH, BENCH_RESOLUTION_HEIGHT,
+            WINDOW_FORMAT_RGBA_8888);
+    activity->callbacks->onNativeWindowCreated(activity, window);
+    activity->callbacks->onWindowFocusChanged(activity, 1);
+
+    // Cot lev : l'chelle descend puis ne bouge plus.
+    struct bench_resolution_phase converge;
+    struct bench_resolution_phase steady;
+    host_window_set_fill_cost(BENCH_RESOLUTION_HIGH_COST);
+    bench_resolution_run(window, &converge, BENCH_RESOLUTION_CONVERGE_NS, 0);
+    bench_resolution_run(window, &steady, BENCH_RESOLUTION_STEADY_NS, 0);
+    double pixels = (double)steady.lastWidth * steady.lastWidth / BENCH_RESOLUTION_WIDTH
+            * BENCH_RESOLUTION_HEIGHT;
+    double steadyFillMs = pixels * BENCH_RESOLUTION_HIGH_COST / 1e12;
+
+    // Cot faible : retour  la pleine rsolution.
+    struct bench_resolution_phase recover;
+    host_window_set_fill_cost(BENCH_RESOLUTION_LOW_COST);
+    bench_resolution_run(window, &recover, BENCH_RESOLUTION_RECOVER_NS, BENCH_RESOLUTION_WIDTH);
+
+    // Limitation thermique imminente : chelle plafonne malgr le cot faible.
+    struct bench_resolution_phase thermal;
+    host_thermal_set_headroom(0.95f);
+    bench_resolution_run(window, &thermal, BENCH_RESOLUTION_THERMAL_NS, 0);
+    host_thermal_set_headroom(0.3f);
+    host_window_set_fill_cost(0);
+
+    activity->callbacks->onWindowFocusChanged(activity, 0);
+    activity->callbacks->onPause(activity);
+    activity->callbacks->onNativeWindowDestroyed(activity, window);
+    ANativeWindow_release(window);
+    activity->callbacks->onStop(activity);
+    bench_engine_destroy(activity);
+    host_thermal_set_headroom(0.0f);
+    bench_engine_quiet(0);
+
+    bench_resolution_report("resolution/converge", &converge);
+    bench_resolution_report("resolution/steady", &steady);
+    bench_resolution_report("resolution/recover", &recover);
+    bench_resolution_report("resolution/thermal", &thermal);
+    printf("resolution: steady_fill_ms=%.2f\n", steadyFillMs);
+    bench_result("resolution", "steady_fill", "ms", steadyFillMs);
+
+    const char* failure = NULL;
+    if (converge.lastWidth >= BENCH_RESOLUTION_WIDTH || steadyFillMs > 0.8 * BENCH_FRAME_NS / 1e6) {
+        failure = "scale did not settle under the frame budget";
+    } else if (steady.changes != 0) {
+        failure = "scale oscillates at a steady cost";
+    } else if (recover.lastWidth != BENCH_RESOLUTION_WIDTH) {
+        failure = "full resolution not restored at a low cost";
+    } else if (thermal.lastWidth > BENCH_RESOLUTION_WIDTH * 6 / 10) {
+        failure = "thermal headroom ignored";
+    }
+    if (failure != NULL) {
+        fprintf(stderr, "resolution: %s\n", failure);
+        return 1;
+    }
+    return 0;
+}
+
+static int bench_raster(int iterations) {
+    int failures = bench_raster_exact();
+    bench_raster_rate(iterations);
+    int fallback = bench_raster_fallback();
+    bench_result("raster", "exact_mismatches", "count", failures);
+    if (failures != 0 || fallback != 0) {
+        fprintf(stderr, "raster: %d scenes differ from the scalar reference%s\n", failures,
+                fallback != 0 ? ", software fallback failed" : "");
+        return 1;
+    }
+    return 0;
+}
+
+// --------------------------------------------------------------------
+// Tches
+// --------------------------------------------------------------------
+
+static uint64_t bench_jobs_sum;
+static uint32_t bench_jobs_leaves;
+static int64_t bench_jobs_latencies[BENCH_JOBS_LATENCY_ROUNDS];
+
+static void bench_jobs_add(void* data, size_t begin, size_t end) {
+    uint64_t sum = 0;
+    for (size_t i = begin; i < end; i++) {
+        sum += i;
+    }
+    __atomic_fetch_add(&bench_jobs_sum, sum, __ATOMIC_RELAXED);
+}
+
+// Calcul sans mmoire partage, BENCH_JOBS_WORK pas par lment.
+static void bench_jobs_compute(void* data, size_t begin, size_t end) {
+    uint32_t state = (uint32_t)begin;
+    for (size_t i = begin; i < end; i++) {
+        for (int step = 0; step < BENCH_JOBS_WORK; step++) {
+            state = state * 1664525u + 1013904223u;
+        }
+    }
+    __atomic_fetch_add(&bench_jobs_sum, state & 1, __ATOMIC_RELAXED);
+}
+
+static void bench_jobs_node(struct job_system* system, struct job* job, void* data) {
+    int depth = *(int*)data;
+    if (depth == 0) {
+        __atomic_fetch_add(&bench_jobs_leaves, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    depth--;
+    for (int i = 0; i < 2; i++) {
+        struct job* child = job_system_create_job(system, bench_jobs_node, &depth, sizeof(depth), job);
+        job_system_run(system, child, JOB_SYSTEM_LATENCY);
+    }
+}
+
+static void bench_jobs_background(struct job_system* system, struct job* job, void* data) {
+    bench_jobs_compute(NULL, 0, BENCH_JOBS_BACKGROUND_ITEMS);
+}
+
+static void bench_jobs_noop(struct job_system* system, struct job* job, void* data) {
+}
+
+static void bench_jobs_utilization(const char* name, struct job_system* system, int64_t elapsed) {
+    for (int i = 0; i < job_system_get_workers(system); i++) {
+        struct job_system_worker_stats stats;
+        job_system_get_worker_stats(system, i, &stats);
+        printf("%s/worker%d: %s cpu=%d jobs=%llu steals=%llu busy=%.0f%%\n", name, i,
+                stats.jobClass == JOB_SYSTEM_BACKGROUND ? "background" : "latency", stats.cpu,
+                (unsigned long long)stats.jobs, (unsigned long long)stats.steals,
+                100.0 * stats.busyNs / elapsed);
+    }
+}
+
+/**
+ * Surcot : parallel_for de count lments en tranches d'un lment, puis arbre
+ * binaire de tches parentes et filles. Retourne -1 si un rsultat est faux.
+ */
+static int bench_jobs_overhead(int workers, int count) {
+    char name[32];
+    snprintf(name, sizeof(name), "jobs/overhead_t%d", workers + 1);
+    struct job_system* system = job_system_create(workers, 0, 0);
+    __atomic_store_n(&bench_jobs_sum, 0, __ATOMIC_RELAXED);
+    int64_t start = host_now_ns();
+    job_system_parallel_for(system, count, 1, bench_jobs_add, NULL);
+    int64_t perJob = (host_now_ns() - start) / count;
+    int valid = bench_jobs_sum == (uint64_t)count * (count - 1) / 2;
+
+    __atomic_store_n(&bench_jobs_leaves, 0, __ATOMIC_RELAXED);
+    int depth = BENCH_JOBS_TREE_DEPTH;
+    start = host_now_ns();
+    struct job* root = job_system_create_job(system, bench_jobs_node, &depth, sizeof(depth), NULL);
+    job_system_run(system, root, JOB_SYSTEM_LATENCY);
+    job_system_wait(system, root);
+    int64_t tree = host_now_ns() - start;
+    int nodes = (2 << BENCH_JOBS_TREE_DEPTH) - 1;
+    valid &= bench_jobs_leaves == 1u << BENCH_JOBS_TREE_DEPTH;
+    printf("%s: parallel_for=%lld ns/job tree=%d jobs %.2f Mjobs/s valid=%d\n", name,
+            (long long)perJob, nodes, nodes / (tree / 1e3), valid);
+    bench_result(name, "parallel_for_per_job", "ns", (double)perJob);
+    bench_result(name, "tree_rate", "Mjobs/s", nodes / (tree / 1e3));
+    job_system_destroy(system);
+    return valid ? 0 : -1;
+}
+
+// Acclration d'un calcul dcoup en BENCH_JOBS_CHUNKS tranches.
+static int64_t bench_jobs_scaling(int workers, int64_t reference) {
+    char name[32];
+    snprintf(name, sizeof(name), "jobs/scaling_t%d", workers + 1);
+    struct job_system* system = job_system_create(workers, 0, 0);
+    int64_t start = host_now_ns();
+    job_system_parallel_for(system, BENCH_JOBS_CHUNKS, 1, bench_jobs_compute, NULL);
+    int64_t elapsed = host_now_ns() - start;
+    if (reference == 0) reference = elapsed;
+    printf("%s: %.2f ms speedup=%.2f\n", name, elapsed / 1e6, reference / (double)elapsed);
+    bench_result(name, "elapsed", "ms", elapsed / 1e6);
+    bench_result(name, "speedup", "x", reference / (double)elapsed);
+    bench_jobs_utilization(name, system, elapsed);
+    job_system_destroy(system);
+    return elapsed;
+}
+
+/**
+ * Isolement : le mme calcul de latence pendant que des tches de fond occupent
+ * le processeur, excutes par un thread de fond (priorit basse, curs conomes)
+ * ou, sans thread de fond, par le groupe de latence.
+ */
+static void bench_jobs_isolation(int backgroundWorkers) {
+    const char* name = backgroundWorkers > 0 ? "jobs/isolated" : "jobs/shared";
+    struct job_system* system = job_system_create(1, backgroundWorkers, 0);
+    // La parente ne fait rien : elle regroupe ses filles pour l'attente.
+    struct job* background = job_system_create_job(system, bench_jobs_noop, NULL, 0, NULL);
+    for (int i = 0; i < BENCH_JOBS_BACKGROUND_JOBS; i++) {
+        struct job* child = job_system_create_job(system, bench_jobs_background, NULL, 0, background);
+        job_system_run(system, child, JOB_SYSTEM_BACKGROUND);
+    }
+    job_system_run(system, background, JOB_SYSTEM_BACKGROUND);
+    int64_t start = host_now_ns();
+    for (int i = 0; i < BENCH_JOBS_LATENCY_ROUNDS; i++) {
+        int64_t t = host_now_ns();
+        job_system_parallel_for(system, BENCH_JOBS_CHUNKS / 16, 1, bench_jobs_compute, NULL);
+        bench_jobs_latencies[i] = host_now_ns() - t;
+    }
+    int64_t elapsed = host_now_ns() - start;
+    bench_latency_report(name, bench_jobs_latencies, BENCH_JOBS_LATENCY_ROUNDS);
+    bench_jobs_utilization(name, system, elapsed);
+    job_system_wait(system, background);
+    job_system_destroy(system);
+}
+
+static int bench_jobs(int iterations) {
+    struct job_system* system = job_system_create(-1, -1, 0);
+    uint64_t fast;
+    uint64_t efficient;
+    job_system_get_topology(system, &fast, &efficient);
+    printf("jobs: fast cpus=0x%llx efficient cpus=0x%llx threads=%d\n", (unsigned long long)fast,
+            (unsigned long long)efficient, job_system_get_workers(system));
+    job_system_destroy(system);
+
+    int count = iterations < BENCH_JOBS_MAX ? iterations : BENCH_JOBS_MAX;
+    if (count < 1) count = 1;
+    int result = 0;
+    int64_t reference = 0;
+    for (int workers = 0; workers <= 3; workers += workers == 0 ? 1 : 2) {
+        if (bench_jobs_overhead(workers, count) != 0) {
+            result = 1;
+        }
+        int64_t elapsed = bench_jobs_scaling(workers, reference);
+        if (reference == 0) reference = elapsed;
+    }
+    bench_jobs_isolation(1);
+    bench_jobs_isolation(0);
+    if (result != 0) {
+        fprintf(stderr, "jobs: wrong results\n");
+    }
+    return result;
+}
+
+// --------------------------------------------------------------------
+// Budget mmoire
+// --------------------------------------------------------------------
+
+/**
+ * Cache synthtique : des blocs de BENCH_MEMORY_BLOCK octets, librs du plus
+ * rcent au plus ancien. Chaque appel du librateur est not dans
+ * bench_memory_calls, pour vrifier l'ordre des paliers.
+ */
+struct bench_memory_cache {
+    struct memory_budget* budget;
+    const char* name;
+    int category;
+    void* blocks[BENCH_MEMORY_MAX_BLOCKS];
+    int count;
+};
+
+static const struct bench_memory_cache* bench_memory_calls[BENCH_MEMORY_MAX_CALLS];
+static int bench_memory_call_count;
+
+static void bench_memory_fill(struct bench_memory_cache* cache, size_t bytes) {
+    while (bytes >= BENCH_MEMORY_BLOCK && cache->count < BENCH_MEMORY_MAX_BLOCKS) {
+        void* block = malloc(BENCH_MEMORY_BLOCK);
+        memset(block, 0x5a, BENCH_MEMORY_BLOCK);
+        cache->blocks[cache->count++] = block;
+        memory_budget_add(cache->budget, cache->category, BENCH_MEMORY_BLOCK);
+        bytes -= BENCH_MEMORY_BLOCK;
+    }
+}
+
+static size_t bench_memory_evict(void* userData, size_t targetBytes) {
+    struct bench_memory_cache* cache = (struct bench_memory_cache*)userData;
+    if (bench_memory_call_count < BENCH_MEMORY_MAX_CALLS) {
+        bench_memory_calls[bench_memory_call_count++] = cache;
+    }
+    size_t freed = 0;
+    while (freed < targetBytes && cache->count > 0) {
+        free(cache->blocks[--cache->count]);
+        freed += BENCH_MEMORY_BLOCK;
+    }
+    memory_budget_add(cache->budget, cache->category, -(ptrdiff_t)freed);
+    return freed;
+}
+
+static void bench_memory_print(const char* name, const struct memory_budget_report* report) {
+    printf("memory: %-12s evictors=%d freed=%zu KiB in %.1f us, %zu -> %zu KiB\n", name,
+            report->evictors, report->reclaimedBytes >> 10, report->durationNs / 1e3,
+            report->usageBefore >> 10, report->usageAfter >> 10);
+}
+
+/**
+ * Paliers et priorits : dpassement du budget, nouvel essai, arrt puis
+ * mmoire faible, sur quatre caches enregistrs dans le dsordre.
+ */
+static int bench_memory_tiers(int iterations) {
+    struct memory_budget budget;
+    memory_budget_init(&budget, BENCH_MEMORY_BUDGET);
+    struct bench_memory_cache critical = { &budget, "critical", MEMORY_BUDGET_TEXTURES };
+    struct bench_memory_cache background = { &budget, "background", MEMORY_BUDGET_POOLS };
+    struct bench_memory_cache late = { &budget, "late cache", MEMORY_BUDGET_ASSETS };
+    struct bench_memory_cache early = { &budget, "early cache", MEMORY_BUDGET_ASSETS };
+    memory_budget_add_evictor(&budget, critical.name, critical.category, MEMORY_BUDGET_TIER_CRITICAL,
+            0, bench_memory_evict, &critical);
+    memory_budget_add_evictor(&budget, late.name, late.category, MEMORY_BUDGET_TIER_CACHE, 1,
+            bench_memory_evict, &late);
+    memory_budget_add_evictor(&budget, background.name, background.category,
+            MEMORY_BUDGET_TIER_BACKGROUND, 0, bench_memory_evict, &background);
+    memory_budget_add_evictor(&budget, early.name, early.category, MEMORY_BUDGET_TIER_CACHE, 0,
+            bench_memory_evict, &early);
+    bench_memory_fill(&critical, BENCH_MEMORY_BUDGET / 4);
+    bench_memory_fill(&background, BENCH_MEMORY_BUDGET / 4);
+    bench_memory_fill(&late, BENCH_MEMORY_BUDGET / 2);
+    bench_memory_fill(&early, BENCH_MEMORY_BUDGET / 2);
+    int failed = 0;
+
+    // Cot de la vrification de chaque image, sous le budget.
+    struct memory_budget idle;
+    memory_budget_init(&idle, BENCH_MEMORY_BUDGET);
+    memory_budget_add(&idle, MEMORY_BUDGET_ASSETS, BENCH_MEMORY_BUDGET / 2);
+    int checks = iterations * 100;
+    int64_t start = host_now_ns();
+    for (int i = 0; i < checks; i++) {
+        memory_budget_check(&idle);
+    }
+    double checkNs = (host_now_ns() - start) / (double)checks;
+    printf("memory: check=%.1f ns under budget\n", checkNs);
+    bench_result("memory", "check", "ns", checkNs);
+
+    // Dpassement : le premier cache, puis le second jusqu'au seuil bas seulement.
+    struct memory_budget_report report;
+    size_t lowWater = (size_t)(BENCH_MEMORY_BUDGET * MEMORY_BUDGET_LOW_WATER);
+    memory_budget_check(&budget);
+    report = budget.last;
+    bench_memory_print("over_budget", &report);
+    bench_result("memory", "over_budget_freed", "KiB", report.reclaimedBytes >> 10);
+    bench_result("memory", "over_budget", "us", report.durationNs / 1e3);
+    if (bench_memory_call_count != 2 || bench_memory_calls[0] != &early || bench_memory_calls[1] != &late
+            || report.usageAfter > lowWater || report.usageAfter + BENCH_MEMORY_BLOCK <= lowWater
+            || late.count == 0) {
+        fprintf(stderr, "memory: over budget should free the caches in order, down to the low water mark\n");
+        failed = 1;
+    }
+
+    // Mmoire que les caches ne peuvent pas rendre : un seul essai tant qu'elle ne grandit pas.
+    memory_budget_add(&budget, MEMORY_BUDGET_SAVED_STATE, BENCH_MEMORY_BUDGET);
+    memory_budget_check(&budget);
+    int calls = bench_memory_call_count;
+    memory_budget_check(&budget);
+    memory_budget_check(&budget);
+    int repeated = bench_memory_call_count - calls;
+    memory_budget_add(&budget, MEMORY_BUDGET_SAVED_STATE, 1);
+    memory_budget_check(&budget);
+    int retried = bench_memory_call_count - calls - repeated;
+    memory_budget_add(&budget, MEMORY_BUDGET_SAVED_STATE, -(ptrdiff_t)(BENCH_MEMORY_BUDGET + 1));
+    printf("memory: still over budget, repeated=%d retried after growth=%d\n", repeated, retried);
+    if (repeated != 0 || retried == 0 || early.count != 0 || late.count != 0) {
+        fprintf(stderr, "memory: over budget should retry only after usage grows\n");
+        failed = 1;
+    }
+
+    // Arrt : le palier de fond, pas le palier critique.
+    memory_budget_reclaim(&budget, MEMORY_BUDGET_STOPPED, &report);
+    bench_memory_print("stopped", &report);
+    bench_result("memory", "stopped_freed", "KiB", report.reclaimedBytes >> 10);
+    bench_result("memory", "stopped", "us", report.durationNs / 1e3);
+    if (background.count != 0 || critical.count == 0) {
+        fprintf(stderr, "memory: stop should free the background tier only\n");
+        failed = 1;
+    }
+
+    // Mmoire faible : tout.
+    memory_budget_reclaim(&budget, MEMORY_BUDGET_LOW_MEMORY, &report);
+    bench_memory_print("low_memory", &report);
+    bench_result("memory", "low_memory_freed", "KiB", report.reclaimedBytes >> 10);
+    bench_result("memory", "low_memory", "us", report.durationNs / 1e3);
+    if (critical.count != 0 || memory_budget_total(&budget) != 0) {
+        fprintf(stderr, "memory: low memory should free every tier\n");
+        failed = 1;
+    }
+    return failed;
+}
+
+/**
+ * Moteur : une fentre dtruite puis recre aprs l'arrt, qui garde le
+ * contexte, puis aprs l'arrt et une alerte de mmoire faible, qui le libre.
+ * Retourne la latence jusqu' la premire prsentation et les contextes crs.
+ */
+static int64_t bench_memory_cycle(ANativeActivity* activity, ANativeWindow** inOutWindow, int lowMemory,
+        uint64_t* outContexts) {
+    activity->callbacks->onPause(activity);
+    activity->callbacks->onNativeWindowDestroyed(activity, *inOutWindow);
+    ANativeWindow_release(*inOutWindow);
+    activity->callbacks->onStop(activity);
+    if (lowMemory) {
+        activity->callbacks->onLowMemory(activity);
+    }
+    // Demande synchrone : les commandes prcdentes sont traites  son retour.
+    size_t savedStateSize = 0;
+    free(activity->callbacks->onSaveInstanceState(activity, &savedStateSize));
+
+    activity->callbacks->onStart(activity);
+    activity->callbacks->onResume(activity);
+    struct host_counters before;
+    host_counters_get(&before);
+    *inOutWindow = host_window_create(720, 1280, WINDOW_FORMAT_RGBA_8888);
+    int64_t start = host_now_ns();
+    activity->callbacks->onNativeWindowCreated(activity, *inOutWindow);
+    int64_t latency = bench_wait_swaps(before.swaps + 1) == 0 ? host_now_ns() - start : -1;
+    struct host_counters after;
+    host_counters_get(&after);
+    *outContexts = after.eglContexts - before.eglContexts;
+    return latency;
+}
+
+static int bench_memory_engine(void) {
+    bench_engine_quiet(1);
+    ANativeActivity* activity = bench_engine_create(NULL, 0);
+    activity->callbacks->onStart(activity);
+    activity->callbacks->onResume(activity);
+    struct host_counters before;
+    host_counters_get(&before);
+    ANativeWindow* window = host_window_create(720, 1280, WINDOW_FORMAT_RGBA_8888);
+    activity->callbacks->onNativeWindowCreated(activity, window);
+    int failed = bench_wait_swaps(before.swaps + 1);
+
+    uint64_t stoppedContexts = 0;
+    uint64_t lowMemoryContexts = 0;
+    int64_t stoppedNs = failed == 0 ? bench_memory_cycle(activity, &window, 0, &stoppedContexts) : -1;
+    int64_t lowMemoryNs = failed == 0 ? bench_memory_cycle(activity, &window, 1, &lowMemoryContexts) : -1;
+
+    activity->callbacks->onPause(activity);
+    activity->callbacks->onNativeWindowDestroyed(activity, window);
+    ANativeWindow_release(window);
+    activity->callbacks->onStop(activity);
+    bench_engine_destroy(activity);
+    bench_engine_quiet(0);
+
+    printf("memory: engine window after stop %.2f us (contexts=%llu), after low memory %.2f us "
+            "(contexts=%llu)\n", stoppedNs / 1e3, (unsigned long long)stoppedContexts,
+            lowMemoryNs / 1e3, (unsigned long long)lowMemoryContexts);
+    bench_result("memory", "window_after_stop", "us", stoppedNs / 1e3);
+    bench_result("memory", "window_after_low_memory", "us", lowMemoryNs / 1e3);
+    if (failed != 0 || stoppedNs < 0 || lowMemoryNs < 0 || stoppedContexts != 0 || lowMemoryContexts != 1) {
+        fprintf(stderr, "memory: the context should survive a stop and be released on low memory\n");
+        return 1;
+    }
+    return 0;
+}
+
+static int bench_memory(int iterations) {
+    int result = bench_memory_tiers(iterations);
+    result |= bench_memory_engine();
+    return result;
+}
+
+// --------------------------------------------------------------------
+// Trace d'vnements
+// --------------------------------------------------------------------
+
+// Mouvement synthtique numro index : deux doigts qui tournent, pression variable.
+static void bench_trace_motion(int index, int64_t baseNs, struct event_trace_motion* motion) {
+    memset(motion, 0, sizeof(*motion));
+    motion->action = index == 0 ? AMOTION_EVENT_ACTION_DOWN : AMOTION_EVENT_ACTION_MOVE;
+    motion->source = AINPUT_SOURCE_TOUCHSCREEN;
+    motion->deviceId = 3;
+    motion->pointerCount = BENCH_TRACE_POINTERS;
+    motion->sampleCount = BENCH_TRACE_HISTORY + 1;
+    for (uint32_t p = 0; p < motion->pointerCount; p++) {
+        motion->pointerId[p] = (int32_t)p;
+    }
+    for (uint32_t s = 0; s < motion->sampleCount; s++) {
+        int sample = index * (int)motion->sampleCount + (int)s;
+        // chantillons  1 kHz, un vnement toutes les 8 ms, comme le toucher soutenu du benchmark input.
+        motion->eventTime[s] = baseNs + (int64_t)sample * 1000000;
+        for (uint32_t p = 0; p < motion->pointerCount; p++) {
+            float angle = sample * 0.01f + p * 3.14159f;
+            motion->x[s][p] = 540.0f + 300.0f * cosf(angle);
+            motion->y[s][p] = 960.0f + 300.0f * sinf(angle);
+            motion->pressure[s][p] = 0.5f + 0.25f * sinf(sample * 0.05f);
+        }
+    }
+}
+
+static void bench_trace_sensor(int index, int64_t baseNs, ASensorEvent* event) {
+    memset(event, 0, sizeof(*event));
+    event->version = sizeof(*event);
+    event->type = ASENSOR_TYPE_ACCELEROMETER;
+    event->timestamp = baseNs + (int64_t)index * 5000000;
+    event->vector.x = 0.3f * sinf(index * 0.1f);
+    event->vector.y = 9.81f + 0.1f * cosf(index * 0.07f);
+    event->vector.z = 0.05f * sinf(index * 0.3f);
+}
+
+static int bench_trace_same_motion(const struct event_trace_motion* a, const struct event_trace_motion* b) {
+    if (a->action != b->action || a->source != b->source || a->deviceId != b->deviceId
+            || a->pointerCount != b->pointerCount || a->sampleCount != b->sampleCount
+            || memcmp(a->pointerId, b->pointerId, a->pointerCount * sizeof(int32_t)) != 0
+            || memcmp(a->eventTime, b->eventTime, a->sampleCount * sizeof(int64_t)) != 0) {
+        return 0;
+    }
+    for (uint32_t s = 0; s < a->sampleCount; s++) {
+        size_t bytes = a->pointerCount * sizeof(float);
+        if (memcmp(a->x[s], b->x[s], bytes) != 0 || memcmp(a->y[s], b->y[s], bytes) != 0
+                || memcmp(a->pressure[s], b->pressure[s], bytes) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Enregistrement et relecture d'un flux synthtique : events mouvements, chacun
+ * suivi de BENCH_TRACE_SENSOR_BATCH chantillons, et une commande toutes les
+ * 64 itrations. Les mouvements passent par une AInputQueue pour tre de vrais
+ * AInputEvent. Retourne le nombre d'enregistrements relus qui diffrent.
+ */
+static int bench_trace_codec(const char* path, int events) {
+    struct event_trace* trace = event_trace_create(path);
+    if (trace == NULL) {
+        fprintf(stderr, "trace: cannot create %s\n", path);
+        return 1;
+    }
+    AInputQueue* queue = host_input_queue_create();
+    struct event_trace_motion* motion = (struct event_trace_motion*)malloc(sizeof(struct event_trace_motion));
+    ASensorEvent sensors[BENCH_TRACE_SENSOR_BATCH];
+    int64_t baseNs = host_now_ns();
+    int64_t motionNs = 0;
+    int64_t sensorNs = 0;
+    for (int i = 0; i < events; i++) {
+        bench_trace_motion(i, baseNs, motion);
+        host_input_push_motion_at(queue, motion->action, motion->source, motion->deviceId,
+                motion->pointerCount, motion->pointerId, motion->sampleCount, motion->eventTime,
+                &motion->x[0][0], &motion->y[0][0], &motion->pressure[0][0], EVENT_TRACE_MAX_POINTERS);
+        AInputEvent* event = NULL;
+        AInputQueue_getEvent(queue, &event);
+        int64_t t = host_now_ns();
+        event_trace_record_input(trace, event);
+        motionNs += host_now_ns() - t;
+        AInputQueue_finishEvent(queue, event, 1);
+
+        for (int s = 0; s < BENCH_TRACE_SENSOR_BATCH; s++) {
+            bench_trace_sensor(i * BENCH_TRACE_SENSOR_BATCH + s, baseNs, &sensors[s]);
+        }
+        t = host_now_ns();
+        event_trace_record_sensors(trace, sensors, BENCH_TRACE_SENSOR_BATCH);
+        sensorNs += host_now_ns() - t;
+
+        if (i % 64 == 0) {
+            const int32_t args[3] = { 720, 1280 + i, WINDOW_FORMAT_RGBA_8888 };
+            event_trace_record_cmd(trace, APP_CMD_WINDOW_RESIZED, args, 3);
+        }
+    }
+    host_input_queue_destroy(queue);
+    struct event_trace_stats stats;
+    event_trace_close(trace, &stats);
+    struct event_trace_reader* reader = event_trace_open(path);
+
+    // Relecture dans l'ordre d'criture.
+    int mismatches = 0;
+    int motions = 0;
+    int sensorEvents = 0;
+    int commands = 0;
+    struct event_trace_record* record = (struct event_trace_record*)malloc(sizeof(struct event_trace_record));
+    int result;
+    while (reader != NULL && (result = event_trace_next(reader, record)) > 0) {
+        switch (record->type) {
+            case EVENT_TRACE_MOTION:
+                bench_trace_motion(motions++, baseNs, motion);
+                mismatches += !bench_trace_same_motion(motion, &record->motion);
+                break;
+            case EVENT_TRACE_SENSOR:
+                for (uint32_t s = 0; s < record->sensorCount; s++) {
+                    bench_trace_sensor(sensorEvents++, baseNs, &sensors[0]);
+                    const struct event_trace_sensor* sensor = &record->sensors[s];
+                    mismatches += sensor->type != sensors[0].type || sensor->timestamp != sensors[0].timestamp
+                            || memcmp(sensor->values, sensors[0].data, sizeof(sensor->values)) != 0;
+                }
+                break;
+            case EVENT_TRACE_CMD:
+                mismatches += record->cmd != APP_CMD_WINDOW_RESIZED || record->argCount != 3
+                        || record->args[1] != 1280 + commands * 64;
+                commands++;
+                break;
+            default:
+                mismatches++;
+                break;
+        }
+    }
+    if (reader == NULL || result < 0 || motions != events || sensorEvents != events * BENCH_TRACE_SENSOR_BATCH
+            || commands != (events + 63) / 64) {
+        fprintf(stderr, "trace: read back %d motions, %d sensor events, %d commands (result %d)\n",
+                motions, sensorEvents, commands, reader != NULL ? result : -1);
+        mismatches++;
+    }
+    event_trace_reader_close(reader);
+    free(record);
+    free(motion);
+    unlink(path);
+
+    double motionCost = motionNs / (double)events;
+    double sensorCost = sensorNs / (double)(events * BENCH_TRACE_SENSOR_BATCH);
+    double eventCount = events * (1.0 + BENCH_TRACE_SENSOR_BATCH);
+    double ratio = stats.compressedBytes > 0 ? stats.rawBytes / (double)stats.compressedBytes : 0.0;
+    printf("trace: record motion %.1f ns (%d pointers, %d samples), sensor %.1f ns/event, stalls=%llu\n",
+            motionCost, BENCH_TRACE_POINTERS, BENCH_TRACE_HISTORY + 1, sensorCost,
+            (unsigned long long)stats.stalls);
+    printf("trace: %d motions + %d sensor events: encoded %.1f bytes/event, written %.1f bytes/event "
+            "(zlib ratio %.2f, %llu blocks), mismatches=%d\n", events, events * BENCH_TRACE_SENSOR_BATCH,
+            stats.rawBytes / eventCount, stats.compressedBytes / eventCount, ratio,
+            (unsigned long long)stats.blocks, mismatches);
+    bench_result("trace", "record_motion", "ns", motionCost);
+    bench_result("trace", "record_sensor", "ns", sensorCost);
+    bench_result("trace", "encoded_per_event", "bytes", stats.rawBytes / eventCount);
+    bench_result("trace", "written_per_event", "bytes", stats.compressedBytes / eventCount);
+    bench_result("trace", "compression_ratio", "x", ratio);
+    return mismatches;
+}
+
+static void bench_trace_engine_hook(ANativeActivity* activity) {
+    __atomic_store_n(&bench_app.engineActivity, activity, __ATOMIC_RELEASE);
+}
+
+/**
+ * Session du moteur enregistre dans root (fichier record_events) : cycle de vie
+ * complet, BENCH_TRACE_TOUCHES touchers et chantillons d'acclromtre espacs
+ * de 4 ms. Retourne le nombre de commandes de la trace, ou -1.
+ */
+static int bench_trace_record_session(const char* root, const char* tracePath) {
+    char triggerPath[PATH_MAX];
+    snprintf(triggerPath, sizeof(triggerPath), "%s/record_events", root);
+    int fd = open(triggerPath, O_WRONLY | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return -1;
+    }
+    close(fd);
+
+    ANativeActivity* activity = host_activity_create(root);
+    bench_trace_engine_hook(activity);
+    ANativeActivity_onCreate(activity, NULL, 0);
+    activity->callbacks->onStart(activity);
+    activity->callbacks->onResume(activity);
+    AInputQueue* queue = host_input_queue_create();
+    activity->callbacks->onInputQueueCreated(activity, queue);
+    ANativeWindow* window = host_window_create(720, 1280, WINDOW_FORMAT_RGBA_8888);
+    activity->callbacks->onNativeWindowCreated(activity, window);
+    activity->callbacks->onWindowFocusChanged(activity, 1);
+    for (int i = 0; i < BENCH_TRACE_TOUCHES; i++) {
+        float xy[2] = { 100.0f + i, 200.0f + i * 0.5f };
+        host_input_push_motion(queue, i == 0 ? AMOTION_EVENT_ACTION_DOWN : AMOTION_EVENT_ACTION_MOVE, 1, xy, 4);
+        host_sensor_push(ASENSOR_TYPE_ACCELEROMETER, 0.1f * i, 9.81f, 0.0f);
+        usleep(4000);
+    }
+    // Comme le rejeu : entres termines et chantillons signals lus avant la perte du focus.
+    int64_t deadline = host_now_ns() + 1000000000LL;
+    while ((host_input_queue_pending(queue) > 0 || host_sensor_pending() > 0) && host_now_ns() < deadline) {
+        sched_yield();
+    }
+    activity->callbacks->onWindowFocusChanged(activity, 0);
+    activity->callbacks->onPause(activity);
+    activity->callbacks->onStop(activity);
+    activity->callbacks->onNativeWindowDestroyed(activity, window);
+    ANativeWindow_release(window);
+    activity->callbacks->onInputQueueDestroyed(activity, queue);
+    host_input_queue_destroy(queue);
+    bench_engine_destroy(activity);
+    unlink(triggerPath);
+
+    // Commandes enregistres, relues dans la trace.
+    struct event_trace_reader* reader = event_trace_open(tracePath);
+    if (reader == NULL) {
+        return -1;
+    }
+    struct event_trace_record* record = (struct event_trace_record*)malloc(sizeof(struct event_trace_record));
+    int commands = 0;
+    int result;
+    while ((result = event_trace_next(reader, record)) > 0) {
+        commands += record->type == EVENT_TRACE_CMD;
+    }
+    free(record);
+    event_trace_reader_close(reader);
+    return result == 0 ? commands : -1;
+}
+
+/**
+ * Rejeu de la session  speed : retourne 0 si les mmes commandes, les mmes
+ * vnements d'entre et les mmes lectures de l'acclromtre sont rejous, et
+ * si chaque entre injecte est termine.
+ */
+static int bench_trace_replay(const char* name, const char* root, const char* tracePath, float speed,
+        int commands, const struct host_counters* recorded) {
+    struct host_counters before;
+    host_counters_get(&before);
+    struct host_replay_stats stats;
+    host_replay_set_create_hook(bench_trace_engine_hook);
+    int result = host_replay_run(tracePath, root, speed, &stats);
+    host_replay_set_create_hook(NULL);
+    __atomic_store_n(&bench_app.engineActivity, (ANativeActivity*)NULL, __ATOMIC_RELEASE);
+    struct host_counters after;
+    host_counters_get(&after);
+
+    uint64_t injected = after.inputEvents - before.inputEvents;
+    uint64_t finished = after.inputFinished - before.inputFinished;
+    uint64_t sensorRead = after.sensorRead - before.sensorRead;
+    bench_engine_quiet(0);
+    printf("trace/%s: %.1f ms, commands=%llu/%d inputs=%llu/%llu finished=%llu/%llu sensor_read=%llu/%llu "
+            "skipped=%llu unsettled=%llu max_late=%.1f us\n", name, stats.durationNs / 1e6,
+            (unsigned long long)stats.commands, commands, (unsigned long long)injected,
+            (unsigned long long)recorded->inputEvents, (unsigned long long)finished,
+            (unsigned long long)injected, (unsigned long long)sensorRead,
+            (unsigned long long)recorded->sensorRead, (unsigned long long)stats.skipped,
+            (unsigned long long)stats.unsettled, stats.maxLateNs / 1e3);
+    bench_engine_quiet(1);
+    bench_result("trace", name, "ms", stats.durationNs / 1e6);
+    return result != 0 || stats.commands != (uint64_t)commands || stats.skipped != 0
+            || stats.unsettled != 0 || injected != recorded->inputEvents || finished != injected
+            || sensorRead != recorded->sensorRead;
+}
+
+static int bench_trace_engine(void) {
+    char root[] = "/tmp/host_bench.XXXXXX";
+    if (mkdtemp(root) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+    char tracePath[PATH_MAX];
+    snprintf(tracePath, sizeof(tracePath), "%s/events.trace", root);
+
+    bench_engine_quiet(1);
+    struct host_counters before;
+    host_counters_get(&before);
+    int64_t start = host_now_ns();
+    int commands = bench_trace_record_session(root, tracePath);
+    int64_t recordNs = host_now_ns() - start;
+    struct host_counters after;
+    host_counters_get(&after);
+    struct host_counters recorded;
+    memset(&recorded, 0, sizeof(recorded));
+    recorded.inputEvents = after.inputEvents - before.inputEvents;
+    recorded.inputFinished = after.inputFinished - before.inputFinished;
+    recorded.sensorRead = after.sensorRead - before.sensorRead;
+
+    int failed = commands <= 0;
+    if (!failed) {
+        bench_engine_quiet(0);
+        printf("trace/record: %.1f ms, commands=%d inputs=%llu sensor_read=%llu\n", recordNs / 1e6,
+                commands, (unsigned long long)recorded.inputEvents, (unsigned long long)recorded.sensorRead);
+        bench_engine_quiet(1);
+        failed |= bench_trace_replay("replay", root, tracePath, 1.0f, commands, &recorded);
+        failed |= bench_trace_replay("replay_fast", root, tracePath, 0.0f, commands, &recorded);
+    }
+    bench_engine_quiet(0);
+    bench_result("trace", "record", "ms", recordNs / 1e6);
+
+    char command[64];
+    snprintf(command, sizeof(command), "rm -rf %s", root);
+    if (system(command) != 0) {
+        fprintf(stderr, "trace: unable to remove %s\n", root);
+    }
+    if (failed) {
+        fprintf(stderr, "trace: the replayed session differs from the recorded one\n");
+    }
+    return failed;
+}
+
+static int bench_trace(int iterations) {
+    int events = iterations < BENCH_TRACE_MAX_EVENTS ? iterations : BENCH_TRACE_MAX_EVENTS;
+    if (events < 1) events = 1;
+    char path[] = "/tmp/host_bench_trace.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+    int result = bench_trace_codec(path, events) != 0;
+    if (result) {
+        fprintf(stderr, "trace: records read back differ from the recorded ones\n");
+    }
+    result |= bench_trace_engine();
+    return result;
+}
+
+// --------------------------------------------------------------------
+// Traces systme
+// --------------------------------------------------------------------
+
+/**
+ * Bilan de la vrification d'un export.
+ */
+struct bench_systrace_check {
+    int events;
+    int spans;
+    int counters;
+    int asyncBegins;
+    int asyncEnds;
+
+    // Instant dcroissant, fin sans dbut sur son thread, fin asynchrone sans
+    // dbut, tranche encore ouverte  la fin, ligne illisible.
+    int unsorted;
+    int unmatched;
+    int asyncUnmatched;
+    int open;
+    int malformed;
+};
+
+struct bench_systrace_async {
+    char name[64];
+    long long id;
+};
+
+// Valeur de la chane qui suit key dans line, copie dans out.
+static int bench_systrace_string(const char* line, const char* key, char* out, size_t size) {
+    const char* value = strstr(line, key);
+    if (value == NULL) {
+        return 0;
+    }
+    value += strlen(key);
+    size_t length = strcspn(value, "\"");
+    if (length >= size) length = size - 1;
+    memcpy(out, value, length);
+    out[length] = '\0';
+    return 1;
+}
+
+/**
+ * Relit l'export path, une entre par ligne, et vrifie l'ordre, l'appariement
+ * des tranches de chaque thread et celui des tranches asynchrones. names est
+ * une liste termine par NULL de noms qui doivent tre prsents ; found reoit
+ * leur nombre d'apparitions. Retourne -1 si le fichier n'est pas un export.
+ */
+static int bench_systrace_check(const char* path, const char* const* names, int* found,
+        struct bench_systrace_check* check) {
+    memset(check, 0, sizeof(*check));
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return -1;
+    }
+    char* line = (char*)malloc(BENCH_SYSTRACE_MAX_LINE);
+    struct bench_systrace_async* async = (struct bench_systrace_async*)calloc(BENCH_SYSTRACE_MAX_ASYNC,
+            sizeof(struct bench_systrace_async));
+    int asyncCount = 0;
+    int tids[SYS_TRACE_MAX_THREADS];
+    int depths[SYS_TRACE_MAX_THREADS];
+    int threadCount = 0;
+    double lastTs = -1.0;
+    int header = 0;
+    int footer = 0;
+    for (int i = 0; names[i] != NULL; i++) {
+        found[i] = 0;
+    }
+    while (fgets(line, BENCH_SYSTRACE_MAX_LINE, file) != NULL) {
+        if (strncmp(line, "{\"displayTimeUnit\"", 18) == 0) {
+            header = 1;
+        }
+        if (strcmp(line, "]}\n") == 0) {
+            footer = 1;
+            continue;
+        }
+        char phase[4];
+        char name[64] = "";
+        if (!bench_systrace_string(line, "\"ph\":\"", phase, sizeof(phase))) {
+            continue;
+        }
+        if (phase[0] == 'M') {
+            continue;
+        }
+        bench_systrace_string(line, "\"name\":\"", name, sizeof(name));
+        const char* ts = strstr(line, "\"ts\":");
+        const char* tidText = strstr(line, "\"tid\":");
+        if (ts == NULL || tidText == NULL) {
+            check->malformed++;
+            continue;
+        }
+        check->events++;
+        double time = strtod(ts + 5, NULL);
+        if (time < lastTs) {
+            check->unsorted++;
+        }
+        lastTs = time;
+        int tid = atoi(tidText + 6);
+        int thread = 0;
+        while (thread < threadCount && tids[thread] != tid) {
+            thread++;
+        }
+        if (thread == threadCount && threadCount < SYS_TRACE_MAX_THREADS) {
+            tids[threadCount] = tid;
+            depths[threadCount++] = 0;
+        }
+        for (int i = 0; names[i] != NULL; i++) {
+            found[i] += strcmp(name, names[i]) == 0;
+        }
+        const char* idText = strstr(line, "\"id\":");
+        long long id = idText != NULL ? atoll(idText + 5) : 0;
+        switch (phase[0]) {
+            case 'B':
+                check->spans++;
+                if (thread < threadCount) depths[thread]++;
+                break;
+            case 'E':
+                if (thread < threadCount && depths[thread]-- == 0) {
+                    check->unmatched++;
+                    depths[thread] = 0;
+                }
+                break;
+            case 'C':
+                check->counters++;
+                break;
+            case 'b':
+                check->asyncBegins++;
+                if (asyncCount < BENCH_SYSTRACE_MAX_ASYNC) {
+                    snprintf(async[asyncCount].name, sizeof(async[asyncCount].name), "%s", name);
+                    async[asyncCount++].id = id;
+                }
+                break;
+            case 'e': {
+                check->asyncEnds++;
+                int match = 0;
+                while (match < asyncCount && (async[match].id != id || strcmp(async[match].name, name) != 0)) {
+                    match++;
+                }
+                if (match == asyncCount) {
+                    check->asyncUnmatched++;
+                } else {
+                    async[match] = async[--asyncCount];
+                }
+                break;
+            }
+            default:
+                check->malformed++;
+                break;
+        }
+    }
+    for (int i = 0; i < threadCount; i++) {
+        check->open += depths[i];
+    }
+    fclose(file);
+    free(async);
+    free(line);
+    return header && footer ? 0 : -1;
+}
+
+static void bench_systrace_markers(int markers) {
+    struct host_counters before;
+    host_counters_get(&before);
+    int64_t start = host_now_ns();
+    for (int i = 0; i < markers; i++) {
+        SYS_TRACE_SCOPE("bench_span");
+    }
+    double spanCost = (host_now_ns() - start) / (double)markers;
+    start = host_now_ns();
+    for (int i = 0; i < markers; i++) {
+        SYS_TRACE_ASYNC_BEGIN("bench_async", i);
+        SYS_TRACE_ASYNC_END("bench_async", i);
+    }
+    double asyncCost = (host_now_ns() - start) / (double)markers;
+    start = host_now_ns();
+    for (int i = 0; i < markers; i++) {
+        SYS_TRACE_COUNTER("bench_counter", i);
+    }
+    double counterCost = (host_now_ns() - start) / (double)markers;
+    struct host_counters after;
+    host_counters_get(&after);
+    printf("systrace/markers: span=%.1f ns async=%.1f ns counter=%.1f ns atrace_sections=%llu\n",
+            spanCost, asyncCost, counterCost,
+            (unsigned long long)(after.traceSections - before.traceSections));
+    bench_result("systrace", "span", "ns", spanCost);
+    bench_result("systrace", "async_span", "ns", asyncCost);
+    bench_result("systrace", "counter", "ns", counterCost);
+}
+
+// Tranche extrieure, puis trois anneaux de tranches intrieures : le dbut de
+// l'extrieure est cras, sa fin doit disparatre de l'export.
+static void* bench_systrace_wrap_thread(void* param) {
+    SYS_TRACE_BEGIN("bench_outer");
+    for (int i = 0; i < SYS_TRACE_RING_EVENTS * 3 / 2; i++) {
+        SYS_TRACE_BEGIN("bench_inner");
+        SYS_TRACE_END();
+    }
+    SYS_TRACE_END();
+    return NULL;
+}
+
+static int bench_systrace_wrap(const char* root) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, bench_systrace_wrap_thread, NULL) != 0) {
+        return 1;
+    }
+    pthread_join(thread, NULL);
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/wrap.json", root);
+    int64_t start = host_now_ns();
+    int exported = sys_trace_export_json(path);
+    double exportMs = (host_now_ns() - start) / 1e6;
+    struct stat info;
+    double bytesPerEvent = exported > 0 && stat(path, &info) == 0 ? info.st_size / (double)exported : 0.0;
+
+    static const char* const names[] = { "bench_outer", "bench_inner", NULL };
+    int found[2];
+    struct bench_systrace_check check;
+    int failed = bench_systrace_check(path, names, found, &check) != 0;
+    failed |= exported <= 0 || check.unsorted > 0 || check.unmatched > 0 || check.malformed > 0;
+    // L'anneau du thread est repris par le suivant : ses marqueurs restent exports.
+    failed |= found[0] != 0 || found[1] < SYS_TRACE_RING_EVENTS / 2 - 1;
+    printf("systrace/wrap: exported=%d in %.1f ms (%.0f bytes/event) outer=%d inner=%d unsorted=%d unmatched=%d\n",
+            exported, exportMs, bytesPerEvent, found[0], found[1], check.unsorted, check.unmatched);
+    bench_result("systrace", "export", "ms", exportMs);
+    bench_result("systrace", "export_per_event", "bytes", bytesPerEvent);
+    if (failed) {
+        fprintf(stderr, "systrace: the wrapped ring export is not sorted or not balanced\n");
+    }
+    return failed;
+}
+
+/**
+ * Session du moteur dans root, export demand par le signal des mesures.
+ */
+static int bench_systrace_engine(const char* root) {
+    struct sys_trace_stats stats;
+    sys_trace_get_stats(&stats);
+    uint64_t exports = stats.exports;
+    struct host_counters before;
+    host_counters_get(&before);
+
+    bench_engine_quiet(1);
+    ANativeActivity* activity = host_activity_create(root);
+    __atomic_store_n(&bench_app.engineActivity, activity, __ATOMIC_RELEASE);
+    ANativeActivity_onCreate(activity, NULL, 0);
+    activity->callbacks->onStart(activity);
+    activity->callbacks->onResume(activity);
+    AInputQueue* queue = host_input_queue_create();
+    activity->callbacks->onInputQueueCreated(activity, queue);
+    ANativeWindow* window = host_window_create(720, 1280, WINDOW_FORMAT_RGBA_8888);
+    activity->callbacks->onNativeWindowCreated(activity, window);
+    activity->callbacks->onWindowFocusChanged(activity, 1);
+    for (int i = 0; i < BENCH_SYSTRACE_TOUCHES; i++) {
+        float xy[2] = { 100.0f + i, 200.0f + i };
+        host_input_push_motion(queue, i == 0 ? AMOTION_EVENT_ACTION_DOWN : AMOTION_EVENT_ACTION_MOVE, 1, xy, 4);
+        usleep(4000);
+    }
+    int64_t signalTime = host_now_ns();
+    kill(getpid(), SIGUSR2);
+    int64_t deadline = signalTime + 2000000000LL;
+    do {
+        usleep(1000);
+        sys_trace_get_stats(&stats);
+    } while (stats.exports == exports && host_now_ns() < deadline);
+    double exportMs = (host_now_ns() - signalTime) / 1e6;
+    activity->callbacks->onWindowFocusChanged(activity, 0);
+    activity->callbacks->onPause(activity);
+    activity->callbacks->onStop(activity);
+    activity->callbacks->onNativeWindowDestroyed(activity, window);
+    ANativeWindow_release(window);
+    activity->callbacks->onInputQueueDestroyed(activity, queue);
+    host_input_queue_destroy(queue);
+    bench_engine_destroy(activity);
+    bench_engine_quiet(0);
+    struct host_counters after;
+    host_counters_get(&after);
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/spans.json", root);
+    static const char* const names[] = {
+        "ANativeActivity_onCreate", "onResume", "onNativeWindowCreated", "START", "RESUME",
+        "INIT_WINDOW", "GAINED_FOCUS", "drain_input", "frame", "update", "draw", "swap", "memory_kib", NULL
+    };
+    int found[sizeof(names) / sizeof(names[0]) - 1];
+    struct bench_systrace_check check;
+    int failed = stats.exports == exports || bench_systrace_check(path, names, found, &check) != 0;
+    if (!failed) {
+        failed |= check.unsorted > 0 || check.unmatched > 0 || check.malformed > 0 || check.asyncUnmatched > 0
+                || check.asyncBegins == 0;
+        for (size_t i = 0; i < sizeof(found) / sizeof(found[0]); i++) {
+            if (found[i] == 0) {
+                fprintf(stderr, "systrace: no '%s' marker in the engine export\n", names[i]);
+                failed = 1;
+            }
+        }
+        printf("systrace/engine: events=%d spans=%d counters=%d async=%d/%d open=%d frames=%d export=%.1f ms\n",
+                check.events, check.spans, check.counters, check.asyncEnds, check.asyncBegins, check.open,
+                found[8], exportMs);
+        bench_result("systrace", "engine_events", "count", check.events);
+    }
+    uint64_t unbalanced = after.traceUnbalanced - before.traceUnbalanced;
+    printf("systrace/atrace: sections=%llu async=%llu counters=%llu unbalanced=%llu\n",
+            (unsigned long long)(after.traceSections - before.traceSections),
+            (unsigned long long)(after.traceAsync - before.traceAsync),
+            (unsigned long long)(after.traceCounters - before.traceCounters), (unsigned long long)unbalanced);
+    failed |= unbalanced != 0 || after.traceSections == before.traceSections;
+    if (failed) {
+        fprintf(stderr, "systrace: the engine export is incomplete or not balanced\n");
+    }
+    return failed;
+}
+
+static int bench_systrace(int iterations) {
+    int markers = iterations * 10 < BENCH_SYSTRACE_MAX_MARKERS ? iterations * 10 : BENCH_SYSTRACE_MAX_MARKERS;
+    if (markers < 1) markers = 1;
+    char root[] = "/tmp/host_bench.XXXXXX";
+    if (mkdtemp(root) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+    bench_systrace_markers(markers);
+    int failed = bench_systrace_wrap(root);
+    failed |= bench_systrace_engine(root);
+
+    char command[64];
+    snprintf(command, sizeof(command), "rm -rf %s", root);
+    if (system(command) != 0) {
+        fprintf(stderr, "systrace: unable to remove %s\n", root);
+    }
+    return failed;
+}
+
+// --------------------------------------------------------------------
+// bus : distribution d'event_bus.h
+// --------------------------------------------------------------------
+
+struct bench_bus {
+    uint64_t calls;
+    uint64_t sum;
+    // Dernier abonn appel pour l'vnement en cours.
+    int last;
+    uint64_t misordered;
+};
+
+// Hors ligne, comme un abonn d'une autre unit de compilation : sinon les 48 corps
+// dvelopps dans la fonction d'une cl se fondent en une seule addition.
+template <size_t N>
+__attribute__((noinline)) static void bench_bus_handler(struct bench_bus* bus, const struct event_bus_cmd* event) {
+    bus->calls++;
+    bus->sum += (uint64_t)(N + 1) * (uint64_t)(event->key + 1);
+    bus->misordered += (int)N <= bus->last;
+    bus->last = (int)N;
+}
+
+// Abonns pars : quatre cls chacun ; sinon toutes les cls.
+static constexpr uint32_t bench_bus_mask(int sparse, size_t n) {
+    return sparse ? EVENT_BUS_KEY(n % 32) | EVENT_BUS_KEY((n * 7 + 3) % 32) | EVENT_BUS_KEY((n * 13 + 5) % 32)
+            | EVENT_BUS_KEY((n * 5 + 11) % 32) : EVENT_BUS_ALL;
+}
+
+template <int Sparse, typename Sequence>
+struct bench_bus_type;
+
+template <int Sparse, size_t... N>
+struct bench_bus_type<Sparse, std::index_sequence<N...>> {
+    typedef event_bus<struct bench_bus, struct event_bus_cmd,
+            event_bus_handler<bench_bus_mask(Sparse, N), decltype(&bench_bus_handler<N>),
+                    &bench_bus_handler<N>>...> type;
+};
+
+// Rfrence : abonns enregistrs  l'excution, parcourus  chaque vnement.
+struct bench_bus_entry {
+    uint32_t mask;
+    void (*function)(struct bench_bus* bus, const struct event_bus_cmd* event);
+};
+
+static struct bench_bus_entry bench_bus_list[BENCH_BUS_SUBSCRIBERS];
+
+template <size_t... N>
+static void bench_bus_fill_list(int sparse, std::index_sequence<N...>) {
+    const struct bench_bus_entry entries[] = { { bench_bus_mask(sparse, N), &bench_bus_handler<N> }... };
+    memcpy(bench_bus_list, entries, sizeof(entries));
+}
+
+static void bench_bus_list_dispatch(struct bench_bus* bus, const struct event_bus_cmd* event) {
+    for (int i = 0; i < BENCH_BUS_SUBSCRIBERS; i++) {
+        if ((bench_bus_list[i].mask >> event->key) & 1u) {
+            bench_bus_list[i].function(bus, event);
+        }
+    }
+}
+
+// Appels et somme attendus, d'aprs la liste.
+static void bench_bus_expected(const int32_t* keys, int events, struct bench_bus* outExpected) {
+    memset(outExpected, 0, sizeof(*outExpected));
+    for (int i = 0; i < events; i++) {
+        int32_t key = keys[i % BENCH_BUS_KEY_SEQUENCE];
+        for (int n = 0; n < BENCH_BUS_SUBSCRIBERS; n++) {
+            if ((bench_bus_list[n].mask >> key) & 1u) {
+                outExpected->calls++;
+                outExpected->sum += (uint64_t)(n + 1) * (uint64_t)(key + 1);
+            }
+        }
+    }
+}
+
+template <int Sparse>
+static int bench_bus_run(const char* name, const int32_t* keys, int events) {
+    typedef typename bench_bus_type<Sparse, std::make_index_sequence<BENCH_BUS_SUBSCRIBERS>>::type bus_type;
+    bench_bus_fill_list(Sparse, std::make_index_sequence<BENCH_BUS_SUBSCRIBERS>());
+    struct bench_bus expected;
+    bench_bus_expected(keys, events, &expected);
+
+    struct bench_bus bus;
+    memset(&bus, 0, sizeof(bus));
+    struct event_bus_cmd event;
+    int64_t start = host_now_ns();
+    for (int i = 0; i < events; i++) {
+        event.key = keys[i % BENCH_BUS_KEY_SEQUENCE];
+        bus.last = -1;
+        bus_type::dispatch(&bus, &event);
+    }
+    double busCost = (host_now_ns() - start) / (double)events;
+
+    struct bench_bus list;
+    memset(&list, 0, sizeof(list));
+    start = host_now_ns();
+    for (int i = 0; i < events; i++) {
+        event.key = keys[i % BENCH_BUS_KEY_SEQUENCE];
+        list.last = -1;
+        bench_bus_list_dispatch(&list, &event);
+    }
+    double listCost = (host_now_ns() - start) / (double)events;
+
+    // Cls sans abonn possible.
+    uint64_t calls = bus.calls;
+    const int32_t outside[] = { -1, EVENT_BUS_KEYS, 40 };
+    for (size_t i = 0; i < sizeof(outside) / sizeof(outside[0]); i++) {
+        event.key = outside[i];
+        bus_type::dispatch(&bus, &event);
+    }
+    int stray = bus.calls != calls;
+
+    double perEvent = expected.calls / (double)events;
+    printf("bus/%s: subscribers=%d calls/event=%.1f bus=%.1f ns/event (%.2f ns/call) list=%.1f ns/event "
+            "(%.2f ns/call)\n", name, BENCH_BUS_SUBSCRIBERS, perEvent, busCost, busCost / perEvent, listCost,
+            listCost / perEvent);
+    char metric[32];
+    snprintf(metric, sizeof(metric), "%s_event", name);
+    bench_result("bus", metric, "ns", busCost);
+    snprintf(metric, sizeof(metric), "%s_list_event", name);
+    bench_result("bus", metric, "ns", listCost);
+
+    int failed = stray || bus.misordered != 0 || bus.calls != expected.calls || bus.sum != expected.sum
+            || list.calls != expected.calls || list.sum != expected.sum;
+    if (failed) {
+        fprintf(stderr, "bus/%s: calls=%llu/%llu list=%llu misordered=%llu stray=%d\n", name,
+                (unsigned long long)bus.calls, (unsigned long long)expected.calls,
+                (unsigned long long)list.calls, (unsigned long long)bus.misordered, stray);
+    }
+    return failed;
+}
+
+static int bench_bus(int iterations) {
+    int events = iterations < BENCH_BUS_MAX_EVENTS / 100 ? iterations * 100 : BENCH_BUS_MAX_EVENTS;
+    if (events < 1) events = 1;
+    int32_t keys[BENCH_BUS_KEY_SEQUENCE];
+    uint32_t seed = 12345;
+    for (int i = 0; i < BENCH_BUS_KEY_SEQUENCE; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        keys[i] = (int32_t)(seed >> 27);
+    }
+    int failed = bench_bus_run<1>("sparse", keys, events);
+    failed |= bench_bus_run<0>("broadcast", keys, events);
+    if (failed) {
+        fprintf(stderr, "bus: a subscriber was called wrongly, missed or out of order\n");
+    }
+    return failed;
+}
+
+// --------------------------------------------------------------------
+// Rapport JSON
+// --------------------------------------------------------------------
+
+static int bench_write_json(const char* path, int iterations, int burst) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "cannot write '%s'\n", path);
+        return -1;
+    }
+    fprintf(file, "{\n  \"suite\": \"host_bench\",\n  \"version\": 1,\n");
+    fprintf(file, "  \"timestamp\": %lld,\n", (long long)time(NULL));
+    fprintf(file, "  \"iterations\": %d,\n  \"burst\": %d,\n", iterations, burst);
+    fprintf(file, "  \"cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+    fprintf(file, "  \"results\": [");
+    for (int i = 0; i < bench_result_count; i++) {
+        const struct bench_result* result = &bench_results[i];
+        // Les noms sont des identifiants du programme : aucun chappement n'est ncessaire.
+        fprintf(file, "%s\n    { \"benchmark\": \"%s\", \"metric\": \"%s\", \"unit\": \"%s\", "
+                "\"value\": %.6g }", i > 0 ? "," : "", result->benchmark, result->metric,
+                result->unit, isfinite(result->value) ? result->value : 0.0);
+    }
+    fprintf(file, "\n  ]\n}\n");
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+static const char* const bench_names[] = {
+    "cmd", "dispatch", "sensor", "input", "timing", "log", "snapshot", "journal", "asset", "save",
+    "lifecycle", "frame", "alloc", "raster", "resume", "config", "redraw", "resolution",
+    "jobs", "memory", "trace", "systrace", "bus",
+};
+
+static int bench_run(ANativeActivity* activity, const char* name, int iterations, int burst,
+        const char* tracePath, int speedup) {
+    if (strcmp(name, "cmd") == 0) {
+        bench_cmd(activity, iterations, burst);
+    } else if (strcmp(name, "dispatch") == 0) {
+        bench_dispatch(activity, iterations);
+    } else if (strcmp(name, "sensor") == 0) {
+        bench_sensor(activity, tracePath, speedup);
+    } else if (strcmp(name, "input") == 0) {
+        bench_input(activity, iterations);
+    } else if (strcmp(name, "timing") == 0) {
+        bench_timing_all(iterations * 10);
+    } else if (strcmp(name, "log") == 0) {
+        bench_log(iterations);
+    } else if (strcmp(name, "snapshot") == 0) {
+        return bench_snapshot(activity, iterations);
+    } else if (strcmp(name, "journal") == 0) {
+        return bench_journal(iterations);
+    } else if (strcmp(name, "asset") == 0) {
+        return bench_asset(activity, iterations);
+    } else if (strcmp(name, "save") == 0) {
+        bench_save(iterations);
+    } else if (strcmp(name, "lifecycle") == 0) {
+        bench_lifecycle(iterations);
+    } else if (strcmp(name, "frame") == 0) {
+        bench_frame(iterations);
+    } else if (strcmp(name, "alloc") == 0) {
+        return bench_alloc(iterations);
+    } else if (strcmp(name, "raster") == 0) {
+        return bench_raster(iterations);
+    } else if (strcmp(name, "resume") == 0) {
+        return bench_resume(iterations);
+    } else if (strcmp(name, "config") == 0) {
+        return bench_config(iterations);
+    } else if (strcmp(name, "redraw") == 0) {
+        return bench_redraw();
+    } else if (strcmp(name, "resolution") == 0) {
+        return bench_resolution();
+    } else if (strcmp(name, "jobs") == 0) {
+        return bench_jobs(iterations);
+    } else if (strcmp(name, "memory") == 0) {
+        return bench_memory(iterations);
+    } else if (strcmp(name, "trace") == 0) {
+        return bench_trace(iterations);
+    } else if (strcmp(name, "systrace") == 0) {
+        return bench_systrace(iterations);
+    } else if (strcmp(name, "bus") == 0) {
+        return bench_bus(iterations);
+    } else {
+        fprintf(stderr, "unknown benchmark '%s'\n", name);
+        return 2;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int iterations = 100000;
+    int burst = 3;
+    const char* tracePath = NULL;
+    const char* jsonPath = NULL;
+    int speedup = 10;
+    int option;
+    while ((option = getopt(argc, argv, "n:b:f:x:j:")) != -1) {
+        switch (option) {
+            case 'n':
+                iterations = atoi(optarg);
+                break;
+            case 'b':
+                burst = atoi(optarg);
+                break;
+            case 'f':
+                tracePath = optarg;
+                break;
+            case 'x':
+                speedup = atoi(optarg);
+                break;
+            case 'j':
+                jsonPath = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n iterations] [-b burst] [-f trace] [-x speedup] "
+                        "[-j json] [cmd|dispatch|sensor|input|timing|log|snapshot|journal|asset|save|lifecycle|frame|alloc|raster|resume|config|redraw|resolution|jobs|memory|trace|systrace|bus|all]...\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+    if (burst < 1) burst = 1;
+
+    bench_app.sendTimes = (int64_t*)calloc(BENCH_MAX_SAMPLES, sizeof(int64_t));
+    bench_app.latencies = (int64_t*)calloc(BENCH_MAX_SAMPLES, sizeof(int64_t));
+
+    ANativeActivity* activity = host_activity_create("/tmp");
+    ANativeActivity_onCreate(activity, NULL, 0);
+    activity->callbacks->onStart(activity);
+    activity->callbacks->onResume(activity);
+
+    int result = 0;
+    if (optind == argc) {
+        result = bench_run(activity, "cmd", iterations, burst, tracePath, speedup);
+    }
+    for (int i = optind; i < argc && result == 0; i++) {
+        if (strcmp(argv[i], "all") == 0) {
+            for (size_t j = 0; j < sizeof(bench_names) / sizeof(bench_names[0]); j++) {
+                if (bench_run(activity, bench_names[j], iterations, burst, tracePath, speedup) != 0) {
+                    result = 1;
+                }
+            }
+        } else {
+            result = bench_run(activity, argv[i], iterations, burst, tracePath, speedup);
+        }
+    }
+    if (result == 0 && jsonPath != NULL && bench_write_json(jsonPath, iterations, burst) != 0) {
+        result = 1;
+    }
+
+    activity->callbacks->onPause(activity);
+    activity->callbacks->onStop(activity);
+    activity->callbacks->onDestroy(activity);
+    host_activity_destroy(activity);
+
+    free(bench_app.sendTimes);
+    free(bench_app.latencies);
+    return result;
+}
@@ -0,0 +1,190 @@
+/*
+ * AConfiguration hte et activit simule.
+ *
+ * La configuration de l'appareil est un tat global protg par un mutex ;
+ * AConfiguration_fromAssetManager() en prend une copie. Le pilote la modifie
+ * entre host_config_lock() et host_config_unlock() avant de signaler
+ * onConfigurationChanged.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <android/configuration.h>
+#include <android/native_activity.h>
+
+#include "host_internal.h"
+
+struct AConfiguration {
+    int32_t mcc;
+    int32_t mnc;
+    char language[2];
+    char country[2];
+    int32_t orientation;
+    int32_t touchscreen;
+    int32_t density;
+    int32_t keyboard;
+    int32_t navigation;
+    int32_t keysHidden;
+    int32_t navHidden;
+    int32_t sdkVersion;
+    int32_t screenSize;
+    int32_t screenLong;
+    int32_t uiModeType;
+    int32_t uiModeNight;
+    int32_t screenWidthDp;
+    int32_t screenHeightDp;
+    int32_t smallestScreenWidthDp;
+    int32_t layoutDirection;
+};
+
+struct AAssetManager {
+    int unused;
+};
+
+static pthread_mutex_t config_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static AConfiguration config_device = {
+    208, 1, { 'f', 'r' }, { 'F', 'R' },
+    ACONFIGURATION_ORIENTATION_PORT, ACONFIGURATION_TOUCHSCREEN_FINGER,
+    ACONFIGURATION_DENSITY_XHIGH, ACONFIGURATION_KEYBOARD_NOKEYS,
+    ACONFIGURATION_NAVIGATION_NONAV, ACONFIGURATION_KEYSHIDDEN_YES,
+    ACONFIGURATION_NAVHIDDEN_YES, 26, ACONFIGURATION_SCREENSIZE_NORMAL,
+    ACONFIGURATION_SCREENLONG_YES, ACONFIGURATION_UI_MODE_TYPE_NORMAL,
+    ACONFIGURATION_UI_MODE_NIGHT_NO, 360, 640, 360, ACONFIGURATION_LAYOUTDIR_LTR,
+};
+
+static AAssetManager config_asset_manager;
+
+void host_config_lock(AConfiguration** outConfig) {
+    pthread_mutex_lock(&config_mutex);
+    *outConfig = &config_device;
+}
+
+void host_config_unlock(void) {
+    pthread_mutex_unlock(&config_mutex);
+}
+
+AConfiguration* AConfiguration_new(void) {
+    return (AConfiguration*)calloc(1, sizeof(AConfiguration));
+}
+
+void AConfiguration_delete(AConfiguration* config) {
+    free(config);
+}
+
+void AConfiguration_fromAssetManager(AConfiguration* out, AAssetManager* am) {
+    pthread_mutex_lock(&config_mutex);
+    *out = config_device;
+    pthread_mutex_unlock(&config_mutex);
+}
+
+void AConfiguration_copy(AConfiguration* dest, AConfiguration* src) {
+    *dest = *src;
+}
+
+int32_t AConfiguration_diff(AConfiguration* config1, AConfiguration* config2) {
+    int32_t diff = 0;
+    if (config1->mcc != config2->mcc) diff |= ACONFIGURATION_MCC;
+    if (config1->mnc != config2->mnc) diff |= ACONFIGURATION_MNC;
+    if (memcmp(config1->language, config2->language, 2) != 0
+            || memcmp(config1->country, config2->country, 2) != 0) {
+        diff |= ACONFIGURATION_LOCALE;
+    }
+    if (config1->orientation != config2->orientation) diff |= ACONFIGURATION_ORIENTATION;
+    if (config1->touchscreen != config2->touchscreen) diff |= ACONFIGURATION_TOUCHSCREEN;
+    if (config1->density != config2->density) diff |= ACONFIGURATION_DENSITY;
+    if (config1->keyboard != config2->keyboard) diff |= ACONFIGURATION_KEYBOARD;
+    if (config1->navigation != config2->navigation) diff |= ACONFIGURATION_NAVIGATION;
+    if (config1->keysHidden != config2->keysHidden
+            || config1->navHidden != config2->navHidden) {
+        diff |= ACONFIGURATION_KEYBOARD_HIDDEN;
+    }
+    if (config1->sdkVersion != config2->sdkVersion) diff |= ACONFIGURATION_VERSION;
+    if (config1->screenSize != config2->screenSize
+            || config1->screenWidthDp != config2->screenWidthDp
+            || config1->screenHeightDp != config2->screenHeightDp) {
+        diff |= ACONFIGURATION_SCREEN_SIZE;
+    }
+    if (config1->screenLong != config2->screenLong) diff |= ACONFIGURATION_SCREEN_LAYOUT;
+    if (config1->uiModeType != config2->uiModeType
+            || config1->uiModeNight != config2->uiModeNight) {
+        diff |= ACONFIGURATION_UI_MODE;
+    }
+    if (config1->smallestScreenWidthDp != config2->smallestScreenWidthDp) {
+        diff |= ACONFIGURATION_SMALLEST_SCREEN_SIZE;
+    }
+    if (config1->layoutDirection != config2->layoutDirection) diff |= ACONFIGURATION_LAYOUTDIR;
+    return diff;
+}
+
+void AConfiguration_getLanguage(AConfiguration* config, char* outLanguage) {
+    outLanguage[0] = config->language[0];
+    outLanguage[1] = config->language[1];
+}
+
+void AConfiguration_setLanguage(AConfiguration* config, const char* language) {
+    config->language[0] = language[0];
+    config->language[1] = language[1];
+}
+
+void AConfiguration_getCountry(AConfiguration* config, char* outCountry) {
+    outCountry[0] = config->country[0];
+    outCountry[1] = config->country[1];
+}
+
+void AConfiguration_setCountry(AConfiguration* config, const char* country) {
+    config->country[0] = country[0];
+    config->country[1] = country[1];
+}
+
+#define CONFIG_ACCESSORS(Name, field) \
+    int32_t AConfiguration_get##Name(AConfiguration* config) { \
+        return config->field; \
+    } \
+    void AConfiguration_set##Name(AConfiguration* config, int32_t value) { \
+        config->field = value; \
+    }
+
+CONFIG_ACCESSORS(Mcc, mcc)
+CONFIG_ACCESSORS(Mnc, mnc)
+CONFIG_ACCESSORS(Orientation, orientation)
+CONFIG_ACCESSORS(Touchscreen, touchscreen)
+CONFIG_ACCESSORS(Density, density)
+CONFIG_ACCESSORS(Keyboard, keyboard)
+CONFIG_ACCESSORS(Navigation, navigation)
+CONFIG_ACCESSORS(KeysHidden, keysHidden)
+CONFIG_ACCESSORS(NavHidden, navHidden)
+CONFIG_ACCESSORS(SdkVersion, sdkVersion)
+CONFIG_ACCESSORS(ScreenSize, screenSize)
+CONFIG_ACCESSORS(ScreenLong, screenLong)
+CONFIG_ACCESSORS(UiModeType, uiModeType)
+CONFIG_ACCESSORS(UiModeNight, uiModeNight)
+CONFIG_ACCESSORS(ScreenWidthDp, screenWidthDp)
+CONFIG_ACCESSORS(ScreenHeightDp, screenHeightDp)
+CONFIG_ACCESSORS(SmallestScreenWidthDp, smallestScreenWidthDp)
+CONFIG_ACCESSORS(LayoutDirection, layoutDirection)
+
+// --------------------------------------------------------------------
+// Activit simule
+// --------------------------------------------------------------------
+
+ANativeActivity* host_activity_create(const char* internalDataPath) {
+    ANativeActivity* activity = (ANativeActivity*)calloc(1, sizeof(ANativeActivity));
+    activity->callbacks = (ANativeActivityCallbacks*)calloc(1, sizeof(ANativeActivityCallbacks));
+    activity->internalDataPath = internalDataPath;
+    activity->externalDataPath = internalDataPath;
+    activity->sdkVersion = config_device.sdkVersion;
+    activity->assetManager = &config_asset_manager;
+    return activity;
+}
+
+void host_activity_destroy(ANativeActivity* activity) {
+    free(activity->callbacks);
+    free(activity);
+}
+
+void ANativeActivity_finish(ANativeActivity* activity) {
+    // Le pilote dcide seul de la destruction de l'activit.
+}
@@ -0,0 +1,117 @@
+/*
+ * Compteurs, horloge et interception des appels systme du runtime hte.
+ *
+ * read() et write() sont intercepts  l'dition des liens
+ * (-Wl,--wrap=read,--wrap=write) pour compter les appels systme par
+ * commande sans modifier le code de collage.
+ *
+ * Les fonctions d'allocation de la glibc sont remplaces par des versions qui
+ * comptent chaque allocation puis appellent l'implmentation d'origine
+ * (__libc_malloc...) : toutes les allocations du processus sont vues, y compris
+ * celles de la bibliothque C elle-mme, ce qui permet de vrifier qu'une image
+ * en rgime tabli n'en fait aucune.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "host_internal.h"
+
+struct host_counters host_counters_global;
+
+extern "C" ssize_t __real_read(int fd, void* buf, size_t count);
+extern "C" ssize_t __real_write(int fd, const void* buf, size_t count);
+
+extern "C" ssize_t __wrap_read(int fd, void* buf, size_t count) {
+    host_counter_add(&host_counters_global.reads, 1);
+    return __real_read(fd, buf, count);
+}
+
+extern "C" ssize_t __wrap_write(int fd, const void* buf, size_t count) {
+    host_counter_add(&host_counters_global.writes, 1);
+    return __real_write(fd, buf, count);
+}
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* data, size_t size);
+extern "C" void* __libc_memalign(size_t alignment, size_t size);
+extern "C" void __libc_free(void* data);
+
+// Compteur du thread courant : modle TLS local  l'excutable, sans allocation.
+static __thread uint64_t host_thread_allocation_count;
+
+static void host_count_allocation(size_t size) {
+    host_thread_allocation_count++;
+    host_counter_add(&host_counters_global.allocations, 1);
+    host_counter_add(&host_counters_global.allocatedBytes, size);
+}
+
+extern "C" void* malloc(size_t size) {
+    host_count_allocation(size);
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+    host_count_allocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* data, size_t size) {
+    host_count_allocation(size);
+    return __libc_realloc(data, size);
+}
+
+extern "C" void* memalign(size_t alignment, size_t size) {
+    host_count_allocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void* aligned_alloc(size_t alignment, size_t size) {
+    host_count_allocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void** out, size_t alignment, size_t size) {
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    host_count_allocation(size);
+    void* data = __libc_memalign(alignment, size);
+    if (data == NULL && size != 0) {
+        return ENOMEM;
+    }
+    *out = data;
+    return 0;
+}
+
+extern "C" void free(void* data) {
+    __libc_free(data);
+}
+
+uint64_t host_thread_allocations(void) {
+    return host_thread_allocation_count;
+}
+
+void host_counters_get(struct host_counters* out) {
+    const uint64_t* src = (const uint64_t*)&host_counters_global;
+    uint64_t* dst = (uint64_t*)out;
+    for (size_t i = 0; i < sizeof(struct host_counters) / sizeof(uint64_t); i++) {
+        dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    }
+}
+
+void host_counters_reset(void) {
+    uint64_t* dst = (uint64_t*)&host_counters_global;
+    for (size_t i = 0; i < sizeof(struct host_counters) / sizeof(uint64_t); i++) {
+        __atomic_store_n(&dst[i], 0, __ATOMIC_RELAXED);
+    }
+}
+
+int64_t host_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
@@ -0,0 +1,301 @@
+/*
+ * EGL hte.
+ *
+ * Les substituts n'effectuent aucun rendu : ils valident la squence d'appels
+ * du moteur (display_manager.h) et comptent les initialisations, contextes,
+ * surfaces et prsentations. Plusieurs configurations sont proposes, dans
+ * l'ordre de tri d'EGL : la premire qui convient a du multichantillonnage,
+ * de la profondeur et du stencil, la meilleure pour le moteur n'en a pas.
+ *
+ * Le pilote peut rendre EGL indisponible (host_egl_set_available()) ou faire
+ * perdre le contexte courant  la prochaine prsentation (host_egl_lose_context()).
+ *
+ * host_egl_check (make egl-check) n'utilise pas ce fichier : il vrifie
+ * display_manager contre l'EGL logiciel de Mesa.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+
+#include <android/native_window.h>
+
+#include "host_internal.h"
+
+struct host_egl_config {
+    EGLint id;
+    EGLint red;
+    EGLint green;
+    EGLint blue;
+    EGLint alpha;
+    EGLint depth;
+    EGLint stencil;
+    EGLint samples;
+    EGLint caveat;
+    EGLint surfaceType;
+    EGLint visual;
+};
+
+struct host_egl_surface {
+    // NULL pour une surface hors cran.
+    ANativeWindow* window;
+    EGLint width;
+    EGLint height;
+};
+
+struct host_egl_context {
+    int lost;
+};
+
+#define HOST_EGL_WINDOW_PBUFFER (EGL_WINDOW_BIT | EGL_PBUFFER_BIT)
+
+static const struct host_egl_config host_egl_configs[] = {
+    { 1, 8, 8, 8, 8, 24, 8, 4, EGL_NONE, HOST_EGL_WINDOW_PBUFFER, WINDOW_FORMAT_RGBA_8888 },
+    { 2, 8, 8, 8, 8, 24, 8, 0, EGL_NONE, HOST_EGL_WINDOW_PBUFFER, WINDOW_FORMAT_RGBA_8888 },
+    { 3, 8, 8, 8, 0, 16, 0, 0, EGL_NONE, EGL_WINDOW_BIT, WINDOW_FORMAT_RGBX_8888 },
+    { 4, 8, 8, 8, 0, 0, 0, 0, EGL_SLOW_CONFIG, HOST_EGL_WINDOW_PBUFFER, WINDOW_FORMAT_RGBX_8888 },
+    { 5, 8, 8, 8, 0, 0, 0, 0, EGL_NONE, HOST_EGL_WINDOW_PBUFFER, WINDOW_FORMAT_RGBX_8888 },
+    { 6, 5, 6, 5, 0, 0, 0, 0, EGL_NONE, HOST_EGL_WINDOW_PBUFFER, WINDOW_FORMAT_RGB_565 },
+};
+
+#define HOST_EGL_CONFIG_COUNT ((EGLint)(sizeof(host_egl_configs) / sizeof(host_egl_configs[0])))
+
+static int host_egl_display;
+static int host_egl_unavailable;
+static int host_egl_lose_pending;
+static EGLint host_egl_error = EGL_SUCCESS;
+static struct host_egl_context* host_egl_current;
+
+void host_egl_set_available(int available) {
+    host_egl_unavailable = !available;
+}
+
+void host_egl_lose_context(void) {
+    __atomic_store_n(&host_egl_lose_pending, 1, __ATOMIC_RELEASE);
+}
+
+static EGLBoolean host_egl_fail(EGLint error) {
+    host_egl_error = error;
+    return EGL_FALSE;
+}
+
+// --------------------------------------------------------------------
+// EGL
+// --------------------------------------------------------------------
+
+EGLint eglGetError(void) {
+    EGLint error = host_egl_error;
+    host_egl_error = EGL_SUCCESS;
+    return error;
+}
+
+EGLDisplay eglGetDisplay(EGLNativeDisplayType display_id) {
+    return (EGLDisplay)&host_egl_display;
+}
+
+EGLBoolean eglInitialize(EGLDisplay dpy, EGLint* major, EGLint* minor) {
+    if (host_egl_unavailable) {
+        return host_egl_fail(EGL_NOT_INITIALIZED);
+    }
+    host_counter_add(&host_counters_global.eglInits, 1);
+    if (major != NULL) *major = 1;
+    if (minor != NULL) *minor = 4;
+    return EGL_TRUE;
+}
+
+EGLBoolean eglTerminate(EGLDisplay dpy) {
+    return EGL_TRUE;
+}
+
+const char* eglQueryString(EGLDisplay dpy, EGLint name) {
+    switch (name) {
+        case EGL_VENDOR:
+            return "host";
+        case EGL_VERSION:
+            return "1.4 host";
+        case EGL_EXTENSIONS:
+            return "EGL_KHR_create_context EGL_KHR_surfaceless_context";
+        default:
+            host_egl_fail(EGL_BAD_PARAMETER);
+            return NULL;
+    }
+}
+
+static EGLint host_egl_config_value(const struct host_egl_config* config, EGLint attribute) {
+    switch (attribute) {
+        case EGL_CONFIG_ID: return config->id;
+        case EGL_RED_SIZE: return config->red;
+        case EGL_GREEN_SIZE: return config->green;
+        case EGL_BLUE_SIZE: return config->blue;
+        case EGL_ALPHA_SIZE: return config->alpha;
+        case EGL_DEPTH_SIZE: return config->depth;
+        case EGL_STENCIL_SIZE: return config->stencil;
+        case EGL_SAMPLES: return config->samples;
+        case EGL_SAMPLE_BUFFERS: return config->samples > 0;
+        case EGL_CONFIG_CAVEAT: return config->caveat;
+        case EGL_SURFACE_TYPE: return config->surfaceType;
+        case EGL_RENDERABLE_TYPE: return EGL_OPENGL_ES_BIT | EGL_OPENGL_ES2_BIT;
+        case EGL_NATIVE_VISUAL_ID: return config->visual;
+        default: return 0;
+    }
+}
+
+// Une configuration convient si elle a au moins les tailles demandes et tous
+// les bits des masques demands.
+static int host_egl_config_matches(const struct host_egl_config* config, const EGLint* attribs) {
+    for (; attribs != NULL && attribs[0] != EGL_NONE; attribs += 2) {
+        EGLint value = host_egl_config_value(config, attribs[0]);
+        switch (attribs[0]) {
+            case EGL_SURFACE_TYPE:
+            case EGL_RENDERABLE_TYPE:
+                if ((value & attribs[1]) != attribs[1]) return 0;
+                break;
+            default:
+                if (value < attribs[1]) return 0;
+                break;
+        }
+    }
+    return 1;
+}
+
+EGLBoolean eglChooseConfig(EGLDisplay dpy, const EGLint* attrib_list,
+        EGLConfig* configs, EGLint config_size, EGLint* num_config) {
+    EGLint count = 0;
+    for (EGLint i = 0; i < HOST_EGL_CONFIG_COUNT; i++) {
+        if (!host_egl_config_matches(&host_egl_configs[i], attrib_list)) {
+            continue;
+        }
+        if (configs != NULL && count < config_size) {
+            configs[count] = (EGLConfig)&host_egl_configs[i];
+        }
+        count++;
+    }
+    *num_config = configs != NULL && count > config_size ? config_size : count;
+    return EGL_TRUE;
+}
+
+EGLBoolean eglGetConfigAttrib(EGLDisplay dpy, EGLConfig config,
+        EGLint attribute, EGLint* value) {
+    *value = host_egl_config_value((const struct host_egl_config*)config, attribute);
+    return EGL_TRUE;
+}
+
+EGLSurface eglCreateWindowSurface(EGLDisplay dpy, EGLConfig config,
+        EGLNativeWindowType win, const EGLint* attrib_list) {
+    if (win == NULL) {
+        host_egl_fail(EGL_BAD_NATIVE_WINDOW);
+        return EGL_NO_SURFACE;
+    }
+    struct host_egl_surface* surface =
+            (struct host_egl_surface*)calloc(1, sizeof(struct host_egl_surface));
+    surface->window = win;
+    host_counter_add(&host_counters_global.eglSurfaces, 1);
+    return (EGLSurface)surface;
+}
+
+EGLSurface eglCreatePbufferSurface(EGLDisplay dpy, EGLConfig config, const EGLint* attrib_list) {
+    struct host_egl_surface* surface =
+            (struct host_egl_surface*)calloc(1, sizeof(struct host_egl_surface));
+    for (; attrib_list != NULL && attrib_list[0] != EGL_NONE; attrib_list += 2) {
+        if (attrib_list[0] == EGL_WIDTH) surface->width = attrib_list[1];
+        if (attrib_list[0] == EGL_HEIGHT) surface->height = attrib_list[1];
+    }
+    host_counter_add(&host_counters_global.eglSurfaces, 1);
+    return (EGLSurface)surface;
+}
+
+EGLBoolean eglDestroySurface(EGLDisplay dpy, EGLSurface surface) {
+    free(surface);
+    return EGL_TRUE;
+}
+
+EGLBoolean eglQuerySurface(EGLDisplay dpy, EGLSurface surface,
+        EGLint attribute, EGLint* value) {
+    const struct host_egl_surface* hostSurface = (const struct host_egl_surface*)surface;
+    ANativeWindow* window = hostSurface->window;
+    switch (attribute) {
+        case EGL_WIDTH:
+            *value = window != NULL ? ANativeWindow_getWidth(window) : hostSurface->width;
+            return EGL_TRUE;
+        case EGL_HEIGHT:
+            *value = window != NULL ? ANativeWindow_getHeight(window) : hostSurface->height;
+            return EGL_TRUE;
+        default:
+            return host_egl_fail(EGL_BAD_ATTRIBUTE);
+    }
+}
+
+EGLContext eglCreateContext(EGLDisplay dpy, EGLConfig config,
+        EGLContext share_context, const EGLint* attrib_list) {
+    host_counter_add(&host_counters_global.eglContexts, 1);
+    return (EGLContext)calloc(1, sizeof(struct host_egl_context));
+}
+
+EGLBoolean eglDestroyContext(EGLDisplay dpy, EGLContext ctx) {
+    if (host_egl_current == (struct host_egl_context*)ctx) {
+        host_egl_current = NULL;
+    }
+    // Un seul contexte  la fois : ses objets disparaissent avec lui.
+    host_gles_release();
+    free(ctx);
+    return EGL_TRUE;
+}
+
+EGLBoolean eglMakeCurrent(EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx) {
+    struct host_egl_context* context = (struct host_egl_context*)ctx;
+    if (context != NULL && context->lost) {
+        return host_egl_fail(EGL_CONTEXT_LOST);
+    }
+    host_egl_current = context;
+    return EGL_TRUE;
+}
+
+EGLBoolean eglSwapBuffers(EGLDisplay dpy, EGLSurface surface) {
+    if (surface == EGL_NO_SURFACE) {
+        return host_egl_fail(EGL_BAD_SURFACE);
+    }
+    if (host_egl_current != NULL && __atomic_exchange_n(&host_egl_lose_pending, 0, __ATOMIC_ACQUIRE)) {
+        host_egl_current->lost = 1;
+    }
+    if (host_egl_current != NULL && host_egl_current->lost) {
+        return host_egl_fail(EGL_CONTEXT_LOST);
+    }
+    host_counter_add(&host_counters_global.swaps, 1);
+    const struct host_egl_surface* hostSurface = (const struct host_egl_surface*)surface;
+    if (hostSurface->window != NULL) {
+        host_fill_wait(ANativeWindow_getWidth(hostSurface->window), ANativeWindow_getHeight(hostSurface->window));
+    } else {
+        host_fill_wait(hostSurface->width, hostSurface->height);
+    }
+    host_vsync_wait();
+    return EGL_TRUE;
+}
+
+// Fonctions d'OpenGL ES 3 que le moteur obtient  l'excution (host_gles.cpp).
+static const struct {
+    const char* name;
+    __eglMustCastToProperFunctionPointerType function;
+} host_egl_procs[] = {
+    { "glMapBufferRange", (__eglMustCastToProperFunctionPointerType)glMapBufferRange },
+    { "glFlushMappedBufferRange", (__eglMustCastToProperFunctionPointerType)glFlushMappedBufferRange },
+    { "glUnmapBuffer", (__eglMustCastToProperFunctionPointerType)glUnmapBuffer },
+    { "glTexImage3D", (__eglMustCastToProperFunctionPointerType)glTexImage3D },
+    { "glTexSubImage3D", (__eglMustCastToProperFunctionPointerType)glTexSubImage3D },
+    { "glVertexAttribIPointer", (__eglMustCastToProperFunctionPointerType)glVertexAttribIPointer },
+    { "glVertexAttribDivisor", (__eglMustCastToProperFunctionPointerType)glVertexAttribDivisor },
+    { "glDrawArraysInstanced", (__eglMustCastToProperFunctionPointerType)glDrawArraysInstanced },
+    { "glFenceSync", (__eglMustCastToProperFunctionPointerType)glFenceSync },
+    { "glClientWaitSync", (__eglMustCastToProperFunctionPointerType)glClientWaitSync },
+    { "glDeleteSync", (__eglMustCastToProperFunctionPointerType)glDeleteSync },
+};
+
+__eglMustCastToProperFunctionPointerType eglGetProcAddress(const char* procname) {
+    for (size_t i = 0; i < sizeof(host_egl_procs) / sizeof(host_egl_procs[0]); i++) {
+        if (strcmp(host_egl_procs[i].name, procname) == 0) {
+            return host_egl_procs[i].function;
+        }
+    }
+    return NULL;
+}
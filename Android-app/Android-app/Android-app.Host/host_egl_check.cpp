@@ -0,0 +1,119 @@
+/*
+ * Vrification de display_manager contre l'EGL logiciel de Mesa.
+ *
+ * Le programme n'utilise pas les substituts de host_egl.cpp : display_manager
+ * est li  libEGL et libGLESv1_CM, sur la plateforme sans affichage de Mesa
+ * (EGL_PLATFORM=surfaceless), qui n'a pas de surface de fentre. Les fentres
+ * sont donc remplaces par des tampons hors cran donns 
+ * display_manager_attach_surface().
+ *
+ * Une texture cre avec la premire surface doit exister encore aprs la
+ * destruction de la surface et l'attachement d'une autre, sans nouveau
+ * contexte ; un effacement doit tre relu par glReadPixels(). Les dures de la
+ * premire initialisation et des reprises sont affiches.
+ *
+ * Utilisation : host_egl_check [cycles]. Retourne 0 si la vrification russit,
+ * 1 si elle choue, 2 si EGL n'est pas utilisable.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <EGL/egl.h>
+#include <GLES/gl.h>
+
+#include "display_manager.h"
+
+static const EGLint check_config_attribs[] = {
+    EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_ES_BIT,
+    EGL_RED_SIZE, 8,
+    EGL_GREEN_SIZE, 8,
+    EGL_BLUE_SIZE, 8,
+    EGL_NONE
+};
+
+static EGLSurface check_pbuffer(struct display_manager* manager, EGLint width, EGLint height) {
+    const EGLint attribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+    return eglCreatePbufferSurface(manager->display, manager->config, attribs);
+}
+
+static int check_fail(struct display_manager* manager, const char* message) {
+    fprintf(stderr, "egl-check: %s (EGL error 0x%x, GL error 0x%x)\n", message, eglGetError(),
+            glGetError());
+    display_manager_term(manager);
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    int cycles = argc > 1 ? atoi(argv[1]) : 100;
+    if (cycles < 1) cycles = 1;
+    setenv("EGL_PLATFORM", "surfaceless", 0);
+
+    struct display_manager manager;
+    display_manager_init(&manager, check_config_attribs, NULL);
+    if (display_manager_open(&manager) != 0) {
+        fprintf(stderr, "egl-check: EGL unavailable\n");
+        return 2;
+    }
+    EGLint id = 0;
+    EGLint depth = 0;
+    EGLint samples = 0;
+    eglGetConfigAttrib(manager.display, manager.config, EGL_CONFIG_ID, &id);
+    eglGetConfigAttrib(manager.display, manager.config, EGL_DEPTH_SIZE, &depth);
+    eglGetConfigAttrib(manager.display, manager.config, EGL_SAMPLES, &samples);
+    printf("egl-check: %s, config %d (depth %d, samples %d, score %d), surfaceless=%d\n",
+            eglQueryString(manager.display, EGL_VENDOR), id, depth, samples,
+            display_manager_score_config(manager.display, manager.config, check_config_attribs),
+            manager.surfaceless);
+    display_manager_term(&manager);
+    manager.stats = {};
+
+    // Premire surface : initialisation complte, puis une texture.
+    if (display_manager_open(&manager) != 0
+            || display_manager_attach_surface(&manager, check_pbuffer(&manager, 64, 64))
+                != DISPLAY_MANAGER_NEW_CONTEXT) {
+        return check_fail(&manager, "first attach failed");
+    }
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    const uint32_t texel = 0xff00ff00u;
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &texel);
+
+    // Reprises : la surface seule est recre, de taille diffrente  chaque fois.
+    int64_t resumeNs = 0;
+    for (int i = 0; i < cycles; i++) {
+        display_manager_detach(&manager);
+        EGLint size = 32 + (i & 31);
+        if (display_manager_attach_surface(&manager, check_pbuffer(&manager, size, size)) != 0) {
+            return check_fail(&manager, "resume created a new context");
+        }
+        resumeNs += manager.stats.lastAttachNs;
+        if (manager.width != size || manager.height != size) {
+            return check_fail(&manager, "surface size not updated");
+        }
+    }
+    if (glIsTexture(texture) != GL_TRUE) {
+        return check_fail(&manager, "texture lost across surfaces");
+    }
+
+    glClearColor(1.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    uint8_t pixel[4] = { 0, 0, 0, 0 };
+    glReadPixels(0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+    if (pixel[0] != 255 || pixel[1] != 0 || pixel[2] != 0) {
+        return check_fail(&manager, "clear not read back");
+    }
+    if (display_manager_swap(&manager) != 0) {
+        return check_fail(&manager, "swap failed");
+    }
+
+    const struct display_manager_stats stats = manager.stats;
+    printf("egl-check: init=%.3f ms resume=%.3f ms (%d cycles) contexts=%llu surfaces=%llu "
+            "texture kept\n", stats.initNs / 1e6, resumeNs / 1e6 / cycles, cycles,
+            (unsigned long long)stats.contexts, (unsigned long long)stats.surfaces);
+    display_manager_term(&manager);
+    return stats.contexts == 1 && stats.displayInits == 1 ? 0 : 1;
+}
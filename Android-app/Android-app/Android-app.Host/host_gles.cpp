@@ -0,0 +1,366 @@
+/*
+ * OpenGL ES 3 hte.
+ *
+ * Les substituts ne dessinent rien : ils valident les appels du moteur et
+ * comptent les effacements et les appels de dessin. Les tampons ont un vrai
+ * stockage, que glMapBufferRange() rend  l'criture ; les autres objets
+ * (nuanceurs, programmes, textures, barrires) ne sont que des noms.
+ *
+ * Les fonctions d'OpenGL ES 3 sont aussi rendues par eglGetProcAddress()
+ * (host_egl.cpp), par lequel le moteur les obtient. GL_EXT_buffer_storage
+ * n'est pas annonce : le moteur projette chaque lot.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <GLES3/gl3.h>
+
+#include "host_internal.h"
+
+#define HOST_GL_MAX_BUFFERS 64
+
+struct host_gl_buffer {
+    uint8_t* data;
+    GLsizeiptr size;
+};
+
+static struct host_gl_buffer host_gl_buffers[HOST_GL_MAX_BUFFERS];
+static GLuint host_gl_array_buffer;
+static GLuint host_gl_element_buffer;
+static GLuint host_gl_next_name = 1;
+static uintptr_t host_gl_next_sync = 1;
+static GLenum host_gl_error = GL_NO_ERROR;
+
+static void host_gl_fail(GLenum error) {
+    if (host_gl_error == GL_NO_ERROR) {
+        host_gl_error = error;
+    }
+}
+
+static GLuint* host_gl_binding(GLenum target) {
+    switch (target) {
+        case GL_ARRAY_BUFFER:
+            return &host_gl_array_buffer;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            return &host_gl_element_buffer;
+        default:
+            return NULL;
+    }
+}
+
+static struct host_gl_buffer* host_gl_bound(GLenum target) {
+    GLuint* binding = host_gl_binding(target);
+    if (binding == NULL || *binding == 0 || *binding >= HOST_GL_MAX_BUFFERS) {
+        host_gl_fail(GL_INVALID_OPERATION);
+        return NULL;
+    }
+    return &host_gl_buffers[*binding];
+}
+
+void host_gles_release(void) {
+    for (GLuint name = 1; name < HOST_GL_MAX_BUFFERS; name++) {
+        free(host_gl_buffers[name].data);
+        host_gl_buffers[name].data = NULL;
+        host_gl_buffers[name].size = 0;
+    }
+    host_gl_array_buffer = 0;
+    host_gl_element_buffer = 0;
+}
+
+// --------------------------------------------------------------------
+// tat
+// --------------------------------------------------------------------
+
+GLenum glGetError(void) {
+    GLenum error = host_gl_error;
+    host_gl_error = GL_NO_ERROR;
+    return error;
+}
+
+const GLubyte* glGetString(GLenum name) {
+    switch (name) {
+        case GL_VENDOR:
+            return (const GLubyte*)"host";
+        case GL_RENDERER:
+            return (const GLubyte*)"host";
+        case GL_VERSION:
+            return (const GLubyte*)"OpenGL ES 3.0 host";
+        case GL_SHADING_LANGUAGE_VERSION:
+            return (const GLubyte*)"OpenGL ES GLSL ES 3.00";
+        case GL_EXTENSIONS:
+            return (const GLubyte*)"";
+        default:
+            host_gl_fail(GL_INVALID_ENUM);
+            return NULL;
+    }
+}
+
+void glGetIntegerv(GLenum pname, GLint* data) {
+    *data = pname == GL_MAX_ARRAY_TEXTURE_LAYERS ? 256 : 0;
+}
+
+void glEnable(GLenum cap) {
+}
+
+void glDisable(GLenum cap) {
+}
+
+void glBlendFunc(GLenum sfactor, GLenum dfactor) {
+}
+
+void glViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+}
+
+void glClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+}
+
+void glClear(GLbitfield mask) {
+    host_counter_add(&host_counters_global.clears, 1);
+}
+
+void glPixelStorei(GLenum pname, GLint param) {
+}
+
+void glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type,
+        void* pixels) {
+    memset(pixels, 0, (size_t)width * height * 4);
+}
+
+void glFinish(void) {
+}
+
+void glFlush(void) {
+}
+
+// --------------------------------------------------------------------
+// Nuanceurs et programmes
+// --------------------------------------------------------------------
+
+GLuint glCreateShader(GLenum type) {
+    return host_gl_next_name++;
+}
+
+void glShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length) {
+}
+
+void glCompileShader(GLuint shader) {
+}
+
+void glGetShaderiv(GLuint shader, GLenum pname, GLint* params) {
+    *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+void glGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+    if (bufSize > 0) infoLog[0] = '\0';
+    if (length != NULL) *length = 0;
+}
+
+void glDeleteShader(GLuint shader) {
+}
+
+GLuint glCreateProgram(void) {
+    return host_gl_next_name++;
+}
+
+void glAttachShader(GLuint program, GLuint shader) {
+}
+
+void glBindAttribLocation(GLuint program, GLuint index, const GLchar* name) {
+}
+
+void glLinkProgram(GLuint program) {
+}
+
+void glGetProgramiv(GLuint program, GLenum pname, GLint* params) {
+    *params = pname == GL_LINK_STATUS ? GL_TRUE : 0;
+}
+
+void glGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+    if (bufSize > 0) infoLog[0] = '\0';
+    if (length != NULL) *length = 0;
+}
+
+void glDeleteProgram(GLuint program) {
+}
+
+void glUseProgram(GLuint program) {
+}
+
+GLint glGetUniformLocation(GLuint program, const GLchar* name) {
+    return 0;
+}
+
+void glUniform1i(GLint location, GLint v0) {
+}
+
+void glUniform2f(GLint location, GLfloat v0, GLfloat v1) {
+}
+
+// --------------------------------------------------------------------
+// Tampons
+// --------------------------------------------------------------------
+
+void glGenBuffers(GLsizei n, GLuint* buffers) {
+    for (GLsizei i = 0; i < n; i++) {
+        buffers[i] = 0;
+        for (GLuint name = 1; name < HOST_GL_MAX_BUFFERS; name++) {
+            // Un nom libre n'a pas de stockage et n'a pas encore t rendu.
+            if (host_gl_buffers[name].size == 0 && host_gl_buffers[name].data == NULL) {
+                host_gl_buffers[name].size = -1;
+                buffers[i] = name;
+                break;
+            }
+        }
+        if (buffers[i] == 0) {
+            host_gl_fail(GL_OUT_OF_MEMORY);
+        }
+    }
+}
+
+void glDeleteBuffers(GLsizei n, const GLuint* buffers) {
+    for (GLsizei i = 0; i < n; i++) {
+        GLuint name = buffers[i];
+        if (name == 0 || name >= HOST_GL_MAX_BUFFERS) {
+            continue;
+        }
+        free(host_gl_buffers[name].data);
+        host_gl_buffers[name].data = NULL;
+        host_gl_buffers[name].size = 0;
+        if (host_gl_array_buffer == name) host_gl_array_buffer = 0;
+        if (host_gl_element_buffer == name) host_gl_element_buffer = 0;
+    }
+}
+
+void glBindBuffer(GLenum target, GLuint buffer) {
+    GLuint* binding = host_gl_binding(target);
+    if (binding != NULL) {
+        *binding = buffer;
+    }
+}
+
+void glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    struct host_gl_buffer* buffer = host_gl_bound(target);
+    if (buffer == NULL) {
+        return;
+    }
+    // Remplacement du stockage  taille gale (tampon en flux) : aucune allocation.
+    if (buffer->size != size || buffer->data == NULL) {
+        free(buffer->data);
+        buffer->data = (uint8_t*)malloc((size_t)size);
+        buffer->size = size;
+    }
+    if (data != NULL) {
+        memcpy(buffer->data, data, (size_t)size);
+    }
+}
+
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+    struct host_gl_buffer* buffer = host_gl_bound(target);
+    if (buffer == NULL || offset < 0 || offset + size > buffer->size) {
+        host_gl_fail(GL_INVALID_VALUE);
+        return;
+    }
+    memcpy(buffer->data + offset, data, (size_t)size);
+}
+
+void* glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    struct host_gl_buffer* buffer = host_gl_bound(target);
+    if (buffer == NULL || offset < 0 || offset + length > buffer->size) {
+        host_gl_fail(GL_INVALID_VALUE);
+        return NULL;
+    }
+    return buffer->data + offset;
+}
+
+void glFlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length) {
+}
+
+GLboolean glUnmapBuffer(GLenum target) {
+    return GL_TRUE;
+}
+
+// --------------------------------------------------------------------
+// Textures
+// --------------------------------------------------------------------
+
+void glGenTextures(GLsizei n, GLuint* textures) {
+    for (GLsizei i = 0; i < n; i++) {
+        textures[i] = host_gl_next_name++;
+    }
+}
+
+void glDeleteTextures(GLsizei n, const GLuint* textures) {
+}
+
+void glActiveTexture(GLenum texture) {
+}
+
+void glBindTexture(GLenum target, GLuint texture) {
+}
+
+void glTexParameteri(GLenum target, GLenum pname, GLint param) {
+}
+
+void glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+        GLint border, GLenum format, GLenum type, const void* pixels) {
+}
+
+void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
+        GLsizei height, GLenum format, GLenum type, const void* pixels) {
+}
+
+void glTexImage3D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+        GLsizei depth, GLint border, GLenum format, GLenum type, const void* pixels) {
+}
+
+void glTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+        GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels) {
+}
+
+// --------------------------------------------------------------------
+// Attributs et dessin
+// --------------------------------------------------------------------
+
+void glEnableVertexAttribArray(GLuint index) {
+}
+
+void glDisableVertexAttribArray(GLuint index) {
+}
+
+void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+        GLsizei stride, const void* pointer) {
+}
+
+void glVertexAttribIPointer(GLuint index, GLint size, GLenum type, GLsizei stride, const void* pointer) {
+}
+
+void glVertexAttribDivisor(GLuint index, GLuint divisor) {
+}
+
+void glDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    host_counter_add(&host_counters_global.draws, 1);
+}
+
+void glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount) {
+    host_counter_add(&host_counters_global.draws, 1);
+}
+
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+    host_counter_add(&host_counters_global.draws, 1);
+}
+
+// --------------------------------------------------------------------
+// Barrires : les commandes sont excutes ds leur envoi.
+// --------------------------------------------------------------------
+
+GLsync glFenceSync(GLenum condition, GLbitfield flags) {
+    return (GLsync)host_gl_next_sync++;
+}
+
+GLenum glClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+    return GL_ALREADY_SIGNALED;
+}
+
+void glDeleteSync(GLsync sync) {
+}
@@ -0,0 +1,267 @@
+/*
+ * Benchmark du rendu de sprites (sprite_batch.h) contre llvmpipe, sans fentre.
+ *
+ * Le programme est li  l'EGL et  l'OpenGL ES de Mesa, sur la plateforme
+ * sans affichage (EGL_PLATFORM=surfaceless) : l'image de 1280x720 est un tampon
+ * hors cran. Les sprites de 16x16 pixels prennent au hasard une des
+ * BENCH_LAYERS images, dans un ordre fix par la graine. Pour 1000, 10000 et
+ * 50000 sprites par image, quatre modes :
+ *
+ *      immediate   chemin dvelopp, dessin aprs chaque ajout : un appel par
+ *                  sprite, comme un rendu immdiat ;
+ *      expanded    chemin dvelopp : un appel  chaque changement d'image ;
+ *      instanced   chemin instanci, anneau projet de faon persistante si
+ *                  GL_EXT_buffer_storage est disponible ;
+ *      mapped      chemin instanci, chaque lot projet par glMapBufferRange().
+ *
+ * Pour chaque mode : appels de dessin par image, temps d'envoi (de
+ * sprite_batch_begin()  sprite_batch_end()), dure de l'image jusqu'
+ * glFinish(), sprites et sommets par seconde.
+ *
+ * Avant les mesures, une mme scne est dessine par les deux chemins puis
+ * relue par glReadPixels() : les images doivent tre identiques.
+ *
+ * Utilisation : host_gles_bench [-n images] [-s sprites]. Retourne 1 si les
+ * chemins diffrent, 2 si OpenGL ES 3 n'est pas utilisable.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+
+#include "display_manager.h"
+#include "frame_timing.h"
+#include "sprite_batch.h"
+
+#define BENCH_WIDTH 1280
+#define BENCH_HEIGHT 720
+#define BENCH_SPRITE 16
+#define BENCH_LAYERS 16
+#define BENCH_TEXELS 64
+#define BENCH_WARMUP 2
+#define BENCH_EXACT_SPRITES 2000
+
+enum {
+    BENCH_MODE_IMMEDIATE,
+    BENCH_MODE_EXPANDED,
+    BENCH_MODE_INSTANCED,
+    BENCH_MODE_MAPPED,
+
+    BENCH_MODE_COUNT
+};
+
+static const char* const bench_mode_names[BENCH_MODE_COUNT] = {
+    "immediate", "expanded", "instanced", "mapped",
+};
+
+static const int bench_mode_flags[BENCH_MODE_COUNT] = {
+    SPRITE_BATCH_EXPANDED, SPRITE_BATCH_EXPANDED, 0, SPRITE_BATCH_NO_PERSISTENT,
+};
+
+static const EGLint bench_config_attribs[] = {
+    EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+    EGL_RED_SIZE, 8,
+    EGL_GREEN_SIZE, 8,
+    EGL_BLUE_SIZE, 8,
+    EGL_ALPHA_SIZE, 8,
+    EGL_NONE
+};
+
+static const EGLint bench_context_attribs[] = {
+    EGL_CONTEXT_CLIENT_VERSION, 3,
+    EGL_NONE
+};
+
+static uint32_t bench_random(uint32_t* seed) {
+    *seed = *seed * 1664525u + 1013904223u;
+    return *seed >> 8;
+}
+
+static void bench_make_sprites(struct sprite_batch_sprite* sprites, int count, uint32_t seed) {
+    for (int i = 0; i < count; i++) {
+        struct sprite_batch_sprite* sprite = &sprites[i];
+        sprite->x = (float)(bench_random(&seed) % (BENCH_WIDTH - BENCH_SPRITE));
+        sprite->y = (float)(bench_random(&seed) % (BENCH_HEIGHT - BENCH_SPRITE));
+        sprite->width = BENCH_SPRITE;
+        sprite->height = BENCH_SPRITE;
+        sprite->u0 = 0.0f;
+        sprite->v0 = 0.0f;
+        sprite->u1 = 1.0f;
+        sprite->v1 = 1.0f;
+        sprite->color = (bench_random(&seed) & 0x00ffffffu) | (192u + bench_random(&seed) % 64) << 24;
+        sprite->layer = bench_random(&seed) % BENCH_LAYERS;
+    }
+}
+
+// Images : un damier de deux couleurs propres  chaque couche.
+static struct sprite_batch* bench_create_batch(int flags) {
+    struct sprite_batch* batch = sprite_batch_create(BENCH_TEXELS, BENCH_TEXELS, BENCH_LAYERS, flags);
+    if (batch == NULL) {
+        return NULL;
+    }
+    static uint32_t pixels[BENCH_TEXELS * BENCH_TEXELS];
+    for (int layer = 0; layer < BENCH_LAYERS; layer++) {
+        uint32_t even = 0xff000000u | (uint32_t)(layer * 16) | (uint32_t)(255 - layer * 16) << 8;
+        uint32_t odd = 0xff000000u | (uint32_t)(layer * 16) << 16 | 0x80u;
+        for (int y = 0; y < BENCH_TEXELS; y++) {
+            for (int x = 0; x < BENCH_TEXELS; x++) {
+                pixels[y * BENCH_TEXELS + x] = ((x >> 3) ^ (y >> 3)) & 1 ? odd : even;
+            }
+        }
+        sprite_batch_upload(batch, layer, pixels);
+    }
+    return batch;
+}
+
+static void bench_draw(struct sprite_batch* batch, const struct sprite_batch_sprite* sprites,
+        int count, int immediate) {
+    sprite_batch_begin(batch, BENCH_WIDTH, BENCH_HEIGHT);
+    for (int i = 0; i < count; i++) {
+        sprite_batch_add(batch, &sprites[i]);
+        if (immediate) {
+            sprite_batch_flush(batch);
+        }
+    }
+    sprite_batch_end(batch);
+}
+
+static uint32_t* bench_render(int flags, const struct sprite_batch_sprite* sprites, int count) {
+    struct sprite_batch* batch = bench_create_batch(flags);
+    uint32_t* pixels = (uint32_t*)malloc((size_t)BENCH_WIDTH * BENCH_HEIGHT * sizeof(uint32_t));
+    if (batch == NULL || pixels == NULL) {
+        sprite_batch_destroy(batch);
+        free(pixels);
+        return NULL;
+    }
+    glClearColor(0.1f, 0.2f, 0.3f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    bench_draw(batch, sprites, count, 0);
+    glReadPixels(0, 0, BENCH_WIDTH, BENCH_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    sprite_batch_destroy(batch);
+    return pixels;
+}
+
+/**
+ * Mme scne par les deux chemins. Retourne le nombre de pixels qui diffrent,
+ * ou -1 en cas d'erreur.
+ */
+static long bench_exact(void) {
+    static struct sprite_batch_sprite sprites[BENCH_EXACT_SPRITES];
+    bench_make_sprites(sprites, BENCH_EXACT_SPRITES, 7);
+    uint32_t* expanded = bench_render(SPRITE_BATCH_EXPANDED, sprites, BENCH_EXACT_SPRITES);
+    uint32_t* instanced = bench_render(0, sprites, BENCH_EXACT_SPRITES);
+    long mismatches = -1;
+    if (expanded != NULL && instanced != NULL) {
+        mismatches = 0;
+        for (size_t i = 0; i < (size_t)BENCH_WIDTH * BENCH_HEIGHT; i++) {
+            mismatches += expanded[i] != instanced[i];
+        }
+    }
+    free(expanded);
+    free(instanced);
+    return mismatches;
+}
+
+static int bench_mode(int mode, const struct sprite_batch_sprite* sprites, int count, int frames) {
+    struct sprite_batch* batch = bench_create_batch(bench_mode_flags[mode]);
+    if (batch == NULL) {
+        fprintf(stderr, "gles/%s: unable to create the sprite batch\n", bench_mode_names[mode]);
+        return -1;
+    }
+    int immediate = mode == BENCH_MODE_IMMEDIATE;
+    struct sprite_batch_stats before;
+    struct sprite_batch_stats after;
+    int64_t submitNs = 0;
+    int64_t frameNs = 0;
+    for (int frame = -BENCH_WARMUP; frame < frames; frame++) {
+        if (frame == 0) {
+            sprite_batch_get_stats(batch, &before);
+        }
+        int64_t start = frame_timing_now();
+        glClear(GL_COLOR_BUFFER_BIT);
+        bench_draw(batch, sprites, count, immediate);
+        int64_t submitted = frame_timing_now();
+        glFinish();
+        if (frame >= 0) {
+            submitNs += submitted - start;
+            frameNs += frame_timing_now() - start;
+        }
+    }
+    sprite_batch_get_stats(batch, &after);
+    double seconds = frameNs / 1e9;
+    double spritesPerSecond = (after.sprites - before.sprites) / seconds;
+    printf("gles/%s: sprites=%d stream=%s draws/frame=%.1f submit_ms=%.3f frame_ms=%.3f "
+            "sprites/s=%.3gM vertices/s=%.3gM stalls=%llu\n", bench_mode_names[mode], count,
+            sprite_batch_stream_name(sprite_batch_get_stream(batch)),
+            (after.draws - before.draws) / (double)frames, submitNs / 1e6 / frames,
+            frameNs / 1e6 / frames, spritesPerSecond / 1e6, 4 * spritesPerSecond / 1e6,
+            (unsigned long long)(after.stalls - before.stalls));
+    sprite_batch_destroy(batch);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int frames = 10;
+    int only = 0;
+    int option;
+    while ((option = getopt(argc, argv, "n:s:")) != -1) {
+        switch (option) {
+            case 'n':
+                frames = atoi(optarg);
+                break;
+            case 's':
+                only = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n frames] [-s sprites]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (frames < 1) frames = 1;
+    setenv("EGL_PLATFORM", "surfaceless", 0);
+
+    struct display_manager manager;
+    display_manager_init(&manager, bench_config_attribs, bench_context_attribs);
+    const EGLint pbuffer[] = { EGL_WIDTH, BENCH_WIDTH, EGL_HEIGHT, BENCH_HEIGHT, EGL_NONE };
+    if (display_manager_open(&manager) != 0 || display_manager_attach_surface(&manager,
+            eglCreatePbufferSurface(manager.display, manager.config, pbuffer)) < 0) {
+        fprintf(stderr, "gles: EGL unavailable\n");
+        return 2;
+    }
+    const char* version = (const char*)glGetString(GL_VERSION);
+    printf("gles: %s, %s\n", (const char*)glGetString(GL_RENDERER), version);
+    if (strncmp(version, "OpenGL ES 3", 11) != 0) {
+        fprintf(stderr, "gles: OpenGL ES 3 unavailable\n");
+        display_manager_term(&manager);
+        return 2;
+    }
+
+    long mismatches = bench_exact();
+    printf("gles: exact sprites=%d mismatches=%ld\n", BENCH_EXACT_SPRITES, mismatches);
+
+    static const int counts[] = { 1000, 10000, 50000 };
+    struct sprite_batch_sprite* sprites =
+            (struct sprite_batch_sprite*)malloc(sizeof(struct sprite_batch_sprite) * 50000);
+    bench_make_sprites(sprites, 50000, 1);
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        if (only != 0 && counts[i] != only) {
+            continue;
+        }
+        for (int mode = 0; mode < BENCH_MODE_COUNT; mode++) {
+            bench_mode(mode, sprites, counts[i], frames);
+        }
+    }
+    free(sprites);
+    display_manager_term(&manager);
+
+    if (mismatches != 0) {
+        fprintf(stderr, "gles: the instanced and expanded paths differ\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,358 @@
+/*
+ * AInputQueue et AInputEvent htes.
+ *
+ * La file est protge par un mutex et signale par un eventfd attach au
+ * looper de l'application : le fd est lisible tant que la file n'est pas vide,
+ * comme le canal d'entre du framework.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include <android/input.h>
+#include <android/log.h>
+
+#include "host_internal.h"
+
+#define LOGE(...) ((void)__android_log_print(ANDROID_LOG_ERROR, "host_input", __VA_ARGS__))
+
+#define INPUT_MAX_POINTERS 10
+#define INPUT_MAX_HISTORY 32
+
+struct input_sample {
+    int64_t eventTime;
+    float x[INPUT_MAX_POINTERS];
+    float y[INPUT_MAX_POINTERS];
+    float pressure[INPUT_MAX_POINTERS];
+};
+
+struct AInputEvent {
+    struct AInputEvent* next;
+    int32_t type;
+    int32_t source;
+    int32_t deviceId;
+    int32_t action;
+
+    // Touche.
+    int32_t keyCode;
+    int32_t repeatCount;
+    int32_t metaState;
+
+    // Mouvement : les chantillons historiques prcdent l'chantillon courant,
+    // qui est toujours le dernier du tableau.
+    size_t pointerCount;
+    int32_t pointerIds[INPUT_MAX_POINTERS];
+    size_t sampleCount;
+    struct input_sample samples[INPUT_MAX_HISTORY + 1];
+};
+
+struct AInputQueue {
+    pthread_mutex_t mutex;
+    int eventFd;
+    int signaled;
+    struct AInputEvent* head;
+    struct AInputEvent* tail;
+    ALooper* looper;
+    // vnements injects pas encore termins.
+    uint32_t unfinished;
+};
+
+static const struct input_sample* input_current(const AInputEvent* event) {
+    return &event->samples[event->sampleCount - 1];
+}
+
+int32_t AInputEvent_getType(const AInputEvent* event) {
+    return event->type;
+}
+
+int32_t AInputEvent_getDeviceId(const AInputEvent* event) {
+    return event->deviceId;
+}
+
+int32_t AInputEvent_getSource(const AInputEvent* event) {
+    return event->source;
+}
+
+int32_t AKeyEvent_getAction(const AInputEvent* key_event) {
+    return key_event->action;
+}
+
+int32_t AKeyEvent_getKeyCode(const AInputEvent* key_event) {
+    return key_event->keyCode;
+}
+
+int32_t AKeyEvent_getRepeatCount(const AInputEvent* key_event) {
+    return key_event->repeatCount;
+}
+
+int32_t AKeyEvent_getMetaState(const AInputEvent* key_event) {
+    return key_event->metaState;
+}
+
+int64_t AKeyEvent_getEventTime(const AInputEvent* key_event) {
+    return key_event->samples[0].eventTime;
+}
+
+int32_t AMotionEvent_getAction(const AInputEvent* motion_event) {
+    return motion_event->action;
+}
+
+int64_t AMotionEvent_getEventTime(const AInputEvent* motion_event) {
+    return input_current(motion_event)->eventTime;
+}
+
+size_t AMotionEvent_getPointerCount(const AInputEvent* motion_event) {
+    return motion_event->pointerCount;
+}
+
+int32_t AMotionEvent_getPointerId(const AInputEvent* motion_event, size_t pointer_index) {
+    return motion_event->pointerIds[pointer_index];
+}
+
+float AMotionEvent_getX(const AInputEvent* motion_event, size_t pointer_index) {
+    return input_current(motion_event)->x[pointer_index];
+}
+
+float AMotionEvent_getY(const AInputEvent* motion_event, size_t pointer_index) {
+    return input_current(motion_event)->y[pointer_index];
+}
+
+float AMotionEvent_getPressure(const AInputEvent* motion_event, size_t pointer_index) {
+    return input_current(motion_event)->pressure[pointer_index];
+}
+
+size_t AMotionEvent_getHistorySize(const AInputEvent* motion_event) {
+    return motion_event->sampleCount - 1;
+}
+
+int64_t AMotionEvent_getHistoricalEventTime(const AInputEvent* motion_event,
+        size_t history_index) {
+    return motion_event->samples[history_index].eventTime;
+}
+
+float AMotionEvent_getHistoricalX(const AInputEvent* motion_event, size_t pointer_index,
+        size_t history_index) {
+    return motion_event->samples[history_index].x[pointer_index];
+}
+
+float AMotionEvent_getHistoricalY(const AInputEvent* motion_event, size_t pointer_index,
+        size_t history_index) {
+    return motion_event->samples[history_index].y[pointer_index];
+}
+
+float AMotionEvent_getHistoricalPressure(const AInputEvent* motion_event,
+        size_t pointer_index, size_t history_index) {
+    return motion_event->samples[history_index].pressure[pointer_index];
+}
+
+// --------------------------------------------------------------------
+// File d'entre
+// --------------------------------------------------------------------
+
+static void input_queue_signal(AInputQueue* queue, int signaled) {
+    uint64_t value = 1;
+    if (signaled && !queue->signaled) {
+        if (write(queue->eventFd, &value, sizeof(value)) != sizeof(value)) {
+            LOGE("Could not signal input queue: %s", strerror(errno));
+        }
+    } else if (!signaled && queue->signaled) {
+        if (read(queue->eventFd, &value, sizeof(value)) != sizeof(value)) {
+            LOGE("Could not clear input queue: %s", strerror(errno));
+        }
+    }
+    queue->signaled = signaled;
+}
+
+static void input_queue_push(AInputQueue* queue, AInputEvent* event) {
+    host_counter_add(&host_counters_global.inputEvents, 1);
+    pthread_mutex_lock(&queue->mutex);
+    event->next = NULL;
+    if (queue->tail != NULL) {
+        queue->tail->next = event;
+    } else {
+        queue->head = event;
+    }
+    queue->tail = event;
+    queue->unfinished++;
+    input_queue_signal(queue, 1);
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+AInputQueue* host_input_queue_create(void) {
+    AInputQueue* queue = (AInputQueue*)calloc(1, sizeof(AInputQueue));
+    pthread_mutex_init(&queue->mutex, NULL);
+    queue->eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    return queue;
+}
+
+int host_input_queue_pending(AInputQueue* queue) {
+    pthread_mutex_lock(&queue->mutex);
+    int result = (int)queue->unfinished;
+    pthread_mutex_unlock(&queue->mutex);
+    return result;
+}
+
+void host_input_queue_destroy(AInputQueue* queue) {
+    AInputEvent* event = queue->head;
+    while (event != NULL) {
+        AInputEvent* next = event->next;
+        free(event);
+        event = next;
+    }
+    close(queue->eventFd);
+    pthread_mutex_destroy(&queue->mutex);
+    free(queue);
+}
+
+void host_input_push_motion(AInputQueue* queue, int32_t action,
+        size_t pointerCount, const float* xy, size_t historySize) {
+    if (pointerCount > INPUT_MAX_POINTERS) pointerCount = INPUT_MAX_POINTERS;
+    if (historySize > INPUT_MAX_HISTORY) historySize = INPUT_MAX_HISTORY;
+
+    AInputEvent* event = (AInputEvent*)malloc(sizeof(AInputEvent));
+    memset(event, 0, offsetof(AInputEvent, samples));
+    event->type = AINPUT_EVENT_TYPE_MOTION;
+    event->source = AINPUT_SOURCE_TOUCHSCREEN;
+    event->action = action;
+    event->pointerCount = pointerCount;
+    event->sampleCount = historySize + 1;
+
+    // Les chantillons historiques convergent linairement vers la position
+    // courante, espacs d'une milliseconde.
+    int64_t now = host_now_ns();
+    for (size_t h = 0; h <= historySize; h++) {
+        struct input_sample* sample = &event->samples[h];
+        float t = (float)(h + 1) / (float)(historySize + 1);
+        sample->eventTime = now - (int64_t)(historySize - h) * 1000000;
+        for (size_t p = 0; p < pointerCount; p++) {
+            sample->x[p] = xy[p * 2] * t;
+            sample->y[p] = xy[p * 2 + 1] * t;
+            sample->pressure[p] = 1.0f;
+        }
+    }
+    for (size_t p = 0; p < pointerCount; p++) {
+        event->pointerIds[p] = (int32_t)p;
+    }
+    input_queue_push(queue, event);
+}
+
+void host_input_push_key(AInputQueue* queue, int32_t action, int32_t keyCode) {
+    AInputEvent* event = (AInputEvent*)malloc(sizeof(AInputEvent));
+    memset(event, 0, offsetof(AInputEvent, samples) + sizeof(struct input_sample));
+    event->type = AINPUT_EVENT_TYPE_KEY;
+    event->source = AINPUT_SOURCE_KEYBOARD;
+    event->action = action;
+    event->keyCode = keyCode;
+    event->sampleCount = 1;
+    event->samples[0].eventTime = host_now_ns();
+    input_queue_push(queue, event);
+}
+
+void host_input_push_motion_at(AInputQueue* queue, int32_t action, int32_t source, int32_t deviceId,
+        size_t pointerCount, const int32_t* pointerIds, size_t sampleCount, const int64_t* eventTimes,
+        const float* x, const float* y, const float* pressure, size_t stride) {
+    if (pointerCount > INPUT_MAX_POINTERS) pointerCount = INPUT_MAX_POINTERS;
+    // Au-del de la capacit, les chantillons les plus anciens sont abandonns.
+    size_t first = sampleCount > INPUT_MAX_HISTORY + 1 ? sampleCount - (INPUT_MAX_HISTORY + 1) : 0;
+
+    AInputEvent* event = (AInputEvent*)malloc(sizeof(AInputEvent));
+    memset(event, 0, offsetof(AInputEvent, samples));
+    event->type = AINPUT_EVENT_TYPE_MOTION;
+    event->source = source;
+    event->deviceId = deviceId;
+    event->action = action;
+    event->pointerCount = pointerCount;
+    event->sampleCount = sampleCount - first;
+    for (size_t s = first; s < sampleCount; s++) {
+        struct input_sample* sample = &event->samples[s - first];
+        sample->eventTime = eventTimes[s];
+        for (size_t p = 0; p < pointerCount; p++) {
+            sample->x[p] = x[s * stride + p];
+            sample->y[p] = y[s * stride + p];
+            sample->pressure[p] = pressure[s * stride + p];
+        }
+    }
+    memcpy(event->pointerIds, pointerIds, pointerCount * sizeof(int32_t));
+    input_queue_push(queue, event);
+}
+
+void host_input_push_key_at(AInputQueue* queue, int32_t action, int32_t keyCode, int32_t metaState,
+        int32_t repeatCount, int32_t source, int32_t deviceId, int64_t eventTime) {
+    AInputEvent* event = (AInputEvent*)malloc(sizeof(AInputEvent));
+    memset(event, 0, offsetof(AInputEvent, samples) + sizeof(struct input_sample));
+    event->type = AINPUT_EVENT_TYPE_KEY;
+    event->source = source;
+    event->deviceId = deviceId;
+    event->action = action;
+    event->keyCode = keyCode;
+    event->metaState = metaState;
+    event->repeatCount = repeatCount;
+    event->sampleCount = 1;
+    event->samples[0].eventTime = eventTime;
+    input_queue_push(queue, event);
+}
+
+void AInputQueue_attachLooper(AInputQueue* queue, ALooper* looper,
+        int ident, ALooper_callbackFunc callback, void* data) {
+    queue->looper = looper;
+    ALooper_addFd(looper, queue->eventFd, ident, ALOOPER_EVENT_INPUT, callback, data);
+}
+
+// Sur l'appareil, InputQueue::detachLooper() utilise le looper effac par le
+// dtachement prcdent : un second dtachement plante le processus.
+void AInputQueue_detachLooper(AInputQueue* queue) {
+    if (queue->looper == NULL) {
+        fprintf(stderr, "AInputQueue_detachLooper: queue %p is not attached to a looper\n", (void*)queue);
+        abort();
+    }
+    ALooper_removeFd(queue->looper, queue->eventFd);
+    queue->looper = NULL;
+}
+
+int32_t AInputQueue_hasEvents(AInputQueue* queue) {
+    pthread_mutex_lock(&queue->mutex);
+    int32_t result = queue->head != NULL ? 1 : 0;
+    pthread_mutex_unlock(&queue->mutex);
+    return result;
+}
+
+int32_t AInputQueue_getEvent(AInputQueue* queue, AInputEvent** outEvent) {
+    pthread_mutex_lock(&queue->mutex);
+    AInputEvent* event = queue->head;
+    if (event == NULL) {
+        input_queue_signal(queue, 0);
+        pthread_mutex_unlock(&queue->mutex);
+        *outEvent = NULL;
+        return -EAGAIN;
+    }
+    queue->head = event->next;
+    if (queue->head == NULL) {
+        queue->tail = NULL;
+        input_queue_signal(queue, 0);
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    *outEvent = event;
+    return 0;
+}
+
+int32_t AInputQueue_preDispatchEvent(AInputQueue* queue, AInputEvent* event) {
+    // Pas d'IME sur l'hte : aucun vnement n'est prdistribu.
+    return 0;
+}
+
+void AInputQueue_finishEvent(AInputQueue* queue, AInputEvent* event, int handled) {
+    host_counter_add(&host_counters_global.inputFinished, 1);
+    pthread_mutex_lock(&queue->mutex);
+    queue->unfinished--;
+    pthread_mutex_unlock(&queue->mutex);
+    if (handled) {
+        host_counter_add(&host_counters_global.inputHandled, 1);
+    }
+    free(event);
+}
@@ -0,0 +1,63 @@
+/*
+ * Dclarations partages entre les fichiers du runtime hte.
+ */
+
+#ifndef _HOST_INTERNAL_H
+#define _HOST_INTERNAL_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "host_runtime.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern struct host_counters host_counters_global;
+
+static inline void host_counter_add(uint64_t* counter, uint64_t value) {
+    __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+}
+
+/**
+ * Attente de la prochaine synchronisation verticale simule, commune 
+ * eglSwapBuffers() et ANativeWindow_unlockAndPost().
+ */
+void host_vsync_wait(void);
+
+// Temps de remplissage simul d'un tampon de width x height pixels, avant sa prsentation.
+void host_fill_wait(int32_t width, int32_t height);
+
+// Libration des objets GL,  la destruction du contexte.
+void host_gles_release(void);
+
+/**
+ * Fentre native hte : dimensions natives, gomtrie demande par
+ * ANativeWindow_setBuffersGeometry() et tampons du rendu logiciel. Le tampon
+ * prsent (front) est protg par mutex, pour host_window_read().
+ */
+struct ANativeWindow {
+    int refs;
+    int32_t width;
+    int32_t height;
+    int32_t format;
+    int32_t bufferWidth;
+    int32_t bufferHeight;
+    int32_t bufferFormat;
+
+    pthread_mutex_t mutex;
+    uint32_t* pixels[2];
+    int32_t pixelsWidth;
+    int32_t pixelsHeight;
+    int32_t pixelsStride;
+    int front;
+    int locked;
+    uint64_t posts;
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HOST_INTERNAL_H */
@@ -0,0 +1,307 @@
+/*
+ * ALooper hte, implment sur epoll.
+ *
+ * Chaque thread possde au plus un looper, cr par ALooper_prepare() et
+ * libr  la sortie du thread. Comme dans le framework, un fd enregistr sans
+ * rappel fait retourner son identificateur par ALooper_pollOnce(), et un fd
+ * enregistr avec rappel voit son rappel invoqu pendant l'attente.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <android/log.h>
+#include <android/looper.h>
+
+#include "host_internal.h"
+
+#define LOGE(...) ((void)__android_log_print(ANDROID_LOG_ERROR, "host_looper", __VA_ARGS__))
+
+#define LOOPER_MAX_FDS 32
+#define LOOPER_MAX_EVENTS 16
+
+struct looper_request {
+    int fd;
+    int ident;
+    int events;
+    ALooper_callbackFunc callback;
+    void* data;
+};
+
+struct looper_response {
+    struct looper_request request;
+    int events;
+};
+
+struct ALooper {
+    int refs;
+    int epollFd;
+    int wakeFd;
+    int allowNonCallbacks;
+
+    pthread_mutex_t mutex;
+    struct looper_request requests[LOOPER_MAX_FDS];
+    int requestCount;
+
+    struct looper_response responses[LOOPER_MAX_EVENTS];
+    int responseCount;
+    int responseIndex;
+};
+
+static pthread_key_t looper_key;
+static pthread_once_t looper_key_once = PTHREAD_ONCE_INIT;
+
+static void looper_thread_exit(void* looper) {
+    ALooper_release((ALooper*)looper);
+}
+
+static void looper_key_create(void) {
+    pthread_key_create(&looper_key, looper_thread_exit);
+}
+
+static uint32_t looper_to_epoll_events(int events) {
+    uint32_t epollEvents = 0;
+    if (events & ALOOPER_EVENT_INPUT) epollEvents |= EPOLLIN;
+    if (events & ALOOPER_EVENT_OUTPUT) epollEvents |= EPOLLOUT;
+    return epollEvents;
+}
+
+static int looper_from_epoll_events(uint32_t epollEvents) {
+    int events = 0;
+    if (epollEvents & EPOLLIN) events |= ALOOPER_EVENT_INPUT;
+    if (epollEvents & EPOLLOUT) events |= ALOOPER_EVENT_OUTPUT;
+    if (epollEvents & EPOLLERR) events |= ALOOPER_EVENT_ERROR;
+    if (epollEvents & EPOLLHUP) events |= ALOOPER_EVENT_HANGUP;
+    return events;
+}
+
+static int looper_find_request(ALooper* looper, int fd) {
+    for (int i = 0; i < looper->requestCount; i++) {
+        if (looper->requests[i].fd == fd) return i;
+    }
+    return -1;
+}
+
+ALooper* ALooper_forThread(void) {
+    pthread_once(&looper_key_once, looper_key_create);
+    return (ALooper*)pthread_getspecific(looper_key);
+}
+
+ALooper* ALooper_prepare(int opts) {
+    ALooper* looper = ALooper_forThread();
+    if (looper != NULL) {
+        return looper;
+    }
+
+    looper = (ALooper*)calloc(1, sizeof(ALooper));
+    looper->refs = 1;
+    looper->allowNonCallbacks = (opts & ALOOPER_PREPARE_ALLOW_NON_CALLBACKS) != 0;
+    looper->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    looper->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    pthread_mutex_init(&looper->mutex, NULL);
+
+    struct epoll_event item;
+    memset(&item, 0, sizeof(item));
+    item.events = EPOLLIN;
+    item.data.fd = looper->wakeFd;
+    epoll_ctl(looper->epollFd, EPOLL_CTL_ADD, looper->wakeFd, &item);
+
+    pthread_setspecific(looper_key, looper);
+    return looper;
+}
+
+void ALooper_acquire(ALooper* looper) {
+    __atomic_fetch_add(&looper->refs, 1, __ATOMIC_RELAXED);
+}
+
+void ALooper_release(ALooper* looper) {
+    if (__atomic_sub_fetch(&looper->refs, 1, __ATOMIC_ACQ_REL) != 0) {
+        return;
+    }
+    close(looper->epollFd);
+    close(looper->wakeFd);
+    pthread_mutex_destroy(&looper->mutex);
+    free(looper);
+}
+
+void ALooper_wake(ALooper* looper) {
+    uint64_t one = 1;
+    if (write(looper->wakeFd, &one, sizeof(one)) != sizeof(one) && errno != EAGAIN) {
+        LOGE("Could not write wake fd: %s", strerror(errno));
+    }
+}
+
+int ALooper_addFd(ALooper* looper, int fd, int ident, int events,
+        ALooper_callbackFunc callback, void* data) {
+    if (callback == NULL) {
+        if (!looper->allowNonCallbacks || ident < 0) {
+            LOGE("Invalid attempt to add fd %d without callback", fd);
+            return -1;
+        }
+    } else {
+        ident = ALOOPER_POLL_CALLBACK;
+    }
+
+    pthread_mutex_lock(&looper->mutex);
+    int index = looper_find_request(looper, fd);
+    int adding = index < 0;
+    if (adding) {
+        if (looper->requestCount == LOOPER_MAX_FDS) {
+            pthread_mutex_unlock(&looper->mutex);
+            LOGE("Too many fds on looper");
+            return -1;
+        }
+        index = looper->requestCount++;
+    }
+
+    struct looper_request* request = &looper->requests[index];
+    request->fd = fd;
+    request->ident = ident;
+    request->events = events;
+    request->callback = callback;
+    request->data = data;
+
+    struct epoll_event item;
+    memset(&item, 0, sizeof(item));
+    item.events = looper_to_epoll_events(events);
+    item.data.fd = fd;
+    if (epoll_ctl(looper->epollFd, adding ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &item) != 0) {
+        LOGE("Could not add fd %d to epoll: %s", fd, strerror(errno));
+    }
+    pthread_mutex_unlock(&looper->mutex);
+    return 1;
+}
+
+int ALooper_removeFd(ALooper* looper, int fd) {
+    pthread_mutex_lock(&looper->mutex);
+    int index = looper_find_request(looper, fd);
+    if (index < 0) {
+        pthread_mutex_unlock(&looper->mutex);
+        return 0;
+    }
+    epoll_ctl(looper->epollFd, EPOLL_CTL_DEL, fd, NULL);
+    looper->requests[index] = looper->requests[--looper->requestCount];
+
+    // Les rponses dj collectes pour ce fd ne doivent plus tre rendues.
+    for (int i = looper->responseIndex; i < looper->responseCount; i++) {
+        if (looper->responses[i].request.fd == fd) {
+            looper->responses[i].request.ident = ALOOPER_POLL_CALLBACK;
+            looper->responses[i].request.callback = NULL;
+        }
+    }
+    pthread_mutex_unlock(&looper->mutex);
+    return 1;
+}
+
+static int looper_poll_inner(ALooper* looper, int timeoutMillis) {
+    struct epoll_event items[LOOPER_MAX_EVENTS];
+    int count = epoll_wait(looper->epollFd, items, LOOPER_MAX_EVENTS, timeoutMillis);
+    host_counter_add(&host_counters_global.looperWakeups, 1);
+
+    looper->responseCount = 0;
+    looper->responseIndex = 0;
+
+    if (count < 0) {
+        return errno == EINTR ? ALOOPER_POLL_WAKE : ALOOPER_POLL_ERROR;
+    }
+    if (count == 0) {
+        return ALOOPER_POLL_TIMEOUT;
+    }
+
+    int result = ALOOPER_POLL_CALLBACK;
+    pthread_mutex_lock(&looper->mutex);
+    for (int i = 0; i < count; i++) {
+        int fd = items[i].data.fd;
+        if (fd == looper->wakeFd) {
+            uint64_t value;
+            if (read(looper->wakeFd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+                LOGE("Could not read wake fd: %s", strerror(errno));
+            }
+            result = ALOOPER_POLL_WAKE;
+            continue;
+        }
+        int index = looper_find_request(looper, fd);
+        if (index < 0) continue;
+        struct looper_response* response = &looper->responses[looper->responseCount++];
+        response->request = looper->requests[index];
+        response->events = looper_from_epoll_events(items[i].events);
+    }
+    pthread_mutex_unlock(&looper->mutex);
+
+    // Invocation des rappels ; les fd sans rappel sont rendus par ALooper_pollOnce().
+    int invoked = 0;
+    for (int i = 0; i < looper->responseCount; i++) {
+        struct looper_response* response = &looper->responses[i];
+        if (response->request.ident != ALOOPER_POLL_CALLBACK
+                || response->request.callback == NULL) {
+            continue;
+        }
+        int fd = response->request.fd;
+        if (response->request.callback(fd, response->events, response->request.data) == 0) {
+            ALooper_removeFd(looper, fd);
+        }
+        response->request.callback = NULL;
+        invoked = 1;
+    }
+    if (!invoked && result == ALOOPER_POLL_CALLBACK && looper->responseCount == 0) {
+        result = ALOOPER_POLL_TIMEOUT;
+    }
+    return result;
+}
+
+int ALooper_pollOnce(int timeoutMillis, int* outFd, int* outEvents, void** outData) {
+    ALooper* looper = ALooper_forThread();
+    if (looper == NULL) {
+        return ALOOPER_POLL_ERROR;
+    }
+
+    int result = 0;
+    for (;;) {
+        while (looper->responseIndex < looper->responseCount) {
+            struct looper_response* response = &looper->responses[looper->responseIndex++];
+            if (response->request.ident >= 0) {
+                if (outFd != NULL) *outFd = response->request.fd;
+                if (outEvents != NULL) *outEvents = response->events;
+                if (outData != NULL) *outData = response->request.data;
+                return response->request.ident;
+            }
+        }
+
+        if (result != 0) {
+            if (outFd != NULL) *outFd = 0;
+            if (outEvents != NULL) *outEvents = 0;
+            if (outData != NULL) *outData = NULL;
+            return result;
+        }
+
+        result = looper_poll_inner(looper, timeoutMillis);
+    }
+}
+
+int ALooper_pollAll(int timeoutMillis, int* outFd, int* outEvents, void** outData) {
+    if (timeoutMillis <= 0) {
+        int result;
+        do {
+            result = ALooper_pollOnce(timeoutMillis, outFd, outEvents, outData);
+        } while (result == ALOOPER_POLL_CALLBACK);
+        return result;
+    }
+
+    int64_t deadline = host_now_ns() + (int64_t)timeoutMillis * 1000000;
+    for (;;) {
+        int result = ALooper_pollOnce(timeoutMillis, outFd, outEvents, outData);
+        if (result != ALOOPER_POLL_CALLBACK) {
+            return result;
+        }
+        int64_t remaining = deadline - host_now_ns();
+        if (remaining <= 0) {
+            return ALOOPER_POLL_TIMEOUT;
+        }
+        timeoutMillis = (int)((remaining + 999999) / 1000000);
+    }
+}
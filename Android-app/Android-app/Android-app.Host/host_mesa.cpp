@@ -0,0 +1,22 @@
+/*
+ * Symboles du runtime hte ncessaires aux programmes lis  Mesa
+ * (host_egl_check, host_gles_bench).
+ *
+ * Ces programmes n'ont ni activit ni fentre : seuls les symboles utiliss
+ * par display_manager et async_log sont fournis, les messages de log sont
+ * crits sur stderr.
+ */
+
+#include <stdio.h>
+
+#include <android/log.h>
+#include <android/native_window.h>
+
+extern "C" int __android_log_write(int prio, const char* tag, const char* text) {
+    return fprintf(stderr, "%s: %s\n", tag, text);
+}
+
+extern "C" int32_t ANativeWindow_setBuffersGeometry(ANativeWindow* window, int32_t width,
+        int32_t height, int32_t format) {
+    return 0;
+}
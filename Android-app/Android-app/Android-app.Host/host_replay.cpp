@@ -0,0 +1,330 @@
+/*
+ * Rejeu hte d'une trace d'vnements (event_trace.h).
+ *
+ * Le pilote joue le rle du thread principal de l'activit, comme le pilote de
+ * scnarios : chaque commande enregistre redevient le rappel qui l'a produite,
+ * la fentre et la file d'entre sont recres avec les dimensions et la
+ * prsence enregistres, la configuration de l'appareil simul reprend les
+ * champs enregistrs avant chaque APP_CMD_CONFIG_CHANGED. Les vnements
+ * d'entre passent par l'AInputQueue et ceux des capteurs par
+ * l'ASensorEventQueue, avec tous leurs chantillons.
+ *
+ * L'activit est cre au premier enregistrement qui n'est ni l'tat ni la
+ * configuration de dpart, avec l'tat enregistr.
+ *
+ * Avant chaque enregistrement, le pilote attend que l'application ait excut
+ * les commandes prcdentes et lu les chantillons signals : au plus vite,
+ * les chantillons qui suivent le gain du focus arriveraient sinon avant
+ * l'activation du capteur, et la frquence choisie par l'application ne
+ * suivrait plus les chantillons. Avant une commande, il attend aussi que les
+ * vnements d'entre injects soient termins : la perte du focus ou la pause
+ * arriveraient sinon avant eux, et la destruction de la file d'entre
+ * emporterait ses derniers vnements  n'importe quelle vitesse. Les entres
+ * ne sont pas attendues entre elles : l'tage diffr ne les lit qu' l'image
+ * suivante.
+ */
+
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "android_native_app_glue.h"
+#include "event_trace.h"
+#include "host_runtime.h"
+
+// Attente au plus avant une commande.
+#define REPLAY_SETTLE_NS 1000000000LL
+
+struct replay {
+    const char* dataPath;
+    ANativeActivity* activity;
+    ANativeWindow* window;
+    AInputQueue* inputQueue;
+    void* savedState;
+    size_t savedStateSize;
+
+    // Dcalage des instants des capteurs, fix au premier chantillon.
+    int64_t sensorShift;
+    int sensorShiftSet;
+
+    struct host_replay_stats stats;
+};
+
+static void (*replay_create_hook)(ANativeActivity* activity);
+
+void host_replay_set_create_hook(void (*hook)(ANativeActivity* activity)) {
+    replay_create_hook = hook;
+}
+
+static void replay_sleep_until(int64_t due) {
+    struct timespec deadline;
+    deadline.tv_sec = due / 1000000000LL;
+    deadline.tv_nsec = due % 1000000000LL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+    }
+}
+
+// input : vnements d'entre compris.
+static int replay_settled(struct replay* replay, int input) {
+    struct android_app* app = (struct android_app*)replay->activity->instance;
+    if (__atomic_load_n(&app->cmdCompleted, __ATOMIC_SEQ_CST) != app->cmdNextToken) {
+        return 0;
+    }
+    if (input && replay->inputQueue != NULL && host_input_queue_pending(replay->inputQueue) > 0) {
+        return 0;
+    }
+    return host_sensor_pending() == 0;
+}
+
+static void replay_settle(struct replay* replay, int input) {
+    int64_t deadline = host_now_ns() + REPLAY_SETTLE_NS;
+    while (!replay_settled(replay, input)) {
+        if (host_now_ns() >= deadline) {
+            replay->stats.unsettled++;
+            return;
+        }
+        sched_yield();
+    }
+}
+
+static void replay_create(struct replay* replay) {
+    replay->activity = host_activity_create(replay->dataPath);
+    if (replay_create_hook != NULL) {
+        replay_create_hook(replay->activity);
+    }
+    ANativeActivity_onCreate(replay->activity, replay->savedState, replay->savedStateSize);
+}
+
+static void replay_destroy(struct replay* replay) {
+    ANativeActivityCallbacks* callbacks = replay->activity->callbacks;
+    if (replay->window != NULL) {
+        callbacks->onNativeWindowDestroyed(replay->activity, replay->window);
+        ANativeWindow_release(replay->window);
+        replay->window = NULL;
+    }
+    if (replay->inputQueue != NULL) {
+        callbacks->onInputQueueDestroyed(replay->activity, replay->inputQueue);
+        host_input_queue_destroy(replay->inputQueue);
+        replay->inputQueue = NULL;
+    }
+    callbacks->onDestroy(replay->activity);
+    host_activity_destroy(replay->activity);
+    replay->activity = NULL;
+}
+
+static void replay_config(const struct event_trace_config* fields) {
+    AConfiguration* config;
+    host_config_lock(&config);
+    AConfiguration_setOrientation(config, fields->orientation);
+    AConfiguration_setDensity(config, fields->density);
+    AConfiguration_setTouchscreen(config, fields->touchscreen);
+    AConfiguration_setKeyboard(config, fields->keyboard);
+    AConfiguration_setNavigation(config, fields->navigation);
+    AConfiguration_setKeysHidden(config, fields->keysHidden);
+    AConfiguration_setNavHidden(config, fields->navHidden);
+    AConfiguration_setScreenSize(config, fields->screenSize);
+    AConfiguration_setScreenLong(config, fields->screenLong);
+    AConfiguration_setUiModeType(config, fields->uiModeType);
+    AConfiguration_setUiModeNight(config, fields->uiModeNight);
+    host_config_unlock();
+}
+
+// Retourne 0 si la commande n'a pas d'quivalent.
+static int replay_cmd(struct replay* replay, const struct event_trace_record* record) {
+    ANativeActivity* activity = replay->activity;
+    ANativeActivityCallbacks* callbacks = activity->callbacks;
+    switch (record->cmd) {
+        case APP_CMD_INPUT_CHANGED:
+            if (record->argCount > 0 && record->args[0] && replay->inputQueue == NULL) {
+                replay->inputQueue = host_input_queue_create();
+                callbacks->onInputQueueCreated(activity, replay->inputQueue);
+            } else if ((record->argCount == 0 || !record->args[0]) && replay->inputQueue != NULL) {
+                callbacks->onInputQueueDestroyed(activity, replay->inputQueue);
+                host_input_queue_destroy(replay->inputQueue);
+                replay->inputQueue = NULL;
+            }
+            return 1;
+        case APP_CMD_INIT_WINDOW:
+            if (replay->window != NULL || record->argCount < 3) return 0;
+            replay->window = host_window_create(record->args[0], record->args[1], record->args[2]);
+            callbacks->onNativeWindowCreated(activity, replay->window);
+            return 1;
+        case APP_CMD_TERM_WINDOW:
+            if (replay->window == NULL) return 0;
+            callbacks->onNativeWindowDestroyed(activity, replay->window);
+            ANativeWindow_release(replay->window);
+            replay->window = NULL;
+            return 1;
+        case APP_CMD_WINDOW_RESIZED:
+            if (replay->window == NULL || record->argCount < 2) return 0;
+            host_window_resize(replay->window, record->args[0], record->args[1]);
+            if (callbacks->onNativeWindowResized != NULL) {
+                callbacks->onNativeWindowResized(activity, replay->window);
+            }
+            return 1;
+        case APP_CMD_WINDOW_REDRAW_NEEDED:
+            if (replay->window == NULL || callbacks->onNativeWindowRedrawNeeded == NULL) return 0;
+            callbacks->onNativeWindowRedrawNeeded(activity, replay->window);
+            return 1;
+        case APP_CMD_GAINED_FOCUS:
+        case APP_CMD_LOST_FOCUS:
+            callbacks->onWindowFocusChanged(activity, record->cmd == APP_CMD_GAINED_FOCUS);
+            return 1;
+        case APP_CMD_CONFIG_CHANGED:
+            callbacks->onConfigurationChanged(activity);
+            return 1;
+        case APP_CMD_LOW_MEMORY:
+            callbacks->onLowMemory(activity);
+            return 1;
+        case APP_CMD_START:
+            callbacks->onStart(activity);
+            return 1;
+        case APP_CMD_RESUME:
+            callbacks->onResume(activity);
+            return 1;
+        case APP_CMD_PAUSE:
+            callbacks->onPause(activity);
+            return 1;
+        case APP_CMD_STOP:
+            callbacks->onStop(activity);
+            return 1;
+        case APP_CMD_SAVE_STATE: {
+            size_t size = 0;
+            void* state = callbacks->onSaveInstanceState(activity, &size);
+            if (state != NULL) {
+                free(replay->savedState);
+                replay->savedState = state;
+                replay->savedStateSize = size;
+            }
+            return 1;
+        }
+        case APP_CMD_DESTROY:
+            replay_destroy(replay);
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void replay_motion(struct replay* replay, const struct event_trace_motion* motion, int64_t shift) {
+    int64_t eventTimes[EVENT_TRACE_MAX_SAMPLES];
+    for (uint32_t i = 0; i < motion->sampleCount; i++) {
+        eventTimes[i] = motion->eventTime[i] + shift;
+    }
+    host_input_push_motion_at(replay->inputQueue, motion->action, motion->source, motion->deviceId,
+            motion->pointerCount, motion->pointerId, motion->sampleCount, eventTimes, &motion->x[0][0],
+            &motion->y[0][0], &motion->pressure[0][0], EVENT_TRACE_MAX_POINTERS);
+}
+
+int host_replay_run(const char* path, const char* dataPath, float speed, struct host_replay_stats* outStats) {
+    struct event_trace_reader* reader = event_trace_open(path);
+    if (reader == NULL) {
+        fprintf(stderr, "replay: cannot open %s\n", path);
+        return -1;
+    }
+    struct event_trace_record* record = (struct event_trace_record*)malloc(sizeof(struct event_trace_record));
+    struct replay replay;
+    memset(&replay, 0, sizeof(replay));
+    replay.dataPath = dataPath;
+    struct host_replay_stats* stats = &replay.stats;
+
+    int64_t start = host_now_ns();
+    int64_t traceStart = event_trace_start_ns(reader);
+    int result;
+    while ((result = event_trace_next(reader, record)) > 0) {
+        stats->records++;
+        if (record->type == EVENT_TRACE_STATE) {
+            free(replay.savedState);
+            replay.savedState = NULL;
+            replay.savedStateSize = record->stateSize;
+            if (record->stateSize > 0) {
+                replay.savedState = malloc(record->stateSize);
+                memcpy(replay.savedState, record->state, record->stateSize);
+            }
+            continue;
+        }
+        if (record->type == EVENT_TRACE_CONFIG) {
+            replay_config(&record->config);
+            stats->configs++;
+            continue;
+        }
+
+        int64_t due = event_trace_due_ns(start, record->timeNs, speed);
+        int64_t now = host_now_ns();
+        if (due > now) {
+            replay_sleep_until(due);
+            now = host_now_ns();
+        } else if (speed > 0.0f && now - due > stats->maxLateNs) {
+            stats->maxLateNs = now - due;
+        }
+        if (replay.activity == NULL) {
+            replay_create(&replay);
+        } else {
+            replay_settle(&replay, record->type == EVENT_TRACE_CMD);
+        }
+
+        // Les instants d'origine sont dcals sur l'horloge courante.
+        int64_t shift = now - (traceStart + record->timeNs);
+        int played = 1;
+        switch (record->type) {
+            case EVENT_TRACE_CMD:
+                played = replay_cmd(&replay, record);
+                stats->commands += played;
+                break;
+            case EVENT_TRACE_MOTION:
+                played = replay.inputQueue != NULL;
+                if (played) {
+                    replay_motion(&replay, &record->motion, shift);
+                    stats->motions++;
+                }
+                break;
+            case EVENT_TRACE_KEY: {
+                const struct event_trace_key* key = &record->key;
+                played = replay.inputQueue != NULL;
+                if (played) {
+                    host_input_push_key_at(replay.inputQueue, key->action, key->keyCode, key->metaState,
+                            key->repeatCount, key->source, key->deviceId, key->eventTime + shift);
+                    stats->keys++;
+                }
+                break;
+            }
+            case EVENT_TRACE_SENSOR:
+                for (uint32_t i = 0; i < record->sensorCount; i++) {
+                    const struct event_trace_sensor* sensor = &record->sensors[i];
+                    // L'horloge des capteurs de l'appareil n'est pas forcment la mme.
+                    if (!replay.sensorShiftSet) {
+                        replay.sensorShift = now - sensor->timestamp;
+                        replay.sensorShiftSet = 1;
+                    }
+                    host_sensor_push_at(sensor->type, sensor->timestamp + replay.sensorShift,
+                            sensor->values[0], sensor->values[1], sensor->values[2]);
+                }
+                stats->sensorEvents += record->sensorCount;
+                break;
+        }
+        if (!played) {
+            stats->skipped++;
+        }
+    }
+    if (result < 0) {
+        fprintf(stderr, "replay: %s is truncated or corrupt after %llu records\n", path,
+                (unsigned long long)stats->records);
+    }
+    if (replay.activity != NULL) {
+        replay_settle(&replay, 1);
+        replay_destroy(&replay);
+    }
+    stats->durationNs = host_now_ns() - start;
+
+    free(replay.savedState);
+    free(record);
+    event_trace_reader_close(reader);
+    if (outStats != NULL) {
+        *outStats = *stats;
+    }
+    return result < 0 ? -1 : 0;
+}
@@ -0,0 +1,259 @@
+/*
+ * Runtime hte Linux pour android_native_app_glue.
+ *
+ * Ce runtime remplace le framework Android : il fournit des substituts de
+ * l'ALooper, de l'AInputQueue, de l'ASensorEventQueue, de l'AConfiguration,
+ * de l'AAssetManager, d'ANativeWindow et d'EGL, et joue le rle du thread principal de l'activit
+ * en appelant les rappels ANativeActivityCallbacks installs par
+ * ANativeActivity_onCreate(). Le code de collage et android_main() sont
+ * compils sans modification et peuvent ainsi tre profils hors appareil.
+ *
+ * Les fonctions ci-dessous sont rserves au pilote (scnario, benchmarks) ;
+ * elles n'existent pas sur l'appareil.
+ */
+
+#ifndef _HOST_RUNTIME_H
+#define _HOST_RUNTIME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <android/configuration.h>
+#include <android/input.h>
+#include <android/native_activity.h>
+#include <android/sensor.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Compteurs globaux du runtime hte. Ils sont incrments de faon atomique
+ * depuis n'importe quel thread.
+ */
+struct host_counters {
+    // Appels systme read() et write() effectus par le processus.
+    uint64_t reads;
+    uint64_t writes;
+
+    // Retours d'epoll_wait() dans ALooper_pollOnce().
+    uint64_t looperWakeups;
+
+    // vnements d'entre injects, puis termins par AInputQueue_finishEvent().
+    uint64_t inputEvents;
+    uint64_t inputFinished;
+    uint64_t inputHandled;
+
+    // chantillons de capteurs injects, puis lus par ASensorEventQueue_getEvents().
+    uint64_t sensorEvents;
+    uint64_t sensorRead;
+
+    // Capteurs enregistrs (ASensorEventQueue_registerSensor(), enableSensor()) ou dsactivs.
+    uint64_t sensorRegistrations;
+
+    // Appels  eglSwapBuffers(), glClear() et aux fonctions de dessin.
+    uint64_t swaps;
+    uint64_t clears;
+    uint64_t draws;
+
+    // Appels  eglInitialize() russis, contextes et surfaces EGL crs.
+    uint64_t eglInits;
+    uint64_t eglContexts;
+    uint64_t eglSurfaces;
+
+    // Appels  ANativeWindow_unlockAndPost() (rendu logiciel).
+    uint64_t posts;
+
+    // Messages passs  __android_log_print().
+    uint64_t logLines;
+
+    // Tranches ATrace ouvertes, fins sans dbut sur le mme thread, tranches
+    // asynchrones ouvertes et valeurs de compteurs.
+    uint64_t traceSections;
+    uint64_t traceUnbalanced;
+    uint64_t traceAsync;
+    uint64_t traceCounters;
+
+    // Allocations sur le tas (malloc, calloc, realloc, memalign...) de tout le
+    // processus, runtime hte compris, et octets demands.
+    uint64_t allocations;
+    uint64_t allocatedBytes;
+};
+
+void host_counters_get(struct host_counters* out);
+void host_counters_reset(void);
+
+/**
+ * Allocations sur le tas faites par le thread appelant depuis son dmarrage.
+ */
+uint64_t host_thread_allocations(void);
+
+/**
+ * Horloge monotone en nanosecondes.
+ */
+int64_t host_now_ns(void);
+
+/**
+ * Active l'criture des messages de log sur stderr (dsactive par dfaut
+ * pour ne pas fausser les mesures).
+ */
+void host_log_set_verbose(int verbose);
+
+/**
+ * Simulation de la synchronisation verticale : si la priode est non nulle,
+ * eglSwapBuffers() bloque jusqu' la prochaine chance, comme sur l'appareil.
+ */
+void host_egl_set_vsync_period_ns(int64_t period);
+
+/**
+ * Cot GPU simul : chaque prsentation (eglSwapBuffers() ou
+ * ANativeWindow_unlockAndPost()) attend nsPerMegapixel par million de pixels du
+ * tampon prsent. 0 (dfaut) : aucun cot.
+ */
+void host_window_set_fill_cost(int64_t nsPerMegapixel);
+
+/**
+ * Marge thermique rendue par AThermal_getThermalHeadroom() : 0 par dfaut, 1
+ * quand la limitation svre est imminente, NaN pour un appareil sans mesure.
+ */
+void host_thermal_set_headroom(float headroom);
+
+/**
+ * Simulation d'un appareil sans EGL utilisable : si available est nul,
+ * eglInitialize() choue avec EGL_NOT_INITIALIZED.
+ */
+void host_egl_set_available(int available);
+
+/**
+ * Simulation d'une perte de contexte (mise en veille de l'appareil) : la
+ * prochaine prsentation choue avec EGL_CONTEXT_LOST, et le contexte courant
+ * ne peut plus tre rendu courant.
+ */
+void host_egl_lose_context(void);
+
+/**
+ * Cration d'une activit hte prte pour ANativeActivity_onCreate(). Le
+ * rpertoire interne est utilis comme internalDataPath.
+ */
+ANativeActivity* host_activity_create(const char* internalDataPath);
+void host_activity_destroy(ANativeActivity* activity);
+
+/**
+ * Configuration courante de l'appareil simul. Les modifications sont vues par
+ * le prochain AConfiguration_fromAssetManager() ; le pilote doit ensuite
+ * appeler onConfigurationChanged.
+ */
+void host_config_lock(AConfiguration** outConfig);
+void host_config_unlock(void);
+
+/**
+ * Rpertoire des ressources rendues par AAssetManager_open() (par dfaut le
+ * rpertoire courant).
+ */
+void host_asset_set_root(const char* directory);
+
+/**
+ * Fentres natives htes.
+ */
+ANativeWindow* host_window_create(int32_t width, int32_t height, int32_t format);
+void host_window_resize(ANativeWindow* window, int32_t width, int32_t height);
+
+/**
+ * Copie de la dernire image prsente par ANativeWindow_unlockAndPost() dans
+ * pixels, ligne aprs ligne sans remplissage, si elle tient dans capacity
+ * pixels. Retourne le nombre d'images prsentes (0 si aucune), ou -1 si
+ * capacity est insuffisante.
+ */
+int64_t host_window_read(ANativeWindow* window, uint32_t* pixels, size_t capacity,
+        int32_t* outWidth, int32_t* outHeight);
+
+/**
+ * Files d'entre htes. Les vnements injects sont dats avec host_now_ns().
+ * Pour un mouvement, xy contient pointerCount couples (x, y) ; historySize
+ * chantillons historiques interpols sont ajouts avant la position courante.
+ */
+AInputQueue* host_input_queue_create(void);
+void host_input_queue_destroy(AInputQueue* queue);
+void host_input_push_motion(AInputQueue* queue, int32_t action,
+        size_t pointerCount, const float* xy, size_t historySize);
+void host_input_push_key(AInputQueue* queue, int32_t action, int32_t keyCode);
+
+/**
+ * vnements injects dans queue que l'application n'a pas encore termins.
+ */
+int host_input_queue_pending(AInputQueue* queue);
+
+/**
+ * Variantes exactes, pour le rejeu d'une trace : tous les champs sont fournis.
+ * Les sampleCount chantillons d'un mouvement (le courant en dernier) sont lus
+ * dans x, y et pressure  l'indice chantillon * stride + pointeur.
+ */
+void host_input_push_motion_at(AInputQueue* queue, int32_t action, int32_t source, int32_t deviceId,
+        size_t pointerCount, const int32_t* pointerIds, size_t sampleCount, const int64_t* eventTimes,
+        const float* x, const float* y, const float* pressure, size_t stride);
+void host_input_push_key_at(AInputQueue* queue, int32_t action, int32_t keyCode, int32_t metaState,
+        int32_t repeatCount, int32_t source, int32_t deviceId, int64_t eventTime);
+
+/**
+ * Injection d'un chantillon dans toutes les files o le capteur du type
+ * donn est activ.
+ */
+void host_sensor_push(int type, float x, float y, float z);
+
+/**
+ * Variante date, pour le rejeu d'une trace : timestamp remplace host_now_ns().
+ */
+void host_sensor_push_at(int type, int64_t timestamp, float x, float y, float z);
+
+/**
+ * chantillons signals  leur looper et pas encore lus ; ceux qu'une file
+ * garde dans sa FIFO matrielle ne sont pas compts.
+ */
+int host_sensor_pending(void);
+
+/**
+ * Bilan du rejeu d'une trace d'vnements.
+ */
+struct host_replay_stats {
+    uint64_t records;
+    uint64_t commands;
+    uint64_t motions;
+    uint64_t keys;
+    uint64_t sensorEvents;
+    uint64_t configs;
+
+    // Enregistrements sans effet (commande inconnue, entre sans file).
+    uint64_t skipped;
+
+    // Commandes envoyes sans que l'application ait rattrap les vnements
+    // prcdents dans le dlai.
+    uint64_t unsettled;
+
+    // Plus grand retard sur l'chance d'un enregistrement, dure du rejeu.
+    int64_t maxLateNs;
+    int64_t durationNs;
+};
+
+/**
+ * Rejoue la trace path (event_trace.h) en jouant le rle du thread principal de
+ * l'activit, cre avec dataPath comme internalDataPath : rappels du cycle de
+ * vie, configuration, AInputQueue et capteurs, aux instants enregistrs diviss
+ * par speed (0 : au plus vite). Les instants des vnements sont dcals sur
+ * l'horloge courante. Chaque enregistrement attend que l'application ait
+ * rattrap les prcdents (voir host_replay.cpp). L'activit encore vivante  la fin de la trace est
+ * dtruite. Retourne 0, ou -1 si la trace est illisible ou tronque ; outStats
+ * (NULL possible) reoit le bilan.
+ */
+int host_replay_run(const char* path, const char* dataPath, float speed, struct host_replay_stats* outStats);
+
+/**
+ * Fonction appele avec l'activit du rejeu, avant ANativeActivity_onCreate()
+ * (NULL : aucune) ; host_bench y reconnat l'activit du moteur.
+ */
+void host_replay_set_create_hook(void (*hook)(ANativeActivity* activity));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HOST_RUNTIME_H */
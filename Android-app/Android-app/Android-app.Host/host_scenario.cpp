@@ -0,0 +1,556 @@
+/*
+ * Pilote de scnarios du runtime hte.
+ *
+ * Joue le rle du thread principal de l'activit : il cre l'activit, appelle
+ * ANativeActivity_onCreate() puis enchane les rappels du cycle de vie dcrits
+ * par un script, et mesure le temps pass dans chaque rappel.
+ *
+ * Syntaxe du script, une instruction par ligne ( #  commente la ligne) :
+ *
+ *      create | destroy | start | resume | pause | stop | save
+ *      input | input_destroy            cration/destruction de l'AInputQueue
+ *      window <w> <h> | window_destroy  cration/destruction de l'ANativeWindow
+ *      resize <w> <h> | redraw          onNativeWindowResized/RedrawNeeded
+ *      focus <0|1> | lowmem
+ *      config orientation <n> | config density <n> | config night <n>
+ *      touch <x> <y> [historique] | key <code>
+ *      sensor <x> <y> <z>
+ *      thermal <marge> | fill <ns par mgapixel>   marge thermique, cot GPU simul
+ *      wait <ms>
+ *      repeat <n> ... end
+ *
+ * Utilisation : host_app [-n rptitions] [-v] [-g] [-s vsync_us] [-d rpertoire] [-l journal]
+ *                        [-r trace [-x vitesse]] [-t tranches.json] [script]
+ *
+ * -g simule un appareil sans EGL : le moteur passe au rendu logiciel.
+ * -l crit le journal asynchrone de l'application dans un fichier au lieu de stderr.
+ * -r rejoue une trace d'vnements (host_replay.cpp) au lieu du script,  la
+ *    vitesse d'origine multiplie par -x (0 : au plus vite). Une trace s'enregistre
+ *    en crant record_events dans le rpertoire -d : le moteur crit events.trace.
+ * -t exporte  la fin les tranches de trace (sys_trace.h) au format JSON de Chrome.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "host_runtime.h"
+
+#include "async_log.h"
+#include "sys_trace.h"
+
+#define SCENARIO_MAX_STEPS 1024
+#define SCENARIO_MAX_ARGS 4
+
+static const char scenario_default[] =
+    "create\n"
+    "start\n"
+    "resume\n"
+    "input\n"
+    "window 720 1280\n"
+    "focus 1\n"
+    "touch 100 200 4\n"
+    "sensor 0.0 9.81 0.0\n"
+    "config orientation 2\n"
+    "resize 1280 720\n"
+    "focus 0\n"
+    "pause\n"
+    "save\n"
+    "stop\n"
+    "window_destroy\n"
+    "input_destroy\n"
+    "destroy\n";
+
+struct scenario_step {
+    int verb;
+    char key[16];
+    float args[SCENARIO_MAX_ARGS];
+    int argCount;
+    int blockEnd;
+};
+
+struct scenario_stat {
+    uint64_t count;
+    int64_t totalNs;
+    int64_t maxNs;
+};
+
+struct scenario {
+    const char* dataPath;
+    ANativeActivity* activity;
+    ANativeWindow* window;
+    AInputQueue* inputQueue;
+    void* savedState;
+    size_t savedStateSize;
+    uint64_t transitions;
+};
+
+struct scenario_verb {
+    const char* name;
+    int minArgs;
+    int hasKey;
+    void (*run)(struct scenario* scenario, const struct scenario_step* step);
+};
+
+static int scenario_require(struct scenario* scenario, const char* what) {
+    if (scenario->activity == NULL) {
+        fprintf(stderr, "scenario: '%s' without activity\n", what);
+        return 0;
+    }
+    return 1;
+}
+
+static void step_create(struct scenario* scenario, const struct scenario_step* step) {
+    if (scenario->activity != NULL) {
+        fprintf(stderr, "scenario: activity already created\n");
+        return;
+    }
+    scenario->activity = host_activity_create(scenario->dataPath);
+    ANativeActivity_onCreate(scenario->activity, scenario->savedState, scenario->savedStateSize);
+}
+
+static void step_destroy(struct scenario* scenario, const struct scenario_step* step) {
+    if (!scenario_require(scenario, "destroy")) return;
+    scenario->activity->callbacks->onDestroy(scenario->activity);
+    host_activity_destroy(scenario->activity);
+    scenario->activity = NULL;
+}
+
+static void step_start(struct scenario* scenario, const struct scenario_step* step) {
+    if (!scenario_require(scenario, "start")) return;
+    scenario->activity->callbacks->onStart(scenario->activity);
+}
+
+static void step_resume(struct scenario* scenario, const struct scenario_step* step) {
+    if (!scenario_require(scenario, "resume")) return;
+    scenario->activity->callbacks->onResume(scenario->activity);
+}
+
+static void step_pause(struct scenario* scenario, const struct scenario_step* step) {
+    if (!scenario_require(scenario, "pause")) return;
+    scenario->activity->callbacks->onPause(scenario->activity);
+}
+
+static void step_stop(struct scenario* scenario, const struct scenario_step* step) {
+    if (!scenario_require(scenario, "stop")) return;
+    scenario->activity->callbacks->onStop(scenario->activity);
+}
+
+static void step_save(struct scenario* scenario, const struct scenario_step* step) {
+    if (!scenario_require(scenario, "save")) return;
+    size_t size = 0;
+    void* state = scenario->activity->callbacks->onSaveInstanceState(scenario->activity, &size);
+    if (state != NULL) {
+        // Le framework conserve l'tat dans le Bundle jusqu' la prochaine cration.
+        free(scenario->savedState);
+        scenario->savedState = state;
+        scenario->savedStateSize = size;
+    }
+}
+
+static void step_input(struct scenario* scenario, const struct scenario_step* step) {
+    if (!scenario_require(scenario, "input") || scenario->inputQueue != NULL) return;
+    scenario->inputQueue = host_input_queue_create();
+    scenario->activity->callbacks->onInputQueueCreated(scenario->activity, scenario->inputQueue);
+}
+
+static void step_input_destroy(struct scenario* scenario, const struct scenario_step* step) {
+    if (!scenario_require(scenario, "input_destroy") || scenario->inputQueue == NULL) return;
+    scenario->activity->callbacks->onInputQueueDestroyed(scenario->activity, scenario->inputQueue);
+    host_input_queue_destroy(scenario->inputQueue);
+    scenario->inputQueue = NULL;
+}
+
+static void step_window(struct scenario* scenario, const struct scenario_step* step) {
+    if (!scenario_require(scenario, "window") || scenario->window != NULL) return;
+    scenario->window = host_window_create((int32_t)step->args[0], (int32_t)step->args[1],
+            WINDOW_FORMAT_RGBA_8888);
+    scenario->activity->callbacks->onNativeWindowCreated(scenario->activity, scenario->window);
+}
+
+static void step_window_destroy(struct scenario* scenario, const struct scenario_step* step) {
+    if (!scenario_require(scenario, "window_destroy") || scenario->window == NULL) return;
+    scenario->activity->callbacks->onNativeWindowDestroyed(scenario->activity, scenario->window);
+    ANativeWindow_release(scenario->window);
+    scenario->window = NULL;
+}
+
+static void step_resize(struct scenario* scenario, const struct scenario_step* step) {
+    if (!scenario_require(scenario, "resize") || scenario->window == NULL) return;
+    host_window_resize(scenario->window, (int32_t)step->args[0], (int32_t)step->args[1]);
+    if (scenario->activity->callbacks->onNativeWindowResized != NULL) {
+        scenario->activity->callbacks->onNativeWindowResized(scenario->activity, scenario->window);
+    }
+}
+
+static void step_redraw(struct scenario* scenario, const struct scenario_step* step) {
+    if (!scenario_require(scenario, "redraw") || scenario->window == NULL) return;
+    if (scenario->activity->callbacks->onNativeWindowRedrawNeeded != NULL) {
+        scenario->activity->callbacks->onNativeWindowRedrawNeeded(scenario->activity,
+                scenario->window);
+    }
+}
+
+static void step_focus(struct scenario* scenario, const struct scenario_step* step) {
+    if (!scenario_require(scenario, "focus")) return;
+    scenario->activity->callbacks->onWindowFocusChanged(scenario->activity, step->args[0] != 0);
+}
+
+static void step_lowmem(struct scenario* scenario, const struct scenario_step* step) {
+    if (!scenario_require(scenario, "lowmem")) return;
+    scenario->activity->callbacks->onLowMemory(scenario->activity);
+}
+
+static void step_config(struct scenario* scenario, const struct scenario_step* step) {
+    if (!scenario_require(scenario, "config")) return;
+    AConfiguration* config;
+    int32_t value = (int32_t)step->args[0];
+    host_config_lock(&config);
+    if (strcmp(step->key, "orientation") == 0) {
+        AConfiguration_setOrientation(config, value);
+    } else if (strcmp(step->key, "density") == 0) {
+        AConfiguration_setDensity(config, value);
+    } else if (strcmp(step->key, "night") == 0) {
+        AConfiguration_setUiModeNight(config, value);
+    } else {
+        fprintf(stderr, "scenario: unknown config field '%s'\n", step->key);
+    }
+    host_config_unlock();
+    scenario->activity->callbacks->onConfigurationChanged(scenario->activity);
+}
+
+static void step_touch(struct scenario* scenario, const struct scenario_step* step) {
+    if (scenario->inputQueue == NULL) return;
+    float xy[2] = { step->args[0], step->args[1] };
+    size_t history = step->argCount > 2 ? (size_t)step->args[2] : 0;
+    host_input_push_motion(scenario->inputQueue, AMOTION_EVENT_ACTION_MOVE, 1, xy, history);
+}
+
+static void step_key(struct scenario* scenario, const struct scenario_step* step) {
+    if (scenario->inputQueue == NULL) return;
+    host_input_push_key(scenario->inputQueue, AKEY_EVENT_ACTION_DOWN, (int32_t)step->args[0]);
+    host_input_push_key(scenario->inputQueue, AKEY_EVENT_ACTION_UP, (int32_t)step->args[0]);
+}
+
+static void step_sensor(struct scenario* scenario, const struct scenario_step* step) {
+    host_sensor_push(ASENSOR_TYPE_ACCELEROMETER, step->args[0], step->args[1], step->args[2]);
+}
+
+static void step_thermal(struct scenario* scenario, const struct scenario_step* step) {
+    host_thermal_set_headroom(step->args[0]);
+}
+
+static void step_fill(struct scenario* scenario, const struct scenario_step* step) {
+    host_window_set_fill_cost((int64_t)step->args[0]);
+}
+
+static void step_wait(struct scenario* scenario, const struct scenario_step* step) {
+    // chance absolue : un signal reu par le processus (kill -USR2 pour les
+    // mesures de phases) n'courte pas l'attente.
+    int64_t due = host_now_ns() + (int64_t)(step->args[0] * 1000000);
+    struct timespec deadline;
+    deadline.tv_sec = due / 1000000000LL;
+    deadline.tv_nsec = due % 1000000000LL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+    }
+}
+
+enum {
+    VERB_REPEAT,
+    VERB_END,
+    VERB_WAIT,
+};
+
+static const struct scenario_verb scenario_verbs[] = {
+    { "repeat", 1, 0, NULL },
+    { "end", 0, 0, NULL },
+    { "wait", 1, 0, step_wait },
+    { "create", 0, 0, step_create },
+    { "destroy", 0, 0, step_destroy },
+    { "start", 0, 0, step_start },
+    { "resume", 0, 0, step_resume },
+    { "pause", 0, 0, step_pause },
+    { "stop", 0, 0, step_stop },
+    { "save", 0, 0, step_save },
+    { "input", 0, 0, step_input },
+    { "input_destroy", 0, 0, step_input_destroy },
+    { "window", 2, 0, step_window },
+    { "window_destroy", 0, 0, step_window_destroy },
+    { "resize", 2, 0, step_resize },
+    { "redraw", 0, 0, step_redraw },
+    { "focus", 1, 0, step_focus },
+    { "lowmem", 0, 0, step_lowmem },
+    { "config", 1, 1, step_config },
+    { "touch", 2, 0, step_touch },
+    { "key", 1, 0, step_key },
+    { "sensor", 3, 0, step_sensor },
+    { "thermal", 1, 0, step_thermal },
+    { "fill", 1, 0, step_fill },
+};
+
+#define SCENARIO_VERB_COUNT ((int)(sizeof(scenario_verbs) / sizeof(scenario_verbs[0])))
+
+static struct scenario_stat scenario_stats[SCENARIO_VERB_COUNT];
+
+static int scenario_parse(const char* text, struct scenario_step* steps) {
+    int count = 0;
+    int blocks[SCENARIO_MAX_STEPS];
+    int depth = 0;
+    int lineNumber = 0;
+
+    const char* line = text;
+    while (*line != '\0') {
+        const char* next = strchr(line, '\n');
+        size_t length = next != NULL ? (size_t)(next - line) : strlen(line);
+        char buffer[256];
+        if (length >= sizeof(buffer)) length = sizeof(buffer) - 1;
+        memcpy(buffer, line, length);
+        buffer[length] = '\0';
+        line = next != NULL ? next + 1 : line + length;
+        lineNumber++;
+
+        char* comment = strchr(buffer, '#');
+        if (comment != NULL) *comment = '\0';
+        char* token = strtok(buffer, " \t\r");
+        if (token == NULL) continue;
+
+        int verb = -1;
+        for (int i = 0; i < SCENARIO_VERB_COUNT; i++) {
+            if (strcmp(token, scenario_verbs[i].name) == 0) verb = i;
+        }
+        if (verb < 0) {
+            fprintf(stderr, "scenario:%d: unknown instruction '%s'\n", lineNumber, token);
+            return -1;
+        }
+        if (count == SCENARIO_MAX_STEPS) {
+            fprintf(stderr, "scenario:%d: too many instructions\n", lineNumber);
+            return -1;
+        }
+
+        struct scenario_step* step = &steps[count];
+        memset(step, 0, sizeof(*step));
+        step->verb = verb;
+        if (scenario_verbs[verb].hasKey) {
+            token = strtok(NULL, " \t\r");
+            if (token == NULL) {
+                fprintf(stderr, "scenario:%d: missing field\n", lineNumber);
+                return -1;
+            }
+            snprintf(step->key, sizeof(step->key), "%s", token);
+        }
+        while ((token = strtok(NULL, " \t\r")) != NULL && step->argCount < SCENARIO_MAX_ARGS) {
+            step->args[step->argCount++] = strtof(token, NULL);
+        }
+        if (step->argCount < scenario_verbs[verb].minArgs) {
+            fprintf(stderr, "scenario:%d: missing arguments\n", lineNumber);
+            return -1;
+        }
+
+        if (verb == VERB_REPEAT) {
+            blocks[depth++] = count;
+        } else if (verb == VERB_END) {
+            if (depth == 0) {
+                fprintf(stderr, "scenario:%d: 'end' without 'repeat'\n", lineNumber);
+                return -1;
+            }
+            steps[blocks[--depth]].blockEnd = count;
+        }
+        count++;
+    }
+    if (depth != 0) {
+        fprintf(stderr, "scenario: missing 'end'\n");
+        return -1;
+    }
+    return count;
+}
+
+static void scenario_run(struct scenario* scenario, const struct scenario_step* steps,
+        int begin, int end) {
+    for (int i = begin; i < end; i++) {
+        const struct scenario_step* step = &steps[i];
+        if (step->verb == VERB_REPEAT) {
+            for (int r = 0; r < (int)step->args[0]; r++) {
+                scenario_run(scenario, steps, i + 1, step->blockEnd);
+            }
+            i = step->blockEnd;
+            continue;
+        }
+
+        int64_t start = host_now_ns();
+        scenario_verbs[step->verb].run(scenario, step);
+        int64_t elapsed = host_now_ns() - start;
+
+        struct scenario_stat* stat = &scenario_stats[step->verb];
+        stat->count++;
+        stat->totalNs += elapsed;
+        if (elapsed > stat->maxNs) stat->maxNs = elapsed;
+        if (step->verb != VERB_WAIT) scenario->transitions++;
+    }
+}
+
+static char* scenario_load(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        perror(path);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* text = (char*)malloc((size_t)size + 1);
+    size_t read = fread(text, 1, (size_t)size, file);
+    text[read] = '\0';
+    fclose(file);
+    return text;
+}
+
+static void scenario_report(const struct scenario* scenario, int64_t elapsed) {
+    async_log_flush();
+    struct host_counters counters;
+    host_counters_get(&counters);
+    struct async_log_stats log;
+    async_log_get_stats(&log);
+
+    printf("%-16s %10s %12s %12s\n", "callback", "count", "mean_us", "max_us");
+    for (int i = 0; i < SCENARIO_VERB_COUNT; i++) {
+        const struct scenario_stat* stat = &scenario_stats[i];
+        if (stat->count == 0) continue;
+        printf("%-16s %10llu %12.2f %12.2f\n", scenario_verbs[i].name,
+                (unsigned long long)stat->count,
+                stat->totalNs / 1000.0 / (double)stat->count, stat->maxNs / 1000.0);
+    }
+
+    double seconds = elapsed / 1e9;
+    printf("\ntransitions: %llu in %.3f s (%.0f/s)\n",
+            (unsigned long long)scenario->transitions, seconds,
+            scenario->transitions / seconds);
+    printf("syscalls: read=%llu write=%llu looper_wakeups=%llu\n",
+            (unsigned long long)counters.reads, (unsigned long long)counters.writes,
+            (unsigned long long)counters.looperWakeups);
+    printf("input: injected=%llu finished=%llu handled=%llu\n",
+            (unsigned long long)counters.inputEvents, (unsigned long long)counters.inputFinished,
+            (unsigned long long)counters.inputHandled);
+    printf("sensor: injected=%llu read=%llu\n",
+            (unsigned long long)counters.sensorEvents, (unsigned long long)counters.sensorRead);
+    printf("frames: swaps=%llu clears=%llu draws=%llu posts=%llu log_lines=%llu\n",
+            (unsigned long long)counters.swaps, (unsigned long long)counters.clears,
+            (unsigned long long)counters.draws, (unsigned long long)counters.posts,
+            (unsigned long long)counters.logLines);
+    printf("egl: inits=%llu contexts=%llu surfaces=%llu\n",
+            (unsigned long long)counters.eglInits, (unsigned long long)counters.eglContexts,
+            (unsigned long long)counters.eglSurfaces);
+    printf("log: written=%llu dropped=%llu suppressed=%llu flushed=%llu\n",
+            (unsigned long long)log.written, (unsigned long long)log.dropped,
+            (unsigned long long)log.suppressed, (unsigned long long)log.flushed);
+}
+
+static int scenario_export_spans(const char* path) {
+    if (path == NULL) {
+        return 0;
+    }
+    int exported = sys_trace_export_json(path);
+    if (exported < 0) {
+        fprintf(stderr, "spans: cannot write %s\n", path);
+        return -1;
+    }
+    printf("spans: %d events written to %s\n", exported, path);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int iterations = 1;
+    const char* dataPath = "/tmp";
+    const char* replayPath = NULL;
+    float replaySpeed = 1.0f;
+    const char* spansPath = NULL;
+    int option;
+    while ((option = getopt(argc, argv, "n:vgs:d:l:r:x:t:")) != -1) {
+        switch (option) {
+            case 'n':
+                iterations = atoi(optarg);
+                break;
+            case 'v':
+                host_log_set_verbose(1);
+                break;
+            case 'g':
+                host_egl_set_available(0);
+                break;
+            case 's':
+                host_egl_set_vsync_period_ns((int64_t)atoll(optarg) * 1000);
+                break;
+            case 'd':
+                dataPath = optarg;
+                break;
+            case 'l':
+                if (async_log_open_file(optarg) != 0) {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            case 'r':
+                replayPath = optarg;
+                break;
+            case 'x':
+                replaySpeed = strtof(optarg, NULL);
+                break;
+            case 't':
+                spansPath = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n iterations] [-v] [-g] [-s vsync_us] [-d dir] [-l log] "
+                        "[-r trace [-x speed]] [-t spans.json] [script]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    if (replayPath != NULL) {
+        struct host_replay_stats replay;
+        host_counters_reset();
+        int result = host_replay_run(replayPath, dataPath, replaySpeed, &replay);
+        struct scenario scenario;
+        memset(&scenario, 0, sizeof(scenario));
+        scenario.transitions = replay.commands;
+        scenario_report(&scenario, replay.durationNs);
+        printf("replay: records=%llu commands=%llu motions=%llu keys=%llu sensor_events=%llu configs=%llu "
+                "skipped=%llu max_late_us=%.1f\n", (unsigned long long)replay.records,
+                (unsigned long long)replay.commands, (unsigned long long)replay.motions,
+                (unsigned long long)replay.keys, (unsigned long long)replay.sensorEvents,
+                (unsigned long long)replay.configs, (unsigned long long)replay.skipped,
+                replay.maxLateNs / 1000.0);
+        return result == 0 && scenario_export_spans(spansPath) == 0 ? 0 : 1;
+    }
+
+    char* text = optind < argc ? scenario_load(argv[optind]) : strdup(scenario_default);
+    if (text == NULL) {
+        return 1;
+    }
+    static struct scenario_step steps[SCENARIO_MAX_STEPS];
+    int count = scenario_parse(text, steps);
+    free(text);
+    if (count < 0) {
+        return 1;
+    }
+
+    struct scenario scenario;
+    memset(&scenario, 0, sizeof(scenario));
+    scenario.dataPath = dataPath;
+
+    host_counters_reset();
+    int64_t start = host_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        scenario_run(&scenario, steps, 0, count);
+    }
+    int64_t elapsed = host_now_ns() - start;
+
+    if (scenario.activity != NULL) {
+        fprintf(stderr, "scenario: activity still alive at end of script, destroying\n");
+        step_destroy(&scenario, NULL);
+    }
+    free(scenario.savedState);
+
+    scenario_report(&scenario, elapsed);
+    return scenario_export_spans(spansPath) == 0 ? 0 : 1;
+}
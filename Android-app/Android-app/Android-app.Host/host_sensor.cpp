@@ -0,0 +1,265 @@
+/*
+ * ASensorManager et ASensorEventQueue htes.
+ *
+ * Chaque file possde un tampon circulaire et un eventfd attach au looper
+ * donn  ASensorManager_createEventQueue(). host_sensor_push() dpose un
+ * chantillon dans toutes les files o le capteur est activ ; si le tampon
+ * est plein, l'chantillon le plus ancien est perdu, comme dans la FIFO
+ * matrielle.
+ *
+ * La priode d'chantillonnage est respecte en cartant les chantillons trop
+ * rapprochs. Avec une latence de regroupement, le fd n'est signal que quand
+ * le plus ancien chantillon en attente a atteint cette latence ou que la FIFO
+ * matrielle est pleine ; les dates des chantillons servent d'horloge, ce qui
+ * rend le rejeu d'une trace indpendant de sa vitesse.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include <android/log.h>
+#include <android/sensor.h>
+
+#include "host_internal.h"
+
+#define LOGE(...) ((void)__android_log_print(ANDROID_LOG_ERROR, "host_sensor", __VA_ARGS__))
+
+#define SENSOR_QUEUE_CAPACITY 1024
+#define SENSOR_MAX_QUEUES 16
+
+struct ASensor {
+    int type;
+    const char* name;
+    int minDelay;
+    int fifoMaxEventCount;
+};
+
+struct ASensorManager {
+    pthread_mutex_t mutex;
+    ASensorEventQueue* queues[SENSOR_MAX_QUEUES];
+    int queueCount;
+};
+
+struct ASensorEventQueue {
+    ALooper* looper;
+    int eventFd;
+    int signaled;
+    int enabled;
+    int32_t samplingPeriodUs;
+    int64_t maxBatchReportLatencyUs;
+    int64_t lastTimestamp;
+    uint32_t head;
+    uint32_t count;
+    ASensorEvent events[SENSOR_QUEUE_CAPACITY];
+};
+
+static const ASensor sensor_list[] = {
+    { ASENSOR_TYPE_ACCELEROMETER, "Host Accelerometer", 5000, 600 },
+    { ASENSOR_TYPE_GYROSCOPE, "Host Gyroscope", 5000, 600 },
+};
+
+static ASensorManager sensor_manager = { PTHREAD_MUTEX_INITIALIZER, { NULL }, 0 };
+
+static const ASensor* sensor_find(int type) {
+    for (size_t i = 0; i < sizeof(sensor_list) / sizeof(sensor_list[0]); i++) {
+        if (sensor_list[i].type == type) return &sensor_list[i];
+    }
+    return NULL;
+}
+
+static int sensor_queue_bit(ASensor const* sensor) {
+    return 1 << (int)(sensor - sensor_list);
+}
+
+static void sensor_queue_signal(ASensorEventQueue* queue, int signaled) {
+    uint64_t value = 1;
+    if (signaled && !queue->signaled) {
+        if (write(queue->eventFd, &value, sizeof(value)) != sizeof(value)) {
+            LOGE("Could not signal sensor queue: %s", strerror(errno));
+        }
+    } else if (!signaled && queue->signaled) {
+        if (read(queue->eventFd, &value, sizeof(value)) != sizeof(value)) {
+            LOGE("Could not clear sensor queue: %s", strerror(errno));
+        }
+    }
+    queue->signaled = signaled;
+}
+
+ASensorManager* ASensorManager_getInstance(void) {
+    return &sensor_manager;
+}
+
+ASensor const* ASensorManager_getDefaultSensor(ASensorManager* manager, int type) {
+    return sensor_find(type);
+}
+
+ASensorEventQueue* ASensorManager_createEventQueue(ASensorManager* manager,
+        ALooper* looper, int ident, ALooper_callbackFunc callback, void* data) {
+    pthread_mutex_lock(&manager->mutex);
+    if (manager->queueCount == SENSOR_MAX_QUEUES) {
+        pthread_mutex_unlock(&manager->mutex);
+        LOGE("Too many sensor event queues");
+        return NULL;
+    }
+    ASensorEventQueue* queue = (ASensorEventQueue*)calloc(1, sizeof(ASensorEventQueue));
+    queue->looper = looper;
+    queue->eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    manager->queues[manager->queueCount++] = queue;
+    pthread_mutex_unlock(&manager->mutex);
+
+    ALooper_addFd(looper, queue->eventFd, ident, ALOOPER_EVENT_INPUT, callback, data);
+    return queue;
+}
+
+int ASensorManager_destroyEventQueue(ASensorManager* manager, ASensorEventQueue* queue) {
+    pthread_mutex_lock(&manager->mutex);
+    for (int i = 0; i < manager->queueCount; i++) {
+        if (manager->queues[i] == queue) {
+            manager->queues[i] = manager->queues[--manager->queueCount];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&manager->mutex);
+
+    ALooper_removeFd(queue->looper, queue->eventFd);
+    close(queue->eventFd);
+    free(queue);
+    return 0;
+}
+
+int ASensorEventQueue_registerSensor(ASensorEventQueue* queue, ASensor const* sensor,
+        int32_t samplingPeriodUs, int64_t maxBatchReportLatencyUs) {
+    pthread_mutex_lock(&sensor_manager.mutex);
+    queue->enabled |= sensor_queue_bit(sensor);
+    queue->lastTimestamp = 0;
+    queue->samplingPeriodUs = samplingPeriodUs;
+    queue->maxBatchReportLatencyUs = maxBatchReportLatencyUs;
+    pthread_mutex_unlock(&sensor_manager.mutex);
+    host_counter_add(&host_counters_global.sensorRegistrations, 1);
+    return 0;
+}
+
+int ASensorEventQueue_enableSensor(ASensorEventQueue* queue, ASensor const* sensor) {
+    return ASensorEventQueue_registerSensor(queue, sensor, sensor->minDelay, 0);
+}
+
+int ASensorEventQueue_disableSensor(ASensorEventQueue* queue, ASensor const* sensor) {
+    pthread_mutex_lock(&sensor_manager.mutex);
+    queue->enabled &= ~sensor_queue_bit(sensor);
+    pthread_mutex_unlock(&sensor_manager.mutex);
+    host_counter_add(&host_counters_global.sensorRegistrations, 1);
+    return 0;
+}
+
+int ASensorEventQueue_setEventRate(ASensorEventQueue* queue, ASensor const* sensor, int32_t usec) {
+    pthread_mutex_lock(&sensor_manager.mutex);
+    queue->samplingPeriodUs = usec;
+    pthread_mutex_unlock(&sensor_manager.mutex);
+    return 0;
+}
+
+int ASensorEventQueue_hasEvents(ASensorEventQueue* queue) {
+    pthread_mutex_lock(&sensor_manager.mutex);
+    int result = queue->count > 0 ? 1 : 0;
+    pthread_mutex_unlock(&sensor_manager.mutex);
+    return result;
+}
+
+ssize_t ASensorEventQueue_getEvents(ASensorEventQueue* queue, ASensorEvent* events, size_t count) {
+    pthread_mutex_lock(&sensor_manager.mutex);
+    size_t n = 0;
+    while (n < count && queue->count > 0) {
+        events[n++] = queue->events[queue->head];
+        queue->head = (queue->head + 1) % SENSOR_QUEUE_CAPACITY;
+        queue->count--;
+    }
+    if (queue->count == 0) {
+        sensor_queue_signal(queue, 0);
+    }
+    pthread_mutex_unlock(&sensor_manager.mutex);
+    host_counter_add(&host_counters_global.sensorRead, n);
+    return (ssize_t)n;
+}
+
+const char* ASensor_getName(ASensor const* sensor) {
+    return sensor->name;
+}
+
+int ASensor_getType(ASensor const* sensor) {
+    return sensor->type;
+}
+
+int ASensor_getMinDelay(ASensor const* sensor) {
+    return sensor->minDelay;
+}
+
+int ASensor_getFifoMaxEventCount(ASensor const* sensor) {
+    return sensor->fifoMaxEventCount;
+}
+
+int host_sensor_pending(void) {
+    int result = 0;
+    pthread_mutex_lock(&sensor_manager.mutex);
+    for (int i = 0; i < sensor_manager.queueCount; i++) {
+        ASensorEventQueue* queue = sensor_manager.queues[i];
+        if (queue->signaled) {
+            result += (int)queue->count;
+        }
+    }
+    pthread_mutex_unlock(&sensor_manager.mutex);
+    return result;
+}
+
+void host_sensor_push(int type, float x, float y, float z) {
+    host_sensor_push_at(type, host_now_ns(), x, y, z);
+}
+
+void host_sensor_push_at(int type, int64_t timestamp, float x, float y, float z) {
+    const ASensor* sensor = sensor_find(type);
+    if (sensor == NULL) {
+        return;
+    }
+
+    ASensorEvent event;
+    memset(&event, 0, sizeof(event));
+    event.version = sizeof(event);
+    event.sensor = (int32_t)(sensor - sensor_list);
+    event.type = type;
+    event.timestamp = timestamp;
+    event.vector.x = x;
+    event.vector.y = y;
+    event.vector.z = z;
+
+    host_counter_add(&host_counters_global.sensorEvents, 1);
+    pthread_mutex_lock(&sensor_manager.mutex);
+    for (int i = 0; i < sensor_manager.queueCount; i++) {
+        ASensorEventQueue* queue = sensor_manager.queues[i];
+        if ((queue->enabled & sensor_queue_bit(sensor)) == 0) {
+            continue;
+        }
+        // Tolrance d'un huitime de priode sur la gigue de l'chantillonnage.
+        int64_t period = (int64_t)queue->samplingPeriodUs * 1000;
+        if (queue->lastTimestamp != 0 && timestamp - queue->lastTimestamp < period - period / 8) {
+            continue;
+        }
+        queue->lastTimestamp = timestamp;
+        uint32_t tail = (queue->head + queue->count) % SENSOR_QUEUE_CAPACITY;
+        queue->events[tail] = event;
+        if (queue->count == SENSOR_QUEUE_CAPACITY) {
+            queue->head = (queue->head + 1) % SENSOR_QUEUE_CAPACITY;
+        } else {
+            queue->count++;
+        }
+        const ASensorEvent* oldest = &queue->events[queue->head];
+        if (queue->maxBatchReportLatencyUs == 0
+                || queue->count >= (uint32_t)sensor->fifoMaxEventCount
+                || timestamp - oldest->timestamp >= queue->maxBatchReportLatencyUs * 1000) {
+            sensor_queue_signal(queue, 1);
+        }
+    }
+    pthread_mutex_unlock(&sensor_manager.mutex);
+}
@@ -0,0 +1,36 @@
+/*
+ * Marge thermique hte.
+ *
+ * AThermal_getThermalHeadroom() rend la valeur fixe par le pilote
+ * (host_thermal_set_headroom()), 0 par dfaut : aucun chauffement. Comme sur
+ * l'appareil, le moteur trouve ces fonctions avec dlsym() : les programmes htes
+ * exportent leurs symboles (-rdynamic).
+ */
+
+#include <android/thermal.h>
+
+#include "host_internal.h"
+
+struct AThermalManager {
+    int unused;
+};
+
+static AThermalManager host_thermal_manager;
+static float host_thermal_headroom;
+
+void host_thermal_set_headroom(float headroom) {
+    __atomic_store(&host_thermal_headroom, &headroom, __ATOMIC_RELAXED);
+}
+
+AThermalManager* AThermal_acquireManager(void) {
+    return &host_thermal_manager;
+}
+
+void AThermal_releaseManager(AThermalManager* manager) {
+}
+
+float AThermal_getThermalHeadroom(AThermalManager* manager, int forecastSeconds) {
+    float headroom;
+    __atomic_load(&host_thermal_headroom, &headroom, __ATOMIC_RELAXED);
+    return headroom;
+}
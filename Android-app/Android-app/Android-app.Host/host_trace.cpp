@@ -0,0 +1,44 @@
+/*
+ * ATrace hte.
+ *
+ * Les marqueurs ne vont nulle part : ils sont compts (host_counters), et une
+ * fin de tranche sans dbut sur le mme thread est compte  part, ce qui
+ * vrifie l'appariement fait par le moteur. Comme sur l'appareil, le moteur
+ * trouve ces fonctions avec dlsym() : les programmes htes exportent leurs
+ * symboles (-rdynamic).
+ */
+
+#include <android/trace.h>
+
+#include "host_internal.h"
+
+// Tranches ouvertes par le thread courant.
+static __thread int host_trace_depth;
+
+int ATrace_isEnabled(void) {
+    return 1;
+}
+
+void ATrace_beginSection(const char* sectionName) {
+    host_trace_depth++;
+    host_counter_add(&host_counters_global.traceSections, 1);
+}
+
+void ATrace_endSection(void) {
+    if (host_trace_depth == 0) {
+        host_counter_add(&host_counters_global.traceUnbalanced, 1);
+        return;
+    }
+    host_trace_depth--;
+}
+
+void ATrace_beginAsyncSection(const char* sectionName, int32_t cookie) {
+    host_counter_add(&host_counters_global.traceAsync, 1);
+}
+
+void ATrace_endAsyncSection(const char* sectionName, int32_t cookie) {
+}
+
+void ATrace_setCounter(const char* counterName, int64_t counterValue) {
+    host_counter_add(&host_counters_global.traceCounters, 1);
+}
@@ -0,0 +1,247 @@
+/*
+ * ANativeWindow et log htes.
+ *
+ * Le rendu logiciel crit rellement dans les tampons de la fentre, lisibles
+ * par host_window_read(). Si une priode de synchronisation verticale est
+ * dfinie, ANativeWindow_unlockAndPost() et eglSwapBuffers() (host_egl.cpp)
+ * bloquent jusqu' la prochaine chance. Avec un cot de remplissage, elles
+ * attendent d'abord le temps que mettrait le GPU  remplir le tampon prsent,
+ * proportionnel  sa surface.
+ */
+
+#include <stdarg.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <android/log.h>
+#include <android/native_window.h>
+
+#include "host_internal.h"
+
+static int host_log_verbose;
+static int64_t host_vsync_period;
+static int64_t host_vsync_next;
+static int64_t host_fill_cost;
+
+void host_log_set_verbose(int verbose) {
+    host_log_verbose = verbose;
+}
+
+void host_egl_set_vsync_period_ns(int64_t period) {
+    host_vsync_period = period;
+    host_vsync_next = 0;
+}
+
+void host_window_set_fill_cost(int64_t nsPerMegapixel) {
+    __atomic_store_n(&host_fill_cost, nsPerMegapixel, __ATOMIC_RELAXED);
+}
+
+void host_fill_wait(int32_t width, int32_t height) {
+    int64_t cost = __atomic_load_n(&host_fill_cost, __ATOMIC_RELAXED);
+    if (cost <= 0 || width <= 0 || height <= 0) {
+        return;
+    }
+    int64_t duration = (int64_t)width * height * cost / 1000000;
+    struct timespec delay;
+    delay.tv_sec = duration / 1000000000LL;
+    delay.tv_nsec = duration % 1000000000LL;
+    while (nanosleep(&delay, &delay) != 0 && errno == EINTR) {
+    }
+}
+
+void host_vsync_wait(void) {
+    if (host_vsync_period <= 0) {
+        return;
+    }
+
+    int64_t now = host_now_ns();
+    if (host_vsync_next == 0) {
+        host_vsync_next = now + host_vsync_period;
+    } else if (host_vsync_next <= now) {
+        // Image en retard : comme sur l'appareil, la prsentation attend la
+        // prochaine synchronisation verticale sans dcaler leur phase.
+        host_vsync_next += ((now - host_vsync_next) / host_vsync_period + 1) * host_vsync_period;
+    }
+    struct timespec deadline;
+    deadline.tv_sec = host_vsync_next / 1000000000LL;
+    deadline.tv_nsec = host_vsync_next % 1000000000LL;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+    host_vsync_next += host_vsync_period;
+}
+
+// --------------------------------------------------------------------
+// Log
+// --------------------------------------------------------------------
+
+int __android_log_vprint(int prio, const char* tag, const char* fmt, va_list ap) {
+    static const char priorities[] = "??VDIWEFS";
+    host_counter_add(&host_counters_global.logLines, 1);
+
+    // Le message est toujours mis en forme, comme par liblog avant l'envoi 
+    // logd, pour que le cot d'un journal reste mesurable sans verbosit.
+    char line[1024];
+    int length = vsnprintf(line, sizeof(line), fmt, ap);
+    if (!host_log_verbose && prio < ANDROID_LOG_ERROR) {
+        return 0;
+    }
+    if (length > 0 && length < (int)sizeof(line) && line[length - 1] == '\n') {
+        line[length - 1] = '\0';
+    }
+    return fprintf(stderr, "%c/%s: %s\n", priorities[prio & 7], tag, line);
+}
+
+int __android_log_print(int prio, const char* tag, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int result = __android_log_vprint(prio, tag, fmt, ap);
+    va_end(ap);
+    return result;
+}
+
+int __android_log_write(int prio, const char* tag, const char* text) {
+    return __android_log_print(prio, tag, "%s", text);
+}
+
+// --------------------------------------------------------------------
+// Fentre native
+// --------------------------------------------------------------------
+
+ANativeWindow* host_window_create(int32_t width, int32_t height, int32_t format) {
+    ANativeWindow* window = (ANativeWindow*)calloc(1, sizeof(ANativeWindow));
+    window->refs = 1;
+    window->width = width;
+    window->height = height;
+    window->format = format;
+    pthread_mutex_init(&window->mutex, NULL);
+    return window;
+}
+
+// La taille est modifie par le pilote pendant que l'application peut la lire.
+void host_window_resize(ANativeWindow* window, int32_t width, int32_t height) {
+    __atomic_store_n(&window->width, width, __ATOMIC_RELAXED);
+    __atomic_store_n(&window->height, height, __ATOMIC_RELAXED);
+}
+
+void ANativeWindow_acquire(ANativeWindow* window) {
+    __atomic_fetch_add(&window->refs, 1, __ATOMIC_RELAXED);
+}
+
+void ANativeWindow_release(ANativeWindow* window) {
+    if (__atomic_sub_fetch(&window->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(window->pixels[0]);
+        free(window->pixels[1]);
+        pthread_mutex_destroy(&window->mutex);
+        free(window);
+    }
+}
+
+int32_t ANativeWindow_getWidth(ANativeWindow* window) {
+    return window->bufferWidth != 0 ? window->bufferWidth
+            : __atomic_load_n(&window->width, __ATOMIC_RELAXED);
+}
+
+int32_t ANativeWindow_getHeight(ANativeWindow* window) {
+    return window->bufferHeight != 0 ? window->bufferHeight
+            : __atomic_load_n(&window->height, __ATOMIC_RELAXED);
+}
+
+int32_t ANativeWindow_getFormat(ANativeWindow* window) {
+    return window->bufferFormat != 0 ? window->bufferFormat : window->format;
+}
+
+int32_t ANativeWindow_setBuffersGeometry(ANativeWindow* window,
+        int32_t width, int32_t height, int32_t format) {
+    window->bufferWidth = width;
+    window->bufferHeight = height;
+    window->bufferFormat = format;
+    return 0;
+}
+
+int32_t ANativeWindow_lock(ANativeWindow* window, ANativeWindow_Buffer* outBuffer,
+        ARect* inOutDirtyBounds) {
+    int32_t format = ANativeWindow_getFormat(window);
+    if (window->locked || (format != WINDOW_FORMAT_RGBA_8888 && format != WINDOW_FORMAT_RGBX_8888)) {
+        return -EINVAL;
+    }
+    int32_t width = ANativeWindow_getWidth(window);
+    int32_t height = ANativeWindow_getHeight(window);
+    if (width != window->pixelsWidth || height != window->pixelsHeight) {
+        // Nouvelle taille : les deux tampons sont rallous, avec des lignes
+        // alignes sur 16 pixels comme celles de gralloc.
+        int32_t stride = (width + 15) & ~15;
+        size_t size = (size_t)stride * height * sizeof(uint32_t);
+        uint32_t* back = (uint32_t*)calloc(1, size > 0 ? size : 1);
+        uint32_t* front = (uint32_t*)calloc(1, size > 0 ? size : 1);
+        if (back == NULL || front == NULL) {
+            free(back);
+            free(front);
+            return -ENOMEM;
+        }
+        pthread_mutex_lock(&window->mutex);
+        free(window->pixels[0]);
+        free(window->pixels[1]);
+        window->pixels[0] = front;
+        window->pixels[1] = back;
+        window->front = 0;
+        window->pixelsWidth = width;
+        window->pixelsHeight = height;
+        window->pixelsStride = stride;
+        pthread_mutex_unlock(&window->mutex);
+    }
+
+    outBuffer->width = width;
+    outBuffer->height = height;
+    outBuffer->stride = window->pixelsStride;
+    outBuffer->format = format;
+    outBuffer->bits = window->pixels[window->front ^ 1];
+    if (inOutDirtyBounds != NULL) {
+        // Le contenu du tampon arrire n'est pas conserv : tout est  redessiner.
+        inOutDirtyBounds->left = 0;
+        inOutDirtyBounds->top = 0;
+        inOutDirtyBounds->right = width;
+        inOutDirtyBounds->bottom = height;
+    }
+    window->locked = 1;
+    return 0;
+}
+
+int32_t ANativeWindow_unlockAndPost(ANativeWindow* window) {
+    if (!window->locked) {
+        return -EINVAL;
+    }
+    window->locked = 0;
+    pthread_mutex_lock(&window->mutex);
+    window->front ^= 1;
+    window->posts++;
+    pthread_mutex_unlock(&window->mutex);
+    host_counter_add(&host_counters_global.posts, 1);
+    host_fill_wait(ANativeWindow_getWidth(window), ANativeWindow_getHeight(window));
+    host_vsync_wait();
+    return 0;
+}
+
+int64_t host_window_read(ANativeWindow* window, uint32_t* pixels, size_t capacity,
+        int32_t* outWidth, int32_t* outHeight) {
+    pthread_mutex_lock(&window->mutex);
+    int32_t width = window->pixelsWidth;
+    int32_t height = window->pixelsHeight;
+    int64_t posts = (int64_t)window->posts;
+    if ((size_t)width * height > capacity) {
+        pthread_mutex_unlock(&window->mutex);
+        return -1;
+    }
+    if (posts > 0) {
+        const uint32_t* front = window->pixels[window->front];
+        for (int32_t y = 0; y < height; y++) {
+            memcpy(pixels + (size_t)y * width, front + (size_t)y * window->pixelsStride,
+                    width * sizeof(uint32_t));
+        }
+    }
+    pthread_mutex_unlock(&window->mutex);
+    *outWidth = width;
+    *outHeight = height;
+    return posts;
+}
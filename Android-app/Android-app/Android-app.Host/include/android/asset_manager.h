@@ -0,0 +1,45 @@
+/*
+ * Substitut hte de <android/asset_manager.h>.
+ *
+ * L'AAssetManager hte porte la configuration courante de l'appareil simul,
+ * lue par AConfiguration_fromAssetManager(). Ses ressources sont les fichiers
+ * d'un rpertoire (host_asset_set_root()).
+ */
+
+#ifndef _HOST_ANDROID_ASSET_MANAGER_H
+#define _HOST_ANDROID_ASSET_MANAGER_H
+
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct AAssetManager;
+typedef struct AAssetManager AAssetManager;
+
+struct AAsset;
+typedef struct AAsset AAsset;
+
+enum {
+    AASSET_MODE_UNKNOWN = 0,
+    AASSET_MODE_RANDOM = 1,
+    AASSET_MODE_STREAMING = 2,
+    AASSET_MODE_BUFFER = 3
+};
+
+AAsset* AAssetManager_open(AAssetManager* mgr, const char* filename, int mode);
+
+int AAsset_read(AAsset* asset, void* buf, size_t count);
+off_t AAsset_seek(AAsset* asset, off_t offset, int whence);
+void AAsset_close(AAsset* asset);
+off_t AAsset_getLength(AAsset* asset);
+off_t AAsset_getRemainingLength(AAsset* asset);
+int AAsset_openFileDescriptor(AAsset* asset, off_t* outStart, off_t* outLength);
+int AAsset_isAllocated(AAsset* asset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HOST_ANDROID_ASSET_MANAGER_H */
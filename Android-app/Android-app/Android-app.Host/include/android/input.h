@@ -0,0 +1,110 @@
+/*
+ * Substitut hte de <android/input.h>.
+ *
+ * Les vnements sont produits par host_input_push_*() (voir host_runtime.h)
+ * et consomms par l'AInputQueue attache au looper de l'application.
+ */
+
+#ifndef _HOST_ANDROID_INPUT_H
+#define _HOST_ANDROID_INPUT_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <android/looper.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    AKEY_STATE_UNKNOWN = -1,
+    AKEY_STATE_UP = 0,
+    AKEY_STATE_DOWN = 1,
+};
+
+enum {
+    AKEYCODE_UNKNOWN = 0,
+    AKEYCODE_BACK = 4,
+    AKEYCODE_VOLUME_UP = 24,
+    AKEYCODE_VOLUME_DOWN = 25,
+};
+
+struct AInputEvent;
+typedef struct AInputEvent AInputEvent;
+
+enum {
+    AINPUT_EVENT_TYPE_KEY = 1,
+    AINPUT_EVENT_TYPE_MOTION = 2,
+};
+
+enum {
+    AKEY_EVENT_ACTION_DOWN = 0,
+    AKEY_EVENT_ACTION_UP = 1,
+    AKEY_EVENT_ACTION_MULTIPLE = 2,
+};
+
+#define AMOTION_EVENT_ACTION_POINTER_INDEX_SHIFT 8
+
+enum {
+    AMOTION_EVENT_ACTION_MASK = 0xff,
+    AMOTION_EVENT_ACTION_POINTER_INDEX_MASK = 0xff00,
+    AMOTION_EVENT_ACTION_DOWN = 0,
+    AMOTION_EVENT_ACTION_UP = 1,
+    AMOTION_EVENT_ACTION_MOVE = 2,
+    AMOTION_EVENT_ACTION_CANCEL = 3,
+    AMOTION_EVENT_ACTION_OUTSIDE = 4,
+    AMOTION_EVENT_ACTION_POINTER_DOWN = 5,
+    AMOTION_EVENT_ACTION_POINTER_UP = 6,
+};
+
+enum {
+    AINPUT_SOURCE_CLASS_BUTTON = 0x00000001,
+    AINPUT_SOURCE_CLASS_POINTER = 0x00000002,
+    AINPUT_SOURCE_KEYBOARD = 0x00000100 | AINPUT_SOURCE_CLASS_BUTTON,
+    AINPUT_SOURCE_TOUCHSCREEN = 0x00001000 | AINPUT_SOURCE_CLASS_POINTER,
+};
+
+int32_t AInputEvent_getType(const AInputEvent* event);
+int32_t AInputEvent_getDeviceId(const AInputEvent* event);
+int32_t AInputEvent_getSource(const AInputEvent* event);
+
+int32_t AKeyEvent_getAction(const AInputEvent* key_event);
+int32_t AKeyEvent_getKeyCode(const AInputEvent* key_event);
+int32_t AKeyEvent_getRepeatCount(const AInputEvent* key_event);
+int32_t AKeyEvent_getMetaState(const AInputEvent* key_event);
+int64_t AKeyEvent_getEventTime(const AInputEvent* key_event);
+
+int32_t AMotionEvent_getAction(const AInputEvent* motion_event);
+int64_t AMotionEvent_getEventTime(const AInputEvent* motion_event);
+size_t AMotionEvent_getPointerCount(const AInputEvent* motion_event);
+int32_t AMotionEvent_getPointerId(const AInputEvent* motion_event, size_t pointer_index);
+float AMotionEvent_getX(const AInputEvent* motion_event, size_t pointer_index);
+float AMotionEvent_getY(const AInputEvent* motion_event, size_t pointer_index);
+float AMotionEvent_getPressure(const AInputEvent* motion_event, size_t pointer_index);
+size_t AMotionEvent_getHistorySize(const AInputEvent* motion_event);
+int64_t AMotionEvent_getHistoricalEventTime(const AInputEvent* motion_event,
+        size_t history_index);
+float AMotionEvent_getHistoricalX(const AInputEvent* motion_event, size_t pointer_index,
+        size_t history_index);
+float AMotionEvent_getHistoricalY(const AInputEvent* motion_event, size_t pointer_index,
+        size_t history_index);
+float AMotionEvent_getHistoricalPressure(const AInputEvent* motion_event,
+        size_t pointer_index, size_t history_index);
+
+struct AInputQueue;
+typedef struct AInputQueue AInputQueue;
+
+void AInputQueue_attachLooper(AInputQueue* queue, ALooper* looper,
+        int ident, ALooper_callbackFunc callback, void* data);
+void AInputQueue_detachLooper(AInputQueue* queue);
+int32_t AInputQueue_hasEvents(AInputQueue* queue);
+int32_t AInputQueue_getEvent(AInputQueue* queue, AInputEvent** outEvent);
+int32_t AInputQueue_preDispatchEvent(AInputQueue* queue, AInputEvent* event);
+void AInputQueue_finishEvent(AInputQueue* queue, AInputEvent* event, int handled);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HOST_ANDROID_INPUT_H */
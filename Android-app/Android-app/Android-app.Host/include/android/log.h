@@ -0,0 +1,40 @@
+/*
+ * Substitut hte de <android/log.h>.
+ *
+ * Les messages sont compts et, si le runtime hte est en mode verbeux, crits
+ * sur stderr avec le mme prfixe de priorit que logcat.
+ */
+
+#ifndef _HOST_ANDROID_LOG_H
+#define _HOST_ANDROID_LOG_H
+
+#include <stdarg.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum android_LogPriority {
+    ANDROID_LOG_UNKNOWN = 0,
+    ANDROID_LOG_DEFAULT,
+    ANDROID_LOG_VERBOSE,
+    ANDROID_LOG_DEBUG,
+    ANDROID_LOG_INFO,
+    ANDROID_LOG_WARN,
+    ANDROID_LOG_ERROR,
+    ANDROID_LOG_FATAL,
+    ANDROID_LOG_SILENT,
+} android_LogPriority;
+
+int __android_log_write(int prio, const char* tag, const char* text);
+
+int __android_log_print(int prio, const char* tag, const char* fmt, ...)
+        __attribute__((format(printf, 3, 4)));
+
+int __android_log_vprint(int prio, const char* tag, const char* fmt, va_list ap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HOST_ANDROID_LOG_H */
@@ -0,0 +1,25 @@
+/*
+ * Substitut hte de <android/rect.h>.
+ */
+
+#ifndef _HOST_ANDROID_RECT_H
+#define _HOST_ANDROID_RECT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ARect {
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+} ARect;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HOST_ANDROID_RECT_H */
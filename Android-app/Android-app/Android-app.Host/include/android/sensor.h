@@ -0,0 +1,101 @@
+/*
+ * Substitut hte de <android/sensor.h>.
+ *
+ * Les chantillons sont injects par host_sensor_push() (voir host_runtime.h)
+ * dans chaque file d'vnements o le capteur correspondant est activ.
+ */
+
+#ifndef _HOST_ANDROID_SENSOR_H
+#define _HOST_ANDROID_SENSOR_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <android/looper.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    ASENSOR_TYPE_ACCELEROMETER = 1,
+    ASENSOR_TYPE_MAGNETIC_FIELD = 2,
+    ASENSOR_TYPE_GYROSCOPE = 4,
+    ASENSOR_TYPE_LIGHT = 5,
+    ASENSOR_TYPE_PROXIMITY = 8,
+};
+
+#define ASENSOR_STANDARD_GRAVITY (9.80665f)
+
+typedef struct ASensorVector {
+    union {
+        float v[3];
+        struct {
+            float x;
+            float y;
+            float z;
+        };
+        struct {
+            float azimuth;
+            float pitch;
+            float roll;
+        };
+    };
+    int8_t status;
+    uint8_t reserved[3];
+} ASensorVector;
+
+typedef struct ASensorEvent {
+    int32_t version;
+    int32_t sensor;
+    int32_t type;
+    int32_t reserved0;
+    int64_t timestamp;
+    union {
+        float data[16];
+        ASensorVector vector;
+        ASensorVector acceleration;
+        ASensorVector magnetic;
+        float temperature;
+        float distance;
+        float light;
+        float pressure;
+    };
+    uint32_t flags;
+    int32_t reserved1[3];
+} ASensorEvent;
+
+struct ASensorManager;
+typedef struct ASensorManager ASensorManager;
+
+struct ASensorEventQueue;
+typedef struct ASensorEventQueue ASensorEventQueue;
+
+struct ASensor;
+typedef struct ASensor ASensor;
+typedef ASensor const* ASensorRef;
+
+ASensorManager* ASensorManager_getInstance(void);
+ASensor const* ASensorManager_getDefaultSensor(ASensorManager* manager, int type);
+ASensorEventQueue* ASensorManager_createEventQueue(ASensorManager* manager,
+        ALooper* looper, int ident, ALooper_callbackFunc callback, void* data);
+int ASensorManager_destroyEventQueue(ASensorManager* manager, ASensorEventQueue* queue);
+
+int ASensorEventQueue_registerSensor(ASensorEventQueue* queue, ASensor const* sensor,
+        int32_t samplingPeriodUs, int64_t maxBatchReportLatencyUs);
+int ASensorEventQueue_enableSensor(ASensorEventQueue* queue, ASensor const* sensor);
+int ASensorEventQueue_disableSensor(ASensorEventQueue* queue, ASensor const* sensor);
+int ASensorEventQueue_setEventRate(ASensorEventQueue* queue, ASensor const* sensor, int32_t usec);
+int ASensorEventQueue_hasEvents(ASensorEventQueue* queue);
+ssize_t ASensorEventQueue_getEvents(ASensorEventQueue* queue, ASensorEvent* events, size_t count);
+
+const char* ASensor_getName(ASensor const* sensor);
+int ASensor_getType(ASensor const* sensor);
+int ASensor_getMinDelay(ASensor const* sensor);
+int ASensor_getFifoMaxEventCount(ASensor const* sensor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HOST_ANDROID_SENSOR_H */
@@ -0,0 +1,22 @@
+/*
+ * Substitut hte de <android/thermal.h> (Android 11).
+ */
+
+#ifndef _HOST_ANDROID_THERMAL_H
+#define _HOST_ANDROID_THERMAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct AThermalManager AThermalManager;
+
+AThermalManager* AThermal_acquireManager(void);
+void AThermal_releaseManager(AThermalManager* manager);
+float AThermal_getThermalHeadroom(AThermalManager* manager, int forecastSeconds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HOST_ANDROID_THERMAL_H */
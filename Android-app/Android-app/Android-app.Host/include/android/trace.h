@@ -0,0 +1,26 @@
+/*
+ * Substitut hte de <android/trace.h> (Android 6, Android 10 pour les
+ * compteurs et les tranches asynchrones).
+ */
+
+#ifndef _HOST_ANDROID_TRACE_H
+#define _HOST_ANDROID_TRACE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int ATrace_isEnabled(void);
+void ATrace_beginSection(const char* sectionName);
+void ATrace_endSection(void);
+void ATrace_beginAsyncSection(const char* sectionName, int32_t cookie);
+void ATrace_endAsyncSection(const char* sectionName, int32_t cookie);
+void ATrace_setCounter(const char* counterName, int64_t counterValue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HOST_ANDROID_TRACE_H */
@@ -0,0 +1,19 @@
+/*
+ * Substitut hte de <jni.h>.
+ *
+ * Le runtime hte n'embarque pas de machine virtuelle Java : seuls les types
+ * rfrencs par <android/native_activity.h> sont dclars, sous forme opaque.
+ */
+
+#ifndef _HOST_JNI_H
+#define _HOST_JNI_H
+
+#include <stdint.h>
+
+typedef int32_t jint;
+typedef void* jobject;
+
+typedef struct _JNIEnv JNIEnv;
+typedef struct _JavaVM JavaVM;
+
+#endif /* _HOST_JNI_H */
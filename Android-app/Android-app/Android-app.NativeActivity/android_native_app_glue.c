@@ -15,38 +15,116 @@
  *
  */
 
-#define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, "threaded_app", __VA_ARGS__))
-#define LOGE(...) ((void)__android_log_print(ANDROID_LOG_ERROR, "threaded_app", __VA_ARGS__))
+ASYNC_LOG_TAG(threaded_app_log_tag, "threaded_app", 100);
+
+/* Les traces de dbogage (LOGV) ne sont compiles que pour les versions Debug : voir ASYNC_LOG_MIN_LEVEL */
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, &threaded_app_log_tag, __VA_ARGS__)
+#define LOGE(...) ASYNC_LOG(ANDROID_LOG_ERROR, &threaded_app_log_tag, __VA_ARGS__)
+#define LOGV(...) ASYNC_LOG(ANDROID_LOG_VERBOSE, &threaded_app_log_tag, __VA_ARGS__)
+
+static const char* const cmd_names[] = {
+    "INPUT_CHANGED", "INIT_WINDOW", "TERM_WINDOW", "WINDOW_RESIZED",
+    "WINDOW_REDRAW_NEEDED", "CONTENT_RECT_CHANGED", "GAINED_FOCUS", "LOST_FOCUS",
+    "CONFIG_CHANGED", "LOW_MEMORY", "START", "RESUME", "SAVE_STATE", "PAUSE", "STOP",
+    "DESTROY",
+};
+
+static const char* cmd_name(int8_t cmd) {
+    return cmd >= 0 && cmd < (int)(sizeof(cmd_names) / sizeof(cmd_names[0])) ? cmd_names[cmd] : "?";
+}
 
-/* Pour les versions Debug, toujours activer les traces de dbogage dans cette bibliothque */
-#ifndef NDEBUG
-#  define LOGV(...)  ((void)__android_log_print(ANDROID_LOG_VERBOSE, "threaded_app", __VA_ARGS__))
-#else
-#  define LOGV(...)  ((void)0)
-#endif
+static int64_t android_app_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// Appele par le thread principal de l'activit  la fin de chaque rappel.
+static void android_app_record_stall(struct android_app* android_app, int8_t cmd, int64_t start) {
+    if (cmd < 0 || cmd >= ANDROID_APP_CMD_MAX) {
+        return;
+    }
+    int64_t elapsed = android_app_now_ns() - start;
+    struct android_app_stall* stall = &android_app->stalls[cmd];
+    stall->count++;
+    stall->totalNs += elapsed;
+    if (elapsed > stall->maxNs) stall->maxNs = elapsed;
+}
+
+static void android_app_log_stalls(struct android_app* android_app) {
+    for (int cmd = 0; cmd < ANDROID_APP_CMD_MAX; cmd++) {
+        const struct android_app_stall* stall = &android_app->stalls[cmd];
+        if (stall->count == 0) continue;
+        LOGI("UI thread stall %s: count=%llu mean=%.1fus max=%.1fus", cmd_name(cmd),
+                (unsigned long long)stall->count,
+                stall->totalNs / 1000.0 / (double)stall->count, stall->maxNs / 1000.0);
+    }
+}
 
 static void free_saved_state(struct android_app* android_app) {
     pthread_mutex_lock(&android_app->mutex);
     if (android_app->savedState != NULL) {
-        free(android_app->savedState);
+        // Bloc allou avec malloc(), par la rserve ou par l'application : il
+        // garde au moins savedStateSize octets pour le prochain enregistrement.
+        state_pool_release(android_app->savedState, android_app->savedStateSize);
         android_app->savedState = NULL;
         android_app->savedStateSize = 0;
     }
     pthread_mutex_unlock(&android_app->mutex);
 }
 
-int8_t android_app_read_cmd(struct android_app* android_app) {
-    int8_t cmd;
-    if (read(android_app->msgread, &cmd, sizeof(cmd)) == sizeof(cmd)) {
-        switch (cmd) {
-            case APP_CMD_SAVE_STATE:
-                free_saved_state(android_app);
-                break;
+static void android_app_rearm_cmd_signal(struct android_app* android_app) {
+    // Le compteur de l'eventfd est vid avant de rouvrir le signal au producteur ;
+    // une commande publie entre-temps est alors signale  nouveau.
+    uint64_t value;
+    if (read(android_app->cmdEventFd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+        LOGE("Failure reading android_app cmd: %s\n", strerror(errno));
+    }
+    __atomic_store_n(&android_app->cmdSignaled, 0, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&android_app->cmdTail, __ATOMIC_SEQ_CST) != android_app->cmdHead
+            && __atomic_exchange_n(&android_app->cmdSignaled, 1, __ATOMIC_SEQ_CST) == 0) {
+        value = 1;
+        if (write(android_app->cmdEventFd, &value, sizeof(value)) != sizeof(value)) {
+            LOGE("Failure writing android_app cmd: %s\n", strerror(errno));
         }
-        return cmd;
-    } else {
-        LOGE("No data on command pipe!");
     }
+}
+
+int android_app_read_cmd_record(struct android_app* android_app, struct android_app_cmd* outCmd) {
+    // Seul le thread de l'application crit cmdHead.
+    uint32_t head = android_app->cmdHead;
+    uint32_t tail = __atomic_load_n(&android_app->cmdTail, __ATOMIC_SEQ_CST);
+    if (head == tail) {
+        android_app_rearm_cmd_signal(android_app);
+        return 0;
+    }
+
+    *outCmd = android_app->cmdRing[head & (ANDROID_APP_CMD_RING_SIZE - 1)];
+    __atomic_store_n(&android_app->cmdHead, head + 1, __ATOMIC_SEQ_CST);
+
+    if (tail - head == ANDROID_APP_CMD_RING_SIZE) {
+        // Le producteur attend peut-tre une place libre.
+        pthread_mutex_lock(&android_app->mutex);
+        pthread_cond_broadcast(&android_app->cond);
+        pthread_mutex_unlock(&android_app->mutex);
+    }
+    if (__atomic_load_n(&android_app->cmdTail, __ATOMIC_SEQ_CST) == head + 1) {
+        android_app_rearm_cmd_signal(android_app);
+    }
+
+    switch (outCmd->cmd) {
+        case APP_CMD_SAVE_STATE:
+            free_saved_state(android_app);
+            break;
+    }
+    return 1;
+}
+
+int8_t android_app_read_cmd(struct android_app* android_app) {
+    if (android_app_read_cmd_record(android_app, &android_app->currentCmd)) {
+        return android_app->currentCmd.cmd;
+    }
+    LOGV("No data on command ring!");
     return -1;
 }
 
@@ -75,15 +153,49 @@ static void print_cur_config(struct android_app* android_app) {
             AConfiguration_getUiModeNight(android_app->config));
 }
 
+// La nouvelle configuration est compare  la prcdente : seuls les abonns dont
+// un champ a chang sont appels.
+static void update_config(struct android_app* android_app) {
+    AConfiguration_fromAssetManager(android_app->nextConfig, android_app->activity->assetManager);
+    int32_t changes = AConfiguration_diff(android_app->config, android_app->nextConfig);
+    AConfiguration* previous = android_app->config;
+    android_app->config = android_app->nextConfig;
+    android_app->nextConfig = previous;
+    android_app->configChanges = changes;
+    android_app->currentCmd.value = changes;
+    LOGV("APP_CMD_CONFIG_CHANGED: changes=0x%x\n", (unsigned)changes);
+    for (int i = 0; i < android_app->configListenerCount; i++) {
+        const struct android_app_config_listener* listener = &android_app->configListeners[i];
+        if ((changes & listener->mask) != 0) {
+            listener->function(android_app, changes & listener->mask, listener->userData);
+        }
+    }
+}
+
+int android_app_add_config_listener(struct android_app* android_app, int32_t mask,
+        android_app_config_function function, void* userData) {
+    if (android_app->configListenerCount == ANDROID_APP_CONFIG_LISTENERS) {
+        return -1;
+    }
+    struct android_app_config_listener* listener =
+            &android_app->configListeners[android_app->configListenerCount++];
+    listener->mask = mask;
+    listener->function = function;
+    listener->userData = userData;
+    return 0;
+}
+
 void android_app_pre_exec_cmd(struct android_app* android_app, int8_t cmd) {
     switch (cmd) {
         case APP_CMD_INPUT_CHANGED:
             LOGV("APP_CMD_INPUT_CHANGED\n");
             pthread_mutex_lock(&android_app->mutex);
-            if (android_app->inputQueue != NULL) {
+            // Une file tenue par l'tage diffr est dj dtache.
+            if (android_app->inputQueue != NULL && !android_app->inputDetached) {
                 AInputQueue_detachLooper(android_app->inputQueue);
             }
-            android_app->inputQueue = android_app->pendingInputQueue;
+            android_app->inputQueue = android_app->currentCmd.inputQueue;
+            android_app->inputDetached = 0;
             if (android_app->inputQueue != NULL) {
                 LOGV("Attaching input queue to looper");
                 AInputQueue_attachLooper(android_app->inputQueue,
@@ -97,7 +209,7 @@ void android_app_pre_exec_cmd(struct android_app* android_app, int8_t cmd) {
         case APP_CMD_INIT_WINDOW:
             LOGV("APP_CMD_INIT_WINDOW\n");
             pthread_mutex_lock(&android_app->mutex);
-            android_app->window = android_app->pendingWindow;
+            android_app->window = android_app->currentCmd.window;
             pthread_cond_broadcast(&android_app->cond);
             pthread_mutex_unlock(&android_app->mutex);
             break;
@@ -119,10 +231,7 @@ void android_app_pre_exec_cmd(struct android_app* android_app, int8_t cmd) {
             break;
 
         case APP_CMD_CONFIG_CHANGED:
-            LOGV("APP_CMD_CONFIG_CHANGED\n");
-            AConfiguration_fromAssetManager(android_app->config,
-                    android_app->activity->assetManager);
-            print_cur_config(android_app);
+            update_config(android_app);
             break;
 
         case APP_CMD_DESTROY:
@@ -142,58 +251,170 @@ void android_app_post_exec_cmd(struct android_app* android_app, int8_t cmd) {
             pthread_mutex_unlock(&android_app->mutex);
             break;
 
-        case APP_CMD_SAVE_STATE:
+        case APP_CMD_SAVE_STATE: {
             LOGV("APP_CMD_SAVE_STATE\n");
             pthread_mutex_lock(&android_app->mutex);
+            size_t savedStateSize = android_app->savedStateSize;
             android_app->stateSaved = 1;
             pthread_cond_broadcast(&android_app->cond);
             pthread_mutex_unlock(&android_app->mutex);
+            // Le bloc part avec le systme : son remplaant est prpar maintenant,
+            // pendant que le thread principal de l'activit n'attend plus.
+            if (savedStateSize > 0) {
+                state_pool_reserve(savedStateSize);
+            }
             break;
+        }
 
         case APP_CMD_RESUME:
             free_saved_state(android_app);
             break;
+
+        case APP_CMD_LOW_MEMORY:
+            state_pool_trim();
+            break;
     }
 }
 
 static void android_app_destroy(struct android_app* android_app) {
     LOGV("android_app_destroy!");
     free_saved_state(android_app);
+    event_trace_close(android_app->trace, NULL);
+    android_app->trace = NULL;
     pthread_mutex_lock(&android_app->mutex);
-    if (android_app->inputQueue != NULL) {
+    if (android_app->inputQueue != NULL && !android_app->inputDetached) {
         AInputQueue_detachLooper(android_app->inputQueue);
     }
     AConfiguration_delete(android_app->config);
+    AConfiguration_delete(android_app->nextConfig);
     android_app->destroyed = 1;
     pthread_cond_broadcast(&android_app->cond);
     pthread_mutex_unlock(&android_app->mutex);
     // Impossible de modifier l'objet android_app aprs ceci.
 }
 
-static void process_input(struct android_app* app, struct android_poll_source* source) {
+static void drain_input(struct android_app* app) {
+    SYS_TRACE_SCOPE("drain_input");
     AInputEvent* event = NULL;
     while (AInputQueue_getEvent(app->inputQueue, &event) >= 0) {
         LOGV("New input event: type=%d\n", AInputEvent_getType(event));
         if (AInputQueue_preDispatchEvent(app->inputQueue, event)) {
             continue;
         }
+        if (app->trace != NULL) {
+            event_trace_record_input(app->trace, event);
+        }
         int32_t handled = 0;
-        if (app->onInputEvent != NULL) handled = app->onInputEvent(app, event);
+        if (app->inputStage != NULL && AInputEvent_getType(event) == AINPUT_EVENT_TYPE_MOTION) {
+            handled = input_stage_add(app->inputStage, event);
+        } else if (app->onInputEvent != NULL) {
+            handled = app->onInputEvent(app, event);
+        }
         AInputQueue_finishEvent(app->inputQueue, event, handled);
     }
 }
 
+static void process_input(struct android_app* app, struct android_poll_source* source) {
+    drain_input(app);
+    // tage diffr : la file n'est plus surveille jusqu' la prochaine image, qui la
+    // relit avec android_app_latch_input(). Le looper est rveill au plus une fois
+    // par image, quel que soit le dbit des vnements.
+    if (app->inputStage != NULL && app->inputStage->deferred && !app->inputDetached) {
+        AInputQueue_detachLooper(app->inputQueue);
+        app->inputDetached = 1;
+    }
+}
+
+void android_app_latch_input(struct android_app* android_app) {
+    if (android_app->inputQueue == NULL) {
+        return;
+    }
+    drain_input(android_app);
+    if (android_app->inputDetached) {
+        AInputQueue_attachLooper(android_app->inputQueue, android_app->looper, LOOPER_ID_INPUT,
+                NULL, &android_app->inputPollSource);
+        android_app->inputDetached = 0;
+    }
+}
+
+static void android_app_complete_cmd(struct android_app* android_app, uint32_t token) {
+    __atomic_store_n(&android_app->cmdCompleted, token, __ATOMIC_SEQ_CST);
+    // Le mutex n'est pris que si le thread principal attend un jeton.
+    if (__atomic_load_n(&android_app->cmdWaiters, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&android_app->mutex);
+        pthread_cond_broadcast(&android_app->cond);
+        pthread_mutex_unlock(&android_app->mutex);
+    }
+}
+
+int android_app_start_recording(struct android_app* android_app, const char* path) {
+    struct event_trace* trace = event_trace_create(path);
+    if (trace == NULL) {
+        return -1;
+    }
+    event_trace_close(android_app->trace, NULL);
+    android_app->trace = trace;
+    // Point de dpart du rejeu : l'instance recre reoit le mme tat et la mme configuration.
+    event_trace_record_state(trace, android_app->savedState, android_app->savedState != NULL
+            ? android_app->savedStateSize : 0);
+    event_trace_record_config(trace, android_app->config, 0);
+    return 0;
+}
+
+// Commande et arguments, aprs le pr-traitement : la configuration est dj  jour.
+static void record_cmd(struct android_app* app, int8_t cmd) {
+    int32_t args[3];
+    int argCount = 0;
+    switch (cmd) {
+        case APP_CMD_INIT_WINDOW:
+        case APP_CMD_WINDOW_RESIZED:
+            if (app->window != NULL) {
+                args[0] = ANativeWindow_getWidth(app->window);
+                args[1] = ANativeWindow_getHeight(app->window);
+                args[2] = ANativeWindow_getFormat(app->window);
+                argCount = 3;
+            }
+            break;
+        case APP_CMD_INPUT_CHANGED:
+            args[0] = app->inputQueue != NULL;
+            argCount = 1;
+            break;
+        case APP_CMD_CONFIG_CHANGED:
+            event_trace_record_config(app->trace, app->config, app->configChanges);
+            break;
+    }
+    event_trace_record_cmd(app->trace, cmd, args, argCount);
+}
+
 static void process_cmd(struct android_app* app, struct android_poll_source* source) {
-    int8_t cmd = android_app_read_cmd(app);
-    android_app_pre_exec_cmd(app, cmd);
-    if (app->onAppCmd != NULL) app->onAppCmd(app, cmd);
-    android_app_post_exec_cmd(app, cmd);
+    // Toute la rafale prsente au rveil est traite en une passe. Les commandes
+    // publies pendant le traitement attendent le tour suivant du looper, afin que
+    // les vnements d'entre dj en attente ne soient pas devancs.
+    uint32_t pending = __atomic_load_n(&app->cmdTail, __ATOMIC_SEQ_CST) - app->cmdHead;
+    if (pending == 0) pending = 1;
+    while (pending-- > 0 && android_app_read_cmd_record(app, &app->currentCmd)) {
+        int8_t cmd = app->currentCmd.cmd;
+        // Tranche de l'excution ; la tranche asynchrone va de l'envoi  l'acquittement.
+        SYS_TRACE_BEGIN(cmd_name(cmd));
+        android_app_pre_exec_cmd(app, cmd);
+        if (app->trace != NULL) record_cmd(app, cmd);
+        if (app->onAppCmd != NULL) app->onAppCmd(app, cmd);
+        android_app_post_exec_cmd(app, cmd);
+        // Le processus peut tre tu en arrire-plan : la trace est crite jusqu'ici.
+        if (app->trace != NULL && (cmd == APP_CMD_PAUSE || cmd == APP_CMD_STOP)) {
+            event_trace_flush(app->trace);
+        }
+        android_app_complete_cmd(app, app->currentCmd.token);
+        SYS_TRACE_END();
+        SYS_TRACE_ASYNC_END(cmd_name(cmd), (int32_t)app->currentCmd.token);
+    }
 }
 
 static void* android_app_entry(void* param) {
     struct android_app* android_app = (struct android_app*)param;
 
     android_app->config = AConfiguration_new();
+    android_app->nextConfig = AConfiguration_new();
     AConfiguration_fromAssetManager(android_app->config, android_app->activity->assetManager);
 
     print_cur_config(android_app);
@@ -206,7 +427,7 @@ static void* android_app_entry(void* param) {
     android_app->inputPollSource.process = process_input;
 
     ALooper* looper = ALooper_prepare(ALOOPER_PREPARE_ALLOW_NON_CALLBACKS);
-    ALooper_addFd(looper, android_app->msgread, LOOPER_ID_MAIN, ALOOPER_EVENT_INPUT, NULL,
+    ALooper_addFd(looper, android_app->cmdEventFd, LOOPER_ID_MAIN, ALOOPER_EVENT_INPUT, NULL,
             &android_app->cmdPollSource);
     android_app->looper = looper;
 
@@ -225,9 +446,16 @@ static void* android_app_entry(void* param) {
 // Interaction avec une activit native (appele par le thread principal)
 // --------------------------------------------------------------------
 
+// Une activit recre (changement de configuration) coexiste un instant avec
+// la prcdente : deux emplacements vitent le tas, le tas sert au-del.
+OBJECT_POOL_DEFINE(static, android_app_pool, struct android_app, 2);
+
 static struct android_app* android_app_create(ANativeActivity* activity,
         void* savedState, size_t savedStateSize) {
-    struct android_app* android_app = (struct android_app*)malloc(sizeof(struct android_app));
+    struct android_app* android_app = OBJECT_POOL_NEW(&android_app_pool, struct android_app);
+    if (android_app == NULL) {
+        android_app = (struct android_app*)malloc(sizeof(struct android_app));
+    }
     memset(android_app, 0, sizeof(struct android_app));
     android_app->activity = activity;
 
@@ -235,18 +463,18 @@ static struct android_app* android_app_create(ANativeActivity* activity,
     pthread_cond_init(&android_app->cond, NULL);
 
     if (savedState != NULL) {
-        android_app->savedState = malloc(savedStateSize);
+        // Le bloc du systme n'est valide que pendant onCreate : une copie, dans
+        // un tampon de la rserve, est invitable.
+        android_app->savedState = state_pool_acquire(savedStateSize, NULL);
         android_app->savedStateSize = savedStateSize;
         memcpy(android_app->savedState, savedState, savedStateSize);
     }
 
-    int msgpipe[2];
-    if (pipe(msgpipe)) {
-        LOGE("could not create pipe: %s", strerror(errno));
+    android_app->cmdEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (android_app->cmdEventFd < 0) {
+        LOGE("could not create eventfd: %s", strerror(errno));
         return NULL;
     }
-    android_app->msgread = msgpipe[0];
-    android_app->msgwrite = msgpipe[1];
 
     pthread_attr_t attr; 
     pthread_attr_init(&attr);
@@ -263,81 +491,166 @@ static struct android_app* android_app_create(ANativeActivity* activity,
     return android_app;
 }
 
-static void android_app_write_cmd(struct android_app* android_app, int8_t cmd) {
-    if (write(android_app->msgwrite, &cmd, sizeof(cmd)) != sizeof(cmd)) {
-        LOGE("Failure writing android_app cmd: %s\n", strerror(errno));
+// Doit tre appele avec android_app->mutex verrouill. Retourne le jeton de compltion
+// attribu  la commande.
+static uint32_t android_app_write_cmd_record(struct android_app* android_app,
+        const struct android_app_cmd* record) {
+    // Seul le thread principal de l'activit crit cmdTail.
+    uint32_t tail = android_app->cmdTail;
+    while (tail - __atomic_load_n(&android_app->cmdHead, __ATOMIC_SEQ_CST)
+            == ANDROID_APP_CMD_RING_SIZE) {
+        // Anneau plein : le thread de l'application est en retard et dj signal.
+        LOGE("android_app cmd ring full, waiting\n");
+        pthread_cond_wait(&android_app->cond, &android_app->mutex);
+    }
+
+    struct android_app_cmd* slot = &android_app->cmdRing[tail & (ANDROID_APP_CMD_RING_SIZE - 1)];
+    *slot = *record;
+    slot->token = ++android_app->cmdNextToken;
+    SYS_TRACE_ASYNC_BEGIN(cmd_name(record->cmd), (int32_t)slot->token);
+    __atomic_store_n(&android_app->cmdTail, tail + 1, __ATOMIC_SEQ_CST);
+
+    // Seule la transition de vide  non vide rveille le looper.
+    if (__atomic_exchange_n(&android_app->cmdSignaled, 1, __ATOMIC_SEQ_CST) == 0) {
+        uint64_t value = 1;
+        if (write(android_app->cmdEventFd, &value, sizeof(value)) != sizeof(value)) {
+            LOGE("Failure writing android_app cmd: %s\n", strerror(errno));
+        }
     }
+    return slot->token;
+}
+
+static uint32_t android_app_write_cmd(struct android_app* android_app, int8_t cmd) {
+    struct android_app_cmd record;
+    memset(&record, 0, sizeof(record));
+    record.cmd = cmd;
+    return android_app_write_cmd_record(android_app, &record);
+}
+
+// Doit tre appele avec android_app->mutex verrouill.
+static void android_app_wait_cmd(struct android_app* android_app, uint32_t token) {
+    __atomic_fetch_add(&android_app->cmdWaiters, 1, __ATOMIC_SEQ_CST);
+    while ((int32_t)(__atomic_load_n(&android_app->cmdCompleted, __ATOMIC_SEQ_CST) - token) < 0) {
+        pthread_cond_wait(&android_app->cond, &android_app->mutex);
+    }
+    __atomic_fetch_sub(&android_app->cmdWaiters, 1, __ATOMIC_SEQ_CST);
 }
 
 static void android_app_set_input(struct android_app* android_app, AInputQueue* inputQueue) {
+    struct android_app_cmd record;
+    memset(&record, 0, sizeof(record));
+    record.cmd = APP_CMD_INPUT_CHANGED;
+    record.inputQueue = inputQueue;
+
+    int64_t start = android_app_now_ns();
     pthread_mutex_lock(&android_app->mutex);
     android_app->pendingInputQueue = inputQueue;
-    android_app_write_cmd(android_app, APP_CMD_INPUT_CHANGED);
+    android_app_write_cmd_record(android_app, &record);
     while (android_app->inputQueue != android_app->pendingInputQueue) {
         pthread_cond_wait(&android_app->cond, &android_app->mutex);
     }
     pthread_mutex_unlock(&android_app->mutex);
+    android_app_record_stall(android_app, APP_CMD_INPUT_CHANGED, start);
 }
 
 static void android_app_set_window(struct android_app* android_app, ANativeWindow* window) {
+    int64_t start = android_app_now_ns();
     pthread_mutex_lock(&android_app->mutex);
     if (android_app->pendingWindow != NULL) {
         android_app_write_cmd(android_app, APP_CMD_TERM_WINDOW);
     }
     android_app->pendingWindow = window;
     if (window != NULL) {
-        android_app_write_cmd(android_app, APP_CMD_INIT_WINDOW);
+        struct android_app_cmd record;
+        memset(&record, 0, sizeof(record));
+        record.cmd = APP_CMD_INIT_WINDOW;
+        record.window = window;
+        android_app_write_cmd_record(android_app, &record);
     }
     while (android_app->window != android_app->pendingWindow) {
         pthread_cond_wait(&android_app->cond, &android_app->mutex);
     }
     pthread_mutex_unlock(&android_app->mutex);
+    android_app_record_stall(android_app,
+            window != NULL ? APP_CMD_INIT_WINDOW : APP_CMD_TERM_WINDOW, start);
 }
 
 static void android_app_set_activity_state(struct android_app* android_app, int8_t cmd) {
+    int64_t start = android_app_now_ns();
     pthread_mutex_lock(&android_app->mutex);
-    android_app_write_cmd(android_app, cmd);
-    while (android_app->activityState != cmd) {
-        pthread_cond_wait(&android_app->cond, &android_app->mutex);
+    uint32_t token = android_app_write_cmd(android_app, cmd);
+    if (!__atomic_load_n(&android_app->asyncLifecycle, __ATOMIC_RELAXED)) {
+        android_app_wait_cmd(android_app, token);
     }
     pthread_mutex_unlock(&android_app->mutex);
+    android_app_record_stall(android_app, cmd, start);
+}
+
+// Envoi d'une commande qui n'attend aucun acquittement.
+static void android_app_post_cmd(struct android_app* android_app, int8_t cmd) {
+    int64_t start = android_app_now_ns();
+    pthread_mutex_lock(&android_app->mutex);
+    android_app_write_cmd(android_app, cmd);
+    pthread_mutex_unlock(&android_app->mutex);
+    android_app_record_stall(android_app, cmd, start);
+}
+
+// Envoi d'une commande et attente de son excution, mme avec asyncLifecycle.
+static void android_app_run_cmd(struct android_app* android_app, int8_t cmd) {
+    int64_t start = android_app_now_ns();
+    pthread_mutex_lock(&android_app->mutex);
+    uint32_t token = android_app_write_cmd(android_app, cmd);
+    android_app_wait_cmd(android_app, token);
+    pthread_mutex_unlock(&android_app->mutex);
+    android_app_record_stall(android_app, cmd, start);
 }
 
 static void android_app_free(struct android_app* android_app) {
+    int64_t start = android_app_now_ns();
     pthread_mutex_lock(&android_app->mutex);
     android_app_write_cmd(android_app, APP_CMD_DESTROY);
     while (!android_app->destroyed) {
         pthread_cond_wait(&android_app->cond, &android_app->mutex);
     }
     pthread_mutex_unlock(&android_app->mutex);
+    android_app_record_stall(android_app, APP_CMD_DESTROY, start);
+    android_app_log_stalls(android_app);
 
-    close(android_app->msgread);
-    close(android_app->msgwrite);
+    close(android_app->cmdEventFd);
     pthread_cond_destroy(&android_app->cond);
     pthread_mutex_destroy(&android_app->mutex);
-    free(android_app);
+    if (object_pool_owns(&android_app_pool, android_app)) {
+        object_pool_free(&android_app_pool, android_app);
+    } else {
+        free(android_app);
+    }
 }
 
 static void onDestroy(ANativeActivity* activity) {
+    SYS_TRACE_SCOPE("onDestroy");
     LOGV("Destroy: %p\n", activity);
     android_app_free((struct android_app*)activity->instance);
 }
 
 static void onStart(ANativeActivity* activity) {
+    SYS_TRACE_SCOPE("onStart");
     LOGV("Start: %p\n", activity);
     android_app_set_activity_state((struct android_app*)activity->instance, APP_CMD_START);
 }
 
 static void onResume(ANativeActivity* activity) {
+    SYS_TRACE_SCOPE("onResume");
     LOGV("Resume: %p\n", activity);
     android_app_set_activity_state((struct android_app*)activity->instance, APP_CMD_RESUME);
 }
 
 static void* onSaveInstanceState(ANativeActivity* activity, size_t* outLen) {
+    SYS_TRACE_SCOPE("onSaveInstanceState");
     struct android_app* android_app = (struct android_app*)activity->instance;
     void* savedState = NULL;
 
     LOGV("SaveInstanceState: %p\n", activity);
+    int64_t start = android_app_now_ns();
     pthread_mutex_lock(&android_app->mutex);
     android_app->stateSaved = 0;
     android_app_write_cmd(android_app, APP_CMD_SAVE_STATE);
@@ -353,60 +666,85 @@ static void* onSaveInstanceState(ANativeActivity* activity, size_t* outLen) {
     }
 
     pthread_mutex_unlock(&android_app->mutex);
+    android_app_record_stall(android_app, APP_CMD_SAVE_STATE, start);
 
     return savedState;
 }
 
 static void onPause(ANativeActivity* activity) {
+    SYS_TRACE_SCOPE("onPause");
     LOGV("Pause: %p\n", activity);
     android_app_set_activity_state((struct android_app*)activity->instance, APP_CMD_PAUSE);
 }
 
 static void onStop(ANativeActivity* activity) {
+    SYS_TRACE_SCOPE("onStop");
     LOGV("Stop: %p\n", activity);
     android_app_set_activity_state((struct android_app*)activity->instance, APP_CMD_STOP);
 }
 
 static void onConfigurationChanged(ANativeActivity* activity) {
+    SYS_TRACE_SCOPE("onConfigurationChanged");
     struct android_app* android_app = (struct android_app*)activity->instance;
     LOGV("ConfigurationChanged: %p\n", activity);
-    android_app_write_cmd(android_app, APP_CMD_CONFIG_CHANGED);
+    android_app_post_cmd(android_app, APP_CMD_CONFIG_CHANGED);
 }
 
 static void onLowMemory(ANativeActivity* activity) {
+    SYS_TRACE_SCOPE("onLowMemory");
     struct android_app* android_app = (struct android_app*)activity->instance;
     LOGV("LowMemory: %p\n", activity);
-    android_app_write_cmd(android_app, APP_CMD_LOW_MEMORY);
+    android_app_post_cmd(android_app, APP_CMD_LOW_MEMORY);
 }
 
 static void onWindowFocusChanged(ANativeActivity* activity, int focused) {
+    SYS_TRACE_SCOPE("onWindowFocusChanged");
+    struct android_app* android_app = (struct android_app*)activity->instance;
     LOGV("WindowFocusChanged: %p -- %d\n", activity, focused);
-    android_app_write_cmd((struct android_app*)activity->instance,
-            focused ? APP_CMD_GAINED_FOCUS : APP_CMD_LOST_FOCUS);
+    android_app_post_cmd(android_app, focused ? APP_CMD_GAINED_FOCUS : APP_CMD_LOST_FOCUS);
 }
 
 static void onNativeWindowCreated(ANativeActivity* activity, ANativeWindow* window) {
+    SYS_TRACE_SCOPE("onNativeWindowCreated");
     LOGV("NativeWindowCreated: %p -- %p\n", activity, window);
     android_app_set_window((struct android_app*)activity->instance, window);
 }
 
 static void onNativeWindowDestroyed(ANativeActivity* activity, ANativeWindow* window) {
+    SYS_TRACE_SCOPE("onNativeWindowDestroyed");
     LOGV("NativeWindowDestroyed: %p -- %p\n", activity, window);
     android_app_set_window((struct android_app*)activity->instance, NULL);
 }
 
+static void onNativeWindowResized(ANativeActivity* activity, ANativeWindow* window) {
+    SYS_TRACE_SCOPE("onNativeWindowResized");
+    struct android_app* android_app = (struct android_app*)activity->instance;
+    LOGV("NativeWindowResized: %p -- %p\n", activity, window);
+    android_app_post_cmd(android_app, APP_CMD_WINDOW_RESIZED);
+}
+
+// Le systme affiche la fentre au retour : l'application doit avoir redessin.
+static void onNativeWindowRedrawNeeded(ANativeActivity* activity, ANativeWindow* window) {
+    SYS_TRACE_SCOPE("onNativeWindowRedrawNeeded");
+    LOGV("NativeWindowRedrawNeeded: %p -- %p\n", activity, window);
+    android_app_run_cmd((struct android_app*)activity->instance, APP_CMD_WINDOW_REDRAW_NEEDED);
+}
+
 static void onInputQueueCreated(ANativeActivity* activity, AInputQueue* queue) {
+    SYS_TRACE_SCOPE("onInputQueueCreated");
     LOGV("InputQueueCreated: %p -- %p\n", activity, queue);
     android_app_set_input((struct android_app*)activity->instance, queue);
 }
 
 static void onInputQueueDestroyed(ANativeActivity* activity, AInputQueue* queue) {
+    SYS_TRACE_SCOPE("onInputQueueDestroyed");
     LOGV("InputQueueDestroyed: %p -- %p\n", activity, queue);
     android_app_set_input((struct android_app*)activity->instance, NULL);
 }
 
 void ANativeActivity_onCreate(ANativeActivity* activity,
         void* savedState, size_t savedStateSize) {
+    SYS_TRACE_SCOPE("ANativeActivity_onCreate");
     LOGV("Creating: %p\n", activity);
     activity->callbacks->onDestroy = onDestroy;
     activity->callbacks->onStart = onStart;
@@ -419,6 +757,8 @@ void ANativeActivity_onCreate(ANativeActivity* activity,
     activity->callbacks->onWindowFocusChanged = onWindowFocusChanged;
     activity->callbacks->onNativeWindowCreated = onNativeWindowCreated;
     activity->callbacks->onNativeWindowDestroyed = onNativeWindowDestroyed;
+    activity->callbacks->onNativeWindowResized = onNativeWindowResized;
+    activity->callbacks->onNativeWindowRedrawNeeded = onNativeWindowRedrawNeeded;
     activity->callbacks->onInputQueueCreated = onInputQueueCreated;
     activity->callbacks->onInputQueueDestroyed = onInputQueueDestroyed;
 
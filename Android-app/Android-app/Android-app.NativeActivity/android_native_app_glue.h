@@ -83,6 +83,66 @@ extern "C" {
 
 struct android_app;
 
+/**
+ * Commande du thread principal telle qu'elle est transmise au thread de
+ * l'application, avec sa charge utile ventuelle.
+ */
+struct android_app_cmd {
+    // Commande APP_CMD_XXX.
+    int8_t cmd;
+
+    // Jeton de compltion : numro de squence de la commande, publi dans
+    // android_app::cmdCompleted une fois la commande excute.
+    uint32_t token;
+
+    union {
+        // APP_CMD_INIT_WINDOW : nouvelle fentre.
+        ANativeWindow* window;
+
+        // APP_CMD_INPUT_CHANGED : nouvelle file d'attente d'entre (ou NULL).
+        AInputQueue* inputQueue;
+
+        // Valeur associe aux autres commandes.
+        int32_t value;
+    };
+};
+
+/**
+ * Capacit de l'anneau de commandes ; doit tre une puissance de deux.
+ */
+#define ANDROID_APP_CMD_RING_SIZE 64
+
+/**
+ * Borne suprieure des valeurs APP_CMD_XXX, pour les tables indexes par commande.
+ */
+#define ANDROID_APP_CMD_MAX 32
+
+/**
+ * Temps de blocage cumul du thread principal de l'activit pour un type de commande.
+ */
+struct android_app_stall {
+    uint64_t count;
+    int64_t totalNs;
+    int64_t maxNs;
+};
+
+/**
+ * Abonnements aux changements de configuration, au plus.
+ */
+#define ANDROID_APP_CONFIG_LISTENERS 8
+
+/**
+ * Rappel d'un abonn aux changements de configuration : changes contient les
+ * champs modifis (ACONFIGURATION_*) parmi ceux de son abonnement.
+ */
+typedef void (*android_app_config_function)(struct android_app* app, int32_t changes, void* userData);
+
+struct android_app_config_listener {
+    int32_t mask;
+    android_app_config_function function;
+    void* userData;
+};
+
 /**
  * Donnes associes  un fd ALooper qui sont retournes en tant que outData
  * quand les donnes de cette source sont prtes.
@@ -122,12 +182,25 @@ struct android_app {
     // par dfaut.
     int32_t (*onInputEvent)(struct android_app* app, AInputEvent* event);
 
+    // tage d'entre facultatif, renseign par android_main(). S'il est dfini, les
+    // vnements de mouvement ne sont pas passs  onInputEvent : leurs chantillons
+    // sont copis dans l'tage et lus une fois par image avec input_stage_swap().
+    struct input_stage* inputStage;
+
+    // Trace d'vnements en cours d'enregistrement (android_app_start_recording()),
+    // ou NULL. Ferme  la destruction de l'activit.
+    struct event_trace* trace;
+
     // Instance de l'objet ANativeActivity dans laquelle cette application s'excute.
     ANativeActivity* activity;
 
     // Configuration actuelle dans laquelle l'application s'excute.
     AConfiguration* config;
 
+    // Champs modifis par le dernier APP_CMD_CONFIG_CHANGED (masque ACONFIGURATION_*,
+    // comme AConfiguration_diff()) ; aussi dans currentCmd.value pendant onAppCmd.
+    int32_t configChanges;
+
     // tat enregistr de la dernire instance, tel que fourni au moment de la cration.
     // Sa valeur est NULL si aucun tat n'existe. Vous pouvez l'utiliser en fonction de vos besoins; la
     // mmoire est conserve jusqu' l'appel d'android_app_exec_cmd() pour
@@ -136,6 +209,9 @@ struct android_app {
     // aprs quoi elles sont initialises  la valeur NULL. Vous pouvez alors allouer de la mmoire (malloc)  votre
     // tat et placer les informations ici. Dans ce cas, la mmoire est
     // libre pour vous plus tard.
+    // Le bloc restaur est une copie place dans la rserve de state_snapshot.h, aligne
+    // pour une lecture sur place avec state_snapshot_open() ; un tat crit avec
+    // state_snapshot_begin() vient de la mme rserve.
     void* savedState;
     size_t savedStateSize;
 
@@ -153,6 +229,10 @@ struct android_app {
     // contenu de la fentre doit tre plac pour qu'il soit visible par l'utilisateur.
     ARect contentRect;
 
+    // Dernire commande lue par android_app_read_cmd(), avec sa charge utile. Elle est
+    // valide pendant l'excution de onAppCmd.
+    struct android_app_cmd currentCmd;
+
     // tat actuel de l'activit de l'application. Il peut avoir la valeur APP_CMD_START,
     // APP_CMD_RESUME, APP_CMD_PAUSE ou APP_CMD_STOP; voir ci-dessous.
     int activityState;
@@ -161,17 +241,47 @@ struct android_app {
     // est dtruite et en attente de la fin du thread de l'application.
     int destroyRequested;
 
+    // Mode de cycle de vie asynchrone. Quand sa valeur n'est pas zro, onStart,
+    // onResume, onPause et onStop retournent ds que la commande est publie au lieu
+    // d'attendre que android_main() l'ait traite ; activityState est mis  jour
+    // plus tard par le thread de l'application. Peut tre positionn par
+    // android_main() avant sa boucle d'vnements.
+    int asyncLifecycle;
+
+    // Temps de blocage du thread principal de l'activit, par commande APP_CMD_XXX.
+    // Le bilan est journalis  la destruction de l'activit.
+    struct android_app_stall stalls[ANDROID_APP_CMD_MAX];
+
     // -------------------------------------------------
     // Vous trouverez ci-dessous une implmentation prive du code de collage.
 
     pthread_mutex_t mutex;
     pthread_cond_t cond;
 
-    int msgread;
-    int msgwrite;
+    // Anneau de commandes  producteur unique (thread principal de l'activit) et
+    // consommateur unique (thread de l'application). cmdEventFd n'est signal que
+    // lorsque l'anneau passe de vide  non vide : une rafale de commandes cote
+    // un seul rveil du looper.
+    struct android_app_cmd cmdRing[ANDROID_APP_CMD_RING_SIZE];
+    uint32_t cmdHead;
+    uint32_t cmdTail;
+    int cmdSignaled;
+    int cmdEventFd;
+
+    // Dernier jeton attribu par le thread principal, dernier jeton excut par le
+    // thread de l'application, et nombre d'attentes en cours sur cmdCompleted.
+    uint32_t cmdNextToken;
+    uint32_t cmdCompleted;
+    int cmdWaiters;
 
     pthread_t thread;
 
+    // Configuration lue  APP_CMD_CONFIG_CHANGED, compare  config puis change avec
+    // elle, et abonns appels avec les champs modifis.
+    AConfiguration* nextConfig;
+    struct android_app_config_listener configListeners[ANDROID_APP_CONFIG_LISTENERS];
+    int configListenerCount;
+
     struct android_poll_source cmdPollSource;
     struct android_poll_source inputPollSource;
 
@@ -179,6 +289,7 @@ struct android_app {
     int stateSaved;
     int destroyed;
     int redrawNeeded;
+    int inputDetached;
     AInputQueue* pendingInputQueue;
     ANativeWindow* pendingWindow;
     ARect pendingContentRect;
@@ -265,7 +376,11 @@ enum {
     APP_CMD_LOST_FOCUS,
 
     /**
-     * Commande du thread principal: la configuration actuelle du priphrique a t modifie.
+     * Commande du thread principal : la configuration actuelle du priphrique a t modifie.
+     * android_app::config est  jour ; les champs modifis (ACONFIGURATION_*) sont dans
+     * currentCmd.value et android_app::configChanges, et les abonns concerns
+     * d'android_app_add_config_listener() ont t appels avant onAppCmd. Un masque nul
+     * signifie que la modification a dj t livre par une commande prcdente.
      */
     APP_CMD_CONFIG_CHANGED,
 
@@ -288,9 +403,9 @@ enum {
     /**
      * Commande du thread principal: l'application doit gnrer un nouvel tat enregistr
      *  partir duquel elle pourra tre restaure par la suite si ncessaire. Si vous avez un tat enregistr,
-     * allouez-le avec malloc et placez-le dans android_app.savedState avec
-     * la taille dans android_app.savedStateSize. Il sera libr pour vous
-     * plus tard.
+     * allouez-le avec malloc, ou crivez-le avec state_snapshot_begin(), et placez-le
+     * dans android_app.savedState avec la taille dans android_app.savedStateSize. Il
+     * sera libr pour vous plus tard.
      */
     APP_CMD_SAVE_STATE,
 
@@ -313,10 +428,18 @@ enum {
 
 /**
  * Appel quand ALooper_pollAll() retourne LOOPER_ID_MAIN, avec lecture du prochain
- * message de commande de l'application.
+ * message de commande de l'application. La commande et sa charge utile sont
+ * copies dans android_app->currentCmd. Retourne -1 si l'anneau est vide.
  */
 int8_t android_app_read_cmd(struct android_app* android_app);
 
+/**
+ * Lecture du prochain enregistrement de commande dans outCmd. Retourne 1 si une
+ * commande a t lue, 0 si l'anneau est vide ; dans ce cas le signal de
+ * LOOPER_ID_MAIN est rarm.
+ */
+int android_app_read_cmd_record(struct android_app* android_app, struct android_app_cmd* outCmd);
+
 /**
  * Appel avec la commande retourne par android_app_read_cmd() pour effectuer le
  * pr-traitement initial de la commande donne. Vous pouvez effectuer vos propres
@@ -331,6 +454,29 @@ void android_app_pre_exec_cmd(struct android_app* android_app, int8_t cmd);
  */
 void android_app_post_exec_cmd(struct android_app* android_app, int8_t cmd);
 
+/**
+ * Abonnement de function aux changements des champs de mask (ACONFIGURATION_*,
+ * ou -1 pour tous), appele par le thread de l'application avant onAppCmd.
+ * Retourne -1 si les ANDROID_APP_CONFIG_LISTENERS abonnements sont pris.
+ */
+int android_app_add_config_listener(struct android_app* android_app, int32_t mask,
+        android_app_config_function function, void* userData);
+
+/**
+ * Lit tous les vnements en attente dans inputQueue, comme au signal de
+ * LOOPER_ID_INPUT. Si l'tage d'entre est diffr, la file est de nouveau
+ * surveille par le looper :  appeler une fois par image, juste avant le dessin.
+ */
+void android_app_latch_input(struct android_app* android_app);
+
+/**
+ * Enregistre dans path (voir event_trace.h) les commandes, la configuration et
+ * les vnements d'entre remis  l'application,  partir de l'tat enregistr
+ * et de la configuration actuels.  appeler par android_main() avant sa boucle
+ * d'vnements. Retourne -1 si la trace ne peut pas tre cre.
+ */
+int android_app_start_recording(struct android_app* android_app, const char* path);
+
 /**
  * Fonction que le code de l'application doit implmenter, reprsentant
  * l'entre principale  l'application.
@@ -0,0 +1,639 @@
+// Lastorm tech.
+
+ASYNC_LOG_TAG(asset_stream_log_tag, "asset_stream", 10);
+
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, &asset_stream_log_tag, __VA_ARGS__)
+#define LOGW(...) ASYNC_LOG(ANDROID_LOG_WARN, &asset_stream_log_tag, __VA_ARGS__)
+
+enum {
+    ASSET_ENTRY_FREE,
+    ASSET_ENTRY_QUEUED,
+    ASSET_ENTRY_LOADING,
+    ASSET_ENTRY_RESIDENT,
+};
+
+enum {
+    ASSET_REQUEST_FREE,
+    ASSET_REQUEST_WAITING,
+    ASSET_REQUEST_DONE,
+};
+
+struct asset_stream_entry {
+    struct asset_stream_asset asset;
+    char path[ASSET_STREAM_MAX_PATH];
+    uint32_t hash;
+    int state;
+    int priority;
+
+    // File de chargement de sa priorit (entre QUEUED).
+    int prev;
+    int next;
+
+    // Demandes qui attendent le chargement ; waiterCount est lu sans verrou par
+    // le thread de chargement, qui abandonne une lecture qui n'est plus attendue.
+    int waiters;
+    int waiterCount;
+
+    int refs;
+    uint64_t lastUse;
+
+    // Projection (stockage MAPPED) ou bloc allou (COPIED).
+    void* mapBase;
+    size_t mapSize;
+    void* buffer;
+};
+
+struct asset_stream_request {
+    int32_t id;
+    uint32_t generation;
+    int state;
+    int entry;
+    int status;
+
+    // Attente d'une entre, demandes termines ou demandes libres.
+    int next;
+
+    asset_stream_callback callback;
+    void* userData;
+};
+
+struct asset_stream {
+    AAssetManager* manager;
+    ALooper* looper;
+    int eventFd;
+    size_t budget;
+    long pageSize;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+    int stop;
+    int workerCount;
+    pthread_t workers[ASSET_STREAM_MAX_WORKERS];
+
+    struct asset_stream_entry entries[ASSET_STREAM_MAX_ENTRIES];
+    struct asset_stream_request requests[ASSET_STREAM_MAX_REQUESTS];
+    int freeRequests;
+
+    int queueHead[ASSET_STREAM_PRIORITIES];
+    int queueTail[ASSET_STREAM_PRIORITIES];
+
+    // Demandes termines,  rendre par le thread du looper (file).
+    int completedHead;
+    int completedTail;
+
+    uint64_t tick;
+    struct asset_stream_stats stats;
+};
+
+static uint32_t asset_stream_hash(const char* path) {
+    uint32_t hash = 2166136261u;
+    for (; *path != '\0'; path++) {
+        hash = (hash ^ (uint8_t)*path) * 16777619u;
+    }
+    return hash;
+}
+
+static int asset_stream_index(const struct asset_stream* stream, const struct asset_stream_entry* entry) {
+    return (int)(entry - stream->entries);
+}
+
+// --------------------------------------------------------------------
+// Files (verrou tenu)
+// --------------------------------------------------------------------
+
+static void asset_stream_enqueue(struct asset_stream* stream, struct asset_stream_entry* entry) {
+    int index = asset_stream_index(stream, entry);
+    int priority = entry->priority;
+    entry->state = ASSET_ENTRY_QUEUED;
+    entry->next = -1;
+    entry->prev = stream->queueTail[priority];
+    if (entry->prev >= 0) {
+        stream->entries[entry->prev].next = index;
+    } else {
+        stream->queueHead[priority] = index;
+    }
+    stream->queueTail[priority] = index;
+}
+
+static void asset_stream_dequeue(struct asset_stream* stream, struct asset_stream_entry* entry) {
+    int priority = entry->priority;
+    if (entry->prev >= 0) {
+        stream->entries[entry->prev].next = entry->next;
+    } else {
+        stream->queueHead[priority] = entry->next;
+    }
+    if (entry->next >= 0) {
+        stream->entries[entry->next].prev = entry->prev;
+    } else {
+        stream->queueTail[priority] = entry->prev;
+    }
+    entry->prev = -1;
+    entry->next = -1;
+}
+
+static struct asset_stream_entry* asset_stream_pop(struct asset_stream* stream) {
+    for (int priority = 0; priority < ASSET_STREAM_PRIORITIES; priority++) {
+        int index = stream->queueHead[priority];
+        if (index >= 0) {
+            struct asset_stream_entry* entry = &stream->entries[index];
+            asset_stream_dequeue(stream, entry);
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void asset_stream_complete(struct asset_stream* stream, struct asset_stream_request* request,
+        int status) {
+    int index = (int)(request - stream->requests);
+    request->state = ASSET_REQUEST_DONE;
+    request->status = status;
+    request->next = -1;
+    if (stream->completedTail >= 0) {
+        stream->requests[stream->completedTail].next = index;
+    } else {
+        stream->completedHead = index;
+    }
+    stream->completedTail = index;
+}
+
+static void asset_stream_signal(struct asset_stream* stream) {
+    uint64_t one = 1;
+    if (write(stream->eventFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        LOGW("Unable to signal the looper: %s", strerror(errno));
+    }
+}
+
+// --------------------------------------------------------------------
+// Cache (verrou tenu)
+// --------------------------------------------------------------------
+
+static void asset_stream_free_entry(struct asset_stream* stream, struct asset_stream_entry* entry) {
+    if (entry->mapBase != NULL) {
+        munmap(entry->mapBase, entry->mapSize);
+    }
+    free(entry->buffer);
+    if (entry->state == ASSET_ENTRY_RESIDENT) {
+        stream->stats.residentBytes -= entry->asset.size;
+    }
+    entry->mapBase = NULL;
+    entry->mapSize = 0;
+    entry->buffer = NULL;
+    entry->asset.data = NULL;
+    entry->asset.size = 0;
+    entry->state = ASSET_ENTRY_FREE;
+}
+
+// Ressource non retenue la moins rcemment utilise, NULL s'il n'y en a pas.
+static struct asset_stream_entry* asset_stream_lru(struct asset_stream* stream) {
+    struct asset_stream_entry* oldest = NULL;
+    for (int i = 0; i < ASSET_STREAM_MAX_ENTRIES; i++) {
+        struct asset_stream_entry* entry = &stream->entries[i];
+        if (entry->state == ASSET_ENTRY_RESIDENT && entry->refs == 0
+                && (oldest == NULL || entry->lastUse < oldest->lastUse)) {
+            oldest = entry;
+        }
+    }
+    return oldest;
+}
+
+static void asset_stream_evict(struct asset_stream* stream, struct asset_stream_entry* entry) {
+    stream->stats.evictions++;
+    stream->stats.evictedBytes += entry->asset.size;
+    asset_stream_free_entry(stream, entry);
+}
+
+static size_t asset_stream_evict_to(struct asset_stream* stream, size_t targetBytes) {
+    size_t freed = 0;
+    while (stream->stats.residentBytes > targetBytes) {
+        struct asset_stream_entry* entry = asset_stream_lru(stream);
+        if (entry == NULL) {
+            break;
+        }
+        freed += entry->asset.size;
+        asset_stream_evict(stream, entry);
+    }
+    return freed;
+}
+
+static struct asset_stream_entry* asset_stream_lookup(struct asset_stream* stream, const char* path,
+        uint32_t hash) {
+    for (int i = 0; i < ASSET_STREAM_MAX_ENTRIES; i++) {
+        struct asset_stream_entry* entry = &stream->entries[i];
+        if (entry->state != ASSET_ENTRY_FREE && entry->hash == hash && strcmp(entry->path, path) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+// Entre libre ;  dfaut, la ressource non retenue la moins rcemment utilise est libre.
+static struct asset_stream_entry* asset_stream_alloc_entry(struct asset_stream* stream) {
+    for (int i = 0; i < ASSET_STREAM_MAX_ENTRIES; i++) {
+        if (stream->entries[i].state == ASSET_ENTRY_FREE) {
+            return &stream->entries[i];
+        }
+    }
+    struct asset_stream_entry* entry = asset_stream_lru(stream);
+    if (entry != NULL) {
+        asset_stream_evict(stream, entry);
+    }
+    return entry;
+}
+
+// --------------------------------------------------------------------
+// Chargement
+// --------------------------------------------------------------------
+
+// Lecture d'une ressource dans entry, sans verrou. Retourne l'tat de la demande.
+static int asset_stream_load(struct asset_stream* stream, struct asset_stream_entry* entry) {
+    AAsset* asset = AAssetManager_open(stream->manager, entry->path, AASSET_MODE_STREAMING);
+    if (asset == NULL) {
+        return ASSET_STREAM_NOT_FOUND;
+    }
+
+    // Ressource stocke sans compression : projection de l'APK, sans copie.
+    off_t start;
+    off_t length;
+    int fd = AAsset_openFileDescriptor(asset, &start, &length);
+    if (fd >= 0) {
+        off_t aligned = start - start % stream->pageSize;
+        size_t mapSize = (size_t)(length + (start - aligned));
+        void* base = length > 0 ? mmap(NULL, mapSize, PROT_READ, MAP_PRIVATE, fd, aligned) : MAP_FAILED;
+        close(fd);
+        if (base != MAP_FAILED) {
+            // Lecture anticipe : les pages sont lues ici plutt qu'au premier accs du moteur.
+            madvise(base, mapSize, MADV_WILLNEED);
+            AAsset_close(asset);
+            entry->mapBase = base;
+            entry->mapSize = mapSize;
+            entry->asset.data = (const uint8_t*)base + (start - aligned);
+            entry->asset.size = (size_t)length;
+            entry->asset.storage = ASSET_STREAM_MAPPED;
+            return ASSET_STREAM_OK;
+        }
+    }
+
+    size_t size = (size_t)AAsset_getLength(asset);
+    uint8_t* buffer = (uint8_t*)malloc(size > 0 ? size : 1);
+    if (buffer == NULL) {
+        AAsset_close(asset);
+        return ASSET_STREAM_NO_MEMORY;
+    }
+    size_t done = 0;
+    while (done < size) {
+        if (__atomic_load_n(&entry->waiterCount, __ATOMIC_RELAXED) == 0) {
+            free(buffer);
+            AAsset_close(asset);
+            return ASSET_STREAM_CANCELLED;
+        }
+        size_t chunk = size - done < ASSET_STREAM_READ_CHUNK ? size - done : ASSET_STREAM_READ_CHUNK;
+        int count = AAsset_read(asset, buffer + done, chunk);
+        if (count <= 0) {
+            free(buffer);
+            AAsset_close(asset);
+            return ASSET_STREAM_IO_ERROR;
+        }
+        done += (size_t)count;
+    }
+    AAsset_close(asset);
+    entry->buffer = buffer;
+    entry->asset.data = buffer;
+    entry->asset.size = size;
+    entry->asset.storage = ASSET_STREAM_COPIED;
+    return ASSET_STREAM_OK;
+}
+
+// Fin d'un chargement, verrou tenu : les demandes qui l'attendaient sont termines.
+static void asset_stream_finish(struct asset_stream* stream, struct asset_stream_entry* entry, int status) {
+    if (status == ASSET_STREAM_CANCELLED) {
+        if (entry->waiterCount > 0) {
+            // Demand de nouveau pendant l'abandon.
+            asset_stream_enqueue(stream, entry);
+        } else {
+            asset_stream_free_entry(stream, entry);
+        }
+        return;
+    }
+
+    int completed = entry->waiters >= 0;
+    if (status == ASSET_STREAM_OK) {
+        entry->state = ASSET_ENTRY_RESIDENT;
+        entry->lastUse = stream->tick++;
+        stream->stats.residentBytes += entry->asset.size;
+        if (stream->stats.residentBytes > stream->stats.peakResidentBytes) {
+            stream->stats.peakResidentBytes = stream->stats.residentBytes;
+        }
+        if (entry->asset.storage == ASSET_STREAM_MAPPED) {
+            stream->stats.mapped++;
+            stream->stats.mappedBytes += entry->asset.size;
+        } else {
+            stream->stats.copied++;
+            stream->stats.copiedBytes += entry->asset.size;
+        }
+    } else if (status == ASSET_STREAM_NOT_FOUND) {
+        stream->stats.failures++;
+        LOGI("%s not found", entry->path);
+    } else {
+        stream->stats.failures++;
+        LOGW("Unable to load %s (%d)", entry->path, status);
+    }
+    while (entry->waiters >= 0) {
+        struct asset_stream_request* request = &stream->requests[entry->waiters];
+        entry->waiters = request->next;
+        if (status == ASSET_STREAM_OK) {
+            entry->refs++;
+        }
+        asset_stream_complete(stream, request, status);
+    }
+    __atomic_store_n(&entry->waiterCount, 0, __ATOMIC_RELAXED);
+
+    if (status == ASSET_STREAM_OK) {
+        asset_stream_evict_to(stream, stream->budget);
+    } else {
+        asset_stream_free_entry(stream, entry);
+    }
+    if (completed) {
+        asset_stream_signal(stream);
+    }
+}
+
+static void* asset_stream_worker_main(void* param) {
+    struct asset_stream* stream = (struct asset_stream*)param;
+    pthread_mutex_lock(&stream->mutex);
+    while (!stream->stop) {
+        struct asset_stream_entry* entry = asset_stream_pop(stream);
+        if (entry == NULL) {
+            pthread_cond_wait(&stream->wake, &stream->mutex);
+            continue;
+        }
+        entry->state = ASSET_ENTRY_LOADING;
+        pthread_mutex_unlock(&stream->mutex);
+        int status = asset_stream_load(stream, entry);
+        pthread_mutex_lock(&stream->mutex);
+        asset_stream_finish(stream, entry, status);
+    }
+    pthread_mutex_unlock(&stream->mutex);
+    return NULL;
+}
+
+// --------------------------------------------------------------------
+// Rappels, sur le thread du looper
+// --------------------------------------------------------------------
+
+static int asset_stream_dispatch(int fd, int events, void* data) {
+    struct asset_stream* stream = (struct asset_stream*)data;
+    uint64_t value;
+    if (read(fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+        LOGW("Unable to read the completion event: %s", strerror(errno));
+    }
+    for (;;) {
+        pthread_mutex_lock(&stream->mutex);
+        int index = stream->completedHead;
+        if (index < 0) {
+            pthread_mutex_unlock(&stream->mutex);
+            break;
+        }
+        struct asset_stream_request* request = &stream->requests[index];
+        stream->completedHead = request->next;
+        if (stream->completedHead < 0) {
+            stream->completedTail = -1;
+        }
+        int32_t id = request->id;
+        int status = request->status;
+        asset_stream_callback callback = request->callback;
+        void* userData = request->userData;
+        const struct asset_stream_asset* asset =
+                status == ASSET_STREAM_OK ? &stream->entries[request->entry].asset : NULL;
+        request->state = ASSET_REQUEST_FREE;
+        request->next = stream->freeRequests;
+        stream->freeRequests = index;
+        pthread_mutex_unlock(&stream->mutex);
+
+        callback(userData, id, status, asset);
+    }
+    return 1;
+}
+
+// --------------------------------------------------------------------
+// Interface
+// --------------------------------------------------------------------
+
+struct asset_stream* asset_stream_create(AAssetManager* manager, ALooper* looper, int workers,
+        size_t budgetBytes) {
+    struct asset_stream* stream = (struct asset_stream*)calloc(1, sizeof(struct asset_stream));
+    if (stream == NULL) {
+        return NULL;
+    }
+    stream->eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stream->eventFd < 0) {
+        free(stream);
+        return NULL;
+    }
+    stream->manager = manager;
+    stream->looper = looper;
+    stream->budget = budgetBytes;
+    stream->pageSize = sysconf(_SC_PAGESIZE);
+    for (int i = 0; i < ASSET_STREAM_MAX_ENTRIES; i++) {
+        stream->entries[i].waiters = -1;
+        stream->entries[i].prev = -1;
+        stream->entries[i].next = -1;
+        stream->entries[i].asset.path = stream->entries[i].path;
+    }
+    for (int i = 0; i < ASSET_STREAM_MAX_REQUESTS; i++) {
+        stream->requests[i].next = i + 1 < ASSET_STREAM_MAX_REQUESTS ? i + 1 : -1;
+    }
+    for (int i = 0; i < ASSET_STREAM_PRIORITIES; i++) {
+        stream->queueHead[i] = -1;
+        stream->queueTail[i] = -1;
+    }
+    stream->completedHead = -1;
+    stream->completedTail = -1;
+    ALooper_addFd(looper, stream->eventFd, ALOOPER_POLL_CALLBACK, ALOOPER_EVENT_INPUT,
+            asset_stream_dispatch, stream);
+
+    if (workers <= 0) {
+        workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (workers > 2) workers = 2;
+    }
+    if (workers > ASSET_STREAM_MAX_WORKERS) workers = ASSET_STREAM_MAX_WORKERS;
+    if (workers < 1) workers = 1;
+    pthread_mutex_init(&stream->mutex, NULL);
+    pthread_cond_init(&stream->wake, NULL);
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&stream->workers[i], NULL, asset_stream_worker_main, stream) != 0) {
+            LOGW("Unable to start asset worker %d", i);
+            break;
+        }
+        stream->workerCount++;
+    }
+    if (stream->workerCount == 0) {
+        asset_stream_destroy(stream);
+        return NULL;
+    }
+    LOGI("asset stream: %d workers, budget %zu KiB", stream->workerCount, budgetBytes >> 10);
+    return stream;
+}
+
+void asset_stream_destroy(struct asset_stream* stream) {
+    if (stream == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&stream->mutex);
+    stream->stop = 1;
+    pthread_cond_broadcast(&stream->wake);
+    pthread_mutex_unlock(&stream->mutex);
+    for (int i = 0; i < stream->workerCount; i++) {
+        pthread_join(stream->workers[i], NULL);
+    }
+    ALooper_removeFd(stream->looper, stream->eventFd);
+    close(stream->eventFd);
+    for (int i = 0; i < ASSET_STREAM_MAX_ENTRIES; i++) {
+        asset_stream_free_entry(stream, &stream->entries[i]);
+    }
+    pthread_cond_destroy(&stream->wake);
+    pthread_mutex_destroy(&stream->mutex);
+    free(stream);
+}
+
+int32_t asset_stream_request(struct asset_stream* stream, const char* path, int priority,
+        asset_stream_callback callback, void* userData) {
+    size_t length = strlen(path);
+    if (length >= ASSET_STREAM_MAX_PATH) {
+        return -1;
+    }
+    if (priority < 0) priority = 0;
+    if (priority >= ASSET_STREAM_PRIORITIES) priority = ASSET_STREAM_PRIORITIES - 1;
+    uint32_t hash = asset_stream_hash(path);
+
+    pthread_mutex_lock(&stream->mutex);
+    int index = stream->freeRequests;
+    struct asset_stream_entry* entry = asset_stream_lookup(stream, path, hash);
+    int created = entry == NULL;
+    if (created && index >= 0) {
+        entry = asset_stream_alloc_entry(stream);
+    }
+    if (index < 0 || entry == NULL) {
+        pthread_mutex_unlock(&stream->mutex);
+        return -1;
+    }
+
+    struct asset_stream_request* request = &stream->requests[index];
+    stream->freeRequests = request->next;
+    request->generation = request->generation + 1 < INT32_MAX / ASSET_STREAM_MAX_REQUESTS
+            ? request->generation + 1 : 1;
+    request->id = (int32_t)(request->generation * ASSET_STREAM_MAX_REQUESTS + index);
+    request->state = ASSET_REQUEST_WAITING;
+    request->entry = asset_stream_index(stream, entry);
+    request->callback = callback;
+    request->userData = userData;
+    stream->stats.requests++;
+
+    if (entry->state == ASSET_ENTRY_RESIDENT) {
+        entry->refs++;
+        entry->lastUse = stream->tick++;
+        stream->stats.hits++;
+        asset_stream_complete(stream, request, ASSET_STREAM_OK);
+        asset_stream_signal(stream);
+    } else {
+        if (created) {
+            memcpy(entry->path, path, length + 1);
+            entry->hash = hash;
+            entry->priority = priority;
+            entry->refs = 0;
+            asset_stream_enqueue(stream, entry);
+            pthread_cond_signal(&stream->wake);
+        } else {
+            stream->stats.joined++;
+            if (entry->state == ASSET_ENTRY_QUEUED && priority < entry->priority) {
+                asset_stream_dequeue(stream, entry);
+                entry->priority = priority;
+                asset_stream_enqueue(stream, entry);
+            }
+        }
+        request->next = entry->waiters;
+        entry->waiters = index;
+        __atomic_store_n(&entry->waiterCount, entry->waiterCount + 1, __ATOMIC_RELAXED);
+    }
+    int32_t id = request->id;
+    pthread_mutex_unlock(&stream->mutex);
+    return id;
+}
+
+int asset_stream_cancel(struct asset_stream* stream, int32_t id) {
+    if (id <= 0) {
+        return -1;
+    }
+    int index = id % ASSET_STREAM_MAX_REQUESTS;
+    pthread_mutex_lock(&stream->mutex);
+    struct asset_stream_request* request = &stream->requests[index];
+    if (request->id != id || request->state != ASSET_REQUEST_WAITING) {
+        pthread_mutex_unlock(&stream->mutex);
+        return -1;
+    }
+    struct asset_stream_entry* entry = &stream->entries[request->entry];
+    int* link = &entry->waiters;
+    while (*link != index) {
+        link = &stream->requests[*link].next;
+    }
+    *link = request->next;
+    __atomic_store_n(&entry->waiterCount, entry->waiterCount - 1, __ATOMIC_RELAXED);
+    if (entry->waiterCount == 0 && entry->state == ASSET_ENTRY_QUEUED) {
+        asset_stream_dequeue(stream, entry);
+        asset_stream_free_entry(stream, entry);
+    }
+    stream->stats.cancelled++;
+    asset_stream_complete(stream, request, ASSET_STREAM_CANCELLED);
+    asset_stream_signal(stream);
+    pthread_mutex_unlock(&stream->mutex);
+    return 0;
+}
+
+const struct asset_stream_asset* asset_stream_find(struct asset_stream* stream, const char* path) {
+    uint32_t hash = asset_stream_hash(path);
+    pthread_mutex_lock(&stream->mutex);
+    struct asset_stream_entry* entry = asset_stream_lookup(stream, path, hash);
+    if (entry == NULL || entry->state != ASSET_ENTRY_RESIDENT) {
+        pthread_mutex_unlock(&stream->mutex);
+        return NULL;
+    }
+    entry->refs++;
+    entry->lastUse = stream->tick++;
+    pthread_mutex_unlock(&stream->mutex);
+    return &entry->asset;
+}
+
+void asset_stream_release(struct asset_stream* stream, const struct asset_stream_asset* asset) {
+    if (asset == NULL) {
+        return;
+    }
+    struct asset_stream_entry* entry = (struct asset_stream_entry*)
+            ((const uint8_t*)asset - offsetof(struct asset_stream_entry, asset));
+    pthread_mutex_lock(&stream->mutex);
+    if (--entry->refs == 0) {
+        entry->lastUse = stream->tick++;
+        asset_stream_evict_to(stream, stream->budget);
+    }
+    pthread_mutex_unlock(&stream->mutex);
+}
+
+void asset_stream_set_budget(struct asset_stream* stream, size_t budgetBytes) {
+    pthread_mutex_lock(&stream->mutex);
+    stream->budget = budgetBytes;
+    asset_stream_evict_to(stream, budgetBytes);
+    pthread_mutex_unlock(&stream->mutex);
+}
+
+size_t asset_stream_trim(struct asset_stream* stream, size_t targetBytes) {
+    pthread_mutex_lock(&stream->mutex);
+    size_t freed = asset_stream_evict_to(stream, targetBytes);
+    pthread_mutex_unlock(&stream->mutex);
+    return freed;
+}
+
+void asset_stream_get_stats(const struct asset_stream* stream, struct asset_stream_stats* outStats) {
+    struct asset_stream* mutableStream = (struct asset_stream*)stream;
+    pthread_mutex_lock(&mutableStream->mutex);
+    *outStats = stream->stats;
+    pthread_mutex_unlock(&mutableStream->mutex);
+}
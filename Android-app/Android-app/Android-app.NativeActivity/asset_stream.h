@@ -0,0 +1,166 @@
+// Lastorm tech.
+
+#ifndef _ASSET_STREAM_H
+#define _ASSET_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <android/asset_manager.h>
+#include <android/looper.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Chargement asynchrone des ressources de l'APK.
+ *
+ * Les demandes sont ranges dans ASSET_STREAM_PRIORITIES files, servies par
+ * ordre de priorit puis d'arrive par un groupe de threads de chargement. Une
+ * ressource stocke sans compression est projete en mmoire
+ * (AAsset_openFileDescriptor() puis mmap()) : aucune copie, la lecture anticipe
+ * est demande par le thread de chargement. Une ressource compresse est
+ * dcompresse dans un bloc allou.
+ *
+ * Les ressources charges restent dans un cache, dans la limite d'un budget en
+ * octets : au-del, les moins rcemment utilises qui ne sont plus retenues sont
+ * libres. Une demande de ressource dj prsente ne fait aucune lecture ; une
+ * demande de ressource en cours de chargement attend le mme chargement.
+ *
+ * Les rappels de fin sont appels par le thread du looper donn  la cration,
+ * jamais pendant asset_stream_request(). Une ressource rendue par un rappel (ou
+ * par asset_stream_find()) est retenue : elle n'est pas libre avant l'appel
+ *  asset_stream_release() correspondant.
+ *
+ * Les fonctions sont rserves au thread du looper.
+ */
+
+// Threads de chargement au plus.
+#define ASSET_STREAM_MAX_WORKERS 4
+
+// Demandes en cours et ressources (charges ou en chargement) au plus.
+#define ASSET_STREAM_MAX_REQUESTS 256
+#define ASSET_STREAM_MAX_ENTRIES 256
+
+// Longueur maximale d'un chemin, zro final compris.
+#define ASSET_STREAM_MAX_PATH 128
+
+// Taille des lectures d'une ressource compresse ; l'annulation est vrifie entre deux.
+#define ASSET_STREAM_READ_CHUNK (256 << 10)
+
+enum {
+    ASSET_STREAM_PRIORITY_HIGH,
+    ASSET_STREAM_PRIORITY_NORMAL,
+    ASSET_STREAM_PRIORITY_LOW,
+
+    ASSET_STREAM_PRIORITIES
+};
+
+// tat d'une demande termine.
+enum {
+    ASSET_STREAM_OK,
+    ASSET_STREAM_NOT_FOUND,
+    ASSET_STREAM_IO_ERROR,
+    ASSET_STREAM_NO_MEMORY,
+    ASSET_STREAM_CANCELLED,
+};
+
+// Stockage d'une ressource charge.
+enum {
+    ASSET_STREAM_MAPPED,
+    ASSET_STREAM_COPIED,
+};
+
+/**
+ * Ressource charge, en lecture seule.
+ */
+struct asset_stream_asset {
+    const char* path;
+    const void* data;
+    size_t size;
+    int storage;
+};
+
+/**
+ * Rappel de fin d'une demande. asset n'est pas NULL si status vaut
+ * ASSET_STREAM_OK ; il doit alors tre rendu par asset_stream_release().
+ */
+typedef void (*asset_stream_callback)(void* userData, int32_t id, int status,
+        const struct asset_stream_asset* asset);
+
+struct asset_stream_stats {
+    uint64_t requests;
+    uint64_t hits;
+    uint64_t joined;
+    uint64_t mapped;
+    uint64_t copied;
+    uint64_t mappedBytes;
+    uint64_t copiedBytes;
+    uint64_t failures;
+    uint64_t cancelled;
+    uint64_t evictions;
+    uint64_t evictedBytes;
+
+    // Octets des ressources prsentes, et maximum atteint.
+    uint64_t residentBytes;
+    uint64_t peakResidentBytes;
+};
+
+struct asset_stream;
+
+/**
+ * Cre le chargeur pour manager. Les rappels sont appels par le thread de
+ * looper. workers vaut au plus ASSET_STREAM_MAX_WORKERS (0 : un par cur,
+ * deux au plus). budgetBytes borne le cache. Retourne NULL en cas d'erreur.
+ */
+struct asset_stream* asset_stream_create(AAssetManager* manager, ALooper* looper, int workers,
+        size_t budgetBytes);
+
+/**
+ * Annule les demandes en attente (sans rappel), attend la fin des chargements
+ * en cours et libre toutes les ressources, retenues ou non.
+ */
+void asset_stream_destroy(struct asset_stream* stream);
+
+/**
+ * Demande le chargement de path. Retourne l'identifiant de la demande (positif),
+ * ou -1 si le chemin est trop long ou si les demandes ou les ressources sont
+ * toutes utilises.
+ */
+int32_t asset_stream_request(struct asset_stream* stream, const char* path, int priority,
+        asset_stream_callback callback, void* userData);
+
+/**
+ * Annule une demande qui n'est pas termine : son rappel est appel avec
+ * ASSET_STREAM_CANCELLED. Un chargement qui n'est plus attendu par aucune
+ * demande est abandonn. Retourne 0, ou -1 si la demande est inconnue ou dj
+ * termine.
+ */
+int asset_stream_cancel(struct asset_stream* stream, int32_t id);
+
+/**
+ * Ressource prsente dans le cache, retenue ; NULL si elle n'est pas charge.
+ */
+const struct asset_stream_asset* asset_stream_find(struct asset_stream* stream, const char* path);
+
+void asset_stream_release(struct asset_stream* stream, const struct asset_stream_asset* asset);
+
+/**
+ * Change le budget du cache et libre aussitt ce qui le dpasse.
+ */
+void asset_stream_set_budget(struct asset_stream* stream, size_t budgetBytes);
+
+/**
+ * Libre les ressources non retenues jusqu' ne plus occuper que targetBytes.
+ * Retourne le nombre d'octets librs.
+ */
+size_t asset_stream_trim(struct asset_stream* stream, size_t targetBytes);
+
+void asset_stream_get_stats(const struct asset_stream* stream, struct asset_stream_stats* outStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ASSET_STREAM_H */
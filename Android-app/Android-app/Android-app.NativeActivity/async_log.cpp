@@ -0,0 +1,643 @@
+// Lastorm tech.
+
+// Types de stockage des arguments, dduits du format.
+enum {
+    ASYNC_LOG_ARG_NONE,
+    ASYNC_LOG_ARG_INT,
+    ASYNC_LOG_ARG_LONG,
+    ASYNC_LOG_ARG_LLONG,
+    ASYNC_LOG_ARG_INTMAX,
+    ASYNC_LOG_ARG_SIZE,
+    ASYNC_LOG_ARG_PTRDIFF,
+    ASYNC_LOG_ARG_DOUBLE,
+    ASYNC_LOG_ARG_LDOUBLE,
+    ASYNC_LOG_ARG_STRING,
+    ASYNC_LOG_ARG_POINTER,
+};
+
+// Enregistrement de bourrage, en fin d'anneau.
+#define ASYNC_LOG_PADDING 1
+
+#define ASYNC_LOG_MAX_RECORD (sizeof(struct async_log_record) \
+        + ASYNC_LOG_MAX_ARGS * (8 + ASYNC_LOG_MAX_STRING + 8))
+
+#define ASYNC_LOG_MAX_TAGS 32
+#define ASYNC_LOG_MAX_LINE 1024
+
+/**
+ * En-tte d'un enregistrement ; size comprend l'en-tte et les arguments, et
+ * reste un multiple de huit.
+ */
+struct async_log_record {
+    uint32_t size;
+    uint32_t flags;
+    const struct async_log_site* site;
+    int64_t timestamp;
+};
+
+/**
+ * Anneau d'un thread : crit par ce thread seul, lu par le thread qui vide
+ * le journal.
+ */
+struct async_log_ring {
+    struct async_log_ring* next;
+    int tid;
+
+    // Valeur diffrente de zro quand le thread propritaire est termin.
+    int retired;
+
+    uint32_t head;
+    uint32_t tail;
+    unsigned char data[ASYNC_LOG_RING_SIZE];
+};
+
+/**
+ * Description d'une conversion du format.
+ */
+struct async_log_spec {
+    char text[32];
+    char conversion;
+    int starCount;
+    int type;
+};
+
+static pthread_once_t async_log_once = PTHREAD_ONCE_INIT;
+static pthread_key_t async_log_key;
+static __thread struct async_log_ring* async_log_current;
+
+// Protge la liste des anneaux, le fichier de sortie et les tiquettes vues ;
+// srialise le vidage.
+static pthread_mutex_t async_log_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct async_log_ring* async_log_rings;
+static FILE* async_log_file;
+static struct async_log_tag* async_log_tags[ASYNC_LOG_MAX_TAGS];
+static int async_log_tag_count;
+
+// Rveil et arrt du thread d'arrire-plan.
+static pthread_mutex_t async_log_wake_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t async_log_wake_cond;
+static int async_log_wake_requested;
+static int async_log_stopping;
+static int async_log_running;
+static pthread_t async_log_thread;
+
+static struct async_log_stats async_log_stats_global;
+
+static int64_t async_log_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// --------------------------------------------------------------------
+// Analyse du format
+// --------------------------------------------------------------------
+
+static int async_log_integer_type(const char* length) {
+    if (length[0] == 'l' && length[1] == 'l') return ASYNC_LOG_ARG_LLONG;
+    switch (length[0]) {
+        case 'l': return ASYNC_LOG_ARG_LONG;
+        case 'j': return ASYNC_LOG_ARG_INTMAX;
+        case 'z': return ASYNC_LOG_ARG_SIZE;
+        case 't': return ASYNC_LOG_ARG_PTRDIFF;
+        default: return ASYNC_LOG_ARG_INT;
+    }
+}
+
+/**
+ * Lit la conversion qui commence au '%' de *format et avance *format aprs elle.
+ * Les largeurs et prcisions '*' sont comptes dans starCount.
+ */
+static void async_log_parse_spec(const char** format, struct async_log_spec* spec) {
+    const char* f = *format;
+    size_t n = 0;
+    char length[3] = { 0, 0, 0 };
+    size_t lengthCount = 0;
+
+    spec->text[n++] = *f++;
+    spec->starCount = 0;
+    while (*f != '\0' && strchr("-+ #0", *f) != NULL && n < sizeof(spec->text) - 8) {
+        spec->text[n++] = *f++;
+    }
+    for (int part = 0; part < 2; part++) {
+        if (part == 1) {
+            if (*f != '.') break;
+            spec->text[n++] = *f++;
+        }
+        if (*f == '*') {
+            spec->text[n++] = *f++;
+            spec->starCount++;
+        } else {
+            while (*f >= '0' && *f <= '9' && n < sizeof(spec->text) - 8) {
+                spec->text[n++] = *f++;
+            }
+        }
+    }
+    while (*f != '\0' && strchr("hljztL", *f) != NULL && lengthCount < 2) {
+        length[lengthCount++] = *f;
+        spec->text[n++] = *f++;
+    }
+
+    spec->conversion = *f;
+    if (*f != '\0') {
+        spec->text[n++] = *f++;
+    }
+    spec->text[n] = '\0';
+
+    switch (spec->conversion) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+            spec->type = async_log_integer_type(length);
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            spec->type = length[0] == 'L' ? ASYNC_LOG_ARG_LDOUBLE : ASYNC_LOG_ARG_DOUBLE;
+            break;
+        case 's':
+            spec->type = ASYNC_LOG_ARG_STRING;
+            break;
+        case 'p': case 'n':
+            spec->type = ASYNC_LOG_ARG_POINTER;
+            break;
+        default:
+            spec->type = ASYNC_LOG_ARG_NONE;
+            break;
+    }
+    *format = f;
+}
+
+static int async_log_parse_format(const char* format, uint8_t* types) {
+    int count = 0;
+    while (*format != '\0') {
+        if (*format != '%') {
+            format++;
+            continue;
+        }
+        if (format[1] == '%') {
+            format += 2;
+            continue;
+        }
+        struct async_log_spec spec;
+        async_log_parse_spec(&format, &spec);
+        for (int i = 0; i < spec.starCount && count < ASYNC_LOG_MAX_ARGS; i++) {
+            types[count++] = ASYNC_LOG_ARG_INT;
+        }
+        if (spec.type != ASYNC_LOG_ARG_NONE && count < ASYNC_LOG_MAX_ARGS) {
+            types[count++] = (uint8_t)spec.type;
+        }
+    }
+    return count;
+}
+
+// Types des arguments du site : analyss une fois, puis lus sans verrou.
+static int async_log_site_types(struct async_log_site* site, uint8_t* scratch,
+        const uint8_t** outTypes) {
+    if (__atomic_load_n(&site->parsed, __ATOMIC_ACQUIRE) == 2) {
+        *outTypes = site->argTypes;
+        return site->argCount;
+    }
+    int expected = 0;
+    if (__atomic_compare_exchange_n(&site->parsed, &expected, 1, 0,
+            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        site->argCount = async_log_parse_format(site->format, site->argTypes);
+        __atomic_store_n(&site->parsed, 2, __ATOMIC_RELEASE);
+        *outTypes = site->argTypes;
+        return site->argCount;
+    }
+    // Un autre thread analyse le mme site : analyse locale.
+    *outTypes = scratch;
+    return async_log_parse_format(site->format, scratch);
+}
+
+// --------------------------------------------------------------------
+// criture
+// --------------------------------------------------------------------
+
+static void async_log_thread_exit(void* ring) {
+    __atomic_store_n(&((struct async_log_ring*)ring)->retired, 1, __ATOMIC_RELEASE);
+}
+
+static void* async_log_main(void* param);
+static void async_log_shutdown(void);
+
+static void async_log_init(void) {
+    pthread_key_create(&async_log_key, async_log_thread_exit);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&async_log_wake_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&async_log_thread, NULL, async_log_main, NULL) == 0) {
+        async_log_running = 1;
+        atexit(async_log_shutdown);
+    }
+}
+
+static struct async_log_ring* async_log_ring_get(void) {
+    struct async_log_ring* ring = async_log_current;
+    if (ring != NULL) {
+        return ring;
+    }
+    pthread_once(&async_log_once, async_log_init);
+
+    ring = (struct async_log_ring*)calloc(1, sizeof(struct async_log_ring));
+    if (ring == NULL) {
+        return NULL;
+    }
+    ring->tid = (int)syscall(SYS_gettid);
+    pthread_mutex_lock(&async_log_mutex);
+    ring->next = async_log_rings;
+    async_log_rings = ring;
+    pthread_mutex_unlock(&async_log_mutex);
+
+    pthread_setspecific(async_log_key, ring);
+    async_log_current = ring;
+    return ring;
+}
+
+static int async_log_admit(struct async_log_tag* tag, int64_t now) {
+    if (tag->ratePerSecond == 0) {
+        return 1;
+    }
+    int64_t window = now / 1000000000LL;
+    int64_t current = __atomic_load_n(&tag->window, __ATOMIC_RELAXED);
+    if (window != current && __atomic_compare_exchange_n(&tag->window, &current, window, 0,
+            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&tag->count, 0, __ATOMIC_RELAXED);
+    }
+    if (__atomic_fetch_add(&tag->count, 1, __ATOMIC_RELAXED) < tag->ratePerSecond) {
+        return 1;
+    }
+    __atomic_fetch_add(&tag->suppressed, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&async_log_stats_global.suppressed, 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+static void async_log_wake(void) {
+    pthread_mutex_lock(&async_log_wake_mutex);
+    async_log_wake_requested = 1;
+    pthread_cond_signal(&async_log_wake_cond);
+    pthread_mutex_unlock(&async_log_wake_mutex);
+}
+
+static int async_log_ring_put(struct async_log_ring* ring, const unsigned char* record,
+        uint32_t size) {
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = ring->tail;
+    uint32_t offset = tail & (ASYNC_LOG_RING_SIZE - 1);
+    uint32_t contiguous = ASYNC_LOG_RING_SIZE - offset;
+    uint32_t needed = size <= contiguous ? size : size + contiguous;
+    if (ASYNC_LOG_RING_SIZE - (tail - head) < needed) {
+        return 0;
+    }
+    if (size > contiguous) {
+        struct async_log_record* padding = (struct async_log_record*)&ring->data[offset];
+        padding->size = contiguous;
+        padding->flags = ASYNC_LOG_PADDING;
+        tail += contiguous;
+        offset = 0;
+    }
+    memcpy(&ring->data[offset], record, size);
+    __atomic_store_n(&ring->tail, tail + size, __ATOMIC_RELEASE);
+
+    // Le thread d'arrire-plan est rveill sans attendre son prochain passage
+    // quand l'anneau franchit la moiti de sa capacit.
+    uint32_t used = tail + size - head;
+    if (used >= ASYNC_LOG_RING_SIZE / 2 && used - size < ASYNC_LOG_RING_SIZE / 2
+            && async_log_running) {
+        async_log_wake();
+    }
+    return 1;
+}
+
+void async_log_write(struct async_log_site* site, ...) {
+    int64_t now = async_log_now_ns();
+    if (!async_log_admit(site->tag, now)) {
+        return;
+    }
+    struct async_log_ring* ring = async_log_ring_get();
+    if (ring == NULL) {
+        return;
+    }
+
+    uint8_t scratch[ASYNC_LOG_MAX_ARGS];
+    const uint8_t* types;
+    int argCount = async_log_site_types(site, scratch, &types);
+
+    uint64_t buffer[ASYNC_LOG_MAX_RECORD / sizeof(uint64_t) + 1];
+    unsigned char* record = (unsigned char*)buffer;
+    struct async_log_record* header = (struct async_log_record*)record;
+    header->flags = 0;
+    header->site = site;
+    header->timestamp = now;
+    size_t size = sizeof(struct async_log_record);
+
+    va_list ap;
+    va_start(ap, site);
+    for (int i = 0; i < argCount; i++) {
+        uint64_t slot = 0;
+        switch (types[i]) {
+            case ASYNC_LOG_ARG_INT: slot = (uint64_t)(int64_t)va_arg(ap, int); break;
+            case ASYNC_LOG_ARG_LONG: slot = (uint64_t)va_arg(ap, long); break;
+            case ASYNC_LOG_ARG_LLONG: slot = (uint64_t)va_arg(ap, long long); break;
+            case ASYNC_LOG_ARG_INTMAX: slot = (uint64_t)va_arg(ap, intmax_t); break;
+            case ASYNC_LOG_ARG_SIZE: slot = (uint64_t)va_arg(ap, size_t); break;
+            case ASYNC_LOG_ARG_PTRDIFF: slot = (uint64_t)va_arg(ap, ptrdiff_t); break;
+            case ASYNC_LOG_ARG_POINTER: slot = (uint64_t)(uintptr_t)va_arg(ap, void*); break;
+            case ASYNC_LOG_ARG_DOUBLE: {
+                double value = va_arg(ap, double);
+                memcpy(&slot, &value, sizeof(slot));
+                break;
+            }
+            case ASYNC_LOG_ARG_LDOUBLE: {
+                double value = (double)va_arg(ap, long double);
+                memcpy(&slot, &value, sizeof(slot));
+                break;
+            }
+            case ASYNC_LOG_ARG_STRING: {
+                // Longueur sur 32 bits puis octets termins par un zro, aligns sur 8.
+                const char* text = va_arg(ap, const char*);
+                if (text == NULL) text = "(null)";
+                uint32_t length = (uint32_t)strnlen(text, ASYNC_LOG_MAX_STRING);
+                memcpy(record + size, &length, sizeof(length));
+                memcpy(record + size + sizeof(length), text, length);
+                record[size + sizeof(length) + length] = '\0';
+                size += (sizeof(length) + length + 1 + 7) & ~(size_t)7;
+                continue;
+            }
+        }
+        memcpy(record + size, &slot, sizeof(slot));
+        size += sizeof(slot);
+    }
+    va_end(ap);
+    header->size = (uint32_t)size;
+
+    if (async_log_ring_put(ring, record, (uint32_t)size)) {
+        __atomic_fetch_add(&async_log_stats_global.written, 1, __ATOMIC_RELAXED);
+    } else {
+        __atomic_fetch_add(&async_log_stats_global.dropped, 1, __ATOMIC_RELAXED);
+    }
+    if (site->level >= ANDROID_LOG_ERROR && async_log_running) {
+        async_log_wake();
+    }
+}
+
+// --------------------------------------------------------------------
+// Mise en forme et vidage
+// --------------------------------------------------------------------
+
+static size_t async_log_append(char* line, size_t length, int written) {
+    if (written < 0) return length;
+    size_t end = length + (size_t)written;
+    return end < ASYNC_LOG_MAX_LINE - 1 ? end : ASYNC_LOG_MAX_LINE - 1;
+}
+
+// Remplace les '*' de la conversion par les valeurs lues.
+static void async_log_expand_stars(const struct async_log_spec* spec, const int* stars,
+        char* out, size_t outSize) {
+    size_t n = 0;
+    int star = 0;
+    for (const char* c = spec->text; *c != '\0' && n < outSize - 12; c++) {
+        if (*c == '*') {
+            n += snprintf(out + n, outSize - n, "%d", stars[star++]);
+        } else {
+            out[n++] = *c;
+        }
+    }
+    out[n] = '\0';
+}
+
+static void async_log_format(const struct async_log_record* record, char* line) {
+    const struct async_log_site* site = record->site;
+    const unsigned char* payload = (const unsigned char*)(record + 1);
+    const unsigned char* end = (const unsigned char*)record + record->size;
+    const char* f = site->format;
+    size_t n = 0;
+
+    while (*f != '\0' && n < ASYNC_LOG_MAX_LINE - 1) {
+        if (*f != '%') {
+            line[n++] = *f++;
+            continue;
+        }
+        if (f[1] == '%') {
+            line[n++] = '%';
+            f += 2;
+            continue;
+        }
+
+        struct async_log_spec spec;
+        async_log_parse_spec(&f, &spec);
+        int stars[2] = { 0, 0 };
+        for (int i = 0; i < spec.starCount && payload + 8 <= end; i++) {
+            uint64_t slot;
+            memcpy(&slot, payload, sizeof(slot));
+            stars[i] = (int)(int64_t)slot;
+            payload += 8;
+        }
+        if (spec.type == ASYNC_LOG_ARG_NONE || payload + 8 > end) {
+            n = async_log_append(line, n, snprintf(line + n, ASYNC_LOG_MAX_LINE - n, "%s", spec.text));
+            continue;
+        }
+
+        char text[64];
+        async_log_expand_stars(&spec, stars, text, sizeof(text));
+        char* out = line + n;
+        size_t room = ASYNC_LOG_MAX_LINE - n;
+        uint64_t slot;
+        memcpy(&slot, payload, sizeof(slot));
+        int written = 0;
+        switch (spec.type) {
+            case ASYNC_LOG_ARG_INT: written = snprintf(out, room, text, (int)slot); break;
+            case ASYNC_LOG_ARG_LONG: written = snprintf(out, room, text, (long)slot); break;
+            case ASYNC_LOG_ARG_LLONG: written = snprintf(out, room, text, (long long)slot); break;
+            case ASYNC_LOG_ARG_INTMAX: written = snprintf(out, room, text, (intmax_t)slot); break;
+            case ASYNC_LOG_ARG_SIZE: written = snprintf(out, room, text, (size_t)slot); break;
+            case ASYNC_LOG_ARG_PTRDIFF: written = snprintf(out, room, text, (ptrdiff_t)slot); break;
+            case ASYNC_LOG_ARG_POINTER:
+                if (spec.conversion != 'n') {
+                    written = snprintf(out, room, text, (void*)(uintptr_t)slot);
+                }
+                break;
+            case ASYNC_LOG_ARG_DOUBLE:
+            case ASYNC_LOG_ARG_LDOUBLE: {
+                double value;
+                memcpy(&value, &slot, sizeof(value));
+                written = spec.type == ASYNC_LOG_ARG_LDOUBLE
+                        ? snprintf(out, room, text, (long double)value)
+                        : snprintf(out, room, text, value);
+                break;
+            }
+            case ASYNC_LOG_ARG_STRING: {
+                uint32_t length;
+                memcpy(&length, payload, sizeof(length));
+                written = snprintf(out, room, text, (const char*)payload + sizeof(length));
+                payload += (sizeof(length) + length + 1 + 7) & ~(size_t)7;
+                n = async_log_append(line, n, written);
+                continue;
+            }
+        }
+        payload += 8;
+        n = async_log_append(line, n, written);
+    }
+
+    // Les formats du code de collage se terminent souvent par un saut de ligne.
+    while (n > 0 && line[n - 1] == '\n') n--;
+    line[n] = '\0';
+}
+
+// Doit tre appele avec async_log_mutex verrouill.
+static void async_log_emit(int level, const char* tag, int tid, int64_t timestamp,
+        const char* text) {
+    static const char levels[] = "??VDIWEFS";
+    if (async_log_file != NULL) {
+        fprintf(async_log_file, "%lld.%06lld %5d %c/%s: %s\n",
+                (long long)(timestamp / 1000000000LL), (long long)(timestamp % 1000000000LL / 1000),
+                tid, levels[level & 7], tag, text);
+    } else {
+        __android_log_write(level, tag, text);
+    }
+    __atomic_fetch_add(&async_log_stats_global.flushed, 1, __ATOMIC_RELAXED);
+}
+
+// Doit tre appele avec async_log_mutex verrouill.
+static void async_log_note_tag(struct async_log_tag* tag) {
+    for (int i = 0; i < async_log_tag_count; i++) {
+        if (async_log_tags[i] == tag) return;
+    }
+    if (async_log_tag_count < ASYNC_LOG_MAX_TAGS) {
+        async_log_tags[async_log_tag_count++] = tag;
+    }
+}
+
+// Premier enregistrement non lu de l'anneau, bourrage saut ; NULL si vide.
+static const struct async_log_record* async_log_ring_peek(struct async_log_ring* ring) {
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    while (ring->head != tail) {
+        const struct async_log_record* record =
+            (const struct async_log_record*)&ring->data[ring->head & (ASYNC_LOG_RING_SIZE - 1)];
+        if ((record->flags & ASYNC_LOG_PADDING) == 0) {
+            return record;
+        }
+        __atomic_store_n(&ring->head, ring->head + record->size, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+/**
+ * Vide les anneaux en fusionnant leurs enregistrements par date, pour que
+ * l'ordre entre threads soit conserv. Les bilans de limite de dbit sont
+ * crits au plus une fois par seconde, ou  chaque passage si force est non nul.
+ */
+static void async_log_drain(int force) {
+    static int64_t reportNs;
+    char line[ASYNC_LOG_MAX_LINE];
+
+    pthread_mutex_lock(&async_log_mutex);
+    for (;;) {
+        struct async_log_ring* oldest = NULL;
+        const struct async_log_record* record = NULL;
+        for (struct async_log_ring* ring = async_log_rings; ring != NULL; ring = ring->next) {
+            const struct async_log_record* candidate = async_log_ring_peek(ring);
+            if (candidate != NULL && (record == NULL || candidate->timestamp < record->timestamp)) {
+                oldest = ring;
+                record = candidate;
+            }
+        }
+        if (record == NULL) {
+            break;
+        }
+        const struct async_log_site* site = record->site;
+        async_log_note_tag(site->tag);
+        async_log_format(record, line);
+        async_log_emit(site->level, site->tag->name, oldest->tid, record->timestamp, line);
+        // L'emplacement est rendu au producteur au fil de la lecture.
+        __atomic_store_n(&oldest->head, oldest->head + record->size, __ATOMIC_RELEASE);
+    }
+
+    // Les anneaux des threads termins sont librs une fois vides.
+    struct async_log_ring** link = &async_log_rings;
+    while (*link != NULL) {
+        struct async_log_ring* ring = *link;
+        if (__atomic_load_n(&ring->retired, __ATOMIC_ACQUIRE) && async_log_ring_peek(ring) == NULL) {
+            *link = ring->next;
+            free(ring);
+        } else {
+            link = &ring->next;
+        }
+    }
+
+    int64_t now = async_log_now_ns();
+    if (force || now - reportNs >= 1000000000LL) {
+        reportNs = now;
+        for (int i = 0; i < async_log_tag_count; i++) {
+            struct async_log_tag* tag = async_log_tags[i];
+            uint32_t suppressed = __atomic_exchange_n(&tag->suppressed, 0, __ATOMIC_RELAXED);
+            if (suppressed > 0) {
+                snprintf(line, sizeof(line), "%u messages suppressed (limit %u/s)",
+                        suppressed, tag->ratePerSecond);
+                async_log_emit(ANDROID_LOG_WARN, tag->name, 0, now, line);
+            }
+        }
+    }
+    if (async_log_file != NULL) {
+        fflush(async_log_file);
+    }
+    pthread_mutex_unlock(&async_log_mutex);
+}
+
+static void* async_log_main(void* param) {
+    pthread_mutex_lock(&async_log_wake_mutex);
+    while (!async_log_stopping) {
+        if (!async_log_wake_requested) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_nsec += ASYNC_LOG_FLUSH_INTERVAL_MS * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&async_log_wake_cond, &async_log_wake_mutex, &deadline);
+        }
+        async_log_wake_requested = 0;
+        pthread_mutex_unlock(&async_log_wake_mutex);
+        async_log_drain(0);
+        pthread_mutex_lock(&async_log_wake_mutex);
+    }
+    pthread_mutex_unlock(&async_log_wake_mutex);
+    return NULL;
+}
+
+static void async_log_shutdown(void) {
+    pthread_mutex_lock(&async_log_wake_mutex);
+    async_log_stopping = 1;
+    pthread_cond_signal(&async_log_wake_cond);
+    pthread_mutex_unlock(&async_log_wake_mutex);
+    pthread_join(async_log_thread, NULL);
+    async_log_running = 0;
+    async_log_drain(1);
+}
+
+int async_log_open_file(const char* path) {
+    FILE* file = fopen(path, "a");
+    if (file == NULL) {
+        return -1;
+    }
+    pthread_mutex_lock(&async_log_mutex);
+    if (async_log_file != NULL) {
+        fclose(async_log_file);
+    }
+    async_log_file = file;
+    pthread_mutex_unlock(&async_log_mutex);
+    return 0;
+}
+
+void async_log_flush(void) {
+    async_log_drain(1);
+}
+
+void async_log_get_stats(struct async_log_stats* outStats) {
+    outStats->written = __atomic_load_n(&async_log_stats_global.written, __ATOMIC_RELAXED);
+    outStats->dropped = __atomic_load_n(&async_log_stats_global.dropped, __ATOMIC_RELAXED);
+    outStats->suppressed = __atomic_load_n(&async_log_stats_global.suppressed, __ATOMIC_RELAXED);
+    outStats->flushed = __atomic_load_n(&async_log_stats_global.flushed, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,118 @@
+// Lastorm tech.
+
+#ifndef _ASYNC_LOG_H
+#define _ASYNC_LOG_H
+
+#include <stdint.h>
+
+#include <android/log.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Journal binaire asynchrone.
+ *
+ * Un appel ASYNC_LOG() ne met pas le message en forme : il copie l'adresse de
+ * son site d'appel (niveau, tiquette, format), la date et ses arguments bruts
+ * dans un anneau propre au thread appelant, sans verrou ni appel systme. Un
+ * thread d'arrire-plan vide priodiquement les anneaux, met les messages en
+ * forme et les crit dans logcat, ou dans un fichier aprs async_log_open_file().
+ *
+ * Les niveaux infrieurs  ASYNC_LOG_MIN_LEVEL disparaissent  la compilation.
+ * Chaque tiquette limite le nombre de messages par seconde ; l'excdent est
+ * compt et signal une fois par seconde. Un anneau plein perd le message au
+ * lieu de bloquer l'appelant.
+ *
+ * Les chanes (%s) sont copies, tronques  ASYNC_LOG_MAX_STRING octets ;
+ * %n n'est pas pris en charge.
+ */
+
+#ifndef ASYNC_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define ASYNC_LOG_MIN_LEVEL ANDROID_LOG_INFO
+#else
+#define ASYNC_LOG_MIN_LEVEL ANDROID_LOG_VERBOSE
+#endif
+#endif
+
+// Taille de l'anneau de chaque thread, en octets (puissance de deux).
+#define ASYNC_LOG_RING_SIZE (16 * 1024)
+
+#define ASYNC_LOG_MAX_ARGS 24
+#define ASYNC_LOG_MAX_STRING 128
+
+// Intervalle entre deux passages du thread d'arrire-plan, en millisecondes.
+#define ASYNC_LOG_FLUSH_INTERVAL_MS 20
+
+/**
+ * tiquette et limite de dbit associe. Dclare une fois par module avec
+ * ASYNC_LOG_TAG().
+ */
+struct async_log_tag {
+    const char* name;
+
+    // Messages accepts par seconde ; 0 pour aucune limite.
+    uint32_t ratePerSecond;
+
+    // Fentre courante (secondes CLOCK_MONOTONIC), messages accepts et carts.
+    int64_t window;
+    uint32_t count;
+    uint32_t suppressed;
+};
+
+#define ASYNC_LOG_TAG(var, name, ratePerSecond) \
+    static struct async_log_tag var = { name, ratePerSecond, 0, 0, 0 }
+
+/**
+ * Site d'appel. Les types des arguments sont dduits du format au premier appel.
+ */
+struct async_log_site {
+    struct async_log_tag* tag;
+    int level;
+    const char* format;
+
+    // 0 : format non analys, 1 : analyse en cours, 2 : argTypes valide.
+    int parsed;
+    int argCount;
+    uint8_t argTypes[ASYNC_LOG_MAX_ARGS];
+};
+
+#define ASYNC_LOG(level, tag, format, ...) do { \
+        if ((level) >= ASYNC_LOG_MIN_LEVEL) { \
+            static struct async_log_site async_log_site_ = { (tag), (level), (format), 0, 0, { 0 } }; \
+            async_log_write(&async_log_site_, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+/**
+ * Bilan global du journal.
+ */
+struct async_log_stats {
+    uint64_t written;
+    uint64_t dropped;
+    uint64_t suppressed;
+    uint64_t flushed;
+};
+
+void async_log_write(struct async_log_site* site, ...);
+
+/**
+ * Redirige les messages vers un fichier au lieu de logcat. Retourne 0 en cas
+ * de succs, -1 sinon.
+ */
+int async_log_open_file(const char* path);
+
+/**
+ * crit tous les messages dj enregistrs avant de retourner.
+ */
+void async_log_flush(void);
+
+void async_log_get_stats(struct async_log_stats* outStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ASYNC_LOG_H */
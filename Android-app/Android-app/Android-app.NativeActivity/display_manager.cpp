@@ -0,0 +1,330 @@
+// Lastorm tech.
+
+ASYNC_LOG_TAG(display_manager_log_tag, "display_manager", 4);
+
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, &display_manager_log_tag, __VA_ARGS__)
+#define LOGW(...) ASYNC_LOG(ANDROID_LOG_WARN, &display_manager_log_tag, __VA_ARGS__)
+
+// Valeur d'un attribut d'une liste termine par EGL_NONE.
+static EGLint display_manager_find_attrib(const EGLint* attribs, EGLint name, EGLint fallback) {
+    for (; attribs != NULL && attribs[0] != EGL_NONE; attribs += 2) {
+        if (attribs[0] == name) {
+            return attribs[1];
+        }
+    }
+    return fallback;
+}
+
+static EGLint display_manager_config_attrib(EGLDisplay display, EGLConfig config, EGLint name) {
+    EGLint value = 0;
+    eglGetConfigAttrib(display, config, name, &value);
+    return value;
+}
+
+int display_manager_has_extension(const char* extensions, const char* name) {
+    size_t length = strlen(name);
+    for (const char* found = extensions; (found = strstr(found, name)) != NULL; found += length) {
+        if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0')) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int32_t display_manager_score_config(EGLDisplay display, EGLConfig config,
+        const EGLint* configAttribs) {
+    EGLint surfaceType = display_manager_find_attrib(configAttribs, EGL_SURFACE_TYPE, EGL_WINDOW_BIT);
+    EGLint renderableType = display_manager_find_attrib(configAttribs, EGL_RENDERABLE_TYPE, 0);
+    if ((display_manager_config_attrib(display, config, EGL_SURFACE_TYPE) & surfaceType) != surfaceType
+            || (display_manager_config_attrib(display, config, EGL_RENDERABLE_TYPE) & renderableType)
+                != renderableType) {
+        return -1;
+    }
+    EGLint caveat = display_manager_config_attrib(display, config, EGL_CONFIG_CAVEAT);
+    if (caveat == EGL_NON_CONFORMANT_CONFIG) {
+        return -1;
+    }
+
+    // Chaque bit non demand est lu ou crit  chaque pixel de chaque image :
+    // le multichantillonnage cote le plus, puis la profondeur et le stencil.
+    static const struct {
+        EGLint name;
+        int32_t weight;
+    } costs[] = {
+        { EGL_RED_SIZE, 4 },
+        { EGL_GREEN_SIZE, 4 },
+        { EGL_BLUE_SIZE, 4 },
+        { EGL_ALPHA_SIZE, 2 },
+        { EGL_DEPTH_SIZE, 4 },
+        { EGL_STENCIL_SIZE, 4 },
+        { EGL_SAMPLES, 50 },
+    };
+    int32_t score = 1000;
+    if (caveat == EGL_SLOW_CONFIG) {
+        score -= 500;
+    }
+    for (size_t i = 0; i < sizeof(costs) / sizeof(costs[0]); i++) {
+        EGLint wanted = display_manager_find_attrib(configAttribs, costs[i].name, 0);
+        EGLint value = display_manager_config_attrib(display, config, costs[i].name);
+        if (value < wanted) {
+            return -1;
+        }
+        score -= (value - wanted) * costs[i].weight;
+    }
+    //  note gale, une configuration qui permet une surface hors cran garde
+    // le contexte courant sans EGL_KHR_surfaceless_context.
+    if (display_manager_config_attrib(display, config, EGL_SURFACE_TYPE) & EGL_PBUFFER_BIT) {
+        score += 1;
+    }
+    return score > 0 ? score : 0;
+}
+
+void display_manager_init(struct display_manager* manager, const EGLint* configAttribs,
+        const EGLint* contextAttribs) {
+    memset(manager, 0, sizeof(*manager));
+    manager->configAttribs = configAttribs;
+    manager->contextAttribs = contextAttribs;
+    manager->display = EGL_NO_DISPLAY;
+    manager->context = EGL_NO_CONTEXT;
+    manager->surface = EGL_NO_SURFACE;
+    manager->parking = EGL_NO_SURFACE;
+}
+
+static int display_manager_create_context(struct display_manager* manager) {
+    manager->context = eglCreateContext(manager->display, manager->config, EGL_NO_CONTEXT,
+            manager->contextAttribs);
+    EGLint version = display_manager_find_attrib(manager->contextAttribs, EGL_CONTEXT_CLIENT_VERSION, 1);
+    if (manager->context == EGL_NO_CONTEXT && version > 2) {
+        // Mme liste, version 2.
+        EGLint attribs[DISPLAY_MANAGER_MAX_ATTRIBS];
+        size_t count = 0;
+        for (const EGLint* attrib = manager->contextAttribs; attrib[0] != EGL_NONE
+                && count + 3 <= DISPLAY_MANAGER_MAX_ATTRIBS; attrib += 2) {
+            attribs[count++] = attrib[0];
+            attribs[count++] = attrib[0] == EGL_CONTEXT_CLIENT_VERSION ? 2 : attrib[1];
+        }
+        attribs[count] = EGL_NONE;
+        LOGW("OpenGL ES %d unavailable (0x%x), falling back to OpenGL ES 2", version, eglGetError());
+        manager->context = eglCreateContext(manager->display, manager->config, EGL_NO_CONTEXT, attribs);
+    }
+    if (manager->context == EGL_NO_CONTEXT) {
+        LOGW("Unable to eglCreateContext: 0x%x", eglGetError());
+        return -1;
+    }
+    manager->stats.contexts++;
+    manager->newContext = 1;
+    if (!manager->surfaceless && manager->parking == EGL_NO_SURFACE) {
+        const EGLint attribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        manager->parking = eglCreatePbufferSurface(manager->display, manager->config, attribs);
+    }
+    return 0;
+}
+
+int display_manager_open(struct display_manager* manager) {
+    if (manager->display != EGL_NO_DISPLAY) {
+        return manager->context != EGL_NO_CONTEXT ? 0 : display_manager_create_context(manager);
+    }
+
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || eglInitialize(display, NULL, NULL) == EGL_FALSE) {
+        LOGW("Unable to eglInitialize: 0x%x", eglGetError());
+        return -1;
+    }
+    EGLConfig configs[DISPLAY_MANAGER_MAX_CONFIGS];
+    EGLint count = 0;
+    if (eglChooseConfig(display, manager->configAttribs, configs, DISPLAY_MANAGER_MAX_CONFIGS,
+            &count) == EGL_FALSE || count < 1) {
+        LOGW("No EGL config matches: 0x%x", eglGetError());
+        eglTerminate(display);
+        return -1;
+    }
+    int best = -1;
+    int32_t bestScore = -1;
+    for (EGLint i = 0; i < count; i++) {
+        int32_t score = display_manager_score_config(display, configs[i], manager->configAttribs);
+        if (score > bestScore) {
+            best = i;
+            bestScore = score;
+        }
+    }
+    if (best < 0) {
+        LOGW("No usable EGL config among %d", count);
+        eglTerminate(display);
+        return -1;
+    }
+
+    manager->display = display;
+    manager->config = configs[best];
+    manager->format = display_manager_config_attrib(display, manager->config, EGL_NATIVE_VISUAL_ID);
+    const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+    manager->surfaceless = extensions != NULL
+            && display_manager_has_extension(extensions, "EGL_KHR_surfaceless_context");
+    manager->stats.displayInits++;
+    LOGI("EGL config %d of %d (id %d, score %d), surfaceless=%d", best + 1, count,
+            display_manager_config_attrib(display, manager->config, EGL_CONFIG_ID), bestScore,
+            manager->surfaceless);
+
+    if (display_manager_create_context(manager) != 0) {
+        display_manager_term(manager);
+        return -1;
+    }
+    return 0;
+}
+
+// Le contexte courant sans fentre : sans surface, sur la surface hors cran, ou
+//  dfaut plus courant du tout (il garde ses objets).
+static void display_manager_park(struct display_manager* manager) {
+    EGLSurface parking = manager->surfaceless ? EGL_NO_SURFACE : manager->parking;
+    if ((manager->surfaceless || parking != EGL_NO_SURFACE)
+            && eglMakeCurrent(manager->display, parking, parking, manager->context) == EGL_TRUE) {
+        return;
+    }
+    eglMakeCurrent(manager->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+// Fin d'un attachement : surface courante, taille et mesures.
+static int display_manager_bind(struct display_manager* manager, EGLSurface surface, int64_t start) {
+    manager->surface = surface;
+    manager->stats.surfaces++;
+    if (eglMakeCurrent(manager->display, surface, surface, manager->context) == EGL_FALSE) {
+        LOGW("Unable to eglMakeCurrent: 0x%x", eglGetError());
+        eglMakeCurrent(manager->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroySurface(manager->display, surface);
+        manager->surface = EGL_NO_SURFACE;
+        manager->window = NULL;
+        return -1;
+    }
+    EGLint width = 0;
+    EGLint height = 0;
+    eglQuerySurface(manager->display, surface, EGL_WIDTH, &width);
+    eglQuerySurface(manager->display, surface, EGL_HEIGHT, &height);
+    manager->width = width;
+    manager->height = height;
+
+    struct display_manager_stats* stats = &manager->stats;
+    stats->lastAttachNs = frame_timing_now() - start;
+    if (stats->attaches++ == 0) {
+        stats->initNs = stats->lastAttachNs;
+    }
+    int result = manager->newContext ? DISPLAY_MANAGER_NEW_CONTEXT : 0;
+    if (!manager->newContext) {
+        stats->resumes++;
+    }
+    manager->newContext = 0;
+    return result;
+}
+
+int display_manager_attach(struct display_manager* manager, ANativeWindow* window) {
+    int64_t start = frame_timing_now();
+    display_manager_detach(manager);
+    if (display_manager_open(manager) != 0) {
+        return -1;
+    }
+
+    /* EGL_NATIVE_VISUAL_ID est un attribut d'EGLConfig dont l'acceptation par
+    * ANativeWindow_setBuffersGeometry() est garantie. */
+    ANativeWindow_setBuffersGeometry(window, 0, 0, manager->format);
+    EGLSurface surface = eglCreateWindowSurface(manager->display, manager->config, window, NULL);
+    if (surface == EGL_NO_SURFACE) {
+        LOGW("Unable to eglCreateWindowSurface: 0x%x", eglGetError());
+        return -1;
+    }
+    manager->window = window;
+    return display_manager_bind(manager, surface, start);
+}
+
+int display_manager_attach_surface(struct display_manager* manager, EGLSurface surface) {
+    int64_t start = frame_timing_now();
+    display_manager_detach(manager);
+    if (display_manager_open(manager) != 0) {
+        eglDestroySurface(manager->display, surface);
+        return -1;
+    }
+    return display_manager_bind(manager, surface, start);
+}
+
+void display_manager_detach(struct display_manager* manager) {
+    if (manager->surface == EGL_NO_SURFACE) {
+        return;
+    }
+    display_manager_park(manager);
+    eglDestroySurface(manager->display, manager->surface);
+    manager->surface = EGL_NO_SURFACE;
+    manager->window = NULL;
+}
+
+int display_manager_resize(struct display_manager* manager) {
+    if (manager->surface == EGL_NO_SURFACE) {
+        return 0;
+    }
+    EGLint width = manager->width;
+    EGLint height = manager->height;
+    eglQuerySurface(manager->display, manager->surface, EGL_WIDTH, &width);
+    eglQuerySurface(manager->display, manager->surface, EGL_HEIGHT, &height);
+    if (width == manager->width && height == manager->height) {
+        return 0;
+    }
+    manager->width = width;
+    manager->height = height;
+    manager->stats.resizes++;
+    return 1;
+}
+
+int display_manager_swap(struct display_manager* manager) {
+    if (eglSwapBuffers(manager->display, manager->surface) == EGL_TRUE) {
+        return 0;
+    }
+    EGLint error = eglGetError();
+    ANativeWindow* window = manager->window;
+    switch (error) {
+        case EGL_CONTEXT_LOST:
+            // Tous les objets GL sont perdus : le contexte est recr, l'affichage reste.
+            LOGW("EGL context lost, recreating it");
+            manager->stats.contextLosses++;
+            display_manager_detach(manager);
+            eglMakeCurrent(manager->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroyContext(manager->display, manager->context);
+            manager->context = EGL_NO_CONTEXT;
+            break;
+        case EGL_BAD_SURFACE:
+        case EGL_BAD_NATIVE_WINDOW:
+            // Surface invalide (fentre remplace sans TERM_WINDOW) : seule la surface est refaite.
+            LOGW("EGL surface lost (0x%x), recreating it", error);
+            display_manager_detach(manager);
+            break;
+        default:
+            LOGW("Unable to eglSwapBuffers: 0x%x", error);
+            return -1;
+    }
+    return window != NULL ? display_manager_attach(manager, window) : -1;
+}
+
+void display_manager_term(struct display_manager* manager) {
+    if (manager->display == EGL_NO_DISPLAY) {
+        return;
+    }
+    eglMakeCurrent(manager->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (manager->surface != EGL_NO_SURFACE) {
+        eglDestroySurface(manager->display, manager->surface);
+    }
+    if (manager->parking != EGL_NO_SURFACE) {
+        eglDestroySurface(manager->display, manager->parking);
+    }
+    if (manager->context != EGL_NO_CONTEXT) {
+        eglDestroyContext(manager->display, manager->context);
+    }
+    eglTerminate(manager->display);
+
+    const struct display_manager_stats* stats = &manager->stats;
+    LOGI("display: inits=%llu contexts=%llu surfaces=%llu attaches=%llu resumes=%llu "
+            "resizes=%llu losses=%llu init=%.2f ms last=%.2f ms",
+            (unsigned long long)stats->displayInits, (unsigned long long)stats->contexts,
+            (unsigned long long)stats->surfaces, (unsigned long long)stats->attaches,
+            (unsigned long long)stats->resumes, (unsigned long long)stats->resizes,
+            (unsigned long long)stats->contextLosses, stats->initNs / 1e6, stats->lastAttachNs / 1e6);
+
+    // Les attributs et les compteurs restent : l'affichage peut tre rouvert.
+    struct display_manager_stats saved = manager->stats;
+    display_manager_init(manager, manager->configAttribs, manager->contextAttribs);
+    manager->stats = saved;
+}
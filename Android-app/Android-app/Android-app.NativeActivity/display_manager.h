@@ -0,0 +1,170 @@
+// Lastorm tech.
+
+#ifndef _DISPLAY_MANAGER_H
+#define _DISPLAY_MANAGER_H
+
+#include <stdint.h>
+
+#include <EGL/egl.h>
+#include <android/native_window.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Affichage EGL conserv d'une fentre  l'autre.
+ *
+ * L'affichage, la configuration et le contexte sont crs  la premire
+ * fentre puis gards jusqu' display_manager_term() : quand la fentre
+ * disparat (APP_CMD_TERM_WINDOW), seule la surface est dtruite et le
+ * contexte reste courant sans surface (EGL_KHR_surfaceless_context) ou sur un
+ * tampon hors cran de 1x1. La fentre suivante ne cote qu'une surface, et
+ * les objets GL (textures, tampons, programmes) sont conservs. Un
+ * redimensionnement ne relit que la taille de la surface.
+ *
+ * La configuration n'est pas la premire rendue par eglChooseConfig() : toutes
+ * les configurations qui satisfont les attributs demands sont notes par
+ * display_manager_score_config(), qui carte les configurations lentes et
+ * pnalise la profondeur, le stencil, le multichantillonnage et l'alpha non
+ * demands (chacun cote de la bande passante  chaque image).
+ *
+ * Un contexte perdu (EGL_CONTEXT_LOST, aprs une mise en veille de l'appareil
+ * par exemple) est recr par display_manager_swap() ; l'appelant doit alors
+ * recrer son tat GL.
+ *
+ * Toutes les fonctions sont appeles par le thread propritaire du contexte.
+ */
+
+// Retour de display_manager_attach() et display_manager_swap() : le contexte
+// est nouveau, l'tat GL doit tre initialis.
+#define DISPLAY_MANAGER_NEW_CONTEXT 1
+
+// Configurations examines au plus.
+#define DISPLAY_MANAGER_MAX_CONFIGS 64
+
+// Longueur maximale de la liste d'attributs du contexte, EGL_NONE compris.
+#define DISPLAY_MANAGER_MAX_ATTRIBS 32
+
+struct display_manager_stats {
+    // Initialisations de l'affichage, contextes et surfaces crs.
+    uint64_t displayInits;
+    uint64_t contexts;
+    uint64_t surfaces;
+
+    // Attachements d'une fentre, dont ceux qui ont gard le contexte
+    // (reprises), redimensionnements et pertes de contexte.
+    uint64_t attaches;
+    uint64_t resumes;
+    uint64_t resizes;
+    uint64_t contextLosses;
+
+    // Dure du premier attachement (initialisation complte) et du dernier.
+    int64_t initNs;
+    int64_t lastAttachNs;
+};
+
+struct display_manager {
+    // Attributs donns  display_manager_init(),  conserver par l'appelant.
+    const EGLint* configAttribs;
+    const EGLint* contextAttribs;
+
+    EGLDisplay display;
+    EGLConfig config;
+    EGLContext context;
+    EGLSurface surface;
+
+    // Surface de 1x1 qui garde le contexte courant sans fentre, si
+    // EGL_KHR_surfaceless_context n'est pas disponible.
+    EGLSurface parking;
+    int surfaceless;
+
+    // Contexte cr depuis le dernier attachement : l'appelant doit initialiser son tat GL.
+    int newContext;
+
+    // Fentre de la surface, format natif de la configuration et taille courante.
+    ANativeWindow* window;
+    EGLint format;
+    int32_t width;
+    int32_t height;
+
+    struct display_manager_stats stats;
+};
+
+/**
+ * Prpare le gestionnaire sans appel EGL. configAttribs est la liste
+ * minimale passe  eglChooseConfig() ; contextAttribs (NULL possible) est
+ * passe  eglCreateContext(). Si elle demande OpenGL ES 3 ou plus
+ * (EGL_CONTEXT_CLIENT_VERSION) et que l'appareil ne l'a pas, un contexte
+ * OpenGL ES 2 est cr : l'appelant lit la version obtenue par glGetString().
+ */
+void display_manager_init(struct display_manager* manager, const EGLint* configAttribs,
+        const EGLint* contextAttribs);
+
+/**
+ * Rend la fentre courante, en initialisant l'affichage et le contexte s'ils
+ * n'existent pas encore. Retourne DISPLAY_MANAGER_NEW_CONTEXT pour un nouveau
+ * contexte, 0 pour une reprise, ou -1 en cas d'chec (rien n'est alors courant).
+ */
+int display_manager_attach(struct display_manager* manager, ANativeWindow* window);
+
+/**
+ * Variante pour une surface dj cre sur l'affichage du gestionnaire (tampon
+ * hors cran des vrifications htes), ouvert au pralable par
+ * display_manager_open() ; la surface appartient ensuite au gestionnaire.
+ */
+int display_manager_attach_surface(struct display_manager* manager, EGLSurface surface);
+
+/**
+ * Initialisation de l'affichage, de la configuration et du contexte, sans
+ * fentre. Appele par le premier attachement ; retourne 0, ou -1 si EGL n'est
+ * pas utilisable.
+ */
+int display_manager_open(struct display_manager* manager);
+
+/**
+ * Dtruit la surface de la fentre ; le contexte reste courant et conserve ses objets.
+ */
+void display_manager_detach(struct display_manager* manager);
+
+/**
+ * Relit la taille de la surface. Retourne 1 si elle a chang.
+ */
+int display_manager_resize(struct display_manager* manager);
+
+/**
+ * Prsentation de l'image. Retourne 0, DISPLAY_MANAGER_NEW_CONTEXT si le
+ * contexte a t perdu puis recr, ou -1 si l'affichage n'est plus utilisable.
+ */
+int display_manager_swap(struct display_manager* manager);
+
+/**
+ * Libre la surface, le contexte et l'affichage.
+ */
+void display_manager_term(struct display_manager* manager);
+
+/**
+ * Valeur diffrente de zro si une surface de fentre est courante.
+ */
+static inline int display_manager_ready(const struct display_manager* manager) {
+    return manager->surface != EGL_NO_SURFACE;
+}
+
+/**
+ * Note d'une configuration par rapport aux attributs demands : ngative si
+ * elle est inutilisable, plus leve si elle est meilleure.
+ */
+int32_t display_manager_score_config(EGLDisplay display, EGLConfig config,
+        const EGLint* configAttribs);
+
+/**
+ * Valeur diffrente de zro si name est un mot de la liste d'extensions
+ * extensions (spares par des espaces), EGL ou GL.
+ */
+int display_manager_has_extension(const char* extensions, const char* name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DISPLAY_MANAGER_H */
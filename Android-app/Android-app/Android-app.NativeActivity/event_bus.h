@@ -0,0 +1,137 @@
+// Lastorm tech.
+
+#ifndef _EVENT_BUS_H
+#define _EVENT_BUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#include <utility>
+
+/**
+ * Bus d'vnements typ, dont les abonns sont fixs  la compilation.
+ *
+ * Un vnement porte une cl, de 0  EVENT_BUS_KEYS - 1 : commande APP_CMD_*,
+ * identifiant d'une source du looper... Un abonn est une fonction libre
+ * void f(Context*, const Event*) accompagne du masque des cls qu'elle reoit,
+ * dclare avec EVENT_BUS_HANDLER(). Le bus est un type :
+ *
+ *      typedef event_bus<struct engine, struct event_bus_cmd,
+ *          EVENT_BUS_HANDLER(EVENT_BUS_KEY(APP_CMD_PAUSE), engine_timing_on_cmd),
+ *          EVENT_BUS_HANDLER(EVENT_BUS_ALL, engine_log_on_cmd)> engine_cmd_bus;
+ *
+ *      engine_cmd_bus::dispatch(engine, &event);
+ *
+ * Pour chaque cl, le compilateur produit une fonction qui appelle directement,
+ * dans l'ordre de dclaration, les seuls abonns de cette cl ; une table
+ * constante de ces fonctions, indexe par la cl, est construite  la
+ * compilation. Une distribution cote une lecture de la table et un appel
+ * indirect, quel que soit le nombre d'abonns : ni fonction virtuelle, ni
+ * allocation, ni test des abonns d'autres cls. Les abonns peuvent tre
+ * dvelopps en ligne dans la fonction de leur cl.
+ *
+ * Une cl sans abonn, ou hors de la plage, n'est distribue  personne.
+ */
+
+// Cls d'un bus, et masques d'abonnement.
+#define EVENT_BUS_KEYS 32
+#define EVENT_BUS_KEY(key) (1u << (key))
+#define EVENT_BUS_ALL 0xffffffffu
+
+// Commande du cycle de vie ; cl : APP_CMD_*.
+struct event_bus_cmd {
+    int32_t key;
+};
+
+// Lot d'entres appliqu par le moteur, une fois par image au plus ; cl :
+// EVENT_BUS_INPUT_BATCH.
+#define EVENT_BUS_INPUT_BATCH 0
+
+struct input_batch;
+
+struct event_bus_input {
+    int32_t key;
+    const struct input_batch* batch;
+};
+
+// Source du looper prte ; cl : identifiant rendu par ALooper_pollAll()
+// (LOOPER_ID_MAIN, LOOPER_ID_INPUT, LOOPER_ID_USER et suivants), avec les
+// ALOOPER_EVENT_* reus et l'instant de la fin de l'attente.
+struct event_bus_looper {
+    int32_t key;
+    int events;
+    int64_t pollEndNs;
+};
+
+/**
+ * Abonn : Function appele pour les cls de Mask.
+ */
+template <uint32_t Mask, typename Function, Function Target>
+struct event_bus_handler {
+    static constexpr uint32_t mask = Mask;
+
+    template <uint32_t Key, typename Context, typename Event>
+    static inline void call(Context* context, const Event* event) {
+        if ((Mask >> Key) & 1u) {
+            Target(context, event);
+        }
+    }
+};
+
+#define EVENT_BUS_HANDLER(mask, function) event_bus_handler<(mask), decltype(&function), &function>
+
+template <typename Context, typename Event, typename... Handlers>
+struct event_bus {
+    typedef void (*key_function)(Context* context, const Event* event);
+
+    /**
+     * Abonns de key,  la compilation.
+     */
+    static constexpr int subscribers(uint32_t key) {
+        const uint32_t masks[] = { 0u, Handlers::mask... };
+        int count = 0;
+        for (uint32_t mask : masks) {
+            count += key < EVENT_BUS_KEYS && ((mask >> key) & 1u);
+        }
+        return count;
+    }
+
+    /**
+     * Distribution de event  ses abonns, dans l'ordre de dclaration.
+     */
+    static inline void dispatch(Context* context, const Event* event) {
+        uint32_t key = (uint32_t)event->key;
+        if (key < EVENT_BUS_KEYS) {
+            key_function function = table(std::make_index_sequence<EVENT_BUS_KEYS>())[key];
+            if (function != nullptr) {
+                function(context, event);
+            }
+        }
+    }
+
+    /**
+     * Distribution d'une cl connue  la compilation : les abonns sont appels
+     * directement, sans table.
+     */
+    template <uint32_t Key>
+    static inline void dispatch_key(Context* context, const Event* event) {
+        static_assert(Key < EVENT_BUS_KEYS, "event bus key out of range");
+        // Un appel par abonn, dans l'ordre de la liste (C++14 n'a pas d'expression de repli).
+        const int expand[] = { 0, (Handlers::template call<Key>(context, event), 0)... };
+        (void)expand;
+    }
+
+private:
+    template <size_t... Keys>
+    static const key_function* table(std::index_sequence<Keys...>) {
+        // Initialise  la compilation : ni garde, ni construction au premier appel.
+        static constexpr key_function functions[] = {
+            (subscribers(Keys) > 0 ? &dispatch_key<Keys> : nullptr)...
+        };
+        return functions;
+    }
+};
+#endif
+
+#endif /* _EVENT_BUS_H */
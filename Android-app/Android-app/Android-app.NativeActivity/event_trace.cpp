@@ -0,0 +1,719 @@
+// Lastorm tech.
+
+ASYNC_LOG_TAG(event_trace_log_tag, "event_trace", 10);
+
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, &event_trace_log_tag, __VA_ARGS__)
+#define LOGE(...) ASYNC_LOG(ANDROID_LOG_ERROR, &event_trace_log_tag, __VA_ARGS__)
+
+// Longueur maximale d'un entier cod.
+#define EVENT_TRACE_VARINT_BYTES 10
+
+struct event_trace_file_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    int64_t startNs;
+    int64_t createdAt;
+};
+
+struct event_trace_block_header {
+    uint32_t rawBytes;
+    uint32_t compressedBytes;
+};
+
+/**
+ * Dernires valeurs de chaque canal, de part et d'autre : le codage en OU exclusif
+ * et en carts suppose que l'crivain et le lecteur voient la mme suite.
+ */
+struct event_trace_channels {
+    float motion[3][EVENT_TRACE_MAX_POINTERS];
+    float sensor[3];
+    int64_t sensorTime;
+};
+
+struct event_trace {
+    int fd;
+    int64_t startNs;
+    int64_t lastNs;
+    struct event_trace_channels channels;
+
+    // Bloc en cours de codage, et bloc confi au thread d'criture.
+    uint8_t* buffers[2];
+    size_t capacities[2];
+    int current;
+    size_t used;
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    const uint8_t* pending;
+    size_t pendingBytes;
+    int stop;
+
+    // Tampon de compression du thread d'criture.
+    uint8_t* compressed;
+    size_t compressedCapacity;
+
+    struct event_trace_stats stats;
+};
+
+struct event_trace_reader {
+    int fd;
+    int64_t startNs;
+    int64_t timeNs;
+    struct event_trace_channels channels;
+
+    uint8_t* raw;
+    size_t rawCapacity;
+    size_t rawBytes;
+    size_t position;
+    uint8_t* compressed;
+    size_t compressedCapacity;
+};
+
+/**
+ * Lecture d'un bloc dcod ; error passe  1 au-del de la fin.
+ */
+struct event_trace_cursor {
+    const uint8_t* p;
+    const uint8_t* end;
+    int error;
+};
+
+static int64_t event_trace_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// --------------------------------------------------------------------
+// Codage
+// --------------------------------------------------------------------
+
+static uint8_t* event_trace_put(uint8_t* p, uint64_t value) {
+    while (value >= 0x80) {
+        *p++ = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+    return p;
+}
+
+static uint8_t* event_trace_put_signed(uint8_t* p, int64_t value) {
+    return event_trace_put(p, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+static uint8_t* event_trace_put_float(uint8_t* p, float value, float* previous) {
+    uint32_t bits;
+    uint32_t previousBits;
+    memcpy(&bits, &value, sizeof(bits));
+    memcpy(&previousBits, previous, sizeof(previousBits));
+    *previous = value;
+    return event_trace_put(p, bits ^ previousBits);
+}
+
+static uint64_t event_trace_get(struct event_trace_cursor* cursor) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 7 * EVENT_TRACE_VARINT_BYTES; shift += 7) {
+        if (cursor->p == cursor->end) {
+            break;
+        }
+        uint8_t byte = *cursor->p++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    cursor->error = 1;
+    return 0;
+}
+
+static int64_t event_trace_get_signed(struct event_trace_cursor* cursor) {
+    uint64_t value = event_trace_get(cursor);
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static float event_trace_get_float(struct event_trace_cursor* cursor, float* previous) {
+    uint32_t previousBits;
+    memcpy(&previousBits, previous, sizeof(previousBits));
+    uint32_t bits = (uint32_t)event_trace_get(cursor) ^ previousBits;
+    memcpy(previous, &bits, sizeof(bits));
+    return *previous;
+}
+
+// --------------------------------------------------------------------
+// criture
+// --------------------------------------------------------------------
+
+static int event_trace_write_all(int fd, const void* data, size_t size) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (size > 0) {
+        ssize_t written = write(fd, p, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += written;
+        size -= (size_t)written;
+    }
+    return 0;
+}
+
+// Compression et criture d'un bloc, par le thread d'criture.
+static void event_trace_write_block(struct event_trace* trace, const uint8_t* data, size_t size) {
+    uLongf bound = compressBound((uLong)size);
+    if (bound > trace->compressedCapacity) {
+        uint8_t* compressed = (uint8_t*)realloc(trace->compressed, bound);
+        if (compressed == NULL) {
+            LOGE("Unable to allocate %lu bytes for compression", (unsigned long)bound);
+            pthread_mutex_lock(&trace->mutex);
+            trace->stats.errors++;
+            pthread_mutex_unlock(&trace->mutex);
+            return;
+        }
+        trace->compressed = compressed;
+        trace->compressedCapacity = bound;
+    }
+    uLongf compressedBytes = bound;
+    struct event_trace_block_header header;
+    int result = compress2(trace->compressed, &compressedBytes, data, (uLong)size, Z_BEST_SPEED);
+    int ok = result == Z_OK;
+    if (ok) {
+        header.rawBytes = (uint32_t)size;
+        header.compressedBytes = (uint32_t)compressedBytes;
+        ok = event_trace_write_all(trace->fd, &header, sizeof(header)) == 0
+                && event_trace_write_all(trace->fd, trace->compressed, compressedBytes) == 0;
+        if (!ok) {
+            LOGE("Unable to write trace block: %s", strerror(errno));
+        }
+    } else {
+        LOGE("Unable to compress trace block: zlib error %d", result);
+    }
+    pthread_mutex_lock(&trace->mutex);
+    if (ok) {
+        trace->stats.rawBytes += size;
+        trace->stats.compressedBytes += sizeof(header) + compressedBytes;
+        trace->stats.blocks++;
+    } else {
+        trace->stats.errors++;
+    }
+    pthread_mutex_unlock(&trace->mutex);
+}
+
+static void* event_trace_main(void* param) {
+    struct event_trace* trace = (struct event_trace*)param;
+    pthread_mutex_lock(&trace->mutex);
+    for (;;) {
+        while (trace->pending == NULL && !trace->stop) {
+            pthread_cond_wait(&trace->cond, &trace->mutex);
+        }
+        if (trace->pending == NULL) {
+            break;
+        }
+        const uint8_t* data = trace->pending;
+        size_t size = trace->pendingBytes;
+        pthread_mutex_unlock(&trace->mutex);
+
+        event_trace_write_block(trace, data, size);
+
+        pthread_mutex_lock(&trace->mutex);
+        trace->pending = NULL;
+        pthread_cond_broadcast(&trace->cond);
+    }
+    pthread_mutex_unlock(&trace->mutex);
+    return NULL;
+}
+
+// Confie le bloc en cours au thread d'criture et passe  l'autre tampon.
+static void event_trace_submit(struct event_trace* trace) {
+    if (trace->used == 0) {
+        return;
+    }
+    pthread_mutex_lock(&trace->mutex);
+    if (trace->pending != NULL) {
+        trace->stats.stalls++;
+        do {
+            pthread_cond_wait(&trace->cond, &trace->mutex);
+        } while (trace->pending != NULL);
+    }
+    trace->pending = trace->buffers[trace->current];
+    trace->pendingBytes = trace->used;
+    pthread_cond_broadcast(&trace->cond);
+    pthread_mutex_unlock(&trace->mutex);
+    trace->current ^= 1;
+    trace->used = 0;
+}
+
+/**
+ * Dbut d'un enregistrement d'au plus bound octets : type et cart avec le
+ * prcdent. Retourne NULL si la place manque.
+ */
+static uint8_t* event_trace_begin(struct event_trace* trace, int type, size_t bound) {
+    bound += 1 + EVENT_TRACE_VARINT_BYTES;
+    if (trace->used + bound > trace->capacities[trace->current]) {
+        event_trace_submit(trace);
+        if (bound > trace->capacities[trace->current]) {
+            // Seul un tat enregistr dpasse un bloc : le tampon est agrandi.
+            uint8_t* buffer = (uint8_t*)realloc(trace->buffers[trace->current], bound);
+            if (buffer == NULL) {
+                LOGE("Unable to allocate %zu bytes for a trace record", bound);
+                trace->stats.errors++;
+                return NULL;
+            }
+            trace->buffers[trace->current] = buffer;
+            trace->capacities[trace->current] = bound;
+        }
+    }
+    int64_t now = event_trace_now();
+    uint8_t* p = trace->buffers[trace->current] + trace->used;
+    *p++ = (uint8_t)type;
+    p = event_trace_put(p, (uint64_t)(now - trace->lastNs));
+    trace->lastNs = now;
+    trace->stats.records[type]++;
+    return p;
+}
+
+static void event_trace_end(struct event_trace* trace, const uint8_t* p) {
+    trace->used = (size_t)(p - trace->buffers[trace->current]);
+}
+
+struct event_trace* event_trace_create(const char* path) {
+    struct event_trace* trace = (struct event_trace*)calloc(1, sizeof(struct event_trace));
+    if (trace == NULL) {
+        return NULL;
+    }
+    trace->buffers[0] = (uint8_t*)malloc(EVENT_TRACE_BLOCK_BYTES);
+    trace->buffers[1] = (uint8_t*)malloc(EVENT_TRACE_BLOCK_BYTES);
+    trace->capacities[0] = EVENT_TRACE_BLOCK_BYTES;
+    trace->capacities[1] = EVENT_TRACE_BLOCK_BYTES;
+    trace->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (trace->fd < 0 || trace->buffers[0] == NULL || trace->buffers[1] == NULL) {
+        LOGE("Unable to create %s: %s", path, strerror(errno));
+        goto fail;
+    }
+
+    trace->startNs = event_trace_now();
+    trace->lastNs = trace->startNs;
+    struct event_trace_file_header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = EVENT_TRACE_MAGIC;
+    header.version = EVENT_TRACE_VERSION;
+    header.headerSize = sizeof(header);
+    header.startNs = trace->startNs;
+    header.createdAt = (int64_t)time(NULL);
+    if (event_trace_write_all(trace->fd, &header, sizeof(header)) != 0) {
+        LOGE("Unable to write %s: %s", path, strerror(errno));
+        goto fail;
+    }
+
+    pthread_mutex_init(&trace->mutex, NULL);
+    pthread_cond_init(&trace->cond, NULL);
+    if (pthread_create(&trace->thread, NULL, event_trace_main, trace) != 0) {
+        LOGE("Unable to start the trace writer");
+        pthread_cond_destroy(&trace->cond);
+        pthread_mutex_destroy(&trace->mutex);
+        goto fail;
+    }
+    LOGI("recording events to %s", path);
+    return trace;
+
+fail:
+    if (trace->fd >= 0) {
+        close(trace->fd);
+        unlink(path);
+    }
+    free(trace->buffers[0]);
+    free(trace->buffers[1]);
+    free(trace);
+    return NULL;
+}
+
+void event_trace_flush(struct event_trace* trace) {
+    event_trace_submit(trace);
+}
+
+void event_trace_close(struct event_trace* trace, struct event_trace_stats* outStats) {
+    if (trace == NULL) {
+        return;
+    }
+    event_trace_submit(trace);
+    pthread_mutex_lock(&trace->mutex);
+    trace->stop = 1;
+    pthread_cond_broadcast(&trace->cond);
+    pthread_mutex_unlock(&trace->mutex);
+    pthread_join(trace->thread, NULL);
+    pthread_cond_destroy(&trace->cond);
+    pthread_mutex_destroy(&trace->mutex);
+    close(trace->fd);
+
+    const struct event_trace_stats* stats = &trace->stats;
+    LOGI("trace closed: cmd=%llu motion=%llu key=%llu sensor=%llu raw=%llu written=%llu bytes "
+            "blocks=%llu stalls=%llu dropped_samples=%llu errors=%llu",
+            (unsigned long long)stats->records[EVENT_TRACE_CMD],
+            (unsigned long long)stats->records[EVENT_TRACE_MOTION],
+            (unsigned long long)stats->records[EVENT_TRACE_KEY],
+            (unsigned long long)stats->records[EVENT_TRACE_SENSOR],
+            (unsigned long long)stats->rawBytes, (unsigned long long)stats->compressedBytes,
+            (unsigned long long)stats->blocks, (unsigned long long)stats->stalls,
+            (unsigned long long)stats->droppedSamples, (unsigned long long)stats->errors);
+    if (outStats != NULL) {
+        *outStats = *stats;
+    }
+    free(trace->buffers[0]);
+    free(trace->buffers[1]);
+    free(trace->compressed);
+    free(trace);
+}
+
+void event_trace_record_cmd(struct event_trace* trace, int32_t cmd, const int32_t* args, int argCount) {
+    if (argCount > EVENT_TRACE_MAX_ARGS) argCount = EVENT_TRACE_MAX_ARGS;
+    uint8_t* p = event_trace_begin(trace, EVENT_TRACE_CMD, (2 + argCount) * EVENT_TRACE_VARINT_BYTES);
+    if (p == NULL) return;
+    p = event_trace_put_signed(p, cmd);
+    p = event_trace_put(p, (uint64_t)argCount);
+    for (int i = 0; i < argCount; i++) {
+        p = event_trace_put_signed(p, args[i]);
+    }
+    event_trace_end(trace, p);
+}
+
+static void event_trace_record_motion(struct event_trace* trace, const AInputEvent* event) {
+    size_t pointers = AMotionEvent_getPointerCount(event);
+    size_t history = AMotionEvent_getHistorySize(event);
+    if (pointers > EVENT_TRACE_MAX_POINTERS) pointers = EVENT_TRACE_MAX_POINTERS;
+    // Au-del de la limite, les chantillons historiques les plus anciens sont abandonns.
+    size_t first = history + 1 > EVENT_TRACE_MAX_SAMPLES ? history + 1 - EVENT_TRACE_MAX_SAMPLES : 0;
+    size_t samples = history + 1 - first;
+    trace->stats.droppedSamples += first * pointers;
+
+    size_t bound = (5 + pointers + samples + samples * pointers * 3) * EVENT_TRACE_VARINT_BYTES;
+    uint8_t* p = event_trace_begin(trace, EVENT_TRACE_MOTION, bound);
+    if (p == NULL) return;
+    int64_t eventTime = AMotionEvent_getEventTime(event);
+    p = event_trace_put_signed(p, AMotionEvent_getAction(event));
+    p = event_trace_put_signed(p, AInputEvent_getSource(event));
+    p = event_trace_put_signed(p, AInputEvent_getDeviceId(event));
+    p = event_trace_put(p, pointers);
+    p = event_trace_put(p, samples);
+    for (size_t i = 0; i < pointers; i++) {
+        p = event_trace_put_signed(p, AMotionEvent_getPointerId(event, i));
+    }
+    // L'instant courant depuis l'enregistrement, les historiques depuis l'instant courant.
+    p = event_trace_put_signed(p, trace->lastNs - eventTime);
+    for (size_t h = first; h < history; h++) {
+        p = event_trace_put_signed(p, eventTime - AMotionEvent_getHistoricalEventTime(event, h));
+    }
+    float (*previous)[EVENT_TRACE_MAX_POINTERS] = trace->channels.motion;
+    for (size_t h = first; h <= history; h++) {
+        for (size_t i = 0; i < pointers; i++) {
+            float x = h < history ? AMotionEvent_getHistoricalX(event, i, h) : AMotionEvent_getX(event, i);
+            float y = h < history ? AMotionEvent_getHistoricalY(event, i, h) : AMotionEvent_getY(event, i);
+            float pressure = h < history ? AMotionEvent_getHistoricalPressure(event, i, h)
+                    : AMotionEvent_getPressure(event, i);
+            p = event_trace_put_float(p, x, &previous[0][i]);
+            p = event_trace_put_float(p, y, &previous[1][i]);
+            p = event_trace_put_float(p, pressure, &previous[2][i]);
+        }
+    }
+    event_trace_end(trace, p);
+}
+
+static void event_trace_record_key(struct event_trace* trace, const AInputEvent* event) {
+    uint8_t* p = event_trace_begin(trace, EVENT_TRACE_KEY, 7 * EVENT_TRACE_VARINT_BYTES);
+    if (p == NULL) return;
+    p = event_trace_put_signed(p, AKeyEvent_getAction(event));
+    p = event_trace_put_signed(p, AKeyEvent_getKeyCode(event));
+    p = event_trace_put_signed(p, AKeyEvent_getMetaState(event));
+    p = event_trace_put_signed(p, AKeyEvent_getRepeatCount(event));
+    p = event_trace_put_signed(p, AInputEvent_getSource(event));
+    p = event_trace_put_signed(p, AInputEvent_getDeviceId(event));
+    p = event_trace_put_signed(p, trace->lastNs - AKeyEvent_getEventTime(event));
+    event_trace_end(trace, p);
+}
+
+void event_trace_record_input(struct event_trace* trace, const AInputEvent* event) {
+    switch (AInputEvent_getType(event)) {
+        case AINPUT_EVENT_TYPE_MOTION:
+            event_trace_record_motion(trace, event);
+            break;
+        case AINPUT_EVENT_TYPE_KEY:
+            event_trace_record_key(trace, event);
+            break;
+    }
+}
+
+void event_trace_record_sensors(struct event_trace* trace, const ASensorEvent* events, size_t count) {
+    struct event_trace_channels* channels = &trace->channels;
+    while (count > 0) {
+        size_t n = count < EVENT_TRACE_MAX_SENSOR_EVENTS ? count : EVENT_TRACE_MAX_SENSOR_EVENTS;
+        uint8_t* p = event_trace_begin(trace, EVENT_TRACE_SENSOR, (1 + n * 5) * EVENT_TRACE_VARINT_BYTES);
+        if (p == NULL) return;
+        p = event_trace_put(p, n);
+        for (size_t i = 0; i < n; i++) {
+            const ASensorEvent* event = &events[i];
+            p = event_trace_put_signed(p, event->type);
+            p = event_trace_put_signed(p, event->timestamp - channels->sensorTime);
+            channels->sensorTime = event->timestamp;
+            for (int axis = 0; axis < 3; axis++) {
+                p = event_trace_put_float(p, event->data[axis], &channels->sensor[axis]);
+            }
+        }
+        event_trace_end(trace, p);
+        events += n;
+        count -= n;
+    }
+}
+
+void event_trace_record_config(struct event_trace* trace, AConfiguration* config, int32_t changes) {
+    const int32_t fields[] = {
+        changes,
+        AConfiguration_getOrientation(config),
+        AConfiguration_getDensity(config),
+        AConfiguration_getTouchscreen(config),
+        AConfiguration_getKeyboard(config),
+        AConfiguration_getNavigation(config),
+        AConfiguration_getKeysHidden(config),
+        AConfiguration_getNavHidden(config),
+        AConfiguration_getScreenSize(config),
+        AConfiguration_getScreenLong(config),
+        AConfiguration_getUiModeType(config),
+        AConfiguration_getUiModeNight(config),
+    };
+    const int count = (int)(sizeof(fields) / sizeof(fields[0]));
+    uint8_t* p = event_trace_begin(trace, EVENT_TRACE_CONFIG, count * EVENT_TRACE_VARINT_BYTES);
+    if (p == NULL) return;
+    for (int i = 0; i < count; i++) {
+        p = event_trace_put_signed(p, fields[i]);
+    }
+    event_trace_end(trace, p);
+}
+
+void event_trace_record_state(struct event_trace* trace, const void* data, size_t size) {
+    uint8_t* p = event_trace_begin(trace, EVENT_TRACE_STATE, EVENT_TRACE_VARINT_BYTES + size);
+    if (p == NULL) return;
+    p = event_trace_put(p, size);
+    if (size > 0) {
+        memcpy(p, data, size);
+    }
+    event_trace_end(trace, p + size);
+}
+
+void event_trace_get_stats(struct event_trace* trace, struct event_trace_stats* outStats) {
+    pthread_mutex_lock(&trace->mutex);
+    *outStats = trace->stats;
+    pthread_mutex_unlock(&trace->mutex);
+}
+
+// --------------------------------------------------------------------
+// Lecture
+// --------------------------------------------------------------------
+
+// Retourne 1 si size octets ont t lus, 0  la fin du fichier, -1 sinon.
+static int event_trace_read_all(int fd, void* data, size_t size) {
+    uint8_t* p = (uint8_t*)data;
+    size_t done = 0;
+    while (done < size) {
+        ssize_t count = read(fd, p + done, size - done);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (count == 0) {
+            return done == 0 ? 0 : -1;
+        }
+        done += (size_t)count;
+    }
+    return 1;
+}
+
+static int event_trace_reserve(uint8_t** buffer, size_t* capacity, size_t size) {
+    if (size <= *capacity) {
+        return 0;
+    }
+    uint8_t* grown = (uint8_t*)realloc(*buffer, size);
+    if (grown == NULL) {
+        return -1;
+    }
+    *buffer = grown;
+    *capacity = size;
+    return 0;
+}
+
+// Bloc suivant. Retourne 1, 0  la fin du fichier, -1 si le bloc est illisible.
+static int event_trace_read_block(struct event_trace_reader* reader) {
+    struct event_trace_block_header header;
+    int result = event_trace_read_all(reader->fd, &header, sizeof(header));
+    if (result <= 0) {
+        return result;
+    }
+    if (event_trace_reserve(&reader->compressed, &reader->compressedCapacity, header.compressedBytes) != 0
+            || event_trace_reserve(&reader->raw, &reader->rawCapacity, header.rawBytes) != 0
+            || event_trace_read_all(reader->fd, reader->compressed, header.compressedBytes) != 1) {
+        return -1;
+    }
+    uLongf rawBytes = header.rawBytes;
+    if (uncompress(reader->raw, &rawBytes, reader->compressed, header.compressedBytes) != Z_OK
+            || rawBytes != header.rawBytes) {
+        return -1;
+    }
+    reader->rawBytes = rawBytes;
+    reader->position = 0;
+    return 1;
+}
+
+struct event_trace_reader* event_trace_open(const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct event_trace_file_header header;
+    if (event_trace_read_all(fd, &header, sizeof(header)) != 1 || header.magic != EVENT_TRACE_MAGIC
+            || header.version != EVENT_TRACE_VERSION || header.headerSize < sizeof(header)
+            || lseek(fd, header.headerSize, SEEK_SET) < 0) {
+        LOGE("%s is not an event trace", path);
+        close(fd);
+        return NULL;
+    }
+    struct event_trace_reader* reader = (struct event_trace_reader*)calloc(1, sizeof(struct event_trace_reader));
+    if (reader == NULL) {
+        close(fd);
+        return NULL;
+    }
+    reader->fd = fd;
+    reader->startNs = header.startNs;
+    return reader;
+}
+
+void event_trace_reader_close(struct event_trace_reader* reader) {
+    if (reader == NULL) {
+        return;
+    }
+    close(reader->fd);
+    free(reader->raw);
+    free(reader->compressed);
+    free(reader);
+}
+
+int64_t event_trace_start_ns(const struct event_trace_reader* reader) {
+    return reader->startNs;
+}
+
+static void event_trace_read_motion(struct event_trace_reader* reader, struct event_trace_cursor* cursor,
+        struct event_trace_motion* motion, int64_t recordNs) {
+    motion->action = (int32_t)event_trace_get_signed(cursor);
+    motion->source = (int32_t)event_trace_get_signed(cursor);
+    motion->deviceId = (int32_t)event_trace_get_signed(cursor);
+    motion->pointerCount = (uint32_t)event_trace_get(cursor);
+    motion->sampleCount = (uint32_t)event_trace_get(cursor);
+    if (motion->pointerCount > EVENT_TRACE_MAX_POINTERS || motion->sampleCount == 0
+            || motion->sampleCount > EVENT_TRACE_MAX_SAMPLES) {
+        cursor->error = 1;
+        return;
+    }
+    uint32_t last = motion->sampleCount - 1;
+    for (uint32_t i = 0; i < motion->pointerCount; i++) {
+        motion->pointerId[i] = (int32_t)event_trace_get_signed(cursor);
+    }
+    motion->eventTime[last] = recordNs - event_trace_get_signed(cursor);
+    for (uint32_t h = 0; h < last; h++) {
+        motion->eventTime[h] = motion->eventTime[last] - event_trace_get_signed(cursor);
+    }
+    float (*previous)[EVENT_TRACE_MAX_POINTERS] = reader->channels.motion;
+    for (uint32_t h = 0; h <= last; h++) {
+        for (uint32_t i = 0; i < motion->pointerCount; i++) {
+            motion->x[h][i] = event_trace_get_float(cursor, &previous[0][i]);
+            motion->y[h][i] = event_trace_get_float(cursor, &previous[1][i]);
+            motion->pressure[h][i] = event_trace_get_float(cursor, &previous[2][i]);
+        }
+    }
+}
+
+int event_trace_next(struct event_trace_reader* reader, struct event_trace_record* outRecord) {
+    if (reader->position == reader->rawBytes) {
+        int result = event_trace_read_block(reader);
+        if (result <= 0) {
+            return result;
+        }
+    }
+    struct event_trace_cursor cursor = {
+        reader->raw + reader->position, reader->raw + reader->rawBytes, 0,
+    };
+    struct event_trace_record* record = outRecord;
+    record->type = *cursor.p++;
+    reader->timeNs += (int64_t)event_trace_get(&cursor);
+    record->timeNs = reader->timeNs;
+    int64_t recordNs = reader->startNs + reader->timeNs;
+
+    switch (record->type) {
+        case EVENT_TRACE_CMD:
+            record->cmd = (int32_t)event_trace_get_signed(&cursor);
+            record->argCount = (int32_t)event_trace_get(&cursor);
+            if (record->argCount > EVENT_TRACE_MAX_ARGS) {
+                cursor.error = 1;
+                break;
+            }
+            for (int i = 0; i < record->argCount; i++) {
+                record->args[i] = (int32_t)event_trace_get_signed(&cursor);
+            }
+            break;
+        case EVENT_TRACE_MOTION:
+            event_trace_read_motion(reader, &cursor, &record->motion, recordNs);
+            break;
+        case EVENT_TRACE_KEY: {
+            struct event_trace_key* key = &record->key;
+            key->action = (int32_t)event_trace_get_signed(&cursor);
+            key->keyCode = (int32_t)event_trace_get_signed(&cursor);
+            key->metaState = (int32_t)event_trace_get_signed(&cursor);
+            key->repeatCount = (int32_t)event_trace_get_signed(&cursor);
+            key->source = (int32_t)event_trace_get_signed(&cursor);
+            key->deviceId = (int32_t)event_trace_get_signed(&cursor);
+            key->eventTime = recordNs - event_trace_get_signed(&cursor);
+            break;
+        }
+        case EVENT_TRACE_SENSOR: {
+            struct event_trace_channels* channels = &reader->channels;
+            record->sensorCount = (uint32_t)event_trace_get(&cursor);
+            if (record->sensorCount > EVENT_TRACE_MAX_SENSOR_EVENTS) {
+                cursor.error = 1;
+                break;
+            }
+            for (uint32_t i = 0; i < record->sensorCount; i++) {
+                struct event_trace_sensor* sensor = &record->sensors[i];
+                sensor->type = (int32_t)event_trace_get_signed(&cursor);
+                channels->sensorTime += event_trace_get_signed(&cursor);
+                sensor->timestamp = channels->sensorTime;
+                for (int axis = 0; axis < 3; axis++) {
+                    sensor->values[axis] = event_trace_get_float(&cursor, &channels->sensor[axis]);
+                }
+            }
+            break;
+        }
+        case EVENT_TRACE_CONFIG: {
+            int32_t* fields = &record->config.changes;
+            const int count = (int)(sizeof(record->config) / sizeof(int32_t));
+            for (int i = 0; i < count; i++) {
+                fields[i] = (int32_t)event_trace_get_signed(&cursor);
+            }
+            break;
+        }
+        case EVENT_TRACE_STATE:
+            record->stateSize = (size_t)event_trace_get(&cursor);
+            record->state = cursor.p;
+            if (record->stateSize > (size_t)(cursor.end - cursor.p)) {
+                cursor.error = 1;
+                break;
+            }
+            cursor.p += record->stateSize;
+            break;
+        default:
+            cursor.error = 1;
+            break;
+    }
+    if (cursor.error) {
+        LOGE("Corrupt trace record (type %d) at offset %zu", record->type, reader->position);
+        reader->position = reader->rawBytes;
+        return -1;
+    }
+    reader->position = (size_t)(cursor.p - reader->raw);
+    return 1;
+}
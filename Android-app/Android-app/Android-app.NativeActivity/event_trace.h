@@ -0,0 +1,226 @@
+// Lastorm tech.
+
+#ifndef _EVENT_TRACE_H
+#define _EVENT_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <android/configuration.h>
+#include <android/input.h>
+#include <android/sensor.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Enregistrement et rejeu des flux d'entre, de capteurs et du cycle de vie.
+ *
+ * Le code de collage enregistre chaque commande aprs son pr-traitement
+ * (process_cmd()) et chaque vnement d'entre remis  l'application
+ * (process_input()) ; sensor_pipeline_drain() enregistre les vnements bruts
+ * des capteurs. Chaque enregistrement est dat par l'cart avec le prcdent
+ * (horloge monotone) et cod en entiers de longueur variable : instants des
+ * vnements en carts, valeurs flottantes en OU exclusif avec la valeur
+ * prcdente du mme canal, ce qui laisse surtout des octets nuls. Les blocs
+ * de EVENT_TRACE_BLOCK_BYTES sont compresss par zlib et crits par un thread
+ * d'criture : le thread enregistreur ne fait que coder en mmoire.
+ *
+ * Fichier : un en-tte (EVENT_TRACE_MAGIC, version, instant de dpart), puis
+ * des blocs { octets dcods, octets compresss, donnes }. Un bloc tronqu
+ * (processus tu pendant l'criture) termine la lecture.
+ *
+ * Le lecteur rend les enregistrements dans l'ordre, dats depuis le dbut de
+ * la trace. Le pilote de rejeu les repasse par les mmes points d'entre,  la
+ * vitesse d'origine (ou multiplie) ou au plus vite : rappels de l'activit,
+ * AInputQueue et ASensorEventQueue sur l'hte (host_app -r), tage d'entre et
+ * chane de capteurs sur l'appareil, o le cycle de vie reste celui du systme.
+ *
+ * Un enregistreur n'est utilis que par un thread, celui d'android_main().
+ */
+
+#define EVENT_TRACE_MAGIC 0x43525445u  //  ETRC 
+#define EVENT_TRACE_VERSION 1
+
+// Taille d'un bloc avant compression.
+#define EVENT_TRACE_BLOCK_BYTES (64 << 10)
+
+// Limites d'un mouvement (chantillons historiques compris ; les plus anciens
+// sont abandonns au-del), d'un lot de capteurs et des arguments d'une commande.
+#define EVENT_TRACE_MAX_POINTERS 10
+#define EVENT_TRACE_MAX_SAMPLES 32
+#define EVENT_TRACE_MAX_SENSOR_EVENTS 64
+#define EVENT_TRACE_MAX_ARGS 4
+
+// Types d'enregistrement.
+enum {
+    EVENT_TRACE_CMD = 1,
+    EVENT_TRACE_MOTION,
+    EVENT_TRACE_KEY,
+    EVENT_TRACE_SENSOR,
+    EVENT_TRACE_CONFIG,
+    EVENT_TRACE_STATE,
+
+    EVENT_TRACE_TYPES
+};
+
+/**
+ * vnement de mouvement : les chantillons historiques, puis l'chantillon
+ * courant, toujours le dernier.
+ */
+struct event_trace_motion {
+    int32_t action;
+    int32_t source;
+    int32_t deviceId;
+    uint32_t pointerCount;
+    uint32_t sampleCount;
+    int32_t pointerId[EVENT_TRACE_MAX_POINTERS];
+    int64_t eventTime[EVENT_TRACE_MAX_SAMPLES];
+    float x[EVENT_TRACE_MAX_SAMPLES][EVENT_TRACE_MAX_POINTERS];
+    float y[EVENT_TRACE_MAX_SAMPLES][EVENT_TRACE_MAX_POINTERS];
+    float pressure[EVENT_TRACE_MAX_SAMPLES][EVENT_TRACE_MAX_POINTERS];
+};
+
+struct event_trace_key {
+    int32_t action;
+    int32_t keyCode;
+    int32_t metaState;
+    int32_t repeatCount;
+    int32_t source;
+    int32_t deviceId;
+    int64_t eventTime;
+};
+
+/**
+ * vnement de capteur : les trois premires valeurs seulement.
+ */
+struct event_trace_sensor {
+    int32_t type;
+    int64_t timestamp;
+    float values[3];
+};
+
+/**
+ * Champs de configuration disponibles ds Android 2.3. changes est le masque
+ * d'AConfiguration_diff() (0 pour la configuration de dpart).
+ */
+struct event_trace_config {
+    int32_t changes;
+    int32_t orientation;
+    int32_t density;
+    int32_t touchscreen;
+    int32_t keyboard;
+    int32_t navigation;
+    int32_t keysHidden;
+    int32_t navHidden;
+    int32_t screenSize;
+    int32_t screenLong;
+    int32_t uiModeType;
+    int32_t uiModeNight;
+};
+
+/**
+ * Enregistrement dcod. Seuls les champs de son type sont valides ; state
+ * reste valide jusqu' l'appel suivant  event_trace_next().
+ */
+struct event_trace_record {
+    int type;
+
+    // Instant d'enregistrement, depuis le dbut de la trace.
+    int64_t timeNs;
+
+    // Commande APP_CMD_* et ses arguments : largeur, hauteur et format de la
+    // fentre (INIT_WINDOW, WINDOW_RESIZED), prsence de la file (INPUT_CHANGED).
+    int32_t cmd;
+    int32_t argCount;
+    int32_t args[EVENT_TRACE_MAX_ARGS];
+
+    struct event_trace_motion motion;
+    struct event_trace_key key;
+    struct event_trace_sensor sensors[EVENT_TRACE_MAX_SENSOR_EVENTS];
+    uint32_t sensorCount;
+    struct event_trace_config config;
+    const void* state;
+    size_t stateSize;
+};
+
+struct event_trace_stats {
+    // Enregistrements par type, chantillons de mouvement abandonns.
+    uint64_t records[EVENT_TRACE_TYPES];
+    uint64_t droppedSamples;
+
+    // Octets cods, octets crits aprs compression, blocs.
+    uint64_t rawBytes;
+    uint64_t compressedBytes;
+    uint64_t blocks;
+
+    // Attentes du thread enregistreur derrire le thread d'criture.
+    uint64_t stalls;
+
+    // Erreurs d'criture ou de compression : la trace est incomplte.
+    uint64_t errors;
+};
+
+struct event_trace;
+struct event_trace_reader;
+
+/**
+ * Cre la trace path (remplace si elle existe) et dmarre son thread
+ * d'criture. Retourne NULL en cas d'erreur.
+ */
+struct event_trace* event_trace_create(const char* path);
+
+/**
+ * crit le bloc en cours, attend la fin des critures et ferme la trace ;
+ * outStats (NULL possible) reoit le bilan final. trace peut tre NULL.
+ */
+void event_trace_close(struct event_trace* trace, struct event_trace_stats* outStats);
+
+/**
+ * Remet le bloc en cours, mme incomplet, au thread d'criture ; par exemple
+ * avant le passage en arrire-plan, o le processus peut tre tu.
+ */
+void event_trace_flush(struct event_trace* trace);
+
+void event_trace_record_cmd(struct event_trace* trace, int32_t cmd, const int32_t* args, int argCount);
+void event_trace_record_input(struct event_trace* trace, const AInputEvent* event);
+void event_trace_record_sensors(struct event_trace* trace, const ASensorEvent* events, size_t count);
+void event_trace_record_config(struct event_trace* trace, AConfiguration* config, int32_t changes);
+void event_trace_record_state(struct event_trace* trace, const void* data, size_t size);
+
+void event_trace_get_stats(struct event_trace* trace, struct event_trace_stats* outStats);
+
+/**
+ * Ouvre une trace en lecture. Retourne NULL si le fichier est illisible ou
+ * n'est pas une trace de cette version.
+ */
+struct event_trace_reader* event_trace_open(const char* path);
+
+void event_trace_reader_close(struct event_trace_reader* reader);
+
+/**
+ * Enregistrement suivant. Retourne 1, 0  la fin de la trace, -1 si elle est
+ * tronque ou corrompue.
+ */
+int event_trace_next(struct event_trace_reader* reader, struct event_trace_record* outRecord);
+
+/**
+ * Instant de dpart de la trace (horloge monotone de l'enregistrement), auquel
+ * timeNs s'ajoute pour retrouver les instants d'origine des vnements.
+ */
+int64_t event_trace_start_ns(const struct event_trace_reader* reader);
+
+/**
+ * chance d'un enregistrement rejou  partir de startNs : speed multiplie la
+ * vitesse d'origine ; 0 rejoue au plus vite.
+ */
+static inline int64_t event_trace_due_ns(int64_t startNs, int64_t timeNs, float speed) {
+    return speed > 0.0f ? startNs + (int64_t)(timeNs / speed) : startNs;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _EVENT_TRACE_H */
@@ -0,0 +1,214 @@
+// Lastorm tech.
+
+ASYNC_LOG_TAG(frame_alloc_log_tag, "frame_alloc", 1);
+
+#define LOGW(...) ASYNC_LOG(ANDROID_LOG_WARN, &frame_alloc_log_tag, __VA_ARGS__)
+
+// --------------------------------------------------------------------
+// Arne d'image
+// --------------------------------------------------------------------
+
+struct frame_arena_block {
+    struct frame_arena_block* next;
+    size_t size;
+};
+
+// Place de l'en-tte d'un bloc de dbordement, qui garde l'alignement des donnes.
+#define FRAME_ARENA_BLOCK_HEADER ((sizeof(struct frame_arena_block) + FRAME_ARENA_ALIGN - 1) \
+        & ~(size_t)(FRAME_ARENA_ALIGN - 1))
+
+static size_t frame_arena_round(size_t size) {
+    return (size + FRAME_ARENA_ALIGN - 1) & ~(size_t)(FRAME_ARENA_ALIGN - 1);
+}
+
+// aligned_alloc n'existe dans bionic qu' partir d'Android 9 ; le bloc se libre avec free().
+static void* frame_arena_alloc_aligned(size_t size) {
+    void* memory = NULL;
+    if (posix_memalign(&memory, FRAME_ARENA_ALIGN, size) != 0) {
+        return NULL;
+    }
+    return memory;
+}
+
+int frame_arena_init(struct frame_arena* arena, size_t capacity) {
+    memset(arena, 0, sizeof(*arena));
+    capacity = frame_arena_round(capacity);
+    if (capacity > 0) {
+        arena->base = (uint8_t*)frame_arena_alloc_aligned(capacity);
+        if (arena->base == NULL) {
+            return -1;
+        }
+    }
+    arena->capacity = capacity;
+    return 0;
+}
+
+static void frame_arena_free_overflow(struct frame_arena* arena) {
+    struct frame_arena_block* block = arena->overflow;
+    while (block != NULL) {
+        struct frame_arena_block* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->overflow = NULL;
+    arena->overflowBytes = 0;
+}
+
+void frame_arena_destroy(struct frame_arena* arena) {
+    frame_arena_free_overflow(arena);
+    free(arena->base);
+    memset(arena, 0, sizeof(*arena));
+}
+
+void* frame_arena_alloc(struct frame_arena* arena, size_t size, size_t align) {
+    // Toutes les allocations commencent sur FRAME_ARENA_ALIGN : align n'a pas 
+    // tre trait  part, et mark/rewind restent exacts.
+    size_t space = frame_arena_round(size > 0 ? size : 1);
+    arena->allocations++;
+    arena->bytes += space;
+    if (space <= arena->capacity - arena->used) {
+        void* data = arena->base + arena->used;
+        arena->used += space;
+        return data;
+    }
+
+    struct frame_arena_block* block = (struct frame_arena_block*)frame_arena_alloc_aligned(
+            FRAME_ARENA_BLOCK_HEADER + space);
+    if (block == NULL) {
+        return NULL;
+    }
+    block->next = arena->overflow;
+    block->size = space;
+    arena->overflow = block;
+    arena->overflowBytes += space;
+    arena->stats.overflows++;
+    return (uint8_t*)block + FRAME_ARENA_BLOCK_HEADER;
+}
+
+size_t frame_arena_mark(const struct frame_arena* arena) {
+    return arena->used;
+}
+
+void frame_arena_rewind(struct frame_arena* arena, size_t mark) {
+    if (mark <= arena->used) {
+        arena->used = mark;
+    }
+}
+
+void frame_arena_reset(struct frame_arena* arena) {
+    struct frame_arena_stats* stats = &arena->stats;
+    stats->frames++;
+    stats->frameAllocations = arena->allocations;
+    stats->frameBytes = arena->bytes;
+    stats->allocations += arena->allocations;
+    stats->bytes += arena->bytes;
+    if (arena->bytes > stats->peakBytes) {
+        stats->peakBytes = arena->bytes;
+    }
+
+    if (arena->overflow != NULL) {
+        // La forme de l'image suivante sera probablement la mme : l'arne prend
+        // d'un coup la taille ncessaire, au lieu de dborder  chaque image.
+        size_t capacity = frame_arena_round(arena->capacity + arena->overflowBytes);
+        capacity += capacity / 4;
+        capacity = frame_arena_round(capacity);
+        uint8_t* base = (uint8_t*)frame_arena_alloc_aligned(capacity);
+        frame_arena_free_overflow(arena);
+        if (base != NULL) {
+            free(arena->base);
+            arena->base = base;
+            arena->capacity = capacity;
+            stats->grows++;
+        } else {
+            LOGW("Unable to grow frame arena to %zu bytes", capacity);
+        }
+    }
+    arena->used = 0;
+    arena->allocations = 0;
+    arena->bytes = 0;
+}
+
+// --------------------------------------------------------------------
+// Brouillon par thread
+// --------------------------------------------------------------------
+
+static pthread_key_t frame_scratch_key;
+static pthread_once_t frame_scratch_once = PTHREAD_ONCE_INIT;
+
+static void frame_scratch_release(void* param) {
+    struct frame_arena* arena = (struct frame_arena*)param;
+    frame_arena_destroy(arena);
+    free(arena);
+}
+
+static void frame_scratch_init(void) {
+    pthread_key_create(&frame_scratch_key, frame_scratch_release);
+}
+
+struct frame_arena* frame_scratch(void) {
+    pthread_once(&frame_scratch_once, frame_scratch_init);
+    struct frame_arena* arena = (struct frame_arena*)pthread_getspecific(frame_scratch_key);
+    if (arena != NULL) {
+        return arena;
+    }
+    arena = (struct frame_arena*)malloc(sizeof(struct frame_arena));
+    if (arena == NULL) {
+        return NULL;
+    }
+    if (frame_arena_init(arena, FRAME_SCRATCH_CAPACITY) != 0) {
+        free(arena);
+        return NULL;
+    }
+    pthread_setspecific(frame_scratch_key, arena);
+    return arena;
+}
+
+// --------------------------------------------------------------------
+// Rserve d'objets
+// --------------------------------------------------------------------
+
+int object_pool_init(struct object_pool* pool, size_t objectSize, uint32_t capacity) {
+    memset(pool, 0, sizeof(*pool));
+    pool->objectSize = frame_arena_round(objectSize > sizeof(void*) ? objectSize : sizeof(void*));
+    pool->storage = (uint8_t*)frame_arena_alloc_aligned(pool->objectSize * capacity);
+    if (pool->storage == NULL) {
+        return -1;
+    }
+    pool->capacity = capacity;
+    return 0;
+}
+
+void object_pool_destroy(struct object_pool* pool) {
+    free(pool->storage);
+    memset(pool, 0, sizeof(*pool));
+}
+
+void* object_pool_alloc(struct object_pool* pool) {
+    void* object = pool->freeList;
+    if (object != NULL) {
+        pool->freeList = *(void**)object;
+    } else if (pool->touched < pool->capacity) {
+        object = pool->storage + (size_t)pool->touched++ * pool->objectSize;
+    } else {
+        pool->exhausted++;
+        return NULL;
+    }
+    if (++pool->live > pool->peak) {
+        pool->peak = pool->live;
+    }
+    return object;
+}
+
+void object_pool_free(struct object_pool* pool, void* object) {
+    if (object == NULL) {
+        return;
+    }
+    *(void**)object = pool->freeList;
+    pool->freeList = object;
+    pool->live--;
+}
+
+int object_pool_owns(const struct object_pool* pool, const void* object) {
+    const uint8_t* data = (const uint8_t*)object;
+    return data >= pool->storage && data < pool->storage + (size_t)pool->capacity * pool->objectSize;
+}
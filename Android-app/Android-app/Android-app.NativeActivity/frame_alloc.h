@@ -0,0 +1,171 @@
+// Lastorm tech.
+
+#ifndef _FRAME_ALLOC_H
+#define _FRAME_ALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Allocation sans tas pour les images en rgime tabli.
+ *
+ *      arne d'image   allocation par incrment d'un pointeur, remise  zro  la
+ *                      fin de chaque itration de la boucle d'android_main() :
+ *                      les donnes temporaires d'une image n'ont pas  tre libres.
+ *      rserve d'objets  objets de taille fixe  longue dure de vie, dans un
+ *                      stockage statique ou allou une fois, avec une liste libre.
+ *      brouillon       une arne par thread (threads de travail, de rendu, de
+ *                      fond), cre  la premire utilisation ; l'appelant
+ *                      marque la position puis y revient.
+ *
+ * Une arne trop petite ne fait pas chouer l'allocation : le dbordement est
+ * servi par le tas, compt, et l'arne est agrandie au plus haut niveau atteint
+ *  la remise  zro suivante. Aprs la premire image de chaque forme, aucune
+ * allocation ne touche le tas.
+ *
+ * Une arne et une rserve appartiennent  un seul thread.
+ */
+
+#define FRAME_ARENA_ALIGN 16
+
+// Capacit du brouillon de chaque thread.
+#define FRAME_SCRATCH_CAPACITY (64 << 10)
+
+struct frame_arena_block;
+
+/**
+ * Compteurs d'une arne, mis  jour  chaque remise  zro.
+ */
+struct frame_arena_stats {
+    // Remises  zro (images), et allocations et octets de la dernire image.
+    uint64_t frames;
+    uint64_t frameAllocations;
+    uint64_t frameBytes;
+
+    // Totaux, plus haut niveau d'une image et allocations servies par le tas.
+    uint64_t allocations;
+    uint64_t bytes;
+    uint64_t peakBytes;
+    uint64_t overflows;
+    uint64_t grows;
+};
+
+struct frame_arena {
+    uint8_t* base;
+    size_t capacity;
+    size_t used;
+
+    // Blocs de dbordement allous sur le tas depuis la dernire remise  zro.
+    struct frame_arena_block* overflow;
+    size_t overflowBytes;
+
+    // Image en cours.
+    uint64_t allocations;
+    uint64_t bytes;
+
+    struct frame_arena_stats stats;
+};
+
+/**
+ * Prpare une arne de capacity octets. Retourne 0 en cas de succs, -1 sinon.
+ */
+int frame_arena_init(struct frame_arena* arena, size_t capacity);
+
+void frame_arena_destroy(struct frame_arena* arena);
+
+/**
+ * size octets aligns sur align (une puissance de deux, au plus
+ * FRAME_ARENA_ALIGN), valables jusqu' la prochaine remise  zro. Retourne
+ * NULL seulement si le tas est puis.
+ */
+void* frame_arena_alloc(struct frame_arena* arena, size_t size, size_t align);
+
+#define FRAME_ARENA_NEW(arena, type, count) \
+    ((type*)frame_arena_alloc((arena), sizeof(type) * (count), __alignof__(type)))
+
+/**
+ * Position courante, puis retour  cette position : les allocations faites
+ * entre les deux sont rendues (hors dbordement, rendu  la remise  zro).
+ */
+size_t frame_arena_mark(const struct frame_arena* arena);
+void frame_arena_rewind(struct frame_arena* arena, size_t mark);
+
+/**
+ * Fin d'image : toutes les allocations sont rendues et les compteurs de l'image
+ * sont reports dans stats. Aprs un dbordement, l'arne est agrandie.
+ */
+void frame_arena_reset(struct frame_arena* arena);
+
+/**
+ * Brouillon du thread appelant, libr  la fin du thread.
+ */
+struct frame_arena* frame_scratch(void);
+
+/**
+ * Rserve d'objets de taille fixe. Les emplacements jamais utiliss sont pris
+ * dans l'ordre, les emplacements rendus forment une liste libre : aucune
+ * initialisation n'est ncessaire, si bien qu'une rserve peut tre statique.
+ *
+ *      OBJECT_POOL_DEFINE(static, app_pool, struct android_app, 2);
+ *      struct android_app* app = OBJECT_POOL_NEW(&app_pool, struct android_app);
+ *      ...
+ *      object_pool_free(&app_pool, app);
+ */
+struct object_pool {
+    uint8_t* storage;
+    size_t objectSize;
+    uint32_t capacity;
+
+    // Emplacements dj distribus au moins une fois, et liste libre.
+    uint32_t touched;
+    void* freeList;
+
+    // Objets vivants, plus haut niveau et demandes refuses (rserve pleine).
+    uint32_t live;
+    uint32_t peak;
+    uint64_t exhausted;
+};
+
+// Taille d'un emplacement : un objet, et au moins un pointeur de la liste libre.
+#define OBJECT_POOL_SLOT_SIZE(type) (((sizeof(type) > sizeof(void*) ? sizeof(type) : sizeof(void*)) \
+        + FRAME_ARENA_ALIGN - 1) & ~(size_t)(FRAME_ARENA_ALIGN - 1))
+
+#define OBJECT_POOL_DEFINE(storageClass, name, type, count) \
+    storageClass uint8_t name##_storage[OBJECT_POOL_SLOT_SIZE(type) * (count)] \
+        __attribute__((aligned(FRAME_ARENA_ALIGN))); \
+    storageClass struct object_pool name = { name##_storage, OBJECT_POOL_SLOT_SIZE(type), (count) }
+
+#define OBJECT_POOL_NEW(pool, type) ((type*)object_pool_alloc(pool))
+
+/**
+ * Rserve de capacity objets de objectSize octets, dans un stockage allou une
+ * fois. Retourne 0 en cas de succs, -1 sinon.
+ */
+int object_pool_init(struct object_pool* pool, size_t objectSize, uint32_t capacity);
+
+/**
+ * Libre le stockage d'une rserve cre par object_pool_init().
+ */
+void object_pool_destroy(struct object_pool* pool);
+
+/**
+ * Objet non initialis, ou NULL si la rserve est pleine.
+ */
+void* object_pool_alloc(struct object_pool* pool);
+
+void object_pool_free(struct object_pool* pool, void* object);
+
+/**
+ * Valeur diffrente de zro si object appartient au stockage de la rserve.
+ */
+int object_pool_owns(const struct object_pool* pool, const void* object);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRAME_ALLOC_H */
@@ -0,0 +1,150 @@
+// Lastorm tech.
+
+ASYNC_LOG_TAG(frame_pacer_log_tag, "frame_pacer", 10);
+
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, &frame_pacer_log_tag, __VA_ARGS__)
+
+// Marge de rveil par dfaut : couvre la latence de rveil du looper et
+// l'arrondi  la milliseconde de son dlai.
+#define FRAME_PACER_LATCH_MARGIN_NS 1500000LL
+
+static const int frame_pacer_rates[] = {
+    FRAME_PACER_RATE_30, FRAME_PACER_RATE_60, FRAME_PACER_RATE_90, FRAME_PACER_RATE_120,
+};
+
+static int64_t frame_pacer_clock_ns(clockid_t clock) {
+    struct timespec now;
+    clock_gettime(clock, &now);
+    return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static int64_t frame_pacer_wake_ns(const struct frame_pacer* pacer) {
+    return pacer->deadlineNs - pacer->costEstimateNs - pacer->latchMarginNs;
+}
+
+void frame_pacer_init(struct frame_pacer* pacer, int rateHz) {
+    memset(pacer, 0, sizeof(*pacer));
+    pacer->latchMarginNs = FRAME_PACER_LATCH_MARGIN_NS;
+    pacer->reportStartNs = frame_pacer_clock_ns(CLOCK_MONOTONIC);
+    frame_pacer_set_rate(pacer, rateHz);
+}
+
+int frame_pacer_set_rate(struct frame_pacer* pacer, int rateHz) {
+    int best = frame_pacer_rates[0];
+    for (size_t i = 1; i < sizeof(frame_pacer_rates) / sizeof(frame_pacer_rates[0]); i++) {
+        int rate = frame_pacer_rates[i];
+        if (abs(rate - rateHz) < abs(best - rateHz)) best = rate;
+    }
+    pacer->rateHz = best;
+    pacer->periodNs = 1000000000LL / best;
+    return best;
+}
+
+void frame_pacer_reset(struct frame_pacer* pacer) {
+    pacer->deadlineNs = 0;
+    pacer->resync = 0;
+    pacer->pendingInputNs = 0;
+}
+
+int frame_pacer_poll_timeout(struct frame_pacer* pacer) {
+    if (pacer->deadlineNs == 0) {
+        return 0;
+    }
+    int64_t remaining = frame_pacer_wake_ns(pacer) - frame_pacer_clock_ns(CLOCK_MONOTONIC);
+    if (remaining <= 0) {
+        return 0;
+    }
+    // Arrondi infrieur : mieux vaut se rveiller un peu tt que manquer l'chance.
+    return (int)(remaining / 1000000);
+}
+
+int frame_pacer_due(struct frame_pacer* pacer) {
+    return frame_pacer_poll_timeout(pacer) == 0;
+}
+
+void frame_pacer_note_input(struct frame_pacer* pacer, int64_t eventTimeNs) {
+    if (pacer->pendingInputNs == 0 || eventTimeNs < pacer->pendingInputNs) {
+        pacer->pendingInputNs = eventTimeNs;
+    }
+}
+
+void frame_pacer_begin_frame(struct frame_pacer* pacer) {
+    pacer->frameStartNs = frame_pacer_clock_ns(CLOCK_MONOTONIC);
+    pacer->frameStartCpuNs = frame_pacer_clock_ns(CLOCK_THREAD_CPUTIME_ID);
+
+    if (pacer->deadlineNs == 0) {
+        // Premire image aprs une pause : la phase sera prise  la fin de l'image.
+        pacer->deadlineNs = pacer->frameStartNs;
+        pacer->resync = 1;
+    }
+
+    if (pacer->pendingInputNs != 0) {
+        int64_t latch = pacer->frameStartNs - pacer->pendingInputNs;
+        struct frame_pacer_stats* stats = &pacer->stats;
+        stats->inputLatches++;
+        stats->inputLatchTotalNs += latch;
+        if (latch > stats->inputLatchMaxNs) stats->inputLatchMaxNs = latch;
+        pacer->pendingInputNs = 0;
+    }
+}
+
+void frame_pacer_end_frame(struct frame_pacer* pacer) {
+    int64_t now = frame_pacer_clock_ns(CLOCK_MONOTONIC);
+    int64_t cpu = frame_pacer_clock_ns(CLOCK_THREAD_CPUTIME_ID) - pacer->frameStartCpuNs;
+
+    struct frame_pacer_stats* stats = &pacer->stats;
+    stats->frames++;
+    stats->cpuTotalNs += cpu;
+    if (cpu > stats->cpuMaxNs) stats->cpuMaxNs = cpu;
+
+    // Moyenne glissante sur environ huit images.
+    pacer->costEstimateNs += (cpu - pacer->costEstimateNs) / 8;
+
+    // Quand eglSwapBuffers() bloque, la fin de l'image concide avec une
+    // synchronisation verticale : elle sert de nouvelle phase  la premire
+    // image et aprs une chance manque.
+    if (pacer->resync) {
+        pacer->deadlineNs = now;
+        pacer->resync = 0;
+    } else if (now > pacer->deadlineNs + pacer->periodNs / 4) {
+        stats->missed++;
+        pacer->deadlineNs = now;
+    }
+
+    // L'chance avance d'une priode entire ; les priodes dont l'instant de
+    // rveil est dj dpass sont sautes.
+    pacer->deadlineNs += pacer->periodNs;
+    while (frame_pacer_wake_ns(pacer) < now - pacer->latchMarginNs) {
+        pacer->deadlineNs += pacer->periodNs;
+        stats->skipped++;
+    }
+
+    if (now - pacer->reportStartNs >= FRAME_PACER_REPORT_INTERVAL_NS) {
+        frame_pacer_report(pacer, NULL);
+    }
+}
+
+void frame_pacer_report(struct frame_pacer* pacer, struct frame_pacer_stats* outStats) {
+    int64_t now = frame_pacer_clock_ns(CLOCK_MONOTONIC);
+    struct frame_pacer_stats* stats = &pacer->stats;
+    stats->elapsedNs = now - pacer->reportStartNs;
+
+    if (stats->frames > 0) {
+        LOGI("%d Hz: frames=%llu fps=%.1f cpu_ms mean=%.3f max=%.3f missed=%llu skipped=%llu",
+                pacer->rateHz, (unsigned long long)stats->frames,
+                stats->frames * 1e9 / (double)stats->elapsedNs,
+                stats->cpuTotalNs / 1e6 / (double)stats->frames, stats->cpuMaxNs / 1e6,
+                (unsigned long long)stats->missed, (unsigned long long)stats->skipped);
+    }
+    if (stats->inputLatches > 0) {
+        LOGI("input latch_ms mean=%.3f max=%.3f",
+                stats->inputLatchTotalNs / 1e6 / (double)stats->inputLatches,
+                stats->inputLatchMaxNs / 1e6);
+    }
+
+    if (outStats != NULL) {
+        *outStats = *stats;
+    }
+    memset(stats, 0, sizeof(*stats));
+    pacer->reportStartNs = now;
+}
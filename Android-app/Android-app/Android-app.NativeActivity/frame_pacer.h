@@ -0,0 +1,154 @@
+// Lastorm tech.
+
+#ifndef _FRAME_PACER_H
+#define _FRAME_PACER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Planificateur d'images pilot par chance.
+ *
+ * Chaque image a une chance de prsentation ; la boucle de android_main()
+ * attend dans ALooper_pollAll() jusqu' l'instant de rveil, situ avant
+ * l'chance du cot estim d'une image et d'une marge fixe. Les entres sont
+ * ainsi lues au plus tard (late-latch), juste avant le dessin, au lieu de
+ * tourner sur ALooper_pollAll(0) en comptant sur eglSwapBuffers() pour
+ * limiter la cadence.
+ *
+ * Utilisation :
+ *
+ *      timeout = frame_pacer_poll_timeout(&pacer);   // dlai pour ALooper_pollAll()
+ *      ...
+ *      if (frame_pacer_due(&pacer)) {
+ *          frame_pacer_begin_frame(&pacer);
+ *          // mise  jour et dessin, eglSwapBuffers() compris
+ *          frame_pacer_end_frame(&pacer);
+ *      }
+ *
+ * Toutes les fonctions doivent tre appeles par le thread de android_main().
+ */
+
+/**
+ * Frquences cibles prises en charge, en Hz.
+ */
+#define FRAME_PACER_RATE_30 30
+#define FRAME_PACER_RATE_60 60
+#define FRAME_PACER_RATE_90 90
+#define FRAME_PACER_RATE_120 120
+
+/**
+ * Intervalle entre deux bilans automatiques, en nanosecondes.
+ */
+#define FRAME_PACER_REPORT_INTERVAL_NS 5000000000LL
+
+/**
+ * Bilan du planificateur depuis le dernier appel  frame_pacer_report().
+ */
+struct frame_pacer_stats {
+    uint64_t frames;
+
+    // Images termines aprs leur chance (plus un quart de priode de tolrance).
+    uint64_t missed;
+
+    // Priodes sautes quand une image a dur plus d'une priode.
+    uint64_t skipped;
+
+    // Temps CPU du thread par image.
+    int64_t cpuTotalNs;
+    int64_t cpuMaxNs;
+
+    // Dlai entre le plus ancien vnement d'entre non lu et le dbut de l'image.
+    uint64_t inputLatches;
+    int64_t inputLatchTotalNs;
+    int64_t inputLatchMaxNs;
+
+    int64_t elapsedNs;
+};
+
+struct frame_pacer {
+    // Frquence cible et priode correspondante.
+    int rateHz;
+    int64_t periodNs;
+
+    // chance de prsentation de la prochaine image (CLOCK_MONOTONIC), ou 0
+    // si la phase doit tre recale sur la prochaine image.
+    int64_t deadlineNs;
+
+    // Valeur diffrente de zro tant que la phase de la premire image n'est pas connue.
+    int resync;
+
+    // Marge de rveil ajoute au cot estim d'une image.
+    int64_t latchMarginNs;
+
+    // Moyenne glissante du temps CPU d'une image.
+    int64_t costEstimateNs;
+
+    // Dbut de l'image en cours : horloge monotone et temps CPU du thread.
+    int64_t frameStartNs;
+    int64_t frameStartCpuNs;
+
+    // Instant du plus ancien vnement d'entre reu depuis le dbut de la
+    // dernire image, ou 0.
+    int64_t pendingInputNs;
+
+    int64_t reportStartNs;
+    struct frame_pacer_stats stats;
+};
+
+/**
+ * Initialise le planificateur pour une frquence cible.
+ */
+void frame_pacer_init(struct frame_pacer* pacer, int rateHz);
+
+/**
+ * Change la frquence cible. Une valeur non prise en charge est ramene  la
+ * frquence la plus proche ; la frquence applique est retourne.
+ */
+int frame_pacer_set_rate(struct frame_pacer* pacer, int rateHz);
+
+/**
+ * Oublie la phase courante : la prochaine image est dessine sans attente.
+ *  appeler quand l'animation reprend aprs une pause.
+ */
+void frame_pacer_reset(struct frame_pacer* pacer);
+
+/**
+ * Dlai en millisecondes jusqu' l'instant de rveil de la prochaine image,
+ *  passer  ALooper_pollAll() ; 0 si l'image est due.
+ */
+int frame_pacer_poll_timeout(struct frame_pacer* pacer);
+
+/**
+ * Valeur diffrente de zro si la prochaine image doit tre dessine maintenant.
+ */
+int frame_pacer_due(struct frame_pacer* pacer);
+
+/**
+ * Signale un vnement d'entre dat de eventTimeNs (CLOCK_MONOTONIC), lu
+ * avant le dbut de la prochaine image.
+ */
+void frame_pacer_note_input(struct frame_pacer* pacer, int64_t eventTimeNs);
+
+void frame_pacer_begin_frame(struct frame_pacer* pacer);
+
+/**
+ * Termine l'image en cours et calcule l'chance suivante. Un bilan est
+ * journalis toutes les FRAME_PACER_REPORT_INTERVAL_NS.
+ */
+void frame_pacer_end_frame(struct frame_pacer* pacer);
+
+/**
+ * Copie le bilan courant dans outStats (si non NULL), le journalise et le
+ * remet  zro.
+ */
+void frame_pacer_report(struct frame_pacer* pacer, struct frame_pacer_stats* outStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRAME_PACER_H */
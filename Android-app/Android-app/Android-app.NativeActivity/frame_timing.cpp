@@ -0,0 +1,145 @@
+// Lastorm tech.
+
+static const char* const frame_timing_names[FRAME_PHASE_COUNT] = {
+    "poll", "cmd", "input", "sensor", "update", "draw", "swap", "frame",
+};
+
+static int frame_timing_index(uint64_t value) {
+    if (value < FRAME_TIMING_SUB_COUNT) {
+        return (int)value;
+    }
+    int msb = 63 - __builtin_clzll(value);
+    if (msb >= FRAME_TIMING_MAX_BITS) {
+        return FRAME_TIMING_BUCKETS - 1;
+    }
+    // Les FRAME_TIMING_SUB_BITS bits de poids fort, dont le premier vaut 1.
+    int shift = msb - (FRAME_TIMING_SUB_BITS - 1);
+    return FRAME_TIMING_SUB_COUNT + (shift - 1) * (FRAME_TIMING_SUB_COUNT / 2)
+        + (int)(value >> shift) - FRAME_TIMING_SUB_COUNT / 2;
+}
+
+// Plus grande valeur de l'intervalle index.
+static int64_t frame_timing_upper(int index) {
+    if (index < FRAME_TIMING_SUB_COUNT) {
+        return index;
+    }
+    int shift = (index - FRAME_TIMING_SUB_COUNT) / (FRAME_TIMING_SUB_COUNT / 2) + 1;
+    int64_t mantissa = (index - FRAME_TIMING_SUB_COUNT) % (FRAME_TIMING_SUB_COUNT / 2)
+        + FRAME_TIMING_SUB_COUNT / 2;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void frame_timing_init(struct frame_timing* timing) {
+    memset(timing, 0, sizeof(*timing));
+    timing->startNs = frame_timing_now();
+}
+
+int64_t frame_timing_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+void frame_timing_record(struct frame_timing* timing, int phase, int64_t durationNs) {
+    struct frame_timing_histogram* histogram = &timing->phases[phase];
+    uint64_t value = durationNs > 0 ? (uint64_t)durationNs : 0;
+    __atomic_fetch_add(&histogram->buckets[frame_timing_index(value)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->totalNs, value, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->count, 1, __ATOMIC_RELAXED);
+
+    uint64_t max = __atomic_load_n(&histogram->maxNs, __ATOMIC_RELAXED);
+    while (value > max && !__atomic_compare_exchange_n(&histogram->maxNs, &max, value, 1,
+            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+int64_t frame_timing_end(struct frame_timing* timing, int phase, int64_t startNs) {
+    int64_t now = frame_timing_now();
+    frame_timing_record(timing, phase, now - startNs);
+    return now;
+}
+
+void frame_timing_summarize(const struct frame_timing* timing, int phase,
+        struct frame_timing_summary* outSummary) {
+    const struct frame_timing_histogram* histogram = &timing->phases[phase];
+    memset(outSummary, 0, sizeof(*outSummary));
+
+    // Les compteurs sont relus intervalle par intervalle : le total fait foi
+    // mme si des enregistrements arrivent pendant la lecture.
+    uint64_t count = 0;
+    for (int i = 0; i < FRAME_TIMING_BUCKETS; i++) {
+        count += __atomic_load_n(&histogram->buckets[i], __ATOMIC_RELAXED);
+    }
+    if (count == 0) {
+        return;
+    }
+
+    const uint64_t ranks[3] = {
+        (count * 500 + 999) / 1000, (count * 990 + 999) / 1000, (count * 999 + 999) / 1000,
+    };
+    int64_t* values[3] = { &outSummary->p50Ns, &outSummary->p99Ns, &outSummary->p999Ns };
+    uint64_t seen = 0;
+    int next = 0;
+    for (int i = 0; i < FRAME_TIMING_BUCKETS && next < 3; i++) {
+        seen += __atomic_load_n(&histogram->buckets[i], __ATOMIC_RELAXED);
+        while (next < 3 && seen >= ranks[next]) {
+            *values[next++] = frame_timing_upper(i);
+        }
+    }
+
+    outSummary->count = count;
+    outSummary->meanNs = (int64_t)(__atomic_load_n(&histogram->totalNs, __ATOMIC_RELAXED) / count);
+    outSummary->maxNs = (int64_t)__atomic_load_n(&histogram->maxNs, __ATOMIC_RELAXED);
+    // Le maximum exact borne les centiles arrondis  leur intervalle.
+    for (int i = 0; i < 3; i++) {
+        if (*values[i] > outSummary->maxNs) *values[i] = outSummary->maxNs;
+    }
+}
+
+int frame_timing_write(const struct frame_timing* timing, FILE* file) {
+    double seconds = (frame_timing_now() - timing->startNs) / 1e9;
+    fprintf(file, "frame timing over %.1f s (us)\n", seconds);
+    fprintf(file, "%-8s %10s %10s %10s %10s %10s %10s\n",
+            "phase", "count", "mean", "p50", "p99", "p99.9", "max");
+    int written = 0;
+    for (int phase = 0; phase < FRAME_PHASE_COUNT; phase++) {
+        struct frame_timing_summary summary;
+        frame_timing_summarize(timing, phase, &summary);
+        if (summary.count == 0) {
+            continue;
+        }
+        fprintf(file, "%-8s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                frame_timing_names[phase], (unsigned long long)summary.count,
+                summary.meanNs / 1e3, summary.p50Ns / 1e3, summary.p99Ns / 1e3,
+                summary.p999Ns / 1e3, summary.maxNs / 1e3);
+        written++;
+    }
+    return written;
+}
+
+int frame_timing_dump(const struct frame_timing* timing, const char* path) {
+    if (path == NULL) {
+        frame_timing_write(timing, stdout);
+        fflush(stdout);
+        return 0;
+    }
+    FILE* file = fopen(path, "a");
+    if (file == NULL) {
+        return -1;
+    }
+    frame_timing_write(timing, file);
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+void frame_timing_reset(struct frame_timing* timing) {
+    for (int phase = 0; phase < FRAME_PHASE_COUNT; phase++) {
+        struct frame_timing_histogram* histogram = &timing->phases[phase];
+        for (int i = 0; i < FRAME_TIMING_BUCKETS; i++) {
+            __atomic_store_n(&histogram->buckets[i], 0, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&histogram->count, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&histogram->totalNs, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&histogram->maxNs, 0, __ATOMIC_RELAXED);
+    }
+    timing->startNs = frame_timing_now();
+}
@@ -0,0 +1,122 @@
+// Lastorm tech.
+
+#ifndef _FRAME_TIMING_H
+#define _FRAME_TIMING_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Mesure des phases d'une image.
+ *
+ * Chaque phase de la boucle de android_main() est date sur l'horloge
+ * monotone ; sa dure est ajoute  un histogramme  plage dynamique tendue
+ * (HDR) : 64 valeurs exactes, puis 32 intervalles par octave jusqu' environ
+ * 18 minutes, soit une erreur relative d'au plus 1/32 (3 %). Un enregistrement
+ * cote une lecture d'horloge et quelques additions atomiques, sans verrou :
+ * le thread de rendu et le thread de l'application peuvent enregistrer en mme
+ * temps qu'un autre thread lit les histogrammes.
+ *
+ * Utilisation :
+ *
+ *      int64_t t = frame_timing_now();
+ *      ...                                             // phase A
+ *      t = frame_timing_end(&timing, FRAME_PHASE_A, t);
+ *      ...                                             // phase B
+ *      t = frame_timing_end(&timing, FRAME_PHASE_B, t);
+ */
+
+enum {
+    // Passage non bloquant du looper juste avant une image, rappels compris.
+    FRAME_PHASE_POLL,
+    // Rappels du looper : commandes, entres et capteur.
+    FRAME_PHASE_CMD,
+    FRAME_PHASE_INPUT,
+    FRAME_PHASE_SENSOR,
+    // Mise  jour de l'tat avant le dessin.
+    FRAME_PHASE_UPDATE,
+    // engine_draw_frame(), sans eglSwapBuffers().
+    FRAME_PHASE_DRAW,
+    FRAME_PHASE_SWAP,
+    // Image complte, de frame_pacer_begin_frame()  frame_pacer_end_frame().
+    FRAME_PHASE_FRAME,
+
+    FRAME_PHASE_COUNT
+};
+
+#define FRAME_TIMING_SUB_BITS 6
+#define FRAME_TIMING_SUB_COUNT (1 << FRAME_TIMING_SUB_BITS)
+#define FRAME_TIMING_MAX_BITS 40
+#define FRAME_TIMING_BUCKETS (FRAME_TIMING_SUB_COUNT \
+        + (FRAME_TIMING_MAX_BITS - FRAME_TIMING_SUB_BITS) * (FRAME_TIMING_SUB_COUNT / 2))
+
+/**
+ * Histogramme d'une phase, en nanosecondes. Tous les champs sont modifis par
+ * des oprations atomiques.
+ */
+struct frame_timing_histogram {
+    uint64_t count;
+    uint64_t totalNs;
+    uint64_t maxNs;
+    uint32_t buckets[FRAME_TIMING_BUCKETS];
+};
+
+struct frame_timing {
+    struct frame_timing_histogram phases[FRAME_PHASE_COUNT];
+
+    // Dbut de la priode mesure (CLOCK_MONOTONIC).
+    int64_t startNs;
+};
+
+/**
+ * Rsum d'un histogramme ; les centiles sont la borne haute de leur intervalle.
+ */
+struct frame_timing_summary {
+    uint64_t count;
+    int64_t meanNs;
+    int64_t p50Ns;
+    int64_t p99Ns;
+    int64_t p999Ns;
+    int64_t maxNs;
+};
+
+void frame_timing_init(struct frame_timing* timing);
+
+int64_t frame_timing_now(void);
+
+void frame_timing_record(struct frame_timing* timing, int phase, int64_t durationNs);
+
+/**
+ * Enregistre la dure coule depuis startNs pour la phase et retourne
+ * l'instant courant, dbut de la phase suivante.
+ */
+int64_t frame_timing_end(struct frame_timing* timing, int phase, int64_t startNs);
+
+void frame_timing_summarize(const struct frame_timing* timing, int phase,
+        struct frame_timing_summary* outSummary);
+
+/**
+ * crit le rsum de chaque phase dans file. Retourne le nombre de phases crites.
+ */
+int frame_timing_write(const struct frame_timing* timing, FILE* file);
+
+/**
+ * Ajoute le rsum au fichier path, ou l'crit sur la sortie standard si path
+ * est NULL. Retourne 0 en cas de succs, -1 sinon.
+ */
+int frame_timing_dump(const struct frame_timing* timing, const char* path);
+
+/**
+ * Vide les histogrammes et commence une nouvelle priode.
+ */
+void frame_timing_reset(struct frame_timing* timing);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRAME_TIMING_H */
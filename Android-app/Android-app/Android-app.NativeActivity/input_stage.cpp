@@ -0,0 +1,159 @@
+// Lastorm tech.
+
+ASYNC_LOG_TAG(input_stage_log_tag, "input_stage", 10);
+
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, &input_stage_log_tag, __VA_ARGS__)
+
+// Indicateurs de l'chantillon courant du pointeur pointerIndex.
+static uint8_t input_stage_action_flags(int32_t action, size_t pointerIndex) {
+    size_t actionIndex = (size_t)((action & AMOTION_EVENT_ACTION_POINTER_INDEX_MASK)
+            >> AMOTION_EVENT_ACTION_POINTER_INDEX_SHIFT);
+    switch (action & AMOTION_EVENT_ACTION_MASK) {
+        case AMOTION_EVENT_ACTION_DOWN:
+            return INPUT_STAGE_DOWN;
+        case AMOTION_EVENT_ACTION_UP:
+            return INPUT_STAGE_UP;
+        case AMOTION_EVENT_ACTION_POINTER_DOWN:
+            return pointerIndex == actionIndex ? INPUT_STAGE_DOWN : 0;
+        case AMOTION_EVENT_ACTION_POINTER_UP:
+            return pointerIndex == actionIndex ? INPUT_STAGE_UP : 0;
+        case AMOTION_EVENT_ACTION_CANCEL:
+            return INPUT_STAGE_CANCELED;
+        default:
+            return 0;
+    }
+}
+
+void input_stage_init(struct input_stage* stage) {
+    stage->batches[0].count = 0;
+    stage->batches[0].events = 0;
+    stage->batches[0].firstEventTime = 0;
+    stage->batches[0].dropped = 0;
+    stage->batches[1] = stage->batches[0];
+    stage->back = 0;
+    stage->deferred = 0;
+    memset(&stage->stats, 0, sizeof(stage->stats));
+}
+
+// Compte l'vnement et rduit pointers et history  la place restante du lot.
+static void input_stage_reserve(struct input_stage* stage, struct input_batch* batch, int64_t eventTime,
+        size_t* pointersInOut, size_t* historyInOut) {
+    size_t pointers = *pointersInOut;
+    size_t history = *historyInOut;
+    if (batch->events++ == 0) {
+        batch->firstEventTime = eventTime;
+    }
+    stage->stats.events++;
+
+    // Sans place pour tout l'vnement, seuls les chantillons courants sont gards.
+    size_t room = INPUT_STAGE_MAX_SAMPLES - batch->count;
+    if (pointers * (history + 1) > room) {
+        batch->dropped += (uint32_t)(pointers * history);
+        stage->stats.dropped += pointers * history;
+        history = 0;
+        if (pointers > room) {
+            batch->dropped += (uint32_t)(pointers - room);
+            stage->stats.dropped += pointers - room;
+            pointers = room;
+        }
+    }
+    *pointersInOut = pointers;
+    *historyInOut = history;
+}
+
+int32_t input_stage_add(struct input_stage* stage, const AInputEvent* event) {
+    struct input_batch* batch = &stage->batches[stage->back];
+    size_t pointers = AMotionEvent_getPointerCount(event);
+    size_t history = AMotionEvent_getHistorySize(event);
+    int32_t action = AMotionEvent_getAction(event);
+    int64_t eventTime = AMotionEvent_getEventTime(event);
+    input_stage_reserve(stage, batch, eventTime, &pointers, &history);
+
+    // chantillons dans l'ordre chronologique ; pour un mme instant, dans
+    // l'ordre des pointeurs. Les accesseurs sont appels une fois par valeur.
+    size_t n = batch->count;
+    for (size_t h = 0; h < history; h++) {
+        int64_t time = AMotionEvent_getHistoricalEventTime(event, h);
+        for (size_t p = 0; p < pointers; p++, n++) {
+            batch->eventTime[n] = time;
+            batch->pointerId[n] = AMotionEvent_getPointerId(event, p);
+            batch->x[n] = AMotionEvent_getHistoricalX(event, p, h);
+            batch->y[n] = AMotionEvent_getHistoricalY(event, p, h);
+            batch->pressure[n] = AMotionEvent_getHistoricalPressure(event, p, h);
+            batch->flags[n] = INPUT_STAGE_HISTORICAL | (p == 0 ? INPUT_STAGE_PRIMARY : 0);
+        }
+    }
+    for (size_t p = 0; p < pointers; p++, n++) {
+        batch->eventTime[n] = eventTime;
+        batch->pointerId[n] = AMotionEvent_getPointerId(event, p);
+        batch->x[n] = AMotionEvent_getX(event, p);
+        batch->y[n] = AMotionEvent_getY(event, p);
+        batch->pressure[n] = AMotionEvent_getPressure(event, p);
+        batch->flags[n] = input_stage_action_flags(action, p) | (p == 0 ? INPUT_STAGE_PRIMARY : 0);
+    }
+
+    stage->stats.samples += n - batch->count;
+    stage->stats.historical += pointers * history;
+    batch->count = n;
+    return 1;
+}
+
+int32_t input_stage_add_motion(struct input_stage* stage, const struct event_trace_motion* motion) {
+    struct input_batch* batch = &stage->batches[stage->back];
+    size_t pointers = motion->pointerCount;
+    size_t history = motion->sampleCount - 1;
+    size_t last = history;
+    input_stage_reserve(stage, batch, motion->eventTime[last], &pointers, &history);
+
+    // Les chantillons historiques abandonns sont les plus anciens.
+    size_t n = batch->count;
+    for (size_t h = last - history; h <= last; h++) {
+        for (size_t p = 0; p < pointers; p++, n++) {
+            batch->eventTime[n] = motion->eventTime[h];
+            batch->pointerId[n] = motion->pointerId[p];
+            batch->x[n] = motion->x[h][p];
+            batch->y[n] = motion->y[h][p];
+            batch->pressure[n] = motion->pressure[h][p];
+            batch->flags[n] = (h < last ? INPUT_STAGE_HISTORICAL : input_stage_action_flags(motion->action, p))
+                    | (p == 0 ? INPUT_STAGE_PRIMARY : 0);
+        }
+    }
+
+    stage->stats.samples += n - batch->count;
+    stage->stats.historical += pointers * history;
+    batch->count = n;
+    return 1;
+}
+
+const struct input_batch* input_stage_swap(struct input_stage* stage) {
+    struct input_batch* ready = &stage->batches[stage->back];
+    stage->back ^= 1;
+
+    struct input_batch* next = &stage->batches[stage->back];
+    next->count = 0;
+    next->events = 0;
+    next->firstEventTime = 0;
+    next->dropped = 0;
+
+    if (ready->events > 0) {
+        stage->stats.batches++;
+        if (ready->count > stage->stats.largestBatch) stage->stats.largestBatch = ready->count;
+    }
+    return ready;
+}
+
+void input_stage_report(struct input_stage* stage, struct input_stage_stats* outStats) {
+    struct input_stage_stats* stats = &stage->stats;
+    if (stats->events > 0) {
+        LOGI("events=%llu batches=%llu events/batch=%.1f samples=%llu historical=%llu "
+                "largest=%llu dropped=%llu",
+                (unsigned long long)stats->events, (unsigned long long)stats->batches,
+                stats->batches > 0 ? stats->events / (double)stats->batches : 0.0,
+                (unsigned long long)stats->samples, (unsigned long long)stats->historical,
+                (unsigned long long)stats->largestBatch, (unsigned long long)stats->dropped);
+    }
+    if (outStats != NULL) {
+        *outStats = *stats;
+    }
+    memset(stats, 0, sizeof(*stats));
+}
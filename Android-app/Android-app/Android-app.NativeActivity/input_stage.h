@@ -0,0 +1,116 @@
+// Lastorm tech.
+
+#ifndef _INPUT_STAGE_H
+#define _INPUT_STAGE_H
+
+#include <stdint.h>
+
+#include <android/input.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * tage d'entre : regroupement des vnements de mouvement par image.
+ *
+ * Quand android_app.inputStage est dfini, process_input() ne passe plus les
+ * vnements de mouvement  onInputEvent : input_stage_add() copie tous leurs
+ * pointeurs et tous leurs chantillons historiques dans un lot en structure
+ * de tableaux, puis l'vnement est termin aussitt. Le moteur reoit un seul
+ * lot par image avec input_stage_swap(). Les touches et les autres vnements
+ * suivent toujours onInputEvent, dont le rsultat est transmis 
+ * AInputQueue_finishEvent().
+ *
+ * Quand deferred n'est pas zro, la file d'entre est dtache du looper ds
+ * qu'elle a t vide, et android_app_latch_input() la vide de nouveau et la
+ * rattache au dbut de chaque image : le thread n'est rveill qu'une fois par
+ * image, et non  chaque vnement. Sans image  venir (cran statique),
+ * deferred doit rester  zro.
+ *
+ * Toutes les fonctions doivent tre appeles par le thread de android_main().
+ */
+
+// Capacit d'un lot, en chantillons (un chantillon par pointeur et par instant).
+#define INPUT_STAGE_MAX_SAMPLES 1024
+
+// Indicateurs d'un chantillon.
+#define INPUT_STAGE_HISTORICAL 0x01    // chantillon historique, antrieur  l'vnement
+#define INPUT_STAGE_PRIMARY 0x02       // premier pointeur de l'vnement
+#define INPUT_STAGE_DOWN 0x04          // le pointeur vient de toucher l'cran
+#define INPUT_STAGE_UP 0x08            // le pointeur vient de quitter l'cran
+#define INPUT_STAGE_CANCELED 0x10      // geste annul
+
+/**
+ * Lot d'chantillons de mouvement, du plus ancien au plus rcent.
+ */
+struct input_batch {
+    size_t count;
+    int64_t eventTime[INPUT_STAGE_MAX_SAMPLES];
+    int32_t pointerId[INPUT_STAGE_MAX_SAMPLES];
+    float x[INPUT_STAGE_MAX_SAMPLES];
+    float y[INPUT_STAGE_MAX_SAMPLES];
+    float pressure[INPUT_STAGE_MAX_SAMPLES];
+    uint8_t flags[INPUT_STAGE_MAX_SAMPLES];
+
+    // vnements regroups, et instant du premier d'entre eux, ou 0.
+    uint32_t events;
+    int64_t firstEventTime;
+
+    // chantillons perdus faute de place : les historiques d'abord.
+    uint32_t dropped;
+};
+
+/**
+ * Bilan de l'tage depuis le dernier appel  input_stage_report().
+ */
+struct input_stage_stats {
+    uint64_t events;
+    uint64_t samples;
+    uint64_t historical;
+    uint64_t dropped;
+    uint64_t batches;
+    uint64_t largestBatch;
+};
+
+struct input_stage {
+    // Lot en cours de remplissage et lot remis au moteur.
+    struct input_batch batches[2];
+    int back;
+
+    // Valeur diffrente de zro pour ne lire la file qu'une fois par image.
+    int deferred;
+
+    struct input_stage_stats stats;
+};
+
+void input_stage_init(struct input_stage* stage);
+
+/**
+ * Ajoute les chantillons d'un vnement de mouvement au lot en cours.
+ * Retourne la valeur  passer  AInputQueue_finishEvent().
+ */
+int32_t input_stage_add(struct input_stage* stage, const AInputEvent* event);
+
+/**
+ * Mme chose pour un mouvement relu dans une trace (event_trace.h).
+ */
+int32_t input_stage_add_motion(struct input_stage* stage, const struct event_trace_motion* motion);
+
+/**
+ * Remet au moteur le lot accumul depuis l'appel prcdent, vide ou non, et
+ * commence un nouveau lot. Le lot retourn reste valide jusqu' l'appel suivant.
+ */
+const struct input_batch* input_stage_swap(struct input_stage* stage);
+
+/**
+ * Copie le bilan courant dans outStats (si non NULL), le journalise et le
+ * remet  zro.
+ */
+void input_stage_report(struct input_stage* stage, struct input_stage_stats* outStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _INPUT_STAGE_H */
@@ -0,0 +1,580 @@
+// Lastorm tech.
+
+ASYNC_LOG_TAG(job_system_log_tag, "job_system", 1);
+
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, &job_system_log_tag, __VA_ARGS__)
+#define LOGW(...) ASYNC_LOG(ANDROID_LOG_WARN, &job_system_log_tag, __VA_ARGS__)
+
+// Recherches infructueuses (avec sched_yield()) avant qu'un thread ne s'endorme.
+#define JOB_SYSTEM_SPINS 64
+
+#define JOB_SYSTEM_MAX_THREADS (2 * JOB_SYSTEM_MAX_WORKERS + 1)
+#define JOB_SYSTEM_MAX_CPUS 64
+
+struct job {
+    job_function function;
+    struct job* parent;
+
+    // Tche elle-mme et filles non termines ; la case est libre  zro.
+    int32_t unfinished;
+    int32_t jobClass;
+
+    uint8_t data[JOB_SYSTEM_DATA_BYTES];
+} __attribute__((aligned(64)));
+
+/**
+ * File de Chase et Lev de taille fixe : le propritaire empile et dpile en bas,
+ * les voleurs prennent en haut.
+ */
+struct job_system_deque {
+    int64_t top __attribute__((aligned(64)));
+    int64_t bottom __attribute__((aligned(64)));
+    struct job* jobs[JOB_SYSTEM_DEQUE_SIZE];
+};
+
+struct job_system_worker {
+    struct job_system_deque deque;
+    struct job pool[JOB_SYSTEM_POOL_SIZE];
+    uint32_t poolNext;
+
+    struct job_system* system;
+    int index;
+    int group;
+    uint32_t seed;
+    pthread_t thread;
+
+    struct job_system_worker_stats stats;
+};
+
+/**
+ * Groupe de threads : ses membres sont workers[first]  workers[first + count - 1].
+ * Les tches lances par un thread d'un autre groupe passent par la bote de
+ * rception. epoch change  chaque tche lance : un thread ne s'endort que
+ * s'il n'a pas chang depuis sa dernire recherche.
+ */
+struct job_system_group {
+    int first;
+    int count;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+    uint32_t epoch;
+    int sleepers;
+
+    struct job* inbox[JOB_SYSTEM_DEQUE_SIZE];
+    uint32_t inboxHead;
+    uint32_t inboxTail;
+};
+
+struct job_system {
+    int flags;
+    int stop;
+    uint64_t fast;
+    uint64_t efficient;
+
+    int workerCount;
+    struct job_system_worker* workers[JOB_SYSTEM_MAX_THREADS];
+    struct job_system_group groups[JOB_SYSTEM_CLASSES];
+};
+
+static __thread struct job_system_worker* job_system_current;
+
+// --------------------------------------------------------------------
+// File de Chase et Lev
+// --------------------------------------------------------------------
+
+static int job_system_push(struct job_system_deque* deque, struct job* job) {
+    int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+    int64_t top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    if (bottom - top >= JOB_SYSTEM_DEQUE_SIZE) {
+        return -1;
+    }
+    __atomic_store_n(&deque->jobs[bottom & (JOB_SYSTEM_DEQUE_SIZE - 1)], job, __ATOMIC_RELAXED);
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static struct job* job_system_pop(struct job_system_deque* deque) {
+    int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&deque->bottom, bottom, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t top = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+    if (top > bottom) {
+        __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    struct job* job = __atomic_load_n(&deque->jobs[bottom & (JOB_SYSTEM_DEQUE_SIZE - 1)],
+            __ATOMIC_RELAXED);
+    if (top == bottom) {
+        // Dernire tche : dispute avec les voleurs.
+        if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, 0, __ATOMIC_SEQ_CST,
+                __ATOMIC_RELAXED)) {
+            job = NULL;
+        }
+        __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+    }
+    return job;
+}
+
+static struct job* job_system_steal(struct job_system_deque* deque) {
+    int64_t top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+    if (top >= bottom) {
+        return NULL;
+    }
+    struct job* job = __atomic_load_n(&deque->jobs[top & (JOB_SYSTEM_DEQUE_SIZE - 1)],
+            __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, 0, __ATOMIC_SEQ_CST,
+            __ATOMIC_RELAXED)) {
+        return NULL;
+    }
+    return job;
+}
+
+// --------------------------------------------------------------------
+// Excution
+// --------------------------------------------------------------------
+
+static struct job_system_group* job_system_group_for(struct job_system* system, int jobClass) {
+    if (jobClass == JOB_SYSTEM_BACKGROUND && system->groups[JOB_SYSTEM_BACKGROUND].count > 0) {
+        return &system->groups[JOB_SYSTEM_BACKGROUND];
+    }
+    return &system->groups[JOB_SYSTEM_LATENCY];
+}
+
+static void job_system_notify(struct job_system_group* group) {
+    __atomic_add_fetch(&group->epoch, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&group->sleepers, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&group->mutex);
+        pthread_cond_signal(&group->wake);
+        pthread_mutex_unlock(&group->mutex);
+    }
+}
+
+static struct job* job_system_take_inbox(struct job_system_group* group) {
+    if (__atomic_load_n(&group->inboxHead, __ATOMIC_ACQUIRE)
+            == __atomic_load_n(&group->inboxTail, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    struct job* job = NULL;
+    pthread_mutex_lock(&group->mutex);
+    if (group->inboxHead != group->inboxTail) {
+        job = group->inbox[group->inboxHead & (JOB_SYSTEM_DEQUE_SIZE - 1)];
+        __atomic_store_n(&group->inboxHead, group->inboxHead + 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&group->mutex);
+    return job;
+}
+
+// Tche suivante pour worker : sa file, la bote de son groupe, puis un vol.
+static struct job* job_system_find(struct job_system_worker* worker) {
+    struct job* job = job_system_pop(&worker->deque);
+    if (job != NULL) {
+        return job;
+    }
+    struct job_system* system = worker->system;
+    struct job_system_group* group = &system->groups[worker->group];
+    job = job_system_take_inbox(group);
+    if (job != NULL) {
+        return job;
+    }
+    for (int i = 1; i < group->count; i++) {
+        worker->seed = worker->seed * 1664525u + 1013904223u;
+        struct job_system_worker* victim =
+                system->workers[group->first + (worker->seed >> 16) % group->count];
+        if (victim == worker) {
+            continue;
+        }
+        job = job_system_steal(&victim->deque);
+        if (job != NULL) {
+            __atomic_fetch_add(&worker->stats.steals, 1, __ATOMIC_RELAXED);
+            return job;
+        }
+    }
+    return NULL;
+}
+
+// La parente est lue avant la dcrmentation : une tche termine peut tre rutilise aussitt.
+static void job_system_finish(struct job* job) {
+    while (job != NULL) {
+        struct job* parent = job->parent;
+        if (__atomic_sub_fetch(&job->unfinished, 1, __ATOMIC_ACQ_REL) != 0) {
+            break;
+        }
+        job = parent;
+    }
+}
+
+static void job_system_execute(struct job_system_worker* worker, struct job* job) {
+    int64_t start = frame_timing_now();
+    job->function(worker->system, job, job->data);
+    // Compteurs lus par job_system_get_worker_stats() depuis un autre thread.
+    __atomic_fetch_add(&worker->stats.busyNs, (uint64_t)(frame_timing_now() - start), __ATOMIC_RELAXED);
+    __atomic_fetch_add(&worker->stats.jobs, 1, __ATOMIC_RELAXED);
+    job_system_finish(job);
+}
+
+// Cur courant ; sched_getcpu() n'existe qu' partir d'Android 3.1.
+static int job_system_cpu(void) {
+    unsigned cpu = 0;
+    return syscall(SYS_getcpu, &cpu, NULL, NULL) == 0 ? (int)cpu : -1;
+}
+
+static void job_system_set_affinity(uint64_t mask) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu = 0; cpu < JOB_SYSTEM_MAX_CPUS; cpu++) {
+        if (mask & (1ull << cpu)) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        LOGW("Unable to set the thread affinity: %s", strerror(errno));
+    }
+}
+
+static void* job_system_worker_main(void* param) {
+    struct job_system_worker* worker = (struct job_system_worker*)param;
+    struct job_system* system = worker->system;
+    struct job_system_group* group = &system->groups[worker->group];
+    job_system_current = worker;
+
+    int background = worker->group == JOB_SYSTEM_BACKGROUND;
+    if (!(system->flags & JOB_SYSTEM_NO_AFFINITY)) {
+        // Sur un processeur homogne, les threads de fond restent sur tous les curs.
+        uint64_t mask = background ? system->efficient : system->fast;
+        if (mask != 0) {
+            job_system_set_affinity(mask);
+        }
+    }
+    if (!(system->flags & JOB_SYSTEM_NO_PRIORITY)) {
+        int nice = background ? JOB_SYSTEM_BACKGROUND_NICE : JOB_SYSTEM_LATENCY_NICE;
+        if (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), nice) != 0) {
+            LOGW("Unable to set the priority of worker %d to %d: %s", worker->index, nice,
+                    strerror(errno));
+        }
+    }
+    __atomic_store_n(&worker->stats.cpu, job_system_cpu(), __ATOMIC_RELAXED);
+
+    int spins = 0;
+    while (!__atomic_load_n(&system->stop, __ATOMIC_ACQUIRE)) {
+        uint32_t epoch = __atomic_load_n(&group->epoch, __ATOMIC_SEQ_CST);
+        struct job* job = job_system_find(worker);
+        if (job != NULL) {
+            job_system_execute(worker, job);
+            spins = 0;
+            continue;
+        }
+        if (++spins < JOB_SYSTEM_SPINS) {
+            sched_yield();
+            continue;
+        }
+        spins = 0;
+        pthread_mutex_lock(&group->mutex);
+        __atomic_add_fetch(&group->sleepers, 1, __ATOMIC_SEQ_CST);
+        int64_t start = frame_timing_now();
+        while (__atomic_load_n(&group->epoch, __ATOMIC_SEQ_CST) == epoch
+                && !__atomic_load_n(&system->stop, __ATOMIC_ACQUIRE)) {
+            pthread_cond_wait(&group->wake, &group->mutex);
+        }
+        __atomic_fetch_add(&worker->stats.sleepNs, (uint64_t)(frame_timing_now() - start), __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&group->sleepers, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&group->mutex);
+        __atomic_store_n(&worker->stats.cpu, job_system_cpu(), __ATOMIC_RELAXED);
+    }
+    job_system_current = NULL;
+    return NULL;
+}
+
+// Excute une tche du groupe de l'appelant s'il y en a une, sinon cde le cur.
+static void job_system_help(struct job_system_worker* worker) {
+    struct job* job = job_system_find(worker);
+    if (job != NULL) {
+        job_system_execute(worker, job);
+    } else {
+        sched_yield();
+    }
+}
+
+// --------------------------------------------------------------------
+// Topologie
+// --------------------------------------------------------------------
+
+static long job_system_read_long(const char* format, int cpu) {
+    char path[96];
+    snprintf(path, sizeof(path), format, cpu);
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return 0;
+    }
+    long value = 0;
+    if (fscanf(file, "%ld", &value) != 1) {
+        value = 0;
+    }
+    fclose(file);
+    return value;
+}
+
+static void job_system_detect(uint64_t* outFast, uint64_t* outEfficient) {
+    long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    if (cpus > JOB_SYSTEM_MAX_CPUS) cpus = JOB_SYSTEM_MAX_CPUS;
+    if (cpus < 1) cpus = 1;
+    long capacities[JOB_SYSTEM_MAX_CPUS];
+    long best = 0;
+    for (int cpu = 0; cpu < cpus; cpu++) {
+        long capacity = job_system_read_long("/sys/devices/system/cpu/cpu%d/cpu_capacity", cpu);
+        if (capacity <= 0) {
+            capacity = job_system_read_long("/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+        }
+        capacities[cpu] = capacity > 0 ? capacity : 1;
+        if (capacities[cpu] > best) {
+            best = capacities[cpu];
+        }
+    }
+    *outFast = 0;
+    *outEfficient = 0;
+    for (int cpu = 0; cpu < cpus; cpu++) {
+        if (capacities[cpu] == best) {
+            *outFast |= 1ull << cpu;
+        } else {
+            *outEfficient |= 1ull << cpu;
+        }
+    }
+}
+
+// --------------------------------------------------------------------
+// Interface
+// --------------------------------------------------------------------
+
+static struct job_system_worker* job_system_new_worker(struct job_system* system, int group) {
+    void* memory = NULL;
+    if (posix_memalign(&memory, 64, sizeof(struct job_system_worker)) != 0) {
+        return NULL;
+    }
+    struct job_system_worker* worker = (struct job_system_worker*)memory;
+    memset(worker, 0, sizeof(*worker));
+    worker->system = system;
+    worker->index = system->workerCount;
+    worker->group = group;
+    worker->seed = 0x9e3779b9u * (uint32_t)(worker->index + 1);
+    worker->stats.jobClass = group;
+    worker->stats.cpu = -1;
+    system->workers[system->workerCount++] = worker;
+    return worker;
+}
+
+struct job_system* job_system_create(int latencyWorkers, int backgroundWorkers, int flags) {
+    struct job_system* system = (struct job_system*)calloc(1, sizeof(struct job_system));
+    if (system == NULL) {
+        return NULL;
+    }
+    system->flags = flags;
+    job_system_detect(&system->fast, &system->efficient);
+    if (latencyWorkers < 0) {
+        latencyWorkers = __builtin_popcountll(system->fast) - 1;
+    }
+    if (backgroundWorkers < 0) {
+        backgroundWorkers = system->efficient != 0 ? 1 : 0;
+    }
+    if (latencyWorkers > JOB_SYSTEM_MAX_WORKERS) latencyWorkers = JOB_SYSTEM_MAX_WORKERS;
+    if (backgroundWorkers > JOB_SYSTEM_MAX_WORKERS) backgroundWorkers = JOB_SYSTEM_MAX_WORKERS;
+    for (int i = 0; i < JOB_SYSTEM_CLASSES; i++) {
+        pthread_mutex_init(&system->groups[i].mutex, NULL);
+        pthread_cond_init(&system->groups[i].wake, NULL);
+    }
+
+    // Le thread appelant est le premier membre du groupe de latence.
+    struct job_system_group* latency = &system->groups[JOB_SYSTEM_LATENCY];
+    struct job_system_group* background = &system->groups[JOB_SYSTEM_BACKGROUND];
+    latency->first = 0;
+    latency->count = 1 + latencyWorkers;
+    background->first = latency->count;
+    background->count = backgroundWorkers;
+    for (int i = 0; i < latency->count + background->count; i++) {
+        if (job_system_new_worker(system, i < latency->count ? JOB_SYSTEM_LATENCY
+                : JOB_SYSTEM_BACKGROUND) == NULL) {
+            job_system_destroy(system);
+            return NULL;
+        }
+    }
+    job_system_current = system->workers[0];
+    system->workers[0]->stats.cpu = job_system_cpu();
+    for (int i = 1; i < system->workerCount; i++) {
+        struct job_system_worker* worker = system->workers[i];
+        if (pthread_create(&worker->thread, NULL, job_system_worker_main, worker) != 0) {
+            LOGW("Unable to start job worker %d", i);
+            // Les membres suivants ne dmarreront pas : les groupes sont rduits.
+            struct job_system_group* group = &system->groups[worker->group];
+            group->count = i - group->first;
+            if (worker->group == JOB_SYSTEM_LATENCY) {
+                background->first = i;
+                background->count = 0;
+            }
+            for (int j = i; j < system->workerCount; j++) {
+                free(system->workers[j]);
+                system->workers[j] = NULL;
+            }
+            system->workerCount = i;
+            break;
+        }
+    }
+    LOGI("job system: %d latency and %d background threads, fast cpus 0x%llx, efficient cpus 0x%llx",
+            latency->count, background->count, (unsigned long long)system->fast,
+            (unsigned long long)system->efficient);
+    return system;
+}
+
+void job_system_destroy(struct job_system* system) {
+    if (system == NULL) {
+        return;
+    }
+    __atomic_store_n(&system->stop, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < JOB_SYSTEM_CLASSES; i++) {
+        struct job_system_group* group = &system->groups[i];
+        pthread_mutex_lock(&group->mutex);
+        __atomic_add_fetch(&group->epoch, 1, __ATOMIC_SEQ_CST);
+        pthread_cond_broadcast(&group->wake);
+        pthread_mutex_unlock(&group->mutex);
+    }
+    for (int i = 0; i < system->workerCount; i++) {
+        if (i > 0 && system->workers[i]->thread != 0) {
+            pthread_join(system->workers[i]->thread, NULL);
+        }
+        if (job_system_current == system->workers[i]) {
+            job_system_current = NULL;
+        }
+        free(system->workers[i]);
+    }
+    for (int i = 0; i < JOB_SYSTEM_CLASSES; i++) {
+        pthread_cond_destroy(&system->groups[i].wake);
+        pthread_mutex_destroy(&system->groups[i].mutex);
+    }
+    free(system);
+}
+
+struct job* job_system_create_job(struct job_system* system, job_function function,
+        const void* data, size_t size, struct job* parent) {
+    struct job_system_worker* worker = job_system_current;
+    struct job* job = NULL;
+    while (job == NULL) {
+        for (int i = 0; i < JOB_SYSTEM_POOL_SIZE; i++) {
+            struct job* candidate = &worker->pool[worker->poolNext++ & (JOB_SYSTEM_POOL_SIZE - 1)];
+            if (__atomic_load_n(&candidate->unfinished, __ATOMIC_ACQUIRE) == 0) {
+                job = candidate;
+                break;
+            }
+        }
+        if (job == NULL) {
+            // Rserve puise : des tches sont excutes jusqu' ce qu'une case se libre.
+            job_system_help(worker);
+        }
+    }
+    job->function = function;
+    job->parent = parent;
+    job->jobClass = JOB_SYSTEM_LATENCY;
+    __atomic_store_n(&job->unfinished, 1, __ATOMIC_RELAXED);
+    if (size > JOB_SYSTEM_DATA_BYTES) {
+        size = JOB_SYSTEM_DATA_BYTES;
+    }
+    if (size > 0) {
+        memcpy(job->data, data, size);
+    }
+    if (parent != NULL) {
+        __atomic_add_fetch(&parent->unfinished, 1, __ATOMIC_RELAXED);
+    }
+    return job;
+}
+
+void job_system_run(struct job_system* system, struct job* job, int jobClass) {
+    struct job_system_worker* worker = job_system_current;
+    struct job_system_group* group = job_system_group_for(system, jobClass);
+    job->jobClass = jobClass;
+    int groupIndex = (int)(group - system->groups);
+    if (worker->group == groupIndex) {
+        if (job_system_push(&worker->deque, job) != 0) {
+            // File pleine : la tche est excute tout de suite.
+            job_system_execute(worker, job);
+            return;
+        }
+    } else {
+        pthread_mutex_lock(&group->mutex);
+        int full = group->inboxTail - group->inboxHead >= JOB_SYSTEM_DEQUE_SIZE;
+        if (!full) {
+            group->inbox[group->inboxTail & (JOB_SYSTEM_DEQUE_SIZE - 1)] = job;
+            __atomic_store_n(&group->inboxTail, group->inboxTail + 1, __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&group->mutex);
+        if (full) {
+            job_system_execute(worker, job);
+            return;
+        }
+    }
+    job_system_notify(group);
+}
+
+void job_system_wait(struct job_system* system, struct job* job) {
+    struct job_system_worker* worker = job_system_current;
+    while (__atomic_load_n(&job->unfinished, __ATOMIC_ACQUIRE) > 0) {
+        job_system_help(worker);
+    }
+}
+
+// --------------------------------------------------------------------
+// Boucle parallle
+// --------------------------------------------------------------------
+
+struct job_system_range {
+    void (*function)(void* data, size_t begin, size_t end);
+    void* data;
+    size_t begin;
+    size_t end;
+    size_t grain;
+};
+
+// Dcoupe rcursive : la moiti haute est confie  une fille, que les autres threads peuvent voler.
+static void job_system_range_main(struct job_system* system, struct job* job, void* data) {
+    struct job_system_range range = *(struct job_system_range*)data;
+    while (range.end - range.begin > range.grain) {
+        size_t middle = range.begin + (range.end - range.begin) / 2;
+        struct job_system_range upper = range;
+        upper.begin = middle;
+        struct job* child = job_system_create_job(system, job_system_range_main, &upper,
+                sizeof(upper), job);
+        job_system_run(system, child, JOB_SYSTEM_LATENCY);
+        range.end = middle;
+    }
+    range.function(range.data, range.begin, range.end);
+}
+
+void job_system_parallel_for(struct job_system* system, size_t count, size_t grain,
+        void (*function)(void* data, size_t begin, size_t end), void* data) {
+    if (count == 0) {
+        return;
+    }
+    if (grain < 1) grain = 1;
+    struct job_system_range range = { function, data, 0, count, grain };
+    struct job* root = job_system_create_job(system, job_system_range_main, &range, sizeof(range), NULL);
+    job_system_run(system, root, JOB_SYSTEM_LATENCY);
+    job_system_wait(system, root);
+}
+
+int job_system_get_workers(const struct job_system* system) {
+    return system->workerCount;
+}
+
+void job_system_get_topology(const struct job_system* system, uint64_t* outFast, uint64_t* outEfficient) {
+    *outFast = system->fast;
+    *outEfficient = system->efficient;
+}
+
+void job_system_get_worker_stats(const struct job_system* system, int worker,
+        struct job_system_worker_stats* outStats) {
+    const struct job_system_worker_stats* stats = &system->workers[worker]->stats;
+    outStats->jobClass = stats->jobClass;
+    outStats->cpu = __atomic_load_n(&stats->cpu, __ATOMIC_RELAXED);
+    outStats->jobs = __atomic_load_n(&stats->jobs, __ATOMIC_RELAXED);
+    outStats->steals = __atomic_load_n(&stats->steals, __ATOMIC_RELAXED);
+    outStats->busyNs = __atomic_load_n(&stats->busyNs, __ATOMIC_RELAXED);
+    outStats->sleepNs = __atomic_load_n(&stats->sleepNs, __ATOMIC_RELAXED);
+}
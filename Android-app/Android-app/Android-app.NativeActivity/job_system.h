@@ -0,0 +1,150 @@
+// Lastorm tech.
+
+#ifndef _JOB_SYSTEM_H
+#define _JOB_SYSTEM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Ordonnanceur de tches par vol de travail.
+ *
+ * Chaque thread du systme (le thread crateur et les threads de travail) a
+ * sa file  double extrmit : il empile et dpile ses tches d'un ct, les
+ * autres threads de son groupe les volent de l'autre (file de Chase et Lev,
+ * sans verrou). Une tche peut avoir une tche parente : la parente n'est
+ * termine qu'une fois toutes ses filles termines, et job_system_wait() sur
+ * une tche excute d'autres tches en attendant.
+ *
+ * Deux groupes de threads :
+ *
+ *      latence     le thread crateur et les threads de premier plan ; ces
+ *                  derniers sont placs sur les curs rapides avec une
+ *                  priorit d'affichage ;
+ *      fond        threads placs sur les curs conomes avec une priorit
+ *                  basse ; ils n'excutent que les tches de fond.
+ *
+ * Les curs rapides sont ceux de plus grande capacit (cpu_capacity, ou 
+ * dfaut frquence maximale) ; sur un processeur homogne, tous les curs le
+ * sont, et seule la priorit distingue les deux groupes. Sans thread de fond,
+ * les tches de fond sont excutes par le groupe de latence.
+ *
+ * Les tches sont prises dans une rserve circulaire propre  chaque thread,
+ * sans allocation : une case n'est rutilise qu'une fois sa tche termine.
+ * Une tche termine ne doit donc plus tre attendue aprs que son thread en a
+ * cr JOB_SYSTEM_POOL_SIZE autres. Les threads inactifs dorment jusqu' la
+ * prochaine tche de leur groupe.
+ *
+ * Seuls les threads du systme crent, lancent et attendent des tches. Le
+ * placement et la priorit ne s'appliquent qu'aux threads crs : le thread
+ * crateur garde les siens, fixs par son propritaire.
+ */
+
+// Threads de travail au plus, par groupe.
+#define JOB_SYSTEM_MAX_WORKERS 8
+
+// Capacit de la file de chaque thread et de sa rserve de tches (puissances de deux).
+#define JOB_SYSTEM_DEQUE_SIZE 1024
+#define JOB_SYSTEM_POOL_SIZE 1024
+
+// Donnes recopies dans une tche, au plus.
+#define JOB_SYSTEM_DATA_BYTES 88
+
+// Options de job_system_create().
+#define JOB_SYSTEM_NO_AFFINITY 0x1  // pas de placement sur les curs
+#define JOB_SYSTEM_NO_PRIORITY 0x2  // priorit des threads inchange
+
+// Priorits (nice) des deux groupes, comme THREAD_PRIORITY_DISPLAY et _BACKGROUND.
+#define JOB_SYSTEM_LATENCY_NICE (-4)
+#define JOB_SYSTEM_BACKGROUND_NICE 10
+
+enum {
+    JOB_SYSTEM_LATENCY,
+    JOB_SYSTEM_BACKGROUND,
+
+    JOB_SYSTEM_CLASSES
+};
+
+struct job_system;
+struct job;
+
+typedef void (*job_function)(struct job_system* system, struct job* job, void* data);
+
+/**
+ * Utilisation d'un thread depuis sa cration. Les compteurs sont mis  jour par
+ * leur thread et se lisent depuis n'importe quel thread.
+ */
+struct job_system_worker_stats {
+    int jobClass;
+    int cpu;
+
+    uint64_t jobs;
+    uint64_t steals;
+
+    // Dure d'excution des tches, et dure de sommeil faute de tche.
+    uint64_t busyNs;
+    uint64_t sleepNs;
+};
+
+/**
+ * Cre le systme. latencyWorkers et backgroundWorkers comptent les threads
+ * crs en plus du thread appelant ; une valeur ngative choisit selon les
+ * curs (un thread par cur rapide moins le thread appelant ; un thread de fond
+ * s'il y a des curs conomes). flags combine les options JOB_SYSTEM_*.
+ * Retourne NULL en cas d'erreur.
+ */
+struct job_system* job_system_create(int latencyWorkers, int backgroundWorkers, int flags);
+
+/**
+ * Arrte les threads ; les tches doivent tre termines. Par le thread crateur.
+ */
+void job_system_destroy(struct job_system* system);
+
+/**
+ * Nouvelle tche : function sera appele avec une copie des size octets de data
+ * (au plus JOB_SYSTEM_DATA_BYTES). parent, s'il n'est pas NULL, attend la fin
+ * de la tche. La tche est lance par job_system_run().
+ */
+struct job* job_system_create_job(struct job_system* system, job_function function,
+        const void* data, size_t size, struct job* parent);
+
+/**
+ * Lance la tche, dans le groupe de jobClass (JOB_SYSTEM_LATENCY ou
+ * JOB_SYSTEM_BACKGROUND).
+ */
+void job_system_run(struct job_system* system, struct job* job, int jobClass);
+
+/**
+ * Excute des tches de son groupe jusqu' la fin de job et de ses filles.
+ */
+void job_system_wait(struct job_system* system, struct job* job);
+
+/**
+ * Appelle function(data, begin, end) sur [0, count) dcoup en tranches de
+ * grain lments, rparties sur le groupe de latence, et attend la fin.
+ */
+void job_system_parallel_for(struct job_system* system, size_t count, size_t grain,
+        void (*function)(void* data, size_t begin, size_t end), void* data);
+
+/**
+ * Threads du systme, thread crateur compris (indice 0).
+ */
+int job_system_get_workers(const struct job_system* system);
+
+/**
+ * Curs rapides et conomes dtects (masques des 64 premiers curs).
+ */
+void job_system_get_topology(const struct job_system* system, uint64_t* outFast, uint64_t* outEfficient);
+
+void job_system_get_worker_stats(const struct job_system* system, int worker,
+        struct job_system_worker_stats* outStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _JOB_SYSTEM_H */
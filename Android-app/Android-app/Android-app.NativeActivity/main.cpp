@@ -17,8 +17,118 @@
 
 // Lastorm tech.
 
-#define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, "AndroidProject1.NativeActivity", __VA_ARGS__))
-#define LOGW(...) ((void)__android_log_print(ANDROID_LOG_WARN, "AndroidProject1.NativeActivity", __VA_ARGS__))
+ASYNC_LOG_TAG(engine_log_tag, "AndroidProject1.NativeActivity", 20);
+
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, &engine_log_tag, __VA_ARGS__)
+#define LOGW(...) ASYNC_LOG(ANDROID_LOG_WARN, &engine_log_tag, __VA_ARGS__)
+
+/**
+* Frquence d'images cible de l'animation.
+*/
+#define ENGINE_FRAME_RATE FRAME_PACER_RATE_60
+
+/**
+* Utilisation d'un thread de rendu propritaire du contexte EGL : 0 pour jamais,
+* 1 si l'appareil a plusieurs curs, 2 pour toujours.
+*/
+#ifndef ENGINE_RENDER_THREAD
+#define ENGINE_RENDER_THREAD 1
+#endif
+
+/**
+* Rendu : 0 pour OpenGL ES, remplac par le rendu logiciel si EGL choue ; 1 pour
+* toujours le rendu logiciel (soft_raster.h).
+*/
+#ifndef ENGINE_RENDER_BACKEND
+#define ENGINE_RENDER_BACKEND 0
+#endif
+
+/**
+* Rendu  la demande : 1 pour ne dessiner une image que si ce qu'elle montre a
+* chang et attendre dans le looper le reste du temps, 0 pour dessiner chaque
+* image tant que l'animation tourne.
+*/
+#ifndef ENGINE_RENDER_ON_DEMAND
+#define ENGINE_RENDER_ON_DEMAND 1
+#endif
+
+/**
+* Dure de l'animation de couleur aprs la dernire activit (toucher, mouvement de
+* l'appareil, nouvelle fentre, focus) en rendu  la demande.
+*/
+#define ENGINE_ANIMATION_IDLE_NS 2000000000LL
+
+/**
+* Variation de l'acclration filtre, sur un axe, qui compte comme un mouvement.
+*/
+#define ENGINE_MOTION_THRESHOLD 0.5f
+
+/**
+* Signal qui demande l'criture des mesures de phases d'image et l'export des
+* tranches de trace (sys_trace.h) dans spans.json, au format JSON de Chrome, dans
+* le stockage interne (adb shell run-as <paquet> kill -USR2 <pid>, ou kill -USR2
+* sur l'hte).
+*/
+#define ENGINE_TIMING_SIGNAL SIGUSR2
+#define ENGINE_SPANS_FILE "spans.json"
+
+/**
+* Identificateur looper de ces demandes.
+*/
+#define ENGINE_LOOPER_ID_TIMING (LOOPER_ID_USER + 1)
+
+/**
+* Capacit initiale de l'arne d'image ; elle s'agrandit aprs un dbordement.
+*/
+#define ENGINE_FRAME_ARENA_BYTES (16 << 10)
+
+/**
+* Attributs minimaux de la configuration EGL : au moins 8 bits par couleur,
+* compatible avec les fentres  l'cran et OpenGL ES 2. Parmi les configurations
+* qui conviennent, display_manager_score_config() choisit la moins coteuse.
+*/
+static const EGLint engine_config_attribs[] = {
+	EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+	EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+	EGL_BLUE_SIZE, 8,
+	EGL_GREEN_SIZE, 8,
+	EGL_RED_SIZE, 8,
+	EGL_NONE
+};
+
+/**
+* Contexte OpenGL ES 3, ou 2 si l'appareil ne l'a pas (sprite_batch.h).
+*/
+static const EGLint engine_context_attribs[] = {
+	EGL_CONTEXT_CLIENT_VERSION, 3,
+	EGL_NONE
+};
+
+/**
+* Ct de l'image du repre de toucher, en texels, et rayon du repre dessin,
+* en dp (pixels  la densit moyenne) ; teinte du repre en mode nuit.
+*/
+#define ENGINE_MARKER_TEXELS 32
+#define ENGINE_MARKER_RADIUS_DP 24
+#define ENGINE_MARKER_NIGHT_COLOR 0xff808080u
+
+/**
+* Image du repre fournie par l'APK (RGBA, ENGINE_MARKER_TEXELS de ct, sans
+* en-tte), qui remplace le disque gnr quand elle existe ; budget du cache des
+* ressources.
+*/
+#define ENGINE_MARKER_ASSET "marker.rgba"
+#define ENGINE_ASSET_BUDGET (4 << 20)
+
+/**
+* Enregistrement et rejeu des vnements (event_trace.h), commands par des fichiers
+* du stockage interne : record_events enregistre la session dans events.trace ;
+* replay_events la rejoue,  la vitesse crite dans le fichier (1 par dfaut, 0 : au
+* plus vite, une image de trace par itration).
+*/
+#define ENGINE_TRACE_FILE "events.trace"
+#define ENGINE_RECORD_TRIGGER "record_events"
+#define ENGINE_REPLAY_TRIGGER "replay_events"
 
 /**
 * Donnes d'tat enregistres.
@@ -29,6 +139,88 @@ struct saved_state {
 	int32_t y;
 };
 
+/**
+* Famille et champs de l'tat enregistr au format de state_snapshot.h. Un champ
+* ajout prend un nouvel identifiant ; un identifiant existant ne change jamais
+* de signification.
+*/
+#define ENGINE_STATE_SCHEMA 0x31474e45u	//  ENG1 
+
+enum {
+	ENGINE_STATE_ANGLE = 1,
+	ENGINE_STATE_POSITION = 2,
+
+	ENGINE_STATE_FIELD_COUNT = 2
+};
+
+/**
+* Instantan immuable de l'tat publi pour le thread de rendu.
+*/
+struct engine_snapshot {
+	struct saved_state state;
+	uint64_t frame;
+};
+
+/**
+* Demandes adresses au thread de rendu.
+*/
+enum {
+	ENGINE_RENDER_NONE,
+	ENGINE_RENDER_INIT,
+	ENGINE_RENDER_TERM,
+	ENGINE_RENDER_RESIZE,
+	ENGINE_RENDER_REDRAW,
+	ENGINE_RENDER_RELEASE,
+	ENGINE_RENDER_EXIT,
+};
+
+/**
+* Raisons de dessiner la prochaine image.
+*/
+enum {
+	ENGINE_DIRTY_STATE = 0x1,	// position ou angle modifis
+	ENGINE_DIRTY_CONTENT = 0x2,	// ressource charge (image du repre)
+};
+
+/**
+* Bilan du rendu  la demande : images prsentes, images prpares mais sautes
+* faute de changement, et attentes dans le looper sans aucune image.
+*/
+struct engine_redraw_stats {
+	uint64_t presented;
+	uint64_t skipped;
+	uint64_t idlePeriods;
+	int64_t idleNs;
+};
+
+/**
+* Thread de rendu facultatif. Il possde le contexte EGL et dessine toujours le dernier
+* instantan publi par android_main() ; les demandes INIT et TERM sont synchrones, de
+* sorte que la fentre n'est jamais utilise aprs le retour de APP_CMD_TERM_WINDOW.
+*/
+struct engine_renderer {
+	int threaded;
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+
+	// Demande en cours, protge par mutex.
+	int request;
+
+	// Un instantan attend d'tre dessin ; le thread de rendu attend sur cond
+	// quand waiting n'est pas zro.
+	int framePending;
+	int waiting;
+
+	struct triple_buffer snapshots;
+	struct engine_snapshot slots[3];
+
+	// Instantans publis, remplacs avant d'tre lus, et dessins.
+	uint64_t published;
+	uint64_t dropped;
+	uint64_t drawn;
+};
+
 /**
 * tat partag de l'application.
 */
@@ -38,181 +230,1228 @@ struct engine {
 	ASensorManager* sensorManager;
 	const ASensor* accelerometerSensor;
 	ASensorEventQueue* sensorEventQueue;
+	struct sensor_pipeline sensors;
+
+	// Entres de mouvement, regroupes en un lot par image.
+	struct input_stage input;
+
+	// Dernier chantillon filtr de l'acclromtre.
+	struct sensor_sample acceleration;
 
 	int animating;
-	EGLDisplay display;
-	EGLSurface surface;
-	EGLContext context;
+	struct frame_pacer pacer;
+
+	// Rendu  la demande : raisons de dessiner (ENGINE_DIRTY_*), fin de l'animation de
+	// couleur, acclration du dernier mouvement, et attente sans image en cours.
+	uint32_t dirty;
+	int64_t animateUntil;
+	struct sensor_sample motionReference;
+	int idle;
+	int64_t idleSince;
+	struct engine_redraw_stats redraw;
+	struct display_manager egl;
 	int32_t width;
 	int32_t height;
 	struct saved_state state;
+
+	// Rendu logiciel, utilis  la place d'EGL.
+	struct soft_raster* raster;
+
+	// Sprites dessins par OpenGL ES.
+	struct sprite_batch* sprites;
+
+	// Aspect du repre selon la configuration, lu par le thread de rendu : rayon en
+	// pixels et teinte.
+	int32_t markerRadius;
+	uint32_t markerColor;
+
+	// chelle des tampons de la fentre, choisie d'aprs la dure des images par le
+	// thread propritaire du contexte ; width et height restent la taille de la
+	// fentre. La taille d'une surface EGL redimensionne est relue aprs la
+	// prsentation suivante.
+	struct resolution_governor resolution;
+	int renderScaleChanged;
+
+	// Ressources de l'APK, charges en arrire-plan. L'image du repre est publie
+	// par le thread d'android_main() et charge dans le contexte par le thread de rendu.
+	struct asset_stream* assets;
+	const struct asset_stream_asset* marker;
+	const struct asset_stream_asset* markerUploaded;
+
+	struct engine_renderer renderer;
+
+	// Dures des phases de la boucle, enregistres aussi par le thread de rendu.
+	struct frame_timing timing;
+
+	// Journal de l'tat, pour une restauration aprs la mort du processus.
+	struct state_journal* journal;
+
+	// Donnes temporaires d'une itration de la boucle, rendues  sa fin.
+	struct frame_arena frameArena;
+
+	// Octets par sous-systme et librateurs appels au-del du budget,  l'arrt et
+	// quand le systme manque de mmoire.
+	struct memory_budget memory;
+
+	// Dernire utilisation publie dans le compteur de trace  memory_kib .
+	size_t tracedMemory;
+
+	// Rejeu d'une trace : lecteur, enregistrement en attente de son chance, vitesse,
+	// dpart et position dans la trace (au plus vite), enregistrements rejous et ignors.
+	struct event_trace_reader* replay;
+	struct event_trace_record* replayRecord;
+	int replayPending;
+	float replaySpeed;
+	int64_t replayStartNs;
+	int64_t replayPositionNs;
+	uint64_t replayFed;
+	uint64_t replaySkipped;
 };
 
+// Le signal peut tre reu par n'importe quel thread : le gestionnaire se contente
+// de signaler cet eventfd, surveill par le looper de android_main().
+static int engine_timing_fd = -1;
+
+static void engine_request_timing(int signal) {
+	int savedErrno = errno;
+	uint64_t value = 1;
+	if (write(engine_timing_fd, &value, sizeof(value)) < 0) {
+		// Demande dj en attente.
+	}
+	errno = savedErrno;
+}
+
 /**
-* Initialisation d'un contexte EGL pour l'affichage en cours.
+* criture des mesures de phases : dans le stockage interne de l'application sur
+* l'appareil, sur la sortie standard sur l'hte.
 */
-static int engine_init_display(struct engine* engine) {
-	// Initialisation d'OpenGL ES et EGL
-
-	/*
-	* Ici, les attributs de la configuration dsire sont spcifis.
-	* Un composant EGLConfig avec au moins 8bits par couleur
-	* compatible avec les fentres  l'cran est slectionn ci-dessous.
-	*/
-	const EGLint attribs[] = {
-		EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
-		EGL_BLUE_SIZE, 8,
-		EGL_GREEN_SIZE, 8,
-		EGL_RED_SIZE, 8,
-		EGL_NONE
-	};
-	EGLint w, h, format;
-	EGLint numConfigs;
-	EGLConfig config;
-	EGLSurface surface;
-	EGLContext context;
+static void engine_dump_timing(struct engine* engine) {
+#ifdef __ANDROID__
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/frame_timing.txt", engine->app->activity->internalDataPath);
+	if (frame_timing_dump(&engine->timing, path) == 0) {
+		LOGI("frame timing written to %s", path);
+	} else {
+		LOGW("Unable to write %s", path);
+	}
+#else
+	frame_timing_dump(&engine->timing, NULL);
+#endif
+	const struct frame_arena_stats* arena = &engine->frameArena.stats;
+	LOGI("frame arena: frames=%llu allocations/frame=%.1f bytes/frame=%.0f peak=%llu overflows=%llu",
+		(unsigned long long)arena->frames,
+		arena->frames > 0 ? arena->allocations / (double)arena->frames : 0.0,
+		arena->frames > 0 ? arena->bytes / (double)arena->frames : 0.0,
+		(unsigned long long)arena->peakBytes, (unsigned long long)arena->overflows);
+	const struct engine_redraw_stats* redraw = &engine->redraw;
+	LOGI("redraw: presented=%llu skipped=%llu idle=%.1f s in %llu waits (%.0f frames not drawn)",
+		(unsigned long long)redraw->presented, (unsigned long long)redraw->skipped,
+		redraw->idleNs / 1e9, (unsigned long long)redraw->idlePeriods,
+		redraw->skipped + redraw->idleNs / (double)engine->pacer.periodNs);
+	const struct resolution_governor* resolution = &engine->resolution;
+	LOGI("resolution: scale=%.0f%% p90=%.2f ms budget=%.2f ms windows=%llu over=%llu lowers=%llu "
+		"raises=%llu thermal_caps=%llu headroom=%.2f", resolution_governor_scale(resolution) * 100.0f,
+		resolution->stats.lastP90Ns / 1e6, resolution->budgetNs / 1e6,
+		(unsigned long long)resolution->stats.windows, (unsigned long long)resolution->stats.overBudget,
+		(unsigned long long)resolution->stats.lowers, (unsigned long long)resolution->stats.raises,
+		(unsigned long long)resolution->stats.thermalCaps, resolution->headroom);
+	memory_budget_log(&engine->memory);
+}
 
-	EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+/**
+* Changement visible : la prochaine image sera dessine. Une boucle qui attend dans
+* le looper est rveille.
+*/
+static void engine_mark_dirty(struct engine* engine, uint32_t reasons) {
+	engine->dirty |= reasons;
+	if (engine->idle) {
+		ALooper_wake(engine->app->looper);
+	}
+}
 
-	eglInitialize(display, 0, 0);
+/**
+* Aspect du repre : rayon selon la densit de l'cran, teinte assombrie en mode nuit.
+*/
+static void engine_update_marker_style(struct engine* engine) {
+	AConfiguration* config = engine->app->config;
+	int32_t density = AConfiguration_getDensity(config);
+	if (density == ACONFIGURATION_DENSITY_DEFAULT || density >= ACONFIGURATION_DENSITY_ANY) {
+		density = ACONFIGURATION_DENSITY_MEDIUM;
+	}
+	int night = AConfiguration_getUiModeNight(config) == ACONFIGURATION_UI_MODE_NIGHT_YES;
+	__atomic_store_n(&engine->markerRadius, ENGINE_MARKER_RADIUS_DP * density / ACONFIGURATION_DENSITY_MEDIUM,
+		__ATOMIC_RELAXED);
+	__atomic_store_n(&engine->markerColor, night ? ENGINE_MARKER_NIGHT_COLOR : 0xffffffffu, __ATOMIC_RELAXED);
+}
 
-	/* Ici, l'application choisit la configuration dsire. Cet
-	* exemple illustre un processus de slection trs simplifi dans lequel le premier EGLConfig
-	* correspondant aux critres est slectionn. */
-	eglChooseConfig(display, attribs, &config, 1, &numConfigs);
+/**
+* Abonn aux changements de densit et de mode nuit : seul le repre change. La
+* rotation et la taille de l'cran n'ont pas d'abonn ; la fentre redimensionne
+* (APP_CMD_WINDOW_RESIZED) garde sa surface et le contexte.
+*/
+static void engine_config_changed(struct android_app* app, int32_t changes, void* userData) {
+	struct engine* engine = (struct engine*)userData;
+	engine_update_marker_style(engine);
+	engine_mark_dirty(engine, ENGINE_DIRTY_CONTENT);
+}
 
-	/* EGL_NATIVE_VISUAL_ID est un attribut d'EGLConfig dont
-	* l'acceptation par ANativeWindow_setBuffersGeometry() est garantie.
-	* Ds qu'un EGLConfig est choisi, il est possible de reconfigurer en toute scurit les
-	* mmoires tampons ANativeWindow pour les faire correspondre  l'aide d'EGL_NATIVE_VISUAL_ID. */
-	eglGetConfigAttrib(display, config, EGL_NATIVE_VISUAL_ID, &format);
+/**
+* Activit de l'utilisateur : l'animation de couleur reprend pour ENGINE_ANIMATION_IDLE_NS.
+*/
+static void engine_extend_animation(struct engine* engine) {
+	engine->animateUntil = frame_timing_now() + ENGINE_ANIMATION_IDLE_NS;
+	engine_mark_dirty(engine, ENGINE_DIRTY_STATE);
+}
 
-	ANativeWindow_setBuffersGeometry(engine->app->window, 0, 0, format);
+/**
+* Mouvement de l'appareil : variation de plus de ENGINE_MOTION_THRESHOLD sur un axe
+* depuis le mouvement prcdent.
+*/
+static void engine_note_motion(struct engine* engine, const struct sensor_sample* sample) {
+	const struct sensor_sample* reference = &engine->motionReference;
+	if (fabsf(sample->x - reference->x) > ENGINE_MOTION_THRESHOLD
+		|| fabsf(sample->y - reference->y) > ENGINE_MOTION_THRESHOLD
+		|| fabsf(sample->z - reference->z) > ENGINE_MOTION_THRESHOLD) {
+		engine->motionReference = *sample;
+		engine_extend_animation(engine);
+	}
+}
 
-	surface = eglCreateWindowSurface(display, config, engine->app->window, NULL);
-	context = eglCreateContext(display, config, NULL, NULL);
+/**
+* Rien  dessiner ni  animer : la boucle attend dans le looper sans dlai. La file
+* d'entre reste attache pour que le premier vnement la rveille, et
+* l'acclromtre est regroup par la FIFO matrielle comme pour un cran statique ;
+* ses lots ne mettent fin  l'attente que si l'appareil a boug.
+*/
+static void engine_idle_begin(struct engine* engine) {
+	engine->idle = 1;
+	engine->idleSince = frame_timing_now();
+	engine->redraw.idlePeriods++;
+	engine->input.deferred = 0;
+	sensor_pipeline_set_static(&engine->sensors, 1);
+}
 
-	if (eglMakeCurrent(display, surface, surface, context) == EGL_FALSE) {
-		LOGW("Unable to eglMakeCurrent");
-		return -1;
+static void engine_idle_end(struct engine* engine) {
+	if (!engine->idle) {
+		return;
 	}
+	engine->idle = 0;
+	engine->redraw.idleNs += frame_timing_now() - engine->idleSince;
+	sensor_pipeline_set_static(&engine->sensors, 0);
+	// La phase des images d'avant l'attente n'a plus cours.
+	frame_pacer_reset(&engine->pacer);
+}
 
-	eglQuerySurface(display, surface, EGL_WIDTH, &w);
-	eglQuerySurface(display, surface, EGL_HEIGHT, &h);
+/**
+* Initialisation de l'tat GL d'un nouveau contexte : moteur de sprites et image du
+* repre de toucher, un disque blanc au bord adouci. Les objets d'un contexte perdu
+* n'existent plus, seule la mmoire de l'ancien moteur est libre.
+*/
+static void engine_init_gl(struct engine* engine) {
+	sprite_batch_abandon(engine->sprites);
+	engine->sprites = sprite_batch_create(ENGINE_MARKER_TEXELS, ENGINE_MARKER_TEXELS, 1, 0);
+	if (engine->sprites == NULL) {
+		LOGW("Unable to create the sprite batch");
+		return;
+	}
+	uint32_t pixels[ENGINE_MARKER_TEXELS * ENGINE_MARKER_TEXELS];
+	const float center = ENGINE_MARKER_TEXELS / 2.0f;
+	for (int y = 0; y < ENGINE_MARKER_TEXELS; y++) {
+		for (int x = 0; x < ENGINE_MARKER_TEXELS; x++) {
+			float dx = x + 0.5f - center;
+			float dy = y + 0.5f - center;
+			float coverage = center - sqrtf(dx * dx + dy * dy);
+			uint32_t alpha = coverage >= 1.0f ? 255 : coverage <= 0.0f ? 0 : (uint32_t)(coverage * 255.0f);
+			pixels[y * ENGINE_MARKER_TEXELS + x] = 0x00ffffffu | alpha << 24;
+		}
+	}
+	sprite_batch_upload(engine->sprites, 0, pixels);
+	engine->markerUploaded = NULL;
+	struct sprite_batch_stats stats;
+	sprite_batch_get_stats(engine->sprites, &stats);
+	memory_budget_set(&engine->memory, MEMORY_BUDGET_TEXTURES, stats.textureBytes + stats.bufferBytes);
+}
 
-	engine->display = display;
-	engine->context = context;
-	engine->surface = surface;
-	engine->width = w;
-	engine->height = h;
-	engine->state.angle = 0;
+/**
+* Chargement de l'image du repre de l'APK dans le contexte, ds qu'elle est publie.
+*/
+static void engine_upload_marker(struct engine* engine) {
+	const struct asset_stream_asset* marker = __atomic_load_n(&engine->marker, __ATOMIC_ACQUIRE);
+	if (marker != NULL && marker != engine->markerUploaded && engine->sprites != NULL) {
+		sprite_batch_upload(engine->sprites, 0, (const uint32_t*)marker->data);
+		engine->markerUploaded = marker;
+	}
+}
+
+/**
+* Fin du chargement de l'image du repre, sur le looper d'android_main(). La
+* ressource reste retenue jusqu' la fin d'android_main() : le thread de rendu la
+* lit sans copie.
+*/
+static void engine_marker_loaded(void* userData, int32_t id, int status,
+	const struct asset_stream_asset* asset) {
+	struct engine* engine = (struct engine*)userData;
+	if (status != ASSET_STREAM_OK) {
+		return;
+	}
+	if (asset->size != ENGINE_MARKER_TEXELS * ENGINE_MARKER_TEXELS * sizeof(uint32_t)) {
+		LOGW("Ignoring %s: %zu bytes", asset->path, asset->size);
+		asset_stream_release(engine->assets, asset);
+		return;
+	}
+	__atomic_store_n(&engine->marker, asset, __ATOMIC_RELEASE);
+	engine_mark_dirty(engine, ENGINE_DIRTY_CONTENT);
+}
+
+/**
+* Tampons de la fentre  l'chelle choisie par le rgulateur, agrandis par le
+* compositeur ;  l'chelle 1, la gomtrie par dfaut.
+*/
+static void engine_apply_render_scale(struct engine* engine) {
+	ANativeWindow* window = engine->app->window;
+	if (window == NULL) {
+		return;
+	}
+	float scale = resolution_governor_scale(&engine->resolution);
+	SYS_TRACE_COUNTER("render_scale_pct", (int64_t)(scale * 100.0f + 0.5f));
+	int32_t width = 0;
+	int32_t height = 0;
+	if (scale < 1.0f) {
+		width = (int32_t)(engine->width * scale + 0.5f);
+		height = (int32_t)(engine->height * scale + 0.5f);
+		if (width < 1) width = 1;
+		if (height < 1) height = 1;
+	}
+	int32_t format = engine->raster != NULL ? WINDOW_FORMAT_RGBX_8888 : engine->egl.format;
+	if (ANativeWindow_setBuffersGeometry(window, width, height, format) != 0) {
+		LOGW("Unable to scale the window buffers");
+		return;
+	}
+	engine->renderScaleChanged = 1;
+}
 
-	// Initialisation de l'tat GL.
-	glHint(GL_PERSPECTIVE_CORRECTION_HINT, GL_FASTEST);
-	glEnable(GL_CULL_FACE);
-	glShadeModel(GL_SMOOTH);
-	glDisable(GL_DEPTH_TEST);
+/**
+* Taille de la fentre, lue avec la gomtrie par dfaut des tampons, puis retour 
+* l'chelle courante. Les dures mesures avant le changement de fentre sont oublies.
+*/
+static void engine_read_window_size(struct engine* engine, int32_t format) {
+	ANativeWindow* window = engine->app->window;
+	ANativeWindow_setBuffersGeometry(window, 0, 0, format);
+	engine->width = ANativeWindow_getWidth(window);
+	engine->height = ANativeWindow_getHeight(window);
+	if (resolution_governor_scale(&engine->resolution) < 1.0f) {
+		engine_apply_render_scale(engine);
+	}
+	resolution_governor_reset(&engine->resolution);
+}
+
+/**
+* Dure d'une image donne au rgulateur, qui peut changer l'chelle des tampons.
+*/
+static void engine_govern_resolution(struct engine* engine, int64_t frameStart) {
+	int64_t now = frame_timing_now();
+	if (resolution_governor_frame(&engine->resolution, now - frameStart, now)) {
+		engine_apply_render_scale(engine);
+	}
+}
 
+/**
+* Rendu logiciel dans les tampons de la fentre, au format RGBX_8888.
+*/
+static int engine_init_raster(struct engine* engine) {
+	ANativeWindow* window = engine->app->window;
+	if (ANativeWindow_setBuffersGeometry(window, 0, 0, WINDOW_FORMAT_RGBX_8888) != 0) {
+		LOGW("Unable to set the window buffers geometry");
+		return -1;
+	}
+	if (engine->raster == NULL) {
+		engine->raster = soft_raster_create(0);
+	}
+	if (engine->raster == NULL) {
+		LOGW("Unable to create the software rasterizer");
+		return -1;
+	}
+	engine_read_window_size(engine, WINDOW_FORMAT_RGBX_8888);
+	engine->state.angle = 0;
 	return 0;
 }
 
 /**
-* Uniquement l'image actuelle dans l'affichage.
+* Initialisation de l'affichage : EGL si ENGINE_RENDER_BACKEND le permet, le
+* rendu logiciel sinon ou si EGL choue. Aprs la premire fentre, l'affichage et
+* le contexte EGL sont repris : seule la surface de la fentre est cre.
 */
-static void engine_draw_frame(struct engine* engine) {
-	if (engine->display == NULL) {
+static int engine_init_display(struct engine* engine) {
+	if (ENGINE_RENDER_BACKEND == 0 && engine->raster == NULL) {
+		int result = display_manager_attach(&engine->egl, engine->app->window);
+		if (result >= 0) {
+			if (result == DISPLAY_MANAGER_NEW_CONTEXT) {
+				engine_init_gl(engine);
+			}
+			// display_manager_attach() vient de rtablir la gomtrie par dfaut.
+			engine->width = engine->egl.width;
+			engine->height = engine->egl.height;
+			if (resolution_governor_scale(&engine->resolution) < 1.0f) {
+				engine_apply_render_scale(engine);
+			}
+			resolution_governor_reset(&engine->resolution);
+			engine->state.angle = 0;
+			LOGI("display %s in %.2f ms", result == DISPLAY_MANAGER_NEW_CONTEXT ? "created" : "resumed",
+				engine->egl.stats.lastAttachNs / 1e6);
+			return 0;
+		}
+		LOGW("EGL unavailable, falling back to software rendering");
+	}
+	return engine_init_raster(engine);
+}
+
+/**
+* Composante de couleur d'un tampon, comme glClearColor() la ramne dans [0, 1].
+*/
+static uint32_t engine_color_channel(float value) {
+	if (!(value > 0.0f)) {
+		return 0;
+	}
+	return value >= 1.0f ? 255 : (uint32_t)(value * 255.0f + 0.5f);
+}
+
+/**
+* Dessin logiciel d'un tat : la fentre est verrouille le temps du dessin puis
+* prsente.
+*/
+static void engine_draw_raster(struct engine* engine, const struct saved_state* state) {
+	ANativeWindow* window = engine->app->window;
+	SYS_TRACE_BEGIN("draw");
+	int64_t t = frame_timing_now();
+	ANativeWindow_Buffer buffer;
+	if (ANativeWindow_lock(window, &buffer, NULL) != 0) {
+		SYS_TRACE_END();
+		LOGW("Unable to lock the window");
+		return;
+	}
+	struct soft_raster_target target = {
+		(uint32_t*)buffer.bits, buffer.width, buffer.height, buffer.stride
+	};
+	soft_raster_begin(engine->raster, &target);
+	soft_raster_clear(engine->raster, SOFT_RASTER_RGBA(
+		engine_color_channel(((float)state->x) / engine->width),
+		engine_color_channel(state->angle),
+		engine_color_channel(((float)state->y) / engine->height), 255));
+	soft_raster_end(engine->raster);
+	t = frame_timing_end(&engine->timing, FRAME_PHASE_DRAW, t);
+	SYS_TRACE_END();
+
+	SYS_TRACE_BEGIN("swap");
+	ANativeWindow_unlockAndPost(window);
+	frame_timing_end(&engine->timing, FRAME_PHASE_SWAP, t);
+	SYS_TRACE_END();
+}
+
+/**
+* Dessin d'un tat dans l'affichage, par le thread propritaire du contexte EGL.
+*/
+static void engine_draw_state(struct engine* engine, const struct saved_state* state) {
+	int64_t frameStart = frame_timing_now();
+	if (engine->raster != NULL) {
+		engine_draw_raster(engine, state);
+		engine_govern_resolution(engine, frameStart);
+		return;
+	}
+	if (!display_manager_ready(&engine->egl)) {
 		// Aucun affichage.
 		return;
 	}
 
 	// Remplissage de l'cran avec simplement une couleur.
-	glClearColor(((float)engine->state.x) / engine->width, engine->state.angle,
-		((float)engine->state.y) / engine->height, 1);
+	SYS_TRACE_BEGIN("draw");
+	int64_t t = frame_timing_now();
+	glClearColor(((float)state->x) / engine->width, state->angle,
+		((float)state->y) / engine->height, 1);
 	glClear(GL_COLOR_BUFFER_BIT);
+	if (engine->sprites != NULL) {
+		engine_upload_marker(engine);
+		// Repre du dernier toucher, les coordonnes de la fentre ramenes  celles des tampons.
+		float scale = engine->width > 0 ? engine->egl.width / (float)engine->width : 1.0f;
+		float radius = (float)__atomic_load_n(&engine->markerRadius, __ATOMIC_RELAXED);
+		const struct sprite_batch_sprite marker = {
+			(state->x - radius) * scale, (state->y - radius) * scale,
+			2.0f * radius * scale, 2.0f * radius * scale,
+			0.0f, 0.0f, 1.0f, 1.0f, __atomic_load_n(&engine->markerColor, __ATOMIC_RELAXED), 0
+		};
+		sprite_batch_begin(engine->sprites, engine->egl.width, engine->egl.height);
+		sprite_batch_add(engine->sprites, &marker);
+		sprite_batch_end(engine->sprites);
+	}
+	t = frame_timing_end(&engine->timing, FRAME_PHASE_DRAW, t);
+	SYS_TRACE_END();
 
-	eglSwapBuffers(engine->display, engine->surface);
+	SYS_TRACE_BEGIN("swap");
+	if (display_manager_swap(&engine->egl) == DISPLAY_MANAGER_NEW_CONTEXT) {
+		// Contexte perdu puis recr.
+		engine_init_gl(engine);
+	}
+	if (engine->renderScaleChanged) {
+		engine->renderScaleChanged = 0;
+		display_manager_resize(&engine->egl);
+	}
+	frame_timing_end(&engine->timing, FRAME_PHASE_SWAP, t);
+	SYS_TRACE_END();
+	engine_govern_resolution(engine, frameStart);
 }
 
 /**
-* Destruction du contexte EGL actuellement associ  l'affichage.
+* Perte de la fentre : seule la surface EGL est dtruite, le contexte et le rendu
+* logiciel sont gards pour la fentre suivante.
 */
 static void engine_term_display(struct engine* engine) {
-	if (engine->display != EGL_NO_DISPLAY) {
-		eglMakeCurrent(engine->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
-		if (engine->context != EGL_NO_CONTEXT) {
-			eglDestroyContext(engine->display, engine->context);
+	display_manager_detach(&engine->egl);
+	engine->animating = 0;
+}
+
+/**
+* Nouvelle taille de la fentre, sans recrer la surface.
+*/
+static void engine_resize_display(struct engine* engine) {
+	if (display_manager_ready(&engine->egl)) {
+		engine_read_window_size(engine, engine->egl.format);
+		display_manager_resize(&engine->egl);
+	} else if (engine->raster != NULL && engine->app->window != NULL) {
+		engine_read_window_size(engine, WINDOW_FORMAT_RGBX_8888);
+	}
+}
+
+/**
+* Libration complte de l'affichage,  la fin d'android_main() ou sans fentre quand
+* le systme manque de mmoire ; la fentre suivante cre un nouveau contexte.
+*/
+static void engine_release_display(struct engine* engine) {
+	// Les objets GL disparaissent avec le contexte.
+	sprite_batch_abandon(engine->sprites);
+	engine->sprites = NULL;
+	display_manager_term(&engine->egl);
+	soft_raster_destroy(engine->raster);
+	engine->raster = NULL;
+	memory_budget_set(&engine->memory, MEMORY_BUDGET_TEXTURES, 0);
+}
+
+/**
+* Excution d'une demande d'affichage par le thread propritaire du contexte EGL.
+*/
+static void engine_display_run(struct engine* engine, int request) {
+	switch (request) {
+	case ENGINE_RENDER_INIT:
+		engine_init_display(engine);
+		break;
+	case ENGINE_RENDER_TERM:
+		engine_term_display(engine);
+		break;
+	case ENGINE_RENDER_RESIZE:
+		engine_resize_display(engine);
+		break;
+	case ENGINE_RENDER_REDRAW:
+		// android_main() attend : son tat est lu directement.
+		engine_draw_state(engine, &engine->state);
+		break;
+	case ENGINE_RENDER_RELEASE:
+	case ENGINE_RENDER_EXIT:
+		engine_release_display(engine);
+		break;
+	}
+}
+
+/**
+* Boucle du thread de rendu.
+*/
+static void* engine_render_main(void* param) {
+	struct engine* engine = (struct engine*)param;
+	struct engine_renderer* renderer = &engine->renderer;
+
+	pthread_mutex_lock(&renderer->mutex);
+	for (;;) {
+		__atomic_store_n(&renderer->waiting, 1, __ATOMIC_SEQ_CST);
+		while (renderer->request == ENGINE_RENDER_NONE
+			&& !__atomic_load_n(&renderer->framePending, __ATOMIC_SEQ_CST)) {
+			pthread_cond_wait(&renderer->cond, &renderer->mutex);
+		}
+		__atomic_store_n(&renderer->waiting, 0, __ATOMIC_SEQ_CST);
+
+		int request = renderer->request;
+		if (request != ENGINE_RENDER_NONE) {
+			// android_main() attend la fin de la demande : l'tat du moteur peut tre modifi.
+			pthread_mutex_unlock(&renderer->mutex);
+			engine_display_run(engine, request);
+			pthread_mutex_lock(&renderer->mutex);
+			renderer->request = ENGINE_RENDER_NONE;
+			pthread_cond_broadcast(&renderer->cond);
+			if (request == ENGINE_RENDER_EXIT) {
+				break;
+			}
+			continue;
 		}
-		if (engine->surface != EGL_NO_SURFACE) {
-			eglDestroySurface(engine->display, engine->surface);
+
+		__atomic_store_n(&renderer->framePending, 0, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(&renderer->mutex);
+		int fresh;
+		const struct engine_snapshot* snapshot =
+			(const struct engine_snapshot*)triple_buffer_front(&renderer->snapshots, &fresh);
+		if (fresh) {
+			engine_draw_state(engine, &snapshot->state);
+			__atomic_fetch_add(&renderer->drawn, 1, __ATOMIC_RELAXED);
 		}
-		eglTerminate(engine->display);
+		pthread_mutex_lock(&renderer->mutex);
 	}
-	engine->animating = 0;
-	engine->display = EGL_NO_DISPLAY;
-	engine->context = EGL_NO_CONTEXT;
-	engine->surface = EGL_NO_SURFACE;
+	pthread_mutex_unlock(&renderer->mutex);
+	return NULL;
 }
 
 /**
-* Traitement de l'vnement d'entre suivant.
+* Envoi d'une demande au thread de rendu et attente de son excution.
 */
-static int32_t engine_handle_input(struct android_app* app, AInputEvent* event) {
-	struct engine* engine = (struct engine*)app->userData;
-	if (AInputEvent_getType(event) == AINPUT_EVENT_TYPE_MOTION) {
-		engine->state.x = AMotionEvent_getX(event, 0);
-		engine->state.y = AMotionEvent_getY(event, 0);
-		return 1;
+static void engine_render_request(struct engine* engine, int request) {
+	struct engine_renderer* renderer = &engine->renderer;
+	pthread_mutex_lock(&renderer->mutex);
+	renderer->request = request;
+	pthread_cond_broadcast(&renderer->cond);
+	while (renderer->request != ENGINE_RENDER_NONE) {
+		pthread_cond_wait(&renderer->cond, &renderer->mutex);
+	}
+	pthread_mutex_unlock(&renderer->mutex);
+}
+
+static void engine_render_start(struct engine* engine) {
+	struct engine_renderer* renderer = &engine->renderer;
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	renderer->threaded = ENGINE_RENDER_THREAD == 2 || (ENGINE_RENDER_THREAD == 1 && cores > 1);
+	if (!renderer->threaded) {
+		return;
 	}
+
+	pthread_mutex_init(&renderer->mutex, NULL);
+	pthread_cond_init(&renderer->cond, NULL);
+	triple_buffer_init(&renderer->snapshots, renderer->slots, sizeof(renderer->slots[0]));
+	if (pthread_create(&renderer->thread, NULL, engine_render_main, engine) != 0) {
+		LOGW("Unable to start the render thread, rendering on the main thread");
+		pthread_cond_destroy(&renderer->cond);
+		pthread_mutex_destroy(&renderer->mutex);
+		renderer->threaded = 0;
+	}
+}
+
+static void engine_render_stop(struct engine* engine) {
+	struct engine_renderer* renderer = &engine->renderer;
+	if (!renderer->threaded) {
+		engine_release_display(engine);
+		return;
+	}
+	engine_render_request(engine, ENGINE_RENDER_EXIT);
+	pthread_join(renderer->thread, NULL);
+	pthread_cond_destroy(&renderer->cond);
+	pthread_mutex_destroy(&renderer->mutex);
+	renderer->threaded = 0;
+	LOGI("render thread: published=%llu dropped=%llu drawn=%llu",
+		(unsigned long long)renderer->published, (unsigned long long)renderer->dropped,
+		(unsigned long long)renderer->drawn);
+}
+
+/**
+* Uniquement l'image actuelle dans l'affichage. Avec un thread de rendu, l'tat est
+* publi sans attendre le dessin.
+*/
+static void engine_draw_frame(struct engine* engine) {
+	struct engine_renderer* renderer = &engine->renderer;
+	engine->redraw.presented++;
+	engine->dirty = 0;
+	if (!renderer->threaded) {
+		engine_draw_state(engine, &engine->state);
+		return;
+	}
+
+	struct engine_snapshot* snapshot =
+		(struct engine_snapshot*)triple_buffer_back(&renderer->snapshots);
+	snapshot->state = engine->state;
+	snapshot->frame = ++renderer->published;
+	if (triple_buffer_publish(&renderer->snapshots)) {
+		renderer->dropped++;
+	}
+
+	// Le verrou n'est pris que si le thread de rendu est en attente.
+	__atomic_store_n(&renderer->framePending, 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&renderer->waiting, __ATOMIC_SEQ_CST)) {
+		pthread_mutex_lock(&renderer->mutex);
+		pthread_cond_broadcast(&renderer->cond);
+		pthread_mutex_unlock(&renderer->mutex);
+	}
+}
+
+/**
+* Demande d'affichage (INIT, TERM, RESIZE) excute par le thread propritaire du
+* contexte EGL.
+*/
+static void engine_display_request(struct engine* engine, int request) {
+	if (engine->renderer.threaded) {
+		engine_render_request(engine, request);
+	} else {
+		engine_display_run(engine, request);
+	}
+}
+
+/**
+* Librateurs de mmoire, appels par android_main(). Le cache de ressources ne garde
+* que ce qui n'est pas demand ; l'image du repre reste retenue.
+*/
+static size_t engine_evict_assets(void* userData, size_t targetBytes) {
+	struct engine* engine = (struct engine*)userData;
+	if (engine->assets == NULL) {
+		return 0;
+	}
+	struct asset_stream_stats stats;
+	asset_stream_get_stats(engine->assets, &stats);
+	size_t keep = targetBytes < stats.residentBytes ? (size_t)stats.residentBytes - targetBytes : 0;
+	size_t freed = asset_stream_trim(engine->assets, keep);
+	memory_budget_add(&engine->memory, MEMORY_BUDGET_ASSETS, -(ptrdiff_t)freed);
+	return freed;
+}
+
+static size_t engine_evict_state_pool(void* userData, size_t targetBytes) {
+	struct engine* engine = (struct engine*)userData;
+	struct state_pool_stats before;
+	struct state_pool_stats after;
+	state_pool_get_stats(&before);
+	state_pool_trim();
+	state_pool_get_stats(&after);
+	size_t freed = (size_t)(before.bytes - after.bytes);
+	memory_budget_add(&engine->memory, MEMORY_BUDGET_POOLS, -(ptrdiff_t)freed);
+	return freed;
+}
+
+/**
+* L'arne agrandie par les images reprend sa taille initiale ; elle grandira de
+* nouveau  la reprise si ncessaire. Appel entre deux itrations, arne vide.
+*/
+static size_t engine_evict_frame_arena(void* userData, size_t targetBytes) {
+	struct engine* engine = (struct engine*)userData;
+	struct frame_arena* arena = &engine->frameArena;
+	if (arena->capacity <= ENGINE_FRAME_ARENA_BYTES || arena->used != 0 || arena->overflow != NULL) {
+		return 0;
+	}
+	size_t capacity = arena->capacity;
+	struct frame_arena_stats stats = arena->stats;
+	frame_arena_destroy(arena);
+	if (frame_arena_init(arena, ENGINE_FRAME_ARENA_BYTES) != 0) {
+		LOGW("Unable to allocate the frame arena");
+	}
+	arena->stats = stats;
+	size_t freed = capacity - arena->capacity;
+	memory_budget_add(&engine->memory, MEMORY_BUDGET_POOLS, -(ptrdiff_t)freed);
+	return freed;
+}
+
+/**
+* Sans fentre seulement : le contexte EGL, ses textures et le rendu logiciel sont
+* librs. La fentre suivante cote une cration de contexte au lieu d'une reprise.
+*/
+static size_t engine_evict_display(void* userData, size_t targetBytes) {
+	struct engine* engine = (struct engine*)userData;
+	if (engine->app->window != NULL
+		|| (engine->egl.context == EGL_NO_CONTEXT && engine->egl.display == EGL_NO_DISPLAY
+			&& engine->raster == NULL)) {
+		return 0;
+	}
+	size_t bytes = memory_budget_get(&engine->memory, MEMORY_BUDGET_TEXTURES);
+	engine_display_request(engine, ENGINE_RENDER_RELEASE);
+	LOGI("display released without a window");
+	return bytes;
+}
+
+/**
+* Export des tranches de trace de tous les threads.
+*/
+static void engine_export_spans(struct engine* engine) {
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/%s", engine->app->activity->internalDataPath, ENGINE_SPANS_FILE);
+	sys_trace_export_json(path);
+}
+
+/**
+* Octets des sous-systmes qui ne les comptent pas eux-mmes, relevs  chaque itration.
+*/
+static void engine_update_memory(struct engine* engine) {
+	if (engine->assets != NULL) {
+		struct asset_stream_stats assets;
+		asset_stream_get_stats(engine->assets, &assets);
+		memory_budget_set(&engine->memory, MEMORY_BUDGET_ASSETS, (size_t)assets.residentBytes);
+	}
+	struct state_pool_stats pool;
+	state_pool_get_stats(&pool);
+	memory_budget_set(&engine->memory, MEMORY_BUDGET_POOLS, (size_t)pool.bytes + engine->frameArena.capacity);
+	size_t total = memory_budget_total(&engine->memory);
+	if (total != engine->tracedMemory) {
+		engine->tracedMemory = total;
+		SYS_TRACE_COUNTER("memory_kib", (int64_t)(total >> 10));
+	}
+}
+
+/**
+* Traitement de l'vnement d'entre suivant. Les mouvements sont regroups par
+* l'tage d'entre : seuls les touches et les autres vnements arrivent ici, et
+* restent confis  la distribution par dfaut.
+*/
+static int32_t engine_handle_input(struct android_app* app, AInputEvent* event) {
 	return 0;
 }
 
 /**
-* Traitement de la commande principale suivante.
+* Planificateur : l'instant du premier vnement du lot mesure la latence des entres.
 */
-static void engine_handle_cmd(struct android_app* app, int32_t cmd) {
-	struct engine* engine = (struct engine*)app->userData;
-	switch (cmd) {
-	case APP_CMD_SAVE_STATE:
-		// Le systme demande d'enregistrer l'tat actuel. Cette opration est effectue.
-		engine->app->savedState = malloc(sizeof(struct saved_state));
-		*((struct saved_state*)engine->app->savedState) = engine->state;
-		engine->app->savedStateSize = sizeof(struct saved_state);
-		break;
+static void engine_pacer_on_input(struct engine* engine, const struct event_bus_input* event) {
+	if (engine->animating) {
+		frame_pacer_note_input(&engine->pacer, event->batch->firstEventTime);
+	}
+}
+
+/**
+* Repre du toucher : le dessin n'utilise que la position la plus rcente du premier pointeur.
+*/
+static void engine_marker_on_input(struct engine* engine, const struct event_bus_input* event) {
+	const struct input_batch* batch = event->batch;
+	for (size_t i = batch->count; i-- > 0;) {
+		if (batch->flags[i] & INPUT_STAGE_PRIMARY) {
+			if (batch->x[i] != engine->state.x || batch->y[i] != engine->state.y) {
+				engine->state.x = batch->x[i];
+				engine->state.y = batch->y[i];
+				engine_extend_animation(engine);
+				const int32_t position[2] = { engine->state.x, engine->state.y };
+				if (engine->journal != NULL) {
+					state_journal_append(engine->journal, ENGINE_STATE_POSITION, STATE_FIELD_I32,
+						position, 2);
+				}
+			}
+			break;
+		}
+	}
+}
+
+typedef event_bus<struct engine, struct event_bus_input,
+	EVENT_BUS_HANDLER(EVENT_BUS_KEY(EVENT_BUS_INPUT_BATCH), engine_pacer_on_input),
+	EVENT_BUS_HANDLER(EVENT_BUS_KEY(EVENT_BUS_INPUT_BATCH), engine_marker_on_input)> engine_input_bus;
+
+/**
+* Application du lot d'entres accumul depuis l'image prcdente.
+*/
+static void engine_apply_input(struct engine* engine) {
+	android_app_latch_input(engine->app);
+	const struct input_batch* batch = input_stage_swap(&engine->input);
+	if (batch->events == 0) {
+		return;
+	}
+	const struct event_bus_input event = { EVENT_BUS_INPUT_BATCH, batch };
+	engine_input_bus::dispatch_key<EVENT_BUS_INPUT_BATCH>(engine, &event);
+}
+
+/**
+* Dmarrage de l'enregistrement ou du rejeu des vnements si son fichier de commande
+* existe ; le rejeu l'emporte.
+*/
+static void engine_start_events(struct engine* engine) {
+	const char* directory = engine->app->activity->internalDataPath;
+	char path[PATH_MAX];
+	char tracePath[PATH_MAX];
+	snprintf(tracePath, sizeof(tracePath), "%s/%s", directory, ENGINE_TRACE_FILE);
+
+	snprintf(path, sizeof(path), "%s/%s", directory, ENGINE_REPLAY_TRIGGER);
+	FILE* trigger = fopen(path, "r");
+	if (trigger != NULL) {
+		float speed = 1.0f;
+		if (fscanf(trigger, "%f", &speed) != 1 || speed < 0.0f) {
+			speed = 1.0f;
+		}
+		fclose(trigger);
+		engine->replay = event_trace_open(tracePath);
+		engine->replayRecord = (struct event_trace_record*)malloc(sizeof(struct event_trace_record));
+		if (engine->replay == NULL || engine->replayRecord == NULL) {
+			LOGW("Unable to replay %s", tracePath);
+			event_trace_reader_close(engine->replay);
+			free(engine->replayRecord);
+			engine->replay = NULL;
+			engine->replayRecord = NULL;
+			return;
+		}
+		engine->replaySpeed = speed;
+		engine->replayStartNs = frame_timing_now();
+		LOGI("replaying %s at speed %.2f", tracePath, speed);
+		return;
+	}
+
+	snprintf(path, sizeof(path), "%s/%s", directory, ENGINE_RECORD_TRIGGER);
+	if (access(path, F_OK) == 0) {
+		if (android_app_start_recording(engine->app, tracePath) == 0) {
+			engine->sensors.trace = engine->app->trace;
+		} else {
+			LOGW("Unable to record %s", tracePath);
+		}
+	}
+}
+
+static void engine_stop_replay(struct engine* engine) {
+	LOGI("replay ended: fed=%llu skipped=%llu in %.3f s", (unsigned long long)engine->replayFed,
+		(unsigned long long)engine->replaySkipped, (frame_timing_now() - engine->replayStartNs) / 1e9);
+	event_trace_reader_close(engine->replay);
+	free(engine->replayRecord);
+	engine->replay = NULL;
+	engine->replayRecord = NULL;
+}
+
+/**
+* Dlai avant l'chance du prochain enregistrement rejou, born par timeout.
+*/
+static int engine_replay_timeout(struct engine* engine, int timeout) {
+	if (engine->replaySpeed <= 0.0f || !engine->replayPending) {
+		return 0;
+	}
+	int64_t due = event_trace_due_ns(engine->replayStartNs, engine->replayRecord->timeNs,
+		engine->replaySpeed);
+	int64_t delay = (due - frame_timing_now() + 999999) / 1000000;
+	if (delay < 0) delay = 0;
+	return timeout < 0 || delay < timeout ? (int)delay : timeout;
+}
+
+/**
+* Rejeu des enregistrements chus, par les mmes points d'entre que les vnements
+* rels : tage d'entre et chane du capteur. Le cycle de vie et la configuration
+* appartiennent au systme sur l'appareil ; ces enregistrements, et les touches que
+* le moteur ne traite pas, sont ignors.
+*/
+static void engine_replay(struct engine* engine) {
+	struct event_trace_record* record = engine->replayRecord;
+	int64_t now = frame_timing_now();
+	// Au plus vite : une priode d'image de la trace par itration.
+	engine->replayPositionNs += engine->pacer.periodNs;
+	int input = 0;
+	for (;;) {
+		if (!engine->replayPending) {
+			int result = event_trace_next(engine->replay, record);
+			if (result <= 0) {
+				if (result < 0) {
+					LOGW("Replay stopped on a truncated trace");
+				}
+				engine_stop_replay(engine);
+				break;
+			}
+			engine->replayPending = 1;
+		}
+		if (engine->replaySpeed > 0.0f ? event_trace_due_ns(engine->replayStartNs, record->timeNs,
+				engine->replaySpeed) > now : record->timeNs > engine->replayPositionNs) {
+			break;
+		}
+		engine->replayPending = 0;
+
+		// Les instants des vnements sont dcals comme l'enregistrement lui-mme.
+		int64_t shift = now - (event_trace_start_ns(engine->replay) + record->timeNs);
+		switch (record->type) {
+		case EVENT_TRACE_MOTION:
+			for (uint32_t i = 0; i < record->motion.sampleCount; i++) {
+				record->motion.eventTime[i] += shift;
+			}
+			input_stage_add_motion(&engine->input, &record->motion);
+			input = 1;
+			break;
+		case EVENT_TRACE_SENSOR: {
+			ASensorEvent* events = engine->sensors.batch;
+			for (uint32_t i = 0; i < record->sensorCount; i++) {
+				memset(&events[i], 0, sizeof(events[i]));
+				events[i].version = sizeof(ASensorEvent);
+				events[i].type = record->sensors[i].type;
+				events[i].timestamp = record->sensors[i].timestamp;
+				memcpy(events[i].data, record->sensors[i].values, sizeof(record->sensors[i].values));
+			}
+			sensor_pipeline_feed(&engine->sensors, events, record->sensorCount);
+			break;
+		}
+		default:
+			engine->replaySkipped++;
+			continue;
+		}
+		engine->replayFed++;
+	}
+	if (input) {
+		engine_idle_end(engine);
+		if (!engine->animating) {
+			engine_apply_input(engine);
+		}
+	}
+}
+
+/**
+* criture de l'tat dans un bloc de la rserve, remis au systme par le code de collage.
+*/
+static void engine_save_state(struct engine* engine) {
+	struct state_snapshot_writer writer;
+	if (state_snapshot_begin(&writer, ENGINE_STATE_SCHEMA, ENGINE_STATE_FIELD_COUNT,
+		STATE_SNAPSHOT_SPACE(sizeof(float)) + STATE_SNAPSHOT_SPACE(2 * sizeof(int32_t))) != 0) {
+		LOGW("Unable to allocate saved state");
+		return;
+	}
+	const int32_t position[2] = { engine->state.x, engine->state.y };
+	state_snapshot_put(&writer, ENGINE_STATE_ANGLE, STATE_FIELD_F32, &engine->state.angle, 1);
+	state_snapshot_put(&writer, ENGINE_STATE_POSITION, STATE_FIELD_I32, position, 2);
+	engine->app->savedState = state_snapshot_finish(&writer, &engine->app->savedStateSize);
+	memory_budget_set(&engine->memory, MEMORY_BUDGET_SAVED_STATE, engine->app->savedStateSize);
+}
+
+/**
+* Application des champs restaurs, lus sur place ; un champ absent (NULL) ou trop
+* court garde sa valeur par dfaut.
+*/
+static void engine_restore_fields(struct engine* engine, const float* angle, size_t angleCount,
+	const int32_t* position, size_t positionCount) {
+	if (angle != NULL && angleCount >= 1) {
+		engine->state.angle = angle[0];
+	}
+	if (position != NULL && positionCount >= 2) {
+		engine->state.x = position[0];
+		engine->state.y = position[1];
+	}
+}
+
+/**
+* Restauration depuis l'tat enregistr par APP_CMD_SAVE_STATE.
+*/
+static void engine_restore_state(struct engine* engine, const void* data, size_t size) {
+	struct state_snapshot_view view;
+	if (state_snapshot_open(&view, data, size, ENGINE_STATE_SCHEMA) != 0) {
+		LOGW("Saved state ignored: unknown format (%zu bytes)", size);
+		return;
+	}
+	size_t angleCount;
+	size_t positionCount;
+	const void* angle = state_snapshot_get(&view, ENGINE_STATE_ANGLE, STATE_FIELD_F32, &angleCount);
+	const void* position = state_snapshot_get(&view, ENGINE_STATE_POSITION, STATE_FIELD_I32,
+		&positionCount);
+	engine_restore_fields(engine, (const float*)angle, angleCount, (const int32_t*)position,
+		positionCount);
+}
+
+/**
+* Restauration  froid depuis le journal, quand le processus a t tu sans tat enregistr.
+*/
+static void engine_restore_journal(struct engine* engine) {
+	size_t angleCount;
+	size_t positionCount;
+	const void* angle = state_journal_get(engine->journal, ENGINE_STATE_ANGLE, STATE_FIELD_F32,
+		&angleCount);
+	const void* position = state_journal_get(engine->journal, ENGINE_STATE_POSITION,
+		STATE_FIELD_I32, &positionCount);
+	engine_restore_fields(engine, (const float*)angle, angleCount, (const int32_t*)position,
+		positionCount);
+}
+
+/**
+* Enregistrement de l'tat : le systme demande d'enregistrer l'tat actuel.
+*/
+static void engine_state_on_cmd(struct engine* engine, const struct event_bus_cmd* event) {
+	engine_save_state(engine);
+}
+
+/**
+* Fentre : la surface suit la fentre, le contexte est gard.
+*/
+static void engine_window_on_cmd(struct engine* engine, const struct event_bus_cmd* event) {
+	switch (event->key) {
 	case APP_CMD_INIT_WINDOW:
-		// La fentre est affiche: opration de prparation.
+	case APP_CMD_WINDOW_RESIZED:
+		// La fentre est affiche, ou mme surface  une nouvelle taille.
 		if (engine->app->window != NULL) {
-			engine_init_display(engine);
+			engine_display_request(engine, event->key == APP_CMD_INIT_WINDOW ? ENGINE_RENDER_INIT
+				: ENGINE_RENDER_RESIZE);
 			engine_draw_frame(engine);
+			engine_extend_animation(engine);
 		}
 		break;
 	case APP_CMD_TERM_WINDOW:
-		// La fentre est masque ou ferme: opration de nettoyage.
-		engine_term_display(engine);
+		// La fentre est masque ou ferme : seule la surface est libre.
+		engine_display_request(engine, ENGINE_RENDER_TERM);
 		break;
-	case APP_CMD_GAINED_FOCUS:
-		// Quand l'application obtient le focus, la surveillance de l'acclromtre est dmarre.
-		if (engine->accelerometerSensor != NULL) {
-			ASensorEventQueue_enableSensor(engine->sensorEventQueue,
-				engine->accelerometerSensor);
-			// L'objectif est de 60vnements par seconde.
-			ASensorEventQueue_setEventRate(engine->sensorEventQueue,
-				engine->accelerometerSensor, (1000L / 60) * 1000);
+	case APP_CMD_WINDOW_REDRAW_NEEDED:
+		// Le systme affiche la fentre au retour : l'image est dessine avant, mme si
+		// rien n'a chang.
+		if (engine->app->window != NULL) {
+			engine_display_request(engine, ENGINE_RENDER_REDRAW);
+			engine->redraw.presented++;
 		}
 		break;
-	case APP_CMD_LOST_FOCUS:
-		// Quand l'application perd le focus, la surveillance de l'acclromtre est arrte.
-		// Cela vite de dcharger la batterie quand elle n'est pas utilise.
-		if (engine->accelerometerSensor != NULL) {
-			ASensorEventQueue_disableSensor(engine->sensorEventQueue,
-				engine->accelerometerSensor);
+	}
+}
+
+/**
+* Animation : elle reprend avec le focus et s'arrte sans lui.
+*/
+static void engine_animation_on_cmd(struct engine* engine, const struct event_bus_cmd* event) {
+	if (event->key == APP_CMD_GAINED_FOCUS) {
+		if (!engine->animating) {
+			// La cadence des images d'avant la perte du focus n'a plus cours.
+			engine->animating = 1;
+			frame_pacer_reset(&engine->pacer);
 		}
-		// Arrt galement de l'animation.
-		engine->animating = 0;
-		engine_draw_frame(engine);
+		engine_extend_animation(engine);
+		return;
+	}
+	engine_idle_end(engine);
+	if (engine->animating) {
+		frame_pacer_report(&engine->pacer, NULL);
+		frame_pacer_reset(&engine->pacer);
+	}
+	engine->animating = 0;
+	engine_draw_frame(engine);
+}
+
+/**
+* Acclromtre : surveill avec le focus seulement, pour ne pas dcharger la batterie.
+*/
+static void engine_sensors_on_cmd(struct engine* engine, const struct event_bus_cmd* event) {
+	if (event->key == APP_CMD_GAINED_FOCUS) {
+		// La frquence suit ensuite le mouvement observ ; sans animation, les vnements
+		// sont regroups par la FIFO matrielle.
+		// Pendant un rejeu, seuls les chantillons de la trace alimentent la chane.
+		if (engine->replay == NULL) {
+			sensor_pipeline_enable(&engine->sensors, !engine->animating);
+		}
+		return;
+	}
+	sensor_pipeline_disable(&engine->sensors);
+	sensor_pipeline_report(&engine->sensors, NULL);
+}
+
+static void engine_input_on_cmd(struct engine* engine, const struct event_bus_cmd* event) {
+	input_stage_report(&engine->input, NULL);
+}
+
+/**
+* Mesures : chaque priode d'activit a son propre bilan de phases.
+*/
+static void engine_timing_on_cmd(struct engine* engine, const struct event_bus_cmd* event) {
+	engine_dump_timing(engine);
+	frame_timing_reset(&engine->timing);
+}
+
+/**
+* Journal : le processus peut tre tu ds l'arrire-plan, un point de contrle est crit.
+*/
+static void engine_journal_on_cmd(struct engine* engine, const struct event_bus_cmd* event) {
+	if (engine->journal != NULL) {
+		state_journal_compact(engine->journal);
+	}
+}
+
+static void engine_memory_on_cmd(struct engine* engine, const struct event_bus_cmd* event) {
+	switch (event->key) {
+	case APP_CMD_RESUME:
+		// L'tat enregistr est libr par le code de collage.
+		memory_budget_set(&engine->memory, MEMORY_BUDGET_SAVED_STATE, 0);
+		break;
+	case APP_CMD_STOP:
+		// Hors du premier plan : caches et rserves. Le contexte est gard pour une
+		// reprise rapide.
+		memory_budget_reclaim(&engine->memory, MEMORY_BUDGET_STOPPED, NULL);
+		break;
+	case APP_CMD_LOW_MEMORY:
+		// Tous les paliers, contexte compris s'il n'y a pas de fentre.
+		memory_budget_reclaim(&engine->memory, MEMORY_BUDGET_LOW_MEMORY, NULL);
 		break;
 	}
 }
 
+/**
+* Abonns aux commandes principales, dans leur ordre d'appel :  la perte du focus,
+* l'attente prend fin avant l'arrt de l'acclromtre.
+*/
+typedef event_bus<struct engine, struct event_bus_cmd,
+	EVENT_BUS_HANDLER(EVENT_BUS_KEY(APP_CMD_SAVE_STATE), engine_state_on_cmd),
+	EVENT_BUS_HANDLER(EVENT_BUS_KEY(APP_CMD_INIT_WINDOW) | EVENT_BUS_KEY(APP_CMD_TERM_WINDOW)
+		| EVENT_BUS_KEY(APP_CMD_WINDOW_RESIZED) | EVENT_BUS_KEY(APP_CMD_WINDOW_REDRAW_NEEDED),
+		engine_window_on_cmd),
+	EVENT_BUS_HANDLER(EVENT_BUS_KEY(APP_CMD_GAINED_FOCUS) | EVENT_BUS_KEY(APP_CMD_LOST_FOCUS),
+		engine_animation_on_cmd),
+	EVENT_BUS_HANDLER(EVENT_BUS_KEY(APP_CMD_GAINED_FOCUS) | EVENT_BUS_KEY(APP_CMD_LOST_FOCUS),
+		engine_sensors_on_cmd),
+	EVENT_BUS_HANDLER(EVENT_BUS_KEY(APP_CMD_LOST_FOCUS), engine_input_on_cmd),
+	EVENT_BUS_HANDLER(EVENT_BUS_KEY(APP_CMD_PAUSE), engine_timing_on_cmd),
+	EVENT_BUS_HANDLER(EVENT_BUS_KEY(APP_CMD_PAUSE), engine_journal_on_cmd),
+	EVENT_BUS_HANDLER(EVENT_BUS_KEY(APP_CMD_RESUME) | EVENT_BUS_KEY(APP_CMD_STOP)
+		| EVENT_BUS_KEY(APP_CMD_LOW_MEMORY), engine_memory_on_cmd)> engine_cmd_bus;
+
+/**
+* Traitement de la commande principale suivante.
+*/
+static void engine_handle_cmd(struct android_app* app, int32_t cmd) {
+	const struct event_bus_cmd event = { cmd };
+	engine_cmd_bus::dispatch((struct engine*)app->userData, &event);
+}
+
+/**
+* Acclromtre : lecture par lots, sans journal.
+*/
+static void engine_sensors_on_looper(struct engine* engine, const struct event_bus_looper* event) {
+	SYS_TRACE_SCOPE("sensor_drain");
+	sensor_pipeline_drain(&engine->sensors);
+}
+
+/**
+* Phases : dure du traitement de la source, depuis la fin de l'attente.
+*/
+static void engine_timing_on_looper(struct engine* engine, const struct event_bus_looper* event) {
+	frame_timing_end(&engine->timing, event->key == LOOPER_ID_MAIN ? FRAME_PHASE_CMD
+		: event->key == LOOPER_ID_INPUT ? FRAME_PHASE_INPUT : FRAME_PHASE_SENSOR, event->pollEndNs);
+}
+
+/**
+* Une entre relance les images, qui dcident s'il y a lieu de dessiner.
+*/
+static void engine_idle_on_looper(struct engine* engine, const struct event_bus_looper* event) {
+	if (engine->idle) {
+		engine_idle_end(engine);
+	}
+}
+
+/**
+* Pendant l'attente, les lots de l'acclromtre sont lus ici : seul un mouvement
+* relance les images, et le capteur garde son mode de regroupement. L'arne de l'image
+* n'est pas remise  zro pendant l'attente : l'anneau est lu sur la pile.
+*/
+static void engine_motion_on_looper(struct engine* engine, const struct event_bus_looper* event) {
+	if (!engine->idle) {
+		return;
+	}
+	struct sensor_sample samples[SENSOR_PIPELINE_RING];
+	size_t sampleCount = sensor_pipeline_read(&engine->sensors, samples, SENSOR_PIPELINE_RING);
+	if (sampleCount > 0) {
+		engine->acceleration = samples[sampleCount - 1];
+		engine_note_motion(engine, &engine->acceleration);
+	}
+}
+
+/**
+* Mesures demandes par signal.
+*/
+static void engine_signal_on_looper(struct engine* engine, const struct event_bus_looper* event) {
+	uint64_t value;
+	if (read(engine_timing_fd, &value, sizeof(value)) == sizeof(value)) {
+		engine_dump_timing(engine);
+		engine_export_spans(engine);
+	}
+}
+
+/**
+* Abonns aux sources du looper, appels aprs le traitement de la source par le code
+* de collage ; les phases sont mesures aprs la lecture de l'acclromtre.
+*/
+typedef event_bus<struct engine, struct event_bus_looper,
+	EVENT_BUS_HANDLER(EVENT_BUS_KEY(LOOPER_ID_USER), engine_sensors_on_looper),
+	EVENT_BUS_HANDLER(EVENT_BUS_KEY(LOOPER_ID_MAIN) | EVENT_BUS_KEY(LOOPER_ID_INPUT)
+		| EVENT_BUS_KEY(LOOPER_ID_USER), engine_timing_on_looper),
+	EVENT_BUS_HANDLER(EVENT_BUS_KEY(LOOPER_ID_INPUT), engine_idle_on_looper),
+	EVENT_BUS_HANDLER(EVENT_BUS_KEY(LOOPER_ID_USER), engine_motion_on_looper),
+	EVENT_BUS_HANDLER(EVENT_BUS_KEY(ENGINE_LOOPER_ID_TIMING), engine_signal_on_looper)> engine_looper_bus;
+
 /**
 * Il s'agit du point d'entre principal d'une application native qui utilise
 * android_native_app_glue. Elle s'excute dans son propre thread, avec sa propre boucle d'vnements
@@ -225,7 +1464,17 @@ void android_main(struct android_app* state) {
 	state->userData = &engine;
 	state->onAppCmd = engine_handle_cmd;
 	state->onInputEvent = engine_handle_input;
+	input_stage_init(&engine.input);
+	state->inputStage = &engine.input;
 	engine.app = state;
+	memory_budget_init(&engine.memory, 0);
+	engine_update_marker_style(&engine);
+	android_app_add_config_listener(state, ACONFIGURATION_DENSITY | ACONFIGURATION_UI_MODE,
+		engine_config_changed, &engine);
+
+	// Le moteur ne dpend pas de activityState pendant les transitions : le thread
+	// principal de l'activit n'a pas  attendre START, RESUME, PAUSE et STOP.
+	__atomic_store_n(&state->asyncLifecycle, 1, __ATOMIC_RELAXED);
 
 	// Prparation de la surveillance de l'acclromtre
 	engine.sensorManager = ASensorManager_getInstance();
@@ -234,12 +1483,56 @@ void android_main(struct android_app* state) {
 	engine.sensorEventQueue = ASensorManager_createEventQueue(engine.sensorManager,
 		state->looper, LOOPER_ID_USER, NULL, NULL);
 
+	// Le journal ne dpend que du moteur : il est ouvert ici plutt que par le code de collage.
+	char journalPath[PATH_MAX];
+	snprintf(journalPath, sizeof(journalPath), "%s/state", state->activity->internalDataPath);
+	engine.journal = state_journal_open(journalPath, ENGINE_STATE_SCHEMA);
+
 	if (state->savedState != NULL) {
 		// Un tat enregistr prcdent est utilis pour procder  la restauration.
-		engine.state = *(struct saved_state*)state->savedState;
+		engine_restore_state(&engine, state->savedState, state->savedStateSize);
+		memory_budget_set(&engine.memory, MEMORY_BUDGET_SAVED_STATE, state->savedStateSize);
+	} else if (engine.journal != NULL) {
+		engine_restore_journal(&engine);
+	}
+	if (engine.journal != NULL) {
+		state_journal_release_view(engine.journal);
 	}
 
 	engine.animating = 1;
+	display_manager_init(&engine.egl, engine_config_attribs, engine_context_attribs);
+	frame_timing_init(&engine.timing);
+	if (frame_arena_init(&engine.frameArena, ENGINE_FRAME_ARENA_BYTES) != 0) {
+		LOGW("Unable to allocate the frame arena");
+	}
+	engine_timing_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (engine_timing_fd >= 0) {
+		ALooper_addFd(state->looper, engine_timing_fd, ENGINE_LOOPER_ID_TIMING, ALOOPER_EVENT_INPUT,
+			NULL, NULL);
+		signal(ENGINE_TIMING_SIGNAL, engine_request_timing);
+	}
+	frame_pacer_init(&engine.pacer, ENGINE_FRAME_RATE);
+	resolution_governor_init(&engine.resolution, engine.pacer.periodNs);
+	sensor_pipeline_init(&engine.sensors, engine.sensorEventQueue, engine.accelerometerSensor,
+		engine.pacer.periodNs);
+	engine_start_events(&engine);
+	engine_render_start(&engine);
+
+	// Les ressources sont lues par les threads de chargement, jamais par ce thread.
+	engine.assets = asset_stream_create(state->activity->assetManager, state->looper, 0,
+		ENGINE_ASSET_BUDGET);
+	if (engine.assets != NULL) {
+		asset_stream_request(engine.assets, ENGINE_MARKER_ASSET, ASSET_STREAM_PRIORITY_HIGH,
+			engine_marker_loaded, &engine);
+	}
+	memory_budget_add_evictor(&engine.memory, "asset cache", MEMORY_BUDGET_ASSETS,
+		MEMORY_BUDGET_TIER_CACHE, 0, engine_evict_assets, &engine);
+	memory_budget_add_evictor(&engine.memory, "state pool", MEMORY_BUDGET_POOLS,
+		MEMORY_BUDGET_TIER_CACHE, 1, engine_evict_state_pool, &engine);
+	memory_budget_add_evictor(&engine.memory, "frame arena", MEMORY_BUDGET_POOLS,
+		MEMORY_BUDGET_TIER_BACKGROUND, 0, engine_evict_frame_arena, &engine);
+	memory_budget_add_evictor(&engine.memory, "display", MEMORY_BUDGET_TEXTURES,
+		MEMORY_BUDGET_TIER_CRITICAL, 0, engine_evict_display, &engine);
 
 	// Boucle utilise en attente de tches  effectuer.
 
@@ -249,47 +1542,124 @@ void android_main(struct android_app* state) {
 		int events;
 		struct android_poll_source* source;
 
-		// Si aucune animation n'a lieu, l'attente d'vnements est bloque indfiniment.
-		// En cas d'animation, la boucle est rpte jusqu' ce que tous les vnements soient lus, puis
-		// la prochaine image d'animation est dessine.
-		while ((ident = ALooper_pollAll(engine.animating ? 0 : -1, NULL, &events,
-			(void**)&source)) >= 0) {
+		// Si aucune animation n'a lieu, ou si rien n'a chang en rendu  la demande,
+		// l'attente d'vnements est bloque indfiniment. En cas d'animation, l'attente
+		// dure jusqu' l'instant de rveil de la prochaine image fix par le
+		// planificateur, puis la prochaine image d'animation est dessine.
+		for (;;) {
+			int timeout = engine.animating && !engine.idle ? frame_pacer_poll_timeout(&engine.pacer) : -1;
+			if (engine.replay != NULL) {
+				timeout = engine_replay_timeout(&engine, timeout);
+			}
+			int64_t t = frame_timing_now();
+			ident = ALooper_pollAll(timeout, NULL, &events, (void**)&source);
+			// Seuls les passages sans attente mesurent le cot du looper lui-mme.
+			t = timeout == 0 ? frame_timing_end(&engine.timing, FRAME_PHASE_POLL, t) : frame_timing_now();
+			if (ident < 0) {
+				break;
+			}
 
 			// Traitement de cet vnement.
 			if (source != NULL) {
 				source->process(state, source);
 			}
 
-			// Traitement d'un capteur s'il possde des donnes.
-			if (ident == LOOPER_ID_USER) {
-				if (engine.accelerometerSensor != NULL) {
-					ASensorEvent event;
-					while (ASensorEventQueue_getEvents(engine.sensorEventQueue,
-						&event, 1) > 0) {
-						LOGI("accelerometer: x=%f y=%f z=%f",
-							event.acceleration.x, event.acceleration.y,
-							event.acceleration.z);
-					}
-				}
+			// Abonns de la source.
+			const struct event_bus_looper event = { ident, events, t };
+			engine_looper_bus::dispatch(&engine, &event);
+
+			// Sans animation, aucune image ne lira l'entre : la file est de nouveau lue 
+			// chaque vnement et le lot est appliqu aussitt.
+			if (!engine.animating && (ident == LOOPER_ID_INPUT || engine.input.deferred)) {
+				engine.input.deferred = 0;
+				engine_apply_input(&engine);
 			}
 
 			// Vrification de la procdure de sortie.
 			if (state->destroyRequested != 0) {
-				engine_term_display(&engine);
+				engine_display_request(&engine, ENGINE_RENDER_TERM);
+				engine_render_stop(&engine);
+				if (engine.assets != NULL) {
+					asset_stream_release(engine.assets, engine.marker);
+					asset_stream_destroy(engine.assets);
+				}
+				// La file du capteur est attache au looper de ce thread : elle est libre avec lui.
+				ASensorManager_destroyEventQueue(engine.sensorManager, engine.sensorEventQueue);
+				if (engine_timing_fd >= 0) {
+					signal(ENGINE_TIMING_SIGNAL, SIG_DFL);
+					ALooper_removeFd(state->looper, engine_timing_fd);
+					close(engine_timing_fd);
+					engine_timing_fd = -1;
+				}
+				state_journal_close(engine.journal);
+				if (engine.replay != NULL) {
+					engine_stop_replay(&engine);
+				}
+				frame_arena_destroy(&engine.frameArena);
 				return;
 			}
 		}
 
-		if (engine.animating) {
-			// vnements termins; dessin de la prochaine image d'animation suivante.
-			engine.state.angle += .01f;
-			if (engine.state.angle > 1) {
-				engine.state.angle = 0;
+		if (engine.replay != NULL) {
+			engine_replay(&engine);
+		}
+
+		if (engine.idle && engine.dirty != 0) {
+			engine_idle_end(&engine);
+		}
+
+		if (engine.animating && !engine.idle && frame_pacer_due(&engine.pacer)) {
+			// vnements termins; le dernier ALooper_pollAll() sans attente vient de lire
+			// les entres, l'tat est donc verrouill au plus tard avant le dessin. Jusqu'
+			// l'image suivante, la file d'entre ne rveille plus le looper qu'une fois.
+			engine.input.deferred = 1;
+			engine_apply_input(&engine);
+			frame_pacer_begin_frame(&engine.pacer);
+			SYS_TRACE_BEGIN("frame");
+			SYS_TRACE_BEGIN("update");
+			int64_t frameStart = frame_timing_now();
+			// Tout l'anneau du capteur est lu d'un coup, dans l'arne de l'image.
+			struct sensor_sample* samples = FRAME_ARENA_NEW(&engine.frameArena, struct sensor_sample,
+				SENSOR_PIPELINE_RING);
+			size_t sampleCount = samples != NULL ? sensor_pipeline_read(&engine.sensors, samples,
+				SENSOR_PIPELINE_RING) : 0;
+			if (sampleCount > 0) {
+				engine.acceleration = samples[sampleCount - 1];
+				engine_note_motion(&engine, &engine.acceleration);
+			}
+			int animate = !ENGINE_RENDER_ON_DEMAND || frameStart < engine.animateUntil;
+			if (animate) {
+				engine.state.angle += .01f;
+				if (engine.state.angle > 1) {
+					engine.state.angle = 0;
+				}
+				if (engine.journal != NULL) {
+					state_journal_append(engine.journal, ENGINE_STATE_ANGLE, STATE_FIELD_F32,
+						&engine.state.angle, 1);
+				}
+				engine.dirty |= ENGINE_DIRTY_STATE;
 			}
+			frame_timing_end(&engine.timing, FRAME_PHASE_UPDATE, frameStart);
+			SYS_TRACE_END();
 
-			// Le dessin tant limit  la frquence de mise  jour de l'cran,
-			// aucune temporisation n'est ncessaire.
-			engine_draw_frame(&engine);
+			// L'image identique  la prcdente n'est ni dessine ni prsente.
+			if (engine.dirty != 0) {
+				engine_draw_frame(&engine);
+			} else {
+				engine.redraw.skipped++;
+			}
+			frame_pacer_end_frame(&engine.pacer);
+			frame_timing_end(&engine.timing, FRAME_PHASE_FRAME, frameStart);
+			SYS_TRACE_END();
+			if (!animate && engine.dirty == 0) {
+				engine_idle_begin(&engine);
+			}
 		}
+
+		// Fin de l'itration : les allocations temporaires sont rendues d'un coup, aprs le
+		// relev de la mmoire et la libration des caches au-del du budget.
+		engine_update_memory(&engine);
+		memory_budget_check(&engine.memory);
+		frame_arena_reset(&engine.frameArena);
 	}
 }
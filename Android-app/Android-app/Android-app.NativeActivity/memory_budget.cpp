@@ -0,0 +1,184 @@
+// Lastorm tech.
+
+ASYNC_LOG_TAG(memory_budget_log_tag, "memory", 20);
+
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, &memory_budget_log_tag, __VA_ARGS__)
+#define LOGW(...) ASYNC_LOG(ANDROID_LOG_WARN, &memory_budget_log_tag, __VA_ARGS__)
+
+static const char* const memory_budget_category_names[MEMORY_BUDGET_CATEGORIES] = {
+    "textures", "assets", "pools", "saved_state",
+};
+
+static const char* const memory_budget_reason_names[MEMORY_BUDGET_REASONS] = {
+    "over_budget", "stopped", "low_memory",
+};
+
+// Dernier palier libr pour chaque raison.
+static const int memory_budget_max_tier[MEMORY_BUDGET_REASONS] = {
+    MEMORY_BUDGET_TIER_CACHE, MEMORY_BUDGET_TIER_BACKGROUND, MEMORY_BUDGET_TIER_CRITICAL,
+};
+
+const char* memory_budget_category_name(int category) {
+    return category >= 0 && category < MEMORY_BUDGET_CATEGORIES ? memory_budget_category_names[category] : "?";
+}
+
+const char* memory_budget_reason_name(int reason) {
+    return reason >= 0 && reason < MEMORY_BUDGET_REASONS ? memory_budget_reason_names[reason] : "?";
+}
+
+size_t memory_budget_default(void) {
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (pages <= 0 || pageSize <= 0) {
+        return MEMORY_BUDGET_DEFAULT_MIN;
+    }
+    uint64_t share = (uint64_t)pages * (uint64_t)pageSize / MEMORY_BUDGET_DEFAULT_SHARE;
+    if (share < MEMORY_BUDGET_DEFAULT_MIN) return MEMORY_BUDGET_DEFAULT_MIN;
+    if (share > MEMORY_BUDGET_DEFAULT_MAX) return MEMORY_BUDGET_DEFAULT_MAX;
+    return (size_t)share;
+}
+
+void memory_budget_init(struct memory_budget* budget, size_t budgetBytes) {
+    memset(budget, 0, sizeof(*budget));
+    budget->budgetBytes = budgetBytes != 0 ? budgetBytes : memory_budget_default();
+}
+
+int memory_budget_add_evictor(struct memory_budget* budget, const char* name, int category, int tier,
+        int priority, memory_budget_evict_function function, void* userData) {
+    if (budget->evictorCount == MEMORY_BUDGET_MAX_EVICTORS) {
+        return -1;
+    }
+    // Insertion trie : la liste est parcourue dans l'ordre  chaque libration.
+    int index = budget->evictorCount;
+    while (index > 0 && (budget->evictors[index - 1].tier > tier
+            || (budget->evictors[index - 1].tier == tier && budget->evictors[index - 1].priority > priority))) {
+        budget->evictors[index] = budget->evictors[index - 1];
+        index--;
+    }
+    struct memory_budget_evictor* evictor = &budget->evictors[index];
+    memset(evictor, 0, sizeof(*evictor));
+    evictor->name = name;
+    evictor->category = category;
+    evictor->tier = tier;
+    evictor->priority = priority;
+    evictor->function = function;
+    evictor->userData = userData;
+    budget->evictorCount++;
+    return 0;
+}
+
+void memory_budget_add(struct memory_budget* budget, int category, ptrdiff_t delta) {
+    __atomic_fetch_add(&budget->bytes[category], (size_t)delta, __ATOMIC_RELAXED);
+}
+
+void memory_budget_set(struct memory_budget* budget, int category, size_t bytes) {
+    __atomic_store_n(&budget->bytes[category], bytes, __ATOMIC_RELAXED);
+}
+
+size_t memory_budget_get(const struct memory_budget* budget, int category) {
+    return __atomic_load_n(&budget->bytes[category], __ATOMIC_RELAXED);
+}
+
+size_t memory_budget_total(const struct memory_budget* budget) {
+    size_t total = 0;
+    for (int i = 0; i < MEMORY_BUDGET_CATEGORIES; i++) {
+        total += memory_budget_get(budget, i);
+    }
+    return total;
+}
+
+size_t memory_budget_reclaim(struct memory_budget* budget, int reason, struct memory_budget_report* outReport) {
+    struct memory_budget_report report;
+    memset(&report, 0, sizeof(report));
+    report.reason = reason;
+    report.usageBefore = memory_budget_total(budget);
+
+    // Hors dpassement, tout ce que les paliers permis peuvent rendre.
+    size_t target = SIZE_MAX;
+    if (reason == MEMORY_BUDGET_OVER_BUDGET) {
+        size_t lowWater = (size_t)(budget->budgetBytes * MEMORY_BUDGET_LOW_WATER);
+        target = report.usageBefore > lowWater ? report.usageBefore - lowWater : 0;
+    }
+
+    int64_t start = frame_timing_now();
+    for (int i = 0; i < budget->evictorCount && report.reclaimedBytes < target; i++) {
+        struct memory_budget_evictor* evictor = &budget->evictors[i];
+        if (evictor->tier > memory_budget_max_tier[reason]) {
+            break;
+        }
+        int64_t t = frame_timing_now();
+        size_t wanted = target == SIZE_MAX ? SIZE_MAX : target - report.reclaimedBytes;
+        size_t reclaimed = evictor->function(evictor->userData, wanted);
+        int64_t elapsed = frame_timing_now() - t;
+        evictor->calls++;
+        evictor->reclaimedBytes += reclaimed;
+        evictor->totalNs += elapsed;
+        report.reclaimedBytes += reclaimed;
+        report.evictors++;
+        if (reclaimed > 0) {
+            LOGI("reclaim %s: %s freed %zu KiB in %.3f ms", memory_budget_reason_name(reason),
+                    evictor->name, reclaimed >> 10, elapsed / 1e6);
+        }
+    }
+    report.durationNs = frame_timing_now() - start;
+    report.usageAfter = memory_budget_total(budget);
+
+    budget->stats.reclaims[reason]++;
+    budget->stats.reclaimedBytes[reason] += report.reclaimedBytes;
+    budget->stats.reclaimNs[reason] += report.durationNs;
+    if (report.durationNs > budget->stats.maxReclaimNs) budget->stats.maxReclaimNs = report.durationNs;
+    budget->last = report;
+    LOGI("reclaim %s: %zu KiB from %d evictors in %.3f ms, %zu -> %zu KiB (budget %zu KiB)",
+            memory_budget_reason_name(reason), report.reclaimedBytes >> 10, report.evictors,
+            report.durationNs / 1e6, report.usageBefore >> 10, report.usageAfter >> 10,
+            budget->budgetBytes >> 10);
+    if (outReport != NULL) {
+        *outReport = report;
+    }
+    return report.reclaimedBytes;
+}
+
+size_t memory_budget_check(struct memory_budget* budget) {
+    size_t total = memory_budget_total(budget);
+    if (total > budget->stats.peakBytes) {
+        budget->stats.peakBytes = total;
+    }
+    if (total <= budget->budgetBytes) {
+        budget->retryAbove = 0;
+        return 0;
+    }
+    if (total <= budget->retryAbove) {
+        return 0;
+    }
+    struct memory_budget_report report;
+    size_t reclaimed = memory_budget_reclaim(budget, MEMORY_BUDGET_OVER_BUDGET, &report);
+    if (report.usageAfter > budget->budgetBytes) {
+        LOGW("still %zu KiB over budget after reclaiming caches",
+                (report.usageAfter - budget->budgetBytes) >> 10);
+        budget->retryAbove = report.usageAfter;
+    }
+    return reclaimed;
+}
+
+void memory_budget_log(const struct memory_budget* budget) {
+    LOGI("memory: total=%zu KiB budget=%zu KiB peak=%zu KiB textures=%zu assets=%zu pools=%zu "
+            "saved_state=%zu KiB", memory_budget_total(budget) >> 10, budget->budgetBytes >> 10,
+            budget->stats.peakBytes >> 10, memory_budget_get(budget, MEMORY_BUDGET_TEXTURES) >> 10,
+            memory_budget_get(budget, MEMORY_BUDGET_ASSETS) >> 10,
+            memory_budget_get(budget, MEMORY_BUDGET_POOLS) >> 10,
+            memory_budget_get(budget, MEMORY_BUDGET_SAVED_STATE) >> 10);
+    for (int reason = 0; reason < MEMORY_BUDGET_REASONS; reason++) {
+        if (budget->stats.reclaims[reason] == 0) continue;
+        LOGI("memory %s: reclaims=%llu freed=%llu KiB time=%.3f ms", memory_budget_reason_name(reason),
+                (unsigned long long)budget->stats.reclaims[reason],
+                (unsigned long long)(budget->stats.reclaimedBytes[reason] >> 10),
+                budget->stats.reclaimNs[reason] / 1e6);
+    }
+    for (int i = 0; i < budget->evictorCount; i++) {
+        const struct memory_budget_evictor* evictor = &budget->evictors[i];
+        LOGI("memory evictor %s (%s, tier %d): calls=%llu freed=%llu KiB time=%.3f ms", evictor->name,
+                memory_budget_category_name(evictor->category), evictor->tier,
+                (unsigned long long)evictor->calls, (unsigned long long)(evictor->reclaimedBytes >> 10),
+                evictor->totalNs / 1e6);
+    }
+}
@@ -0,0 +1,189 @@
+// Lastorm tech.
+
+#ifndef _MEMORY_BUDGET_H
+#define _MEMORY_BUDGET_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Comptabilit de la mmoire du moteur et libration par paliers.
+ *
+ * Chaque sous-systme tient  jour ses octets dans une catgorie, depuis
+ * n'importe quel thread (memory_budget_add() ou memory_budget_set()). Les
+ * librateurs sont enregistrs dans un palier, du moins coteux  reconstruire
+ * au plus coteux :
+ *
+ *      cache       rserves et caches sans utilisateur, recrs  la demande ;
+ *      fond        mmoire inutile hors du premier plan, recre  la reprise ;
+ *      critique    tat coteux  recrer (contexte EGL, textures), libr
+ *                  seulement quand le systme manque de mmoire.
+ *
+ * memory_budget_reclaim() appelle les librateurs des paliers permis par la
+ * raison, palier par palier puis par priorit croissante :
+ *
+ *      budget dpass  cache, jusqu' MEMORY_BUDGET_LOW_WATER du budget ;
+ *      arrt           cache et fond, entirement (APP_CMD_STOP) ;
+ *      mmoire faible  tous les paliers, entirement (APP_CMD_LOW_MEMORY).
+ *
+ * Chaque libration est mesure (octets rendus et dure) et journalise, avec
+ * le dtail de chaque librateur.
+ *
+ * Les librateurs sont enregistrs et appels par le thread propritaire.
+ */
+
+// Librateurs enregistrs au plus.
+#define MEMORY_BUDGET_MAX_EVICTORS 16
+
+// Fraction du budget vise quand il est dpass.
+#define MEMORY_BUDGET_LOW_WATER 0.9f
+
+// Budget par dfaut : une part de la mmoire physique, borne (1/16 : 128 Mio
+// sur un appareil de 2 Gio, 192 Mio sur 3 Gio).
+#define MEMORY_BUDGET_DEFAULT_SHARE 16
+#define MEMORY_BUDGET_DEFAULT_MIN (32 << 20)
+#define MEMORY_BUDGET_DEFAULT_MAX (512 << 20)
+
+// Catgories de mmoire.
+enum {
+    MEMORY_BUDGET_TEXTURES,
+    MEMORY_BUDGET_ASSETS,
+    MEMORY_BUDGET_POOLS,
+    MEMORY_BUDGET_SAVED_STATE,
+
+    MEMORY_BUDGET_CATEGORIES
+};
+
+// Paliers de libration.
+enum {
+    MEMORY_BUDGET_TIER_CACHE,
+    MEMORY_BUDGET_TIER_BACKGROUND,
+    MEMORY_BUDGET_TIER_CRITICAL,
+
+    MEMORY_BUDGET_TIERS
+};
+
+// Raisons d'une libration.
+enum {
+    MEMORY_BUDGET_OVER_BUDGET,
+    MEMORY_BUDGET_STOPPED,
+    MEMORY_BUDGET_LOW_MEMORY,
+
+    MEMORY_BUDGET_REASONS
+};
+
+/**
+ * Libre au moins targetBytes octets si possible (SIZE_MAX : tout ce qui peut
+ * l'tre) et met  jour sa catgorie. Retourne les octets librs.
+ */
+typedef size_t (*memory_budget_evict_function)(void* userData, size_t targetBytes);
+
+struct memory_budget_evictor {
+    const char* name;
+    int category;
+    int tier;
+    int priority;
+    memory_budget_evict_function function;
+    void* userData;
+
+    // Appels, octets librs et dure totale.
+    uint64_t calls;
+    uint64_t reclaimedBytes;
+    int64_t totalNs;
+};
+
+/**
+ * Bilan d'une libration.
+ */
+struct memory_budget_report {
+    int reason;
+    int evictors;
+    size_t usageBefore;
+    size_t usageAfter;
+    size_t reclaimedBytes;
+    int64_t durationNs;
+};
+
+struct memory_budget_stats {
+    // Librations par raison, octets rendus et dure totale.
+    uint64_t reclaims[MEMORY_BUDGET_REASONS];
+    uint64_t reclaimedBytes[MEMORY_BUDGET_REASONS];
+    int64_t reclaimNs[MEMORY_BUDGET_REASONS];
+    int64_t maxReclaimNs;
+
+    // Plus haut niveau observ par memory_budget_check().
+    size_t peakBytes;
+};
+
+struct memory_budget {
+    size_t budgetBytes;
+    size_t bytes[MEMORY_BUDGET_CATEGORIES];
+
+    // Tri par palier puis par priorit.
+    struct memory_budget_evictor evictors[MEMORY_BUDGET_MAX_EVICTORS];
+    int evictorCount;
+
+    // Aprs une libration insuffisante, pas de nouvel essai sous ce niveau.
+    size_t retryAbove;
+
+    struct memory_budget_report last;
+    struct memory_budget_stats stats;
+};
+
+/**
+ * Budget par dfaut, d'aprs la mmoire physique de l'appareil.
+ */
+size_t memory_budget_default(void);
+
+/**
+ * Prpare la comptabilit ; budgetBytes nul choisit memory_budget_default().
+ */
+void memory_budget_init(struct memory_budget* budget, size_t budgetBytes);
+
+/**
+ * Enregistre un librateur de la mmoire de category, dans tier ;  palier gal,
+ * la plus petite priorit passe d'abord. Retourne -1 si
+ * MEMORY_BUDGET_MAX_EVICTORS librateurs sont dj enregistrs.
+ */
+int memory_budget_add_evictor(struct memory_budget* budget, const char* name, int category, int tier,
+        int priority, memory_budget_evict_function function, void* userData);
+
+/**
+ * Octets d'une catgorie : variation, ou nouvelle valeur.
+ */
+void memory_budget_add(struct memory_budget* budget, int category, ptrdiff_t delta);
+void memory_budget_set(struct memory_budget* budget, int category, size_t bytes);
+
+size_t memory_budget_get(const struct memory_budget* budget, int category);
+size_t memory_budget_total(const struct memory_budget* budget);
+
+/**
+ * Libration pour reason. outReport (NULL possible) reoit le bilan. Retourne
+ * les octets librs.
+ */
+size_t memory_budget_reclaim(struct memory_budget* budget, int reason, struct memory_budget_report* outReport);
+
+/**
+ *  appeler rgulirement (une fois par image) : au-del du budget, libration
+ * du palier cache. Aprs une libration insuffisante, le nouvel essai attend
+ * que l'utilisation augmente encore. Retourne les octets librs.
+ */
+size_t memory_budget_check(struct memory_budget* budget);
+
+/**
+ * Journalise l'utilisation par catgorie et les totaux de chaque librateur.
+ */
+void memory_budget_log(const struct memory_budget* budget);
+
+const char* memory_budget_category_name(int category);
+const char* memory_budget_reason_name(int reason);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MEMORY_BUDGET_H */
@@ -8,16 +8,60 @@
 //
 
 #include <jni.h>
+#include <dlfcn.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
 
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
 #include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
 
 #include <EGL/egl.h>
-#include <GLES/gl.h>
+#include <GLES3/gl3.h>
+#include <GLES2/gl2ext.h>
+
+#include <zlib.h>
 
 #include <android/sensor.h>
 
 #include <android/log.h>
+#include "async_log.h"
+#include "sys_trace.h"
+#include "frame_alloc.h"
+#include "event_trace.h"
+#include "input_stage.h"
+#include "event_bus.h"
+#include "state_snapshot.h"
+#include "state_journal.h"
 #include "android_native_app_glue.h"
+#include "frame_pacer.h"
+#include "frame_timing.h"
+#include "triple_buffer.h"
+#include "sensor_pipeline.h"
+#include "soft_raster.h"
+#include "display_manager.h"
+#include "sprite_batch.h"
+#include "asset_stream.h"
+#include "job_system.h"
+#include "resolution_governor.h"
+#include "memory_budget.h"
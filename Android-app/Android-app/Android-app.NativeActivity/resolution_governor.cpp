@@ -0,0 +1,134 @@
+// Lastorm tech.
+
+ASYNC_LOG_TAG(resolution_governor_log_tag, "resolution", 10);
+
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, &resolution_governor_log_tag, __VA_ARGS__)
+
+typedef void* (*resolution_governor_acquire_function)(void);
+
+// AThermal n'existe qu' partir d'Android 11 : les fonctions sont cherches dans les
+// bibliothques dj charges, libandroid.so comprise.
+static void resolution_governor_open_thermal(struct resolution_governor* governor) {
+    resolution_governor_acquire_function acquire =
+        (resolution_governor_acquire_function)dlsym(RTLD_DEFAULT, "AThermal_acquireManager");
+    governor->thermalHeadroom = (float (*)(void*, int))dlsym(RTLD_DEFAULT, "AThermal_getThermalHeadroom");
+    governor->thermalManager = acquire != NULL && governor->thermalHeadroom != NULL ? acquire() : NULL;
+    if (governor->thermalManager == NULL) {
+        governor->thermalHeadroom = NULL;
+        LOGI("thermal headroom unavailable, frame times only");
+    }
+}
+
+static int resolution_governor_compare(const void* a, const void* b) {
+    int64_t x = *(const int64_t*)a;
+    int64_t y = *(const int64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static float resolution_governor_level_scale(int level) {
+    return 1.0f - level * RESOLUTION_GOVERNOR_STEP;
+}
+
+// Palier le plus fin permis par la marge thermique.
+static int resolution_governor_thermal_level(float headroom) {
+    if (!(headroom > RESOLUTION_GOVERNOR_THERMAL_WARN)) {
+        return 0;
+    }
+    float excess = (headroom - RESOLUTION_GOVERNOR_THERMAL_WARN) / (1.0f - RESOLUTION_GOVERNOR_THERMAL_WARN);
+    int level = (int)ceilf(excess * (RESOLUTION_GOVERNOR_LEVELS - 1));
+    return level < RESOLUTION_GOVERNOR_LEVELS - 1 ? level : RESOLUTION_GOVERNOR_LEVELS - 1;
+}
+
+static int resolution_governor_set_level(struct resolution_governor* governor, int level) {
+    if (level == governor->level) {
+        return 0;
+    }
+    LOGI("render scale %.0f%% -> %.0f%% (p90 %.2f ms, budget %.2f ms, headroom %.2f)",
+        resolution_governor_scale(governor) * 100.0f, resolution_governor_level_scale(level) * 100.0f,
+        governor->stats.lastP90Ns / 1e6, governor->budgetNs / 1e6, governor->headroom);
+    if (level > governor->level) {
+        governor->stats.lowers++;
+    } else {
+        governor->stats.raises++;
+    }
+    governor->level = level;
+    governor->comfortableWindows = 0;
+    resolution_governor_reset(governor);
+    return 1;
+}
+
+void resolution_governor_init(struct resolution_governor* governor, int64_t framePeriodNs) {
+    memset(governor, 0, sizeof(*governor));
+    governor->budgetNs = (int64_t)(framePeriodNs * RESOLUTION_GOVERNOR_BUDGET);
+    governor->headroom = NAN;
+    resolution_governor_open_thermal(governor);
+}
+
+void resolution_governor_reset(struct resolution_governor* governor) {
+    governor->sampleCount = 0;
+    governor->settleFrames = RESOLUTION_GOVERNOR_SETTLE_FRAMES;
+}
+
+int resolution_governor_set_headroom(struct resolution_governor* governor, float headroom) {
+    governor->headroom = headroom;
+    governor->thermalLevel = resolution_governor_thermal_level(headroom);
+    if (governor->level < governor->thermalLevel) {
+        governor->stats.thermalCaps++;
+        return resolution_governor_set_level(governor, governor->thermalLevel);
+    }
+    return 0;
+}
+
+// Dcision sur une fentre complte.
+static int resolution_governor_decide(struct resolution_governor* governor) {
+    qsort(governor->samples, RESOLUTION_GOVERNOR_WINDOW, sizeof(int64_t), resolution_governor_compare);
+    int64_t p90 = governor->samples[RESOLUTION_GOVERNOR_WINDOW * 9 / 10];
+    governor->stats.windows++;
+    governor->stats.lastP90Ns = p90;
+    governor->sampleCount = 0;
+
+    float scale = resolution_governor_scale(governor);
+    if (p90 > governor->budgetNs) {
+        // La dure suit la surface : l'chelle vise ramne le centile  90 % du budget.
+        governor->stats.overBudget++;
+        float target = scale * sqrtf(0.9f * governor->budgetNs / (float)p90);
+        int level = (int)ceilf((1.0f - target) / RESOLUTION_GOVERNOR_STEP - 0.01f);
+        if (level <= governor->level) level = governor->level + 1;
+        if (level > RESOLUTION_GOVERNOR_LEVELS - 1) level = RESOLUTION_GOVERNOR_LEVELS - 1;
+        return resolution_governor_set_level(governor, level);
+    }
+    if (governor->level <= governor->thermalLevel) {
+        governor->comfortableWindows = 0;
+        return 0;
+    }
+    float raised = resolution_governor_level_scale(governor->level - 1);
+    float predicted = p90 * (raised * raised) / (scale * scale);
+    if (predicted < RESOLUTION_GOVERNOR_RAISE_MARGIN * governor->budgetNs) {
+        if (++governor->comfortableWindows >= RESOLUTION_GOVERNOR_RAISE_WINDOWS) {
+            return resolution_governor_set_level(governor, governor->level - 1);
+        }
+    } else {
+        governor->comfortableWindows = 0;
+    }
+    return 0;
+}
+
+int resolution_governor_frame(struct resolution_governor* governor, int64_t frameNs, int64_t nowNs) {
+    governor->stats.frames++;
+    int changed = 0;
+    if (governor->thermalHeadroom != NULL && nowNs >= governor->nextThermalPollNs) {
+        // Une lecture plus frquente rend NaN.
+        governor->nextThermalPollNs = nowNs + RESOLUTION_GOVERNOR_THERMAL_INTERVAL_NS;
+        changed = resolution_governor_set_headroom(governor, governor->thermalHeadroom(
+            governor->thermalManager, RESOLUTION_GOVERNOR_THERMAL_FORECAST_S));
+    }
+    if (governor->settleFrames > 0) {
+        governor->settleFrames--;
+        return changed;
+    }
+    governor->samples[governor->sampleCount++] = frameNs;
+    if (governor->sampleCount == RESOLUTION_GOVERNOR_WINDOW) {
+        changed |= resolution_governor_decide(governor);
+    }
+    return changed;
+}
@@ -0,0 +1,131 @@
+// Lastorm tech.
+
+#ifndef _RESOLUTION_GOVERNOR_H
+#define _RESOLUTION_GOVERNOR_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Rgulateur de la rsolution de rendu.
+ *
+ * Le propritaire de la fentre donne la dure de chaque image (dessin et
+ * prsentation) ; le rgulateur choisit l'chelle des tampons de la fentre,
+ * par paliers de RESOLUTION_GOVERNOR_STEP, entre 1 et
+ * RESOLUTION_GOVERNOR_MIN_SCALE. Le compositeur agrandit les tampons rduits 
+ * la taille de la fentre.
+ *
+ * Les dcisions portent sur le 90e centile de fentres de
+ * RESOLUTION_GOVERNOR_WINDOW images, compar au budget (une fraction de la
+ * priode d'image) :
+ *
+ *      au-dessus   baisse immdiate, jusqu'au palier dont la surface ramne la
+ *                  dure estime sous le budget ;
+ *      en dessous  hausse d'un palier quand la dure estime au palier
+ *                  suprieur, proportionnelle  la surface, reste sous
+ *                  RESOLUTION_GOVERNOR_RAISE_MARGIN du budget pendant
+ *                  RESOLUTION_GOVERNOR_RAISE_WINDOWS fentres conscutives.
+ *
+ * L'cart entre les deux seuils vite les oscillations ; le cot par pixel est
+ * mesur, aucun rglage ne dpend de l'appareil.
+ *
+ * La marge thermique (AThermal_getThermalHeadroom(), Android 11, rsolue 
+ * l'excution) est lue au plus une fois par seconde. Au-del de
+ * RESOLUTION_GOVERNOR_THERMAL_WARN, l'chelle est plafonne, jusqu'
+ * l'chelle minimale  1 (limitation svre imminente). Sans marge
+ * disponible, seules les dures comptent.
+ *
+ * Les fonctions sont appeles par le thread propritaire de la fentre.
+ */
+
+// chelle minimale et cart entre deux paliers.
+#define RESOLUTION_GOVERNOR_MIN_SCALE 0.5f
+#define RESOLUTION_GOVERNOR_STEP 0.1f
+#define RESOLUTION_GOVERNOR_LEVELS 6
+
+// Images par dcision, et images ignores aprs un changement (nouveaux tampons).
+#define RESOLUTION_GOVERNOR_WINDOW 30
+#define RESOLUTION_GOVERNOR_SETTLE_FRAMES 5
+
+// Budget, en fraction de la priode d'image.
+#define RESOLUTION_GOVERNOR_BUDGET 0.8f
+
+// Hausse : marge sous le budget et fentres conscutives requises.
+#define RESOLUTION_GOVERNOR_RAISE_MARGIN 0.85f
+#define RESOLUTION_GOVERNOR_RAISE_WINDOWS 4
+
+// Marge thermique  partir de laquelle l'chelle est plafonne, priode de
+// lecture et horizon de prvision.
+#define RESOLUTION_GOVERNOR_THERMAL_WARN 0.75f
+#define RESOLUTION_GOVERNOR_THERMAL_INTERVAL_NS 1000000000LL
+#define RESOLUTION_GOVERNOR_THERMAL_FORECAST_S 3
+
+struct resolution_governor_stats {
+    uint64_t frames;
+    uint64_t windows;
+    uint64_t lowers;
+    uint64_t raises;
+
+    // Fentres au-dessus du budget, et changements imposs par la marge thermique.
+    uint64_t overBudget;
+    uint64_t thermalCaps;
+
+    // 90e centile de la dernire fentre.
+    int64_t lastP90Ns;
+};
+
+struct resolution_governor {
+    int64_t budgetNs;
+
+    // Palier courant (0 : pleine rsolution) et palier minimal impos par la marge thermique.
+    int level;
+    int thermalLevel;
+
+    int64_t samples[RESOLUTION_GOVERNOR_WINDOW];
+    int sampleCount;
+    int settleFrames;
+    int comfortableWindows;
+
+    // Dernire marge thermique lue (NaN si inconnue) et prochaine lecture.
+    float headroom;
+    int64_t nextThermalPollNs;
+    void* thermalManager;
+    float (*thermalHeadroom)(void* manager, int forecastSeconds);
+
+    struct resolution_governor_stats stats;
+};
+
+/**
+ * Prpare le rgulateur pour une priode d'image, en pleine rsolution.
+ */
+void resolution_governor_init(struct resolution_governor* governor, int64_t framePeriodNs);
+
+/**
+ * Dure d'une image, du dbut du dessin  la fin de la prsentation. Retourne 1
+ * si l'chelle a chang : les tampons de la fentre doivent tre redimensionns.
+ */
+int resolution_governor_frame(struct resolution_governor* governor, int64_t frameNs, int64_t nowNs);
+
+/**
+ * Marge thermique obtenue par ailleurs (NaN : inconnue), applique aussitt ;
+ * la lecture suivante d'AThermal la remplace. Retourne 1 si l'chelle a chang.
+ */
+int resolution_governor_set_headroom(struct resolution_governor* governor, float headroom);
+
+/**
+ * Oublie les dures mesures, par exemple pour une nouvelle fentre ; le palier est gard.
+ */
+void resolution_governor_reset(struct resolution_governor* governor);
+
+static inline float resolution_governor_scale(const struct resolution_governor* governor) {
+    return 1.0f - governor->level * RESOLUTION_GOVERNOR_STEP;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RESOLUTION_GOVERNOR_H */
@@ -0,0 +1,237 @@
+// Lastorm tech.
+
+ASYNC_LOG_TAG(sensor_pipeline_log_tag, "sensor_pipeline", 10);
+
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, &sensor_pipeline_log_tag, __VA_ARGS__)
+
+// Frquences de coupure du filtre de sortie et de l'estimation du mouvement.
+#define SENSOR_PIPELINE_CUTOFF_HZ 5.0f
+#define SENSOR_PIPELINE_MOTION_CUTOFF_HZ 1.0f
+
+#define SENSOR_PIPELINE_PI 3.14159265f
+
+// Coefficient d'un passe-bas du premier ordre pour un pas de dtNs.
+static float sensor_pipeline_alpha(int64_t dtNs, float cutoffHz) {
+    float dt = dtNs * 1e-9f;
+    float rc = 1.0f / (2.0f * SENSOR_PIPELINE_PI * cutoffHz);
+    return dt / (rc + dt);
+}
+
+static int32_t sensor_pipeline_clamp_period(const struct sensor_pipeline* pipeline,
+        int32_t periodUs) {
+    int32_t minDelay = ASensor_getMinDelay(pipeline->sensor);
+    return periodUs < minDelay ? minDelay : periodUs;
+}
+
+void sensor_pipeline_init(struct sensor_pipeline* pipeline, ASensorEventQueue* queue,
+        const ASensor* sensor, int64_t outputPeriodNs) {
+    memset(pipeline, 0, sizeof(*pipeline));
+    pipeline->queue = queue;
+    pipeline->sensor = sensor;
+    pipeline->outputPeriodNs = outputPeriodNs;
+    pipeline->periodUs = SENSOR_PIPELINE_RATE_NORMAL_US;
+    // ASensorEventQueue_registerSensor n'existe qu' partir d'Android 8.0 : la fonction
+    // est cherche dans les bibliothques dj charges, libandroid.so comprise.
+    pipeline->registerSensor = (int (*)(ASensorEventQueue*, const ASensor*, int32_t, int64_t))
+        dlsym(RTLD_DEFAULT, "ASensorEventQueue_registerSensor");
+    if (pipeline->registerSensor == NULL) {
+        LOGI("sensor batching unavailable");
+    }
+}
+
+static void sensor_pipeline_register(struct sensor_pipeline* pipeline) {
+    int32_t periodUs = sensor_pipeline_clamp_period(pipeline, pipeline->periodUs);
+    if (pipeline->registerSensor != NULL) {
+        pipeline->registerSensor(pipeline->queue, pipeline->sensor, periodUs,
+                pipeline->batchLatencyUs);
+        return;
+    }
+    ASensorEventQueue_enableSensor(pipeline->queue, pipeline->sensor);
+    ASensorEventQueue_setEventRate(pipeline->queue, pipeline->sensor, periodUs);
+}
+
+void sensor_pipeline_enable(struct sensor_pipeline* pipeline, int staticScreen) {
+    if (pipeline->sensor == NULL) {
+        return;
+    }
+    pipeline->batchLatencyUs = staticScreen ? SENSOR_PIPELINE_BATCH_LATENCY_US : 0;
+    pipeline->lastTimestamp = 0;
+    pipeline->settleSinceNs = 0;
+    sensor_pipeline_register(pipeline);
+    pipeline->enabled = 1;
+}
+
+void sensor_pipeline_disable(struct sensor_pipeline* pipeline) {
+    if (!pipeline->enabled) {
+        return;
+    }
+    ASensorEventQueue_disableSensor(pipeline->queue, pipeline->sensor);
+    pipeline->enabled = 0;
+}
+
+void sensor_pipeline_set_static(struct sensor_pipeline* pipeline, int staticScreen) {
+    int64_t latency = staticScreen ? SENSOR_PIPELINE_BATCH_LATENCY_US : 0;
+    if (!pipeline->enabled || latency == pipeline->batchLatencyUs
+            || pipeline->registerSensor == NULL) {
+        pipeline->batchLatencyUs = latency;
+        return;
+    }
+    // Un capteur actif doit tre dsactiv avant d'tre enregistr  nouveau.
+    pipeline->batchLatencyUs = latency;
+    ASensorEventQueue_disableSensor(pipeline->queue, pipeline->sensor);
+    sensor_pipeline_register(pipeline);
+}
+
+static void sensor_pipeline_push(struct sensor_pipeline* pipeline, int64_t timestamp) {
+    if (pipeline->ringTail - pipeline->ringHead == SENSOR_PIPELINE_RING) {
+        // Le moteur n'a pas lu l'anneau : l'chantillon le plus ancien est perdu.
+        pipeline->ringHead++;
+        pipeline->stats.overruns++;
+    }
+    struct sensor_sample* sample = &pipeline->ring[pipeline->ringTail & (SENSOR_PIPELINE_RING - 1)];
+    sample->timestamp = timestamp;
+    sample->x = pipeline->filtered[0];
+    sample->y = pipeline->filtered[1];
+    sample->z = pipeline->filtered[2];
+    pipeline->ringTail++;
+    pipeline->stats.samples++;
+}
+
+static void sensor_pipeline_filter(struct sensor_pipeline* pipeline, const ASensorEvent* event) {
+    const float* raw = event->acceleration.v;
+    if (pipeline->lastTimestamp == 0) {
+        pipeline->filtered[0] = raw[0];
+        pipeline->filtered[1] = raw[1];
+        pipeline->filtered[2] = raw[2];
+        pipeline->nextOutputNs = event->timestamp;
+    } else {
+        int64_t dt = event->timestamp - pipeline->lastTimestamp;
+        if (dt <= 0) {
+            return;
+        }
+        float alpha = sensor_pipeline_alpha(dt, SENSOR_PIPELINE_CUTOFF_HZ);
+        float energy = 0;
+        for (int i = 0; i < 3; i++) {
+            float delta = raw[i] - pipeline->filtered[i];
+            pipeline->filtered[i] += alpha * delta;
+            energy += delta < 0 ? -delta : delta;
+        }
+        pipeline->motion += sensor_pipeline_alpha(dt, SENSOR_PIPELINE_MOTION_CUTOFF_HZ)
+                * (energy - pipeline->motion);
+    }
+    pipeline->lastTimestamp = event->timestamp;
+
+    if (event->timestamp >= pipeline->nextOutputNs) {
+        sensor_pipeline_push(pipeline, event->timestamp);
+        pipeline->nextOutputNs += pipeline->outputPeriodNs;
+        if (pipeline->nextOutputNs <= event->timestamp) {
+            pipeline->nextOutputNs = event->timestamp + pipeline->outputPeriodNs;
+        }
+    }
+}
+
+// Choix du palier d'chantillonnage d'aprs le mouvement estim.
+static void sensor_pipeline_adapt(struct sensor_pipeline* pipeline) {
+    int32_t target = SENSOR_PIPELINE_RATE_SLOW_US;
+    if (pipeline->motion >= SENSOR_PIPELINE_MOTION_FAST) {
+        target = SENSOR_PIPELINE_RATE_FAST_US;
+    } else if (pipeline->motion >= SENSOR_PIPELINE_MOTION_NORMAL) {
+        target = SENSOR_PIPELINE_RATE_NORMAL_US;
+    }
+
+    if (target == pipeline->periodUs) {
+        pipeline->settleSinceNs = 0;
+        return;
+    }
+    if (target > pipeline->periodUs) {
+        // Descente : le calme doit durer avant de rduire la frquence.
+        if (pipeline->settleSinceNs == 0 || target != pipeline->settlePeriodUs) {
+            pipeline->settlePeriodUs = target;
+            pipeline->settleSinceNs = pipeline->lastTimestamp;
+            return;
+        }
+        if (pipeline->lastTimestamp - pipeline->settleSinceNs < SENSOR_PIPELINE_SETTLE_NS) {
+            return;
+        }
+    }
+
+    pipeline->periodUs = target;
+    pipeline->settleSinceNs = 0;
+    pipeline->stats.rateChanges++;
+    ASensorEventQueue_setEventRate(pipeline->queue, pipeline->sensor,
+            sensor_pipeline_clamp_period(pipeline, target));
+}
+
+static void sensor_pipeline_filter_batch(struct sensor_pipeline* pipeline, const ASensorEvent* events,
+        size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (events[i].type == ASENSOR_TYPE_ACCELEROMETER) {
+            sensor_pipeline_filter(pipeline, &events[i]);
+        }
+    }
+}
+
+// Bilan d'une lecture de total vnements, puis choix du palier.
+static int sensor_pipeline_account(struct sensor_pipeline* pipeline, int total) {
+    if (total == 0) {
+        return 0;
+    }
+    struct sensor_pipeline_stats* stats = &pipeline->stats;
+    stats->events += total;
+    stats->drains++;
+    if ((uint64_t)total > stats->largestDrain) stats->largestDrain = total;
+
+    if (pipeline->enabled) {
+        sensor_pipeline_adapt(pipeline);
+    }
+    return total;
+}
+
+int sensor_pipeline_drain(struct sensor_pipeline* pipeline) {
+    int total = 0;
+    ssize_t count;
+    while ((count = ASensorEventQueue_getEvents(pipeline->queue, pipeline->batch,
+            SENSOR_PIPELINE_BATCH)) > 0) {
+        if (pipeline->trace != NULL) {
+            event_trace_record_sensors(pipeline->trace, pipeline->batch, (size_t)count);
+        }
+        sensor_pipeline_filter_batch(pipeline, pipeline->batch, (size_t)count);
+        total += (int)count;
+        if (count < SENSOR_PIPELINE_BATCH) {
+            break;
+        }
+    }
+    return sensor_pipeline_account(pipeline, total);
+}
+
+int sensor_pipeline_feed(struct sensor_pipeline* pipeline, const ASensorEvent* events, size_t count) {
+    sensor_pipeline_filter_batch(pipeline, events, count);
+    return sensor_pipeline_account(pipeline, (int)count);
+}
+
+size_t sensor_pipeline_read(struct sensor_pipeline* pipeline, struct sensor_sample* out,
+        size_t count) {
+    size_t n = 0;
+    while (n < count && pipeline->ringHead != pipeline->ringTail) {
+        out[n++] = pipeline->ring[pipeline->ringHead & (SENSOR_PIPELINE_RING - 1)];
+        pipeline->ringHead++;
+    }
+    return n;
+}
+
+void sensor_pipeline_report(struct sensor_pipeline* pipeline,
+        struct sensor_pipeline_stats* outStats) {
+    struct sensor_pipeline_stats* stats = &pipeline->stats;
+    if (stats->drains > 0) {
+        LOGI("events=%llu drains=%llu events/drain=%.1f largest=%llu samples=%llu "
+                "overruns=%llu rate_changes=%llu period_us=%d",
+                (unsigned long long)stats->events, (unsigned long long)stats->drains,
+                stats->events / (double)stats->drains, (unsigned long long)stats->largestDrain,
+                (unsigned long long)stats->samples, (unsigned long long)stats->overruns,
+                (unsigned long long)stats->rateChanges, pipeline->periodUs);
+    }
+    if (outStats != NULL) {
+        *outStats = *stats;
+    }
+    memset(stats, 0, sizeof(*stats));
+}
@@ -0,0 +1,163 @@
+// Lastorm tech.
+
+#ifndef _SENSOR_PIPELINE_H
+#define _SENSOR_PIPELINE_H
+
+#include <stdint.h>
+
+#include <android/sensor.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Chane d'acquisition de l'acclromtre.
+ *
+ * Les vnements sont lus par lots de SENSOR_PIPELINE_BATCH dans un tampon
+ * prallou, filtrs par un passe-bas du premier ordre puis dcims  la
+ * priode de sortie ; les chantillons obtenus sont conservs dans un anneau
+ * que le moteur lit  chaque image. Aucun message n'est journalis par
+ * vnement : un bilan est disponible avec sensor_pipeline_report().
+ *
+ * La frquence d'chantillonnage suit le mouvement observ (trois paliers,
+ * monte immdiate, descente aprs SENSOR_PIPELINE_SETTLE_NS de calme) et,
+ * quand l'cran est statique, les vnements sont groups par la FIFO
+ * matrielle pendant au plus SENSOR_PIPELINE_BATCH_LATENCY_US. Le regroupement
+ * demande ASensorEventQueue_registerSensor(), qui n'existe qu' partir d'Android
+ * 8.0 ; avant, le capteur est activ sans regroupement.
+ *
+ * Toutes les fonctions doivent tre appeles par le thread du looper de la file.
+ */
+
+// vnements lus par appel  ASensorEventQueue_getEvents().
+#define SENSOR_PIPELINE_BATCH 64
+
+// Capacit de l'anneau d'chantillons dcims (puissance de deux).
+#define SENSOR_PIPELINE_RING 64
+
+// Priodes d'chantillonnage des trois paliers, en microsecondes.
+#define SENSOR_PIPELINE_RATE_FAST_US 10000
+#define SENSOR_PIPELINE_RATE_NORMAL_US 16667
+#define SENSOR_PIPELINE_RATE_SLOW_US 100000
+
+// Seuils de mouvement (nergie haute frquence, m/s) des paliers rapide et normal.
+#define SENSOR_PIPELINE_MOTION_FAST 1.0f
+#define SENSOR_PIPELINE_MOTION_NORMAL 0.2f
+
+// Dure de calme avant de descendre d'un palier.
+#define SENSOR_PIPELINE_SETTLE_NS 1000000000LL
+
+// Latence maximale de regroupement quand l'cran est statique.
+#define SENSOR_PIPELINE_BATCH_LATENCY_US 200000
+
+/**
+ * chantillon filtr et dcim.
+ */
+struct sensor_sample {
+    int64_t timestamp;
+    float x;
+    float y;
+    float z;
+};
+
+/**
+ * Bilan de la chane depuis le dernier appel  sensor_pipeline_report().
+ */
+struct sensor_pipeline_stats {
+    uint64_t events;
+    uint64_t drains;
+    uint64_t samples;
+    uint64_t overruns;
+    uint64_t rateChanges;
+    uint64_t largestDrain;
+};
+
+struct sensor_pipeline {
+    ASensorEventQueue* queue;
+    const ASensor* sensor;
+    int enabled;
+
+    // ASensorEventQueue_registerSensor(), NULL avant Android 8.0.
+    int (*registerSensor)(ASensorEventQueue* queue, const ASensor* sensor,
+            int32_t samplingPeriodUs, int64_t maxBatchReportLatencyUs);
+
+    // Rglages courants de la file.
+    int32_t periodUs;
+    int64_t batchLatencyUs;
+
+    // Filtre passe-bas et estimation du mouvement.
+    int64_t lastTimestamp;
+    float filtered[3];
+    float motion;
+
+    // Dcimation : priode de sortie et instant du prochain chantillon.
+    int64_t outputPeriodNs;
+    int64_t nextOutputNs;
+
+    // Palier candidat  la descente et instant depuis lequel il est observ.
+    int32_t settlePeriodUs;
+    int64_t settleSinceNs;
+
+    struct sensor_sample ring[SENSOR_PIPELINE_RING];
+    uint32_t ringHead;
+    uint32_t ringTail;
+
+    ASensorEvent batch[SENSOR_PIPELINE_BATCH];
+
+    // Trace d'vnements : les vnements lus y sont enregistrs bruts (NULL : aucune).
+    struct event_trace* trace;
+
+    struct sensor_pipeline_stats stats;
+};
+
+/**
+ * Initialise la chane pour une file et un acclromtre (qui peut tre NULL).
+ * outputPeriodNs est la priode des chantillons exposs au moteur.
+ */
+void sensor_pipeline_init(struct sensor_pipeline* pipeline, ASensorEventQueue* queue,
+        const ASensor* sensor, int64_t outputPeriodNs);
+
+/**
+ * Active le capteur. Quand staticScreen n'est pas zro, les vnements sont
+ * regroups par la FIFO matrielle.
+ */
+void sensor_pipeline_enable(struct sensor_pipeline* pipeline, int staticScreen);
+void sensor_pipeline_disable(struct sensor_pipeline* pipeline);
+
+/**
+ * Change le mode de regroupement d'un capteur actif.
+ */
+void sensor_pipeline_set_static(struct sensor_pipeline* pipeline, int staticScreen);
+
+/**
+ * Lit tous les vnements en attente ;  appeler quand le looper signale la
+ * file. Retourne le nombre d'vnements lus.
+ */
+int sensor_pipeline_drain(struct sensor_pipeline* pipeline);
+
+/**
+ * Traite count vnements comme s'ils venaient de la file ; sert au rejeu d'une
+ * trace. Retourne count.
+ */
+int sensor_pipeline_feed(struct sensor_pipeline* pipeline, const ASensorEvent* events, size_t count);
+
+/**
+ * Copie au plus count chantillons dcims, du plus ancien au plus rcent, et
+ * les retire de l'anneau. Retourne le nombre d'chantillons copis.
+ */
+size_t sensor_pipeline_read(struct sensor_pipeline* pipeline, struct sensor_sample* out,
+        size_t count);
+
+/**
+ * Copie le bilan courant dans outStats (si non NULL), le journalise et le
+ * remet  zro.
+ */
+void sensor_pipeline_report(struct sensor_pipeline* pipeline,
+        struct sensor_pipeline_stats* outStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SENSOR_PIPELINE_H */
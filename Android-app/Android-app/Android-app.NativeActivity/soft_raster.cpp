@@ -0,0 +1,620 @@
+// Lastorm tech.
+
+ASYNC_LOG_TAG(soft_raster_log_tag, "soft_raster", 1);
+
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, &soft_raster_log_tag, __VA_ARGS__)
+#define LOGW(...) ASYNC_LOG(ANDROID_LOG_WARN, &soft_raster_log_tag, __VA_ARGS__)
+
+enum {
+    SOFT_RASTER_CMD_FILL,
+    SOFT_RASTER_CMD_BLEND,
+    SOFT_RASTER_CMD_BLIT,
+    SOFT_RASTER_CMD_BLIT_BLEND,
+};
+
+/**
+ * Commande enregistre, dj dcoupe aux bornes de la destination.
+ */
+struct soft_raster_command {
+    int type;
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+    uint32_t color;
+
+    // Copies : pixels de l'image et position de son coin suprieur gauche.
+    const uint32_t* pixels;
+    int32_t stride;
+    int32_t x;
+    int32_t y;
+};
+
+/**
+ * Noyaux d'une ligne de count pixels.
+ */
+struct soft_raster_kernels {
+    void (*fill)(uint32_t* dst, int32_t count, uint32_t color);
+    void (*blend)(uint32_t* dst, int32_t count, uint32_t color);
+    void (*copy)(uint32_t* dst, const uint32_t* src, int32_t count);
+    void (*blendImage)(uint32_t* dst, const uint32_t* src, int32_t count);
+};
+
+struct soft_raster {
+    const struct soft_raster_kernels* kernels;
+    int isa;
+
+    struct soft_raster_target target;
+    struct soft_raster_command commands[SOFT_RASTER_MAX_COMMANDS];
+    int commandCount;
+
+    // Tuiles de l'excution en cours, distribues par nextTile.
+    int32_t tilesX;
+    int32_t tileCount;
+    int32_t nextTile;
+
+    // Threads d'aide : rveills par un changement de generation, ils
+    // dcrmentent running en fin d'excution.
+    int helperCount;
+    pthread_t helpers[SOFT_RASTER_MAX_THREADS - 1];
+    pthread_mutex_t mutex;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    uint64_t generation;
+    int running;
+    int stop;
+
+    struct soft_raster_stats stats;
+};
+
+// --------------------------------------------------------------------
+// Noyaux scalaires (rfrence)
+// --------------------------------------------------------------------
+
+// Mlange d'un pixel : la composante alpha de la source vaut 255.
+static inline uint32_t soft_raster_mix(uint32_t s, uint32_t d, uint32_t a) {
+    s |= 0xff000000u;
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        uint32_t t = ((s >> shift) & 0xff) * a + ((d >> shift) & 0xff) * (255 - a) + 128;
+        out |= ((t + (t >> 8)) >> 8) << shift;
+    }
+    return out;
+}
+
+static void soft_raster_fill_scalar(uint32_t* dst, int32_t count, uint32_t color) {
+    for (int32_t i = 0; i < count; i++) {
+        dst[i] = color;
+    }
+}
+
+static void soft_raster_blend_scalar(uint32_t* dst, int32_t count, uint32_t color) {
+    uint32_t a = color >> 24;
+    for (int32_t i = 0; i < count; i++) {
+        dst[i] = soft_raster_mix(color, dst[i], a);
+    }
+}
+
+// Les copies opaques utilisent memcpy(), dj vectorise par la bibliothque C.
+static void soft_raster_copy(uint32_t* dst, const uint32_t* src, int32_t count) {
+    memcpy(dst, src, (size_t)count * sizeof(uint32_t));
+}
+
+static void soft_raster_blend_image_scalar(uint32_t* dst, const uint32_t* src, int32_t count) {
+    for (int32_t i = 0; i < count; i++) {
+        dst[i] = soft_raster_mix(src[i], dst[i], src[i] >> 24);
+    }
+}
+
+// --------------------------------------------------------------------
+// SSE2 et AVX2
+// --------------------------------------------------------------------
+
+#if defined(__SSE2__)
+
+// (t + (t >> 8)) >> 8 sur chaque composante de 16 bits.
+static inline __m128i soft_raster_div255_sse2(__m128i t) {
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+static void soft_raster_fill_sse2(uint32_t* dst, int32_t count, uint32_t color) {
+    __m128i value = _mm_set1_epi32((int)color);
+    int32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        _mm_storeu_si128((__m128i*)(dst + i), value);
+        _mm_storeu_si128((__m128i*)(dst + i + 4), value);
+        _mm_storeu_si128((__m128i*)(dst + i + 8), value);
+        _mm_storeu_si128((__m128i*)(dst + i + 12), value);
+    }
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128((__m128i*)(dst + i), value);
+    }
+    soft_raster_fill_scalar(dst + i, count - i, color);
+}
+
+static void soft_raster_blend_sse2(uint32_t* dst, int32_t count, uint32_t color) {
+    uint32_t a = color >> 24;
+    __m128i zero = _mm_setzero_si128();
+    __m128i source = _mm_unpacklo_epi8(_mm_set1_epi32((int)(color | 0xff000000u)), zero);
+    __m128i scaled = _mm_add_epi16(_mm_mullo_epi16(source, _mm_set1_epi16((short)a)),
+            _mm_set1_epi16(128));
+    __m128i inverse = _mm_set1_epi16((short)(255 - a));
+    int32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i lo = _mm_add_epi16(scaled, _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inverse));
+        __m128i hi = _mm_add_epi16(scaled, _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inverse));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(soft_raster_div255_sse2(lo),
+                soft_raster_div255_sse2(hi)));
+    }
+    soft_raster_blend_scalar(dst + i, count - i, color);
+}
+
+// Deux pixels de 16 bits par composante : alpha diffuse, source d'alpha 255.
+static inline __m128i soft_raster_blend_pair_sse2(__m128i s, __m128i d) {
+    __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xff), 0xff);
+    __m128i opaque = _mm_or_si128(s, _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0));
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(opaque, alpha),
+            _mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(255), alpha)));
+    return soft_raster_div255_sse2(_mm_add_epi16(t, _mm_set1_epi16(128)));
+}
+
+static void soft_raster_blend_image_sse2(uint32_t* dst, const uint32_t* src, int32_t count) {
+    __m128i zero = _mm_setzero_si128();
+    int32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i lo = soft_raster_blend_pair_sse2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+        __m128i hi = soft_raster_blend_pair_sse2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    soft_raster_blend_image_scalar(dst + i, src + i, count - i);
+}
+
+#define SOFT_RASTER_AVX2 __attribute__((target("avx2")))
+
+SOFT_RASTER_AVX2 static inline __m256i soft_raster_div255_avx2(__m256i t) {
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+SOFT_RASTER_AVX2 static void soft_raster_fill_avx2(uint32_t* dst, int32_t count, uint32_t color) {
+    __m256i value = _mm256_set1_epi32((int)color);
+    int32_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        _mm256_storeu_si256((__m256i*)(dst + i), value);
+        _mm256_storeu_si256((__m256i*)(dst + i + 8), value);
+        _mm256_storeu_si256((__m256i*)(dst + i + 16), value);
+        _mm256_storeu_si256((__m256i*)(dst + i + 24), value);
+    }
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_si256((__m256i*)(dst + i), value);
+    }
+    // Les fins de ligne passent par du code non VEX : la moiti haute des
+    // registres est remise  zro pour viter la pnalit de transition.
+    _mm256_zeroupper();
+    soft_raster_fill_scalar(dst + i, count - i, color);
+}
+
+SOFT_RASTER_AVX2 static void soft_raster_blend_avx2(uint32_t* dst, int32_t count, uint32_t color) {
+    uint32_t a = color >> 24;
+    __m256i zero = _mm256_setzero_si256();
+    __m256i source = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)(color | 0xff000000u)), zero);
+    __m256i scaled = _mm256_add_epi16(_mm256_mullo_epi16(source, _mm256_set1_epi16((short)a)),
+            _mm256_set1_epi16(128));
+    __m256i inverse = _mm256_set1_epi16((short)(255 - a));
+    int32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i lo = _mm256_add_epi16(scaled, _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), inverse));
+        __m256i hi = _mm256_add_epi16(scaled, _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), inverse));
+        // Dcompression et recompression par moiti de registre : l'ordre des pixels est conserv.
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(soft_raster_div255_avx2(lo),
+                soft_raster_div255_avx2(hi)));
+    }
+    _mm256_zeroupper();
+    soft_raster_blend_sse2(dst + i, count - i, color);
+}
+
+SOFT_RASTER_AVX2 static inline __m256i soft_raster_blend_pair_avx2(__m256i s, __m256i d) {
+    __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xff), 0xff);
+    __m256i opaque = _mm256_or_si256(s, _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0,
+            255, 0, 0, 0, 255, 0, 0, 0));
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(opaque, alpha),
+            _mm256_mullo_epi16(d, _mm256_sub_epi16(_mm256_set1_epi16(255), alpha)));
+    return soft_raster_div255_avx2(_mm256_add_epi16(t, _mm256_set1_epi16(128)));
+}
+
+SOFT_RASTER_AVX2 static void soft_raster_blend_image_avx2(uint32_t* dst, const uint32_t* src,
+        int32_t count) {
+    __m256i zero = _mm256_setzero_si256();
+    int32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i lo = soft_raster_blend_pair_avx2(_mm256_unpacklo_epi8(s, zero),
+                _mm256_unpacklo_epi8(d, zero));
+        __m256i hi = soft_raster_blend_pair_avx2(_mm256_unpackhi_epi8(s, zero),
+                _mm256_unpackhi_epi8(d, zero));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+    _mm256_zeroupper();
+    soft_raster_blend_image_sse2(dst + i, src + i, count - i);
+}
+
+#endif
+
+// --------------------------------------------------------------------
+// NEON
+// --------------------------------------------------------------------
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+static inline uint8x8_t soft_raster_div255_neon(uint16x8_t t) {
+    return vshrn_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8);
+}
+
+static void soft_raster_fill_neon(uint32_t* dst, int32_t count, uint32_t color) {
+    uint32x4_t value = vdupq_n_u32(color);
+    int32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        vst1q_u32(dst + i, value);
+        vst1q_u32(dst + i + 4, value);
+        vst1q_u32(dst + i + 8, value);
+        vst1q_u32(dst + i + 12, value);
+    }
+    for (; i + 4 <= count; i += 4) {
+        vst1q_u32(dst + i, value);
+    }
+    soft_raster_fill_scalar(dst + i, count - i, color);
+}
+
+static void soft_raster_blend_neon(uint32_t* dst, int32_t count, uint32_t color) {
+    uint32_t a = color >> 24;
+    uint8x8_t inverse = vdup_n_u8((uint8_t)(255 - a));
+    uint16x8_t scaled[4];
+    for (int c = 0; c < 4; c++) {
+        uint32_t s = c == 3 ? 255 : (color >> (8 * c)) & 0xff;
+        scaled[c] = vdupq_n_u16((uint16_t)(s * a + 128));
+    }
+    int32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // Dsentrelacement : un registre par composante.
+        uint8x8x4_t d = vld4_u8((const uint8_t*)(dst + i));
+        for (int c = 0; c < 4; c++) {
+            d.val[c] = soft_raster_div255_neon(vmlal_u8(scaled[c], d.val[c], inverse));
+        }
+        vst4_u8((uint8_t*)(dst + i), d);
+    }
+    soft_raster_blend_scalar(dst + i, count - i, color);
+}
+
+static void soft_raster_blend_image_neon(uint32_t* dst, const uint32_t* src, int32_t count) {
+    uint16x8_t half = vdupq_n_u16(128);
+    int32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint8x8x4_t s = vld4_u8((const uint8_t*)(src + i));
+        uint8x8x4_t d = vld4_u8((const uint8_t*)(dst + i));
+        uint8x8_t alpha = s.val[3];
+        uint8x8_t inverse = vmvn_u8(alpha);
+        s.val[3] = vdup_n_u8(255);
+        for (int c = 0; c < 4; c++) {
+            uint16x8_t t = vmlal_u8(vmull_u8(s.val[c], alpha), d.val[c], inverse);
+            d.val[c] = soft_raster_div255_neon(vaddq_u16(t, half));
+        }
+        vst4_u8((uint8_t*)(dst + i), d);
+    }
+    soft_raster_blend_image_scalar(dst + i, src + i, count - i);
+}
+
+#endif
+
+static const struct soft_raster_kernels soft_raster_kernel_table[SOFT_RASTER_ISA_COUNT] = {
+    { soft_raster_fill_scalar, soft_raster_blend_scalar, soft_raster_copy,
+        soft_raster_blend_image_scalar },
+#if defined(__SSE2__)
+    { soft_raster_fill_sse2, soft_raster_blend_sse2, soft_raster_copy, soft_raster_blend_image_sse2 },
+    { soft_raster_fill_avx2, soft_raster_blend_avx2, soft_raster_copy, soft_raster_blend_image_avx2 },
+#else
+    { NULL, NULL, NULL, NULL },
+    { NULL, NULL, NULL, NULL },
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    { soft_raster_fill_neon, soft_raster_blend_neon, soft_raster_copy, soft_raster_blend_image_neon },
+#else
+    { NULL, NULL, NULL, NULL },
+#endif
+};
+
+static const char* const soft_raster_isa_names[SOFT_RASTER_ISA_COUNT] = {
+    "scalar", "sse2", "avx2", "neon",
+};
+
+int soft_raster_best_isa(void) {
+#if defined(__SSE2__)
+    return __builtin_cpu_supports("avx2") ? SOFT_RASTER_ISA_AVX2 : SOFT_RASTER_ISA_SSE2;
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    return SOFT_RASTER_ISA_NEON;
+#else
+    return SOFT_RASTER_ISA_SCALAR;
+#endif
+}
+
+const char* soft_raster_isa_name(int isa) {
+    return isa >= 0 && isa < SOFT_RASTER_ISA_COUNT ? soft_raster_isa_names[isa] : "unknown";
+}
+
+int soft_raster_set_isa(struct soft_raster* raster, int isa) {
+    // Un jeu absent de la compilation ou de l'appareil retombe sur le meilleur disponible.
+    int best = soft_raster_best_isa();
+    if (isa < 0 || isa >= SOFT_RASTER_ISA_COUNT || soft_raster_kernel_table[isa].fill == NULL
+            || (isa == SOFT_RASTER_ISA_AVX2 && best != SOFT_RASTER_ISA_AVX2)) {
+        isa = best;
+    }
+    raster->isa = isa;
+    raster->kernels = &soft_raster_kernel_table[isa];
+    return isa;
+}
+
+// --------------------------------------------------------------------
+// Excution par tuiles
+// --------------------------------------------------------------------
+
+static void soft_raster_run_tile(struct soft_raster* raster, int32_t tile) {
+    const struct soft_raster_kernels* kernels = raster->kernels;
+    const struct soft_raster_target* target = &raster->target;
+    int32_t tileLeft = (tile % raster->tilesX) * SOFT_RASTER_TILE;
+    int32_t tileTop = (tile / raster->tilesX) * SOFT_RASTER_TILE;
+    int32_t tileRight = tileLeft + SOFT_RASTER_TILE < target->width ? tileLeft + SOFT_RASTER_TILE
+            : target->width;
+    int32_t tileBottom = tileTop + SOFT_RASTER_TILE < target->height ? tileTop + SOFT_RASTER_TILE
+            : target->height;
+
+    for (int i = 0; i < raster->commandCount; i++) {
+        const struct soft_raster_command* command = &raster->commands[i];
+        int32_t left = command->left > tileLeft ? command->left : tileLeft;
+        int32_t right = command->right < tileRight ? command->right : tileRight;
+        int32_t top = command->top > tileTop ? command->top : tileTop;
+        int32_t bottom = command->bottom < tileBottom ? command->bottom : tileBottom;
+        if (left >= right || top >= bottom) {
+            continue;
+        }
+        int32_t count = right - left;
+        uint32_t* dst = target->pixels + (size_t)top * target->stride + left;
+        const uint32_t* src = command->pixels + (size_t)(top - command->y) * command->stride
+                + (left - command->x);
+        for (int32_t y = top; y < bottom; y++) {
+            switch (command->type) {
+                case SOFT_RASTER_CMD_FILL:
+                    kernels->fill(dst, count, command->color);
+                    break;
+                case SOFT_RASTER_CMD_BLEND:
+                    kernels->blend(dst, count, command->color);
+                    break;
+                case SOFT_RASTER_CMD_BLIT:
+                    kernels->copy(dst, src, count);
+                    break;
+                case SOFT_RASTER_CMD_BLIT_BLEND:
+                    kernels->blendImage(dst, src, count);
+                    break;
+            }
+            dst += target->stride;
+            src += command->stride;
+        }
+    }
+}
+
+static void soft_raster_work(struct soft_raster* raster) {
+    for (;;) {
+        int32_t tile = __atomic_fetch_add(&raster->nextTile, 1, __ATOMIC_RELAXED);
+        if (tile >= raster->tileCount) {
+            break;
+        }
+        soft_raster_run_tile(raster, tile);
+    }
+}
+
+static void* soft_raster_helper_main(void* param) {
+    struct soft_raster* raster = (struct soft_raster*)param;
+    // generation vaut 0  la cration : une excution lance avant le dmarrage
+    // de ce thread n'est pas manque.
+    uint64_t seen = 0;
+    pthread_mutex_lock(&raster->mutex);
+    for (;;) {
+        while (raster->generation == seen && !raster->stop) {
+            pthread_cond_wait(&raster->start, &raster->mutex);
+        }
+        if (raster->stop) {
+            break;
+        }
+        seen = raster->generation;
+        pthread_mutex_unlock(&raster->mutex);
+        soft_raster_work(raster);
+        pthread_mutex_lock(&raster->mutex);
+        if (--raster->running == 0) {
+            pthread_cond_signal(&raster->done);
+        }
+    }
+    pthread_mutex_unlock(&raster->mutex);
+    return NULL;
+}
+
+// Excute les commandes en attente sur toutes les tuiles de la destination.
+static void soft_raster_flush(struct soft_raster* raster) {
+    if (raster->commandCount == 0) {
+        return;
+    }
+    const struct soft_raster_target* target = &raster->target;
+    raster->tilesX = (target->width + SOFT_RASTER_TILE - 1) / SOFT_RASTER_TILE;
+    raster->tileCount = raster->tilesX * ((target->height + SOFT_RASTER_TILE - 1) / SOFT_RASTER_TILE);
+    __atomic_store_n(&raster->nextTile, 0, __ATOMIC_RELAXED);
+
+    // Les threads d'aide ne sont rveills que si chacun peut avoir une tuile.
+    int helpers = raster->tileCount > raster->helperCount ? raster->helperCount : 0;
+    if (helpers > 0) {
+        pthread_mutex_lock(&raster->mutex);
+        raster->running = helpers;
+        raster->generation++;
+        pthread_cond_broadcast(&raster->start);
+        pthread_mutex_unlock(&raster->mutex);
+    }
+    soft_raster_work(raster);
+    if (helpers > 0) {
+        pthread_mutex_lock(&raster->mutex);
+        while (raster->running > 0) {
+            pthread_cond_wait(&raster->done, &raster->mutex);
+        }
+        pthread_mutex_unlock(&raster->mutex);
+    }
+
+    raster->stats.commands += raster->commandCount;
+    raster->stats.tiles += raster->tileCount;
+    raster->commandCount = 0;
+}
+
+// --------------------------------------------------------------------
+// Enregistrement
+// --------------------------------------------------------------------
+
+// Nouvelle commande couvrant (left, top)-(right, bottom), dcoupe  la
+// destination ; NULL si elle est vide.
+static struct soft_raster_command* soft_raster_record(struct soft_raster* raster, int type,
+        int32_t left, int32_t top, int32_t right, int32_t bottom) {
+    const struct soft_raster_target* target = &raster->target;
+    if (target->pixels == NULL) {
+        return NULL;
+    }
+    if (left < 0) left = 0;
+    if (top < 0) top = 0;
+    if (right > target->width) right = target->width;
+    if (bottom > target->height) bottom = target->height;
+    if (left >= right || top >= bottom) {
+        return NULL;
+    }
+    if (raster->commandCount == SOFT_RASTER_MAX_COMMANDS) {
+        soft_raster_flush(raster);
+    }
+    struct soft_raster_command* command = &raster->commands[raster->commandCount++];
+    command->type = type;
+    command->left = left;
+    command->top = top;
+    command->right = right;
+    command->bottom = bottom;
+    command->color = 0;
+    command->pixels = NULL;
+    command->stride = 0;
+    command->x = left;
+    command->y = top;
+    raster->stats.pixels += (uint64_t)(right - left) * (uint64_t)(bottom - top);
+    return command;
+}
+
+struct soft_raster* soft_raster_create(int threads) {
+    struct soft_raster* raster = (struct soft_raster*)calloc(1, sizeof(struct soft_raster));
+    if (raster == NULL) {
+        return NULL;
+    }
+    soft_raster_set_isa(raster, soft_raster_best_isa());
+    if (threads <= 0) {
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (threads > SOFT_RASTER_MAX_THREADS) threads = SOFT_RASTER_MAX_THREADS;
+    if (threads < 1) threads = 1;
+
+    pthread_mutex_init(&raster->mutex, NULL);
+    pthread_cond_init(&raster->start, NULL);
+    pthread_cond_init(&raster->done, NULL);
+    for (int i = 0; i < threads - 1; i++) {
+        if (pthread_create(&raster->helpers[i], NULL, soft_raster_helper_main, raster) != 0) {
+            LOGW("Unable to start raster helper %d", i);
+            break;
+        }
+        raster->helperCount++;
+    }
+    LOGI("software raster: %s, %d threads", soft_raster_isa_name(raster->isa),
+            raster->helperCount + 1);
+    return raster;
+}
+
+void soft_raster_destroy(struct soft_raster* raster) {
+    if (raster == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&raster->mutex);
+    raster->stop = 1;
+    pthread_cond_broadcast(&raster->start);
+    pthread_mutex_unlock(&raster->mutex);
+    for (int i = 0; i < raster->helperCount; i++) {
+        pthread_join(raster->helpers[i], NULL);
+    }
+    pthread_cond_destroy(&raster->done);
+    pthread_cond_destroy(&raster->start);
+    pthread_mutex_destroy(&raster->mutex);
+    free(raster);
+}
+
+int soft_raster_get_threads(const struct soft_raster* raster) {
+    return raster->helperCount + 1;
+}
+
+void soft_raster_begin(struct soft_raster* raster, const struct soft_raster_target* target) {
+    raster->target = *target;
+    raster->commandCount = 0;
+}
+
+void soft_raster_clear(struct soft_raster* raster, uint32_t color) {
+    // Tout ce qui prcde est recouvert.
+    raster->commandCount = 0;
+    struct soft_raster_command* command = soft_raster_record(raster, SOFT_RASTER_CMD_FILL,
+            0, 0, raster->target.width, raster->target.height);
+    if (command != NULL) {
+        command->color = color;
+    }
+}
+
+void soft_raster_fill(struct soft_raster* raster, int32_t x, int32_t y, int32_t width,
+        int32_t height, uint32_t color) {
+    struct soft_raster_command* command = soft_raster_record(raster, SOFT_RASTER_CMD_FILL,
+            x, y, x + width, y + height);
+    if (command != NULL) {
+        command->color = color;
+    }
+}
+
+void soft_raster_blend(struct soft_raster* raster, int32_t x, int32_t y, int32_t width,
+        int32_t height, uint32_t color) {
+    uint32_t alpha = color >> 24;
+    if (alpha == 0) {
+        return;
+    }
+    struct soft_raster_command* command = soft_raster_record(raster,
+            alpha == 255 ? SOFT_RASTER_CMD_FILL : SOFT_RASTER_CMD_BLEND, x, y, x + width, y + height);
+    if (command != NULL) {
+        command->color = color;
+    }
+}
+
+void soft_raster_blit(struct soft_raster* raster, int32_t x, int32_t y,
+        const struct soft_raster_image* image, int blend) {
+    struct soft_raster_command* command = soft_raster_record(raster,
+            blend ? SOFT_RASTER_CMD_BLIT_BLEND : SOFT_RASTER_CMD_BLIT,
+            x, y, x + image->width, y + image->height);
+    if (command != NULL) {
+        command->pixels = image->pixels;
+        command->stride = image->stride;
+        command->x = x;
+        command->y = y;
+    }
+}
+
+void soft_raster_end(struct soft_raster* raster) {
+    int64_t start = frame_timing_now();
+    soft_raster_flush(raster);
+    raster->stats.frames++;
+    raster->stats.lastFrameNs = frame_timing_now() - start;
+    memset(&raster->target, 0, sizeof(raster->target));
+}
+
+void soft_raster_get_stats(const struct soft_raster* raster, struct soft_raster_stats* outStats) {
+    *outStats = raster->stats;
+}
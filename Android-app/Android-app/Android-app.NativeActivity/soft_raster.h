@@ -0,0 +1,146 @@
+// Lastorm tech.
+
+#ifndef _SOFT_RASTER_H
+#define _SOFT_RASTER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Rendu logiciel dans les tampons d'une ANativeWindow.
+ *
+ * Utilis quand EGL n'est pas disponible (machine sans GPU, pilote dfaillant)
+ * ou impos par ENGINE_RENDER_BACKEND : l'image est dessine entre
+ * ANativeWindow_lock() et ANativeWindow_unlockAndPost(), au format
+ * WINDOW_FORMAT_RGBA_8888 ou RGBX_8888 (octets R, G, B, A en mmoire).
+ *
+ * Les commandes d'une image (effacement, rectangles opaques ou transparents,
+ * copies d'images opaques ou transparentes) sont enregistres entre
+ * soft_raster_begin() et soft_raster_end(), puis excutes par tuiles de
+ * SOFT_RASTER_TILE pixels : chaque tuile applique toutes les commandes dans
+ * l'ordre, dcoupes  ses bornes, et les tuiles sont rparties entre le
+ * thread appelant et des threads d'aide. Le rsultat ne dpend ni du nombre de
+ * threads ni du jeu d'instructions.
+ *
+ * Les noyaux de ligne existent en version scalaire (rfrence), SSE2, AVX2
+ * (choisie  l'excution) et NEON. Le mlange est  source par-dessus  avec
+ * une alpha non prmultiplie, arrondi exactement :
+ *
+ *      t = s * a + d * (255 - a) + 128
+ *      r = (t + (t >> 8)) >> 8             (= arrondi de (s * a + d * (255 - a)) / 255)
+ *
+ * la composante alpha de la source valant 255 dans ce calcul.
+ *
+ * Les fonctions sont rserves au thread qui dessine.
+ */
+
+// Ct d'une tuile, en pixels.
+#define SOFT_RASTER_TILE 64
+
+// Commandes d'une image ; au-del, les commandes en attente sont excutes.
+#define SOFT_RASTER_MAX_COMMANDS 1024
+
+// Threads d'excution, thread appelant compris.
+#define SOFT_RASTER_MAX_THREADS 4
+
+// Jeux d'instructions des noyaux.
+enum {
+    SOFT_RASTER_ISA_SCALAR,
+    SOFT_RASTER_ISA_SSE2,
+    SOFT_RASTER_ISA_AVX2,
+    SOFT_RASTER_ISA_NEON,
+
+    SOFT_RASTER_ISA_COUNT
+};
+
+// Couleur au format des tampons : R dans l'octet de poids faible.
+#define SOFT_RASTER_RGBA(r, g, b, a) ((uint32_t)(r) | (uint32_t)(g) << 8 \
+        | (uint32_t)(b) << 16 | (uint32_t)(a) << 24)
+
+/**
+ * Tampon destination ou image source ; stride est exprim en pixels.
+ */
+struct soft_raster_target {
+    uint32_t* pixels;
+    int32_t width;
+    int32_t height;
+    int32_t stride;
+};
+
+struct soft_raster_image {
+    const uint32_t* pixels;
+    int32_t width;
+    int32_t height;
+    int32_t stride;
+};
+
+struct soft_raster_stats {
+    uint64_t frames;
+    uint64_t commands;
+    uint64_t tiles;
+
+    // Pixels crits par les commandes, aprs dcoupage.
+    uint64_t pixels;
+
+    // Dure de la dernire excution (soft_raster_end()).
+    int64_t lastFrameNs;
+};
+
+struct soft_raster;
+
+/**
+ * Cre un moteur de rendu excut par threads threads au plus (thread appelant
+ * compris) ; 0 choisit selon le nombre de curs. Retourne NULL en cas d'erreur.
+ */
+struct soft_raster* soft_raster_create(int threads);
+
+void soft_raster_destroy(struct soft_raster* raster);
+
+/**
+ * Meilleur jeu d'instructions de l'appareil, puis choix du jeu utilis (pour
+ * les comparaisons) : retourne le jeu effectivement retenu.
+ */
+int soft_raster_best_isa(void);
+int soft_raster_set_isa(struct soft_raster* raster, int isa);
+const char* soft_raster_isa_name(int isa);
+
+int soft_raster_get_threads(const struct soft_raster* raster);
+
+/**
+ * Dbut d'une image dans target, valable jusqu' soft_raster_end().
+ */
+void soft_raster_begin(struct soft_raster* raster, const struct soft_raster_target* target);
+
+void soft_raster_clear(struct soft_raster* raster, uint32_t color);
+
+/**
+ * Rectangle opaque, puis rectangle mlang selon l'alpha de color.
+ */
+void soft_raster_fill(struct soft_raster* raster, int32_t x, int32_t y, int32_t width,
+        int32_t height, uint32_t color);
+void soft_raster_blend(struct soft_raster* raster, int32_t x, int32_t y, int32_t width,
+        int32_t height, uint32_t color);
+
+/**
+ * Copie d'une image en (x, y) : telle quelle, ou mlange selon l'alpha de
+ * chaque pixel si blend n'est pas nul. L'image doit rester valable jusqu'
+ * soft_raster_end().
+ */
+void soft_raster_blit(struct soft_raster* raster, int32_t x, int32_t y,
+        const struct soft_raster_image* image, int blend);
+
+/**
+ * Excute les commandes enregistres ; le tampon est complet au retour.
+ */
+void soft_raster_end(struct soft_raster* raster);
+
+void soft_raster_get_stats(const struct soft_raster* raster, struct soft_raster_stats* outStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SOFT_RASTER_H */
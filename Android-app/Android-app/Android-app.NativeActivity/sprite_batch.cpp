@@ -0,0 +1,619 @@
+// Lastorm tech.
+
+ASYNC_LOG_TAG(sprite_batch_log_tag, "sprite_batch", 4);
+
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, &sprite_batch_log_tag, __VA_ARGS__)
+#define LOGW(...) ASYNC_LOG(ANDROID_LOG_WARN, &sprite_batch_log_tag, __VA_ARGS__)
+
+// Sommet du chemin dvelopp.
+struct sprite_batch_vertex {
+    float x;
+    float y;
+    float u;
+    float v;
+    uint32_t color;
+};
+
+// Fonctions d'OpenGL ES 3 et de GL_EXT_buffer_storage, obtenues  l'excution.
+struct sprite_batch_gl3 {
+    PFNGLMAPBUFFERRANGEPROC mapBufferRange;
+    PFNGLFLUSHMAPPEDBUFFERRANGEPROC flushMappedBufferRange;
+    PFNGLUNMAPBUFFERPROC unmapBuffer;
+    PFNGLTEXIMAGE3DPROC texImage3D;
+    PFNGLTEXSUBIMAGE3DPROC texSubImage3D;
+    PFNGLVERTEXATTRIBIPOINTERPROC vertexAttribIPointer;
+    PFNGLVERTEXATTRIBDIVISORPROC vertexAttribDivisor;
+    PFNGLDRAWARRAYSINSTANCEDPROC drawArraysInstanced;
+    PFNGLFENCESYNCPROC fenceSync;
+    PFNGLCLIENTWAITSYNCPROC clientWaitSync;
+    PFNGLDELETESYNCPROC deleteSync;
+
+    // NULL sans GL_EXT_buffer_storage.
+    PFNGLBUFFERSTORAGEEXTPROC bufferStorage;
+};
+
+// Emplacements des attributs.
+enum {
+    // Chemin instanci.
+    SPRITE_BATCH_ATTRIB_RECT = 0,
+    SPRITE_BATCH_ATTRIB_REGION = 1,
+    SPRITE_BATCH_ATTRIB_LAYER = 3,
+
+    // Chemin dvelopp.
+    SPRITE_BATCH_ATTRIB_POSITION = 0,
+    SPRITE_BATCH_ATTRIB_TEXCOORD = 1,
+
+    // Les deux.
+    SPRITE_BATCH_ATTRIB_COLOR = 2,
+};
+
+struct sprite_batch {
+    struct sprite_batch_gl3 gl3;
+    int path;
+    int stream;
+
+    int32_t textureWidth;
+    int32_t textureHeight;
+    int32_t layers;
+
+    GLuint program;
+    GLint scaleLocation;
+    GLuint buffer;
+    GLuint indices;
+
+    // Texture tableau (chemin instanci) ou une texture par image (chemin dvelopp).
+    GLuint arrayTexture;
+    GLuint* textures;
+
+    size_t spriteBytes;
+    size_t segmentBytes;
+
+    // Projection persistante de tout l'anneau, ou copie d'un lot.
+    uint8_t* persistent;
+    uint8_t* staging;
+
+    GLsync fences[SPRITE_BATCH_SEGMENTS];
+    int segment;
+    size_t segmentUsed;
+
+    // Lot en cours : emplacement d'criture, sprites crits, capacit, projection
+    // par glMapBufferRange() et image (chemin dvelopp).
+    uint8_t* cursor;
+    uint32_t count;
+    uint32_t capacity;
+    int mapped;
+    uint32_t layer;
+
+    struct sprite_batch_stats stats;
+};
+
+static const char sprite_batch_instanced_vertex[] =
+    "#version 300 es\n"
+    "in vec4 rect;\n"
+    "in vec4 region;\n"
+    "in vec4 color;\n"
+    "in uint layer;\n"
+    "uniform vec2 scale;\n"
+    "out vec3 texCoord;\n"
+    "out vec4 tint;\n"
+    "void main() {\n"
+    "    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));\n"
+    "    gl_Position = vec4((rect.xy + corner * rect.zw) * scale + vec2(-1.0, 1.0), 0.0, 1.0);\n"
+    "    texCoord = vec3(mix(region.xy, region.zw, corner), float(layer));\n"
+    "    tint = color;\n"
+    "}\n";
+
+static const char sprite_batch_instanced_fragment[] =
+    "#version 300 es\n"
+    "precision mediump float;\n"
+    "uniform mediump sampler2DArray image;\n"
+    "in vec3 texCoord;\n"
+    "in vec4 tint;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    fragColor = texture(image, texCoord) * tint;\n"
+    "}\n";
+
+static const char sprite_batch_expanded_vertex[] =
+    "attribute vec2 position;\n"
+    "attribute vec2 texCoord;\n"
+    "attribute vec4 color;\n"
+    "uniform vec2 scale;\n"
+    "varying vec2 uv;\n"
+    "varying vec4 tint;\n"
+    "void main() {\n"
+    "    gl_Position = vec4(position * scale + vec2(-1.0, 1.0), 0.0, 1.0);\n"
+    "    uv = texCoord;\n"
+    "    tint = color;\n"
+    "}\n";
+
+static const char sprite_batch_expanded_fragment[] =
+    "precision mediump float;\n"
+    "uniform sampler2D image;\n"
+    "varying vec2 uv;\n"
+    "varying vec4 tint;\n"
+    "void main() {\n"
+    "    gl_FragColor = texture2D(image, uv) * tint;\n"
+    "}\n";
+
+static const char* const sprite_batch_path_names[] = { "instanced", "expanded" };
+static const char* const sprite_batch_stream_names[] = { "persistent", "mapped", "copied" };
+
+const char* sprite_batch_path_name(int path) {
+    return path >= 0 && path <= SPRITE_BATCH_PATH_EXPANDED ? sprite_batch_path_names[path] : "?";
+}
+
+const char* sprite_batch_stream_name(int stream) {
+    return stream >= 0 && stream <= SPRITE_BATCH_STREAM_COPIED ? sprite_batch_stream_names[stream] : "?";
+}
+
+int sprite_batch_get_path(const struct sprite_batch* batch) {
+    return batch->path;
+}
+
+int sprite_batch_get_stream(const struct sprite_batch* batch) {
+    return batch->stream;
+}
+
+// Version majeure d'OpenGL ES du contexte courant, 0 si ce n'est pas OpenGL ES
+// 2 ou plus ( OpenGL ES-CM 1.1 ).
+static int sprite_batch_gles_major(void) {
+    const char* version = (const char*)glGetString(GL_VERSION);
+    int major = 0;
+    if (version == NULL || sscanf(version, "OpenGL ES %d", &major) != 1) {
+        return 0;
+    }
+    return major;
+}
+
+static int sprite_batch_load_gl3(struct sprite_batch_gl3* gl3) {
+    gl3->mapBufferRange = (PFNGLMAPBUFFERRANGEPROC)eglGetProcAddress("glMapBufferRange");
+    gl3->flushMappedBufferRange =
+            (PFNGLFLUSHMAPPEDBUFFERRANGEPROC)eglGetProcAddress("glFlushMappedBufferRange");
+    gl3->unmapBuffer = (PFNGLUNMAPBUFFERPROC)eglGetProcAddress("glUnmapBuffer");
+    gl3->texImage3D = (PFNGLTEXIMAGE3DPROC)eglGetProcAddress("glTexImage3D");
+    gl3->texSubImage3D = (PFNGLTEXSUBIMAGE3DPROC)eglGetProcAddress("glTexSubImage3D");
+    gl3->vertexAttribIPointer =
+            (PFNGLVERTEXATTRIBIPOINTERPROC)eglGetProcAddress("glVertexAttribIPointer");
+    gl3->vertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORPROC)eglGetProcAddress("glVertexAttribDivisor");
+    gl3->drawArraysInstanced = (PFNGLDRAWARRAYSINSTANCEDPROC)eglGetProcAddress("glDrawArraysInstanced");
+    gl3->fenceSync = (PFNGLFENCESYNCPROC)eglGetProcAddress("glFenceSync");
+    gl3->clientWaitSync = (PFNGLCLIENTWAITSYNCPROC)eglGetProcAddress("glClientWaitSync");
+    gl3->deleteSync = (PFNGLDELETESYNCPROC)eglGetProcAddress("glDeleteSync");
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    gl3->bufferStorage = extensions != NULL
+            && display_manager_has_extension(extensions, "GL_EXT_buffer_storage")
+            ? (PFNGLBUFFERSTORAGEEXTPROC)eglGetProcAddress("glBufferStorageEXT") : NULL;
+    return gl3->mapBufferRange != NULL && gl3->flushMappedBufferRange != NULL
+            && gl3->unmapBuffer != NULL && gl3->texImage3D != NULL && gl3->texSubImage3D != NULL
+            && gl3->vertexAttribIPointer != NULL && gl3->vertexAttribDivisor != NULL
+            && gl3->drawArraysInstanced != NULL && gl3->fenceSync != NULL
+            && gl3->clientWaitSync != NULL && gl3->deleteSync != NULL ? 0 : -1;
+}
+
+static GLuint sprite_batch_compile(GLenum type, const char* source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (compiled != GL_TRUE) {
+        char log[512] = "";
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        LOGW("Unable to compile the %s shader: %s", type == GL_VERTEX_SHADER ? "vertex" : "fragment", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+static GLuint sprite_batch_link(int path) {
+    int instanced = path == SPRITE_BATCH_PATH_INSTANCED;
+    GLuint vertex = sprite_batch_compile(GL_VERTEX_SHADER,
+            instanced ? sprite_batch_instanced_vertex : sprite_batch_expanded_vertex);
+    GLuint fragment = sprite_batch_compile(GL_FRAGMENT_SHADER,
+            instanced ? sprite_batch_instanced_fragment : sprite_batch_expanded_fragment);
+    if (vertex == 0 || fragment == 0) {
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        return 0;
+    }
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    if (instanced) {
+        glBindAttribLocation(program, SPRITE_BATCH_ATTRIB_RECT, "rect");
+        glBindAttribLocation(program, SPRITE_BATCH_ATTRIB_REGION, "region");
+        glBindAttribLocation(program, SPRITE_BATCH_ATTRIB_LAYER, "layer");
+    } else {
+        glBindAttribLocation(program, SPRITE_BATCH_ATTRIB_POSITION, "position");
+        glBindAttribLocation(program, SPRITE_BATCH_ATTRIB_TEXCOORD, "texCoord");
+    }
+    glBindAttribLocation(program, SPRITE_BATCH_ATTRIB_COLOR, "color");
+    glLinkProgram(program);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (linked != GL_TRUE) {
+        char log[512] = "";
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        LOGW("Unable to link the %s program: %s", sprite_batch_path_name(path), log);
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+static void sprite_batch_texture_parameters(GLenum target) {
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+// Anneau en flux : projection persistante si possible, sinon stockage modifiable.
+static void sprite_batch_create_buffer(struct sprite_batch* batch, int hasGl3, int flags) {
+    const struct sprite_batch_gl3* gl3 = &batch->gl3;
+    GLsizeiptr size = (GLsizeiptr)(batch->segmentBytes * SPRITE_BATCH_SEGMENTS);
+    batch->stats.bufferBytes = (uint64_t)size;
+    if (hasGl3 && gl3->bufferStorage != NULL && !(flags & SPRITE_BATCH_NO_PERSISTENT)) {
+        const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT_EXT | GL_MAP_COHERENT_BIT_EXT;
+        glGenBuffers(1, &batch->buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, batch->buffer);
+        gl3->bufferStorage(GL_ARRAY_BUFFER, size, NULL, access);
+        batch->persistent = (uint8_t*)gl3->mapBufferRange(GL_ARRAY_BUFFER, 0, size, access);
+        if (batch->persistent != NULL) {
+            batch->stream = SPRITE_BATCH_STREAM_PERSISTENT;
+            return;
+        }
+        // Stockage immuable non projetable : un tampon ordinaire le remplace.
+        LOGW("Unable to map the sprite buffer persistently: 0x%x", glGetError());
+        glDeleteBuffers(1, &batch->buffer);
+    }
+    glGenBuffers(1, &batch->buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, batch->buffer);
+    glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+    batch->stream = hasGl3 ? SPRITE_BATCH_STREAM_MAPPED : SPRITE_BATCH_STREAM_COPIED;
+    batch->staging = (uint8_t*)malloc(batch->spriteBytes * SPRITE_BATCH_MAX_SPRITES);
+    batch->stats.bufferBytes += batch->spriteBytes * SPRITE_BATCH_MAX_SPRITES;
+}
+
+// Indices fixes du chemin dvelopp : deux triangles par sprite.
+static int sprite_batch_create_indices(struct sprite_batch* batch) {
+    const size_t count = (size_t)SPRITE_BATCH_MAX_SPRITES * 6;
+    uint16_t* indices = (uint16_t*)malloc(count * sizeof(uint16_t));
+    if (indices == NULL) {
+        return -1;
+    }
+    for (uint16_t i = 0; i < SPRITE_BATCH_MAX_SPRITES; i++) {
+        uint16_t* quad = indices + (size_t)i * 6;
+        uint16_t first = (uint16_t)(i * 4);
+        quad[0] = first;
+        quad[1] = (uint16_t)(first + 1);
+        quad[2] = (uint16_t)(first + 2);
+        quad[3] = (uint16_t)(first + 2);
+        quad[4] = (uint16_t)(first + 1);
+        quad[5] = (uint16_t)(first + 3);
+    }
+    glGenBuffers(1, &batch->indices);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch->indices);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(count * sizeof(uint16_t)), indices, GL_STATIC_DRAW);
+    free(indices);
+    batch->stats.bufferBytes += count * sizeof(uint16_t);
+    return 0;
+}
+
+struct sprite_batch* sprite_batch_create(int32_t textureWidth, int32_t textureHeight,
+        int32_t layers, int flags) {
+    int major = sprite_batch_gles_major();
+    if (major < 2 || textureWidth < 1 || textureHeight < 1 || layers < 1) {
+        LOGW("Sprite batch needs OpenGL ES 2 (context version %d)", major);
+        return NULL;
+    }
+    struct sprite_batch* batch = (struct sprite_batch*)calloc(1, sizeof(struct sprite_batch));
+    if (batch == NULL) {
+        return NULL;
+    }
+    int hasGl3 = major >= 3 && sprite_batch_load_gl3(&batch->gl3) == 0;
+    batch->path = hasGl3 && !(flags & SPRITE_BATCH_EXPANDED)
+            ? SPRITE_BATCH_PATH_INSTANCED : SPRITE_BATCH_PATH_EXPANDED;
+    batch->textureWidth = textureWidth;
+    batch->textureHeight = textureHeight;
+    batch->layers = layers;
+    batch->spriteBytes = batch->path == SPRITE_BATCH_PATH_INSTANCED
+            ? sizeof(struct sprite_batch_sprite) : 4 * sizeof(struct sprite_batch_vertex);
+    batch->segmentBytes = batch->spriteBytes * SPRITE_BATCH_SEGMENT_SPRITES;
+
+    if (batch->path == SPRITE_BATCH_PATH_INSTANCED) {
+        GLint maxLayers = 0;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+        if (layers > maxLayers) {
+            LOGW("%d sprite layers, at most %d in a texture array", layers, maxLayers);
+            sprite_batch_destroy(batch);
+            return NULL;
+        }
+    }
+
+    batch->program = sprite_batch_link(batch->path);
+    if (batch->program == 0) {
+        sprite_batch_destroy(batch);
+        return NULL;
+    }
+    batch->scaleLocation = glGetUniformLocation(batch->program, "scale");
+    glUseProgram(batch->program);
+    glUniform1i(glGetUniformLocation(batch->program, "image"), 0);
+
+    sprite_batch_create_buffer(batch, hasGl3, flags);
+    batch->stats.textureBytes = (uint64_t)textureWidth * textureHeight * layers * sizeof(uint32_t);
+    if (batch->path == SPRITE_BATCH_PATH_INSTANCED) {
+        glGenTextures(1, &batch->arrayTexture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, batch->arrayTexture);
+        batch->gl3.texImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, textureWidth, textureHeight, layers,
+                0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        sprite_batch_texture_parameters(GL_TEXTURE_2D_ARRAY);
+    } else {
+        batch->textures = (GLuint*)calloc((size_t)layers, sizeof(GLuint));
+        if (batch->textures == NULL || sprite_batch_create_indices(batch) != 0) {
+            sprite_batch_destroy(batch);
+            return NULL;
+        }
+        glGenTextures(layers, batch->textures);
+        for (int32_t i = 0; i < layers; i++) {
+            glBindTexture(GL_TEXTURE_2D, batch->textures[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, textureWidth, textureHeight, 0, GL_RGBA,
+                    GL_UNSIGNED_BYTE, NULL);
+            sprite_batch_texture_parameters(GL_TEXTURE_2D);
+        }
+    }
+
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR || (batch->stream != SPRITE_BATCH_STREAM_PERSISTENT && batch->staging == NULL)) {
+        LOGW("Unable to create the sprite batch: 0x%x", error);
+        sprite_batch_destroy(batch);
+        return NULL;
+    }
+    LOGI("sprite batch: OpenGL ES %d, %s path, %s stream, %d layers of %dx%d", major,
+            sprite_batch_path_name(batch->path), sprite_batch_stream_name(batch->stream), layers,
+            textureWidth, textureHeight);
+    return batch;
+}
+
+void sprite_batch_abandon(struct sprite_batch* batch) {
+    if (batch == NULL) {
+        return;
+    }
+    free(batch->textures);
+    free(batch->staging);
+    free(batch);
+}
+
+void sprite_batch_destroy(struct sprite_batch* batch) {
+    if (batch == NULL) {
+        return;
+    }
+    if (batch->persistent != NULL) {
+        glBindBuffer(GL_ARRAY_BUFFER, batch->buffer);
+        batch->gl3.unmapBuffer(GL_ARRAY_BUFFER);
+    }
+    for (int i = 0; i < SPRITE_BATCH_SEGMENTS; i++) {
+        if (batch->fences[i] != NULL) {
+            batch->gl3.deleteSync(batch->fences[i]);
+        }
+    }
+    glDeleteBuffers(1, &batch->buffer);
+    glDeleteBuffers(1, &batch->indices);
+    glDeleteTextures(1, &batch->arrayTexture);
+    if (batch->textures != NULL) {
+        glDeleteTextures(batch->layers, batch->textures);
+    }
+    glDeleteProgram(batch->program);
+    sprite_batch_abandon(batch);
+}
+
+void sprite_batch_upload(struct sprite_batch* batch, int32_t layer, const uint32_t* pixels) {
+    if (layer < 0 || layer >= batch->layers) {
+        return;
+    }
+    if (batch->path == SPRITE_BATCH_PATH_INSTANCED) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, batch->arrayTexture);
+        batch->gl3.texSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, batch->textureWidth,
+                batch->textureHeight, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, batch->textures[layer]);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, batch->textureWidth, batch->textureHeight, GL_RGBA,
+                GL_UNSIGNED_BYTE, pixels);
+    }
+}
+
+static void sprite_batch_set_attributes(struct sprite_batch* batch, int enable) {
+    int instanced = batch->path == SPRITE_BATCH_PATH_INSTANCED;
+    GLuint count = instanced ? 4 : 3;
+    for (GLuint i = 0; i < count; i++) {
+        if (enable) {
+            glEnableVertexAttribArray(i);
+        } else {
+            glDisableVertexAttribArray(i);
+        }
+        if (instanced) {
+            batch->gl3.vertexAttribDivisor(i, enable ? 1 : 0);
+        }
+    }
+}
+
+void sprite_batch_begin(struct sprite_batch* batch, int32_t width, int32_t height) {
+    glViewport(0, 0, width, height);
+    glUseProgram(batch->program);
+    glUniform2f(batch->scaleLocation, 2.0f / (float)width, -2.0f / (float)height);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glActiveTexture(GL_TEXTURE0);
+    if (batch->path == SPRITE_BATCH_PATH_INSTANCED) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, batch->arrayTexture);
+    } else {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch->indices);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, batch->buffer);
+    sprite_batch_set_attributes(batch, 1);
+    batch->layer = UINT32_MAX;
+    batch->stats.frames++;
+}
+
+/**
+ * Segment suivant de l'anneau : une barrire est pose sur celui qui est
+ * quitt, puis celle du suivant est attendue.
+ */
+static void sprite_batch_next_segment(struct sprite_batch* batch) {
+    const struct sprite_batch_gl3* gl3 = &batch->gl3;
+    if (batch->stream == SPRITE_BATCH_STREAM_COPIED) {
+        // Sans barrires (OpenGL ES 2) : le stockage est remplac  chaque tour.
+        batch->segment = (batch->segment + 1) % SPRITE_BATCH_SEGMENTS;
+        batch->segmentUsed = 0;
+        if (batch->segment == 0) {
+            glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(batch->segmentBytes * SPRITE_BATCH_SEGMENTS),
+                    NULL, GL_STREAM_DRAW);
+        }
+        return;
+    }
+    if (batch->fences[batch->segment] != NULL) {
+        gl3->deleteSync(batch->fences[batch->segment]);
+    }
+    batch->fences[batch->segment] = gl3->fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    batch->segment = (batch->segment + 1) % SPRITE_BATCH_SEGMENTS;
+    batch->segmentUsed = 0;
+
+    GLsync fence = batch->fences[batch->segment];
+    if (fence == NULL) {
+        return;
+    }
+    GLenum result = gl3->clientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        batch->stats.stalls++;
+        do {
+            result = gl3->clientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000);
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+    gl3->deleteSync(fence);
+    batch->fences[batch->segment] = NULL;
+}
+
+// Dbut d'un lot : emplacement d'criture dans le segment courant.
+static void sprite_batch_reserve(struct sprite_batch* batch) {
+    size_t available = (batch->segmentBytes - batch->segmentUsed) / batch->spriteBytes;
+    if (available == 0) {
+        sprite_batch_next_segment(batch);
+        available = SPRITE_BATCH_SEGMENT_SPRITES;
+    }
+    batch->capacity = (uint32_t)(available < SPRITE_BATCH_MAX_SPRITES ? available : SPRITE_BATCH_MAX_SPRITES);
+    size_t offset = batch->segment * batch->segmentBytes + batch->segmentUsed;
+    batch->mapped = 0;
+    switch (batch->stream) {
+        case SPRITE_BATCH_STREAM_PERSISTENT:
+            batch->cursor = batch->persistent + offset;
+            break;
+        case SPRITE_BATCH_STREAM_MAPPED:
+            // La plage n'est lue par aucune commande en cours : aucune synchronisation.
+            batch->cursor = (uint8_t*)batch->gl3.mapBufferRange(GL_ARRAY_BUFFER, (GLintptr)offset,
+                    (GLsizeiptr)(batch->capacity * batch->spriteBytes), GL_MAP_WRITE_BIT
+                    | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_FLUSH_EXPLICIT_BIT);
+            batch->mapped = batch->cursor != NULL;
+            if (batch->cursor == NULL) {
+                batch->cursor = batch->staging;
+            }
+            break;
+        default:
+            batch->cursor = batch->staging;
+            break;
+    }
+}
+
+void sprite_batch_add(struct sprite_batch* batch, const struct sprite_batch_sprite* sprite) {
+    if (sprite->layer >= (uint32_t)batch->layers) {
+        return;
+    }
+    if (batch->path == SPRITE_BATCH_PATH_EXPANDED && sprite->layer != batch->layer) {
+        sprite_batch_flush(batch);
+        batch->layer = sprite->layer;
+    }
+    if (batch->count == 0) {
+        sprite_batch_reserve(batch);
+    }
+    uint8_t* out = batch->cursor + batch->count * batch->spriteBytes;
+    if (batch->path == SPRITE_BATCH_PATH_INSTANCED) {
+        memcpy(out, sprite, sizeof(*sprite));
+    } else {
+        // criture dans l'ordre des adresses : la mmoire projete est souvent
+        // en criture combine, et n'est jamais relue.
+        float x1 = sprite->x + sprite->width;
+        float y1 = sprite->y + sprite->height;
+        const struct sprite_batch_vertex vertices[4] = {
+            { sprite->x, sprite->y, sprite->u0, sprite->v0, sprite->color },
+            { x1, sprite->y, sprite->u1, sprite->v0, sprite->color },
+            { sprite->x, y1, sprite->u0, sprite->v1, sprite->color },
+            { x1, y1, sprite->u1, sprite->v1, sprite->color },
+        };
+        memcpy(out, vertices, sizeof(vertices));
+    }
+    if (++batch->count == batch->capacity) {
+        sprite_batch_flush(batch);
+    }
+}
+
+static inline const void* sprite_batch_offset(size_t offset) {
+    return (const void*)(uintptr_t)offset;
+}
+
+void sprite_batch_flush(struct sprite_batch* batch) {
+    if (batch->count == 0) {
+        return;
+    }
+    const struct sprite_batch_gl3* gl3 = &batch->gl3;
+    size_t bytes = batch->count * batch->spriteBytes;
+    size_t offset = batch->segment * batch->segmentBytes + batch->segmentUsed;
+    if (batch->mapped) {
+        gl3->flushMappedBufferRange(GL_ARRAY_BUFFER, 0, (GLsizeiptr)bytes);
+        gl3->unmapBuffer(GL_ARRAY_BUFFER);
+    } else if (batch->stream != SPRITE_BATCH_STREAM_PERSISTENT) {
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)offset, (GLsizeiptr)bytes, batch->staging);
+    }
+
+    if (batch->path == SPRITE_BATCH_PATH_INSTANCED) {
+        const GLsizei stride = sizeof(struct sprite_batch_sprite);
+        glVertexAttribPointer(SPRITE_BATCH_ATTRIB_RECT, 4, GL_FLOAT, GL_FALSE, stride,
+                sprite_batch_offset(offset + offsetof(struct sprite_batch_sprite, x)));
+        glVertexAttribPointer(SPRITE_BATCH_ATTRIB_REGION, 4, GL_FLOAT, GL_FALSE, stride,
+                sprite_batch_offset(offset + offsetof(struct sprite_batch_sprite, u0)));
+        glVertexAttribPointer(SPRITE_BATCH_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                sprite_batch_offset(offset + offsetof(struct sprite_batch_sprite, color)));
+        gl3->vertexAttribIPointer(SPRITE_BATCH_ATTRIB_LAYER, 1, GL_UNSIGNED_INT, stride,
+                sprite_batch_offset(offset + offsetof(struct sprite_batch_sprite, layer)));
+        gl3->drawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)batch->count);
+    } else {
+        // Sans sommet de base en OpenGL ES 2 : les attributs pointent sur le lot.
+        const GLsizei stride = sizeof(struct sprite_batch_vertex);
+        glBindTexture(GL_TEXTURE_2D, batch->textures[batch->layer]);
+        glVertexAttribPointer(SPRITE_BATCH_ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, stride,
+                sprite_batch_offset(offset + offsetof(struct sprite_batch_vertex, x)));
+        glVertexAttribPointer(SPRITE_BATCH_ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, stride,
+                sprite_batch_offset(offset + offsetof(struct sprite_batch_vertex, u)));
+        glVertexAttribPointer(SPRITE_BATCH_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                sprite_batch_offset(offset + offsetof(struct sprite_batch_vertex, color)));
+        glDrawElements(GL_TRIANGLES, (GLsizei)(batch->count * 6), GL_UNSIGNED_SHORT, NULL);
+    }
+
+    batch->segmentUsed += bytes;
+    batch->stats.sprites += batch->count;
+    batch->stats.draws++;
+    batch->stats.streamedBytes += bytes;
+    batch->count = 0;
+}
+
+void sprite_batch_end(struct sprite_batch* batch) {
+    sprite_batch_flush(batch);
+    sprite_batch_set_attributes(batch, 0);
+}
+
+void sprite_batch_get_stats(const struct sprite_batch* batch, struct sprite_batch_stats* outStats) {
+    *outStats = batch->stats;
+}
@@ -0,0 +1,157 @@
+// Lastorm tech.
+
+#ifndef _SPRITE_BATCH_H
+#define _SPRITE_BATCH_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Rendu de sprites par lots, OpenGL ES 3 ou 2.
+ *
+ * Les sprites ajouts entre sprite_batch_begin() et sprite_batch_end() sont
+ * crits directement dans un tampon de sommets en flux puis dessins en aussi
+ * peu d'appels que possible :
+ *
+ *  - chemin instanci (OpenGL ES 3) : un sprite est une instance de
+ *    struct sprite_batch_sprite, recopie telle quelle ; le quadrilatre est
+ *    dduit de gl_VertexID et les images sont les couches d'une texture tableau
+ *    (GL_TEXTURE_2D_ARRAY). Un appel glDrawArraysInstanced() par lot de
+ *    SPRITE_BATCH_MAX_SPRITES sprites, quelles que soient leurs images ;
+ *
+ *  - chemin dvelopp (OpenGL ES 2, ou impos par SPRITE_BATCH_EXPANDED) :
+ *    quatre sommets par sprite et un tampon d'indices fixe, une texture 2D par
+ *    image : le lot est dessin  chaque changement d'image.
+ *
+ * Le tampon en flux est un anneau de SPRITE_BATCH_SEGMENTS segments. Avec
+ * GL_EXT_buffer_storage, il est projet une fois pour toutes (persistant et
+ * cohrent) ; sinon chaque lot est projet par glMapBufferRange() sans
+ * synchronisation (OpenGL ES 3), ou copi par glBufferSubData() (OpenGL ES 2).
+ * En OpenGL ES 3, une barrire (glFenceSync) est pose sur chaque segment
+ * rempli : il n'est rcrit qu'une fois excutes les commandes qui le lisent.
+ *
+ * Les fonctions d'OpenGL ES 3 sont obtenues par eglGetProcAddress() : le module
+ * est li  libGLESv2 et fonctionne sur les appareils qui n'ont qu'OpenGL ES 2.
+ *
+ * L'ordre d'ajout est l'ordre de dessin ; le mlange est  source par-dessus ,
+ * alpha non prmultiplie. Les coordonnes sont en pixels, origine en haut 
+ * gauche ; la couleur multiplie le texel, au format de soft_raster.h (R dans
+ * l'octet de poids faible).
+ *
+ * Les fonctions sont rserves au thread propritaire du contexte, qui doit
+ * tre courant.
+ */
+
+// Sprites d'un appel de dessin au plus (indices sur 16 bits dans le chemin dvelopp).
+#define SPRITE_BATCH_MAX_SPRITES 4096
+
+// Segments de l'anneau, et sprites par segment.
+#define SPRITE_BATCH_SEGMENTS 3
+#define SPRITE_BATCH_SEGMENT_SPRITES 16384
+
+// Options de sprite_batch_create().
+#define SPRITE_BATCH_EXPANDED 0x1       // chemin dvelopp mme en OpenGL ES 3
+#define SPRITE_BATCH_NO_PERSISTENT 0x2  // pas de projection persistante
+
+enum {
+    SPRITE_BATCH_PATH_INSTANCED,
+    SPRITE_BATCH_PATH_EXPANDED,
+};
+
+// criture du tampon en flux.
+enum {
+    SPRITE_BATCH_STREAM_PERSISTENT,
+    SPRITE_BATCH_STREAM_MAPPED,
+    SPRITE_BATCH_STREAM_COPIED,
+};
+
+/**
+ * Un sprite : rectangle en pixels, rgion de l'image en coordonnes de texture,
+ * couleur et image (couche).
+ */
+struct sprite_batch_sprite {
+    float x;
+    float y;
+    float width;
+    float height;
+    float u0;
+    float v0;
+    float u1;
+    float v1;
+    uint32_t color;
+    uint32_t layer;
+};
+
+struct sprite_batch_stats {
+    uint64_t frames;
+    uint64_t sprites;
+    uint64_t draws;
+
+    // Octets crits dans le tampon en flux.
+    uint64_t streamedBytes;
+
+    // Segments dont la barrire n'tait pas encore franchie  la rutilisation.
+    uint64_t stalls;
+
+    // Mmoire des images, puis des tampons (anneau, indices et copie intermdiaire).
+    uint64_t textureBytes;
+    uint64_t bufferBytes;
+};
+
+struct sprite_batch;
+
+/**
+ * Cre le moteur de sprites pour le contexte courant, avec layers images de
+ * textureWidth x textureHeight pixels ( charger par sprite_batch_upload()).
+ * flags combine les options SPRITE_BATCH_*. Retourne NULL si le contexte n'est
+ * pas OpenGL ES 2 ou plus, ou en cas d'erreur.
+ */
+struct sprite_batch* sprite_batch_create(int32_t textureWidth, int32_t textureHeight,
+        int32_t layers, int flags);
+
+/**
+ * Libre les objets GL (contexte courant) et la mmoire.
+ */
+void sprite_batch_destroy(struct sprite_batch* batch);
+
+/**
+ * Libre la mmoire seule, aprs la perte du contexte : ses objets GL
+ * n'existent plus.
+ */
+void sprite_batch_abandon(struct sprite_batch* batch);
+
+int sprite_batch_get_path(const struct sprite_batch* batch);
+int sprite_batch_get_stream(const struct sprite_batch* batch);
+const char* sprite_batch_path_name(int path);
+const char* sprite_batch_stream_name(int stream);
+
+/**
+ * Chargement d'une image : pixels RGBA, textureWidth x textureHeight, sans remplissage.
+ */
+void sprite_batch_upload(struct sprite_batch* batch, int32_t layer, const uint32_t* pixels);
+
+/**
+ * Dbut d'une image dans une cible de width x height pixels : programme,
+ * fentre d'affichage et mlange.
+ */
+void sprite_batch_begin(struct sprite_batch* batch, int32_t width, int32_t height);
+
+void sprite_batch_add(struct sprite_batch* batch, const struct sprite_batch_sprite* sprite);
+
+/**
+ * Dessin des sprites en attente ; sprite_batch_end() l'appelle.
+ */
+void sprite_batch_flush(struct sprite_batch* batch);
+
+void sprite_batch_end(struct sprite_batch* batch);
+
+void sprite_batch_get_stats(const struct sprite_batch* batch, struct sprite_batch_stats* outStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SPRITE_BATCH_H */
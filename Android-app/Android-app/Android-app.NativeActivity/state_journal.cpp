@@ -0,0 +1,702 @@
+// Lastorm tech.
+
+ASYNC_LOG_TAG(state_journal_log_tag, "state_journal", 10);
+
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, &state_journal_log_tag, __VA_ARGS__)
+#define LOGW(...) ASYNC_LOG(ANDROID_LOG_WARN, &state_journal_log_tag, __VA_ARGS__)
+#define LOGE(...) ASYNC_LOG(ANDROID_LOG_ERROR, &state_journal_log_tag, __VA_ARGS__)
+
+#define STATE_JOURNAL_MAGIC 0x4e524a53u      //  SJRN 
+#define STATE_CHECKPOINT_MAGIC 0x504b4353u   //  SCKP 
+#define STATE_JOURNAL_VERSION 1
+
+// Les enregistrements et les donnes du point de contrle commencent aprs un
+// en-tte de 64 octets, et restent aligns sur STATE_SNAPSHOT_ALIGN.
+#define STATE_JOURNAL_HEADER_SIZE 64
+
+enum {
+    STATE_JOURNAL_TASK_VERIFY = 1,
+    STATE_JOURNAL_TASK_COMPACT = 2,
+};
+
+struct state_journal_file_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t schema;
+    uint32_t capacity;
+};
+
+struct state_checkpoint_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t schema;
+
+    // CRC de cet en-tte (headerCrc  zro) et de l'en-tte et du rpertoire de
+    // l'instantan, puis CRC des donnes de l'instantan.
+    uint32_t headerCrc;
+    uint32_t dataCrc;
+    uint32_t directorySize;
+
+    // Dernier numro de squence contenu, et taille de l'instantan.
+    uint64_t sequence;
+    uint64_t snapshotSize;
+};
+
+/**
+ * Enregistrement du journal, suivi des donnes du champ. size est crit en
+ * dernier ; crc couvre tout ce qui le suit.
+ */
+struct state_journal_record {
+    uint32_t size;
+    uint32_t crc;
+    uint64_t sequence;
+    uint32_t id;
+    uint16_t type;
+    uint16_t elementSize;
+    uint64_t count;
+};
+
+struct state_journal_file {
+    int fd;
+    uint8_t* map;
+
+    // Fin du dernier enregistrement valide, et sa squence.
+    size_t used;
+    uint64_t lastSequence;
+};
+
+// Dernire valeur connue d'un champ : enregistrement du journal ou champ du point de contrle.
+struct state_journal_entry {
+    uint32_t id;
+    uint16_t type;
+    uint16_t elementSize;
+    uint64_t count;
+    const void* data;
+};
+
+// Place laisse au nom des fichiers dans leur chemin.
+#define STATE_JOURNAL_NAME_MAX 32
+
+struct state_journal {
+    char directory[PATH_MAX - STATE_JOURNAL_NAME_MAX];
+    uint32_t schema;
+
+    struct state_journal_file files[2];
+    int active;
+
+    // Point de contrle projet ; il appartient au thread de fond une fois la vue libre.
+    uint8_t* checkpointMap;
+    size_t checkpointMapSize;
+    struct state_snapshot_view checkpoint;
+    uint64_t checkpointSequence;
+    uint32_t checkpointDataCrc;
+    int checkpointCorrupt;
+
+    uint64_t nextSequence;
+
+    // Vue de restauration : dernire valeur de chaque champ  l'ouverture.
+    int viewOpen;
+    struct state_journal_entry latest[STATE_JOURNAL_MAX_FIELDS];
+    int latestCount;
+
+    // Thread de fond. frozen est l'indice du journal en cours de compactage, ou -1.
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int tasks;
+    int frozen;
+    int busy;
+    int stop;
+
+    struct state_journal_stats stats;
+};
+
+// --------------------------------------------------------------------
+// CRC32 (polynme IEEE 802.3, rflchi)
+// --------------------------------------------------------------------
+
+static uint32_t state_journal_crc_table[256];
+static pthread_once_t state_journal_crc_once = PTHREAD_ONCE_INIT;
+
+static void state_journal_crc_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        state_journal_crc_table[i] = c;
+    }
+}
+
+static uint32_t state_journal_crc(uint32_t crc, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = state_journal_crc_table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// --------------------------------------------------------------------
+// Fichiers
+// --------------------------------------------------------------------
+
+static int64_t state_journal_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static void state_journal_path(const struct state_journal* journal, const char* name,
+        char* path, size_t size) {
+    snprintf(path, size, "%s/%s", journal->directory, name);
+}
+
+// Index de la dernire valeur de chaque champ ; retourne -1 si la table est pleine.
+static int state_journal_index(struct state_journal_entry* entries, int* count,
+        const struct state_journal_entry* entry) {
+    for (int i = 0; i < *count; i++) {
+        if (entries[i].id == entry->id) {
+            entries[i] = *entry;
+            return 0;
+        }
+    }
+    if (*count == STATE_JOURNAL_MAX_FIELDS) {
+        return -1;
+    }
+    entries[(*count)++] = *entry;
+    return 0;
+}
+
+static void state_journal_file_reset(struct state_journal* journal, struct state_journal_file* file) {
+    memset(file->map, 0, STATE_JOURNAL_CAPACITY);
+    struct state_journal_file_header* header = (struct state_journal_file_header*)file->map;
+    header->magic = STATE_JOURNAL_MAGIC;
+    header->version = STATE_JOURNAL_VERSION;
+    header->headerSize = STATE_JOURNAL_HEADER_SIZE;
+    header->schema = journal->schema;
+    header->capacity = STATE_JOURNAL_CAPACITY;
+    file->used = STATE_JOURNAL_HEADER_SIZE;
+    file->lastSequence = 0;
+}
+
+// Parcourt les enregistrements valides ; s'arrte au premier enregistrement
+// incomplet, corrompu ou hors squence. Les enregistrements postrieurs 
+// afterSequence sont indexs dans entries (si non NULL) et compts dans
+// *replayed (si non NULL). Retourne 1 si la fin du journal est une criture
+// interrompue.
+static int state_journal_file_scan(struct state_journal_file* file,
+        struct state_journal_entry* entries, int* entryCount, uint64_t afterSequence,
+        uint64_t* replayed) {
+    size_t offset = STATE_JOURNAL_HEADER_SIZE;
+    uint64_t sequence = 0;
+    while (offset + sizeof(struct state_journal_record) <= STATE_JOURNAL_CAPACITY) {
+        const struct state_journal_record* record = (const struct state_journal_record*)(file->map + offset);
+        uint32_t size = record->size;
+        if (size == 0) {
+            break;
+        }
+        if (size < sizeof(*record) || size % STATE_SNAPSHOT_ALIGN != 0
+                || size > STATE_JOURNAL_CAPACITY - offset || record->sequence <= sequence
+                || record->elementSize == 0
+                || record->count > (size - sizeof(*record)) / record->elementSize
+                || record->crc != state_journal_crc(0, (const uint8_t*)record + 8, size - 8)) {
+            file->used = offset;
+            file->lastSequence = sequence;
+            return 1;
+        }
+        sequence = record->sequence;
+        if (entries != NULL && sequence > afterSequence) {
+            struct state_journal_entry entry = {
+                record->id, record->type, record->elementSize, record->count, record + 1,
+            };
+            if (state_journal_index(entries, entryCount, &entry) == 0 && replayed != NULL) {
+                (*replayed)++;
+            }
+        }
+        offset += size;
+    }
+    file->used = offset;
+    file->lastSequence = sequence;
+    return 0;
+}
+
+static int state_journal_file_open(struct state_journal* journal, int index) {
+    struct state_journal_file* file = &journal->files[index];
+    char path[PATH_MAX];
+    char name[16];
+    snprintf(name, sizeof(name), "state.jrnl%d", index);
+    state_journal_path(journal, name, path, sizeof(path));
+
+    file->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (file->fd < 0) {
+        LOGE("Unable to open %s: %s", path, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    int created = fstat(file->fd, &st) != 0 || st.st_size != STATE_JOURNAL_CAPACITY;
+    if (created && ftruncate(file->fd, STATE_JOURNAL_CAPACITY) != 0) {
+        LOGE("Unable to size %s: %s", path, strerror(errno));
+        return -1;
+    }
+    void* map = mmap(NULL, STATE_JOURNAL_CAPACITY, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, 0);
+    if (map == MAP_FAILED) {
+        LOGE("Unable to map %s: %s", path, strerror(errno));
+        return -1;
+    }
+    file->map = (uint8_t*)map;
+
+    const struct state_journal_file_header* header = (const struct state_journal_file_header*)map;
+    if (created || header->magic != STATE_JOURNAL_MAGIC || header->version != STATE_JOURNAL_VERSION
+            || header->schema != journal->schema || header->capacity != STATE_JOURNAL_CAPACITY) {
+        state_journal_file_reset(journal, file);
+    }
+    return 0;
+}
+
+static void state_journal_file_close(struct state_journal_file* file) {
+    if (file->map != NULL) {
+        munmap(file->map, STATE_JOURNAL_CAPACITY);
+        file->map = NULL;
+    }
+    if (file->fd >= 0) {
+        close(file->fd);
+        file->fd = -1;
+    }
+}
+
+static void state_journal_unmap_checkpoint(struct state_journal* journal) {
+    if (journal->checkpointMap != NULL) {
+        munmap(journal->checkpointMap, journal->checkpointMapSize);
+        journal->checkpointMap = NULL;
+        journal->checkpointMapSize = 0;
+    }
+    memset(&journal->checkpoint, 0, sizeof(journal->checkpoint));
+}
+
+// Projette state.ckpt et vrifie son en-tte et son rpertoire. Les donnes ne sont pas lues.
+static int state_journal_map_checkpoint(struct state_journal* journal) {
+    char path[PATH_MAX];
+    state_journal_path(journal, "state.ckpt", path, sizeof(path));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= STATE_JOURNAL_HEADER_SIZE) {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+
+    const struct state_checkpoint_header* header = (const struct state_checkpoint_header*)map;
+    struct state_checkpoint_header copy = *header;
+    copy.headerCrc = 0;
+    const uint8_t* snapshot = (const uint8_t*)map + STATE_JOURNAL_HEADER_SIZE;
+    int valid = header->magic == STATE_CHECKPOINT_MAGIC && header->version == STATE_JOURNAL_VERSION
+            && header->headerSize == STATE_JOURNAL_HEADER_SIZE && header->schema == journal->schema
+            && header->snapshotSize <= (uint64_t)st.st_size - STATE_JOURNAL_HEADER_SIZE
+            && header->directorySize <= header->snapshotSize
+            && header->headerCrc == state_journal_crc(state_journal_crc(0, &copy, sizeof(copy)),
+                    snapshot, header->directorySize)
+            && state_snapshot_open(&journal->checkpoint, snapshot, (size_t)header->snapshotSize,
+                    journal->schema) == 0;
+    if (!valid) {
+        LOGW("Ignoring invalid checkpoint %s", path);
+        munmap(map, (size_t)st.st_size);
+        memset(&journal->checkpoint, 0, sizeof(journal->checkpoint));
+        return -1;
+    }
+
+    journal->checkpointMap = (uint8_t*)map;
+    journal->checkpointMapSize = (size_t)st.st_size;
+    journal->checkpointSequence = header->sequence;
+    journal->checkpointDataCrc = header->dataCrc;
+    journal->checkpointCorrupt = 0;
+    return 0;
+}
+
+// --------------------------------------------------------------------
+// Thread de fond
+// --------------------------------------------------------------------
+
+static void state_journal_verify(struct state_journal* journal) {
+    if (journal->checkpointMap == NULL) {
+        return;
+    }
+    const uint8_t* snapshot = journal->checkpointMap + STATE_JOURNAL_HEADER_SIZE;
+    if (state_journal_crc(0, snapshot, journal->checkpoint.size) == journal->checkpointDataCrc) {
+        return;
+    }
+    // Les valeurs dj restaures ne peuvent plus tre reprises : le point de
+    // contrle est seulement cart pour la suite.
+    char path[PATH_MAX];
+    state_journal_path(journal, "state.ckpt", path, sizeof(path));
+    LOGE("Checkpoint %s is corrupt, discarding it", path);
+    unlink(path);
+    pthread_mutex_lock(&journal->mutex);
+    journal->checkpointCorrupt = 1;
+    journal->stats.corrupt++;
+    pthread_mutex_unlock(&journal->mutex);
+}
+
+// crit un point de contrle avec l'instantan, puis le met en place avec rename().
+static int state_journal_write_checkpoint(struct state_journal* journal, const uint8_t* snapshot,
+        size_t size, uint64_t sequence) {
+    struct state_checkpoint_header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = STATE_CHECKPOINT_MAGIC;
+    header.version = STATE_JOURNAL_VERSION;
+    header.headerSize = STATE_JOURNAL_HEADER_SIZE;
+    header.schema = journal->schema;
+    header.dataCrc = state_journal_crc(0, snapshot, size);
+    header.sequence = sequence;
+    header.snapshotSize = size;
+    const struct state_snapshot_header* snapshotHeader = (const struct state_snapshot_header*)snapshot;
+    header.directorySize = snapshotHeader->headerSize
+            + snapshotHeader->fieldCount * sizeof(struct state_snapshot_field);
+    header.headerCrc = state_journal_crc(state_journal_crc(0, &header, sizeof(header)),
+            snapshot, header.directorySize);
+
+    uint8_t block[STATE_JOURNAL_HEADER_SIZE];
+    memset(block, 0, sizeof(block));
+    memcpy(block, &header, sizeof(header));
+
+    char path[PATH_MAX];
+    char tempPath[PATH_MAX];
+    state_journal_path(journal, "state.ckpt", path, sizeof(path));
+    state_journal_path(journal, "state.ckpt.tmp", tempPath, sizeof(tempPath));
+    int fd = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        LOGE("Unable to create %s: %s", tempPath, strerror(errno));
+        return -1;
+    }
+    int ok = pwrite(fd, block, sizeof(block), 0) == (ssize_t)sizeof(block)
+            && pwrite(fd, snapshot, size, sizeof(block)) == (ssize_t)size
+            && fdatasync(fd) == 0;
+    close(fd);
+    if (!ok || rename(tempPath, path) != 0) {
+        LOGE("Unable to write %s: %s", path, strerror(errno));
+        unlink(tempPath);
+        return -1;
+    }
+    // Le renommage lui-mme est rendu durable.
+    int dirFd = open(journal->directory, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        close(dirFd);
+    }
+    return 0;
+}
+
+// Fusionne le point de contrle et le journal gel en un nouveau point de contrle,
+// puis vide le journal gel.
+static void state_journal_compact_file(struct state_journal* journal, int index) {
+    int64_t start = state_journal_now_ns();
+    struct state_journal_file* file = &journal->files[index];
+
+    // La table de fusion vient du brouillon du thread de fond.
+    struct frame_arena* scratch = frame_scratch();
+    if (scratch == NULL) {
+        return;
+    }
+    size_t mark = frame_arena_mark(scratch);
+    struct state_journal_entry* entries = FRAME_ARENA_NEW(scratch, struct state_journal_entry,
+            STATE_JOURNAL_MAX_FIELDS);
+    if (entries == NULL) {
+        return;
+    }
+    int count = 0;
+    int corrupt = __atomic_load_n(&journal->checkpointCorrupt, __ATOMIC_ACQUIRE);
+    if (journal->checkpointMap != NULL && !corrupt) {
+        for (uint32_t i = 0; i < journal->checkpoint.fieldCount; i++) {
+            const struct state_snapshot_field* field = &journal->checkpoint.fields[i];
+            struct state_journal_entry entry = {
+                field->id, field->type, field->elementSize, field->count,
+                journal->checkpoint.data + field->offset,
+            };
+            state_journal_index(entries, &count, &entry);
+        }
+    }
+    uint64_t checkpointSequence = journal->checkpointSequence;
+    state_journal_file_scan(file, entries, &count, checkpointSequence, NULL);
+    uint64_t sequence = file->lastSequence > checkpointSequence ? file->lastSequence
+            : checkpointSequence;
+
+    size_t payload = 0;
+    for (int i = 0; i < count; i++) {
+        payload += STATE_SNAPSHOT_SPACE(entries[i].count * entries[i].elementSize);
+    }
+    struct state_snapshot_writer writer;
+    int written = -1;
+    if (state_snapshot_begin(&writer, journal->schema, (uint32_t)count, payload) == 0) {
+        for (int i = 0; i < count; i++) {
+            state_snapshot_put(&writer, entries[i].id, entries[i].type, entries[i].data,
+                    (size_t)entries[i].count);
+        }
+        size_t size;
+        void* snapshot = state_snapshot_finish(&writer, &size);
+        if (snapshot != NULL) {
+            written = state_journal_write_checkpoint(journal, (const uint8_t*)snapshot, size, sequence);
+            state_pool_release(snapshot, size);
+        }
+    }
+    frame_arena_rewind(scratch, mark);
+    if (written != 0) {
+        // Le journal gel reste tel quel : il sera rejou  la prochaine ouverture.
+        return;
+    }
+
+    state_journal_unmap_checkpoint(journal);
+    state_journal_map_checkpoint(journal);
+    state_journal_file_reset(journal, file);
+    msync(file->map, STATE_JOURNAL_CAPACITY, MS_ASYNC);
+
+    pthread_mutex_lock(&journal->mutex);
+    journal->stats.compactions++;
+    journal->stats.checkpointBytes = journal->checkpoint.size;
+    journal->stats.lastCompactionNs = state_journal_now_ns() - start;
+    pthread_mutex_unlock(&journal->mutex);
+}
+
+static void* state_journal_main(void* param) {
+    struct state_journal* journal = (struct state_journal*)param;
+    pthread_mutex_lock(&journal->mutex);
+    for (;;) {
+        while (journal->tasks == 0 && !journal->stop) {
+            pthread_cond_wait(&journal->cond, &journal->mutex);
+        }
+        if (journal->tasks == 0) {
+            break;
+        }
+        int tasks = journal->tasks;
+        int frozen = journal->frozen;
+        journal->tasks = 0;
+        journal->busy = 1;
+        pthread_mutex_unlock(&journal->mutex);
+
+        if (tasks & STATE_JOURNAL_TASK_VERIFY) {
+            state_journal_verify(journal);
+        }
+        if ((tasks & STATE_JOURNAL_TASK_COMPACT) && frozen >= 0) {
+            state_journal_compact_file(journal, frozen);
+        }
+
+        pthread_mutex_lock(&journal->mutex);
+        if (tasks & STATE_JOURNAL_TASK_COMPACT) {
+            journal->frozen = -1;
+        }
+        journal->busy = 0;
+        pthread_cond_broadcast(&journal->cond);
+    }
+    pthread_mutex_unlock(&journal->mutex);
+    return NULL;
+}
+
+// Gle le journal index et confie son compactage au thread de fond.
+static void state_journal_request_compact(struct state_journal* journal, int index) {
+    pthread_mutex_lock(&journal->mutex);
+    journal->frozen = index;
+    journal->tasks |= STATE_JOURNAL_TASK_COMPACT;
+    pthread_cond_broadcast(&journal->cond);
+    pthread_mutex_unlock(&journal->mutex);
+}
+
+// --------------------------------------------------------------------
+// Interface
+// --------------------------------------------------------------------
+
+struct state_journal* state_journal_open(const char* directory, uint32_t schema) {
+    pthread_once(&state_journal_crc_once, state_journal_crc_init);
+    if (directory == NULL || strlen(directory) >= PATH_MAX - STATE_JOURNAL_NAME_MAX
+            || (mkdir(directory, 0700) != 0 && errno != EEXIST)) {
+        LOGE("Unable to create journal directory %s", directory != NULL ? directory : "(null)");
+        return NULL;
+    }
+
+    struct state_journal* journal = (struct state_journal*)calloc(1, sizeof(struct state_journal));
+    snprintf(journal->directory, sizeof(journal->directory), "%s", directory);
+    journal->schema = schema;
+    journal->files[0].fd = -1;
+    journal->files[1].fd = -1;
+    journal->frozen = -1;
+    if (state_journal_file_open(journal, 0) != 0 || state_journal_file_open(journal, 1) != 0) {
+        state_journal_file_close(&journal->files[0]);
+        state_journal_file_close(&journal->files[1]);
+        free(journal);
+        return NULL;
+    }
+
+    state_journal_map_checkpoint(journal);
+    journal->stats.checkpointBytes = journal->checkpoint.size;
+    if (journal->checkpointMap != NULL) {
+        for (uint32_t i = 0; i < journal->checkpoint.fieldCount; i++) {
+            const struct state_snapshot_field* field = &journal->checkpoint.fields[i];
+            struct state_journal_entry entry = {
+                field->id, field->type, field->elementSize, field->count,
+                journal->checkpoint.data + field->offset,
+            };
+            state_journal_index(journal->latest, &journal->latestCount, &entry);
+        }
+    }
+
+    // Les squences des deux journaux ne se chevauchent pas : un premier parcours
+    // les ordonne, puis le plus ancien est rejou d'abord.
+    for (int index = 0; index < 2; index++) {
+        state_journal_file_scan(&journal->files[index], NULL, NULL, 0, NULL);
+    }
+    int older = journal->files[0].lastSequence <= journal->files[1].lastSequence ? 0 : 1;
+    for (int pass = 0; pass < 2; pass++) {
+        struct state_journal_file* file = &journal->files[pass == 0 ? older : older ^ 1];
+        if (state_journal_file_scan(file, journal->latest, &journal->latestCount,
+                journal->checkpointSequence, &journal->stats.replayed)) {
+            // La fin interrompue est efface : un ajout plus court ne doit pas
+            // laisser derrire lui les restes d'un enregistrement valide.
+            memset(file->map + file->used, 0, STATE_JOURNAL_CAPACITY - file->used);
+            journal->stats.torn++;
+        }
+    }
+    journal->active = older ^ 1;
+    uint64_t last = journal->files[journal->active].lastSequence;
+    journal->nextSequence = (last > journal->checkpointSequence ? last : journal->checkpointSequence) + 1;
+    journal->viewOpen = 1;
+
+    pthread_mutex_init(&journal->mutex, NULL);
+    pthread_cond_init(&journal->cond, NULL);
+    journal->tasks = STATE_JOURNAL_TASK_VERIFY;
+    pthread_create(&journal->thread, NULL, state_journal_main, journal);
+
+    LOGI("journal %s: checkpoint=%llu bytes, %d fields, replayed=%llu torn=%llu",
+            directory, (unsigned long long)journal->stats.checkpointBytes, journal->latestCount,
+            (unsigned long long)journal->stats.replayed, (unsigned long long)journal->stats.torn);
+    return journal;
+}
+
+const void* state_journal_get(struct state_journal* journal, uint32_t id, int type,
+        size_t* outCount) {
+    if (journal->viewOpen) {
+        for (int i = 0; i < journal->latestCount; i++) {
+            const struct state_journal_entry* entry = &journal->latest[i];
+            if (entry->id != id) {
+                continue;
+            }
+            if (entry->type != type || entry->elementSize != state_snapshot_element_size(type)) {
+                break;
+            }
+            if (outCount != NULL) {
+                *outCount = (size_t)entry->count;
+            }
+            return entry->data;
+        }
+    }
+    if (outCount != NULL) {
+        *outCount = 0;
+    }
+    return NULL;
+}
+
+void state_journal_release_view(struct state_journal* journal) {
+    if (!journal->viewOpen) {
+        return;
+    }
+    journal->viewOpen = 0;
+    journal->latestCount = 0;
+    // Un arrt pendant un compactage laisse des enregistrements vivants dans
+    // l'ancien journal : ils sont intgrs au prochain point de contrle.
+    // L'ancien journal est vid avant de pouvoir redevenir actif.
+    int other = journal->active ^ 1;
+    if (journal->files[other].lastSequence > journal->checkpointSequence) {
+        state_journal_request_compact(journal, other);
+    } else if (journal->files[other].used > STATE_JOURNAL_HEADER_SIZE) {
+        state_journal_file_reset(journal, &journal->files[other]);
+    }
+}
+
+int state_journal_append(struct state_journal* journal, uint32_t id, int type,
+        const void* values, size_t count) {
+    size_t elementSize = state_snapshot_element_size(type);
+    size_t dataSize = STATE_SNAPSHOT_SPACE(count * elementSize);
+    size_t size = sizeof(struct state_journal_record) + dataSize;
+    struct state_journal_file* file = &journal->files[journal->active];
+    if (elementSize == 0 || size > STATE_JOURNAL_CAPACITY - file->used) {
+        journal->stats.dropped++;
+        state_journal_compact(journal);
+        return -1;
+    }
+
+    struct state_journal_record* record = (struct state_journal_record*)(file->map + file->used);
+    uint8_t* data = (uint8_t*)(record + 1);
+    memcpy(data, values, count * elementSize);
+    memset(data + count * elementSize, 0, dataSize - count * elementSize);
+    record->sequence = journal->nextSequence++;
+    record->id = id;
+    record->type = (uint16_t)type;
+    record->elementSize = (uint16_t)elementSize;
+    record->count = count;
+    record->crc = state_journal_crc(0, (const uint8_t*)record + 8, size - 8);
+    // La taille valide l'enregistrement : elle est crite aprs tout le reste.
+    __atomic_store_n(&record->size, (uint32_t)size, __ATOMIC_RELEASE);
+    file->used += size;
+    file->lastSequence = record->sequence;
+    journal->stats.appends++;
+    journal->stats.appendedBytes += size;
+
+    if (file->used > STATE_JOURNAL_CAPACITY / 2) {
+        state_journal_compact(journal);
+    }
+    return 0;
+}
+
+void state_journal_compact(struct state_journal* journal) {
+    struct state_journal_file* file = &journal->files[journal->active];
+    if (journal->viewOpen || file->used == STATE_JOURNAL_HEADER_SIZE) {
+        return;
+    }
+    pthread_mutex_lock(&journal->mutex);
+    int idle = journal->frozen < 0;
+    pthread_mutex_unlock(&journal->mutex);
+    if (!idle) {
+        return;
+    }
+    // Les ajouts continuent dans l'autre journal, vid par le compactage prcdent.
+    int frozen = journal->active;
+    journal->active ^= 1;
+    state_journal_request_compact(journal, frozen);
+}
+
+void state_journal_wait(struct state_journal* journal) {
+    pthread_mutex_lock(&journal->mutex);
+    while (journal->tasks != 0 || journal->busy) {
+        pthread_cond_wait(&journal->cond, &journal->mutex);
+    }
+    pthread_mutex_unlock(&journal->mutex);
+}
+
+void state_journal_get_stats(struct state_journal* journal, struct state_journal_stats* outStats) {
+    pthread_mutex_lock(&journal->mutex);
+    *outStats = journal->stats;
+    pthread_mutex_unlock(&journal->mutex);
+}
+
+void state_journal_close(struct state_journal* journal) {
+    if (journal == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&journal->mutex);
+    journal->stop = 1;
+    pthread_cond_broadcast(&journal->cond);
+    pthread_mutex_unlock(&journal->mutex);
+    pthread_join(journal->thread, NULL);
+
+    state_journal_unmap_checkpoint(journal);
+    state_journal_file_close(&journal->files[0]);
+    state_journal_file_close(&journal->files[1]);
+    pthread_cond_destroy(&journal->cond);
+    pthread_mutex_destroy(&journal->mutex);
+    free(journal);
+}
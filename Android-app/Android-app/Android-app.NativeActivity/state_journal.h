@@ -0,0 +1,128 @@
+// Lastorm tech.
+
+#ifndef _STATE_JOURNAL_H
+#define _STATE_JOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Journal d'tat projet en mmoire, pour une restauration  froid.
+ *
+ * L'tat enregistr par onSaveInstanceState() est perdu quand le processus est
+ * tu en arrire-plan. Le journal garde l'tat dans un rpertoire du stockage
+ * interne, sous trois fichiers :
+ *
+ *      state.ckpt      point de contrle : un instantan de state_snapshot.h
+ *                      prcd d'un en-tte avec ses sommes de contrle ;
+ *      state.jrnl0/1   deux journaux de capacit fixe, projets avec mmap(),
+ *                      o l'application ajoute la nouvelle valeur de chaque
+ *                      champ modifi (delta).
+ *
+ * Un ajout est une copie dans la projection, sans appel systme : les pages
+ * appartiennent au noyau et survivent  la mort du processus. Chaque
+ * enregistrement porte un numro de squence croissant et un CRC32 ; sa taille
+ * est crite en dernier.  l'ouverture, le parcours d'un journal s'arrte au
+ * premier enregistrement incomplet ou corrompu (criture interrompue), qui
+ * sera recouvert par les ajouts suivants.
+ *
+ * Quand le journal actif est  moiti plein, ou sur demande, l'application
+ * passe  l'autre journal et un thread de fond fusionne le point de contrle et
+ * le journal gel en un nouveau point de contrle : fichier temporaire,
+ * fdatasync(), puis rename() atomique. Le point de contrle retient le dernier
+ * numro de squence qu'il contient ; les enregistrements plus anciens sont
+ * ignors, si bien qu'un arrt  n'importe quelle tape laisse un tat cohrent.
+ *
+ *  l'ouverture, le point de contrle est projet sans tre lu : seuls son
+ * en-tte et son rpertoire de champs sont vrifis (CRC), puis
+ * state_journal_get() retourne les champs sur place, dans le point de contrle
+ * ou dans le dernier enregistrement du journal. La somme de contrle des donnes
+ * est vrifie ensuite par le thread de fond ; un point de contrle corrompu
+ * est cart pour les ouvertures suivantes.
+ *
+ * state_journal_append(), state_journal_compact() et state_journal_get() sont
+ * rserves au thread qui a ouvert le journal.
+ */
+
+// Capacit de chaque journal.
+#define STATE_JOURNAL_CAPACITY (256 << 10)
+
+// Champs distincts suivis par le journal.
+#define STATE_JOURNAL_MAX_FIELDS 64
+
+struct state_journal;
+
+struct state_journal_stats {
+    uint64_t appends;
+    uint64_t appendedBytes;
+
+    // Ajouts refuss faute de place (compactage en retard, ou champ trop grand).
+    uint64_t dropped;
+
+    // Points de contrle crits, dure du dernier et taille de l'instantan courant.
+    uint64_t compactions;
+    int64_t lastCompactionNs;
+    uint64_t checkpointBytes;
+
+    //  l'ouverture : enregistrements rejous et fin de journal incomplte ou corrompue.
+    uint64_t replayed;
+    uint64_t torn;
+
+    // Points de contrle dont les donnes ne correspondent pas  leur CRC.
+    uint64_t corrupt;
+};
+
+/**
+ * Ouvre (ou cre) le journal du rpertoire directory, pour la famille de champs
+ * schema. Les champs restaurs sont disponibles avec state_journal_get() jusqu'
+ * state_journal_release_view(). Retourne NULL en cas d'erreur.
+ */
+struct state_journal* state_journal_open(const char* directory, uint32_t schema);
+
+/**
+ * Valeur restaure du champ id, sur place, ou NULL si le champ est absent ou
+ * d'un autre type. *outCount (si non NULL) reoit le nombre d'lments.
+ */
+const void* state_journal_get(struct state_journal* journal, uint32_t id, int type,
+        size_t* outCount);
+
+/**
+ * Fin de la restauration : les adresses retournes par state_journal_get() ne
+ * sont plus utilises, et le compactage peut commencer.
+ */
+void state_journal_release_view(struct state_journal* journal);
+
+/**
+ * Ajoute la nouvelle valeur d'un champ. Retourne 0 en cas de succs, -1 si le
+ * journal actif est plein.
+ */
+int state_journal_append(struct state_journal* journal, uint32_t id, int type,
+        const void* values, size_t count);
+
+/**
+ * Demande un point de contrle en arrire-plan (par exemple  la pause).
+ */
+void state_journal_compact(struct state_journal* journal);
+
+/**
+ * Attend la fin du compactage en cours.
+ */
+void state_journal_wait(struct state_journal* journal);
+
+void state_journal_get_stats(struct state_journal* journal, struct state_journal_stats* outStats);
+
+/**
+ * Attend la fin du compactage en cours et ferme le journal. Les ajouts dj
+ * faits restent dans les fichiers.
+ */
+void state_journal_close(struct state_journal* journal);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _STATE_JOURNAL_H */
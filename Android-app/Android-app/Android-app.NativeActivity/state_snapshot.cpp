@@ -0,0 +1,314 @@
+// Lastorm tech.
+
+ASYNC_LOG_TAG(state_snapshot_log_tag, "state_snapshot", 10);
+
+#define LOGW(...) ASYNC_LOG(ANDROID_LOG_WARN, &state_snapshot_log_tag, __VA_ARGS__)
+
+// --------------------------------------------------------------------
+// Format
+// --------------------------------------------------------------------
+
+size_t state_snapshot_element_size(int type) {
+    switch (type) {
+        case STATE_FIELD_BYTES:
+            return 1;
+        case STATE_FIELD_I32:
+        case STATE_FIELD_F32:
+            return 4;
+        case STATE_FIELD_I64:
+        case STATE_FIELD_F64:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+// Dbut des donnes : aprs l'en-tte et un rpertoire de fieldCount entres.
+static size_t state_snapshot_data_start(uint32_t fieldCount) {
+    return STATE_SNAPSHOT_SPACE(sizeof(struct state_snapshot_header)
+            + fieldCount * sizeof(struct state_snapshot_field));
+}
+
+int state_snapshot_begin(struct state_snapshot_writer* writer, uint32_t schema,
+        uint32_t maxFields, size_t payloadSize) {
+    memset(writer, 0, sizeof(*writer));
+    size_t start = state_snapshot_data_start(maxFields);
+    writer->data = (uint8_t*)state_pool_acquire(start + payloadSize, &writer->capacity);
+    if (writer->data == NULL) {
+        return -1;
+    }
+    writer->used = start;
+    writer->maxFields = maxFields;
+
+    struct state_snapshot_header* header = (struct state_snapshot_header*)writer->data;
+    header->magic = STATE_SNAPSHOT_MAGIC;
+    header->version = STATE_SNAPSHOT_VERSION;
+    header->headerSize = sizeof(struct state_snapshot_header);
+    header->schema = schema;
+    header->fieldCount = 0;
+    header->size = 0;
+    return 0;
+}
+
+void* state_snapshot_reserve(struct state_snapshot_writer* writer, uint32_t id, int type,
+        size_t count) {
+    size_t elementSize = state_snapshot_element_size(type);
+    if (writer->data == NULL || writer->fieldCount == writer->maxFields || elementSize == 0
+            || count > (writer->capacity - writer->used) / elementSize) {
+        writer->failed = 1;
+        return NULL;
+    }
+    size_t space = STATE_SNAPSHOT_SPACE(count * elementSize);
+    if (space > writer->capacity - writer->used) {
+        writer->failed = 1;
+        return NULL;
+    }
+
+    struct state_snapshot_field* field = (struct state_snapshot_field*)(writer->data
+            + sizeof(struct state_snapshot_header)) + writer->fieldCount++;
+    field->id = id;
+    field->type = (uint16_t)type;
+    field->elementSize = (uint16_t)elementSize;
+    field->offset = writer->used;
+    field->count = count;
+
+    uint8_t* values = writer->data + writer->used;
+    // Le bourrage est mis  zro : le bloc ne transporte aucun reste d'un usage prcdent.
+    memset(values + count * elementSize, 0, space - count * elementSize);
+    writer->used += space;
+    return values;
+}
+
+int state_snapshot_put(struct state_snapshot_writer* writer, uint32_t id, int type,
+        const void* values, size_t count) {
+    void* field = state_snapshot_reserve(writer, id, type, count);
+    if (field == NULL) {
+        return -1;
+    }
+    memcpy(field, values, count * state_snapshot_element_size(type));
+    return 0;
+}
+
+void* state_snapshot_finish(struct state_snapshot_writer* writer, size_t* outSize) {
+    if (writer->data == NULL || writer->failed) {
+        LOGW("snapshot discarded: %u fields, %zu of %zu bytes used",
+                writer->fieldCount, writer->used, writer->capacity);
+        state_snapshot_abort(writer);
+        *outSize = 0;
+        return NULL;
+    }
+
+    // Les entres inutilises du rpertoire restent dans le bloc, sans tre dcrites.
+    struct state_snapshot_header* header = (struct state_snapshot_header*)writer->data;
+    header->fieldCount = writer->fieldCount;
+    header->size = writer->used;
+
+    void* data = writer->data;
+    *outSize = writer->used;
+    writer->data = NULL;
+    return data;
+}
+
+void state_snapshot_abort(struct state_snapshot_writer* writer) {
+    if (writer->data != NULL) {
+        state_pool_release(writer->data, writer->capacity);
+        writer->data = NULL;
+    }
+}
+
+int state_snapshot_open(struct state_snapshot_view* view, const void* data, size_t size,
+        uint32_t schema) {
+    memset(view, 0, sizeof(*view));
+    const struct state_snapshot_header* header = (const struct state_snapshot_header*)data;
+    if (data == NULL || ((uintptr_t)data & 7) != 0 || size < sizeof(*header)
+            || header->magic != STATE_SNAPSHOT_MAGIC || header->version != STATE_SNAPSHOT_VERSION
+            || header->headerSize < sizeof(*header) || (header->headerSize & 7) != 0
+            || header->schema != schema || header->size > size
+            || header->size < header->headerSize) {
+        return -1;
+    }
+
+    uint64_t blockSize = header->size;
+    if (header->fieldCount > (blockSize - header->headerSize) / sizeof(struct state_snapshot_field)) {
+        return -1;
+    }
+    const struct state_snapshot_field* fields = (const struct state_snapshot_field*)
+            ((const uint8_t*)data + header->headerSize);
+    for (uint32_t i = 0; i < header->fieldCount; i++) {
+        const struct state_snapshot_field* field = &fields[i];
+        if (field->offset % STATE_SNAPSHOT_ALIGN != 0 || field->offset > blockSize
+                || field->elementSize == 0
+                || field->count > (blockSize - field->offset) / field->elementSize) {
+            return -1;
+        }
+    }
+
+    view->data = (const uint8_t*)data;
+    view->size = (size_t)blockSize;
+    view->schema = schema;
+    view->fieldCount = header->fieldCount;
+    view->fields = fields;
+    return 0;
+}
+
+const void* state_snapshot_get(const struct state_snapshot_view* view, uint32_t id, int type,
+        size_t* outCount) {
+    for (uint32_t i = 0; i < view->fieldCount; i++) {
+        const struct state_snapshot_field* field = &view->fields[i];
+        if (field->id != id) {
+            continue;
+        }
+        if (field->type != type || field->elementSize != state_snapshot_element_size(type)) {
+            break;
+        }
+        if (outCount != NULL) {
+            *outCount = (size_t)field->count;
+        }
+        return view->data + field->offset;
+    }
+    if (outCount != NULL) {
+        *outCount = 0;
+    }
+    return NULL;
+}
+
+// --------------------------------------------------------------------
+// Rserve
+// --------------------------------------------------------------------
+
+struct state_pool_slot {
+    void* data;
+    size_t capacity;
+};
+
+static struct {
+    pthread_mutex_t mutex;
+    struct state_pool_slot slots[STATE_POOL_SLOTS];
+    int count;
+    struct state_pool_stats stats;
+} state_pool = { PTHREAD_MUTEX_INITIALIZER };
+
+// Les grands tampons sont arrondis  la page : ils sont servis par mmap() et
+// aucun octet de la dernire page n'est perdu.
+static size_t state_pool_round(size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return size >= page ? (size + page - 1) & ~(page - 1) : size;
+}
+
+// Doit tre appele avec state_pool.mutex verrouill. Retourne l'indice du plus
+// petit tampon d'au moins size octets, ou -1.
+static int state_pool_find(size_t size) {
+    int best = -1;
+    for (int i = 0; i < state_pool.count; i++) {
+        if (state_pool.slots[i].capacity >= size
+                && (best < 0 || state_pool.slots[i].capacity < state_pool.slots[best].capacity)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// Doit tre appele avec state_pool.mutex verrouill.
+static void state_pool_remove(int index, void** outData, size_t* outCapacity) {
+    *outData = state_pool.slots[index].data;
+    *outCapacity = state_pool.slots[index].capacity;
+    state_pool.stats.bytes -= *outCapacity;
+    state_pool.slots[index] = state_pool.slots[--state_pool.count];
+}
+
+void* state_pool_acquire(size_t size, size_t* outCapacity) {
+    void* data = NULL;
+    size_t capacity = 0;
+    pthread_mutex_lock(&state_pool.mutex);
+    int index = state_pool_find(size);
+    if (index >= 0) {
+        state_pool_remove(index, &data, &capacity);
+        state_pool.stats.hits++;
+    } else {
+        state_pool.stats.misses++;
+    }
+    pthread_mutex_unlock(&state_pool.mutex);
+
+    if (data == NULL) {
+        capacity = state_pool_round(size);
+        data = malloc(capacity);
+        if (data == NULL) {
+            capacity = 0;
+        }
+    }
+    if (outCapacity != NULL) {
+        *outCapacity = capacity;
+    }
+    return data;
+}
+
+void state_pool_release(void* buffer, size_t capacity) {
+    if (buffer == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&state_pool.mutex);
+    if (state_pool.count < STATE_POOL_SLOTS) {
+        state_pool.slots[state_pool.count].data = buffer;
+        state_pool.slots[state_pool.count++].capacity = capacity;
+        state_pool.stats.bytes += capacity;
+        buffer = NULL;
+    } else {
+        // Rserve pleine : le plus petit tampon laisse sa place.
+        int smallest = 0;
+        for (int i = 1; i < state_pool.count; i++) {
+            if (state_pool.slots[i].capacity < state_pool.slots[smallest].capacity) smallest = i;
+        }
+        if (state_pool.slots[smallest].capacity < capacity) {
+            void* evicted = state_pool.slots[smallest].data;
+            state_pool.stats.bytes += capacity - state_pool.slots[smallest].capacity;
+            state_pool.slots[smallest].data = buffer;
+            state_pool.slots[smallest].capacity = capacity;
+            buffer = evicted;
+        }
+    }
+    pthread_mutex_unlock(&state_pool.mutex);
+    free(buffer);
+}
+
+void state_pool_reserve(size_t size) {
+    pthread_mutex_lock(&state_pool.mutex);
+    int index = state_pool_find(size);
+    pthread_mutex_unlock(&state_pool.mutex);
+    if (index >= 0) {
+        return;
+    }
+
+    size_t capacity = state_pool_round(size);
+    uint8_t* data = (uint8_t*)malloc(capacity);
+    if (data == NULL) {
+        return;
+    }
+    // Une criture par page : les dfauts de page sont pays ici, hors de
+    // l'enregistrement suivant.
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    for (size_t offset = 0; offset < capacity; offset += page) {
+        data[offset] = 0;
+    }
+    state_pool_release(data, capacity);
+
+    pthread_mutex_lock(&state_pool.mutex);
+    state_pool.stats.reserved++;
+    pthread_mutex_unlock(&state_pool.mutex);
+}
+
+void state_pool_trim(void) {
+    pthread_mutex_lock(&state_pool.mutex);
+    while (state_pool.count > 0) {
+        void* data;
+        size_t capacity;
+        state_pool_remove(state_pool.count - 1, &data, &capacity);
+        free(data);
+    }
+    pthread_mutex_unlock(&state_pool.mutex);
+}
+
+void state_pool_get_stats(struct state_pool_stats* outStats) {
+    pthread_mutex_lock(&state_pool.mutex);
+    *outStats = state_pool.stats;
+    pthread_mutex_unlock(&state_pool.mutex);
+}
@@ -0,0 +1,208 @@
+// Lastorm tech.
+
+#ifndef _STATE_SNAPSHOT_H
+#define _STATE_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Format d'tat enregistr plat et versionn.
+ *
+ * Un instantan est un bloc contigu : un en-tte, un rpertoire de champs, puis
+ * les donnes de chaque champ, alignes sur 16 octets. Chaque champ est dcrit
+ * par un identifiant, un type et un nombre d'lments. Le lecteur ignore les
+ * champs qu'il ne connat pas et garde sa valeur par dfaut pour ceux qui
+ * manquent : l'tat enregistr peut gagner des champs d'une version  l'autre
+ * sans rompre la restauration. Les identifiants d'une famille (schema) ne
+ * doivent jamais tre rutiliss pour une autre signification.
+ *
+ * La restauration ne fait ni analyse ni copie : state_snapshot_open() vrifie
+ * une fois l'en-tte et les bornes du rpertoire, puis state_snapshot_get()
+ * retourne l'adresse du champ dans le bloc lui-mme.
+ *
+ * L'criture se fait directement dans un tampon de la rserve dcrite plus bas,
+ * avec state_snapshot_reserve() (le champ est rempli sur place) ou
+ * state_snapshot_put() (copie d'un tableau existant).
+ *
+ *      struct state_snapshot_writer writer;
+ *      if (state_snapshot_begin(&writer, SCHEMA, 2, STATE_SNAPSHOT_SPACE(sizeof(float))
+ *              + STATE_SNAPSHOT_SPACE(n * sizeof(int32_t))) == 0) {
+ *          state_snapshot_put(&writer, FIELD_ANGLE, STATE_FIELD_F32, &angle, 1);
+ *          int32_t* cells = (int32_t*)state_snapshot_reserve(&writer, FIELD_CELLS,
+ *                  STATE_FIELD_I32, n);
+ *          ...
+ *          app->savedState = state_snapshot_finish(&writer, &app->savedStateSize);
+ *      }
+ */
+
+#define STATE_SNAPSHOT_MAGIC 0x50414e53u   //  SNAP  en petit-boutiste
+#define STATE_SNAPSHOT_VERSION 1
+#define STATE_SNAPSHOT_ALIGN 16
+
+// Place occupe par un champ de size octets.
+#define STATE_SNAPSHOT_SPACE(size) (((size_t)(size) + STATE_SNAPSHOT_ALIGN - 1) \
+        & ~(size_t)(STATE_SNAPSHOT_ALIGN - 1))
+
+// Types des champs.
+enum {
+    STATE_FIELD_BYTES = 1,
+    STATE_FIELD_I32,
+    STATE_FIELD_F32,
+    STATE_FIELD_I64,
+    STATE_FIELD_F64,
+};
+
+struct state_snapshot_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+
+    // Famille de champs, choisie par l'application.
+    uint32_t schema;
+    uint32_t fieldCount;
+
+    // Taille totale du bloc, en-tte compris.
+    uint64_t size;
+};
+
+struct state_snapshot_field {
+    uint32_t id;
+    uint16_t type;
+    uint16_t elementSize;
+
+    // Position des donnes depuis le dbut du bloc, et nombre d'lments.
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct state_snapshot_writer {
+    uint8_t* data;
+    size_t capacity;
+    size_t used;
+    uint32_t fieldCount;
+    uint32_t maxFields;
+
+    // Valeur diffrente de zro si un champ n'a pas trouv de place.
+    int failed;
+};
+
+struct state_snapshot_view {
+    const uint8_t* data;
+    size_t size;
+    uint32_t schema;
+    uint32_t fieldCount;
+    const struct state_snapshot_field* fields;
+};
+
+/**
+ * Commence un instantan d'au plus maxFields champs dont les donnes occupent
+ * payloadSize octets (somme des STATE_SNAPSHOT_SPACE()). Le tampon vient de la
+ * rserve. Retourne 0 en cas de succs, -1 sinon.
+ */
+int state_snapshot_begin(struct state_snapshot_writer* writer, uint32_t schema,
+        uint32_t maxFields, size_t payloadSize);
+
+/**
+ * Ajoute un champ de count lments et retourne l'adresse de ses donnes, 
+ * remplir par l'appelant, ou NULL s'il n'y a plus de place.
+ */
+void* state_snapshot_reserve(struct state_snapshot_writer* writer, uint32_t id, int type,
+        size_t count);
+
+/**
+ * Ajoute un champ en copiant count lments depuis values. Retourne 0 en cas
+ * de succs, -1 sinon.
+ */
+int state_snapshot_put(struct state_snapshot_writer* writer, uint32_t id, int type,
+        const void* values, size_t count);
+
+/**
+ * Termine l'instantan et retourne le bloc,  placer dans android_app.savedState.
+ * Le bloc peut tre libr avec free(). Si un champ a manqu de place, le tampon
+ * retourne  la rserve et la fonction retourne NULL.
+ */
+void* state_snapshot_finish(struct state_snapshot_writer* writer, size_t* outSize);
+
+/**
+ * Abandonne l'instantan ; le tampon retourne  la rserve.
+ */
+void state_snapshot_abort(struct state_snapshot_writer* writer);
+
+/**
+ * Taille d'un lment du type type, 0 pour un type inconnu.
+ */
+size_t state_snapshot_element_size(int type);
+
+/**
+ * Vrifie l'en-tte et le rpertoire d'un bloc. Retourne 0 si le bloc est un
+ * instantan valide de la famille schema, -1 sinon (bloc d'une autre version
+ * ou d'un autre format, tronqu ou mal align).
+ */
+int state_snapshot_open(struct state_snapshot_view* view, const void* data, size_t size,
+        uint32_t schema);
+
+/**
+ * Donnes du champ id, dans le bloc lui-mme, ou NULL si le champ est absent ou
+ * d'un autre type. *outCount (si non NULL) reoit le nombre d'lments.
+ */
+const void* state_snapshot_get(const struct state_snapshot_view* view, uint32_t id, int type,
+        size_t* outCount);
+
+/**
+ * Rserve de tampons d'tat enregistr.
+ *
+ * Le systme libre avec free() le bloc remis par onSaveInstanceState() : un
+ * bloc remis ne revient pas. Les tampons de la rserve sont donc allous avec
+ * malloc(), et le code de collage en prpare un nouveau, prcharg en mmoire
+ * (chaque page touche), juste aprs avoir libr le thread principal de
+ * l'activit : un enregistrement de plusieurs mgaoctets ne paie ni l'allocation
+ * ni les dfauts de page pendant que ce thread attend. Les blocs restaurs et
+ * les tats non rclams retournent  la rserve au lieu d'tre librs.
+ *
+ * Les fonctions peuvent tre appeles depuis n'importe quel thread.
+ */
+
+#define STATE_POOL_SLOTS 4
+
+struct state_pool_stats {
+    // Demandes servies par un tampon de la rserve, ou par une nouvelle allocation.
+    uint64_t hits;
+    uint64_t misses;
+
+    // Tampons prpars par state_pool_reserve(), et octets actuellement en rserve.
+    uint64_t reserved;
+    uint64_t bytes;
+};
+
+/**
+ * Tampon d'au moins size octets. *outCapacity (si non NULL) reoit sa taille relle.
+ */
+void* state_pool_acquire(size_t size, size_t* outCapacity);
+
+/**
+ * Rend un tampon de capacity octets, allou avec malloc() (par la rserve ou non).
+ */
+void state_pool_release(void* buffer, size_t capacity);
+
+/**
+ * Prpare un tampon d'au moins size octets si la rserve n'en a pas.
+ */
+void state_pool_reserve(size_t size);
+
+/**
+ * Libre tous les tampons en rserve.
+ */
+void state_pool_trim(void);
+
+void state_pool_get_stats(struct state_pool_stats* outStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _STATE_SNAPSHOT_H */
@@ -0,0 +1,445 @@
+// Lastorm tech.
+
+ASYNC_LOG_TAG(sys_trace_log_tag, "sys_trace", 10);
+
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, &sys_trace_log_tag, __VA_ARGS__)
+#define LOGW(...) ASYNC_LOG(ANDROID_LOG_WARN, &sys_trace_log_tag, __VA_ARGS__)
+
+/**
+ * Marqueur. value est la valeur d'un compteur ou le cookie d'une tranche
+ * asynchrone.
+ */
+struct sys_trace_event {
+    int64_t timeNs;
+    const char* name;
+    int64_t value;
+    int32_t type;
+    int32_t tid;
+};
+
+/**
+ * Anneau d'un thread : crit par ce thread seul, lu par l'export. Un anneau
+ * libr par la fin de son thread est repris par le suivant, avec les marqueurs
+ * de l'ancien propritaire.
+ */
+struct sys_trace_ring {
+    struct sys_trace_ring* next;
+    int tid;
+
+    // Valeur diffrente de zro quand le thread propritaire est termin.
+    int retired;
+
+    // Marqueurs crits depuis la cration ; publi aprs chaque criture.
+    uint64_t written;
+    struct sys_trace_event events[SYS_TRACE_RING_EVENTS];
+};
+
+/**
+ * Fonctions ATrace de libandroid.so, absentes avant Android 6.
+ */
+struct sys_trace_atrace {
+    void (*beginSection)(const char* sectionName);
+    void (*endSection)(void);
+    void (*beginAsyncSection)(const char* sectionName, int32_t cookie);
+    void (*endAsyncSection)(const char* sectionName, int32_t cookie);
+    void (*setCounter)(const char* counterName, int64_t counterValue);
+};
+
+/**
+ * Marqueur copi pour l'export, avec son rang de lecture :  instant gal,
+ * l'ordre d'criture d'un thread est conserv.
+ */
+struct sys_trace_item {
+    struct sys_trace_event event;
+    uint64_t order;
+};
+
+struct sys_trace_thread {
+    int tid;
+    int depth;
+};
+
+struct sys_trace_async {
+    const char* name;
+    int64_t cookie;
+};
+
+/**
+ * Appariement pendant l'export : tranches ouvertes de chaque thread, tranches
+ * asynchrones ouvertes. Au-del de SYS_TRACE_MAX_ASYNC tranches asynchrones
+ * ouvertes, les fins ne sont plus filtres.
+ */
+struct sys_trace_export {
+    struct sys_trace_thread threads[SYS_TRACE_MAX_THREADS];
+    int threadCount;
+    struct sys_trace_async async[SYS_TRACE_MAX_ASYNC];
+    int asyncCount;
+    int asyncOverflow;
+};
+
+static pthread_once_t sys_trace_once = PTHREAD_ONCE_INIT;
+static pthread_key_t sys_trace_key;
+static __thread struct sys_trace_ring* sys_trace_current;
+
+// Protge la liste des anneaux ; srialise les exports.
+static pthread_mutex_t sys_trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct sys_trace_ring* sys_trace_rings;
+static struct sys_trace_atrace sys_trace_atrace;
+static struct sys_trace_stats sys_trace_stats_global;
+
+static int64_t sys_trace_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// --------------------------------------------------------------------
+// criture
+// --------------------------------------------------------------------
+
+static void sys_trace_thread_exit(void* ring) {
+    __atomic_store_n(&((struct sys_trace_ring*)ring)->retired, 1, __ATOMIC_RELEASE);
+}
+
+// ATrace n'existe qu' partir d'Android 6 (compteurs et tranches asynchrones :
+// Android 10) : les fonctions sont cherches dans les bibliothques dj charges.
+static void sys_trace_init(void) {
+    pthread_key_create(&sys_trace_key, sys_trace_thread_exit);
+
+    struct sys_trace_atrace* atrace = &sys_trace_atrace;
+    atrace->beginSection = (void (*)(const char*))dlsym(RTLD_DEFAULT, "ATrace_beginSection");
+    atrace->endSection = (void (*)(void))dlsym(RTLD_DEFAULT, "ATrace_endSection");
+    if (atrace->beginSection == NULL || atrace->endSection == NULL) {
+        atrace->beginSection = NULL;
+        atrace->endSection = NULL;
+        LOGI("ATrace unavailable, in-process ring only");
+        return;
+    }
+    sys_trace_stats_global.atraceLevel = 1;
+    atrace->beginAsyncSection = (void (*)(const char*, int32_t))dlsym(RTLD_DEFAULT, "ATrace_beginAsyncSection");
+    atrace->endAsyncSection = (void (*)(const char*, int32_t))dlsym(RTLD_DEFAULT, "ATrace_endAsyncSection");
+    atrace->setCounter = (void (*)(const char*, int64_t))dlsym(RTLD_DEFAULT, "ATrace_setCounter");
+    if (atrace->beginAsyncSection == NULL || atrace->endAsyncSection == NULL || atrace->setCounter == NULL) {
+        atrace->beginAsyncSection = NULL;
+        atrace->endAsyncSection = NULL;
+        atrace->setCounter = NULL;
+    } else {
+        sys_trace_stats_global.atraceLevel = 2;
+    }
+}
+
+static struct sys_trace_ring* sys_trace_ring_get(void) {
+    struct sys_trace_ring* ring = sys_trace_current;
+    if (ring != NULL) {
+        return ring;
+    }
+    pthread_once(&sys_trace_once, sys_trace_init);
+
+    int tid = (int)syscall(SYS_gettid);
+    pthread_mutex_lock(&sys_trace_mutex);
+    for (ring = sys_trace_rings; ring != NULL; ring = ring->next) {
+        if (__atomic_load_n(&ring->retired, __ATOMIC_ACQUIRE)) {
+            ring->retired = 0;
+            break;
+        }
+    }
+    if (ring == NULL) {
+        ring = (struct sys_trace_ring*)calloc(1, sizeof(struct sys_trace_ring));
+        if (ring == NULL) {
+            pthread_mutex_unlock(&sys_trace_mutex);
+            return NULL;
+        }
+        ring->next = sys_trace_rings;
+        sys_trace_rings = ring;
+        sys_trace_stats_global.rings++;
+    }
+    ring->tid = tid;
+    pthread_mutex_unlock(&sys_trace_mutex);
+
+    pthread_setspecific(sys_trace_key, ring);
+    sys_trace_current = ring;
+    return ring;
+}
+
+static void sys_trace_put(int type, const char* name, int64_t value) {
+    struct sys_trace_ring* ring = sys_trace_ring_get();
+    if (ring == NULL) {
+        return;
+    }
+    uint64_t index = ring->written;
+    struct sys_trace_event* event = &ring->events[index & (SYS_TRACE_RING_EVENTS - 1)];
+    event->timeNs = sys_trace_now_ns();
+    event->name = name;
+    event->value = value;
+    event->type = type;
+    event->tid = ring->tid;
+    __atomic_store_n(&ring->written, index + 1, __ATOMIC_RELEASE);
+}
+
+void sys_trace_begin(const char* name) {
+    sys_trace_put(SYS_TRACE_BEGIN, name, 0);
+    if (sys_trace_atrace.beginSection != NULL) {
+        sys_trace_atrace.beginSection(name);
+    }
+}
+
+void sys_trace_end(void) {
+    sys_trace_put(SYS_TRACE_END, NULL, 0);
+    if (sys_trace_atrace.endSection != NULL) {
+        sys_trace_atrace.endSection();
+    }
+}
+
+void sys_trace_counter(const char* name, int64_t value) {
+    sys_trace_put(SYS_TRACE_COUNTER, name, value);
+    if (sys_trace_atrace.setCounter != NULL) {
+        sys_trace_atrace.setCounter(name, value);
+    }
+}
+
+void sys_trace_async_begin(const char* name, int32_t cookie) {
+    sys_trace_put(SYS_TRACE_ASYNC_BEGIN, name, cookie);
+    if (sys_trace_atrace.beginAsyncSection != NULL) {
+        sys_trace_atrace.beginAsyncSection(name, cookie);
+    }
+}
+
+void sys_trace_async_end(const char* name, int32_t cookie) {
+    sys_trace_put(SYS_TRACE_ASYNC_END, name, cookie);
+    if (sys_trace_atrace.endAsyncSection != NULL) {
+        sys_trace_atrace.endAsyncSection(name, cookie);
+    }
+}
+
+// --------------------------------------------------------------------
+// Export
+// --------------------------------------------------------------------
+
+static int sys_trace_compare(const void* a, const void* b) {
+    const struct sys_trace_item* x = (const struct sys_trace_item*)a;
+    const struct sys_trace_item* y = (const struct sys_trace_item*)b;
+    if (x->event.timeNs != y->event.timeNs) {
+        return x->event.timeNs < y->event.timeNs ? -1 : 1;
+    }
+    return x->order < y->order ? -1 : x->order > y->order;
+}
+
+/**
+ * Copie les marqueurs d'un anneau dans items ; ceux que son thread a pu craser
+ * pendant la copie sont carts. Retourne le nombre de marqueurs copis.
+ * Appele avec sys_trace_mutex verrouill.
+ */
+static size_t sys_trace_copy_ring(const struct sys_trace_ring* ring, struct sys_trace_item* items,
+        uint64_t* order) {
+    uint64_t written = __atomic_load_n(&ring->written, __ATOMIC_ACQUIRE);
+    uint64_t first = written > SYS_TRACE_RING_EVENTS ? written - SYS_TRACE_RING_EVENTS : 0;
+    for (uint64_t i = first; i < written; i++) {
+        items[i - first].event = ring->events[i & (SYS_TRACE_RING_EVENTS - 1)];
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    // L'emplacement en cours d'criture est celui du marqueur qui suit le dernier publi.
+    uint64_t after = __atomic_load_n(&ring->written, __ATOMIC_RELAXED);
+    uint64_t valid = after + 1 > SYS_TRACE_RING_EVENTS ? after + 1 - SYS_TRACE_RING_EVENTS : 0;
+    size_t skip = valid > first ? (size_t)(valid - first) : 0;
+    size_t count = 0;
+    for (uint64_t i = first; i < written; i++) {
+        if (i - first < skip) {
+            continue;
+        }
+        items[count].event = items[i - first].event;
+        items[count].order = (*order)++;
+        count++;
+    }
+    return count;
+}
+
+static struct sys_trace_thread* sys_trace_find_thread(struct sys_trace_export* state, int tid) {
+    for (int i = 0; i < state->threadCount; i++) {
+        if (state->threads[i].tid == tid) {
+            return &state->threads[i];
+        }
+    }
+    if (state->threadCount == SYS_TRACE_MAX_THREADS) {
+        return NULL;
+    }
+    struct sys_trace_thread* thread = &state->threads[state->threadCount++];
+    thread->tid = tid;
+    thread->depth = 0;
+    return thread;
+}
+
+/**
+ * Retourne 0 pour une fin dont le dbut a t cras par l'anneau : seule, elle
+ * fermerait une tranche extrieure ou une tranche asynchrone absente.
+ */
+static int sys_trace_keep(struct sys_trace_export* state, const struct sys_trace_event* event) {
+    switch (event->type) {
+        case SYS_TRACE_BEGIN:
+        case SYS_TRACE_END: {
+            struct sys_trace_thread* thread = sys_trace_find_thread(state, event->tid);
+            if (thread == NULL) {
+                return 1;
+            }
+            if (event->type == SYS_TRACE_BEGIN) {
+                thread->depth++;
+                return 1;
+            }
+            if (thread->depth == 0) {
+                return 0;
+            }
+            thread->depth--;
+            return 1;
+        }
+        case SYS_TRACE_ASYNC_BEGIN:
+            if (state->asyncCount == SYS_TRACE_MAX_ASYNC) {
+                state->asyncOverflow = 1;
+            } else {
+                state->async[state->asyncCount].name = event->name;
+                state->async[state->asyncCount++].cookie = event->value;
+            }
+            return 1;
+        case SYS_TRACE_ASYNC_END:
+            for (int i = 0; i < state->asyncCount; i++) {
+                if (state->async[i].cookie == event->value && strcmp(state->async[i].name, event->name) == 0) {
+                    state->async[i] = state->async[--state->asyncCount];
+                    return 1;
+                }
+            }
+            return state->asyncOverflow;
+        default:
+            return 1;
+    }
+}
+
+static void sys_trace_write_string(FILE* file, const char* text) {
+    fputc('"', file);
+    for (const char* c = text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+            fputc(*c, file);
+        } else if ((unsigned char)*c < 0x20) {
+            fprintf(file, "\\u%04x", (unsigned char)*c);
+        } else {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+// Nom d'un thread vivant ; le dernier caractre de comm est un saut de ligne.
+static int sys_trace_thread_name(int tid, char* name, size_t size) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/comm", tid);
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return 0;
+    }
+    int found = fgets(name, (int)size, file) != NULL;
+    fclose(file);
+    if (found) {
+        name[strcspn(name, "\n")] = '\0';
+    }
+    return found;
+}
+
+static void sys_trace_write_event(FILE* file, const struct sys_trace_event* event, int pid) {
+    static const char phases[] = { 'B', 'E', 'C', 'b', 'e' };
+    fputs(",\n{", file);
+    if (event->name != NULL) {
+        fputs("\"name\":", file);
+        sys_trace_write_string(file, event->name);
+        fputc(',', file);
+    }
+    fprintf(file, "\"ph\":\"%c\",\"ts\":%lld.%03d,\"pid\":%d,\"tid\":%d", phases[event->type],
+            (long long)(event->timeNs / 1000), (int)(event->timeNs % 1000), pid, event->tid);
+    if (event->type == SYS_TRACE_COUNTER) {
+        fprintf(file, ",\"args\":{\"value\":%lld}", (long long)event->value);
+    } else if (event->type == SYS_TRACE_ASYNC_BEGIN || event->type == SYS_TRACE_ASYNC_END) {
+        fprintf(file, ",\"cat\":\"async\",\"id\":%lld", (long long)event->value);
+    }
+    fputc('}', file);
+}
+
+int sys_trace_export_json(const char* path) {
+    int64_t start = sys_trace_now_ns();
+    pthread_mutex_lock(&sys_trace_mutex);
+    // Les anneaux continuent d'tre crits pendant l'export : chacun peut tre plein.
+    size_t rings = 1;
+    for (struct sys_trace_ring* ring = sys_trace_rings; ring != NULL; ring = ring->next) {
+        rings++;
+    }
+    size_t capacity = rings * SYS_TRACE_RING_EVENTS;
+    struct sys_trace_item* items = (struct sys_trace_item*)malloc(capacity * sizeof(struct sys_trace_item));
+    struct sys_trace_export* state = (struct sys_trace_export*)calloc(1, sizeof(struct sys_trace_export));
+    FILE* file = fopen(path, "w");
+    if (items == NULL || state == NULL || file == NULL) {
+        pthread_mutex_unlock(&sys_trace_mutex);
+        LOGW("Unable to export trace to %s", path);
+        if (file != NULL) fclose(file);
+        free(state);
+        free(items);
+        return -1;
+    }
+
+    size_t count = 0;
+    uint64_t order = 0;
+    for (struct sys_trace_ring* ring = sys_trace_rings; ring != NULL; ring = ring->next) {
+        count += sys_trace_copy_ring(ring, items + count, &order);
+    }
+    qsort(items, count, sizeof(struct sys_trace_item), sys_trace_compare);
+
+    int pid = (int)getpid();
+    size_t exported = 0;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+            "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"engine\"}}",
+            pid, pid);
+    for (size_t i = 0; i < count; i++) {
+        const struct sys_trace_event* event = &items[i].event;
+        if (sys_trace_keep(state, event)) {
+            sys_trace_write_event(file, event, pid);
+            exported++;
+        }
+    }
+    for (int i = 0; i < state->threadCount; i++) {
+        char name[32];
+        if (sys_trace_thread_name(state->threads[i].tid, name, sizeof(name))) {
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+                    pid, state->threads[i].tid);
+            sys_trace_write_string(file, name);
+            fputs("}}", file);
+        }
+    }
+    fputs("\n]}\n", file);
+    sys_trace_stats_global.exports++;
+    sys_trace_stats_global.exported += exported;
+    pthread_mutex_unlock(&sys_trace_mutex);
+
+    int failed = ferror(file);
+    failed |= fclose(file) != 0;
+    int threadCount = state->threadCount;
+    free(state);
+    free(items);
+    if (failed) {
+        LOGW("Unable to write trace %s", path);
+        return -1;
+    }
+    LOGI("trace exported to %s: %zu events from %d threads in %.1f ms", path, exported, threadCount,
+            (sys_trace_now_ns() - start) / 1e6);
+    return (int)exported;
+}
+
+void sys_trace_get_stats(struct sys_trace_stats* outStats) {
+    pthread_once(&sys_trace_once, sys_trace_init);
+    pthread_mutex_lock(&sys_trace_mutex);
+    *outStats = sys_trace_stats_global;
+    outStats->events = 0;
+    outStats->overwritten = 0;
+    for (struct sys_trace_ring* ring = sys_trace_rings; ring != NULL; ring = ring->next) {
+        uint64_t written = __atomic_load_n(&ring->written, __ATOMIC_ACQUIRE);
+        outStats->events += written;
+        if (written > SYS_TRACE_RING_EVENTS) {
+            outStats->overwritten += written - SYS_TRACE_RING_EVENTS;
+        }
+    }
+    pthread_mutex_unlock(&sys_trace_mutex);
+}
@@ -0,0 +1,127 @@
+// Lastorm tech.
+
+#ifndef _SYS_TRACE_H
+#define _SYS_TRACE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Marqueurs de trace systme : tranches, compteurs et tranches asynchrones.
+ *
+ * Chaque marqueur part vers deux destinations :
+ *
+ *      ATrace      ATrace_beginSection() et les fonctions voisines de
+ *                  libandroid.so (Android 6, Android 10 pour les compteurs et les
+ *                  tranches asynchrones), cherches avec dlsym() : le travail de
+ *                  l'application s'aligne sur SurfaceFlinger et l'ordonnanceur
+ *                  dans une trace systrace ou Perfetto ;
+ *      anneau      un anneau par thread, crit sans verrou ni appel systme, qui
+ *                  garde les SYS_TRACE_RING_EVENTS derniers marqueurs du thread
+ *                  et s'exporte au format JSON de Chrome (chrome://tracing,
+ *                  ui.perfetto.dev), sur l'appareil comme sur l'hte.
+ *
+ * Les instants sont ceux de CLOCK_MONOTONIC, l'horloge des traces du noyau.
+ *
+ * Les noms ne sont pas copis : chanes littrales ou de dure de vie statique
+ * seulement. Une tranche se termine sur le thread qui l'a commence ; une tranche
+ * asynchrone se termine sur n'importe quel thread, avec le mme nom et le mme
+ * cookie.
+ *
+ * SYS_TRACE_ENABLED  0 retire les marqueurs  la compilation.
+ */
+
+#ifndef SYS_TRACE_ENABLED
+#define SYS_TRACE_ENABLED 1
+#endif
+
+// Marqueurs gards par thread (puissance de deux).
+#define SYS_TRACE_RING_EVENTS 4096
+
+// Threads et tranches asynchrones ouvertes suivis par un export.
+#define SYS_TRACE_MAX_THREADS 64
+#define SYS_TRACE_MAX_ASYNC 256
+
+// Types de marqueur.
+enum {
+    SYS_TRACE_BEGIN,
+    SYS_TRACE_END,
+    SYS_TRACE_COUNTER,
+    SYS_TRACE_ASYNC_BEGIN,
+    SYS_TRACE_ASYNC_END,
+};
+
+struct sys_trace_stats {
+    // Marqueurs crits, et crass depuis par des plus rcents de leur anneau.
+    uint64_t events;
+    uint64_t overwritten;
+
+    // Anneaux crs (un par thread vivant au plus, rutiliss ensuite).
+    uint64_t rings;
+
+    // Exports et marqueurs exports.
+    uint64_t exports;
+    uint64_t exported;
+
+    // Fonctions ATrace trouves : 0, tranches (Android 6), tout (Android 10).
+    int atraceLevel;
+};
+
+void sys_trace_begin(const char* name);
+void sys_trace_end(void);
+
+/**
+ * Valeur d'un compteur, affiche en courbe.
+ */
+void sys_trace_counter(const char* name, int64_t value);
+
+void sys_trace_async_begin(const char* name, int32_t cookie);
+void sys_trace_async_end(const char* name, int32_t cookie);
+
+/**
+ * crit les marqueurs des anneaux au format JSON de Chrome dans path, tris
+ * par instant ; les fins de tranche, asynchrone ou non, dont le dbut a t
+ * cras sont cartes. Les threads encore vivants sont nomms. Retourne le
+ * nombre de marqueurs crits, -1 en cas d'erreur.
+ */
+int sys_trace_export_json(const char* path);
+
+void sys_trace_get_stats(struct sys_trace_stats* outStats);
+
+#ifdef __cplusplus
+}
+
+/**
+ * Tranche limite  la porte courante.
+ */
+struct sys_trace_scope {
+    explicit sys_trace_scope(const char* name) { sys_trace_begin(name); }
+    ~sys_trace_scope() { sys_trace_end(); }
+    sys_trace_scope(const sys_trace_scope&) = delete;
+    sys_trace_scope& operator=(const sys_trace_scope&) = delete;
+};
+#endif
+
+#define SYS_TRACE_CONCAT_(a, b) a##b
+#define SYS_TRACE_CONCAT(a, b) SYS_TRACE_CONCAT_(a, b)
+
+#if SYS_TRACE_ENABLED
+#define SYS_TRACE_BEGIN(name) sys_trace_begin(name)
+#define SYS_TRACE_END() sys_trace_end()
+#define SYS_TRACE_SCOPE(name) struct sys_trace_scope SYS_TRACE_CONCAT(sys_trace_scope_, __LINE__)(name)
+#define SYS_TRACE_COUNTER(name, value) sys_trace_counter(name, value)
+#define SYS_TRACE_ASYNC_BEGIN(name, cookie) sys_trace_async_begin(name, cookie)
+#define SYS_TRACE_ASYNC_END(name, cookie) sys_trace_async_end(name, cookie)
+#else
+#define SYS_TRACE_BEGIN(name) do { } while (0)
+#define SYS_TRACE_END() do { } while (0)
+#define SYS_TRACE_SCOPE(name) do { } while (0)
+#define SYS_TRACE_COUNTER(name, value) do { } while (0)
+#define SYS_TRACE_ASYNC_BEGIN(name, cookie) do { } while (0)
+#define SYS_TRACE_ASYNC_END(name, cookie) do { } while (0)
+#endif
+
+#endif /* _SYS_TRACE_H */
@@ -0,0 +1,30 @@
+// Lastorm tech.
+
+void triple_buffer_init(struct triple_buffer* buffer, void* slots, size_t slotSize) {
+    buffer->slots = (unsigned char*)slots;
+    buffer->slotSize = slotSize;
+    buffer->back = 0;
+    buffer->middle = 1;
+    buffer->front = 2;
+}
+
+void* triple_buffer_back(struct triple_buffer* buffer) {
+    return buffer->slots + buffer->back * buffer->slotSize;
+}
+
+int triple_buffer_publish(struct triple_buffer* buffer) {
+    int previous = __atomic_exchange_n(&buffer->middle, buffer->back | TRIPLE_BUFFER_FRESH,
+            __ATOMIC_ACQ_REL);
+    buffer->back = previous & ~TRIPLE_BUFFER_FRESH;
+    return (previous & TRIPLE_BUFFER_FRESH) != 0;
+}
+
+const void* triple_buffer_front(struct triple_buffer* buffer, int* outFresh) {
+    int fresh = (__atomic_load_n(&buffer->middle, __ATOMIC_ACQUIRE) & TRIPLE_BUFFER_FRESH) != 0;
+    if (fresh) {
+        int previous = __atomic_exchange_n(&buffer->middle, buffer->front, __ATOMIC_ACQ_REL);
+        buffer->front = previous & ~TRIPLE_BUFFER_FRESH;
+    }
+    if (outFresh != NULL) *outFresh = fresh;
+    return buffer->slots + buffer->front * buffer->slotSize;
+}
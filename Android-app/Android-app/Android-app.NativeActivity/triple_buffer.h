@@ -0,0 +1,66 @@
+// Lastorm tech.
+
+#ifndef _TRIPLE_BUFFER_H
+#define _TRIPLE_BUFFER_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Tampon triple sans verrou entre un producteur et un consommateur.
+ *
+ * Le producteur remplit toujours son emplacement arrire puis le publie ; le
+ * consommateur lit toujours l'instantan publi le plus rcent. Aucun des
+ * deux ne bloque l'autre : un instantan publi mais pas encore lu est
+ * simplement remplac par le suivant. Un emplacement n'est jamais modifi
+ * tant que le consommateur le lit.
+ */
+
+// Bit positionn dans middle quand l'emplacement du milieu n'a pas encore t lu.
+#define TRIPLE_BUFFER_FRESH 4
+
+struct triple_buffer {
+    unsigned char* slots;
+    size_t slotSize;
+
+    // Emplacement rserv au producteur.
+    int back;
+
+    // Emplacement rserv au consommateur.
+    int front;
+
+    // Emplacement chang, accd de faon atomique, avec TRIPLE_BUFFER_FRESH.
+    int middle;
+};
+
+/**
+ * Initialise le tampon sur trois emplacements contigus de slotSize octets.
+ */
+void triple_buffer_init(struct triple_buffer* buffer, void* slots, size_t slotSize);
+
+/**
+ * Emplacement arrire, que le producteur remplit avant triple_buffer_publish().
+ */
+void* triple_buffer_back(struct triple_buffer* buffer);
+
+/**
+ * Publie l'emplacement arrire. Retourne une valeur diffrente de zro si
+ * l'instantan prcdent est remplac sans avoir t lu.
+ */
+int triple_buffer_publish(struct triple_buffer* buffer);
+
+/**
+ * Instantan le plus rcent, pour le consommateur. *outFresh (si non NULL)
+ * reoit une valeur diffrente de zro si l'instantan n'avait pas encore t
+ * retourn. L'instantan reste valide jusqu' l'appel suivant.
+ */
+const void* triple_buffer_front(struct triple_buffer* buffer, int* outFresh);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TRIPLE_BUFFER_H */